@@ -0,0 +1,157 @@
+#include "async_loader.h"
+#include <chrono>
+
+namespace Engine {
+
+/*
+ * Class AsyncLoader
+ */
+std::mutex AsyncLoader::workerMutex;
+std::condition_variable AsyncLoader::workerCondition;
+std::condition_variable AsyncLoader::idleCondition;
+std::deque<std::function<void()>> AsyncLoader::workerTasks = std::deque<std::function<void()>>();
+std::vector<std::thread> AsyncLoader::workerThreads = std::vector<std::thread>();
+unsigned int AsyncLoader::numWorkerThreads = 0;
+unsigned int AsyncLoader::numActiveWorkerTasks = 0;
+bool AsyncLoader::stopping = false;
+std::mutex AsyncLoader::mainThreadMutex;
+std::deque<std::function<void()>> AsyncLoader::mainThreadTasks = std::deque<std::function<void()>>();
+AsyncLoadStats AsyncLoader::stats = AsyncLoadStats();
+
+// Joins the worker threads before the statics above are destroyed, since destroying a joinable thread terminates
+static struct AsyncLoaderShutdownGuard {
+    ~AsyncLoaderShutdownGuard() { AsyncLoader::Shutdown(); }
+} asyncLoaderShutdownGuard;
+
+void AsyncLoader::QueueOnMainThread(const std::function<void()> task) {
+    std::lock_guard<std::mutex> lock(mainThreadMutex);
+    mainThreadTasks.push_back(task);
+}
+
+unsigned int AsyncLoader::ProcessMainThreadTasks(const double timeBudgetMilliseconds) {
+    std::chrono::steady_clock::time_point startTime = std::chrono::steady_clock::now();
+    unsigned int numTasksRun = 0;
+    while(true) {
+        std::function<void()> task;
+        {
+            std::lock_guard<std::mutex> lock(mainThreadMutex);
+            if(mainThreadTasks.empty()) {
+                break;
+            }
+            double elapsedMilliseconds = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - startTime).count();
+            if(numTasksRun > 0 && elapsedMilliseconds >= timeBudgetMilliseconds) {
+                stats.numBudgetDeferrals++;
+                break;
+            }
+            task = std::move(mainThreadTasks.front());
+            mainThreadTasks.pop_front();
+            stats.numMainThreadTasksRun++;
+        }
+        numTasksRun++;
+        task();
+    }
+    return numTasksRun;
+}
+
+void AsyncLoader::WaitForWorkers() {
+    std::unique_lock<std::mutex> lock(workerMutex);
+    idleCondition.wait(lock, []() { return workerTasks.empty() && numActiveWorkerTasks == 0; });
+}
+
+unsigned int AsyncLoader::GetNumRunningWorkerThreads() {
+    std::lock_guard<std::mutex> lock(workerMutex);
+    return workerThreads.size();
+}
+
+size_t AsyncLoader::GetNumPendingWorkerTasks() {
+    std::lock_guard<std::mutex> lock(workerMutex);
+    return workerTasks.size() + numActiveWorkerTasks;
+}
+
+size_t AsyncLoader::GetNumPendingMainThreadTasks() {
+    std::lock_guard<std::mutex> lock(mainThreadMutex);
+    return mainThreadTasks.size();
+}
+
+AsyncLoadStats AsyncLoader::GetStats() {
+    std::lock_guard<std::mutex> workerLock(workerMutex);
+    std::lock_guard<std::mutex> mainThreadLock(mainThreadMutex);
+    return stats;
+}
+
+void AsyncLoader::ResetStats() {
+    std::lock_guard<std::mutex> workerLock(workerMutex);
+    std::lock_guard<std::mutex> mainThreadLock(mainThreadMutex);
+    stats = AsyncLoadStats();
+}
+
+void AsyncLoader::Shutdown() {
+    std::vector<std::thread> joiningThreads;
+    {
+        std::lock_guard<std::mutex> lock(workerMutex);
+        stopping = true;
+        joiningThreads.swap(workerThreads);
+    }
+    workerCondition.notify_all();
+    for(unsigned int i = 0; i < joiningThreads.size(); i++) {
+        joiningThreads[i].join();
+    }
+    {
+        std::lock_guard<std::mutex> lock(workerMutex);
+        stopping = false;
+    }
+    std::deque<std::function<void()>> droppedTasks;
+    {
+        std::lock_guard<std::mutex> lock(mainThreadMutex);
+        droppedTasks.swap(mainThreadTasks);
+    }
+}
+
+void AsyncLoader::Enqueue(const std::function<void()> task) {
+    {
+        std::lock_guard<std::mutex> lock(workerMutex);
+        if(workerThreads.empty()) {
+            unsigned int numThreads = numWorkerThreads;
+            if(numThreads == 0) {
+                unsigned int numHardwareThreads = std::thread::hardware_concurrency();
+                numThreads = (numHardwareThreads > 1) ? numHardwareThreads - 1 : 1;
+            }
+            for(unsigned int i = 0; i < numThreads; i++) {
+                workerThreads.push_back(std::thread(RunWorker));
+            }
+        }
+        workerTasks.push_back(task);
+        stats.numTasksSubmitted++;
+    }
+    workerCondition.notify_one();
+}
+
+void AsyncLoader::RunWorker() {
+    while(true) {
+        std::function<void()> task;
+        {
+            std::unique_lock<std::mutex> lock(workerMutex);
+            workerCondition.wait(lock, []() { return stopping || !workerTasks.empty(); });
+            // Finish the queued tasks before stopping
+            if(workerTasks.empty()) {
+                return;
+            }
+            task = std::move(workerTasks.front());
+            workerTasks.pop_front();
+            numActiveWorkerTasks++;
+        }
+        task();
+        // Release the task's captures before reporting it as finished
+        task = nullptr;
+        {
+            std::lock_guard<std::mutex> lock(workerMutex);
+            numActiveWorkerTasks--;
+            stats.numTasksCompleted++;
+            if(workerTasks.empty() && numActiveWorkerTasks == 0) {
+                idleCondition.notify_all();
+            }
+        }
+    }
+}
+
+}
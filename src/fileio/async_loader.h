@@ -0,0 +1,114 @@
+#ifndef ASYNC_LOADER_H
+#define ASYNC_LOADER_H
+
+#include <functional>
+#include <future>
+#include <memory>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <deque>
+#include <vector>
+
+namespace Engine {
+
+/*
+ * Counts of the tasks run by AsyncLoader.
+ */
+struct AsyncLoadStats {
+    unsigned long long numTasksSubmitted = 0;
+    unsigned long long numTasksCompleted = 0;
+    unsigned long long numMainThreadTasksRun = 0;
+    // Calls to ProcessMainThreadTasks that left tasks queued because the time budget was spent
+    unsigned long long numBudgetDeferrals = 0;
+};
+
+/*
+ * AsyncLoader runs the system memory side of loading assets (file I/O, parsing and decoding) on a pool of worker
+ * threads. OpenGL objects can only be created on the thread that owns the context, so worker tasks hand that part back
+ * with QueueOnMainThread, and the main thread drains the queue once per frame with ProcessMainThreadTasks under a time
+ * budget so that loading never stalls a frame for long.
+ *
+ * The loaders themselves are not thread safe. Worker tasks must only touch their own data and leave loading into the
+ * loaders to the main thread tasks they queue.
+ */
+class AsyncLoader {
+    public:
+        /*
+         * Runs task on a worker thread. Returns a future holding the task's result, or the exception it threw. Starts
+         * the worker threads on first use.
+         */
+        template<typename T>
+        static std::future<T> Submit(std::function<T()> task);
+        
+        /*
+         * Queues task to run on the main thread during ProcessMainThreadTasks. Safe to call from any thread.
+         */
+        static void QueueOnMainThread(const std::function<void()> task);
+        
+        /*
+         * Runs queued main thread tasks in order until the queue is empty or timeBudgetMilliseconds has passed, always
+         * running at least one task. Returns the number of tasks run. Exceptions thrown by a task are passed on to the
+         * caller. Call once per frame from the thread that owns the OpenGL context.
+         */
+        static unsigned int ProcessMainThreadTasks(const double timeBudgetMilliseconds);
+        
+        /*
+         * Blocks until every submitted worker task has finished. The main thread tasks they queued are left queued.
+         */
+        static void WaitForWorkers();
+        
+        /*
+         * Sets the number of worker threads, with 0 using one less than the number of hardware threads. Takes effect
+         * the next time the worker threads are started.
+         */
+        static void SetNumWorkerThreads(const unsigned int numWorkerThreads) { AsyncLoader::numWorkerThreads = numWorkerThreads; }
+        
+        /*
+         * Returns the number of running worker threads.
+         */
+        static unsigned int GetNumRunningWorkerThreads();
+        
+        static size_t GetNumPendingWorkerTasks();
+        static size_t GetNumPendingMainThreadTasks();
+        static AsyncLoadStats GetStats();
+        static void ResetStats();
+        
+        /*
+         * Finishes the submitted worker tasks, joins the worker threads and drops the queued main thread tasks. The
+         * worker threads are started again by the next Submit.
+         */
+        static void Shutdown();
+    private:
+        /*
+         * Starts the worker threads if they aren't running and queues task for them.
+         */
+        static void Enqueue(const std::function<void()> task);
+        
+        static void RunWorker();
+        
+        static std::mutex workerMutex;
+        static std::condition_variable workerCondition;
+        static std::condition_variable idleCondition;
+        static std::deque<std::function<void()>> workerTasks;
+        static std::vector<std::thread> workerThreads;
+        static unsigned int numWorkerThreads;
+        static unsigned int numActiveWorkerTasks;
+        static bool stopping;
+        static std::mutex mainThreadMutex;
+        static std::deque<std::function<void()>> mainThreadTasks;
+        static AsyncLoadStats stats;
+};
+
+template<typename T>
+std::future<T> AsyncLoader::Submit(std::function<T()> task) {
+    // packaged_task isn't copyable, so share it with the queued function
+    std::shared_ptr<std::packaged_task<T()>> packagedTaskPtr = std::make_shared<std::packaged_task<T()>>(std::move(task));
+    std::future<T> future = packagedTaskPtr->get_future();
+    Enqueue([packagedTaskPtr]() { (*packagedTaskPtr)(); });
+    return future;
+}
+
+}
+
+#endif //ASYNC_LOADER_H
@@ -0,0 +1,20 @@
+#include "hash.h"
+
+namespace Engine {
+
+/*
+ * Class Hash
+ */
+unsigned long long Hash::HashBytes(unsigned long long hash, const void* bytes, const size_t numBytes) {
+    for(size_t i = 0; i < numBytes; i++) {
+        hash = (hash ^ ((const unsigned char*)bytes)[i]) * 1099511628211ULL;
+    }
+    return hash;
+}
+
+unsigned long long Hash::HashString(const unsigned long long hash, const std::string& string) {
+    unsigned long long size = string.size();
+    return HashBytes(HashBytes(hash, &size, sizeof(size)), string.data(), string.size());
+}
+
+}
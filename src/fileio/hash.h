@@ -0,0 +1,30 @@
+#ifndef HASH_H
+#define HASH_H
+
+#include <string>
+
+namespace Engine {
+
+/*
+ * Hash computes the 64-bit FNV-1a hashes that the engine's caches key their entries and files by. Hashes are chained by
+ * passing the result of one call as the starting hash of the next, beginning with OFFSET_BASIS.
+ */
+class Hash {
+    public:
+        static constexpr unsigned long long OFFSET_BASIS = 14695981039346656037ULL;
+        
+        /*
+         * Returns hash updated with numBytes bytes starting at bytes.
+         */
+        static unsigned long long HashBytes(unsigned long long hash, const void* bytes, const size_t numBytes);
+        
+        /*
+         * Returns hash updated with the size of string and then its characters. Hashing the size first keeps
+         * consecutive strings from running into each other, e.g. "ab", "c" and "a", "bc" hash differently.
+         */
+        static unsigned long long HashString(const unsigned long long hash, const std::string& string);
+};
+
+}
+
+#endif //HASH_H
@@ -0,0 +1,75 @@
+#include "path_index.h"
+#include <filesystem>
+#include <cassert>
+
+namespace Engine {
+
+/*
+ * Class PathTable
+ */
+std::vector<std::string> PathTable::internedPaths = std::vector<std::string>(1, "");
+std::unordered_map<std::string, unsigned int> PathTable::pathIDs = std::unordered_map<std::string, unsigned int>({{"", 0}});
+
+std::string PathTable::Canonicalize(const std::string& filePath) {
+    if(filePath == "") {
+        return "";
+    }
+    std::error_code errorCode;
+    std::filesystem::path absolutePath = std::filesystem::absolute(std::filesystem::path(filePath), errorCode);
+    if(errorCode) {
+        absolutePath = std::filesystem::path(filePath);
+    }
+    std::filesystem::path canonicalPath = std::filesystem::weakly_canonical(absolutePath, errorCode);
+    if(errorCode) {
+        canonicalPath = absolutePath;
+    }
+    return canonicalPath.lexically_normal().generic_string();
+}
+
+unsigned int PathTable::Intern(const std::string& filePath) {
+    std::string canonicalPath = Canonicalize(filePath);
+    std::unordered_map<std::string, unsigned int>::iterator iter = pathIDs.find(canonicalPath);
+    if(iter != pathIDs.end()) {
+        return iter->second;
+    }
+    unsigned int pathID = internedPaths.size();
+    internedPaths.push_back(canonicalPath);
+    pathIDs[canonicalPath] = pathID;
+    return pathID;
+}
+
+const std::string& PathTable::GetPath(const unsigned int pathID) {
+#ifdef _DEBUG
+    assert(pathID < internedPaths.size());
+#endif
+    return internedPaths[pathID];
+}
+
+/*
+ * Class PathIndex
+ */
+unsigned int PathIndex::find(const std::string& filePath) {
+    std::unordered_map<unsigned int, unsigned int>::iterator iter = resourceIDs.find(PathTable::Intern(filePath));
+    if(iter == resourceIDs.end()) {
+        misses++;
+        return 0;
+    }
+    hits++;
+    return iter->second;
+}
+
+void PathIndex::insert(const std::string& filePath, const unsigned int resourceID) {
+#ifdef _DEBUG
+    assert(resourceID != 0);
+#endif
+    resourceIDs[PathTable::Intern(filePath)] = resourceID;
+}
+
+void PathIndex::erase(const std::string& filePath, const unsigned int resourceID) {
+    std::unordered_map<unsigned int, unsigned int>::iterator iter = resourceIDs.find(PathTable::Intern(filePath));
+    if(iter != resourceIDs.end() && iter->second == resourceID) {
+        resourceIDs.erase(iter);
+    }
+}
+
+}
@@ -0,0 +1,74 @@
+#ifndef PATH_INDEX_H
+#define PATH_INDEX_H
+
+#include <string>
+#include <vector>
+#include <unordered_map>
+
+namespace Engine {
+
+/*
+ * PathTable interns canonicalized file paths so that loaders can compare paths by integer ID instead of by string.
+ * Two spellings of the same file (e.g. "./a/../wall.jpg" and "wall.jpg") are interned to the same path ID. Path ID 0
+ * is reserved for the empty path.
+ */
+class PathTable {
+    public:
+        /*
+         * Returns the canonical form of filePath. Falls back to the lexically normalized path if the file system
+         * can't resolve it.
+         */
+        static std::string Canonicalize(const std::string& filePath);
+        
+        /*
+         * Returns the path ID for the canonical form of filePath, interning it if it hasn't been seen before.
+         */
+        static unsigned int Intern(const std::string& filePath);
+        
+        /*
+         * Returns the canonical path interned with path ID pathID.
+         */
+        static const std::string& GetPath(const unsigned int pathID);
+        
+        static unsigned int GetNumInternedPaths() { return internedPaths.size(); }
+    private:
+        static std::vector<std::string> internedPaths;
+        static std::unordered_map<std::string, unsigned int> pathIDs;
+};
+
+/*
+ * PathIndex maps interned path IDs to loader resource IDs so that repeat loads of the same file are a single hash
+ * lookup. Each loader owns one PathIndex and keeps it in sync with its list of loaded resources.
+ */
+class PathIndex {
+    public:
+        /*
+         * Returns the resource ID registered for filePath, or 0 if none is registered. Counts a hit or a miss.
+         */
+        unsigned int find(const std::string& filePath);
+        
+        /*
+         * Registers resourceID as the loaded resource for filePath.
+         */
+        void insert(const std::string& filePath, const unsigned int resourceID);
+        
+        /*
+         * Removes the entry for filePath if it is registered to resourceID.
+         */
+        void erase(const std::string& filePath, const unsigned int resourceID);
+        
+        void clear() { resourceIDs.clear(); }
+        void resetStats() { hits = 0; misses = 0; }
+        
+        unsigned int getSize() const { return resourceIDs.size(); }
+        unsigned long long getHits() const { return hits; }
+        unsigned long long getMisses() const { return misses; }
+    private:
+        std::unordered_map<unsigned int, unsigned int> resourceIDs;
+        unsigned long long hits = 0;
+        unsigned long long misses = 0;
+};
+
+}
+
+#endif //PATH_INDEX_H
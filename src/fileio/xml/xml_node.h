@@ -72,7 +72,7 @@ class XmlNode {
         void setAttributes(const std::string& attributes) { this->attributes = attributes; }
         std::string getData() const { return data; }
         void setData(const std::string& data) { this->data = data; }
-        XmlNodePtr getParentNode() const { return parentNode; }
+        XmlNodePtr getParentNode() const { return parentNode.lock(); }
         void setParentNode(const XmlNodePtr parentNode) { this->parentNode = parentNode; }
         std::vector<XmlNodePtr> getChildNodes() const { return childNodes; }
         
@@ -82,7 +82,8 @@ class XmlNode {
         std::string name;
         std::string attributes;
         std::string data;
-        XmlNodePtr parentNode;
+        // Weak so that a tree of nodes is released with its top node
+        std::weak_ptr<XmlNode> parentNode;
         std::vector<XmlNodePtr> childNodes;
 };
 
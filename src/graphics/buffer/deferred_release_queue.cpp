@@ -0,0 +1,67 @@
+#include "deferred_release_queue.h"
+
+namespace Engine {
+
+/*
+ * Class FrameClock
+ */
+unsigned long long FrameClock::frameNumber = 0;
+
+/*
+ * Class DeferredReleaseQueue
+ */
+void DeferredReleaseQueue::schedule(const unsigned int resourceID, const size_t numBytes, const unsigned long long frameNumber) {
+    remove(resourceID);
+    PendingRelease pendingRelease;
+    pendingRelease.resourceID = resourceID;
+    pendingRelease.numBytes = numBytes;
+    pendingRelease.frameReleased = frameNumber;
+    pendingReleases.push_back(pendingRelease);
+    pendingIndex[resourceID] = std::prev(pendingReleases.end());
+    pendingBytes += numBytes;
+    stats.deferredReleases++;
+}
+
+bool DeferredReleaseQueue::resurrect(const unsigned int resourceID) {
+    if(!remove(resourceID)) {
+        return false;
+    }
+    stats.resurrections++;
+    return true;
+}
+
+bool DeferredReleaseQueue::remove(const unsigned int resourceID) {
+    std::unordered_map<unsigned int, std::list<PendingRelease>::iterator>::iterator indexIter = pendingIndex.find(resourceID);
+    if(indexIter == pendingIndex.end()) {
+        return false;
+    }
+    erase(indexIter->second);
+    return true;
+}
+
+std::vector<unsigned int> DeferredReleaseQueue::collect(const unsigned long long frameNumber, const bool reclaimAll) {
+    std::vector<unsigned int> reclaimedIDs;
+    while(!pendingReleases.empty()) {
+        const PendingRelease& oldest = pendingReleases.front();
+        bool expired = frameNumber >= oldest.frameReleased + releaseDelayFrames;
+        bool overBudget = pendingByteBudget != 0 && pendingBytes > pendingByteBudget;
+        if(!reclaimAll && !expired && !overBudget) {
+            break;
+        }
+        if(!expired) {
+            stats.pressureReclaims++;
+        }
+        stats.reclaims++;
+        reclaimedIDs.push_back(oldest.resourceID);
+        erase(pendingReleases.begin());
+    }
+    return reclaimedIDs;
+}
+
+void DeferredReleaseQueue::erase(std::list<PendingRelease>::iterator iter) {
+    pendingBytes -= iter->numBytes;
+    pendingIndex.erase(iter->resourceID);
+    pendingReleases.erase(iter);
+}
+
+}
@@ -0,0 +1,105 @@
+#ifndef DEFERRED_RELEASE_QUEUE_H
+#define DEFERRED_RELEASE_QUEUE_H
+
+#include <list>
+#include <vector>
+#include <unordered_map>
+#include <cstddef>
+
+namespace Engine {
+
+/*
+ * FrameClock counts rendered frames. Deferred releases are timed against it.
+ */
+class FrameClock {
+    public:
+        static void AdvanceFrame() { frameNumber++; }
+        static unsigned long long GetFrameNumber() { return frameNumber; }
+    private:
+        static unsigned long long frameNumber;
+};
+
+struct DeferredReleaseStats {
+    // Resources whose usage count reached zero and were queued instead of being deleted
+    unsigned long long deferredReleases = 0;
+    // Queued resources used again before being reclaimed, so no OpenGL object was regenerated
+    unsigned long long resurrections = 0;
+    // Queued resources whose OpenGL objects were deleted
+    unsigned long long reclaims = 0;
+    // Reclaims forced early by the pending byte budget or by memory pressure
+    unsigned long long pressureReclaims = 0;
+    // Resources buffered again after their OpenGL objects had been deleted
+    unsigned long long thrashEvents = 0;
+};
+
+/*
+ * DeferredReleaseQueue holds resources that are no longer used but are still buffered with OpenGL. A resource is only
+ * reclaimed once it has stayed unused for releaseDelayFrames frames, or earlier if the queue holds more than
+ * pendingByteBudget bytes or a full reclaim is requested. Using a queued resource again takes it off the queue without
+ * touching OpenGL.
+ */
+class DeferredReleaseQueue {
+    public:
+        /*
+         * Queues resourceID holding numBytes of OpenGL memory as released on frame frameNumber.
+         */
+        void schedule(const unsigned int resourceID, const size_t numBytes, const unsigned long long frameNumber);
+        
+        /*
+         * Takes resourceID off the queue because it is being used again. Returns false if it wasn't queued.
+         */
+        bool resurrect(const unsigned int resourceID);
+        
+        /*
+         * Takes resourceID off the queue without counting a resurrection, e.g. because it is being unloaded. Returns
+         * false if it wasn't queued.
+         */
+        bool remove(const unsigned int resourceID);
+        
+        bool isPending(const unsigned int resourceID) const { return pendingIndex.count(resourceID) > 0; }
+        
+        /*
+         * Takes the resources due to be reclaimed on frame frameNumber off the queue and returns them, oldest first. If
+         * reclaimAll is true every queued resource is returned.
+         */
+        std::vector<unsigned int> collect(const unsigned long long frameNumber, const bool reclaimAll = false);
+        
+        /*
+         * Counts a resource being buffered again after it was reclaimed.
+         */
+        void recordThrashEvent() { stats.thrashEvents++; }
+        
+        unsigned int getReleaseDelayFrames() const { return releaseDelayFrames; }
+        void setReleaseDelayFrames(const unsigned int releaseDelayFrames) { this->releaseDelayFrames = releaseDelayFrames; }
+        size_t getPendingByteBudget() const { return pendingByteBudget; }
+        
+        /*
+         * Sets the most bytes the queue may hold before reclaiming early. 0 means no limit.
+         */
+        void setPendingByteBudget(const size_t pendingByteBudget) { this->pendingByteBudget = pendingByteBudget; }
+        
+        unsigned int getNumPending() const { return pendingReleases.size(); }
+        size_t getPendingBytes() const { return pendingBytes; }
+        const DeferredReleaseStats& getStats() const { return stats; }
+        void resetStats() { stats = DeferredReleaseStats(); }
+    private:
+        struct PendingRelease {
+            unsigned int resourceID;
+            size_t numBytes;
+            unsigned long long frameReleased;
+        };
+        
+        void erase(std::list<PendingRelease>::iterator iter);
+        
+        // Ordered by frame released, oldest first
+        std::list<PendingRelease> pendingReleases;
+        std::unordered_map<unsigned int, std::list<PendingRelease>::iterator> pendingIndex;
+        size_t pendingBytes = 0;
+        unsigned int releaseDelayFrames = 120;
+        size_t pendingByteBudget = 0;
+        DeferredReleaseStats stats;
+};
+
+}
+
+#endif //DEFERRED_RELEASE_QUEUE_H
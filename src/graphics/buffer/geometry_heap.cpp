@@ -0,0 +1,107 @@
+#include "geometry_heap.h"
+#include <graphics/state/gl_state_cache.h>
+
+namespace Engine {
+
+GPUBufferHeap GeometryHeap::vertexHeaps[NUM_VERTEX_FORMATS] = {
+    GPUBufferHeap((3 + 3 + 2) * sizeof(float), 1 << 16)
+};
+GPUBufferHeap GeometryHeap::indexHeap = GPUBufferHeap(sizeof(unsigned int), 1 << 18);
+GeometryHeap::VertexArrayInfo GeometryHeap::vertexArrays[NUM_VERTEX_FORMATS] = {};
+
+unsigned int GeometryHeap::AllocateVertices(const VertexFormat vertexFormat, const size_t numVertices, const void* data) {
+    return vertexHeaps[vertexFormat].allocate(numVertices, data);
+}
+
+void GeometryHeap::FreeVertices(const VertexFormat vertexFormat, const unsigned int allocationID) {
+    vertexHeaps[vertexFormat].free(allocationID);
+}
+
+void GeometryHeap::ReadVertices(const VertexFormat vertexFormat, const unsigned int allocationID, void* data) {
+    vertexHeaps[vertexFormat].read(allocationID, data);
+}
+
+int GeometryHeap::GetBaseVertex(const VertexFormat vertexFormat, const unsigned int allocationID) {
+    return (int)vertexHeaps[vertexFormat].getOffset(allocationID);
+}
+
+unsigned int GeometryHeap::AllocateIndices(const size_t numIndices, const unsigned int* data) {
+    return indexHeap.allocate(numIndices, data);
+}
+
+void GeometryHeap::FreeIndices(const unsigned int allocationID) {
+    indexHeap.free(allocationID);
+}
+
+void GeometryHeap::ReadIndices(const unsigned int allocationID, unsigned int* data) {
+    indexHeap.read(allocationID, data);
+}
+
+size_t GeometryHeap::GetFirstIndex(const unsigned int allocationID) {
+    return indexHeap.getOffset(allocationID);
+}
+
+void GeometryHeap::BindVertexFormat(const VertexFormat vertexFormat) {
+    VertexArrayInfo& vertexArrayInfo = vertexArrays[vertexFormat];
+    const GPUBufferHeap& vertexHeap = vertexHeaps[vertexFormat];
+    if(vertexArrayInfo.vertexArrayName != 0 && vertexArrayInfo.vertexGeneration == vertexHeap.getGeneration()
+            && vertexArrayInfo.indexGeneration == indexHeap.getGeneration()) {
+        GLStateCache::BindVertexArray(vertexArrayInfo.vertexArrayName);
+        return;
+    }
+    
+    // Point the vertex array at the current buffers, they are replaced when a heap grows or is defragmented
+    if(vertexArrayInfo.vertexArrayName == 0) {
+        glGenVertexArrays(1, &vertexArrayInfo.vertexArrayName);
+    }
+    GLStateCache::BindVertexArray(vertexArrayInfo.vertexArrayName);
+    GLStateCache::BindBuffer(GL_ARRAY_BUFFER, vertexHeap.getBufferName());
+    GLStateCache::BindBuffer(GL_ELEMENT_ARRAY_BUFFER, indexHeap.getBufferName());
+    switch(vertexFormat) {
+        case VERTEX_FORMAT_POSITION_NORMAL_TEXCOORD: {
+            unsigned int vertexStride = 3 * sizeof(float);
+            unsigned int normalStride = 3 * sizeof(float);
+            unsigned int stride = GetVertexSize(vertexFormat);
+            // Vertices
+            glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, stride, (void*)(size_t)0);
+            glEnableVertexAttribArray(0);
+            // Normals
+            glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, stride, (void*)(size_t)(vertexStride));
+            glEnableVertexAttribArray(1);
+            // Texture Coords
+            glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, stride, (void*)(size_t)(vertexStride + normalStride));
+            glEnableVertexAttribArray(2);
+            break;
+        }
+        default:
+            break;
+    }
+    GLStateCache::BindBuffer(GL_ARRAY_BUFFER, 0);
+    vertexArrayInfo.vertexGeneration = vertexHeap.getGeneration();
+    vertexArrayInfo.indexGeneration = indexHeap.getGeneration();
+}
+
+void GeometryHeap::Defragment() {
+    for(unsigned int i = 0; i < NUM_VERTEX_FORMATS; i++) {
+        vertexHeaps[i].defragment();
+    }
+    indexHeap.defragment();
+}
+
+void GeometryHeap::Destroy() {
+    for(unsigned int i = 0; i < NUM_VERTEX_FORMATS; i++) {
+        vertexHeaps[i].destroy();
+        if(vertexArrays[i].vertexArrayName != 0) {
+            glDeleteVertexArrays(1, &vertexArrays[i].vertexArrayName);
+            GLStateCache::ForgetVertexArray(vertexArrays[i].vertexArrayName);
+        }
+        vertexArrays[i] = VertexArrayInfo();
+    }
+    indexHeap.destroy();
+}
+
+size_t GeometryHeap::GetVertexSize(const VertexFormat vertexFormat) {
+    return vertexHeaps[vertexFormat].getElementSize();
+}
+
+}
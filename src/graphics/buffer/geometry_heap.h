@@ -0,0 +1,82 @@
+#ifndef GEOMETRY_HEAP_H
+#define GEOMETRY_HEAP_H
+
+#include <graphics/buffer/gpu_buffer_heap.h>
+#include <cstddef>
+
+#include <glad/glad.h>
+
+namespace Engine {
+
+/*
+ * Layouts of interleaved vertex data. Each vertex format has its own vertex heap and vertex array object.
+ */
+enum VertexFormat {
+    // 3 float position, 3 float normal, 2 float texture coordinates
+    VERTEX_FORMAT_POSITION_NORMAL_TEXCOORD,
+    NUM_VERTEX_FORMATS
+};
+
+/*
+ * GeometryHeap holds the vertices of all buffered mesh geometries in one OpenGL buffer per vertex format and the
+ * indices of all buffered meshes in one shared index buffer. Meshes with the same vertex format share a vertex array
+ * object and are drawn with glDrawElementsBaseVertex using the offsets of their allocations.
+ */
+class GeometryHeap {
+    public:
+        /*
+         * Allocates and uploads numVertices vertices of vertexFormat. Returns the allocation ID.
+         */
+        static unsigned int AllocateVertices(const VertexFormat vertexFormat, const size_t numVertices, const void* data);
+        static void FreeVertices(const VertexFormat vertexFormat, const unsigned int allocationID);
+        static void ReadVertices(const VertexFormat vertexFormat, const unsigned int allocationID, void* data);
+        
+        /*
+         * Returns the index of the first vertex of the allocation, to be passed as base vertex when drawing.
+         */
+        static int GetBaseVertex(const VertexFormat vertexFormat, const unsigned int allocationID);
+        
+        /*
+         * Allocates and uploads numIndices indices. Returns the allocation ID.
+         */
+        static unsigned int AllocateIndices(const size_t numIndices, const unsigned int* data);
+        static void FreeIndices(const unsigned int allocationID);
+        static void ReadIndices(const unsigned int allocationID, unsigned int* data);
+        
+        /*
+         * Returns the position of the first index of the allocation in the shared index buffer.
+         */
+        static size_t GetFirstIndex(const unsigned int allocationID);
+        
+        /*
+         * Binds the vertex array object of vertexFormat, pointing it at the current vertex and index buffers.
+         */
+        static void BindVertexFormat(const VertexFormat vertexFormat);
+        
+        /*
+         * Compacts the vertex and index heaps.
+         */
+        static void Defragment();
+        
+        /*
+         * Deletes all OpenGL buffers and vertex arrays. Only valid once every allocation has been freed.
+         */
+        static void Destroy();
+        
+        static size_t GetVertexSize(const VertexFormat vertexFormat);
+        static const GPUBufferHeap& GetVertexHeap(const VertexFormat vertexFormat) { return vertexHeaps[vertexFormat]; }
+        static const GPUBufferHeap& GetIndexHeap() { return indexHeap; }
+    private:
+        struct VertexArrayInfo {
+            unsigned int vertexArrayName = 0;
+            unsigned int vertexGeneration = 0;
+            unsigned int indexGeneration = 0;
+        };
+        static GPUBufferHeap vertexHeaps[NUM_VERTEX_FORMATS];
+        static GPUBufferHeap indexHeap;
+        static VertexArrayInfo vertexArrays[NUM_VERTEX_FORMATS];
+};
+
+}
+
+#endif //GEOMETRY_HEAP_H
@@ -0,0 +1,164 @@
+#include "gpu_buffer_heap.h"
+#include <graphics/state/gl_state_cache.h>
+#include <graphics/buffer/upload_scheduler.h>
+#include <algorithm>
+#include <cassert>
+
+namespace Engine {
+
+GPUBufferHeap::GPUBufferHeap(const size_t elementSize, const size_t initialCapacity) : elementSize(elementSize), allocator(initialCapacity) {}
+
+unsigned int GPUBufferHeap::allocate(const size_t numElements, const void* data) {
+    if(numElements == 0) {
+        return EMPTY_ALLOCATION_ID;
+    }
+    if(bufferName == 0) {
+        glGenBuffers(1, &bufferName);
+        GLStateCache::BindBuffer(GL_COPY_WRITE_BUFFER, bufferName);
+        glBufferData(GL_COPY_WRITE_BUFFER, allocator.getCapacity() * elementSize, nullptr, GL_STATIC_DRAW);
+        GLStateCache::BindBuffer(GL_COPY_WRITE_BUFFER, 0);
+        generation++;
+    }
+    size_t offset = 0;
+    if(!allocator.allocate(numElements, offset)) {
+        // Compact, doubling the capacity if the free space wouldn't fit the allocation
+        size_t newCapacity = allocator.getCapacity();
+        while(newCapacity - allocator.getUsedSize() < numElements) {
+            newCapacity = (newCapacity == 0) ? numElements : newCapacity * 2;
+        }
+        if(newCapacity != allocator.getCapacity()) {
+            numGrows++;
+        }
+        reallocate(newCapacity);
+        allocator.allocate(numElements, offset);
+    }
+    
+    if(data != nullptr) {
+        UploadScheduler::UploadToBuffer(bufferName, offset * elementSize, numElements * elementSize, data);
+    }
+    unsigned int allocationID = spareAllocationID++;
+    allocationOffsets[allocationID] = offset;
+    return allocationID;
+}
+
+void GPUBufferHeap::free(const unsigned int allocationID) {
+    if(allocationID == EMPTY_ALLOCATION_ID) {
+        return;
+    }
+    std::unordered_map<unsigned int, size_t>::iterator iter = allocationOffsets.find(allocationID);
+#ifdef _DEBUG
+    assert(iter != allocationOffsets.end());
+#endif
+    allocator.free(iter->second);
+    allocationOffsets.erase(iter);
+}
+
+void GPUBufferHeap::read(const unsigned int allocationID, void* data) const {
+    if(allocationID == EMPTY_ALLOCATION_ID) {
+        return;
+    }
+    GLStateCache::BindBuffer(GL_COPY_READ_BUFFER, bufferName);
+    glGetBufferSubData(GL_COPY_READ_BUFFER, getOffset(allocationID) * elementSize, getNumElements(allocationID) * elementSize, data);
+    GLStateCache::BindBuffer(GL_COPY_READ_BUFFER, 0);
+}
+
+void GPUBufferHeap::defragment() {
+    if(allocator.getStats().numFreeBlocks <= 1) {
+        return;
+    }
+    reallocate(allocator.getCapacity());
+}
+
+void GPUBufferHeap::destroy() {
+#ifdef _DEBUG
+    assert(allocationOffsets.empty());
+#endif
+    if(bufferName != 0) {
+        glDeleteBuffers(1, &bufferName);
+        GLStateCache::ForgetBuffer(bufferName);
+        bufferName = 0;
+    }
+}
+
+size_t GPUBufferHeap::getOffset(const unsigned int allocationID) const {
+    if(allocationID == EMPTY_ALLOCATION_ID) {
+        return 0;
+    }
+    std::unordered_map<unsigned int, size_t>::const_iterator iter = allocationOffsets.find(allocationID);
+#ifdef _DEBUG
+    assert(iter != allocationOffsets.end());
+#endif
+    return iter->second;
+}
+
+size_t GPUBufferHeap::getNumElements(const unsigned int allocationID) const {
+    if(allocationID == EMPTY_ALLOCATION_ID) {
+        return 0;
+    }
+    return allocator.getAllocationSize(getOffset(allocationID));
+}
+
+void GPUBufferHeap::reallocate(const size_t newCapacity) {
+    // Offsets of allocations that stay where they are don't appear in the moves, so copy every allocation by walking
+    // the old layout in order
+    std::vector<std::pair<size_t, size_t>> oldRanges;
+    for(std::unordered_map<unsigned int, size_t>::iterator iter = allocationOffsets.begin(); iter != allocationOffsets.end(); iter++) {
+        oldRanges.push_back(std::make_pair(iter->second, allocator.getAllocationSize(iter->second)));
+    }
+    std::vector<TLSFAllocator::Move> moves = allocator.defragment();
+    allocator.grow(newCapacity);
+    std::unordered_map<size_t, size_t> newOffsets;
+    for(unsigned int i = 0; i < moves.size(); i++) {
+        newOffsets[moves[i].oldOffset] = moves[i].newOffset;
+    }
+    
+    unsigned int newBufferName = 0;
+    glGenBuffers(1, &newBufferName);
+    GLStateCache::BindBuffer(GL_COPY_WRITE_BUFFER, newBufferName);
+    glBufferData(GL_COPY_WRITE_BUFFER, newCapacity * elementSize, nullptr, GL_STATIC_DRAW);
+    GLStateCache::BindBuffer(GL_COPY_READ_BUFFER, bufferName);
+    
+    // Copy in old offset order, merging allocations that stay contiguous into a single copy
+    std::sort(oldRanges.begin(), oldRanges.end());
+    size_t runOldOffset = 0;
+    size_t runNewOffset = 0;
+    size_t runSize = 0;
+    for(unsigned int i = 0; i <= oldRanges.size(); i++) {
+        size_t oldOffset = 0;
+        size_t newOffset = 0;
+        size_t size = 0;
+        if(i < oldRanges.size()) {
+            oldOffset = oldRanges[i].first;
+            size = oldRanges[i].second;
+            std::unordered_map<size_t, size_t>::iterator newOffsetIter = newOffsets.find(oldOffset);
+            newOffset = (newOffsetIter != newOffsets.end()) ? newOffsetIter->second : oldOffset;
+            if(runSize != 0 && oldOffset == runOldOffset + runSize && newOffset == runNewOffset + runSize) {
+                runSize += size;
+                continue;
+            }
+        }
+        if(runSize != 0) {
+            glCopyBufferSubData(GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER, runOldOffset * elementSize, runNewOffset * elementSize, runSize * elementSize);
+        }
+        runOldOffset = oldOffset;
+        runNewOffset = newOffset;
+        runSize = size;
+    }
+    GLStateCache::BindBuffer(GL_COPY_READ_BUFFER, 0);
+    GLStateCache::BindBuffer(GL_COPY_WRITE_BUFFER, 0);
+    glDeleteBuffers(1, &bufferName);
+    GLStateCache::ForgetBuffer(bufferName);
+    bufferName = newBufferName;
+    generation++;
+    
+    for(std::unordered_map<unsigned int, size_t>::iterator iter = allocationOffsets.begin(); iter != allocationOffsets.end(); iter++) {
+        std::unordered_map<size_t, size_t>::iterator newOffsetIter = newOffsets.find(iter->second);
+        if(newOffsetIter != newOffsets.end()) {
+            bytesMoved += allocator.getAllocationSize(newOffsetIter->second) * elementSize;
+            iter->second = newOffsetIter->second;
+        }
+    }
+    numDefragments++;
+}
+
+}
@@ -0,0 +1,88 @@
+#ifndef GPU_BUFFER_HEAP_H
+#define GPU_BUFFER_HEAP_H
+
+#include <graphics/buffer/tlsf_allocator.h>
+#include <unordered_map>
+#include <cstddef>
+
+#include <glad/glad.h>
+
+namespace Engine {
+
+/*
+ * GPUBufferHeap sub-allocates fixed size elements (e.g. vertices or indices) from a single OpenGL buffer. Allocations
+ * are referred to by allocation ID since their offsets change when the heap is defragmented. When an allocation
+ * doesn't fit, the heap is compacted into a new buffer, growing it if the free space isn't enough. The OpenGL buffer
+ * is created on first allocation.
+ */
+class GPUBufferHeap {
+    public:
+        static constexpr unsigned int EMPTY_ALLOCATION_ID = ~0u;
+        
+        GPUBufferHeap(const size_t elementSize, const size_t initialCapacity);
+        
+        /*
+         * Allocates numElements elements, uploads them from data (if not null) and returns the allocation ID. An empty
+         * allocation takes no space and returns EMPTY_ALLOCATION_ID, which has offset 0 and no elements.
+         */
+        unsigned int allocate(const size_t numElements, const void* data);
+        
+        /*
+         * Frees allocation with ID allocationID.
+         */
+        void free(const unsigned int allocationID);
+        
+        /*
+         * Reads the elements of allocation with ID allocationID back from the OpenGL buffer into data.
+         */
+        void read(const unsigned int allocationID, void* data) const;
+        
+        /*
+         * Moves all allocations to the start of a new buffer of the same capacity. Does nothing if the free space is
+         * already in one block.
+         */
+        void defragment();
+        
+        /*
+         * Deletes the OpenGL buffer. Only valid once every allocation has been freed.
+         */
+        void destroy();
+        
+        /*
+         * Returns the offset of allocation with ID allocationID in elements from the start of the buffer.
+         */
+        size_t getOffset(const unsigned int allocationID) const;
+        size_t getNumElements(const unsigned int allocationID) const;
+        
+        unsigned int getBufferName() const { return bufferName; }
+        size_t getElementSize() const { return elementSize; }
+        
+        /*
+         * Incremented each time the OpenGL buffer is replaced, so that vertex arrays pointing at it can be updated.
+         */
+        unsigned int getGeneration() const { return generation; }
+        
+        const TLSFAllocator& getAllocator() const { return allocator; }
+        unsigned long long getNumGrows() const { return numGrows; }
+        unsigned long long getNumDefragments() const { return numDefragments; }
+        unsigned long long getBytesMoved() const { return bytesMoved; }
+    private:
+        /*
+         * Compacts all allocations into a new buffer with capacity newCapacity elements and deletes the old buffer.
+         */
+        void reallocate(const size_t newCapacity);
+        
+        size_t elementSize;
+        TLSFAllocator allocator;
+        unsigned int bufferName = 0;
+        unsigned int generation = 0;
+        unsigned int spareAllocationID = 1;
+        std::unordered_map<unsigned int, size_t> allocationOffsets;
+        unsigned long long numGrows = 0;
+        unsigned long long numDefragments = 0;
+        unsigned long long bytesMoved = 0;
+};
+
+}
+
+#endif //GPU_BUFFER_HEAP_H
@@ -0,0 +1,87 @@
+#include "persistent_mapped_buffer.h"
+#include <graphics/state/gl_state_cache.h>
+
+namespace Engine {
+
+PersistentMappedBuffer::PersistentMappedBuffer(const size_t regionSize, const unsigned int numRegions)
+    : regionSize(regionSize), numRegions(numRegions), currentRegion(numRegions - 1), regionFences(numRegions, nullptr) {}
+
+void* PersistentMappedBuffer::beginWrite() {
+    if(bufferName == 0) {
+        create();
+    }
+    currentRegion = (currentRegion + 1) % numRegions;
+    GLsync& fence = regionFences[currentRegion];
+    if(fence != nullptr) {
+        GLenum waitResult = glClientWaitSync(fence, 0, 0);
+        if(waitResult == GL_TIMEOUT_EXPIRED) {
+            numStalls++;
+            while(waitResult == GL_TIMEOUT_EXPIRED) {
+                waitResult = glClientWaitSync(fence, GL_SYNC_FLUSH_COMMANDS_BIT, 1000000);
+            }
+        }
+        glDeleteSync(fence);
+        fence = nullptr;
+    }
+    if(mappedPtr != nullptr) {
+        return mappedPtr + currentRegion * regionSize;
+    }
+    return stagingData.data();
+}
+
+void PersistentMappedBuffer::endWrite(const size_t numBytesWritten) {
+    if(mappedPtr != nullptr || numBytesWritten == 0) {
+        // Coherent mapping, writes are already visible
+        return;
+    }
+    GLStateCache::BindBuffer(GL_COPY_WRITE_BUFFER, bufferName);
+    glBufferSubData(GL_COPY_WRITE_BUFFER, currentRegion * regionSize, numBytesWritten, stagingData.data());
+    GLStateCache::BindBuffer(GL_COPY_WRITE_BUFFER, 0);
+}
+
+void PersistentMappedBuffer::fenceRegion() {
+    if(regionFences[currentRegion] != nullptr) {
+        glDeleteSync(regionFences[currentRegion]);
+    }
+    regionFences[currentRegion] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+}
+
+void PersistentMappedBuffer::destroy() {
+    for(unsigned int i = 0; i < numRegions; i++) {
+        if(regionFences[i] != nullptr) {
+            glDeleteSync(regionFences[i]);
+            regionFences[i] = nullptr;
+        }
+    }
+    if(bufferName != 0) {
+        if(mappedPtr != nullptr) {
+            GLStateCache::BindBuffer(GL_COPY_WRITE_BUFFER, bufferName);
+            glUnmapBuffer(GL_COPY_WRITE_BUFFER);
+            GLStateCache::BindBuffer(GL_COPY_WRITE_BUFFER, 0);
+            mappedPtr = nullptr;
+        }
+        glDeleteBuffers(1, &bufferName);
+        GLStateCache::ForgetBuffer(bufferName);
+        bufferName = 0;
+    }
+    stagingData.clear();
+    currentRegion = numRegions - 1;
+}
+
+void PersistentMappedBuffer::create() {
+    size_t bufferSize = regionSize * numRegions;
+    glGenBuffers(1, &bufferName);
+    GLStateCache::BindBuffer(GL_COPY_WRITE_BUFFER, bufferName);
+    if(GLAD_GL_ARB_buffer_storage) {
+        GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+        glBufferStorage(GL_COPY_WRITE_BUFFER, bufferSize, nullptr, flags);
+        mappedPtr = (unsigned char*)glMapBufferRange(GL_COPY_WRITE_BUFFER, 0, bufferSize, flags);
+    }
+    if(mappedPtr == nullptr) {
+        glBufferData(GL_COPY_WRITE_BUFFER, bufferSize, nullptr, GL_STREAM_DRAW);
+        stagingData.resize(regionSize);
+    }
+    GLStateCache::BindBuffer(GL_COPY_WRITE_BUFFER, 0);
+}
+
+}
@@ -0,0 +1,73 @@
+#ifndef PERSISTENT_MAPPED_BUFFER_H
+#define PERSISTENT_MAPPED_BUFFER_H
+
+#include <vector>
+#include <cstddef>
+
+#include <glad/glad.h>
+
+namespace Engine {
+
+/*
+ * PersistentMappedBuffer is an OpenGL buffer split into numRegions regions that the CPU writes through a persistent,
+ * coherent mapping while the GPU reads the previous regions. Each region is fenced after the commands reading it have
+ * been submitted, and writing to it again waits for that fence. Without ARB_buffer_storage it falls back to writing
+ * into system memory and uploading the region with glBufferSubData.
+ *
+ * Usage per frame: beginWrite(), write to the returned pointer, endWrite(), issue the commands, fenceRegion().
+ */
+class PersistentMappedBuffer {
+    public:
+        PersistentMappedBuffer(const size_t regionSize, const unsigned int numRegions = 3);
+        
+        /*
+         * Moves on to the next region, waiting for the GPU to finish reading it, and returns a pointer to write it.
+         * Creates the OpenGL buffer on first use.
+         */
+        void* beginWrite();
+        
+        /*
+         * Makes the bytes written to the current region visible to OpenGL.
+         */
+        void endWrite(const size_t numBytesWritten);
+        
+        /*
+         * Fences the current region once the commands reading it have been submitted.
+         */
+        void fenceRegion();
+        
+        /*
+         * Deletes the OpenGL buffer and any pending fences.
+         */
+        void destroy();
+        
+        unsigned int getBufferName() const { return bufferName; }
+        size_t getRegionSize() const { return regionSize; }
+        
+        /*
+         * Returns the byte offset of the current region from the start of the buffer.
+         */
+        size_t getRegionOffset() const { return currentRegion * regionSize; }
+        bool isPersistent() const { return mappedPtr != nullptr; }
+        
+        /*
+         * Returns the number of times beginWrite() had to wait for the GPU.
+         */
+        unsigned long long getNumStalls() const { return numStalls; }
+    private:
+        void create();
+        
+        size_t regionSize;
+        unsigned int numRegions;
+        unsigned int currentRegion;
+        unsigned int bufferName = 0;
+        unsigned char* mappedPtr = nullptr;
+        // Used instead of the mapping when buffer storage isn't available
+        std::vector<unsigned char> stagingData;
+        std::vector<GLsync> regionFences;
+        unsigned long long numStalls = 0;
+};
+
+}
+
+#endif //PERSISTENT_MAPPED_BUFFER_H
@@ -0,0 +1,33 @@
+#ifndef RESIDENCY_H
+#define RESIDENCY_H
+
+#include <cstddef>
+
+namespace Engine {
+
+/*
+ * ResidencyPolicy decides what happens to a resource's system memory copy once it has been buffered with OpenGL.
+ */
+enum ResidencyPolicy {
+    // Keep the system memory copy for as long as the resource is loaded.
+    RESIDENCY_KEEP_HOST_COPY,
+    // Drop the system memory copy after buffering. Accessing the data afterwards is an error, and the resource can't
+    // be buffered again once it has been unbuffered.
+    RESIDENCY_DISCARD_HOST_COPY,
+    // Drop the system memory copy after buffering and fetch it back on demand, from the source file if the resource
+    // has one or otherwise by reading back the OpenGL buffer. The copy is fetched back before the resource is
+    // unbuffered so that it can be buffered again.
+    RESIDENCY_REFETCH_HOST_COPY
+};
+
+/*
+ * Bytes held by a loader in system memory (host) and in OpenGL buffers and textures (device).
+ */
+struct MemoryStats {
+    size_t hostBytes = 0;
+    size_t deviceBytes = 0;
+};
+
+}
+
+#endif //RESIDENCY_H
@@ -0,0 +1,54 @@
+#include "resource_reclaimer.h"
+#include <graphics/mesh/mesh_data.h>
+#include <graphics/texture/texture_data.h>
+
+namespace Engine {
+
+void ResourceReclaimer::EndFrame() {
+    FrameClock::AdvanceFrame();
+    // Meshes first, since unbuffering a mesh relaxes its mesh geometry
+    MeshLoader::ProcessDeferredReleases();
+    MeshGeometryLoader::ProcessDeferredReleases();
+    TextureLoader::ProcessDeferredReleases();
+}
+
+void ResourceReclaimer::ReclaimAll() {
+    MeshLoader::ProcessDeferredReleases(true);
+    MeshGeometryLoader::ProcessDeferredReleases(true);
+    TextureLoader::ProcessDeferredReleases(true);
+}
+
+void ResourceReclaimer::SetReleaseDelayFrames(const unsigned int releaseDelayFrames) {
+    MeshLoader::GetReleaseQueue().setReleaseDelayFrames(releaseDelayFrames);
+    MeshGeometryLoader::GetReleaseQueue().setReleaseDelayFrames(releaseDelayFrames);
+    TextureLoader::GetReleaseQueue().setReleaseDelayFrames(releaseDelayFrames);
+}
+
+void ResourceReclaimer::SetPendingByteBudget(const size_t pendingByteBudget) {
+    MeshLoader::GetReleaseQueue().setPendingByteBudget(pendingByteBudget);
+    MeshGeometryLoader::GetReleaseQueue().setPendingByteBudget(pendingByteBudget);
+    TextureLoader::GetReleaseQueue().setPendingByteBudget(pendingByteBudget);
+}
+
+DeferredReleaseStats ResourceReclaimer::GetStats() {
+    const DeferredReleaseQueue* releaseQueues[] = {&MeshLoader::GetReleaseQueue(), &MeshGeometryLoader::GetReleaseQueue(),
+            &TextureLoader::GetReleaseQueue()};
+    DeferredReleaseStats totalStats;
+    for(unsigned int i = 0; i < 3; i++) {
+        const DeferredReleaseStats& stats = releaseQueues[i]->getStats();
+        totalStats.deferredReleases += stats.deferredReleases;
+        totalStats.resurrections += stats.resurrections;
+        totalStats.reclaims += stats.reclaims;
+        totalStats.pressureReclaims += stats.pressureReclaims;
+        totalStats.thrashEvents += stats.thrashEvents;
+    }
+    return totalStats;
+}
+
+void ResourceReclaimer::ResetStats() {
+    MeshLoader::GetReleaseQueue().resetStats();
+    MeshGeometryLoader::GetReleaseQueue().resetStats();
+    TextureLoader::GetReleaseQueue().resetStats();
+}
+
+}
@@ -0,0 +1,47 @@
+#ifndef RESOURCE_RECLAIMER_H
+#define RESOURCE_RECLAIMER_H
+
+#include <graphics/buffer/deferred_release_queue.h>
+#include <cstddef>
+
+namespace Engine {
+
+/*
+ * ResourceReclaimer drives the deferred release queues of the mesh, mesh geometry and texture loaders. Released
+ * resources keep their OpenGL objects for a number of frames so that releasing and using a resource again (e.g. when a
+ * Mesh or Texture is copied by value) doesn't delete and regenerate them.
+ */
+class ResourceReclaimer {
+    public:
+        /*
+         * Advances the frame clock and reclaims the released resources that have gone unused for the release delay.
+         * Call once per frame after swapping buffers.
+         */
+        static void EndFrame();
+        
+        /*
+         * Reclaims every released resource immediately, e.g. under memory pressure.
+         */
+        static void ReclaimAll();
+        
+        /*
+         * Sets how many frames a released resource stays buffered before it is reclaimed, for all loaders.
+         */
+        static void SetReleaseDelayFrames(const unsigned int releaseDelayFrames);
+        
+        /*
+         * Sets how many bytes of released resources each loader may keep buffered before reclaiming early. 0 means no
+         * limit.
+         */
+        static void SetPendingByteBudget(const size_t pendingByteBudget);
+        
+        /*
+         * Returns the deferred release counters summed over all loaders.
+         */
+        static DeferredReleaseStats GetStats();
+        static void ResetStats();
+};
+
+}
+
+#endif //RESOURCE_RECLAIMER_H
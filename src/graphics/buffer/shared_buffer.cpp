@@ -0,0 +1,11 @@
+#include "shared_buffer.h"
+
+namespace Engine {
+
+/*
+ * Class BufferCopyStats
+ */
+std::atomic<unsigned long long> BufferCopyStats::bytesCopied(0);
+std::atomic<unsigned long long> BufferCopyStats::copyCount(0);
+
+}
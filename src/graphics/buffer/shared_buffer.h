@@ -0,0 +1,122 @@
+#ifndef SHARED_BUFFER_H
+#define SHARED_BUFFER_H
+
+#include <vector>
+#include <memory>
+#include <atomic>
+#include <cstring>
+#include <cassert>
+
+namespace Engine {
+
+/*
+ * BufferCopyStats counts the bytes copied by SharedBuffer so that loaders can be checked for defensive copies.
+ */
+class BufferCopyStats {
+    public:
+        static void AddBytesCopied(const size_t numBytes) { bytesCopied += numBytes; copyCount++; }
+        static unsigned long long GetBytesCopied() { return bytesCopied; }
+        static unsigned long long GetCopyCount() { return copyCount; }
+        static void Reset() { bytesCopied = 0; copyCount = 0; }
+    private:
+        static std::atomic<unsigned long long> bytesCopied;
+        static std::atomic<unsigned long long> copyCount;
+};
+
+/*
+ * SharedBuffer is an immutable, reference counted array. Copying a SharedBuffer shares the underlying array. Writing
+ * requires calling mutableData(), which first copies the array if any other SharedBuffer still refers to it
+ * (copy-on-write).
+ */
+template<typename T>
+class SharedBuffer {
+    public:
+        SharedBuffer() : dataPtr(), size(0) {}
+        
+        /*
+         * Takes ownership of the contents of data without copying.
+         */
+        SharedBuffer(std::vector<T>&& data);
+        
+        /*
+         * Copies the contents of data. Prefer the move constructor when the vector isn't needed afterwards.
+         */
+        explicit SharedBuffer(const std::vector<T>& data);
+        
+        /*
+         * Takes ownership of an existing array of numElements elements without copying. The array is released through
+         * dataPtr's deleter.
+         */
+        SharedBuffer(const std::shared_ptr<T[]> dataPtr, const size_t numElements) : dataPtr(dataPtr), size(numElements) {}
+        
+        const T& operator[](const size_t index) const;
+        const T* data() const { return dataPtr.get(); }
+        const T* begin() const { return dataPtr.get(); }
+        const T* end() const { return dataPtr.get() + size; }
+        size_t getSize() const { return size; }
+        size_t getSizeInBytes() const { return size * sizeof(T); }
+        bool isEmpty() const { return size == 0; }
+        
+        /*
+         * Returns true if no other SharedBuffer refers to this buffer's array.
+         */
+        bool isUnique() const { return dataPtr.use_count() <= 1; }
+        
+        /*
+         * Returns true if both buffers refer to the same array.
+         */
+        bool sharesWith(const SharedBuffer<T>& other) const { return dataPtr == other.dataPtr; }
+        
+        /*
+         * Returns a writable pointer to this buffer's array, copying the array first if it is shared.
+         */
+        T* mutableData();
+        
+        /*
+         * Returns a copy of the contents as a vector.
+         */
+        std::vector<T> toVector() const;
+    private:
+        std::shared_ptr<T[]> dataPtr;
+        size_t size;
+};
+
+template<typename T>
+SharedBuffer<T>::SharedBuffer(std::vector<T>&& data) : dataPtr(), size(data.size()) {
+    std::shared_ptr<std::vector<T>> vectorPtr = std::make_shared<std::vector<T>>(std::move(data));
+    // Aliasing constructor shares ownership of the vector while pointing at its elements
+    dataPtr = std::shared_ptr<T[]>(vectorPtr, vectorPtr->data());
+}
+
+template<typename T>
+SharedBuffer<T>::SharedBuffer(const std::vector<T>& data) : SharedBuffer(std::vector<T>(data)) {
+    BufferCopyStats::AddBytesCopied(data.size() * sizeof(T));
+}
+
+template<typename T>
+const T& SharedBuffer<T>::operator[](const size_t index) const {
+#ifdef _DEBUG
+    assert(index < size);
+#endif
+    return dataPtr[index];
+}
+
+template<typename T>
+T* SharedBuffer<T>::mutableData() {
+    if(!isUnique()) {
+        std::vector<T> copiedData(dataPtr.get(), dataPtr.get() + size);
+        BufferCopyStats::AddBytesCopied(getSizeInBytes());
+        (*this) = SharedBuffer<T>(std::move(copiedData));
+    }
+    return dataPtr.get();
+}
+
+template<typename T>
+std::vector<T> SharedBuffer<T>::toVector() const {
+    BufferCopyStats::AddBytesCopied(getSizeInBytes());
+    return std::vector<T>(begin(), end());
+}
+
+}
+
+#endif //SHARED_BUFFER_H
@@ -0,0 +1,148 @@
+#include "streaming_ring.h"
+#include <graphics/state/gl_state_cache.h>
+
+namespace Engine {
+
+StreamingRing::StreamingRing(const size_t capacity) : capacity(capacity) {}
+
+void* StreamingRing::allocate(const size_t size, const size_t alignment, size_t& offset) {
+    if(size > capacity) {
+        return nullptr;
+    }
+    void* dataPtr = tryAllocate(size, alignment, offset);
+    if(dataPtr != nullptr) {
+        return dataPtr;
+    }
+    stats.numStalls++;
+    while(true) {
+        if(pendingFrames.empty()) {
+            // Only the current frame's allocations are left, which haven't been submitted so can't be waited for
+            return nullptr;
+        }
+        retireFrames(true);
+        if(allocateFromFreeSpace(size, alignment, offset)) {
+            return (mappedPtr != nullptr) ? mappedPtr + offset : stagingData.data() + offset;
+        }
+    }
+}
+
+void* StreamingRing::tryAllocate(const size_t size, const size_t alignment, size_t& offset) {
+    if(size > capacity) {
+        return nullptr;
+    }
+    if(bufferName == 0) {
+        create();
+    }
+    retireFrames(false);
+    if(!allocateFromFreeSpace(size, alignment, offset)) {
+        return nullptr;
+    }
+    return (mappedPtr != nullptr) ? mappedPtr + offset : stagingData.data() + offset;
+}
+
+void StreamingRing::commit(const size_t offset, const size_t size) {
+    if(mappedPtr != nullptr || size == 0) {
+        // Coherent mapping, writes are already visible
+        return;
+    }
+    GLStateCache::BindBuffer(GL_COPY_WRITE_BUFFER, bufferName);
+    glBufferSubData(GL_COPY_WRITE_BUFFER, offset, size, stagingData.data() + offset);
+    GLStateCache::BindBuffer(GL_COPY_WRITE_BUFFER, 0);
+}
+
+void StreamingRing::endFrame() {
+    if(frameBytes == 0) {
+        return;
+    }
+    pendingFrames.push_back({glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0), frameBytes});
+    frameBytes = 0;
+}
+
+void StreamingRing::destroy() {
+    for(unsigned int i = 0; i < pendingFrames.size(); i++) {
+        glDeleteSync(pendingFrames[i].fence);
+    }
+    pendingFrames.clear();
+    if(bufferName != 0) {
+        if(mappedPtr != nullptr) {
+            GLStateCache::BindBuffer(GL_COPY_WRITE_BUFFER, bufferName);
+            glUnmapBuffer(GL_COPY_WRITE_BUFFER);
+            GLStateCache::BindBuffer(GL_COPY_WRITE_BUFFER, 0);
+            mappedPtr = nullptr;
+        }
+        glDeleteBuffers(1, &bufferName);
+        GLStateCache::ForgetBuffer(bufferName);
+        bufferName = 0;
+    }
+    stagingData.clear();
+    head = 0;
+    usedBytes = 0;
+    frameBytes = 0;
+}
+
+void StreamingRing::create() {
+    glGenBuffers(1, &bufferName);
+    GLStateCache::BindBuffer(GL_COPY_WRITE_BUFFER, bufferName);
+    if(GLAD_GL_ARB_buffer_storage) {
+        GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+        glBufferStorage(GL_COPY_WRITE_BUFFER, capacity, nullptr, flags);
+        mappedPtr = (unsigned char*)glMapBufferRange(GL_COPY_WRITE_BUFFER, 0, capacity, flags);
+    }
+    if(mappedPtr == nullptr) {
+        glBufferData(GL_COPY_WRITE_BUFFER, capacity, nullptr, GL_STREAM_DRAW);
+        stagingData.resize(capacity);
+    }
+    GLStateCache::BindBuffer(GL_COPY_WRITE_BUFFER, 0);
+}
+
+bool StreamingRing::allocateFromFreeSpace(const size_t size, const size_t alignment, size_t& offset) {
+    if(usedBytes == 0) {
+        // Nothing is in flight, so start over at the beginning rather than wrap later
+        head = 0;
+    }
+    size_t alignedHead = (alignment > 1) ? (head + alignment - 1) / alignment * alignment : head;
+    size_t start = alignedHead;
+    // The padding before the allocation, or the unused end of the buffer when wrapping, is held until the frame retires
+    size_t numBytes = (alignedHead - head) + size;
+    bool wraps = alignedHead + size > capacity;
+    if(wraps) {
+        start = 0;
+        numBytes = (capacity - head) + size;
+    }
+    if(usedBytes + numBytes > capacity) {
+        return false;
+    }
+    if(wraps) {
+        stats.numWraps++;
+    }
+    head = start + size;
+    usedBytes += numBytes;
+    frameBytes += numBytes;
+    stats.bytesAllocated += size;
+    stats.numAllocations++;
+    offset = start;
+    return true;
+}
+
+void StreamingRing::retireFrames(const bool wait) {
+    bool waitForNext = wait;
+    while(!pendingFrames.empty()) {
+        PendingFrame& frame = pendingFrames.front();
+        GLenum waitResult = glClientWaitSync(frame.fence, 0, 0);
+        if(waitResult == GL_TIMEOUT_EXPIRED) {
+            if(!waitForNext) {
+                return;
+            }
+            while(waitResult == GL_TIMEOUT_EXPIRED) {
+                waitResult = glClientWaitSync(frame.fence, GL_SYNC_FLUSH_COMMANDS_BIT, 1000000);
+            }
+        }
+        // Wait for at most one frame, later ones are only retired if they have already finished
+        waitForNext = false;
+        glDeleteSync(frame.fence);
+        usedBytes -= frame.numBytes;
+        pendingFrames.pop_front();
+    }
+}
+
+}
@@ -0,0 +1,103 @@
+#ifndef STREAMING_RING_H
+#define STREAMING_RING_H
+
+#include <vector>
+#include <deque>
+#include <cstddef>
+
+#include <glad/glad.h>
+
+namespace Engine {
+
+/*
+ * Counts of the work done by a StreamingRing.
+ */
+struct StreamingRingStats {
+    unsigned long long bytesAllocated = 0;
+    unsigned long long numAllocations = 0;
+    // Allocations that had to wait for the GPU to finish with an older frame
+    unsigned long long numStalls = 0;
+    // Allocations that didn't fit before the end of the buffer and restarted at its beginning
+    unsigned long long numWraps = 0;
+};
+
+/*
+ * StreamingRing is a persistently mapped OpenGL buffer that is allocated from like a ring. Each frame's allocations are
+ * fenced by endFrame(), and the space they take is reused once the GPU has signalled the fence, so the CPU can write
+ * the next frames' data while the GPU still reads the previous ones. Without ARB_buffer_storage the ring is written in
+ * system memory and commit() uploads the written range with glBufferSubData.
+ */
+class StreamingRing {
+    public:
+        StreamingRing(const size_t capacity);
+        
+        /*
+         * Returns a pointer to write size bytes to and sets offset to their offset in the buffer, waiting for the GPU
+         * if the ring is full. Returns nullptr if size is larger than the ring.
+         */
+        void* allocate(const size_t size, const size_t alignment, size_t& offset);
+        
+        /*
+         * Like allocate() but returns nullptr instead of waiting for the GPU.
+         */
+        void* tryAllocate(const size_t size, const size_t alignment, size_t& offset);
+        
+        /*
+         * Makes size bytes written at offset visible to OpenGL. Call before issuing commands that read them.
+         */
+        void commit(const size_t offset, const size_t size);
+        
+        /*
+         * Fences the allocations made since the last call. Call once per frame after the commands reading them.
+         */
+        void endFrame();
+        
+        /*
+         * Deletes the OpenGL buffer and fences.
+         */
+        void destroy();
+        
+        unsigned int getBufferName() const { return bufferName; }
+        size_t getCapacity() const { return capacity; }
+        
+        /*
+         * Returns the bytes allocated in frames the GPU may not have finished with, including padding.
+         */
+        size_t getUsedBytes() const { return usedBytes; }
+        unsigned int getNumPendingFrames() const { return pendingFrames.size(); }
+        bool isPersistent() const { return mappedPtr != nullptr; }
+        const StreamingRingStats& getStats() const { return stats; }
+        void resetStats() { stats = StreamingRingStats(); }
+    private:
+        struct PendingFrame {
+            GLsync fence;
+            size_t numBytes;
+        };
+        
+        void create();
+        
+        /*
+         * Allocates from the free space without waiting. Returns false if the allocation doesn't fit.
+         */
+        bool allocateFromFreeSpace(const size_t size, const size_t alignment, size_t& offset);
+        
+        /*
+         * Frees the frames whose fences have been signalled, waiting for the oldest frame if wait is true.
+         */
+        void retireFrames(const bool wait);
+        
+        size_t capacity;
+        unsigned int bufferName = 0;
+        unsigned char* mappedPtr = nullptr;
+        // Used instead of the mapping when buffer storage isn't available
+        std::vector<unsigned char> stagingData;
+        size_t head = 0;
+        size_t usedBytes = 0;
+        size_t frameBytes = 0;
+        std::deque<PendingFrame> pendingFrames;
+        StreamingRingStats stats;
+};
+
+}
+
+#endif //STREAMING_RING_H
@@ -0,0 +1,237 @@
+#include "tlsf_allocator.h"
+#include <cassert>
+
+namespace Engine {
+
+static unsigned int floorLog2(const size_t value) {
+    return 63 - __builtin_clzll((unsigned long long)value);
+}
+
+TLSFAllocator::TLSFAllocator(const size_t capacity) {
+    grow(capacity);
+}
+
+bool TLSFAllocator::allocate(const size_t size, size_t& offset) {
+#ifdef _DEBUG
+    assert(size > 0);
+#endif
+    unsigned int fl = 0;
+    unsigned int sl = 0;
+    std::map<size_t, Block>::iterator blockIter = blocks.end();
+    if(findSuitableList(size, fl, sl)) {
+        blockIter = blocks.find(freeLists[fl][sl].front());
+    }
+    else {
+        // The rounded up search skips the list the size itself maps to, which may still hold a large enough block
+        Mapping(size, fl, sl);
+        for(std::list<size_t>::iterator iter = freeLists[fl][sl].begin(); iter != freeLists[fl][sl].end(); iter++) {
+            std::map<size_t, Block>::iterator candidateIter = blocks.find(*iter);
+            if(candidateIter->second.size >= size) {
+                blockIter = candidateIter;
+                break;
+            }
+        }
+        if(blockIter == blocks.end()) {
+            return false;
+        }
+    }
+    
+    offset = blockIter->first;
+    Block& block = blockIter->second;
+    removeFreeBlock(offset, block);
+    if(block.size > size) {
+        Block remainder;
+        remainder.size = block.size - size;
+        remainder.free = true;
+        Block& insertedRemainder = blocks[offset + size] = remainder;
+        insertFreeBlock(offset + size, insertedRemainder);
+        block.size = size;
+    }
+    block.free = false;
+    usedSize += size;
+    numAllocations++;
+    return true;
+}
+
+void TLSFAllocator::free(const size_t offset) {
+    std::map<size_t, Block>::iterator blockIter = blocks.find(offset);
+#ifdef _DEBUG
+    assert(blockIter != blocks.end() && !blockIter->second.free);
+#endif
+    usedSize -= blockIter->second.size;
+    numAllocations--;
+    blockIter->second.free = true;
+    
+    // Merge with the next block
+    std::map<size_t, Block>::iterator nextIter = std::next(blockIter);
+    if(nextIter != blocks.end() && nextIter->second.free) {
+        removeFreeBlock(nextIter->first, nextIter->second);
+        blockIter->second.size += nextIter->second.size;
+        blocks.erase(nextIter);
+    }
+    // Merge with the previous block
+    if(blockIter != blocks.begin()) {
+        std::map<size_t, Block>::iterator previousIter = std::prev(blockIter);
+        if(previousIter->second.free) {
+            removeFreeBlock(previousIter->first, previousIter->second);
+            previousIter->second.size += blockIter->second.size;
+            blocks.erase(blockIter);
+            blockIter = previousIter;
+        }
+    }
+    insertFreeBlock(blockIter->first, blockIter->second);
+}
+
+size_t TLSFAllocator::getAllocationSize(const size_t offset) const {
+    std::map<size_t, Block>::const_iterator blockIter = blocks.find(offset);
+#ifdef _DEBUG
+    assert(blockIter != blocks.end() && !blockIter->second.free);
+#endif
+    return blockIter->second.size;
+}
+
+void TLSFAllocator::grow(const size_t newCapacity) {
+    if(newCapacity <= capacity) {
+        return;
+    }
+    size_t offset = capacity;
+    size_t size = newCapacity - capacity;
+    capacity = newCapacity;
+    if(!blocks.empty()) {
+        std::map<size_t, Block>::iterator lastIter = std::prev(blocks.end());
+        if(lastIter->second.free) {
+            removeFreeBlock(lastIter->first, lastIter->second);
+            lastIter->second.size += size;
+            insertFreeBlock(lastIter->first, lastIter->second);
+            return;
+        }
+    }
+    Block block;
+    block.size = size;
+    block.free = true;
+    Block& insertedBlock = blocks[offset] = block;
+    insertFreeBlock(offset, insertedBlock);
+}
+
+std::vector<TLSFAllocator::Move> TLSFAllocator::defragment() {
+    std::vector<Move> moves;
+    std::map<size_t, Block> compactedBlocks;
+    size_t nextOffset = 0;
+    for(std::map<size_t, Block>::iterator iter = blocks.begin(); iter != blocks.end(); iter++) {
+        if(iter->second.free) {
+            continue;
+        }
+        if(iter->first != nextOffset) {
+            Move move;
+            move.oldOffset = iter->first;
+            move.newOffset = nextOffset;
+            move.size = iter->second.size;
+            moves.push_back(move);
+        }
+        compactedBlocks[nextOffset] = iter->second;
+        nextOffset += iter->second.size;
+    }
+    
+    for(unsigned int i = 0; i < FL_COUNT; i++) {
+        for(unsigned int j = 0; j < SL_COUNT; j++) {
+            freeLists[i][j].clear();
+        }
+        slBitmaps[i] = 0;
+    }
+    flBitmap = 0;
+    numFreeBlocks = 0;
+    blocks = std::move(compactedBlocks);
+    if(nextOffset < capacity) {
+        Block block;
+        block.size = capacity - nextOffset;
+        block.free = true;
+        Block& insertedBlock = blocks[nextOffset] = block;
+        insertFreeBlock(nextOffset, insertedBlock);
+    }
+    return moves;
+}
+
+size_t TLSFAllocator::getLargestFreeBlock() const {
+    if(flBitmap == 0) {
+        return 0;
+    }
+    unsigned int fl = floorLog2(flBitmap);
+    unsigned int sl = floorLog2(slBitmaps[fl]);
+    size_t largestSize = 0;
+    for(std::list<size_t>::const_iterator iter = freeLists[fl][sl].begin(); iter != freeLists[fl][sl].end(); iter++) {
+        size_t size = blocks.find(*iter)->second.size;
+        largestSize = (size > largestSize) ? size : largestSize;
+    }
+    return largestSize;
+}
+
+AllocatorStats TLSFAllocator::getStats() const {
+    AllocatorStats stats;
+    stats.capacity = capacity;
+    stats.usedSize = usedSize;
+    stats.freeSize = getFreeSize();
+    stats.largestFreeBlock = getLargestFreeBlock();
+    stats.numAllocations = numAllocations;
+    stats.numFreeBlocks = numFreeBlocks;
+    stats.fragmentation = (stats.freeSize == 0) ? 0.0f : 1.0f - (float)stats.largestFreeBlock / (float)stats.freeSize;
+    return stats;
+}
+
+void TLSFAllocator::Mapping(const size_t size, unsigned int& fl, unsigned int& sl) {
+    if(size < SL_COUNT) {
+        fl = 0;
+        sl = size;
+        return;
+    }
+    unsigned int log2Size = floorLog2(size);
+    fl = log2Size - SL_BITS + 1;
+    sl = (size >> (log2Size - SL_BITS)) - SL_COUNT;
+}
+
+bool TLSFAllocator::findSuitableList(const size_t size, unsigned int& fl, unsigned int& sl) const {
+    // Round up to the next list boundary so that every block in the list found is large enough
+    size_t roundedSize = size;
+    if(size >= SL_COUNT) {
+        roundedSize += ((size_t)1 << (floorLog2(size) - SL_BITS)) - 1;
+    }
+    Mapping(roundedSize, fl, sl);
+    uint32_t slMap = (sl < SL_COUNT) ? slBitmaps[fl] & (~(uint32_t)0 << sl) : 0;
+    if(slMap == 0) {
+        uint64_t flMap = (fl + 1 < FL_COUNT) ? flBitmap & (~(uint64_t)0 << (fl + 1)) : 0;
+        if(flMap == 0) {
+            return false;
+        }
+        fl = __builtin_ctzll(flMap);
+        slMap = slBitmaps[fl];
+    }
+    sl = __builtin_ctz(slMap);
+    return true;
+}
+
+void TLSFAllocator::insertFreeBlock(const size_t offset, Block& block) {
+    unsigned int fl = 0;
+    unsigned int sl = 0;
+    Mapping(block.size, fl, sl);
+    freeLists[fl][sl].push_front(offset);
+    block.freeListIter = freeLists[fl][sl].begin();
+    block.free = true;
+    flBitmap |= (uint64_t)1 << fl;
+    slBitmaps[fl] |= (uint32_t)1 << sl;
+    numFreeBlocks++;
+}
+
+void TLSFAllocator::removeFreeBlock(const size_t offset, Block& block) {
+    unsigned int fl = 0;
+    unsigned int sl = 0;
+    Mapping(block.size, fl, sl);
+    freeLists[fl][sl].erase(block.freeListIter);
+    if(freeLists[fl][sl].empty()) {
+        slBitmaps[fl] &= ~((uint32_t)1 << sl);
+        if(slBitmaps[fl] == 0) {
+            flBitmap &= ~((uint64_t)1 << fl);
+        }
+    }
+    numFreeBlocks--;
+}
+
+}
@@ -0,0 +1,113 @@
+#ifndef TLSF_ALLOCATOR_H
+#define TLSF_ALLOCATOR_H
+
+#include <map>
+#include <list>
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+
+namespace Engine {
+
+/*
+ * Fragmentation statistics of a TLSFAllocator. fragmentation is 0 when all free space is in one block and approaches
+ * 1 as the free space gets split into many small blocks.
+ */
+struct AllocatorStats {
+    size_t capacity = 0;
+    size_t usedSize = 0;
+    size_t freeSize = 0;
+    size_t largestFreeBlock = 0;
+    unsigned int numAllocations = 0;
+    unsigned int numFreeBlocks = 0;
+    float fragmentation = 0.0f;
+};
+
+/*
+ * TLSFAllocator hands out ranges of a linear address space of capacity units using a two level segregated fit
+ * allocator. The free list to take a block from is found with two bitmap scans in constant time, but blocks are kept in
+ * a map by offset, so allocating and freeing take O(log n) in the number of blocks. When no list is guaranteed to fit,
+ * allocate also scans the one list the size maps to. It doesn't own any memory, the owner maps the returned offsets
+ * onto its own storage (e.g. an OpenGL buffer). Freed ranges are merged with free neighbours.
+ */
+class TLSFAllocator {
+    public:
+        /*
+         * A range moved by defragment().
+         */
+        struct Move {
+            size_t oldOffset;
+            size_t newOffset;
+            size_t size;
+        };
+        
+        TLSFAllocator(const size_t capacity = 0);
+        
+        /*
+         * Allocates size units and sets offset to the start of the range. Returns false if there is no free block
+         * large enough.
+         */
+        bool allocate(const size_t size, size_t& offset);
+        
+        /*
+         * Frees the range allocated at offset.
+         */
+        void free(const size_t offset);
+        
+        size_t getAllocationSize(const size_t offset) const;
+        
+        /*
+         * Extends the address space to newCapacity units. Existing allocations keep their offsets.
+         */
+        void grow(const size_t newCapacity);
+        
+        /*
+         * Moves all allocations to the start of the address space, in order, leaving a single free block at the end.
+         * Returns the ranges that moved, in increasing offset order.
+         */
+        std::vector<Move> defragment();
+        
+        size_t getCapacity() const { return capacity; }
+        size_t getUsedSize() const { return usedSize; }
+        size_t getFreeSize() const { return capacity - usedSize; }
+        unsigned int getNumAllocations() const { return numAllocations; }
+        size_t getLargestFreeBlock() const;
+        AllocatorStats getStats() const;
+    private:
+        static const unsigned int SL_BITS = 4;
+        static const unsigned int SL_COUNT = 1 << SL_BITS;
+        static const unsigned int FL_COUNT = 64;
+        
+        struct Block {
+            size_t size;
+            bool free;
+            std::list<size_t>::iterator freeListIter;
+        };
+        
+        /*
+         * Returns the first and second level indices of the free list holding blocks of the given size.
+         */
+        static void Mapping(const size_t size, unsigned int& fl, unsigned int& sl);
+        
+        /*
+         * Finds a free list whose blocks are all at least size units. Returns false if there is none.
+         */
+        bool findSuitableList(const size_t size, unsigned int& fl, unsigned int& sl) const;
+        
+        void insertFreeBlock(const size_t offset, Block& block);
+        void removeFreeBlock(const size_t offset, Block& block);
+        
+        // Blocks by offset, covering the whole address space without gaps
+        std::map<size_t, Block> blocks;
+        std::list<size_t> freeLists[FL_COUNT][SL_COUNT];
+        uint64_t flBitmap = 0;
+        uint32_t slBitmaps[FL_COUNT] = {};
+        size_t capacity = 0;
+        size_t usedSize = 0;
+        unsigned int numAllocations = 0;
+        unsigned int numFreeBlocks = 0;
+};
+
+}
+
+#endif //TLSF_ALLOCATOR_H
@@ -0,0 +1,202 @@
+#include "upload_scheduler.h"
+#include <graphics/state/gl_state_cache.h>
+#include <graphics/texture/texture_units.h>
+#include <algorithm>
+#include <cstring>
+#include <cassert>
+
+namespace Engine {
+
+/*
+ * Class UploadScheduler
+ */
+StreamingRing UploadScheduler::ring = StreamingRing(8 * 1024 * 1024);
+bool UploadScheduler::stagingEnabled = false;
+size_t UploadScheduler::frameByteBudget = 4 * 1024 * 1024;
+size_t UploadScheduler::frameBytesUploaded = 0;
+unsigned int UploadScheduler::spareID = 1;
+std::deque<UploadScheduler::PendingUpload> UploadScheduler::pendingUploads = std::deque<UploadScheduler::PendingUpload>();
+UploadStats UploadScheduler::stats = UploadStats();
+
+void UploadScheduler::UploadToBuffer(const GLuint buffer, const size_t dstOffset, const size_t numBytes, const void* data) {
+    CopyBufferRange(buffer, dstOffset, numBytes, data, true);
+}
+
+void UploadScheduler::UploadToTexture(const GLuint texture, const unsigned int width, const unsigned int height,
+        const PixelFormat pixelFormat, const void* data, const GLint level) {
+    CopyTextureRows(texture, width, 0, height, pixelFormat, level, data, true);
+}
+
+unsigned int UploadScheduler::QueueBufferUpload(const GLuint buffer, const size_t dstOffset, const SharedBuffer<unsigned char> data,
+        const std::function<void()> onComplete) {
+    unsigned int uploadID = spareID++;
+    pendingUploads.push_back({uploadID, UPLOAD_BUFFER, buffer, dstOffset, 0, 0, PIXEL_FORMAT_R8, 0, data, 0, onComplete});
+    return uploadID;
+}
+
+unsigned int UploadScheduler::QueueTextureUpload(const GLuint texture, const unsigned int width, const unsigned int height,
+        const PixelFormat pixelFormat, const SharedBuffer<unsigned char> data, const std::function<void()> onComplete, const GLint level) {
+#ifdef _DEBUG
+    assert(data.getSize() == (size_t)width * height * PixelConverter::GetBytesPerPixel(pixelFormat));
+#endif
+    unsigned int uploadID = spareID++;
+    pendingUploads.push_back({uploadID, UPLOAD_TEXTURE, texture, 0, width, height, pixelFormat, level, data, 0, onComplete});
+    return uploadID;
+}
+
+bool UploadScheduler::IsUploadPending(const unsigned int uploadID) {
+    for(unsigned int i = 0; i < pendingUploads.size(); i++) {
+        if(pendingUploads[i].uploadID == uploadID) {
+            return true;
+        }
+    }
+    return false;
+}
+
+void UploadScheduler::CancelUpload(const unsigned int uploadID) {
+    for(std::deque<PendingUpload>::iterator iter = pendingUploads.begin(); iter != pendingUploads.end(); iter++) {
+        if(iter->uploadID == uploadID) {
+            pendingUploads.erase(iter);
+            return;
+        }
+    }
+}
+
+void UploadScheduler::ProcessUploads() {
+    while(!pendingUploads.empty() && frameBytesUploaded < frameByteBudget) {
+        PendingUpload& upload = pendingUploads.front();
+        size_t budgetLeft = frameByteBudget - frameBytesUploaded;
+        size_t numBytes = 0;
+        bool copied = false;
+        if(upload.type == UPLOAD_BUFFER) {
+            numBytes = std::min(upload.data.getSizeInBytes() - upload.bytesDone, budgetLeft);
+            if(stagingEnabled) {
+                // A chunk larger than the ring would never fit it
+                numBytes = std::min(numBytes, ring.getCapacity());
+            }
+            copied = CopyBufferRange(upload.destination, upload.dstOffset + upload.bytesDone, numBytes, upload.data.data() + upload.bytesDone, false);
+        }
+        else {
+            size_t rowSize = (size_t)upload.width * PixelConverter::GetBytesPerPixel(upload.pixelFormat);
+            unsigned int firstRow = upload.bytesDone / rowSize;
+            // Rows larger than the ring can never be staged, so they go straight to the texture
+            bool stageable = stagingEnabled && rowSize <= ring.getCapacity();
+            size_t maxBytes = stageable ? std::min(budgetLeft, ring.getCapacity()) : budgetLeft;
+            unsigned int numRows = std::min((size_t)(upload.height - firstRow), maxBytes / rowSize);
+            if(numRows == 0) {
+                if(frameBytesUploaded > 0) {
+                    // The next row doesn't fit the rest of the budget, leave it for the next frame
+                    break;
+                }
+                // A row larger than the whole budget still goes through, one per frame
+                numRows = 1;
+            }
+            numBytes = numRows * rowSize;
+            copied = CopyTextureRows(upload.destination, upload.width, firstRow, numRows, upload.pixelFormat, upload.level, upload.data.data() + upload.bytesDone,
+                    !stageable);
+        }
+        if(!copied) {
+            stats.numRingFullDeferrals++;
+            return;
+        }
+        frameBytesUploaded += numBytes;
+        upload.bytesDone += numBytes;
+        if(upload.bytesDone == upload.data.getSizeInBytes()) {
+            std::function<void()> onComplete = upload.onComplete;
+            pendingUploads.pop_front();
+            stats.numUploadsCompleted++;
+            if(onComplete) {
+                onComplete();
+            }
+        }
+    }
+    if(!pendingUploads.empty()) {
+        stats.numBudgetDeferrals++;
+    }
+}
+
+void UploadScheduler::EndFrame() {
+    ring.endFrame();
+    frameBytesUploaded = 0;
+}
+
+void UploadScheduler::Destroy() {
+    pendingUploads.clear();
+    ring.destroy();
+    frameBytesUploaded = 0;
+}
+
+void UploadScheduler::SetRingCapacity(const size_t ringCapacity) {
+    ring.destroy();
+    ring = StreamingRing(ringCapacity);
+}
+
+size_t UploadScheduler::GetPendingBytes() {
+    size_t pendingBytes = 0;
+    for(unsigned int i = 0; i < pendingUploads.size(); i++) {
+        pendingBytes += pendingUploads[i].data.getSizeInBytes() - pendingUploads[i].bytesDone;
+    }
+    return pendingBytes;
+}
+
+bool UploadScheduler::CopyBufferRange(const GLuint buffer, const size_t dstOffset, const size_t numBytes, const void* data, const bool allowDirect) {
+    if(numBytes == 0) {
+        return true;
+    }
+    size_t stagingOffset = 0;
+    void* stagingPtr = stagingEnabled ? ring.tryAllocate(numBytes, STAGING_ALIGNMENT, stagingOffset) : nullptr;
+    if(stagingPtr == nullptr) {
+        if(stagingEnabled && !allowDirect) {
+            return false;
+        }
+        GLStateCache::BindBuffer(GL_COPY_WRITE_BUFFER, buffer);
+        glBufferSubData(GL_COPY_WRITE_BUFFER, dstOffset, numBytes, data);
+        GLStateCache::BindBuffer(GL_COPY_WRITE_BUFFER, 0);
+        stats.bytesUploadedDirectly += numBytes;
+        return true;
+    }
+    std::memcpy(stagingPtr, data, numBytes);
+    ring.commit(stagingOffset, numBytes);
+    GLStateCache::BindBuffer(GL_COPY_READ_BUFFER, ring.getBufferName());
+    GLStateCache::BindBuffer(GL_COPY_WRITE_BUFFER, buffer);
+    glCopyBufferSubData(GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER, stagingOffset, dstOffset, numBytes);
+    GLStateCache::BindBuffer(GL_COPY_WRITE_BUFFER, 0);
+    GLStateCache::BindBuffer(GL_COPY_READ_BUFFER, 0);
+    stats.bytesStaged += numBytes;
+    return true;
+}
+
+bool UploadScheduler::CopyTextureRows(const GLuint texture, const unsigned int width, const unsigned int firstRow, const unsigned int numRows,
+        const PixelFormat pixelFormat, const GLint level, const void* data, const bool allowDirect) {
+    size_t rowSize = (size_t)width * PixelConverter::GetBytesPerPixel(pixelFormat);
+    size_t numBytes = rowSize * numRows;
+    if(numBytes == 0) {
+        return true;
+    }
+    size_t stagingOffset = 0;
+    void* stagingPtr = stagingEnabled ? ring.tryAllocate(numBytes, STAGING_ALIGNMENT, stagingOffset) : nullptr;
+    if(stagingPtr == nullptr && stagingEnabled && !allowDirect) {
+        return false;
+    }
+    GLPixelFormat glPixelFormat = PixelConverter::GetGLPixelFormat(pixelFormat);
+    TextureUnitState::BindToActiveUnit(texture);
+    // Rows are tightly packed, which the largest alignment dividing the row size describes as well as 1 does
+    glPixelStorei(GL_UNPACK_ALIGNMENT, PixelConverter::GetUnpackAlignment(rowSize));
+    if(stagingPtr == nullptr) {
+        glTexSubImage2D(GL_TEXTURE_2D, level, 0, firstRow, width, numRows, glPixelFormat.format, glPixelFormat.type, data);
+        stats.bytesUploadedDirectly += numBytes;
+    }
+    else {
+        std::memcpy(stagingPtr, data, numBytes);
+        ring.commit(stagingOffset, numBytes);
+        GLStateCache::BindBuffer(GL_PIXEL_UNPACK_BUFFER, ring.getBufferName());
+        glTexSubImage2D(GL_TEXTURE_2D, level, 0, firstRow, width, numRows, glPixelFormat.format, glPixelFormat.type, (void*)stagingOffset);
+        GLStateCache::BindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+        stats.bytesStaged += numBytes;
+    }
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+    TextureUnitState::BindToActiveUnit(0);
+    return true;
+}
+
+}
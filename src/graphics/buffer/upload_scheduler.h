@@ -0,0 +1,162 @@
+#ifndef UPLOAD_SCHEDULER_H
+#define UPLOAD_SCHEDULER_H
+
+#include <graphics/buffer/streaming_ring.h>
+#include <graphics/buffer/shared_buffer.h>
+#include <graphics/texture/pixel_format.h>
+#include <deque>
+#include <functional>
+
+#include <glad/glad.h>
+
+namespace Engine {
+
+/*
+ * Counts of the bytes uploaded by UploadScheduler and of the uploads it had to put off.
+ */
+struct UploadStats {
+    // Bytes copied through the streaming ring
+    unsigned long long bytesStaged = 0;
+    // Bytes uploaded straight from system memory, with staging disabled, the ring full or texture rows larger than it
+    unsigned long long bytesUploadedDirectly = 0;
+    unsigned long long numUploadsCompleted = 0;
+    // Frames that ended with queued uploads left because the frame's byte budget was spent
+    unsigned long long numBudgetDeferrals = 0;
+    // Times queued uploads were put off to the next frame because the ring had no free space
+    unsigned long long numRingFullDeferrals = 0;
+};
+
+/*
+ * UploadScheduler copies buffer and texture data to OpenGL through a persistently mapped StreamingRing, so the CPU
+ * writes into memory the GPU copies from asynchronously instead of handing the driver a system memory array.
+ *
+ * Immediate uploads (UploadToBuffer, UploadToTexture) are issued straight away, for data needed by this frame's draws.
+ * Queued uploads are spread over frames by ProcessUploads, which stops once the frame's byte budget is spent or the
+ * ring is full rather than waiting for the GPU. Large buffer uploads are split into chunks and texture uploads into
+ * rows, no larger than the ring.
+ *
+ * Staging is disabled by default, in which case uploads go straight to glBufferSubData and glTexSubImage2D but queued
+ * uploads are still spread by the byte budget. Call ProcessUploads once per frame before drawing and EndFrame after
+ * the frame's commands have been submitted.
+ */
+class UploadScheduler {
+    public:
+        /*
+         * Copies numBytes bytes of data to buffer at byte offset dstOffset.
+         */
+        static void UploadToBuffer(const GLuint buffer, const size_t dstOffset, const size_t numBytes, const void* data);
+        
+        /*
+         * Copies a width by height image in pixelFormat with tightly packed rows to mipmap level level of texture,
+         * which must already have storage of that size.
+         */
+        static void UploadToTexture(const GLuint texture, const unsigned int width, const unsigned int height,
+                const PixelFormat pixelFormat, const void* data, const GLint level = 0);
+        
+        /*
+         * Queues a copy of data to buffer at byte offset dstOffset. onComplete is called once all of it has been
+         * copied. Returns an upload ID.
+         */
+        static unsigned int QueueBufferUpload(const GLuint buffer, const size_t dstOffset, const SharedBuffer<unsigned char> data,
+                const std::function<void()> onComplete = nullptr);
+        
+        /*
+         * Queues a copy of an image to mipmap level level of texture, as in UploadToTexture. Returns an upload ID.
+         */
+        static unsigned int QueueTextureUpload(const GLuint texture, const unsigned int width, const unsigned int height,
+                const PixelFormat pixelFormat, const SharedBuffer<unsigned char> data, const std::function<void()> onComplete = nullptr,
+                const GLint level = 0);
+        
+        /*
+         * Returns true if the upload with ID uploadID is queued and not yet complete.
+         */
+        static bool IsUploadPending(const unsigned int uploadID);
+        
+        /*
+         * Removes a queued upload, e.g. because its destination is being deleted. Parts of it may already have been
+         * copied.
+         */
+        static void CancelUpload(const unsigned int uploadID);
+        
+        /*
+         * Issues queued uploads in order until the frame's byte budget is spent or the ring is full.
+         */
+        static void ProcessUploads();
+        
+        /*
+         * Fences this frame's staging and resets the frame's byte budget. Call once per frame.
+         */
+        static void EndFrame();
+        
+        /*
+         * Drops all queued uploads and deletes the streaming ring.
+         */
+        static void Destroy();
+        
+        static void SetStagingEnabled(const bool stagingEnabled) { UploadScheduler::stagingEnabled = stagingEnabled; }
+        static bool IsStagingEnabled() { return stagingEnabled; }
+        
+        /*
+         * Sets the capacity of the streaming ring. Deletes the current ring, so call between frames.
+         */
+        static void SetRingCapacity(const size_t ringCapacity);
+        
+        /*
+         * Sets the bytes of queued uploads issued per frame.
+         */
+        static void SetFrameByteBudget(const size_t frameByteBudget) { UploadScheduler::frameByteBudget = frameByteBudget; }
+        static size_t GetFrameByteBudget() { return frameByteBudget; }
+        static size_t GetFrameBytesUploaded() { return frameBytesUploaded; }
+        
+        static unsigned int GetNumPendingUploads() { return pendingUploads.size(); }
+        static size_t GetPendingBytes();
+        static const StreamingRing& GetRing() { return ring; }
+        static const UploadStats& GetStats() { return stats; }
+        static void ResetStats() { stats = UploadStats(); ring.resetStats(); }
+        
+        // Offsets in the ring are aligned for any vertex, index or pixel type
+        static const size_t STAGING_ALIGNMENT = 16;
+    private:
+        enum UploadType {
+            UPLOAD_BUFFER,
+            UPLOAD_TEXTURE
+        };
+        struct PendingUpload {
+            unsigned int uploadID;
+            UploadType type;
+            GLuint destination;
+            size_t dstOffset;
+            unsigned int width;
+            unsigned int height;
+            PixelFormat pixelFormat;
+            GLint level;
+            SharedBuffer<unsigned char> data;
+            // Bytes already copied, always whole rows for textures
+            size_t bytesDone;
+            std::function<void()> onComplete;
+        };
+        
+        /*
+         * Copies part of a buffer upload, through the ring if possible. Returns false without copying if the ring is full
+         * and allowDirect is false.
+         */
+        static bool CopyBufferRange(const GLuint buffer, const size_t dstOffset, const size_t numBytes, const void* data, const bool allowDirect);
+        
+        /*
+         * Copies rows [firstRow, firstRow + numRows) of a texture upload, as CopyBufferRange.
+         */
+        static bool CopyTextureRows(const GLuint texture, const unsigned int width, const unsigned int firstRow, const unsigned int numRows,
+                const PixelFormat pixelFormat, const GLint level, const void* data, const bool allowDirect);
+        
+        static StreamingRing ring;
+        static bool stagingEnabled;
+        static size_t frameByteBudget;
+        static size_t frameBytesUploaded;
+        static unsigned int spareID;
+        static std::deque<PendingUpload> pendingUploads;
+        static UploadStats stats;
+};
+
+}
+
+#endif //UPLOAD_SCHEDULER_H
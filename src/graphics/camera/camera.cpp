@@ -0,0 +1,180 @@
+#include "camera.h"
+#include <cmath>
+
+namespace Engine {
+
+/*
+ * Struct Frustum
+ */
+bool Frustum::intersectsSphere(const Math::Vec3f& center, const float radius) const {
+    for(unsigned int i = 0; i < NUM_PLANES; i++) {
+        const Math::Vec4f& plane = planes[i];
+        if(plane[0] * center[0] + plane[1] * center[1] + plane[2] * center[2] + plane[3] < -radius) {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool Frustum::intersectsBox(const Math::Vec3f& minCorner, const Math::Vec3f& maxCorner) const {
+    for(unsigned int i = 0; i < NUM_PLANES; i++) {
+        const Math::Vec4f& plane = planes[i];
+        // The corner furthest along the plane's normal is the last one to leave it
+        float distance = plane[3];
+        for(unsigned int c = 0; c < 3; c++) {
+            distance += plane[c] * ((plane[c] >= 0.0f) ? maxCorner[c] : minCorner[c]);
+        }
+        if(distance < 0.0f) {
+            return false;
+        }
+    }
+    return true;
+}
+
+Frustum Frustum::FromViewProjection(const Math::Mat4f& viewProjectionMatrix) {
+    // A clip space point is inside when -w <= x, y, z <= w, so each plane is the last row plus or minus another
+    Math::Vec4f lastRow = viewProjectionMatrix[3];
+    Frustum frustum;
+    for(unsigned int row = 0; row < 3; row++) {
+        frustum.planes[2 * row] = lastRow + viewProjectionMatrix[row];
+        frustum.planes[2 * row + 1] = lastRow - viewProjectionMatrix[row];
+    }
+    for(unsigned int i = 0; i < NUM_PLANES; i++) {
+        Math::Vec4f& plane = frustum.planes[i];
+        float normalLength = std::sqrt(plane[0] * plane[0] + plane[1] * plane[1] + plane[2] * plane[2]);
+        if(normalLength > 0.0f) {
+            plane = plane * (1.0f / normalLength);
+        }
+    }
+    return frustum;
+}
+
+/*
+ * Class Camera
+ */
+Camera::Camera() : Camera(Math::toRadians(45.0f), 1.0f, 1.0f, 100.0f) {}
+
+Camera::Camera(const float verticalFieldOfView, const float aspectRatio, const float nearZ, const float farZ)
+    : verticalFieldOfView(verticalFieldOfView), aspectRatio(aspectRatio), nearZ(nearZ), farZ(farZ), position(Math::createVec3<float>(0.0f, 0.0f, 0.0f)),
+      orientation(Math::createVec4<float>(0.0f, 0.0f, 0.0f, 1.0f)) {
+#ifdef _DEBUG
+    assert(aspectRatio > 0.0f);
+    assert(nearZ > 0.0f && farZ > nearZ);
+#endif
+}
+
+void Camera::setPerspective(const float verticalFieldOfView, const float aspectRatio, const float nearZ, const float farZ) {
+#ifdef _DEBUG
+    assert(aspectRatio > 0.0f);
+    assert(nearZ > 0.0f && farZ > nearZ);
+#endif
+    this->verticalFieldOfView = verticalFieldOfView;
+    this->aspectRatio = aspectRatio;
+    this->nearZ = nearZ;
+    this->farZ = farZ;
+    projectionDirty = true;
+}
+
+void Camera::setAspectRatio(const float aspectRatio) {
+#ifdef _DEBUG
+    assert(aspectRatio > 0.0f);
+#endif
+    if(aspectRatio == this->aspectRatio) {
+        return;
+    }
+    this->aspectRatio = aspectRatio;
+    projectionDirty = true;
+}
+
+void Camera::setFramebufferSize(const int width, const int height) {
+    if(width <= 0 || height <= 0) {
+        return;
+    }
+    setAspectRatio((float)width / (float)height);
+}
+
+void Camera::setPosition(const Math::Vec3f& position) {
+    if(position == this->position) {
+        return;
+    }
+    this->position = position;
+    viewDirty = true;
+}
+
+void Camera::setOrientation(const Math::Quatf& orientation) {
+    if(orientation == this->orientation) {
+        return;
+    }
+    this->orientation = orientation;
+    viewDirty = true;
+}
+
+const Frustum& Camera::getFrustum() const {
+    updateViewProjection();
+    if(frustumDirty) {
+        frustum = Frustum::FromViewProjection(viewProjectionMatrix);
+        frustumDirty = false;
+        stats.frustumUpdates++;
+    }
+    return frustum;
+}
+
+void Camera::updateView() const {
+    if(!viewDirty) {
+        return;
+    }
+    // The camera's transform is a rotation then a translation, so the view matrix undoing it is the transposed rotation
+    // then the rotated translation negated
+    Math::Mat4f rotationMatrix = orientation.toRotationMatrix();
+    inverseViewMatrix = rotationMatrix;
+    inverseViewMatrix.setCol(3, Math::createVec4<float>(position[0], position[1], position[2], 1.0f));
+    viewMatrix = Math::Mat4f(1.0f);
+    for(unsigned int r = 0; r < 3; r++) {
+        for(unsigned int c = 0; c < 3; c++) {
+            viewMatrix[r][c] = rotationMatrix[c][r];
+        }
+        viewMatrix[r][3] = -(rotationMatrix[0][r] * position[0] + rotationMatrix[1][r] * position[1] + rotationMatrix[2][r] * position[2]);
+    }
+    viewDirty = false;
+    viewProjectionDirty = true;
+    stats.viewUpdates++;
+}
+
+void Camera::updateProjection() const {
+    if(!projectionDirty) {
+        return;
+    }
+    projectionMatrix = Math::createPerspectiveProjectionMat(verticalFieldOfView, aspectRatio, nearZ, farZ);
+    // Only the scale, the off-center shift and the depth mapping of a perspective projection are free, so its inverse
+    // is written out from them
+    float xScale = projectionMatrix[0][0];
+    float xShift = projectionMatrix[0][2];
+    float yScale = projectionMatrix[1][1];
+    float yShift = projectionMatrix[1][2];
+    float zScale = projectionMatrix[2][2];
+    float zOffset = projectionMatrix[2][3];
+    inverseProjectionMatrix = Math::createMat4<float>(
+            1.0f / xScale, 0.0f, 0.0f, xShift / xScale,
+            0.0f, 1.0f / yScale, 0.0f, yShift / yScale,
+            0.0f, 0.0f, 0.0f, -1.0f,
+            0.0f, 0.0f, 1.0f / zOffset, zScale / zOffset
+    );
+    projectionDirty = false;
+    viewProjectionDirty = true;
+    stats.projectionUpdates++;
+}
+
+void Camera::updateViewProjection() const {
+    updateView();
+    updateProjection();
+    if(!viewProjectionDirty) {
+        return;
+    }
+    viewProjectionMatrix = projectionMatrix * viewMatrix;
+    inverseViewProjectionMatrix = inverseViewMatrix * inverseProjectionMatrix;
+    viewProjectionDirty = false;
+    frustumDirty = true;
+    stats.viewProjectionUpdates++;
+}
+
+}
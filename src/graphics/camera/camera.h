@@ -0,0 +1,120 @@
+#ifndef CAMERA_H
+#define CAMERA_H
+
+#include <math/linear_math.h>
+#include <cassert>
+
+namespace Engine {
+
+/*
+ * The planes bounding what a camera sees, each stored as (normal, distance) with the normal pointing inwards, so a
+ * point p is inside a plane when dot(normal, p) + distance >= 0.
+ */
+struct Frustum {
+    enum Plane {
+        PLANE_LEFT = 0,
+        PLANE_RIGHT,
+        PLANE_BOTTOM,
+        PLANE_TOP,
+        PLANE_NEAR,
+        PLANE_FAR,
+        NUM_PLANES
+    };
+    Math::Vec4f planes[NUM_PLANES];
+    
+    /*
+     * Returns false only if the sphere is entirely outside one of the planes. Spheres near the corners outside the
+     * frustum can still return true.
+     */
+    bool intersectsSphere(const Math::Vec3f& center, const float radius) const;
+    
+    /*
+     * Returns false only if the axis aligned box from minCorner to maxCorner is entirely outside one of the planes.
+     */
+    bool intersectsBox(const Math::Vec3f& minCorner, const Math::Vec3f& maxCorner) const;
+    
+    /*
+     * Returns the planes of the frustum viewProjectionMatrix projects into clip space, normalized.
+     */
+    static Frustum FromViewProjection(const Math::Mat4f& viewProjectionMatrix);
+};
+
+struct CameraStats {
+    unsigned long long viewUpdates = 0;
+    unsigned long long projectionUpdates = 0;
+    unsigned long long viewProjectionUpdates = 0;
+    unsigned long long frustumUpdates = 0;
+};
+
+/*
+ * Camera holds where the scene is viewed from and how it's projected. Its view, projection and view-projection
+ * matrices, their inverses and its frustum are worked out the first time they're asked for after whatever they depend
+ * on changes, and kept until it changes again, so a still camera costs nothing per frame however many draws read it.
+ *
+ * The camera looks down its negative z axis with y up, turned by its orientation and moved to its position.
+ */
+class Camera {
+    public:
+        /*
+         * Creates a camera at the origin with a 45 degree vertical field of view.
+         */
+        Camera();
+        Camera(const float verticalFieldOfView, const float aspectRatio, const float nearZ, const float farZ);
+        
+        void setPerspective(const float verticalFieldOfView, const float aspectRatio, const float nearZ, const float farZ);
+        void setAspectRatio(const float aspectRatio);
+        
+        /*
+         * Sets the aspect ratio to match a framebuffer width by height. Ignores an empty framebuffer, as a minimized
+         * window has.
+         */
+        void setFramebufferSize(const int width, const int height);
+        void setPosition(const Math::Vec3f& position);
+        void setOrientation(const Math::Quatf& orientation);
+        
+        float getVerticalFieldOfView() const { return verticalFieldOfView; }
+        float getAspectRatio() const { return aspectRatio; }
+        float getNearZ() const { return nearZ; }
+        float getFarZ() const { return farZ; }
+        Math::Vec3f getPosition() const { return position; }
+        Math::Quatf getOrientation() const { return orientation; }
+        
+        const Math::Mat4f& getViewMatrix() const { updateView(); return viewMatrix; }
+        const Math::Mat4f& getInverseViewMatrix() const { updateView(); return inverseViewMatrix; }
+        const Math::Mat4f& getProjectionMatrix() const { updateProjection(); return projectionMatrix; }
+        const Math::Mat4f& getInverseProjectionMatrix() const { updateProjection(); return inverseProjectionMatrix; }
+        const Math::Mat4f& getViewProjectionMatrix() const { updateViewProjection(); return viewProjectionMatrix; }
+        const Math::Mat4f& getInverseViewProjectionMatrix() const { updateViewProjection(); return inverseViewProjectionMatrix; }
+        const Frustum& getFrustum() const;
+        
+        const CameraStats& getStats() const { return stats; }
+        void resetStats() { stats = CameraStats(); }
+    private:
+        void updateView() const;
+        void updateProjection() const;
+        void updateViewProjection() const;
+        
+        float verticalFieldOfView;
+        float aspectRatio;
+        float nearZ;
+        float farZ;
+        Math::Vec3f position;
+        Math::Quatf orientation;
+        
+        mutable bool viewDirty = true;
+        mutable bool projectionDirty = true;
+        mutable bool viewProjectionDirty = true;
+        mutable bool frustumDirty = true;
+        mutable Math::Mat4f viewMatrix;
+        mutable Math::Mat4f inverseViewMatrix;
+        mutable Math::Mat4f projectionMatrix;
+        mutable Math::Mat4f inverseProjectionMatrix;
+        mutable Math::Mat4f viewProjectionMatrix;
+        mutable Math::Mat4f inverseViewProjectionMatrix;
+        mutable Frustum frustum;
+        mutable CameraStats stats;
+};
+
+}
+
+#endif //CAMERA_H
@@ -0,0 +1,67 @@
+#include "frame_constants.h"
+#include <graphics/state/gl_state_cache.h>
+#include <exceptions/render_exception.h>
+#include <cstring>
+#include <algorithm>
+
+namespace Engine {
+
+/*
+ * Class FrameConstants
+ */
+StreamingRing FrameConstants::ring = StreamingRing(RING_CAPACITY);
+GLint FrameConstants::uniformOffsetAlignment = 0;
+FrameConstantData FrameConstants::data;
+FrameConstantStats FrameConstants::stats;
+
+void FrameConstants::Update(const Camera& camera) {
+    CopyMatrix(camera.getViewMatrix(), data.viewMatrix);
+    CopyMatrix(camera.getProjectionMatrix(), data.projectionMatrix);
+    CopyMatrix(camera.getViewProjectionMatrix(), data.viewProjectionMatrix);
+    CopyMatrix(camera.getInverseViewProjectionMatrix(), data.inverseViewProjectionMatrix);
+    const Frustum& frustum = camera.getFrustum();
+    for(unsigned int i = 0; i < Frustum::NUM_PLANES; i++) {
+        for(unsigned int c = 0; c < 4; c++) {
+            data.frustumPlanes[i][c] = frustum.planes[i][c];
+        }
+    }
+    Math::Vec3f position = camera.getPosition();
+    for(unsigned int c = 0; c < 3; c++) {
+        data.cameraPosition[c] = position[c];
+    }
+    data.cameraPosition[3] = 1.0f;
+    
+    if(uniformOffsetAlignment == 0) {
+        glGetIntegerv(GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT, &uniformOffsetAlignment);
+        uniformOffsetAlignment = std::max(uniformOffsetAlignment, (GLint)1);
+    }
+    size_t offset = 0;
+    void* dataPtr = ring.allocate(sizeof(FrameConstantData), uniformOffsetAlignment, offset);
+    if(dataPtr == nullptr) {
+        throw RenderException("ERROR: The frame constants don't fit in their uniform ring.");
+    }
+    std::memcpy(dataPtr, &data, sizeof(FrameConstantData));
+    ring.commit(offset, sizeof(FrameConstantData));
+    GLStateCache::BindBufferRange(GL_UNIFORM_BUFFER, FRAME_CONSTANTS_BINDING, ring.getBufferName(), offset, sizeof(FrameConstantData));
+    stats.numUpdates++;
+}
+
+void FrameConstants::EndFrame() {
+    ring.endFrame();
+}
+
+void FrameConstants::Destroy() {
+    ring.destroy();
+    uniformOffsetAlignment = 0;
+}
+
+void FrameConstants::CopyMatrix(const Math::Mat4f& matrix, float* dst) {
+    // The block declares its matrices row major, as Mat4f stores them
+    for(unsigned int r = 0; r < 4; r++) {
+        for(unsigned int c = 0; c < 4; c++) {
+            dst[4 * r + c] = matrix[r][c];
+        }
+    }
+}
+
+}
@@ -0,0 +1,73 @@
+#ifndef FRAME_CONSTANTS_H
+#define FRAME_CONSTANTS_H
+
+#include <graphics/camera/camera.h>
+#include <graphics/buffer/streaming_ring.h>
+#include <cstddef>
+
+#include <glad/glad.h>
+
+namespace Engine {
+
+/*
+ * The values every draw in a frame reads, laid out as the FrameConstants uniform block in frame_constants.glsl
+ * (std140 with row major matrices).
+ */
+struct FrameConstantData {
+    float viewMatrix[16];
+    float projectionMatrix[16];
+    float viewProjectionMatrix[16];
+    float inverseViewProjectionMatrix[16];
+    float frustumPlanes[Frustum::NUM_PLANES][4];
+    // w is 1
+    float cameraPosition[4];
+};
+
+struct FrameConstantStats {
+    unsigned long long numUpdates = 0;
+};
+
+/*
+ * FrameConstants copies a camera's matrices and frustum into a uniform buffer once per frame and binds them to the
+ * FrameConstants block of every program, so draws share them rather than each setting its own uniforms. The copies
+ * come from a small ring so a frame's constants aren't overwritten while the GPU may still read them.
+ */
+class FrameConstants {
+    public:
+        /*
+         * Copies camera's values into the frame's constants and binds them. Call once per frame before drawing.
+         */
+        static void Update(const Camera& camera);
+        
+        /*
+         * Fences the frame's constants, so their space in the ring is reused once the GPU is done with them. Call once
+         * per frame after the commands reading them.
+         */
+        static void EndFrame();
+        
+        /*
+         * Deletes the ring, e.g. before the OpenGL context goes away.
+         */
+        static void Destroy();
+        
+        static const FrameConstantData& GetData() { return data; }
+        static const StreamingRing& GetRing() { return ring; }
+        static const FrameConstantStats& GetStats() { return stats; }
+        static void ResetStats() { stats = FrameConstantStats(); }
+        
+        // Binding point the FrameConstants uniform block of every program is assigned
+        static constexpr GLuint FRAME_CONSTANTS_BINDING = 1;
+        static constexpr size_t RING_CAPACITY = 64 * 1024;
+    private:
+        static void CopyMatrix(const Math::Mat4f& matrix, float* dst);
+        
+        static StreamingRing ring;
+        // 0 until queried from the driver
+        static GLint uniformOffsetAlignment;
+        static FrameConstantData data;
+        static FrameConstantStats stats;
+};
+
+}
+
+#endif //FRAME_CONSTANTS_H
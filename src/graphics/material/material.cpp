@@ -17,6 +17,13 @@ void Material::apply() const {
     // Do nothing
 }
 
+ShaderProgramPtr Material::getActiveShaderProgramPtr() const {
+    if(fallbackShaderProgramPtr != nullptr && shaderProgramPtr->isCompiling()) {
+        return fallbackShaderProgramPtr;
+    }
+    return shaderProgramPtr;
+}
+
 /*
  * Class TexturedMaterial
  */
@@ -34,13 +41,44 @@ void TexturedMaterial::apply() const {
     assert(textures.size() > 0);
     assert(textureMixingWeights.size() == textures.size());
 #endif
-    getShaderProgramPtr()->use();
-    getShaderProgramPtr()->setUniformInt("texture0", 0);
-    getShaderProgramPtr()->setUniformInt("texture1", 1);
+    getParameterBlock(getActiveShaderProgramPtr())->apply();
+}
+
+std::shared_ptr<const MaterialParameterBlock> TexturedMaterial::getParameterBlock(const ShaderProgramPtr shaderProgramPtr) const {
+    std::shared_ptr<const MaterialParameterBlock>& blockPtr = (shaderProgramPtr == getShaderProgramPtr()) ? parameterBlockPtr : fallbackParameterBlockPtr;
+    // The programs may have been set since the block was created
+    if(blockPtr != nullptr && blockPtr->getShaderProgramPtr() == shaderProgramPtr) {
+        return blockPtr;
+    }
+    std::vector<GLuint> samplers(textures.size(), 0);
+    for(unsigned int i = 0; i < textures.size(); i++) {
+        if(maxAnisotropy == 0.0f && lodBias == 0.0f) {
+            continue;
+        }
+        SamplerDescription samplerDescription = TextureLoader::GetSamplerDescription(textures[i].getTextureID());
+        if(maxAnisotropy != 0.0f) {
+            samplerDescription.maxAnisotropy = maxAnisotropy;
+        }
+        samplerDescription.lodBias += lodBias;
+        samplers[i] = SamplerCache::GetSampler(samplerDescription);
+    }
+    blockPtr = std::make_shared<const MaterialParameterBlock>(shaderProgramPtr, textures, samplers, textureMixingWeights);
+    return blockPtr;
+}
+
+bool TexturedMaterial::hasSameState(const TexturedMaterial& texturedMaterial) const {
+    if(getShaderProgramPtr() != texturedMaterial.getShaderProgramPtr() || getFallbackShaderProgramPtr() != texturedMaterial.getFallbackShaderProgramPtr()
+            || textures.size() != texturedMaterial.textures.size()
+            || textureMixingWeights != texturedMaterial.textureMixingWeights || maxAnisotropy != texturedMaterial.maxAnisotropy
+            || lodBias != texturedMaterial.lodBias) {
+        return false;
+    }
     for(unsigned int i = 0; i < textures.size(); i++) {
-        glActiveTexture(GL_TEXTURE0 + i);
-        textures[i].bind();
+        if(textures[i].getTextureID() != texturedMaterial.textures[i].getTextureID()) {
+            return false;
+        }
     }
+    return true;
 }
 
 /*
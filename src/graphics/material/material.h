@@ -4,7 +4,9 @@
 #include <graphics/shaders/shaders.h>
 #include <math/vector.h>
 #include <graphics/texture/texture.h>
+#include <graphics/material/material_parameter_block.h>
 #include <vector>
+#include <memory>
 #include <cassert>
 
 namespace Engine {
@@ -19,8 +21,22 @@ class Material {
         
         ShaderProgramPtr getShaderProgramPtr() const { return shaderProgramPtr; }
         void setShaderProgramPtr(const ShaderProgramPtr shaderProgramPtr) { this->shaderProgramPtr = shaderProgramPtr; }
+        
+        ShaderProgramPtr getFallbackShaderProgramPtr() const { return fallbackShaderProgramPtr; }
+        
+        /*
+         * Sets the program the material renders with while its own is still being compiled by the driver (see
+         * ShaderLoader::SubmitShaderPrograms). Without one, applying the material waits for its program.
+         */
+        void setFallbackShaderProgramPtr(const ShaderProgramPtr fallbackShaderProgramPtr) { this->fallbackShaderProgramPtr = fallbackShaderProgramPtr; }
+        
+        /*
+         * Returns the program applying the material uses now, the fallback program while its own is compiling.
+         */
+        ShaderProgramPtr getActiveShaderProgramPtr() const;
     private:
         ShaderProgramPtr shaderProgramPtr;
+        ShaderProgramPtr fallbackShaderProgramPtr;
 };
 
 class TexturedMaterial : public Material {
@@ -29,15 +45,61 @@ class TexturedMaterial : public Material {
         TexturedMaterial(const std::string& shaderProgramName, const std::vector<Texture> textures, const std::vector<float> textureMixingWeights);
         TexturedMaterial(const ShaderProgramPtr shaderProgramPtr, const std::vector<Texture> textures, const std::vector<float> textureMixingWeights);
         
+        /*
+         * Applies the material's parameter block for the program it currently renders with, creating the block the
+         * first time. The texture mixing weights are the constants of the block.
+         */
         void apply() const;
         
+        /*
+         * Returns the parameter block applying the material with its own program uses, creating it if needed.
+         */
+        std::shared_ptr<const MaterialParameterBlock> getParameterBlock() const { return getParameterBlock(getShaderProgramPtr()); }
+        
+        /*
+         * Returns true if applying either material sets the same shader program, textures, mixing weights and sampling,
+         * so that meshes using them can be drawn together.
+         */
+        bool hasSameState(const TexturedMaterial& texturedMaterial) const;
+        
         std::vector<Texture> getTextures() const { return textures; }
-        void setTextures(const std::vector<Texture> textures) { this->textures = textures; }
+        void setTextures(const std::vector<Texture> textures) { this->textures = textures; clearParameterBlocks(); }
         std::vector<float> getTextureMixingWeights() const { return textureMixingWeights; }
-        void setTextureMixingWeights(const std::vector<float> textureMixingWeights) { this->textureMixingWeights = textureMixingWeights; }
+        void setTextureMixingWeights(const std::vector<float> textureMixingWeights) {
+            this->textureMixingWeights = textureMixingWeights;
+            clearParameterBlocks();
+        }
+        
+        float getMaxAnisotropy() const { return maxAnisotropy; }
+        
+        /*
+         * Sets the anisotropy the material's textures are sampled with, in place of their own. 0 keeps each texture's
+         * own.
+         */
+        void setMaxAnisotropy(const float maxAnisotropy) { this->maxAnisotropy = maxAnisotropy; clearParameterBlocks(); }
+        
+        float getLodBias() const { return lodBias; }
+        
+        /*
+         * Sets a bias added to the level of detail bias of each of the material's textures.
+         */
+        void setLodBias(const float lodBias) { this->lodBias = lodBias; clearParameterBlocks(); }
     private:
+        /*
+         * Returns the parameter block for applying the material with shaderProgramPtr, its own program or its fallback,
+         * creating it if there's none for that program yet.
+         */
+        std::shared_ptr<const MaterialParameterBlock> getParameterBlock(const ShaderProgramPtr shaderProgramPtr) const;
+        
+        void clearParameterBlocks() { parameterBlockPtr = nullptr; fallbackParameterBlockPtr = nullptr; }
+        
         std::vector<Texture> textures;
         std::vector<float> textureMixingWeights;
+        float maxAnisotropy = 0.0f;
+        float lodBias = 0.0f;
+        // Created as the material is first applied with each program, since they make OpenGL calls
+        mutable std::shared_ptr<const MaterialParameterBlock> parameterBlockPtr;
+        mutable std::shared_ptr<const MaterialParameterBlock> fallbackParameterBlockPtr;
 };
 
 enum ColorType {
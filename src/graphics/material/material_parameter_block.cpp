@@ -0,0 +1,99 @@
+#include "material_parameter_block.h"
+#include <graphics/state/gl_state_cache.h>
+#include <graphics/camera/frame_constants.h>
+#include <exceptions/render_exception.h>
+#include <cstring>
+#include <algorithm>
+
+namespace Engine {
+
+/*
+ * Class MaterialParameterBlock
+ */
+StreamingRing MaterialParameterBlock::uniformRing = StreamingRing(UNIFORM_RING_CAPACITY);
+GLint MaterialParameterBlock::uniformOffsetAlignment = 0;
+// Starts past the frame blocks are created with, so nothing is taken as already copied
+unsigned long long MaterialParameterBlock::frame = 1;
+MaterialParameterStats MaterialParameterBlock::stats;
+
+MaterialParameterBlock::MaterialParameterBlock(const ShaderProgramPtr shaderProgramPtr, const std::vector<Texture>& textures,
+        const std::vector<GLuint>& samplers, const std::vector<float>& constants)
+    : shaderProgramPtr(shaderProgramPtr), textures(textures), samplers(samplers), samplerLocations(), constantBlockIndex(GL_INVALID_INDEX),
+      constantData(), ringOffset(0), ringFrame(0) {
+#ifdef _DEBUG
+    assert(shaderProgramPtr != nullptr);
+    assert(samplers.size() == textures.size());
+#endif
+    shaderProgramPtr->finishCompiling();
+    GLuint program = shaderProgramPtr->getProgram();
+    
+    // Sampler units are program state, so they're assigned once here rather than on every apply
+    for(unsigned int i = 0; i < textures.size(); i++) {
+        GLint location = glGetUniformLocation(program, ("texture" + std::to_string(i)).c_str());
+        if(location != -1) {
+            glProgramUniform1i(program, location, i);
+        }
+        samplerLocations.push_back(location);
+    }
+    
+    // Programs reading the camera take it from the frame's constants
+    GLuint frameBlockIndex = glGetUniformBlockIndex(program, "FrameConstants");
+    if(frameBlockIndex != GL_INVALID_INDEX) {
+        glUniformBlockBinding(program, frameBlockIndex, FrameConstants::FRAME_CONSTANTS_BINDING);
+    }
+    
+    if(!constants.empty()) {
+        constantBlockIndex = glGetUniformBlockIndex(program, "MaterialParameters");
+        if(constantBlockIndex != GL_INVALID_INDEX) {
+            glUniformBlockBinding(program, constantBlockIndex, MATERIAL_PARAMETERS_BINDING);
+        }
+        // std140 rounds the size of a block up to a multiple of a vec4
+        constantData.assign(((constants.size() + 3) / 4) * 4 * sizeof(float), 0);
+        std::memcpy(constantData.data(), constants.data(), constants.size() * sizeof(float));
+    }
+}
+
+void MaterialParameterBlock::apply() const {
+    shaderProgramPtr->use();
+    if(constantBlockIndex != GL_INVALID_INDEX) {
+        // Each block's constants are copied once per frame, however many times it's applied
+        if(ringFrame != frame) {
+            if(uniformOffsetAlignment == 0) {
+                glGetIntegerv(GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT, &uniformOffsetAlignment);
+                uniformOffsetAlignment = std::max(uniformOffsetAlignment, (GLint)1);
+            }
+            void* dataPtr = uniformRing.allocate(constantData.size(), uniformOffsetAlignment, ringOffset);
+            if(dataPtr == nullptr) {
+                throw RenderException("ERROR: The constants of the frame's materials don't fit in the material uniform ring.");
+            }
+            std::memcpy(dataPtr, constantData.data(), constantData.size());
+            uniformRing.commit(ringOffset, constantData.size());
+            ringFrame = frame;
+            stats.constantBytesCopied += constantData.size();
+        }
+        GLStateCache::BindBufferRange(GL_UNIFORM_BUFFER, MATERIAL_PARAMETERS_BINDING, uniformRing.getBufferName(), ringOffset, constantData.size());
+    }
+    for(unsigned int i = 0; i < textures.size(); i++) {
+        if(samplers[i] == 0) {
+            textures[i].bind(i);
+        }
+        else {
+            TextureLoader::BindTexture(textures[i].getTextureID(), i, samplers[i]);
+        }
+    }
+    stats.numApplies++;
+}
+
+void MaterialParameterBlock::EndFrame() {
+    uniformRing.endFrame();
+    frame++;
+}
+
+void MaterialParameterBlock::Destroy() {
+    uniformRing.destroy();
+    uniformOffsetAlignment = 0;
+    // Constants copied before are gone with the ring
+    frame++;
+}
+
+}
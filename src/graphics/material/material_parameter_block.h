@@ -0,0 +1,94 @@
+#ifndef MATERIAL_PARAMETER_BLOCK_H
+#define MATERIAL_PARAMETER_BLOCK_H
+
+#include <graphics/shaders/shaders.h>
+#include <graphics/texture/texture.h>
+#include <graphics/buffer/streaming_ring.h>
+#include <vector>
+#include <cassert>
+
+#include <glad/glad.h>
+
+namespace Engine {
+
+struct MaterialParameterStats {
+    unsigned long long numApplies = 0;
+    // Bytes of constants copied into the uniform ring
+    unsigned long long constantBytesCopied = 0;
+};
+
+/*
+ * MaterialParameterBlock is a material worked out ahead of time for one shader program, so that applying it looks
+ * nothing up by name. It holds the location of each sampler uniform texture0, texture1, ... with the texture unit it
+ * was assigned on the program, the textures and sampler objects to bind to those units, and the material's constants
+ * packed in std140 layout for the program's MaterialParameters uniform block. Creating it also binds the program's
+ * FrameConstants block, if it has one. Applying it uses the program, copies the constants into a uniform ring shared
+ * by every block and binds them, and binds the textures.
+ *
+ * Blocks are immutable, so copies of a material share its blocks.
+ */
+class MaterialParameterBlock {
+    public:
+        /*
+         * Creates the block for applying textures and constants with shaderProgramPtr, waiting for the program if the
+         * driver is still compiling it. samplers holds the sampler object to bind with each texture, or 0 for the
+         * texture's own.
+         */
+        MaterialParameterBlock(const ShaderProgramPtr shaderProgramPtr, const std::vector<Texture>& textures, const std::vector<GLuint>& samplers,
+                const std::vector<float>& constants);
+        
+        void apply() const;
+        
+        ShaderProgramPtr getShaderProgramPtr() const { return shaderProgramPtr; }
+        
+        /*
+         * Returns the location of the sampler uniform assigned each texture's unit, -1 where the program has none.
+         */
+        const std::vector<GLint>& getSamplerLocations() const { return samplerLocations; }
+        
+        /*
+         * Returns the constants as copied into the uniform ring, padded to a multiple of a vec4 as std140 lays out
+         * blocks.
+         */
+        const std::vector<unsigned char>& getConstantData() const { return constantData; }
+        bool hasConstantBlock() const { return constantBlockIndex != GL_INVALID_INDEX; }
+        
+        /*
+         * Fences the frame's constants, so their space in the uniform ring is reused once the GPU is done with them.
+         * Call once per frame after the commands reading them.
+         */
+        static void EndFrame();
+        
+        /*
+         * Deletes the uniform ring, e.g. before the OpenGL context goes away.
+         */
+        static void Destroy();
+        
+        static const StreamingRing& GetUniformRing() { return uniformRing; }
+        static const MaterialParameterStats& GetStats() { return stats; }
+        static void ResetStats() { stats = MaterialParameterStats(); }
+        
+        // Binding point the MaterialParameters uniform block of every program is assigned
+        static constexpr GLuint MATERIAL_PARAMETERS_BINDING = 0;
+        static constexpr size_t UNIFORM_RING_CAPACITY = 1024 * 1024;
+    private:
+        ShaderProgramPtr shaderProgramPtr;
+        std::vector<Texture> textures;
+        std::vector<GLuint> samplers;
+        std::vector<GLint> samplerLocations;
+        GLuint constantBlockIndex;
+        std::vector<unsigned char> constantData;
+        // Where the constants were copied to in the uniform ring, valid during frame ringFrame
+        mutable size_t ringOffset;
+        mutable unsigned long long ringFrame;
+        
+        static StreamingRing uniformRing;
+        // 0 until queried from the driver
+        static GLint uniformOffsetAlignment;
+        static unsigned long long frame;
+        static MaterialParameterStats stats;
+};
+
+}
+
+#endif //MATERIAL_PARAMETER_BLOCK_H
@@ -0,0 +1,132 @@
+#include "indirect_draw_stream.h"
+#include <graphics/state/gl_state_cache.h>
+#include <exceptions/render_exception.h>
+#include <jobs/job_system.h>
+#include <algorithm>
+#include <thread>
+#include <cassert>
+
+namespace Engine {
+
+/*
+ * Class IndirectDrawStream
+ */
+IndirectDrawStream::IndirectDrawStream(const unsigned int maxDraws, const unsigned int numThreads)
+    : maxDraws(maxDraws), numThreads(numThreads), draws(), batches(),
+    commandBuffer(maxDraws * sizeof(DrawElementsIndirectCommand)), drawDataBuffer(maxDraws * sizeof(IndirectDrawData)) {
+    if(this->numThreads == 0) {
+        this->numThreads = std::max(1u, std::thread::hardware_concurrency());
+    }
+    draws.reserve(maxDraws);
+}
+
+void IndirectDrawStream::clear() {
+    draws.clear();
+    batches.clear();
+}
+
+void IndirectDrawStream::addDraw(const unsigned int meshID, const unsigned int batchKey, const Math::Mat4f& transform) {
+    // Looked up here rather than in build() since the loaders aren't safe to read from the worker threads
+    addDraw(MeshLoader::GetDrawRange(meshID), batchKey, transform);
+}
+
+void IndirectDrawStream::addDraw(const MeshDrawRange& drawRange, const unsigned int batchKey, const Math::Mat4f& transform) {
+    // Empty meshes have nothing to draw
+    if(drawRange.numIndices == 0) {
+        return;
+    }
+    if(draws.size() >= maxDraws) {
+        throw MeshException("ERROR: Indirect draw stream is full, it holds at most " + std::to_string(maxDraws) + " draws.");
+    }
+    draws.push_back({batchKey, drawRange, transform});
+}
+
+void IndirectDrawStream::build() {
+    batches.clear();
+    std::stable_sort(draws.begin(), draws.end(), [](const Draw& a, const Draw& b) {
+        if(a.drawRange.vertexFormat != b.drawRange.vertexFormat) {
+            return a.drawRange.vertexFormat < b.drawRange.vertexFormat;
+        }
+        return a.batchKey < b.batchKey;
+    });
+    for(unsigned int i = 0; i < draws.size(); i++) {
+        if(batches.empty() || batches.back().vertexFormat != draws[i].drawRange.vertexFormat || batches.back().batchKey != draws[i].batchKey) {
+            batches.push_back({draws[i].drawRange.vertexFormat, draws[i].batchKey, i, 0});
+        }
+        batches.back().numDraws++;
+    }
+    
+    DrawElementsIndirectCommand* commands = (DrawElementsIndirectCommand*)commandBuffer.beginWrite();
+    IndirectDrawData* drawData = (IndirectDrawData*)drawDataBuffer.beginWrite();
+    unsigned int numDraws = draws.size();
+    // Split into about numThreads ranges of at least MIN_DRAWS_PER_THREAD, each a contiguous run of draws so the
+    // threads never share a cache line for long
+    unsigned int grainSize = (numDraws + numThreads - 1) / numThreads;
+    if(grainSize < MIN_DRAWS_PER_THREAD) {
+        grainSize = MIN_DRAWS_PER_THREAD;
+    }
+    JobSystem::ParallelFor(0, numDraws, grainSize, [this, commands, drawData](size_t firstDraw, size_t lastDraw) {
+        writeDraws(firstDraw, lastDraw, commands, drawData);
+    });
+    commandBuffer.endWrite(numDraws * sizeof(DrawElementsIndirectCommand));
+    drawDataBuffer.endWrite(numDraws * sizeof(IndirectDrawData));
+}
+
+void IndirectDrawStream::submit(const std::function<void(unsigned int)>& bindBatch) {
+    if(batches.empty()) {
+        return;
+    }
+    GLStateCache::BindBuffer(GL_DRAW_INDIRECT_BUFFER, commandBuffer.getBufferName());
+    for(unsigned int i = 0; i < batches.size(); i++) {
+        const Batch& batch = batches[i];
+        if(i == 0 || batches[i - 1].vertexFormat != batch.vertexFormat) {
+            GeometryHeap::BindVertexFormat(batch.vertexFormat);
+            // The per-draw transform columns are instanced attributes, so baseInstance picks the draw's data
+            GLStateCache::BindBuffer(GL_ARRAY_BUFFER, drawDataBuffer.getBufferName());
+            for(GLuint column = 0; column < 4; column++) {
+                GLuint location = TRANSFORM_ATTRIBUTE_LOCATION + column;
+                glVertexAttribPointer(location, 4, GL_FLOAT, GL_FALSE, sizeof(IndirectDrawData),
+                        (void*)(drawDataBuffer.getRegionOffset() + column * 4 * sizeof(float)));
+                glEnableVertexAttribArray(location);
+                glVertexAttribDivisor(location, 1);
+            }
+            GLStateCache::BindBuffer(GL_ARRAY_BUFFER, 0);
+        }
+        bindBatch(batch.batchKey);
+        glMultiDrawElementsIndirect(GL_TRIANGLES, GL_UNSIGNED_INT,
+                (void*)(commandBuffer.getRegionOffset() + batch.firstDraw * sizeof(DrawElementsIndirectCommand)), batch.numDraws, 0);
+    }
+    // The vertex arrays are shared with meshes drawn one at a time, which don't have the per-draw attributes
+    for(GLuint column = 0; column < 4; column++) {
+        glDisableVertexAttribArray(TRANSFORM_ATTRIBUTE_LOCATION + column);
+    }
+    GLStateCache::BindBuffer(GL_DRAW_INDIRECT_BUFFER, 0);
+    commandBuffer.fenceRegion();
+    drawDataBuffer.fenceRegion();
+}
+
+void IndirectDrawStream::destroy() {
+    commandBuffer.destroy();
+    drawDataBuffer.destroy();
+}
+
+void IndirectDrawStream::writeDraws(const unsigned int firstDraw, const unsigned int lastDraw,
+        DrawElementsIndirectCommand* commands, IndirectDrawData* drawData) const {
+    for(unsigned int i = firstDraw; i < lastDraw; i++) {
+        const Draw& draw = draws[i];
+        DrawElementsIndirectCommand& command = commands[i];
+        command.count = draw.drawRange.numIndices;
+        command.instanceCount = 1;
+        command.firstIndex = draw.drawRange.firstIndex;
+        command.baseVertex = draw.drawRange.baseVertex;
+        command.baseInstance = i;
+        // Math::Mat is row major while GLSL reads the columns from consecutive attributes
+        for(unsigned int row = 0; row < 4; row++) {
+            for(unsigned int col = 0; col < 4; col++) {
+                drawData[i].transform[col * 4 + row] = draw.transform[row][col];
+            }
+        }
+    }
+}
+
+}
@@ -0,0 +1,113 @@
+#ifndef INDIRECT_DRAW_STREAM_H
+#define INDIRECT_DRAW_STREAM_H
+
+#include <graphics/mesh/mesh_data.h>
+#include <graphics/buffer/persistent_mapped_buffer.h>
+#include <math/matrix.h>
+#include <vector>
+#include <functional>
+
+#include <glad/glad.h>
+
+namespace Engine {
+
+/*
+ * Layout of one command in the GL_DRAW_INDIRECT_BUFFER read by glMultiDrawElementsIndirect.
+ */
+struct DrawElementsIndirectCommand {
+    GLuint count;
+    GLuint instanceCount;
+    GLuint firstIndex;
+    GLint baseVertex;
+    GLuint baseInstance;
+};
+
+/*
+ * Per-draw data read by the vertex shader through instanced attributes. The transform is stored column major.
+ */
+struct IndirectDrawData {
+    float transform[16];
+};
+
+/*
+ * IndirectDrawStream collects the visible meshes of a frame and draws all meshes sharing a vertex format and batch key
+ * (e.g. a material) with a single glMultiDrawElementsIndirect call. The draw commands and per-draw data are written by
+ * JobSystem jobs straight into persistently mapped buffers. Each draw's baseInstance selects its per-draw data, which
+ * the vertex shader reads from attribute locations 3 to 6 (see indirect_vertex_shader.vs.glsl).
+ *
+ * Usage per frame: clear(), addDraw() for each visible mesh, build(), submit().
+ */
+class IndirectDrawStream {
+    public:
+        /*
+         * Creates a stream holding up to maxDraws draws per frame. Commands are built by JobSystem jobs, split into ranges
+         * for numThreads threads, or for one per hardware thread if numThreads is 0.
+         */
+        IndirectDrawStream(const unsigned int maxDraws, const unsigned int numThreads = 0);
+        
+        void clear();
+        
+        /*
+         * Adds a draw of buffered mesh with index meshID. Draws with equal batchKey and vertex format are submitted
+         * together. Meshes without indices are skipped. Throws MeshException if maxDraws draws have already been added.
+         */
+        void addDraw(const unsigned int meshID, const unsigned int batchKey, const Math::Mat4f& transform);
+        
+        /*
+         * Adds a draw of drawRange, for callers that looked up the range of a mesh drawn many times once.
+         */
+        void addDraw(const MeshDrawRange& drawRange, const unsigned int batchKey, const Math::Mat4f& transform);
+        
+        /*
+         * Sorts the draws into batches and writes their commands and per-draw data.
+         */
+        void build();
+        
+        /*
+         * Issues one glMultiDrawElementsIndirect call per batch. bindBatch is called with the batch key before each
+         * batch to bind its material.
+         */
+        void submit(const std::function<void(unsigned int)>& bindBatch);
+        
+        /*
+         * Deletes the OpenGL buffers.
+         */
+        void destroy();
+        
+        unsigned int getNumDraws() const { return draws.size(); }
+        unsigned int getNumBatches() const { return batches.size(); }
+        unsigned int getMaxDraws() const { return maxDraws; }
+        const PersistentMappedBuffer& getCommandBuffer() const { return commandBuffer; }
+        const PersistentMappedBuffer& getDrawDataBuffer() const { return drawDataBuffer; }
+        
+        // Builds with fewer draws than this per thread run on the calling thread only
+        static const unsigned int MIN_DRAWS_PER_THREAD = 256;
+        // Attribute location of the first column of the per-draw transform
+        static const GLuint TRANSFORM_ATTRIBUTE_LOCATION = 3;
+    private:
+        struct Draw {
+            unsigned int batchKey;
+            MeshDrawRange drawRange;
+            Math::Mat4f transform;
+        };
+        struct Batch {
+            VertexFormat vertexFormat;
+            unsigned int batchKey;
+            unsigned int firstDraw;
+            unsigned int numDraws;
+        };
+        
+        void writeDraws(const unsigned int firstDraw, const unsigned int lastDraw,
+                DrawElementsIndirectCommand* commands, IndirectDrawData* drawData) const;
+        
+        unsigned int maxDraws;
+        unsigned int numThreads;
+        std::vector<Draw> draws;
+        std::vector<Batch> batches;
+        PersistentMappedBuffer commandBuffer;
+        PersistentMappedBuffer drawDataBuffer;
+};
+
+}
+
+#endif //INDIRECT_DRAW_STREAM_H
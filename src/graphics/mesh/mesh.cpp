@@ -1,5 +1,5 @@
 #include "mesh.h"
-#include <math/linear_math.h>
+#include <graphics/state/gl_state_cache.h>
 
 namespace Engine {
 
@@ -23,32 +23,22 @@ Mesh::Mesh(const Mesh& mesh) {
 Mesh::~Mesh() {
     MeshLoader::ReleaseLoadedMesh(this->meshID);
 }
-float Mesh::myTime = 0.0f;
 Math::Vec2f Mesh::myMousePos = Math::createVec2<float>(0.0f, 0.0f);
 Math::Vec3f Mesh::myPos = Math::createVec3<float>(0.0f, 0.0f, 0.0f);
+Math::Mat4f Mesh::myTransform = Math::Mat4f(1.0f);
 void Mesh::render() const {
-
+    if(MeshLoader::GetNumIndices(this->meshID) == 0) {
+        return;
+    }
     texturedMaterial.apply();
+    ShaderProgramPtr shaderProgramPtr = texturedMaterial.getActiveShaderProgramPtr();
     MeshLoader::BindMesh(this->meshID);
     
-    Math::Mat4f myMatrix0(Math::createTranslationMat(
-            Math::createVec3<float>(-0.5f, -0.5f, -0.5f)
-    ));
-    Math::Mat4f myMatrix1(Math::createRotationMat(
-            Math::createVec3<float>(1.0f, 1.0f, 1.0f), Math::toRadians(360.0f * myTime)
-    ));
-    Math::Mat4f myMatrix2(Math::createTranslationMat(
-            Math::createVec3<float>(0.5f, 0.5f, 0.5f)
-    ));
-    Math::Mat4f myMatrix3(Math::createTranslationMat(
-            Math::createVec3<float>(myPos[0], myPos[1], myPos[2])
-    ));
-    ADD_ERROR_INFO(texturedMaterial.getShaderProgramPtr()->setUniformFloatMat("transform", myMatrix3 * myMatrix2 * myMatrix1 * myMatrix0));
-    Math::Mat4f perspectiveMat = Math::createPerspectiveProjectionMat(Math::toRadians(45.0f), (float)900 / (float)600, 1.0f, 100.0f);
-    ADD_ERROR_INFO(texturedMaterial.getShaderProgramPtr()->setUniformFloatMat("projectionMatrix", perspectiveMat));
+    ADD_ERROR_INFO(shaderProgramPtr->setUniformFloatMat("transform", myTransform));
     
-    glPolygonMode(GL_FRONT_AND_BACK, GL_FILL);
-    glDrawElements(GL_TRIANGLES, getMeshDataPtr()->getIndices()->size(), GL_UNSIGNED_INT, 0);
+    GLStateCache::SetPolygonMode(GL_FILL);
+    glDrawElementsBaseVertex(GL_TRIANGLES, MeshLoader::GetNumIndices(this->meshID), GL_UNSIGNED_INT,
+            (void*)(MeshLoader::GetFirstIndex(this->meshID) * sizeof(unsigned int)), MeshLoader::GetBaseVertex(this->meshID));
 }
 
 MeshDataPtr Mesh::getMeshDataPtr() const {
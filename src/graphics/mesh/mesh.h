@@ -12,9 +12,14 @@ class Mesh {
         Mesh(const MeshDataPtr meshDataPtr, const TexturedMaterial texturedMaterial, const UnTexturedMaterial unTexturedMaterial, const std::string modelFilePath = "");
         Mesh(const Mesh& mesh);
         ~Mesh();
-        static float myTime;
         static Math::Vec2f myMousePos;
         static Math::Vec3f myPos;
+        // Model transform every mesh is drawn with, worked out once per frame
+        static Math::Mat4f myTransform;
+        
+        /*
+         * Draws the mesh with its textured material. The camera's matrices come from the frame's FrameConstants.
+         */
         void render() const;
         
         /*
@@ -24,11 +29,18 @@ class Mesh {
         MeshDataPtr getMeshDataPtr() const;
         
         /*
-         * Returns MeshDataPtr to a deep copy of this mesh's data.
+         * Returns MeshDataPtr to a copy of this mesh's data that shares buffers until mutated.
          */
         MeshDataPtr copyMeshData() const;
         
+        unsigned int getMeshID() const { return meshID; }
         TexturedMaterial getTexturedMaterial() const { return texturedMaterial; }
+        
+        /*
+         * Returns true if this mesh's textured material has the same state as texturedMaterial. Avoids copying the
+         * material's textures.
+         */
+        bool hasTexturedMaterialState(const TexturedMaterial& texturedMaterial) const { return this->texturedMaterial.hasSameState(texturedMaterial); }
         void setTexturedMaterial(const TexturedMaterial texturedMaterial) { this->texturedMaterial = texturedMaterial; }
         UnTexturedMaterial getUnTexturedMaterial() const { return unTexturedMaterial; }
         void setUnTexturedMaterial(const UnTexturedMaterial unTexturedMaterial) { this->unTexturedMaterial = unTexturedMaterial; }
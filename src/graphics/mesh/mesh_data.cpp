@@ -5,19 +5,15 @@ namespace Engine {
 /*
  * Class MeshData
  */
-MeshData::MeshData(const VectorPtr<unsigned int> indices, const MeshGeometryDataPtr meshGeometryDataPtr, const std::string modelFilePath) {
+MeshData::MeshData(const SharedBuffer<unsigned int> indices, const MeshGeometryDataPtr meshGeometryDataPtr, const std::string modelFilePath) {
     this->meshGeometryID = MeshGeometryLoader::LoadMeshFromMeshGeometryData(meshGeometryDataPtr, modelFilePath);
     MeshGeometryLoader::UseLoadedMeshGeometry(this->meshGeometryID);
     this->indices = indices;
 }
 
-MeshData::MeshData(const MeshData& meshData) {
+MeshData::MeshData(const MeshData& meshData) : indices(meshData.indices) {
     this->meshGeometryID = meshData.meshGeometryID;
     MeshGeometryLoader::UseLoadedMeshGeometry(this->meshGeometryID);
-    this->indices = std::make_shared<std::vector<unsigned int>>();
-    for(unsigned int i = 0; i < meshData.indices->size(); i++) {
-        this->indices->push_back((*(meshData.indices))[i]);
-    }
 }
 
 MeshData::~MeshData() {
@@ -31,45 +27,73 @@ MeshGeometryDataPtr MeshData::getMeshGeometryDataPtr() const {
 void MeshData::setMeshGeometryDataPtr(const MeshGeometryDataPtr meshGeometryDataPtr) {
     MeshGeometryLoader::ReleaseLoadedMeshGeometry(this->meshGeometryID);
     this->meshGeometryID = MeshGeometryLoader::LoadMeshFromMeshGeometryData(meshGeometryDataPtr);
+    MeshGeometryLoader::UseLoadedMeshGeometry(this->meshGeometryID);
 }
         
 MeshGeometryDataPtr MeshData::copyMeshGeometryData() const {
     return MeshGeometryLoader::CopyMeshGeometryDataFromLoaded(this->meshGeometryID);
 }
 
+std::vector<unsigned int> MeshData::getReferencedVertices(std::vector<unsigned int>& localIndices) const {
+    const unsigned int unused = ~0u;
+    std::vector<unsigned int> localVertexIndices(getMeshGeometryDataPtr()->getNumVertices(), unused);
+    std::vector<unsigned int> referencedVertices;
+    localIndices.resize(indices.getSize());
+    for(unsigned int i = 0; i < indices.getSize(); i++) {
+        unsigned int& localVertexIndex = localVertexIndices[indices[i]];
+        if(localVertexIndex == unused) {
+            localVertexIndex = referencedVertices.size();
+            referencedVertices.push_back(indices[i]);
+        }
+        localIndices[i] = localVertexIndex;
+    }
+    return referencedVertices;
+}
+
 /*
  * Class MeshLoader
  */
 unsigned int MeshLoader::spareID = 1;
 std::stack<unsigned int> MeshLoader::availableIDStack = std::stack<unsigned int>();
 std::unordered_map<unsigned int, MeshLoader::MeshInfo> MeshLoader::loadedMeshes = std::unordered_map<unsigned int, MeshLoader::MeshInfo>();
+ResidencyPolicy MeshLoader::defaultResidencyPolicy = RESIDENCY_KEEP_HOST_COPY;
+DeferredReleaseQueue MeshLoader::releaseQueue = DeferredReleaseQueue();
 
 void MeshLoader::UnloadUnusedMeshes() {
-    for(unsigned int i = 0; i < loadedMeshes.size(); i++) {
-        if(loadedMeshes[i].usingCount == 0) {
-            UnloadMesh(i);
+    std::vector<unsigned int> unusedMeshIDs;
+    for(std::unordered_map<unsigned int, MeshInfo>::iterator iter = loadedMeshes.begin(); iter != loadedMeshes.end(); iter++) {
+        if(iter->second.usingCount == 0) {
+            unusedMeshIDs.push_back(iter->first);
         }
     }
+    for(unsigned int i = 0; i < unusedMeshIDs.size(); i++) {
+        UnloadMesh(unusedMeshIDs[i]);
+    }
 }
 
 MeshDataPtr MeshLoader::GetMeshDataPtr(const unsigned int meshID) {
 #ifdef _DEBUG
     assert(meshID != 0 && meshID < spareID);
 #endif
+    EnsureHostResident(meshID);
     return loadedMeshes[meshID].meshDataPtr;
 }
 
 void MeshLoader::BindMesh(const unsigned int meshID) {
-    glBindVertexArray(loadedMeshes[meshID].meshVAO);
+    GeometryHeap::BindVertexFormat(VERTEX_FORMAT_POSITION_NORMAL_TEXCOORD);
 }
 
 unsigned int MeshLoader::LoadMeshFromMeshData(const MeshDataPtr meshDataPtr, const std::string modelFilePath) {
     MeshInfo meshInfo;
     meshInfo.modelFilePath = modelFilePath;
     meshInfo.meshDataPtr = std::make_shared<MeshData>(*(meshDataPtr.get()));
-    meshInfo.meshEBO = 0;
-    meshInfo.meshVAO = 0;
+    meshInfo.indexAllocationID = 0;
     meshInfo.usingCount = 0;
+    meshInfo.residencyPolicy = defaultResidencyPolicy;
+    meshInfo.hostResident = true;
+    meshInfo.numIndices = meshDataPtr->getIndices().getSize();
+    meshInfo.deviceBytes = 0;
+    meshInfo.timesBuffered = 0;
     if(availableIDStack.empty()) {
         availableIDStack.push(spareID++);
     }
@@ -83,7 +107,7 @@ void MeshLoader::UseLoadedMesh(const unsigned int meshID) {
 #ifdef _DEBUG
     assert(meshID != 0 && meshID < spareID);
 #endif
-    if(loadedMeshes[meshID].usingCount == 0) {
+    if(loadedMeshes[meshID].usingCount == 0 && !releaseQueue.resurrect(meshID)) {
         BufferMeshData(meshID);
     }
     loadedMeshes[meshID].usingCount++;
@@ -98,7 +122,16 @@ void MeshLoader::ReleaseLoadedMesh(const unsigned int meshID) {
     loadedMeshes[meshID].usingCount--;
     std::cout << "ReleaseLoadedMesh ID = " << meshID << ", new count = " << loadedMeshes[meshID].usingCount << "\n";
     if(loadedMeshes[meshID].usingCount == 0) {
-        UnBufferMeshData(meshID);
+        releaseQueue.schedule(meshID, loadedMeshes[meshID].deviceBytes, FrameClock::GetFrameNumber());
+    }
+}
+
+void MeshLoader::ProcessDeferredReleases(const bool reclaimAll) {
+    std::vector<unsigned int> reclaimedMeshIDs = releaseQueue.collect(FrameClock::GetFrameNumber(), reclaimAll);
+    for(unsigned int i = 0; i < reclaimedMeshIDs.size(); i++) {
+        unsigned int meshID = reclaimedMeshIDs[i];
+        // Meshes without a model file are unloaded straight after, so their indices aren't read back
+        UnBufferMeshData(meshID, loadedMeshes[meshID].modelFilePath != "");
         if(loadedMeshes[meshID].modelFilePath == "") {
             UnloadMesh(meshID);
         }
@@ -109,60 +142,140 @@ MeshDataPtr MeshLoader::CopyMeshDataFromLoaded(const unsigned int meshID) {
 #ifdef _DEBUG
     assert(meshID != 0 && meshID < spareID);
 #endif
+    EnsureHostResident(meshID);
     MeshGeometryDataPtr meshGeometryDataPtr = loadedMeshes[meshID].meshDataPtr->copyMeshGeometryData();
     MeshDataPtr meshDataPtr = std::make_shared<MeshData>(*(loadedMeshes[meshID].meshDataPtr));
     meshDataPtr->setMeshGeometryDataPtr(meshGeometryDataPtr);
     return meshDataPtr;
 }
 
+void MeshLoader::SetResidencyPolicy(const unsigned int meshID, const ResidencyPolicy residencyPolicy) {
+#ifdef _DEBUG
+    assert(meshID != 0 && meshID < spareID);
+#endif
+    MeshInfo& meshInfo = loadedMeshes[meshID];
+    if(residencyPolicy == RESIDENCY_KEEP_HOST_COPY) {
+        EnsureHostResident(meshID);
+    }
+    meshInfo.residencyPolicy = residencyPolicy;
+    if(residencyPolicy != RESIDENCY_KEEP_HOST_COPY && meshInfo.indexAllocationID != 0) {
+        meshInfo.meshDataPtr->setIndices(SharedBuffer<unsigned int>());
+        meshInfo.hostResident = false;
+    }
+}
+
+ResidencyPolicy MeshLoader::GetResidencyPolicy(const unsigned int meshID) {
+#ifdef _DEBUG
+    assert(meshID != 0 && meshID < spareID);
+#endif
+    return loadedMeshes[meshID].residencyPolicy;
+}
+
+bool MeshLoader::IsHostResident(const unsigned int meshID) {
+#ifdef _DEBUG
+    assert(meshID != 0 && meshID < spareID);
+#endif
+    return loadedMeshes[meshID].hostResident;
+}
+
+unsigned int MeshLoader::GetNumIndices(const unsigned int meshID) {
+#ifdef _DEBUG
+    assert(meshID != 0 && meshID < spareID);
+#endif
+    return loadedMeshes[meshID].numIndices;
+}
+
+size_t MeshLoader::GetFirstIndex(const unsigned int meshID) {
+#ifdef _DEBUG
+    assert(meshID != 0 && meshID < spareID);
+    assert(loadedMeshes[meshID].indexAllocationID != 0);
+#endif
+    return GeometryHeap::GetFirstIndex(loadedMeshes[meshID].indexAllocationID);
+}
+
+int MeshLoader::GetBaseVertex(const unsigned int meshID) {
+#ifdef _DEBUG
+    assert(meshID != 0 && meshID < spareID);
+#endif
+    return MeshGeometryLoader::GetBaseVertex(loadedMeshes[meshID].meshDataPtr->getMeshGeometryID());
+}
+
+MeshDrawRange MeshLoader::GetDrawRange(const unsigned int meshID) {
+#ifdef _DEBUG
+    assert(meshID != 0 && meshID < spareID);
+    assert(loadedMeshes[meshID].indexAllocationID != 0);
+#endif
+    const MeshInfo& meshInfo = loadedMeshes[meshID];
+    MeshDrawRange drawRange;
+    drawRange.vertexFormat = VERTEX_FORMAT_POSITION_NORMAL_TEXCOORD;
+    drawRange.numIndices = meshInfo.numIndices;
+    drawRange.firstIndex = GeometryHeap::GetFirstIndex(meshInfo.indexAllocationID);
+    drawRange.baseVertex = MeshGeometryLoader::GetBaseVertex(meshInfo.meshDataPtr->getMeshGeometryID());
+    return drawRange;
+}
+
+MemoryStats MeshLoader::GetMemoryStats() {
+    MemoryStats memoryStats;
+    for(std::unordered_map<unsigned int, MeshInfo>::iterator iter = loadedMeshes.begin(); iter != loadedMeshes.end(); iter++) {
+        memoryStats.hostBytes += iter->second.meshDataPtr->getIndices().getSizeInBytes();
+        memoryStats.deviceBytes += iter->second.deviceBytes;
+    }
+    return memoryStats;
+}
+
 void MeshLoader::BufferMeshData(const unsigned int meshID) {
+    EnsureHostResident(meshID);
+    if(loadedMeshes[meshID].timesBuffered++ > 0) {
+        releaseQueue.recordThrashEvent();
+    }
     MeshGeometryLoader::RequireMeshGeometryBuffered(loadedMeshes[meshID].meshDataPtr->getMeshGeometryID());
     
-    glGenVertexArrays(1, &(loadedMeshes[meshID].meshVAO));
-    glBindVertexArray(loadedMeshes[meshID].meshVAO);
-    MeshGeometryLoader::BindMeshGeometry(loadedMeshes[meshID].meshDataPtr->getMeshGeometryID());
-    
-    glGenBuffers(1, &(loadedMeshes[meshID].meshEBO));
-    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, loadedMeshes[meshID].meshEBO);
-    unsigned int indexStride = 1;
-    unsigned int totalNumValues = loadedMeshes[meshID].meshDataPtr->getIndices()->size() * indexStride;
-    std::unique_ptr<unsigned int[]> indexData = std::unique_ptr<unsigned int[]>(new unsigned int[totalNumValues]);
-    for(unsigned int i = 0; i < loadedMeshes[meshID].meshDataPtr->getIndices()->size(); i++) {
-        indexData.get()[i] = (*(loadedMeshes[meshID].meshDataPtr->getIndices()))[i];
-    }
-    glBufferData(GL_ELEMENT_ARRAY_BUFFER, totalNumValues * sizeof(unsigned int), indexData.get(), GL_STATIC_DRAW);
-    
-    unsigned int vertexStride = 3 * sizeof(float);
-    unsigned int normalStride = 3 * sizeof(float);
-    unsigned int textureCoordStride = 2 * sizeof(float);
-    unsigned int stride = vertexStride + normalStride + textureCoordStride;
-    // Vertices
-    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, stride, (void*)(size_t)0);
-    glEnableVertexAttribArray(0);
-    // Normals
-    glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, stride, (void*)(size_t)(vertexStride));
-    glEnableVertexAttribArray(1);
-    // Texture Coords
-    glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, stride, (void*)(size_t)(vertexStride + normalStride));
-    glEnableVertexAttribArray(2);
+    // Indices are relative to the mesh geometry, which is drawn with its base vertex
+    const SharedBuffer<unsigned int>& indices = loadedMeshes[meshID].meshDataPtr->getIndices();
+    loadedMeshes[meshID].indexAllocationID = GeometryHeap::AllocateIndices(indices.getSize(), indices.data());
+    loadedMeshes[meshID].deviceBytes = indices.getSizeInBytes();
     
-    glBindVertexArray(0);
-    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
-    glBindBuffer(GL_ARRAY_BUFFER, 0);
+    if(loadedMeshes[meshID].residencyPolicy != RESIDENCY_KEEP_HOST_COPY) {
+        loadedMeshes[meshID].meshDataPtr->setIndices(SharedBuffer<unsigned int>());
+        loadedMeshes[meshID].hostResident = false;
+    }
 }
 
-void MeshLoader::UnBufferMeshData(const unsigned int meshID) {
-    glDeleteVertexArrays(1, &(loadedMeshes[meshID].meshVAO));
-    glDeleteBuffers(1, &(loadedMeshes[meshID].meshEBO));
+void MeshLoader::UnBufferMeshData(const unsigned int meshID, const bool keepHostCopy) {
+    if(keepHostCopy && loadedMeshes[meshID].residencyPolicy == RESIDENCY_REFETCH_HOST_COPY) {
+        EnsureHostResident(meshID);
+    }
+    GeometryHeap::FreeIndices(loadedMeshes[meshID].indexAllocationID);
+    loadedMeshes[meshID].indexAllocationID = 0;
+    loadedMeshes[meshID].deviceBytes = 0;
     std::cout << "unbuffering\n";
     MeshGeometryLoader::RelaxMeshGeometryBuffered(loadedMeshes[meshID].meshDataPtr->getMeshGeometryID());
 }
 
+void MeshLoader::EnsureHostResident(const unsigned int meshID) {
+    MeshInfo& meshInfo = loadedMeshes[meshID];
+    if(meshInfo.hostResident) {
+        return;
+    }
+    if(meshInfo.residencyPolicy == RESIDENCY_DISCARD_HOST_COPY || meshInfo.indexAllocationID == 0) {
+        throw MeshException("ERROR: System memory copy of mesh " + std::to_string(meshID) + " indices was discarded.");
+    }
+    
+    // Read the indices back from the geometry heap
+    std::vector<unsigned int> indices(meshInfo.numIndices);
+    GeometryHeap::ReadIndices(meshInfo.indexAllocationID, indices.data());
+    meshInfo.meshDataPtr->setIndices(SharedBuffer<unsigned int>(std::move(indices)));
+    meshInfo.hostResident = true;
+}
+
 void MeshLoader::UnloadMesh(const unsigned int meshID) {
 #ifdef _DEBUG
     assert(meshID != 0 && meshID < spareID);
     assert(loadedMeshes[meshID].usingCount == 0);
 #endif
+    if(releaseQueue.remove(meshID)) {
+        UnBufferMeshData(meshID, false);
+    }
     for(std::unordered_map<unsigned int, MeshInfo>::iterator iter = loadedMeshes.begin(); iter != loadedMeshes.end(); iter++) {
         if(iter->first == meshID) {
             availableIDStack.push(iter->first);
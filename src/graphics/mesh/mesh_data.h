@@ -2,6 +2,7 @@
 #define MESH_DATA_H
 
 #include <graphics/mesh/mesh_geometry_data.h>
+#include <graphics/buffer/deferred_release_queue.h>
 #include <math/vector.h>
 #include <vector>
 #include <memory>
@@ -22,12 +23,12 @@ using VectorPtr = std::shared_ptr<std::vector<T>>;
 class MeshData {
     public:
         /*
-         * Shallow copies indices and loads meshGeometryDataPtr using the mesh geometry loader.
+         * Shares indices and loads meshGeometryDataPtr using the mesh geometry loader.
          */
-        MeshData(const VectorPtr<unsigned int> indices, const MeshGeometryDataPtr meshGeometryDataPtr, const std::string modelFilePath = "");
+        MeshData(const SharedBuffer<unsigned int> indices, const MeshGeometryDataPtr meshGeometryDataPtr, const std::string modelFilePath = "");
         
         /*
-         * Deep copies mesh data into new mesh data.
+         * Shares the indices and mesh geometry of the input mesh data with the new mesh data.
          */
         MeshData(const MeshData& meshData);
         
@@ -48,19 +49,41 @@ class MeshData {
         void setMeshGeometryDataPtr(const MeshGeometryDataPtr meshGeometryDataPtr);
         
         /*
-         * Returns MeshGeometryDataPtr to a deep copy of this mesh's geometry data.
+         * Returns MeshGeometryDataPtr to a copy of this mesh's geometry data that shares buffers until mutated.
          */
         MeshGeometryDataPtr copyMeshGeometryData() const;
         
         unsigned int getMeshGeometryID() const { return meshGeometryID; }
-        VectorPtr<unsigned int> getIndices() const { return indices; }
-        void setIndices(const VectorPtr<unsigned int> indices) { this->indices = indices; }
+        const SharedBuffer<unsigned int>& getIndices() const { return indices; }
+        void setIndices(const SharedBuffer<unsigned int> indices) { this->indices = indices; }
+        
+        /*
+         * Returns a writable pointer to the indices, copying them first if they are shared.
+         */
+        unsigned int* mutableIndices() { return indices.mutableData(); }
+        
+        /*
+         * Returns the vertices of the geometry the indices refer to, in order of first use, and sets localIndices to the
+         * indices renumbered into that list. The meshes of a model share one geometry, so this picks out the part of it
+         * that belongs to this mesh.
+         */
+        std::vector<unsigned int> getReferencedVertices(std::vector<unsigned int>& localIndices) const;
     private:
         unsigned int meshGeometryID = 0;
-        VectorPtr<unsigned int> indices;
+        SharedBuffer<unsigned int> indices;
 };
 typedef std::shared_ptr<MeshData> MeshDataPtr;
 
+/*
+ * Location of a buffered mesh in the shared geometry heaps, as needed to draw it.
+ */
+struct MeshDrawRange {
+    VertexFormat vertexFormat = VERTEX_FORMAT_POSITION_NORMAL_TEXCOORD;
+    unsigned int numIndices = 0;
+    size_t firstIndex = 0;
+    int baseVertex = 0;
+};
+
 /*
  * MeshLoader handles loading meshes from mesh data a list of loaded meshes and buffering meshes into OpenGL.
  */
@@ -82,8 +105,8 @@ class MeshLoader {
         static void BindMesh(const unsigned int meshID);
         
         /*
-         * Puts mesh with data given by MeshDataPtr into list of loaded meshes. Returns the index of the mesh from list
-         * of loaded meshes.
+         * Puts mesh with data given by MeshDataPtr into list of loaded meshes, sharing its buffers rather than copying
+         * them. Returns the index of the mesh from list of loaded meshes.
          */
         static unsigned int LoadMeshFromMeshData(const MeshDataPtr meshDataPtr, const std::string filePath = "");
         
@@ -94,14 +117,64 @@ class MeshLoader {
         static void UseLoadedMesh(const unsigned int meshID);
         
         /*
-         * Decrements using count for mesh with index meshID from list of loaded meshes.
+         * Decrements using count for mesh with index meshID from list of loaded meshes. A mesh that is no longer used
+         * stays buffered until it is reclaimed by ProcessDeferredReleases, so using it again in the meantime is free.
          */
         static void ReleaseLoadedMesh(const unsigned int meshID);
         
         /*
-         * Returns a deep copy of the loaded mesh data with index meshID from list of loaded meshes.
+         * Unbuffers the released meshes that have gone unused for the release delay, or all released meshes if
+         * reclaimAll is true. Released meshes without a model file path are also unloaded. Call once per frame.
+         */
+        static void ProcessDeferredReleases(const bool reclaimAll = false);
+        
+        static DeferredReleaseQueue& GetReleaseQueue() { return releaseQueue; }
+        
+        /*
+         * Returns a copy of the loaded mesh data with index meshID from list of loaded meshes. The copy shares its
+         * buffers with the loaded mesh until either is mutated.
          */
         static MeshDataPtr CopyMeshDataFromLoaded(const unsigned int meshID);
+        
+        /*
+         * Sets the residency policy given to meshes loaded from now on. Applies to the mesh indices, the mesh geometry
+         * has its own policy in MeshGeometryLoader.
+         */
+        static void SetDefaultResidencyPolicy(const ResidencyPolicy residencyPolicy) { defaultResidencyPolicy = residencyPolicy; }
+        
+        /*
+         * Sets the residency policy of the indices of loaded mesh with index meshID. Takes effect the next time the
+         * mesh is buffered, or immediately if it is already buffered.
+         */
+        static void SetResidencyPolicy(const unsigned int meshID, const ResidencyPolicy residencyPolicy);
+        static ResidencyPolicy GetResidencyPolicy(const unsigned int meshID);
+        
+        /*
+         * Returns true if the system memory copy of the indices of mesh with index meshID is currently held.
+         */
+        static bool IsHostResident(const unsigned int meshID);
+        
+        static unsigned int GetNumIndices(const unsigned int meshID);
+        
+        /*
+         * Returns the position of the first index of buffered mesh with index meshID in the shared index buffer.
+         */
+        static size_t GetFirstIndex(const unsigned int meshID);
+        
+        /*
+         * Returns the base vertex of the geometry of buffered mesh with index meshID.
+         */
+        static int GetBaseVertex(const unsigned int meshID);
+        
+        /*
+         * Returns the vertex format, index range and base vertex of buffered mesh with index meshID.
+         */
+        static MeshDrawRange GetDrawRange(const unsigned int meshID);
+        
+        /*
+         * Returns the bytes held by the indices of all loaded meshes in system memory and in OpenGL buffers.
+         */
+        static MemoryStats GetMemoryStats();
     private:
         /*
          * Buffers mesh data to GPU from loaded mesh list with index meshID.
@@ -109,26 +182,40 @@ class MeshLoader {
         static void BufferMeshData(const unsigned int meshID);
         
         /*
-         * Deletes OpenGL buffer of mesh with index meshID from loaded mesh list.
+         * Deletes OpenGL buffer of mesh with index meshID from loaded mesh list. The indices are read back first if the
+         * residency policy asks for it and keepHostCopy is set; pass false when the mesh is about to be unloaded.
          */
-        static void UnBufferMeshData(const unsigned int meshID);
+        static void UnBufferMeshData(const unsigned int meshID, const bool keepHostCopy);
         
         /*
          * Unloads loaded mesh from system memory. Removes the mesh from list of loaded meshes.
          */
         static void UnloadMesh(const unsigned int meshID);
         
+        /*
+         * Makes sure the system memory copy of the indices of mesh with index meshID is held, reading them back from
+         * the OpenGL buffer if they were dropped. Throws MeshException if they were discarded and can't be fetched.
+         */
+        static void EnsureHostResident(const unsigned int meshID);
+        
         struct MeshInfo {
             std::string modelFilePath;
             MeshDataPtr meshDataPtr;
-            unsigned int meshEBO;
-            unsigned int meshVAO;
+            // Allocation in the geometry heap, 0 while not buffered
+            unsigned int indexAllocationID = 0;
             unsigned int usingCount = 0;
+            ResidencyPolicy residencyPolicy = RESIDENCY_KEEP_HOST_COPY;
+            bool hostResident = true;
+            unsigned int numIndices = 0;
+            size_t deviceBytes = 0;
+            unsigned int timesBuffered = 0;
         };
         // CHANGE TO SINGLETON PATTERN TO ALLOW RESEARTING OF ENGINE!!!!!!!!!!!!
         static unsigned int spareID;
         static std::stack<unsigned int> availableIDStack;
         static std::unordered_map<unsigned int, MeshInfo> loadedMeshes;
+        static ResidencyPolicy defaultResidencyPolicy;
+        static DeferredReleaseQueue releaseQueue;
 };
 
 }
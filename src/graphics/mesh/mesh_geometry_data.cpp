@@ -5,35 +5,13 @@ namespace Engine {
 /*
  * Class MeshGeometryData
  */
-MeshGeometryData::MeshGeometryData(const VectorPtr<Math::Vec3f> vertices, const VectorPtr<Math::Vec3f> normals, const VectorPtr<Math::Vec2f> textureCoords) {
+MeshGeometryData::MeshGeometryData(const SharedBuffer<Math::Vec3f> vertices, const SharedBuffer<Math::Vec3f> normals, const SharedBuffer<Math::Vec2f> textureCoords)
+    : vertices(vertices), normals(normals), textureCoords(textureCoords) {
 #ifdef _DEBUG
-    unsigned int size = vertices->size();
-    assert(normals->size() == size);
-    assert(textureCoords->size() == size);
+    unsigned int size = vertices.getSize();
+    assert(normals.getSize() == size);
+    assert(textureCoords.getSize() == size);
 #endif
-    this->vertices = vertices;
-    this->normals = normals;
-    this->textureCoords = textureCoords;
-}
-
-MeshGeometryData::MeshGeometryData(const MeshGeometryData& meshGeometryData) {
-#ifdef _DEBUG
-    unsigned int size = meshGeometryData.vertices->size();
-    assert(meshGeometryData.normals->size() == size);
-    assert(meshGeometryData.textureCoords->size() == size);
-#endif
-    this->vertices = std::make_shared<std::vector<Math::Vec3f>>();
-    for(unsigned int i = 0; i < meshGeometryData.vertices->size(); i++) {
-        this->vertices->push_back((*(meshGeometryData.vertices.get()))[i]);
-    }
-    this->normals = std::make_shared<std::vector<Math::Vec3f>>();
-    for(unsigned int i = 0; i < meshGeometryData.normals->size(); i++) {
-        this->normals->push_back((*(meshGeometryData.normals.get()))[i]);
-    }
-    this->textureCoords = std::make_shared<std::vector<Math::Vec2f>>();
-    for(unsigned int i = 0; i < meshGeometryData.textureCoords->size(); i++) {
-        this->textureCoords->push_back((*(meshGeometryData.textureCoords.get()))[i]);
-    }
 }
 
 /*
@@ -42,47 +20,65 @@ MeshGeometryData::MeshGeometryData(const MeshGeometryData& meshGeometryData) {
 unsigned int MeshGeometryLoader::spareID = 1;
 std::stack<unsigned int> MeshGeometryLoader::availableIDStack = std::stack<unsigned int>();
 std::unordered_map<unsigned int, MeshGeometryLoader::MeshGeometryInfo> MeshGeometryLoader::loadedMeshGeometries = std::unordered_map<unsigned int, MeshGeometryLoader::MeshGeometryInfo>();
+PathIndex MeshGeometryLoader::pathIndex = PathIndex();
+ResidencyPolicy MeshGeometryLoader::defaultResidencyPolicy = RESIDENCY_KEEP_HOST_COPY;
+DeferredReleaseQueue MeshGeometryLoader::releaseQueue = DeferredReleaseQueue();
 
 void MeshGeometryLoader::UnloadUnusedMeshGeometries() {
+    std::vector<unsigned int> unusedMeshGeometryIDs;
     for(std::unordered_map<unsigned int, MeshGeometryInfo>::iterator iter = loadedMeshGeometries.begin(); iter != loadedMeshGeometries.end(); iter++) {
         if(iter->second.usingCount == 0) {
-            UnloadMeshGeometry(iter->first);
+            unusedMeshGeometryIDs.push_back(iter->first);
         }
     }
+    for(unsigned int i = 0; i < unusedMeshGeometryIDs.size(); i++) {
+        UnloadMeshGeometry(unusedMeshGeometryIDs[i]);
+    }
 }
 
 MeshGeometryDataPtr MeshGeometryLoader::GetMeshGeometryDataPtr(const unsigned int meshGeometryID) {
 #ifdef _DEBUG
     assert(meshGeometryID != 0 && meshGeometryID < spareID);
 #endif
+    EnsureHostResident(meshGeometryID);
     return loadedMeshGeometries[meshGeometryID].meshGeometryDataPtr;
 }
 
-void MeshGeometryLoader::BindMeshGeometry(const unsigned int meshGeometryID) {
-    glBindBuffer(GL_ARRAY_BUFFER, loadedMeshGeometries[meshGeometryID].meshVBO);
+int MeshGeometryLoader::GetBaseVertex(const unsigned int meshGeometryID) {
+#ifdef _DEBUG
+    assert(meshGeometryID != 0 && meshGeometryID < spareID);
+    assert(loadedMeshGeometries[meshGeometryID].vertexAllocationID != 0);
+#endif
+    return GeometryHeap::GetBaseVertex(VERTEX_FORMAT_POSITION_NORMAL_TEXCOORD, loadedMeshGeometries[meshGeometryID].vertexAllocationID);
 }
 
 unsigned int MeshGeometryLoader::LoadMeshFromMeshGeometryData(const MeshGeometryDataPtr meshGeometryDataPtr, const std::string modelFilePath) {
-    // Check if the mesh geometry is already buffered
+    // Check if the mesh geometry is already loaded
     if(modelFilePath != "") {
-        for(std::unordered_map<unsigned int, MeshGeometryInfo>::iterator iter = loadedMeshGeometries.begin(); iter != loadedMeshGeometries.end(); iter++) {
-            if(iter->second.modelFilePath == modelFilePath) {
-                iter->first;
-            }
+        unsigned int loadedMeshGeometryID = pathIndex.find(modelFilePath);
+        if(loadedMeshGeometryID != 0) {
+            return loadedMeshGeometryID;
         }
     }
     
     MeshGeometryInfo meshGeometryInfo;
     meshGeometryInfo.modelFilePath = modelFilePath;
     meshGeometryInfo.meshGeometryDataPtr = std::make_shared<MeshGeometryData>(*(meshGeometryDataPtr.get()));
-    meshGeometryInfo.meshVBO = 0;
+    meshGeometryInfo.vertexAllocationID = 0;
     meshGeometryInfo.usingCount = 0;
+    meshGeometryInfo.residencyPolicy = defaultResidencyPolicy;
+    meshGeometryInfo.numVertices = meshGeometryDataPtr->getNumVertices();
+    meshGeometryInfo.deviceBytes = 0;
+    meshGeometryInfo.timesBuffered = 0;
     if(availableIDStack.empty()) {
         availableIDStack.push(spareID++);
     }
     unsigned int meshGeometryID = availableIDStack.top();
     availableIDStack.pop();
     loadedMeshGeometries[meshGeometryID] = meshGeometryInfo;
+    if(modelFilePath != "") {
+        pathIndex.insert(modelFilePath, meshGeometryID);
+    }
     return meshGeometryID;
 }
 
@@ -101,11 +97,8 @@ void MeshGeometryLoader::ReleaseLoadedMeshGeometry(const unsigned int meshGeomet
 #endif
     loadedMeshGeometries[meshGeometryID].usingCount--;
     std::cout << "ReleaseLoadedMeshGeometry ID = " << meshGeometryID << ", new count = " << loadedMeshGeometries[meshGeometryID].usingCount << "\n";
-    if(loadedMeshGeometries[meshGeometryID].usingCount == 0) {
-        UnBufferMeshGeometryData(meshGeometryID);
-        if(loadedMeshGeometries[meshGeometryID].modelFilePath == "") {
-            UnloadMeshGeometry(meshGeometryID);
-        }
+    if(loadedMeshGeometries[meshGeometryID].usingCount == 0 && loadedMeshGeometries[meshGeometryID].modelFilePath == "") {
+        UnloadMeshGeometry(meshGeometryID);
     }
 }
 
@@ -113,7 +106,7 @@ void MeshGeometryLoader::RequireMeshGeometryBuffered(const unsigned int meshGeom
 #ifdef _DEBUG
     assert(meshGeometryID != 0 && meshGeometryID < spareID);
 #endif
-    if(loadedMeshGeometries[meshGeometryID].usingBufferedCount == 0) {
+    if(loadedMeshGeometries[meshGeometryID].usingBufferedCount == 0 && !releaseQueue.resurrect(meshGeometryID)) {
         BufferMeshGeometryData(meshGeometryID);
     }
     loadedMeshGeometries[meshGeometryID].usingBufferedCount++;
@@ -128,7 +121,14 @@ void MeshGeometryLoader::RelaxMeshGeometryBuffered(const unsigned int meshGeomet
     loadedMeshGeometries[meshGeometryID].usingBufferedCount--;
     std::cout << "RelaxMeshGeometryBuffered ID = " << meshGeometryID << ", new count = " << loadedMeshGeometries[meshGeometryID].usingBufferedCount << "\n";
     if(loadedMeshGeometries[meshGeometryID].usingBufferedCount == 0) {
-        UnBufferMeshGeometryData(meshGeometryID);
+        releaseQueue.schedule(meshGeometryID, loadedMeshGeometries[meshGeometryID].deviceBytes, FrameClock::GetFrameNumber());
+    }
+}
+
+void MeshGeometryLoader::ProcessDeferredReleases(const bool reclaimAll) {
+    std::vector<unsigned int> reclaimedMeshGeometryIDs = releaseQueue.collect(FrameClock::GetFrameNumber(), reclaimAll);
+    for(unsigned int i = 0; i < reclaimedMeshGeometryIDs.size(); i++) {
+        UnBufferMeshGeometryData(reclaimedMeshGeometryIDs[i], true);
     }
 }
 
@@ -136,19 +136,68 @@ MeshGeometryDataPtr MeshGeometryLoader::CopyMeshGeometryDataFromLoaded(const uns
 #ifdef _DEBUG
     assert(meshGeometryID != 0 && meshGeometryID < spareID);
 #endif
+    EnsureHostResident(meshGeometryID);
     return std::make_shared<MeshGeometryData>(*(loadedMeshGeometries[meshGeometryID].meshGeometryDataPtr));
 }
 
+void MeshGeometryLoader::SetResidencyPolicy(const unsigned int meshGeometryID, const ResidencyPolicy residencyPolicy) {
+#ifdef _DEBUG
+    assert(meshGeometryID != 0 && meshGeometryID < spareID);
+#endif
+    MeshGeometryInfo& meshGeometryInfo = loadedMeshGeometries[meshGeometryID];
+    if(residencyPolicy == RESIDENCY_KEEP_HOST_COPY) {
+        EnsureHostResident(meshGeometryID);
+    }
+    meshGeometryInfo.residencyPolicy = residencyPolicy;
+    if(residencyPolicy != RESIDENCY_KEEP_HOST_COPY && meshGeometryInfo.vertexAllocationID != 0) {
+        meshGeometryInfo.meshGeometryDataPtr.reset();
+    }
+}
+
+ResidencyPolicy MeshGeometryLoader::GetResidencyPolicy(const unsigned int meshGeometryID) {
+#ifdef _DEBUG
+    assert(meshGeometryID != 0 && meshGeometryID < spareID);
+#endif
+    return loadedMeshGeometries[meshGeometryID].residencyPolicy;
+}
+
+bool MeshGeometryLoader::IsHostResident(const unsigned int meshGeometryID) {
+#ifdef _DEBUG
+    assert(meshGeometryID != 0 && meshGeometryID < spareID);
+#endif
+    return loadedMeshGeometries[meshGeometryID].meshGeometryDataPtr.get() != nullptr;
+}
+
+unsigned int MeshGeometryLoader::GetNumVertices(const unsigned int meshGeometryID) {
+#ifdef _DEBUG
+    assert(meshGeometryID != 0 && meshGeometryID < spareID);
+#endif
+    return loadedMeshGeometries[meshGeometryID].numVertices;
+}
+
+MemoryStats MeshGeometryLoader::GetMemoryStats() {
+    MemoryStats memoryStats;
+    for(std::unordered_map<unsigned int, MeshGeometryInfo>::iterator iter = loadedMeshGeometries.begin(); iter != loadedMeshGeometries.end(); iter++) {
+        if(iter->second.meshGeometryDataPtr.get() != nullptr) {
+            memoryStats.hostBytes += iter->second.meshGeometryDataPtr->getSizeInBytes();
+        }
+        memoryStats.deviceBytes += iter->second.deviceBytes;
+    }
+    return memoryStats;
+}
+
 void MeshGeometryLoader::BufferMeshGeometryData(const unsigned int meshGeometryID) {
+    EnsureHostResident(meshGeometryID);
+    if(loadedMeshGeometries[meshGeometryID].timesBuffered++ > 0) {
+        releaseQueue.recordThrashEvent();
+    }
+    const MeshGeometryData& meshGeometryData = *(loadedMeshGeometries[meshGeometryID].meshGeometryDataPtr);
 #ifdef _DEBUG
-    unsigned int size = loadedMeshGeometries[meshGeometryID].meshGeometryDataPtr->getVertices()->size();
-    assert(loadedMeshGeometries[meshGeometryID].meshGeometryDataPtr->getNormals()->size() == size);
-    assert(loadedMeshGeometries[meshGeometryID].meshGeometryDataPtr->getTextureCoords()->size() == size);
+    unsigned int size = meshGeometryData.getVertices().getSize();
+    assert(meshGeometryData.getNormals().getSize() == size);
+    assert(meshGeometryData.getTextureCoords().getSize() == size);
 #endif
-    glGenBuffers(1, &(loadedMeshGeometries[meshGeometryID].meshVBO));
-    
-    glBindBuffer(GL_ARRAY_BUFFER, loadedMeshGeometries[meshGeometryID].meshVBO);
-    unsigned int numVertices = loadedMeshGeometries[meshGeometryID].meshGeometryDataPtr->getVertices()->size();
+    unsigned int numVertices = meshGeometryData.getNumVertices();
     unsigned int vertexStride = 3;
     unsigned int normalStride = 3;
     unsigned int textureCoordStride = 2;
@@ -157,22 +206,62 @@ void MeshGeometryLoader::BufferMeshGeometryData(const unsigned int meshGeometryI
     std::unique_ptr<float[]> combinedVertexData = std::unique_ptr<float[]>(new float[totalNumValues]);
     for(unsigned int i = 0; i < numVertices; i++) {
         for(unsigned int j = 0; j < vertexStride; j++) {
-            combinedVertexData.get()[i * stride + j] = (*(loadedMeshGeometries[meshGeometryID].meshGeometryDataPtr->getVertices()))[i][j];
+            combinedVertexData.get()[i * stride + j] = meshGeometryData.getVertices()[i][j];
         }
         for(unsigned int j = 0; j < normalStride; j++) {
-            combinedVertexData.get()[i * stride + j + vertexStride] = (*(loadedMeshGeometries[meshGeometryID].meshGeometryDataPtr->getNormals()))[i][j];
+            combinedVertexData.get()[i * stride + j + vertexStride] = meshGeometryData.getNormals()[i][j];
         }
         for(unsigned int j = 0; j < textureCoordStride; j++) {
-            combinedVertexData.get()[i * stride + j + vertexStride + normalStride] =
-                    (*(loadedMeshGeometries[meshGeometryID].meshGeometryDataPtr->getTextureCoords()))[i][j];
+            combinedVertexData.get()[i * stride + j + vertexStride + normalStride] = meshGeometryData.getTextureCoords()[i][j];
         }
     }
-    glBufferData(GL_ARRAY_BUFFER, totalNumValues * sizeof(float), combinedVertexData.get(), GL_STATIC_DRAW);
-    glBindBuffer(GL_ARRAY_BUFFER, 0);
+    loadedMeshGeometries[meshGeometryID].vertexAllocationID = GeometryHeap::AllocateVertices(VERTEX_FORMAT_POSITION_NORMAL_TEXCOORD,
+            numVertices, combinedVertexData.get());
+    loadedMeshGeometries[meshGeometryID].deviceBytes = totalNumValues * sizeof(float);
+    
+    if(loadedMeshGeometries[meshGeometryID].residencyPolicy != RESIDENCY_KEEP_HOST_COPY) {
+        loadedMeshGeometries[meshGeometryID].meshGeometryDataPtr.reset();
+    }
 }
 
-void MeshGeometryLoader::UnBufferMeshGeometryData(const unsigned int meshGeometryID) {
-    glDeleteBuffers(1, &(loadedMeshGeometries[meshGeometryID].meshVBO));
+void MeshGeometryLoader::UnBufferMeshGeometryData(const unsigned int meshGeometryID, const bool keepHostCopy) {
+    if(loadedMeshGeometries[meshGeometryID].vertexAllocationID == 0) {
+        return;
+    }
+    if(keepHostCopy && loadedMeshGeometries[meshGeometryID].residencyPolicy == RESIDENCY_REFETCH_HOST_COPY) {
+        EnsureHostResident(meshGeometryID);
+    }
+    GeometryHeap::FreeVertices(VERTEX_FORMAT_POSITION_NORMAL_TEXCOORD, loadedMeshGeometries[meshGeometryID].vertexAllocationID);
+    loadedMeshGeometries[meshGeometryID].vertexAllocationID = 0;
+    loadedMeshGeometries[meshGeometryID].deviceBytes = 0;
+}
+
+void MeshGeometryLoader::EnsureHostResident(const unsigned int meshGeometryID) {
+    MeshGeometryInfo& meshGeometryInfo = loadedMeshGeometries[meshGeometryID];
+    if(meshGeometryInfo.meshGeometryDataPtr.get() != nullptr) {
+        return;
+    }
+    if(meshGeometryInfo.residencyPolicy == RESIDENCY_DISCARD_HOST_COPY || meshGeometryInfo.vertexAllocationID == 0) {
+        throw MeshException("ERROR: System memory copy of mesh geometry " + std::to_string(meshGeometryID) + " was discarded.");
+    }
+    
+    // Read the interleaved vertex data back from the geometry heap
+    unsigned int numVertices = meshGeometryInfo.numVertices;
+    unsigned int stride = 3 + 3 + 2;
+    std::unique_ptr<float[]> combinedVertexData = std::unique_ptr<float[]>(new float[numVertices * stride]);
+    GeometryHeap::ReadVertices(VERTEX_FORMAT_POSITION_NORMAL_TEXCOORD, meshGeometryInfo.vertexAllocationID, combinedVertexData.get());
+    
+    std::vector<Math::Vec3f> vertices(numVertices);
+    std::vector<Math::Vec3f> normals(numVertices);
+    std::vector<Math::Vec2f> textureCoords(numVertices);
+    for(unsigned int i = 0; i < numVertices; i++) {
+        const float* vertexData = combinedVertexData.get() + i * stride;
+        vertices[i] = Math::createVec3<float>(vertexData[0], vertexData[1], vertexData[2]);
+        normals[i] = Math::createVec3<float>(vertexData[3], vertexData[4], vertexData[5]);
+        textureCoords[i] = Math::createVec2<float>(vertexData[6], vertexData[7]);
+    }
+    meshGeometryInfo.meshGeometryDataPtr = std::make_shared<MeshGeometryData>(SharedBuffer<Math::Vec3f>(std::move(vertices)),
+            SharedBuffer<Math::Vec3f>(std::move(normals)), SharedBuffer<Math::Vec2f>(std::move(textureCoords)));
 }
 
 void MeshGeometryLoader::UnloadMeshGeometry(const unsigned int meshGeometryID) {
@@ -180,8 +269,13 @@ void MeshGeometryLoader::UnloadMeshGeometry(const unsigned int meshGeometryID) {
     assert(meshGeometryID != 0 && meshGeometryID < spareID);
     assert(loadedMeshGeometries[meshGeometryID].usingCount == 0);
 #endif
+    releaseQueue.remove(meshGeometryID);
+    UnBufferMeshGeometryData(meshGeometryID, false);
     for(std::unordered_map<unsigned int, MeshGeometryInfo>::iterator iter = loadedMeshGeometries.begin(); iter != loadedMeshGeometries.end(); iter++) {
         if(iter->first == meshGeometryID) {
+            if(iter->second.modelFilePath != "") {
+                pathIndex.erase(iter->second.modelFilePath, meshGeometryID);
+            }
             availableIDStack.push(iter->first);
             loadedMeshGeometries.erase(iter);
             break;
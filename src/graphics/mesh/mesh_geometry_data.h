@@ -2,6 +2,12 @@
 #define MESH_GEOMETRY_DATA_H
 
 #include <math/vector.h>
+#include <fileio/path_index.h>
+#include <graphics/buffer/shared_buffer.h>
+#include <graphics/buffer/residency.h>
+#include <graphics/buffer/deferred_release_queue.h>
+#include <graphics/buffer/geometry_heap.h>
+#include <exceptions/render_exception.h>
 #include <vector>
 #include <memory>
 #include <cstring>
@@ -21,25 +27,36 @@ using VectorPtr = std::shared_ptr<std::vector<T>>;
 class MeshGeometryData {
     public:
         /*
-         * Shallow copies data by assigning to new mesh geometry.
+         * Shares the input buffers with the new mesh geometry.
          */
-        MeshGeometryData(const VectorPtr<Math::Vec3f> vertices, const VectorPtr<Math::Vec3f> normals, const VectorPtr<Math::Vec2f> textureCoords);
+        MeshGeometryData(const SharedBuffer<Math::Vec3f> vertices, const SharedBuffer<Math::Vec3f> normals, const SharedBuffer<Math::Vec2f> textureCoords);
         
         /*
-         * Deep copies data from input mesh geometry into new mesh geometry.
+         * Shares the buffers of the input mesh geometry with the new mesh geometry. Buffers are only copied when one of
+         * the mesh geometries mutates them.
          */
-        MeshGeometryData(const MeshGeometryData& meshGeometryData);
+        MeshGeometryData(const MeshGeometryData& meshGeometryData) = default;
         
-        VectorPtr<Math::Vec3f> getVertices() const { return vertices; }
-        void setVertices(const VectorPtr<Math::Vec3f> vertices) { this->vertices = vertices; }
-        VectorPtr<Math::Vec3f> getNormals() const { return normals; }
-        void setNormals(const VectorPtr<Math::Vec3f> normals) { this->normals = normals; }
-        VectorPtr<Math::Vec2f> getTextureCoords() const { return textureCoords; }
-        void setTextureCoords(const VectorPtr<Math::Vec2f> textureCoords) { this->textureCoords = textureCoords; }
+        const SharedBuffer<Math::Vec3f>& getVertices() const { return vertices; }
+        void setVertices(const SharedBuffer<Math::Vec3f> vertices) { this->vertices = vertices; }
+        const SharedBuffer<Math::Vec3f>& getNormals() const { return normals; }
+        void setNormals(const SharedBuffer<Math::Vec3f> normals) { this->normals = normals; }
+        const SharedBuffer<Math::Vec2f>& getTextureCoords() const { return textureCoords; }
+        void setTextureCoords(const SharedBuffer<Math::Vec2f> textureCoords) { this->textureCoords = textureCoords; }
+        
+        /*
+         * Returns writable pointers to the geometry buffers, copying a buffer first if it is shared.
+         */
+        Math::Vec3f* mutableVertices() { return vertices.mutableData(); }
+        Math::Vec3f* mutableNormals() { return normals.mutableData(); }
+        Math::Vec2f* mutableTextureCoords() { return textureCoords.mutableData(); }
+        
+        unsigned int getNumVertices() const { return vertices.getSize(); }
+        size_t getSizeInBytes() const { return vertices.getSizeInBytes() + normals.getSizeInBytes() + textureCoords.getSizeInBytes(); }
     private:
-        VectorPtr<Math::Vec3f> vertices;
-        VectorPtr<Math::Vec3f> normals;
-        VectorPtr<Math::Vec2f> textureCoords;
+        SharedBuffer<Math::Vec3f> vertices;
+        SharedBuffer<Math::Vec3f> normals;
+        SharedBuffer<Math::Vec2f> textureCoords;
 };
 typedef std::shared_ptr<MeshGeometryData> MeshGeometryDataPtr;
 
@@ -61,15 +78,16 @@ class MeshGeometryLoader {
         static MeshGeometryDataPtr GetMeshGeometryDataPtr(const unsigned int meshGeometryID);
         
         /*
-         * Binds mesh geometry about of be rendered.
+         * Returns the index of the first vertex of buffered mesh geometry with index meshGeometryID in the geometry
+         * heap, to be passed as base vertex when drawing.
          */
-        static void BindMeshGeometry(const unsigned int meshGeometryID);
+        static int GetBaseVertex(const unsigned int meshGeometryID);
         
         /*
-         * Deep copies mesh geometry with data given by MeshGeometryDataPtr into list of loaded mesh geometries. Returns the index
-         * of the mesh geometry from list of loaded mesh geometries. If modelFilePath is not empty and a MeshGeometryData is
-         * found in the list of loaded mesh geometries then the index to the loaded instance will be returned and the
-         * MeshGeometryDataPtr will not be added.
+         * Puts mesh geometry with data given by MeshGeometryDataPtr into list of loaded mesh geometries, sharing its
+         * buffers rather than copying them. Returns the index of the mesh geometry from list of loaded mesh geometries.
+         * If modelFilePath is not empty and a MeshGeometryData is found in the list of loaded mesh geometries then the
+         * index to the loaded instance will be returned and the MeshGeometryDataPtr will not be added.
          */
         static unsigned int LoadMeshFromMeshGeometryData(const MeshGeometryDataPtr meshGeometryDataPtr, const std::string modelFilePath = "");
         
@@ -91,14 +109,53 @@ class MeshGeometryLoader {
         
         /*
          * Decrements using buffered count for mesh geometry with index meshGeometryID from list of loaded mesh geometries.
+         * The mesh geometry stays buffered until it is reclaimed by ProcessDeferredReleases.
          */
         static void RelaxMeshGeometryBuffered(const unsigned int meshGeometryID);
         
         /*
-         * Returns a deep copy of the loaded mesh geometry data with index meshGeometryID from list of loaded mesh
-         * geometries.
+         * Unbuffers the relaxed mesh geometries that have gone unused for the release delay, or all relaxed mesh
+         * geometries if reclaimAll is true. Call once per frame, after MeshLoader::ProcessDeferredReleases.
+         */
+        static void ProcessDeferredReleases(const bool reclaimAll = false);
+        
+        static DeferredReleaseQueue& GetReleaseQueue() { return releaseQueue; }
+        
+        /*
+         * Returns a copy of the loaded mesh geometry data with index meshGeometryID from list of loaded mesh
+         * geometries. The copy shares its buffers with the loaded mesh geometry until either is mutated.
          */
         static MeshGeometryDataPtr CopyMeshGeometryDataFromLoaded(const unsigned int meshGeometryID);
+        
+        /*
+         * Returns the index used to find already loaded mesh geometries by model file path, for reading hit/miss
+         * counts.
+         */
+        static const PathIndex& GetPathIndex() { return pathIndex; }
+        
+        /*
+         * Sets the residency policy given to mesh geometries loaded from now on.
+         */
+        static void SetDefaultResidencyPolicy(const ResidencyPolicy residencyPolicy) { defaultResidencyPolicy = residencyPolicy; }
+        
+        /*
+         * Sets the residency policy of loaded mesh geometry with index meshGeometryID. Takes effect the next time the
+         * mesh geometry is buffered, or immediately if it is already buffered.
+         */
+        static void SetResidencyPolicy(const unsigned int meshGeometryID, const ResidencyPolicy residencyPolicy);
+        static ResidencyPolicy GetResidencyPolicy(const unsigned int meshGeometryID);
+        
+        /*
+         * Returns true if the system memory copy of mesh geometry with index meshGeometryID is currently held.
+         */
+        static bool IsHostResident(const unsigned int meshGeometryID);
+        
+        static unsigned int GetNumVertices(const unsigned int meshGeometryID);
+        
+        /*
+         * Returns the bytes held by all loaded mesh geometries in system memory and in OpenGL buffers.
+         */
+        static MemoryStats GetMemoryStats();
     private:
         /*
          * Buffers mesh geometry data to GPU from loaded mesh geometry list with index meshGeometryID.
@@ -106,9 +163,11 @@ class MeshGeometryLoader {
         static void BufferMeshGeometryData(const unsigned int meshGeometryID);
         
         /*
-         * Deletes OpenGL buffer of mesh geometry with index meshGeometryID from loaded mesh geometry list.
+         * Deletes OpenGL buffer of mesh geometry with index meshGeometryID from loaded mesh geometry list. The system
+         * memory copy is read back first if the residency policy asks for it and keepHostCopy is set; pass false when
+         * the mesh geometry is about to be unloaded.
          */
-        static void UnBufferMeshGeometryData(const unsigned int meshGeometryID);
+        static void UnBufferMeshGeometryData(const unsigned int meshGeometryID, const bool keepHostCopy);
         
         /*
          * Unloads loaded mesh geometry from system memory. Removes the mesh geometry from list of loaded mesh
@@ -116,17 +175,31 @@ class MeshGeometryLoader {
          */
         static void UnloadMeshGeometry(const unsigned int meshGeometryID);
         
+        /*
+         * Makes sure the system memory copy of mesh geometry with index meshGeometryID is held, reading it back from
+         * the OpenGL buffer if it was dropped. Throws MeshException if the copy was discarded and can't be fetched.
+         */
+        static void EnsureHostResident(const unsigned int meshGeometryID);
+        
         struct MeshGeometryInfo {
             std::string modelFilePath;
             MeshGeometryDataPtr meshGeometryDataPtr;
-            unsigned int meshVBO = 0;
+            // Allocation in the geometry heap, 0 while not buffered
+            unsigned int vertexAllocationID = 0;
             unsigned int usingCount = 0;
             unsigned int usingBufferedCount = 0;
+            ResidencyPolicy residencyPolicy = RESIDENCY_KEEP_HOST_COPY;
+            unsigned int numVertices = 0;
+            size_t deviceBytes = 0;
+            unsigned int timesBuffered = 0;
         };
         // CHANGE TO SINGLETON PATTERN TO ALLOW RESEARTING OF ENGINE!!!!!!!!!!!!
         static unsigned int spareID;
         static std::stack<unsigned int> availableIDStack;
         static std::unordered_map<unsigned int, MeshGeometryInfo> loadedMeshGeometries;
+        static PathIndex pathIndex;
+        static ResidencyPolicy defaultResidencyPolicy;
+        static DeferredReleaseQueue releaseQueue;
 };
 
 }
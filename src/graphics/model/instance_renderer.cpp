@@ -0,0 +1,121 @@
+#include "instance_renderer.h"
+#include <graphics/state/gl_state_cache.h>
+#include <exceptions/render_exception.h>
+#include <cstddef>
+
+namespace Engine {
+
+/*
+ * Class InstanceRenderer
+ */
+InstanceRenderer::InstanceRenderer(const unsigned int maxInstances)
+    : maxInstances(maxInstances), groups(), meshGroups(), instances(), instanceBuffer(maxInstances * sizeof(InstanceData)) {
+    instances.reserve(maxInstances);
+}
+
+void InstanceRenderer::addInstance(const Mesh& mesh, const Math::Mat4f& transform, const Math::Vec4f& customData) {
+    if(instances.size() >= maxInstances) {
+        throw MeshException("ERROR: Instance renderer is full, it holds at most " + std::to_string(maxInstances) + " instances per frame.");
+    }
+    std::vector<unsigned int>& groupIndices = meshGroups[mesh.getMeshID()];
+    unsigned int groupIndex = groups.size();
+    for(unsigned int i = 0; i < groupIndices.size(); i++) {
+        if(mesh.hasTexturedMaterialState(groups[groupIndices[i]].texturedMaterial)) {
+            groupIndex = groupIndices[i];
+            break;
+        }
+    }
+    if(groupIndex == groups.size()) {
+        groups.push_back({mesh.getMeshID(), mesh.getTexturedMaterial(), 0});
+        groupIndices.push_back(groupIndex);
+    }
+    groups[groupIndex].numInstances++;
+    instances.push_back({groupIndex, transform, customData});
+}
+
+void InstanceRenderer::addModelInstance(const Model& model, const Math::Mat4f& transform, const Math::Vec4f& customData) {
+    ModelDataPtr modelDataPtr = model.getModelDataPtr();
+    for(unsigned int i = 0; i < modelDataPtr->getNumMeshes(); i++) {
+        addInstance(modelDataPtr->getMesh(i), transform, customData);
+    }
+}
+
+void InstanceRenderer::render(const std::function<void(const TexturedMaterial&)>& applyMaterial) {
+    frameStats = InstancingStats();
+    if(instances.empty()) {
+        clear();
+        return;
+    }
+    
+    // Lay the instances out contiguously per group, keeping the order they were added in within each group
+    std::vector<unsigned int> groupOffsets(groups.size(), 0);
+    for(unsigned int i = 1; i < groups.size(); i++) {
+        groupOffsets[i] = groupOffsets[i - 1] + groups[i - 1].numInstances;
+    }
+    std::vector<unsigned int> writeOffsets(groupOffsets);
+    InstanceData* instanceData = (InstanceData*)instanceBuffer.beginWrite();
+    for(unsigned int i = 0; i < instances.size(); i++) {
+        const Instance& instance = instances[i];
+        InstanceData& data = instanceData[writeOffsets[instance.groupIndex]++];
+        // Math::Mat is row major while GLSL reads the columns from consecutive attributes
+        for(unsigned int row = 0; row < 4; row++) {
+            for(unsigned int col = 0; col < 4; col++) {
+                data.transform[col * 4 + row] = instance.transform[row][col];
+            }
+        }
+        for(unsigned int c = 0; c < 4; c++) {
+            data.customData[c] = instance.customData[c];
+        }
+    }
+    instanceBuffer.endWrite(instances.size() * sizeof(InstanceData));
+    
+    for(unsigned int i = 0; i < groups.size(); i++) {
+        const Group& group = groups[i];
+        MeshLoader::BindMesh(group.meshID);
+        applyMaterial(group.texturedMaterial);
+        // Attribute offsets start at the group's first instance, so no base instance is needed
+        size_t groupOffset = instanceBuffer.getRegionOffset() + groupOffsets[i] * sizeof(InstanceData);
+        GLStateCache::BindBuffer(GL_ARRAY_BUFFER, instanceBuffer.getBufferName());
+        for(GLuint column = 0; column < 4; column++) {
+            GLuint location = TRANSFORM_ATTRIBUTE_LOCATION + column;
+            glVertexAttribPointer(location, 4, GL_FLOAT, GL_FALSE, sizeof(InstanceData), (void*)(groupOffset + column * 4 * sizeof(float)));
+            glEnableVertexAttribArray(location);
+            glVertexAttribDivisor(location, 1);
+        }
+        glVertexAttribPointer(CUSTOM_DATA_ATTRIBUTE_LOCATION, 4, GL_FLOAT, GL_FALSE, sizeof(InstanceData),
+                (void*)(groupOffset + offsetof(InstanceData, customData)));
+        glEnableVertexAttribArray(CUSTOM_DATA_ATTRIBUTE_LOCATION);
+        glVertexAttribDivisor(CUSTOM_DATA_ATTRIBUTE_LOCATION, 1);
+        GLStateCache::BindBuffer(GL_ARRAY_BUFFER, 0);
+        
+        MeshDrawRange drawRange = MeshLoader::GetDrawRange(group.meshID);
+        if(drawRange.numIndices > 0) {
+            glDrawElementsInstancedBaseVertex(GL_TRIANGLES, drawRange.numIndices, GL_UNSIGNED_INT,
+                    (void*)(drawRange.firstIndex * sizeof(unsigned int)), group.numInstances, drawRange.baseVertex);
+            frameStats.numDrawCalls++;
+        }
+    }
+    // The vertex arrays are shared with meshes drawn one at a time, which don't have the instance attributes
+    for(GLuint location = TRANSFORM_ATTRIBUTE_LOCATION; location <= CUSTOM_DATA_ATTRIBUTE_LOCATION; location++) {
+        glDisableVertexAttribArray(location);
+    }
+    instanceBuffer.fenceRegion();
+    
+    frameStats.numInstances = instances.size();
+    totalStats.numInstances += frameStats.numInstances;
+    totalStats.numDrawCalls += frameStats.numDrawCalls;
+    clear();
+}
+
+void InstanceRenderer::destroy() {
+    clear();
+    instanceBuffer.destroy();
+}
+
+void InstanceRenderer::clear() {
+    groups.clear();
+    meshGroups.clear();
+    instances.clear();
+}
+
+}
@@ -0,0 +1,119 @@
+#ifndef INSTANCE_RENDERER_H
+#define INSTANCE_RENDERER_H
+
+#include <graphics/model/model.h>
+#include <graphics/buffer/persistent_mapped_buffer.h>
+#include <math/matrix.h>
+#include <math/vector.h>
+#include <vector>
+#include <unordered_map>
+#include <functional>
+
+#include <glad/glad.h>
+
+namespace Engine {
+
+/*
+ * Per-instance data read by the vertex shader through instanced attributes. The transform is stored column major and
+ * customData is free for the shader to interpret (e.g. a tint or an animation phase).
+ */
+struct InstanceData {
+    float transform[16];
+    float customData[4];
+};
+
+/*
+ * Counts of instances drawn and the draw calls used to draw them.
+ */
+struct InstancingStats {
+    unsigned long long numInstances = 0;
+    unsigned long long numDrawCalls = 0;
+    
+    /*
+     * Returns the average number of instances drawn per draw call, 1 meaning nothing was instanced.
+     */
+    float getInstancingRatio() const { return numDrawCalls == 0 ? 0.0f : (float)numInstances / (float)numDrawCalls; }
+};
+
+/*
+ * InstanceRenderer collects the instances of meshes and models added during a frame and draws all instances of the same
+ * mesh with the same material state with a single glDrawElementsInstancedBaseVertex call. The instance data is streamed
+ * through a persistently mapped buffer and read by the vertex shader from attribute locations 3 to 7 (see
+ * instanced_vertex_shader.vs.glsl).
+ *
+ * Usage per frame: addInstance() or addModelInstance() for each visible instance, then render().
+ */
+class InstanceRenderer {
+    public:
+        /*
+         * Creates a renderer drawing up to maxInstances instances per frame.
+         */
+        InstanceRenderer(const unsigned int maxInstances);
+        
+        /*
+         * Adds an instance of mesh. Throws MeshException if maxInstances instances have already been added this frame.
+         */
+        void addInstance(const Mesh& mesh, const Math::Mat4f& transform, const Math::Vec4f& customData = Math::Vec4f(0.0f));
+        
+        /*
+         * Adds an instance of every mesh of model.
+         */
+        void addModelInstance(const Model& model, const Math::Mat4f& transform, const Math::Vec4f& customData = Math::Vec4f(0.0f));
+        
+        /*
+         * Draws the instances added since the last call, one draw call per mesh and material state. applyMaterial is
+         * called before each draw call to apply the material and set any other uniforms.
+         */
+        void render(const std::function<void(const TexturedMaterial&)>& applyMaterial);
+        
+        /*
+         * Deletes the OpenGL buffer.
+         */
+        void destroy();
+        
+        unsigned int getNumInstances() const { return instances.size(); }
+        unsigned int getNumGroups() const { return groups.size(); }
+        unsigned int getMaxInstances() const { return maxInstances; }
+        const PersistentMappedBuffer& getInstanceBuffer() const { return instanceBuffer; }
+        
+        /*
+         * Returns the stats of the last render() call.
+         */
+        const InstancingStats& getFrameStats() const { return frameStats; }
+        
+        /*
+         * Returns the stats accumulated over all render() calls since the last resetStats().
+         */
+        const InstancingStats& getTotalStats() const { return totalStats; }
+        void resetStats() { frameStats = InstancingStats(); totalStats = InstancingStats(); }
+        
+        // Attribute location of the first column of the instance transform, followed by the custom data
+        static const GLuint TRANSFORM_ATTRIBUTE_LOCATION = 3;
+        static const GLuint CUSTOM_DATA_ATTRIBUTE_LOCATION = 7;
+    private:
+        struct Group {
+            unsigned int meshID;
+            TexturedMaterial texturedMaterial;
+            unsigned int numInstances;
+        };
+        struct Instance {
+            unsigned int groupIndex;
+            Math::Mat4f transform;
+            Math::Vec4f customData;
+        };
+        
+        void clear();
+        
+        unsigned int maxInstances;
+        std::vector<Group> groups;
+        // Indices of the groups of each mesh, one per distinct material state
+        std::unordered_map<unsigned int, std::vector<unsigned int>> meshGroups;
+        std::vector<Instance> instances;
+        PersistentMappedBuffer instanceBuffer;
+        InstancingStats frameStats;
+        InstancingStats totalStats;
+};
+
+}
+
+#endif //INSTANCE_RENDERER_H
@@ -0,0 +1,217 @@
+#include "material_atlas_baker.h"
+#include <algorithm>
+#include <cassert>
+
+namespace Engine {
+
+/*
+ * Class MaterialAtlasBaker
+ */
+MaterialAtlasBaker::MaterialAtlasBaker(const unsigned int maxPageSize, const unsigned int numMipLevels, const unsigned int gutter)
+    : maxPageSize(maxPageSize), numMipLevels(numMipLevels), gutter(gutter), sources() {}
+
+unsigned int MaterialAtlasBaker::addMesh(const Mesh& mesh) {
+    sources.push_back({mesh, mesh.getTexturedMaterial()});
+    return sources.size() - 1;
+}
+
+unsigned int MaterialAtlasBaker::addModel(const Model& model) {
+    unsigned int firstSourceIndex = sources.size();
+    ModelDataPtr modelDataPtr = model.getModelDataPtr();
+    for(unsigned int i = 0; i < modelDataPtr->getNumMeshes(); i++) {
+        addMesh(modelDataPtr->getMesh(i));
+    }
+    return firstSourceIndex;
+}
+
+std::vector<Mesh> MaterialAtlasBaker::build() {
+    stats = MaterialAtlasStats();
+    
+    // Group the textured sources that could share an atlas, keeping the order they were added in
+    std::vector<std::vector<unsigned int>> atlasGroups;
+    for(unsigned int i = 0; i < sources.size(); i++) {
+        if(sources[i].texturedMaterial.getTextures().empty()) {
+            continue;
+        }
+        unsigned int groupIndex = 0;
+        while(groupIndex < atlasGroups.size() && !CanShareAtlas(sources[atlasGroups[groupIndex][0]], sources[i])) {
+            groupIndex++;
+        }
+        if(groupIndex == atlasGroups.size()) {
+            atlasGroups.push_back(std::vector<unsigned int>());
+        }
+        atlasGroups[groupIndex].push_back(i);
+    }
+    
+    std::vector<MeshDataPtr> atlasMeshDataPtrs(sources.size());
+    std::vector<TexturedMaterial> atlasMaterials(sources.size());
+    const MipmapSettings& mipmapSettings = TextureLoader::GetMipmapSettings();
+    for(unsigned int g = 0; g < atlasGroups.size(); g++) {
+        const std::vector<unsigned int>& group = atlasGroups[g];
+        const TexturedMaterial& groupMaterial = sources[group[0]].texturedMaterial;
+        std::vector<Texture> groupTextures = groupMaterial.getTextures();
+        TextureAtlasBuilder builder(groupTextures.size(), maxPageSize, numMipLevels, gutter);
+        
+        // Sources using the same textures share an entry
+        std::vector<std::vector<unsigned int>> entryTextureIDs;
+        std::vector<unsigned int> atlasedSources;
+        std::vector<unsigned int> sourceEntries;
+        for(unsigned int i = 0; i < group.size(); i++) {
+            std::vector<TextureDataPtr> textureDataPtrs = getAtlasTextures(sources[group[i]], builder);
+            if(textureDataPtrs.empty()) {
+                continue;
+            }
+            std::vector<Texture> textures = sources[group[i]].texturedMaterial.getTextures();
+            std::vector<unsigned int> textureIDs;
+            for(unsigned int slot = 0; slot < textures.size(); slot++) {
+                textureIDs.push_back(textures[slot].getTextureID());
+            }
+            unsigned int entry = std::find(entryTextureIDs.begin(), entryTextureIDs.end(), textureIDs) - entryTextureIDs.begin();
+            if(entry == entryTextureIDs.size()) {
+                entryTextureIDs.push_back(textureIDs);
+                builder.addEntry(textureDataPtrs);
+            }
+            atlasedSources.push_back(group[i]);
+            sourceEntries.push_back(entry);
+        }
+        // A single set of textures is bound once already
+        if(entryTextureIDs.size() < 2) {
+            continue;
+        }
+        
+        TextureAtlas atlas = builder.build(mipmapSettings.filter, mipmapSettings.sRGB);
+        std::vector<TexturedMaterial> pageMaterials;
+        for(unsigned int page = 0; page < atlas.getNumPages(); page++) {
+            std::vector<Texture> pageTextures;
+            for(unsigned int slot = 0; slot < groupTextures.size(); slot++) {
+                pageTextures.push_back(Texture(atlas.pages[slot][page], groupTextures[slot].getType()));
+                TextureLoader::SetSamplerDescription(pageTextures[slot].getTextureID(), TextureLoader::GetSamplerDescription(groupTextures[slot].getTextureID()));
+            }
+            TexturedMaterial pageMaterial(groupMaterial.getShaderProgramPtr(), pageTextures, groupMaterial.getTextureMixingWeights());
+            pageMaterial.setFallbackShaderProgramPtr(groupMaterial.getFallbackShaderProgramPtr());
+            pageMaterial.setMaxAnisotropy(groupMaterial.getMaxAnisotropy());
+            pageMaterial.setLodBias(groupMaterial.getLodBias());
+            pageMaterials.push_back(pageMaterial);
+        }
+        for(unsigned int i = 0; i < atlasedSources.size(); i++) {
+            const AtlasRegion& region = atlas.regions[sourceEntries[i]];
+            atlasMeshDataPtrs[atlasedSources[i]] = RemapTextureCoords(sources[atlasedSources[i]].mesh.getMeshDataPtr(), region);
+            atlasMaterials[atlasedSources[i]] = pageMaterials[region.page];
+        }
+        stats.numSourceMaterials += entryTextureIDs.size();
+        stats.numAtlasMaterials += pageMaterials.size();
+        stats.numAtlasedMeshes += atlasedSources.size();
+    }
+    stats.numUnchangedMeshes = sources.size() - stats.numAtlasedMeshes;
+    
+    std::vector<Mesh> meshes;
+    meshes.reserve(sources.size());
+    for(unsigned int i = 0; i < sources.size(); i++) {
+        if(atlasMeshDataPtrs[i] != nullptr) {
+            meshes.push_back(Mesh(atlasMeshDataPtrs[i], atlasMaterials[i], sources[i].mesh.getUnTexturedMaterial()));
+        }
+        else {
+            meshes.push_back(sources[i].mesh);
+        }
+    }
+    sources.clear();
+    return meshes;
+}
+
+bool MaterialAtlasBaker::HasUnitTextureCoords(const MeshData& meshData) {
+    // Allow for rounding in exported texture coordinates
+    const float epsilon = 1e-4f;
+    const SharedBuffer<unsigned int>& indices = meshData.getIndices();
+    const SharedBuffer<Math::Vec2f>& textureCoords = meshData.getMeshGeometryDataPtr()->getTextureCoords();
+    for(unsigned int i = 0; i < indices.getSize(); i++) {
+        for(unsigned int c = 0; c < 2; c++) {
+            if(textureCoords[indices[i]][c] < -epsilon || textureCoords[indices[i]][c] > 1.0f + epsilon) {
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+bool MaterialAtlasBaker::CanShareAtlas(const Source& source, const Source& other) {
+    const TexturedMaterial& material = source.texturedMaterial;
+    const TexturedMaterial& otherMaterial = other.texturedMaterial;
+    std::vector<Texture> textures = material.getTextures();
+    std::vector<Texture> otherTextures = otherMaterial.getTextures();
+    if(material.getShaderProgramPtr() != otherMaterial.getShaderProgramPtr() || material.getFallbackShaderProgramPtr() != otherMaterial.getFallbackShaderProgramPtr()
+            || textures.size() != otherTextures.size()
+            || material.getTextureMixingWeights() != otherMaterial.getTextureMixingWeights() || material.getMaxAnisotropy() != otherMaterial.getMaxAnisotropy()
+            || material.getLodBias() != otherMaterial.getLodBias()) {
+        return false;
+    }
+    for(unsigned int i = 0; i < textures.size(); i++) {
+        if(textures[i].getType() != otherTextures[i].getType()
+                || TextureLoader::GetSamplerDescription(textures[i].getTextureID()) != TextureLoader::GetSamplerDescription(otherTextures[i].getTextureID())) {
+            return false;
+        }
+    }
+    return true;
+}
+
+std::vector<TextureDataPtr> MaterialAtlasBaker::getAtlasTextures(const Source& source, const TextureAtlasBuilder& builder) const {
+    std::vector<Texture> textures = source.texturedMaterial.getTextures();
+    for(unsigned int i = 0; i < textures.size(); i++) {
+        // The placeholder of a texture still loading would be baked in for good
+        if(TextureLoader::IsAsyncLoadPending(textures[i].getTextureID())) {
+            return std::vector<TextureDataPtr>();
+        }
+    }
+    if(!HasUnitTextureCoords(*source.mesh.getMeshDataPtr())) {
+        return std::vector<TextureDataPtr>();
+    }
+    std::vector<TextureDataPtr> textureDataPtrs;
+    for(unsigned int i = 0; i < textures.size(); i++) {
+        textureDataPtrs.push_back(textures[i].getTextureDataPtr());
+    }
+    if(!builder.canAdd(textureDataPtrs)) {
+        return std::vector<TextureDataPtr>();
+    }
+    return textureDataPtrs;
+}
+
+MeshDataPtr MaterialAtlasBaker::RemapTextureCoords(const MeshDataPtr meshDataPtr, const AtlasRegion& region) {
+    MeshGeometryDataPtr sourceGeometryDataPtr = meshDataPtr->getMeshGeometryDataPtr();
+    std::vector<unsigned int> localIndices;
+    std::vector<unsigned int> referencedVertices = meshDataPtr->getReferencedVertices(localIndices);
+    SharedBuffer<unsigned int> indices = meshDataPtr->getIndices();
+    MeshGeometryDataPtr meshGeometryDataPtr;
+    if(referencedVertices.size() == sourceGeometryDataPtr->getNumVertices()) {
+        // The vertices and normals stay shared with the source mesh
+        meshGeometryDataPtr = std::make_shared<MeshGeometryData>(*sourceGeometryDataPtr);
+    }
+    else {
+        // The meshes of a model share one geometry, so only the vertices this mesh uses are copied
+        const SharedBuffer<Math::Vec3f>& sourceVertices = sourceGeometryDataPtr->getVertices();
+        const SharedBuffer<Math::Vec3f>& sourceNormals = sourceGeometryDataPtr->getNormals();
+        const SharedBuffer<Math::Vec2f>& sourceTextureCoords = sourceGeometryDataPtr->getTextureCoords();
+        std::vector<Math::Vec3f> vertices;
+        std::vector<Math::Vec3f> normals;
+        std::vector<Math::Vec2f> textureCoords;
+        vertices.reserve(referencedVertices.size());
+        normals.reserve(referencedVertices.size());
+        textureCoords.reserve(referencedVertices.size());
+        for(unsigned int i = 0; i < referencedVertices.size(); i++) {
+            vertices.push_back(sourceVertices[referencedVertices[i]]);
+            normals.push_back(sourceNormals[referencedVertices[i]]);
+            textureCoords.push_back(sourceTextureCoords[referencedVertices[i]]);
+        }
+        meshGeometryDataPtr = std::make_shared<MeshGeometryData>(SharedBuffer<Math::Vec3f>(std::move(vertices)),
+                SharedBuffer<Math::Vec3f>(std::move(normals)), SharedBuffer<Math::Vec2f>(std::move(textureCoords)));
+        indices = SharedBuffer<unsigned int>(std::move(localIndices));
+    }
+    unsigned int numTextureCoords = meshGeometryDataPtr->getTextureCoords().getSize();
+    Math::Vec2f* textureCoords = meshGeometryDataPtr->mutableTextureCoords();
+    for(unsigned int i = 0; i < numTextureCoords; i++) {
+        for(unsigned int c = 0; c < 2; c++) {
+            textureCoords[i][c] = region.uvOffset[c] + std::clamp(textureCoords[i][c], 0.0f, 1.0f) * region.uvScale[c];
+        }
+    }
+    return std::make_shared<MeshData>(indices, meshGeometryDataPtr);
+}
+
+}
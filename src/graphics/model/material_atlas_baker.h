@@ -0,0 +1,92 @@
+#ifndef MATERIAL_ATLAS_BAKER_H
+#define MATERIAL_ATLAS_BAKER_H
+
+#include <graphics/model/model.h>
+#include <graphics/texture/texture_atlas.h>
+#include <math/vector.h>
+#include <vector>
+
+namespace Engine {
+
+struct MaterialAtlasStats {
+    // Distinct textured materials of the meshes moved into atlases
+    unsigned int numSourceMaterials = 0;
+    // Materials the atlased meshes use afterwards, one per page
+    unsigned int numAtlasMaterials = 0;
+    unsigned int numAtlasedMeshes = 0;
+    // Meshes left as they were, because their textures or texture coordinates can't be atlased
+    unsigned int numUnchangedMeshes = 0;
+};
+
+/*
+ * MaterialAtlasBaker moves the textures of meshes whose materials only differ in their textures into shared
+ * TextureAtlas pages at load time, and rewrites the meshes' texture coordinates to match. Meshes on the same page then
+ * share one material, so StaticBatcher merges them into one batch and drawing them binds their textures once.
+ *
+ * Meshes are grouped by shader program, texture types, mixing weights and sampling. A mesh is left unchanged if it
+ * has no textures, its textures differ in size, aren't uncompressed 8-bit images or are still loading, or its texture
+ * coordinates leave [0, 1] (tiling textures can't repeat inside an atlas).
+ */
+class MaterialAtlasBaker {
+    public:
+        MaterialAtlasBaker(const unsigned int maxPageSize = 2048, const unsigned int numMipLevels = 4, const unsigned int gutter = 8);
+        
+        /*
+         * Adds mesh. Returns the source index of the mesh.
+         */
+        unsigned int addMesh(const Mesh& mesh);
+        
+        /*
+         * Adds every mesh of model. Returns the source index of the first mesh.
+         */
+        unsigned int addModel(const Model& model);
+        
+        /*
+         * Atlases the meshes added since the last build and clears the baker. Returns a mesh for each source, in the
+         * order they were added, using the atlas pages where they could be moved into one.
+         */
+        std::vector<Mesh> build();
+        
+        unsigned int getNumSources() const { return sources.size(); }
+        
+        /*
+         * Returns the counts of the last build.
+         */
+        const MaterialAtlasStats& getStats() const { return stats; }
+        
+        /*
+         * Returns true if every texture coordinate the indices of meshData reference lies in [0, 1].
+         */
+        static bool HasUnitTextureCoords(const MeshData& meshData);
+    private:
+        struct Source {
+            Mesh mesh;
+            TexturedMaterial texturedMaterial;
+        };
+        
+        /*
+         * Returns true if source uses the same shader program, texture types, mixing weights and sampling as other, so
+         * both may share an atlas.
+         */
+        static bool CanShareAtlas(const Source& source, const Source& other);
+        
+        /*
+         * Returns the host copies of the textures of source, or an empty list if it can't be atlased.
+         */
+        std::vector<TextureDataPtr> getAtlasTextures(const Source& source, const TextureAtlasBuilder& builder) const;
+        
+        /*
+         * Returns a copy of meshDataPtr whose texture coordinates are mapped into region.
+         */
+        static MeshDataPtr RemapTextureCoords(const MeshDataPtr meshDataPtr, const AtlasRegion& region);
+        
+        unsigned int maxPageSize;
+        unsigned int numMipLevels;
+        unsigned int gutter;
+        std::vector<Source> sources;
+        MaterialAtlasStats stats;
+};
+
+}
+
+#endif //MATERIAL_ATLAS_BAKER_H
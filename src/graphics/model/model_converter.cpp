@@ -14,7 +14,37 @@ Engine::ModelDataPtr ColladaModelConverter::getModelDataPtr() const {
     return modelDataPtr;
 }
 
+std::shared_future<Engine::ModelDataPtr> ColladaModelConverter::LoadModelDataAsync(const std::string& colladaFilePath) {
+    std::shared_ptr<std::promise<Engine::ModelDataPtr>> promisePtr = std::make_shared<std::promise<Engine::ModelDataPtr>>();
+    std::shared_future<Engine::ModelDataPtr> modelDataFuture = promisePtr->get_future().share();
+    Engine::AsyncLoader::Submit<void>([colladaFilePath, promisePtr]() mutable {
+        std::shared_ptr<ParsedColladaModel> parsedModelPtr = std::make_shared<ParsedColladaModel>();
+        try {
+            ColladaModelConverter colladaModelConverter;
+            *parsedModelPtr = colladaModelConverter.parseColladaFile(colladaFilePath);
+        }
+        catch(...) {
+            promisePtr->set_exception(std::current_exception());
+            return;
+        }
+        // Hand the promise over so that the model data is only ever released on the main thread
+        Engine::AsyncLoader::QueueOnMainThread([promisePtr = std::move(promisePtr), parsedModelPtr = std::move(parsedModelPtr)]() {
+            try {
+                promisePtr->set_value(CreateModelData(*parsedModelPtr));
+            }
+            catch(...) {
+                promisePtr->set_exception(std::current_exception());
+            }
+        });
+    });
+    return modelDataFuture;
+}
+
 Engine::ModelDataPtr ColladaModelConverter::createModelDataFromCollada(const std::string& colladaFilePath) {
+    return CreateModelData(parseColladaFile(colladaFilePath));
+}
+
+ColladaModelConverter::ParsedColladaModel ColladaModelConverter::parseColladaFile(const std::string& colladaFilePath) {
     xmlParser = XmlParser(colladaFilePath);
     XmlNodePtr library_geometries = xmlParser.getTopNode()->getChild("library_geometries");
     XmlNodePtr library_effects = xmlParser.getTopNode()->getChild("library_effects");
@@ -35,12 +65,18 @@ Engine::ModelDataPtr ColladaModelConverter::createModelDataFromCollada(const std
 //        startIndex++;
 //    }
     
-    Engine::ModelDataPtr modelDataPtr;
-    Engine::MeshGeometryDataPtr meshGeometryDataPtr = createMeshGeometryData(vertexGroupDataList);
-    std::vector<Engine::Mesh> meshes;
+    ParsedColladaModel parsedModel;
+    parsedModel.meshGeometryDataPtr = createMeshGeometryData(vertexGroupDataList);
     for(unsigned int i = 0; i < indexMeshes->size(); i++) {
-        Engine::VectorPtr<unsigned int> indices = (*(indexMeshes.get()))[i].indices;
-        Engine::MeshDataPtr meshDataPtr = std::make_shared<Engine::MeshData>(indices, meshGeometryDataPtr, "");
+        parsedModel.meshIndices.push_back(Engine::SharedBuffer<unsigned int>(std::move(*((*(indexMeshes.get()))[i].indices))));
+    }
+    return parsedModel;
+}
+
+Engine::ModelDataPtr ColladaModelConverter::CreateModelData(const ParsedColladaModel& parsedModel) {
+    std::vector<Engine::Mesh> meshes;
+    for(unsigned int i = 0; i < parsedModel.meshIndices.size(); i++) {
+        Engine::MeshDataPtr meshDataPtr = std::make_shared<Engine::MeshData>(parsedModel.meshIndices[i], parsedModel.meshGeometryDataPtr, "");
         
 //        DEAL WITH TEXTURES/MATERIALS FROM COLLAD MODEL FILE
         Engine::TexturedMaterial texturedMaterial;
@@ -50,8 +86,7 @@ Engine::ModelDataPtr ColladaModelConverter::createModelDataFromCollada(const std
         meshes.push_back(mesh);
     }
     
-    modelDataPtr = std::make_shared<Engine::ModelData>(meshes);
-    return modelDataPtr;
+    return std::make_shared<Engine::ModelData>(meshes);
 }
 
 unsigned int ColladaModelConverter::addVertexGroup(const VectorPtr<VertexGroupData> vertexGroupDataList, VertexGroupData vertexGroupData) {
@@ -229,15 +264,21 @@ void ColladaModelConverter::parseColladaIndexArray(const XmlNodePtr xmlTriangles
 
 Engine::MeshGeometryDataPtr ColladaModelConverter::createMeshGeometryData(const VectorPtr<VertexGroupData> vertexGroups) {
     unsigned int numVertices = vertexGroups->size();
-    Engine::VectorPtr<Engine::Math::Vec3f> vertices = std::make_shared<std::vector<Engine::Math::Vec3f>>();
-    Engine::VectorPtr<Engine::Math::Vec3f> normals = std::make_shared<std::vector<Engine::Math::Vec3f>>();
-    Engine::VectorPtr<Engine::Math::Vec2f> textureCoords = std::make_shared<std::vector<Engine::Math::Vec2f>>();
+    std::vector<Engine::Math::Vec3f> vertices;
+    std::vector<Engine::Math::Vec3f> normals;
+    std::vector<Engine::Math::Vec2f> textureCoords;
+    vertices.reserve(numVertices);
+    normals.reserve(numVertices);
+    textureCoords.reserve(numVertices);
     for(unsigned int i = 0; i < numVertices; i++) {
-        vertices->push_back((*(vertexGroups.get()))[i].vertex);
-        normals->push_back((*(vertexGroups.get()))[i].normal);
-        textureCoords->push_back((*(vertexGroups.get()))[i].texCoord);
+        vertices.push_back((*(vertexGroups.get()))[i].vertex);
+        normals.push_back((*(vertexGroups.get()))[i].normal);
+        textureCoords.push_back((*(vertexGroups.get()))[i].texCoord);
     }
-    Engine::MeshGeometryDataPtr meshGeometryDataPtr = std::make_shared<Engine::MeshGeometryData>(vertices, normals, textureCoords);
+    Engine::MeshGeometryDataPtr meshGeometryDataPtr = std::make_shared<Engine::MeshGeometryData>(
+            Engine::SharedBuffer<Engine::Math::Vec3f>(std::move(vertices)),
+            Engine::SharedBuffer<Engine::Math::Vec3f>(std::move(normals)),
+            Engine::SharedBuffer<Engine::Math::Vec2f>(std::move(textureCoords)));
     return meshGeometryDataPtr;
 }
 
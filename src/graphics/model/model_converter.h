@@ -3,7 +3,9 @@
 
 #include <graphics/model/model.h>
 #include <fileio/xml/xml_parser.h>
+#include <fileio/async_loader.h>
 #include <vector>
+#include <future>
 #include <cassert>
 
 namespace Utility {
@@ -15,6 +17,13 @@ class ColladaModelConverter {
         
         std::string getColladaFilePath() const { return colladaFilePath; }
         Engine::ModelDataPtr getModelDataPtr() const;
+        
+        /*
+         * Parses the Collada file on an AsyncLoader worker thread and creates its model data on the main thread during
+         * AsyncLoader::ProcessMainThreadTasks. The returned future holds the model data, or the exception thrown while
+         * loading it.
+         */
+        static std::shared_future<Engine::ModelDataPtr> LoadModelDataAsync(const std::string& colladaFilePath);
     private:
         template<typename T>
         using VectorPtr = std::shared_ptr<std::vector<T>>;
@@ -29,6 +38,14 @@ class ColladaModelConverter {
             VectorPtr<unsigned int> indices;
         };
         
+        /*
+         * Geometry parsed from a Collada file that hasn't been loaded into the mesh loaders yet.
+         */
+        struct ParsedColladaModel {
+            Engine::MeshGeometryDataPtr meshGeometryDataPtr;
+            std::vector<Engine::SharedBuffer<unsigned int>> meshIndices;
+        };
+        
         /*
          * Assumes that mesh indices in Collada file are formatted to form triangles.
          * Assumes mesh geometry in Collada file has positions, normals, and a mesh map.
@@ -37,6 +54,16 @@ class ColladaModelConverter {
          */
         Engine::ModelDataPtr createModelDataFromCollada(const std::string& colladaFilePath);
         
+        /*
+         * Reads and parses the Collada file without touching the loaders or OpenGL, so it can run on a worker thread.
+         */
+        ParsedColladaModel parseColladaFile(const std::string& colladaFilePath);
+        
+        /*
+         * Loads the parsed meshes into the loaders. Must run on the main thread.
+         */
+        static Engine::ModelDataPtr CreateModelData(const ParsedColladaModel& parsedModel);
+        
         /*
          * Searches vertexGroupDataList for the vertex group and adds it if not found. Returns the index of the vertex group in the list.
          */
@@ -26,6 +26,12 @@ class ModelData {
         ModelData(const ModelData& modelData);
         
         std::vector<Mesh> getMeshes() const { return meshes; }
+        
+        /*
+         * Accesses a mesh without copying it, which would increment the usage counts of its mesh and textures.
+         */
+        const Mesh& getMesh(const unsigned int meshIndex) const { return meshes[meshIndex]; }
+        unsigned int getNumMeshes() const { return meshes.size(); }
         void setMeshes(const std::vector<Mesh> meshes) { this->meshes = meshes; }
     private:
         std::vector<Mesh> meshes;
@@ -0,0 +1,188 @@
+#include "static_batcher.h"
+#include <algorithm>
+#include <cmath>
+#include <cassert>
+
+namespace Engine {
+
+/*
+ * Class StaticBatcher
+ */
+StaticBatcher::StaticBatcher(const unsigned int maxVerticesPerBatch, const unsigned int maxIndicesPerBatch)
+    : maxVerticesPerBatch(maxVerticesPerBatch), maxIndicesPerBatch(maxIndicesPerBatch), sources() {}
+
+unsigned int StaticBatcher::addMesh(const Mesh& mesh, const Math::Mat4f& transform) {
+    sources.push_back({mesh.getMeshDataPtr(), mesh.getTexturedMaterial(), mesh.getUnTexturedMaterial(), transform});
+    return sources.size() - 1;
+}
+
+unsigned int StaticBatcher::addModel(const Model& model, const Math::Mat4f& transform) {
+    unsigned int firstSourceIndex = sources.size();
+    ModelDataPtr modelDataPtr = model.getModelDataPtr();
+    for(unsigned int i = 0; i < modelDataPtr->getNumMeshes(); i++) {
+        addMesh(modelDataPtr->getMesh(i), transform);
+    }
+    return firstSourceIndex;
+}
+
+std::vector<StaticBatch> StaticBatcher::build() {
+    // Group the sources by material state, keeping the order they were added in
+    std::vector<std::vector<unsigned int>> materialGroups;
+    for(unsigned int i = 0; i < sources.size(); i++) {
+        unsigned int groupIndex = 0;
+        while(groupIndex < materialGroups.size() && !sources[materialGroups[groupIndex][0]].texturedMaterial.hasSameState(sources[i].texturedMaterial)) {
+            groupIndex++;
+        }
+        if(groupIndex == materialGroups.size()) {
+            materialGroups.push_back(std::vector<unsigned int>());
+        }
+        materialGroups[groupIndex].push_back(i);
+    }
+    
+    std::vector<StaticBatch> batches;
+    for(unsigned int g = 0; g < materialGroups.size(); g++) {
+        const std::vector<unsigned int>& group = materialGroups[g];
+        unsigned int i = 0;
+        while(i < group.size()) {
+            StaticBatch batch;
+            batch.texturedMaterial = sources[group[i]].texturedMaterial;
+            batch.unTexturedMaterial = sources[group[i]].unTexturedMaterial;
+            std::vector<Math::Vec3f> vertices;
+            std::vector<Math::Vec3f> normals;
+            std::vector<Math::Vec2f> textureCoords;
+            std::vector<unsigned int> indices;
+            // A source larger than the limits still gets a batch of its own
+            while(i < group.size()) {
+                // The meshes of a model share one geometry, so only the vertices this mesh uses are copied
+                std::vector<unsigned int> localIndices;
+                std::vector<unsigned int> referencedVertices = sources[group[i]].meshDataPtr->getReferencedVertices(localIndices);
+                if(!batch.sourceRanges.empty() && (vertices.size() + referencedVertices.size() > maxVerticesPerBatch
+                        || indices.size() + localIndices.size() > maxIndicesPerBatch)) {
+                    break;
+                }
+                StaticBatchRange range;
+                range.sourceIndex = group[i];
+                appendSource(group[i], referencedVertices, localIndices, vertices, normals, textureCoords, indices, range);
+                batch.sourceRanges.push_back(range);
+                i++;
+            }
+            MeshGeometryDataPtr meshGeometryDataPtr = std::make_shared<MeshGeometryData>(SharedBuffer<Math::Vec3f>(std::move(vertices)),
+                    SharedBuffer<Math::Vec3f>(std::move(normals)), SharedBuffer<Math::Vec2f>(std::move(textureCoords)));
+            batch.meshDataPtr = std::make_shared<MeshData>(SharedBuffer<unsigned int>(std::move(indices)), meshGeometryDataPtr);
+            batches.push_back(batch);
+        }
+    }
+    sources.clear();
+    return batches;
+}
+
+ModelDataPtr StaticBatcher::CreateModelData(const std::vector<StaticBatch>& batches) {
+    std::vector<Mesh> meshes;
+    meshes.reserve(batches.size());
+    for(unsigned int i = 0; i < batches.size(); i++) {
+        meshes.push_back(Mesh(batches[i].meshDataPtr, batches[i].texturedMaterial, batches[i].unTexturedMaterial));
+    }
+    return std::make_shared<ModelData>(meshes);
+}
+
+unsigned int StaticBatcher::DrawVisibleRanges(const Mesh& batchMesh, const std::vector<StaticBatchRange>& sourceRanges,
+        const std::vector<bool>& visibleSources) {
+#ifdef _DEBUG
+    assert(visibleSources.size() == sourceRanges.size());
+#endif
+    MeshDrawRange drawRange = MeshLoader::GetDrawRange(batchMesh.getMeshID());
+    MeshLoader::BindMesh(batchMesh.getMeshID());
+    unsigned int numDrawCalls = 0;
+    unsigned int i = 0;
+    while(i < sourceRanges.size()) {
+        if(!visibleSources[i]) {
+            i++;
+            continue;
+        }
+        unsigned int firstIndex = sourceRanges[i].firstIndex;
+        unsigned int numIndices = 0;
+        while(i < sourceRanges.size() && visibleSources[i]) {
+            numIndices += sourceRanges[i].numIndices;
+            i++;
+        }
+        glDrawElementsBaseVertex(GL_TRIANGLES, numIndices, GL_UNSIGNED_INT,
+                (void*)((drawRange.firstIndex + firstIndex) * sizeof(unsigned int)), drawRange.baseVertex);
+        numDrawCalls++;
+    }
+    return numDrawCalls;
+}
+
+void StaticBatcher::appendSource(const unsigned int sourceIndex, const std::vector<unsigned int>& referencedVertices, const std::vector<unsigned int>& localIndices,
+        std::vector<Math::Vec3f>& vertices, std::vector<Math::Vec3f>& normals, std::vector<Math::Vec2f>& textureCoords,
+        std::vector<unsigned int>& indices, StaticBatchRange& range) const {
+    const Source& source = sources[sourceIndex];
+    MeshGeometryDataPtr meshGeometryDataPtr = source.meshDataPtr->getMeshGeometryDataPtr();
+    const SharedBuffer<Math::Vec3f>& sourceVertices = meshGeometryDataPtr->getVertices();
+    const SharedBuffer<Math::Vec3f>& sourceNormals = meshGeometryDataPtr->getNormals();
+    const SharedBuffer<Math::Vec2f>& sourceTextureCoords = meshGeometryDataPtr->getTextureCoords();
+    const Math::Mat4f& m = source.transform;
+    
+    // Normals are transformed by the cofactor matrix of the upper 3x3, which is its inverse transpose times its
+    // determinant. The determinant is negative for mirroring transforms, so the sign is taken out to keep normals facing
+    // out, and the length by normalizing
+    float normalMat[3][3];
+    for(unsigned int row = 0; row < 3; row++) {
+        for(unsigned int col = 0; col < 3; col++) {
+            unsigned int r1 = (row + 1) % 3, r2 = (row + 2) % 3;
+            unsigned int c1 = (col + 1) % 3, c2 = (col + 2) % 3;
+            normalMat[row][col] = m[r1][c1] * m[r2][c2] - m[r1][c2] * m[r2][c1];
+        }
+    }
+    float determinant = m[0][0] * normalMat[0][0] + m[0][1] * normalMat[0][1] + m[0][2] * normalMat[0][2];
+    if(determinant < 0.0f) {
+        for(unsigned int row = 0; row < 3; row++) {
+            for(unsigned int col = 0; col < 3; col++) {
+                normalMat[row][col] = -normalMat[row][col];
+            }
+        }
+    }
+    
+    range.firstVertex = vertices.size();
+    range.numVertices = referencedVertices.size();
+    range.firstIndex = indices.size();
+    range.numIndices = localIndices.size();
+    for(unsigned int i = 0; i < referencedVertices.size(); i++) {
+        unsigned int vertexIndex = referencedVertices[i];
+        const Math::Vec3f& v = sourceVertices[vertexIndex];
+        Math::Vec3f worldVertex;
+        for(unsigned int row = 0; row < 3; row++) {
+            worldVertex[row] = m[row][0] * v[0] + m[row][1] * v[1] + m[row][2] * v[2] + m[row][3];
+        }
+        for(unsigned int c = 0; c < 3; c++) {
+            range.boundsMin[c] = std::min(range.boundsMin[c], worldVertex[c]);
+            range.boundsMax[c] = std::max(range.boundsMax[c], worldVertex[c]);
+        }
+        vertices.push_back(worldVertex);
+        
+        const Math::Vec3f& n = sourceNormals[vertexIndex];
+        Math::Vec3f worldNormal;
+        for(unsigned int row = 0; row < 3; row++) {
+            worldNormal[row] = normalMat[row][0] * n[0] + normalMat[row][1] * n[1] + normalMat[row][2] * n[2];
+        }
+        float length = std::sqrt(worldNormal[0] * worldNormal[0] + worldNormal[1] * worldNormal[1] + worldNormal[2] * worldNormal[2]);
+        if(length > 0.0f) {
+            worldNormal = worldNormal / length;
+        }
+        normals.push_back(worldNormal);
+        textureCoords.push_back(sourceTextureCoords[vertexIndex]);
+    }
+    // Mirroring also reverses the winding of each triangle, so it's swapped back to keep the triangles front facing
+    for(unsigned int i = 0; i + 2 < localIndices.size(); i += 3) {
+        indices.push_back(localIndices[i] + range.firstVertex);
+        if(determinant < 0.0f) {
+            indices.push_back(localIndices[i + 2] + range.firstVertex);
+            indices.push_back(localIndices[i + 1] + range.firstVertex);
+        }
+        else {
+            indices.push_back(localIndices[i + 1] + range.firstVertex);
+            indices.push_back(localIndices[i + 2] + range.firstVertex);
+        }
+    }
+}
+
+}
@@ -0,0 +1,100 @@
+#ifndef STATIC_BATCHER_H
+#define STATIC_BATCHER_H
+
+#include <graphics/model/model.h>
+#include <math/matrix.h>
+#include <math/vector.h>
+#include <vector>
+#include <limits>
+
+namespace Engine {
+
+/*
+ * Location of one source mesh inside a static batch, along with its world space bounds so that it can still be culled
+ * on its own.
+ */
+struct StaticBatchRange {
+    // Order in which the source mesh was added to the batcher
+    unsigned int sourceIndex = 0;
+    unsigned int firstIndex = 0;
+    unsigned int numIndices = 0;
+    unsigned int firstVertex = 0;
+    unsigned int numVertices = 0;
+    Math::Vec3f boundsMin = Math::Vec3f(std::numeric_limits<float>::max());
+    Math::Vec3f boundsMax = Math::Vec3f(-std::numeric_limits<float>::max());
+};
+
+/*
+ * Merged world space geometry of static meshes sharing a material. Source ranges are stored in the order their
+ * geometry was appended, so consecutive ranges are contiguous in the index buffer.
+ */
+struct StaticBatch {
+    MeshDataPtr meshDataPtr;
+    TexturedMaterial texturedMaterial;
+    UnTexturedMaterial unTexturedMaterial;
+    std::vector<StaticBatchRange> sourceRanges;
+};
+
+/*
+ * StaticBatcher merges meshes that never move into one mesh per material at load time, so that a scene of props drawn
+ * with one draw call each is drawn with one draw call per material. Vertices are pre-transformed into world space and
+ * batches are split once they would exceed maxVerticesPerBatch vertices or maxIndicesPerBatch indices.
+ */
+class StaticBatcher {
+    public:
+        StaticBatcher(const unsigned int maxVerticesPerBatch = 65536, const unsigned int maxIndicesPerBatch = 196608);
+        
+        /*
+         * Adds mesh placed in the world by transform. Returns the source index of the mesh.
+         */
+        unsigned int addMesh(const Mesh& mesh, const Math::Mat4f& transform);
+        
+        /*
+         * Adds every mesh of model placed in the world by transform. Returns the source index of the first mesh.
+         */
+        unsigned int addModel(const Model& model, const Math::Mat4f& transform);
+        
+        /*
+         * Merges the meshes added since the last build into batches and clears the batcher.
+         */
+        std::vector<StaticBatch> build();
+        
+        unsigned int getNumSources() const { return sources.size(); }
+        
+        /*
+         * Returns a model with one mesh per batch, in the order of batches.
+         */
+        static ModelDataPtr CreateModelData(const std::vector<StaticBatch>& batches);
+        
+        /*
+         * Draws the source ranges of batchMesh flagged in visibleSources, indexed by position in sourceRanges, merging
+         * runs of consecutive visible ranges into one draw call. The mesh's material must already be applied. Returns
+         * the number of draw calls made.
+         */
+        static unsigned int DrawVisibleRanges(const Mesh& batchMesh, const std::vector<StaticBatchRange>& sourceRanges,
+                const std::vector<bool>& visibleSources);
+    private:
+        struct Source {
+            MeshDataPtr meshDataPtr;
+            TexturedMaterial texturedMaterial;
+            UnTexturedMaterial unTexturedMaterial;
+            Math::Mat4f transform;
+        };
+        
+        /*
+         * Appends the world space geometry of source with index sourceIndex to the batch's vectors, taking only
+         * referencedVertices of its geometry and its indices renumbered into them as localIndices (see
+         * MeshData::getReferencedVertices).
+         */
+        void appendSource(const unsigned int sourceIndex, const std::vector<unsigned int>& referencedVertices, const std::vector<unsigned int>& localIndices,
+                std::vector<Math::Vec3f>& vertices, std::vector<Math::Vec3f>& normals, std::vector<Math::Vec2f>& textureCoords,
+                std::vector<unsigned int>& indices, StaticBatchRange& range) const;
+        
+        unsigned int maxVerticesPerBatch;
+        unsigned int maxIndicesPerBatch;
+        std::vector<Source> sources;
+};
+
+}
+
+#endif //STATIC_BATCHER_H
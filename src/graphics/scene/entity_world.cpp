@@ -0,0 +1,233 @@
+#include "entity_world.h"
+#include <jobs/job_system.h>
+#include <algorithm>
+#include <thread>
+
+namespace Engine {
+
+/*
+ * Class EntityChunk
+ */
+EntityChunk::EntityChunk(const ComponentMask mask, const unsigned int capacity)
+    : mask(mask), capacity(capacity), size(0), entities(capacity), componentArrays() {
+    // Only the components the archetype has get arrays, so getComponents returns nullptr for the rest
+    if(mask & componentBit(COMPONENT_TRANSFORM)) {
+        std::get<std::vector<TransformComponent>>(componentArrays).resize(capacity);
+    }
+    if(mask & componentBit(COMPONENT_BOUNDS)) {
+        std::get<std::vector<BoundsComponent>>(componentArrays).resize(capacity);
+    }
+    if(mask & componentBit(COMPONENT_MESH)) {
+        std::get<std::vector<MeshComponent>>(componentArrays).resize(capacity);
+    }
+    if(mask & componentBit(COMPONENT_MATERIAL)) {
+        std::get<std::vector<MaterialComponent>>(componentArrays).resize(capacity);
+    }
+    if(mask & componentBit(COMPONENT_VISIBILITY)) {
+        std::get<std::vector<VisibilityComponent>>(componentArrays).resize(capacity);
+    }
+}
+
+unsigned int EntityChunk::add(const Entity entity) {
+#ifdef _DEBUG
+    assert(size < capacity);
+#endif
+    unsigned int row = size;
+    entities[row] = entity;
+    resetComponent<TransformComponent>(row);
+    resetComponent<BoundsComponent>(row);
+    resetComponent<MeshComponent>(row);
+    resetComponent<MaterialComponent>(row);
+    resetComponent<VisibilityComponent>(row);
+    size++;
+    return row;
+}
+
+void EntityChunk::copyComponents(const unsigned int row, const EntityChunk& src, const unsigned int srcRow) {
+    copyComponent<TransformComponent>(row, src, srcRow);
+    copyComponent<BoundsComponent>(row, src, srcRow);
+    copyComponent<MeshComponent>(row, src, srcRow);
+    copyComponent<MaterialComponent>(row, src, srcRow);
+    copyComponent<VisibilityComponent>(row, src, srcRow);
+}
+
+template<typename Component>
+void EntityChunk::copyComponent(const unsigned int row, const EntityChunk& src, const unsigned int srcRow) {
+    Component* components = getComponents<Component>();
+    const Component* srcComponents = src.getComponents<Component>();
+    if(components != nullptr && srcComponents != nullptr) {
+        components[row] = srcComponents[srcRow];
+    }
+}
+
+template<typename Component>
+void EntityChunk::resetComponent(const unsigned int row) {
+    Component* components = getComponents<Component>();
+    if(components != nullptr) {
+        components[row] = Component();
+    }
+}
+
+/*
+ * Class EntityWorld
+ */
+EntityWorld::EntityWorld(const unsigned int numThreads)
+    : numThreads(numThreads), numEntities(0), archetypes(), archetypeIndices(1u << NUM_COMPONENT_TYPES, NO_ARCHETYPE), locations(),
+      availableIndexStack(), materials() {
+    if(this->numThreads == 0) {
+        this->numThreads = std::max(1u, std::thread::hardware_concurrency());
+    }
+}
+
+Entity EntityWorld::createEntity(const ComponentMask mask) {
+#ifdef _DEBUG
+    assert(mask < (1u << NUM_COMPONENT_TYPES));
+#endif
+    Entity entity;
+    if(!availableIndexStack.empty()) {
+        entity.index = availableIndexStack.top();
+        availableIndexStack.pop();
+    }
+    else {
+        entity.index = locations.size();
+        locations.push_back(EntityLocation());
+    }
+    EntityLocation& location = locations[entity.index];
+    location.alive = true;
+    entity.generation = location.generation;
+    placeEntity(entity, getArchetype(mask));
+    numEntities++;
+    return entity;
+}
+
+void EntityWorld::destroyEntity(const Entity entity) {
+    unplaceEntity(entity);
+    EntityLocation& location = locations[entity.index];
+    location.alive = false;
+    location.generation++;
+    availableIndexStack.push(entity.index);
+    numEntities--;
+}
+
+bool EntityWorld::isAlive(const Entity entity) const {
+    return entity.index < locations.size() && locations[entity.index].alive && locations[entity.index].generation == entity.generation;
+}
+
+ComponentMask EntityWorld::getComponentMask(const Entity entity) const {
+    return archetypes[getLocation(entity).archetype].mask;
+}
+
+void EntityWorld::addComponents(const Entity entity, const ComponentMask mask) {
+    moveEntity(entity, getComponentMask(entity) | mask);
+}
+
+void EntityWorld::removeComponents(const Entity entity, const ComponentMask mask) {
+    moveEntity(entity, getComponentMask(entity) & ~mask);
+}
+
+void EntityWorld::forEachChunk(const ComponentMask mask, const std::function<void(EntityChunk&)>& function) {
+    for(unsigned int a = 0; a < archetypes.size(); a++) {
+        if((archetypes[a].mask & mask) != mask) {
+            continue;
+        }
+        std::vector<EntityChunk>& chunks = archetypes[a].chunks;
+        for(unsigned int c = 0; c < chunks.size(); c++) {
+            function(chunks[c]);
+        }
+    }
+}
+
+void EntityWorld::parallelForEachChunk(const ComponentMask mask, const std::function<void(EntityChunk&)>& function) {
+    std::vector<EntityChunk*> chunks;
+    forEachChunk(mask, [&chunks](EntityChunk& chunk) { chunks.push_back(&chunk); });
+    unsigned int numChunks = chunks.size();
+    // Split into about numThreads runs of contiguous chunks, which are all full but the last of each archetype
+    unsigned int grainSize = (numChunks + numThreads - 1) / numThreads;
+    if(grainSize < MIN_CHUNKS_PER_THREAD) {
+        grainSize = MIN_CHUNKS_PER_THREAD;
+    }
+    JobSystem::ParallelFor(0, numChunks, grainSize, [&chunks, &function](size_t firstChunk, size_t lastChunk) {
+        for(size_t i = firstChunk; i < lastChunk; i++) {
+            function(*chunks[i]);
+        }
+    });
+}
+
+unsigned int EntityWorld::addMaterial(const TexturedMaterial& texturedMaterial) {
+    materials.push_back(texturedMaterial);
+    return materials.size() - 1;
+}
+
+EntityWorldStats EntityWorld::getStats() const {
+    EntityWorldStats stats;
+    stats.numEntities = numEntities;
+    stats.numArchetypes = archetypes.size();
+    for(unsigned int a = 0; a < archetypes.size(); a++) {
+        stats.numChunks += archetypes[a].chunks.size();
+    }
+    return stats;
+}
+
+const EntityWorld::EntityLocation& EntityWorld::getLocation(const Entity entity) const {
+#ifdef _DEBUG
+    assert(isAlive(entity));
+#endif
+    return locations[entity.index];
+}
+
+unsigned int EntityWorld::getArchetype(const ComponentMask mask) {
+    if(archetypeIndices[mask] == NO_ARCHETYPE) {
+        archetypeIndices[mask] = archetypes.size();
+        archetypes.push_back({mask, std::vector<EntityChunk>()});
+    }
+    return archetypeIndices[mask];
+}
+
+void EntityWorld::placeEntity(const Entity entity, const unsigned int archetype) {
+    std::vector<EntityChunk>& chunks = archetypes[archetype].chunks;
+    if(chunks.empty() || chunks.back().isFull()) {
+        chunks.push_back(EntityChunk(archetypes[archetype].mask, CHUNK_CAPACITY));
+    }
+    EntityLocation& location = locations[entity.index];
+    location.archetype = archetype;
+    location.chunk = chunks.size() - 1;
+    location.row = chunks.back().add(entity);
+}
+
+void EntityWorld::unplaceEntity(const Entity entity) {
+    EntityLocation location = getLocation(entity);
+    std::vector<EntityChunk>& chunks = archetypes[location.archetype].chunks;
+    EntityChunk& lastChunk = chunks.back();
+    unsigned int lastRow = lastChunk.size - 1;
+    if(location.chunk != chunks.size() - 1 || location.row != lastRow) {
+        // Keeps the archetype packed, so only its last chunk has free rows
+        Entity lastEntity = lastChunk.entities[lastRow];
+        EntityChunk& chunk = chunks[location.chunk];
+        chunk.entities[location.row] = lastEntity;
+        chunk.copyComponents(location.row, lastChunk, lastRow);
+        locations[lastEntity.index].chunk = location.chunk;
+        locations[lastEntity.index].row = location.row;
+    }
+    lastChunk.size--;
+    if(lastChunk.size == 0) {
+        chunks.pop_back();
+    }
+}
+
+void EntityWorld::moveEntity(const Entity entity, const ComponentMask mask) {
+    const EntityLocation& location = getLocation(entity);
+    unsigned int archetype = getArchetype(mask);
+    if(archetype == location.archetype) {
+        return;
+    }
+    // Copied out first, since unplacing can pop the chunk the entity was in
+    EntityChunk srcChunk(archetypes[location.archetype].mask, 1);
+    srcChunk.add(entity);
+    srcChunk.copyComponents(0, archetypes[location.archetype].chunks[location.chunk], location.row);
+    unplaceEntity(entity);
+    placeEntity(entity, archetype);
+    const EntityLocation& newLocation = locations[entity.index];
+    archetypes[archetype].chunks[newLocation.chunk].copyComponents(newLocation.row, srcChunk, 0);
+}
+
+}
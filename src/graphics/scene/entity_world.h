@@ -0,0 +1,260 @@
+#ifndef ENTITY_WORLD_H
+#define ENTITY_WORLD_H
+
+#include <graphics/material/material.h>
+#include <math/matrix.h>
+#include <math/vector.h>
+#include <vector>
+#include <stack>
+#include <tuple>
+#include <functional>
+#include <cassert>
+
+namespace Engine {
+
+enum ComponentType {
+    COMPONENT_TRANSFORM = 0,
+    COMPONENT_BOUNDS,
+    COMPONENT_MESH,
+    COMPONENT_MATERIAL,
+    COMPONENT_VISIBILITY,
+    NUM_COMPONENT_TYPES
+};
+
+/*
+ * Set of component types, one bit per ComponentType.
+ */
+typedef unsigned int ComponentMask;
+
+inline constexpr ComponentMask componentBit(const ComponentType type) { return 1u << type; }
+
+/*
+ * Where the entity is placed in the world.
+ */
+struct TransformComponent {
+    static constexpr ComponentType TYPE = COMPONENT_TRANSFORM;
+    Math::Mat4f transform = Math::Mat4f(1.0f);
+};
+
+/*
+ * Axis aligned bounds of the entity in its own space, before its transform.
+ */
+struct BoundsComponent {
+    static constexpr ComponentType TYPE = COMPONENT_BOUNDS;
+    Math::Vec3f boundsMin = Math::Vec3f(0.0f);
+    Math::Vec3f boundsMax = Math::Vec3f(0.0f);
+};
+
+/*
+ * The buffered mesh drawn for the entity, by MeshLoader ID. The mesh must stay loaded while entities refer to it.
+ */
+struct MeshComponent {
+    static constexpr ComponentType TYPE = COMPONENT_MESH;
+    unsigned int meshID = 0;
+};
+
+/*
+ * The material the entity is drawn with, as a handle returned by EntityWorld::addMaterial.
+ */
+struct MaterialComponent {
+    static constexpr ComponentType TYPE = COMPONENT_MATERIAL;
+    unsigned int materialHandle = 0;
+};
+
+struct VisibilityComponent {
+    static constexpr ComponentType TYPE = COMPONENT_VISIBILITY;
+    // Set to keep the entity from being drawn whether or not it's in view
+    bool hidden = false;
+    // Written by culling
+    bool visible = true;
+};
+
+/*
+ * Handle to an entity. The generation tells a destroyed entity from a later one reusing its slot; generation 0 is
+ * never alive.
+ */
+struct Entity {
+    unsigned int index = 0;
+    unsigned int generation = 0;
+    
+    bool operator==(const Entity& other) const { return index == other.index && generation == other.generation; }
+    bool operator!=(const Entity& other) const { return !(*this == other); }
+};
+
+/*
+ * A fixed number of entities with the same components, each component stored in its own packed array so systems
+ * reading a few components scan only those. Rows 0 to getSize() - 1 are in use.
+ */
+class EntityChunk {
+    public:
+        EntityChunk(const ComponentMask mask, const unsigned int capacity);
+        
+        ComponentMask getMask() const { return mask; }
+        bool hasComponents(const ComponentMask components) const { return (mask & components) == components; }
+        unsigned int getSize() const { return size; }
+        unsigned int getCapacity() const { return capacity; }
+        bool isFull() const { return size == capacity; }
+        const Entity* getEntities() const { return entities.data(); }
+        
+        /*
+         * Returns the array of Component, or nullptr if the chunk's entities don't have it.
+         */
+        template<typename Component>
+        Component* getComponents() {
+            std::vector<Component>& components = std::get<std::vector<Component>>(componentArrays);
+            return components.empty() ? nullptr : components.data();
+        }
+        template<typename Component>
+        const Component* getComponents() const {
+            const std::vector<Component>& components = std::get<std::vector<Component>>(componentArrays);
+            return components.empty() ? nullptr : components.data();
+        }
+    private:
+        friend class EntityWorld;
+        
+        /*
+         * Adds entity in the next row with default components. Returns the row.
+         */
+        unsigned int add(const Entity entity);
+        
+        /*
+         * Copies the components of row srcRow of src that this chunk has into row.
+         */
+        void copyComponents(const unsigned int row, const EntityChunk& src, const unsigned int srcRow);
+        
+        template<typename Component>
+        void copyComponent(const unsigned int row, const EntityChunk& src, const unsigned int srcRow);
+        template<typename Component>
+        void resetComponent(const unsigned int row);
+        
+        ComponentMask mask;
+        unsigned int capacity;
+        unsigned int size;
+        std::vector<Entity> entities;
+        std::tuple<std::vector<TransformComponent>, std::vector<BoundsComponent>, std::vector<MeshComponent>, std::vector<MaterialComponent>,
+                std::vector<VisibilityComponent>> componentArrays;
+};
+
+struct EntityWorldStats {
+    unsigned int numEntities = 0;
+    unsigned int numArchetypes = 0;
+    unsigned int numChunks = 0;
+};
+
+/*
+ * EntityWorld stores renderable entities by archetype, the set of components they have. Each archetype keeps its
+ * entities packed into chunks of CHUNK_CAPACITY, every chunk but the last full, so systems run over the entities with
+ * some components as linear scans of the chunks' arrays rather than through per-object pointers and lookups. Entities
+ * move between archetypes when components are added or removed, and destroying one moves the archetype's last entity
+ * into its place.
+ *
+ * Entity handles stay valid while entities move. Pointers into chunks don't, so take them only while iterating.
+ */
+class EntityWorld {
+    public:
+        /*
+         * Creates a world whose parallel iteration splits the chunks between JobSystem jobs for numThreads threads, or
+         * for one per hardware thread if numThreads is 0.
+         */
+        EntityWorld(const unsigned int numThreads = 0);
+        
+        /*
+         * Creates an entity with default components of the types in mask.
+         */
+        Entity createEntity(const ComponentMask mask);
+        void destroyEntity(const Entity entity);
+        bool isAlive(const Entity entity) const;
+        ComponentMask getComponentMask(const Entity entity) const;
+        
+        /*
+         * Gives the entity default components of the types in mask it doesn't have yet, keeping its other components.
+         */
+        void addComponents(const Entity entity, const ComponentMask mask);
+        void removeComponents(const Entity entity, const ComponentMask mask);
+        
+        /*
+         * Returns the entity's Component, which it must have. The reference is invalidated by creating, destroying or
+         * changing the components of any entity.
+         */
+        template<typename Component>
+        Component& getComponent(const Entity entity) {
+            const EntityLocation& location = getLocation(entity);
+            EntityChunk& chunk = archetypes[location.archetype].chunks[location.chunk];
+#ifdef _DEBUG
+            assert(chunk.hasComponents(componentBit(Component::TYPE)));
+#endif
+            return chunk.getComponents<Component>()[location.row];
+        }
+        
+        /*
+         * Calls function with each chunk of entities that have every component in mask.
+         */
+        void forEachChunk(const ComponentMask mask, const std::function<void(EntityChunk&)>& function);
+        
+        /*
+         * Like forEachChunk, but runs the chunks as JobSystem jobs and returns once they're done. function must only
+         * touch the chunk it's given.
+         */
+        void parallelForEachChunk(const ComponentMask mask, const std::function<void(EntityChunk&)>& function);
+        
+        /*
+         * Adds a material for entities to be drawn with. Returns its handle.
+         */
+        unsigned int addMaterial(const TexturedMaterial& texturedMaterial);
+        const TexturedMaterial& getMaterial(const unsigned int materialHandle) const { return materials[materialHandle]; }
+        unsigned int getNumMaterials() const { return materials.size(); }
+        
+        unsigned int getNumEntities() const { return numEntities; }
+        EntityWorldStats getStats() const;
+        
+        static constexpr unsigned int CHUNK_CAPACITY = 128;
+        // Iterations over fewer chunks than this per thread run on the calling thread only
+        static constexpr unsigned int MIN_CHUNKS_PER_THREAD = 4;
+    private:
+        struct Archetype {
+            ComponentMask mask;
+            std::vector<EntityChunk> chunks;
+        };
+        struct EntityLocation {
+            // Incremented as the entity in the slot is destroyed
+            unsigned int generation = 1;
+            bool alive = false;
+            unsigned int archetype = 0;
+            unsigned int chunk = 0;
+            unsigned int row = 0;
+        };
+        
+        const EntityLocation& getLocation(const Entity entity) const;
+        
+        /*
+         * Returns the index of the archetype of mask, creating it if needed.
+         */
+        unsigned int getArchetype(const ComponentMask mask);
+        
+        /*
+         * Adds entity to the end of archetype and records where.
+         */
+        void placeEntity(const Entity entity, const unsigned int archetype);
+        
+        /*
+         * Fills the entity's row with the archetype's last entity and drops the last row.
+         */
+        void unplaceEntity(const Entity entity);
+        
+        void moveEntity(const Entity entity, const ComponentMask mask);
+        
+        unsigned int numThreads;
+        unsigned int numEntities;
+        std::vector<Archetype> archetypes;
+        // Index into archetypes of each mask's archetype, NO_ARCHETYPE if it has none yet
+        std::vector<unsigned int> archetypeIndices;
+        std::vector<EntityLocation> locations;
+        std::stack<unsigned int> availableIndexStack;
+        std::vector<TexturedMaterial> materials;
+        
+        static constexpr unsigned int NO_ARCHETYPE = ~0u;
+};
+
+}
+
+#endif //ENTITY_WORLD_H
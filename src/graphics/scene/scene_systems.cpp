@@ -0,0 +1,93 @@
+#include "scene_systems.h"
+#include <atomic>
+#include <cmath>
+
+namespace Engine {
+
+/*
+ * Class CullingSystem
+ */
+unsigned int CullingSystem::UpdateVisibility(EntityWorld& world, const Frustum& frustum) {
+    std::atomic<unsigned int> numVisible(0);
+    ComponentMask mask = componentBit(COMPONENT_TRANSFORM) | componentBit(COMPONENT_BOUNDS) | componentBit(COMPONENT_VISIBILITY);
+    world.parallelForEachChunk(mask, [&frustum, &numVisible](EntityChunk& chunk) {
+        const TransformComponent* transforms = chunk.getComponents<TransformComponent>();
+        const BoundsComponent* bounds = chunk.getComponents<BoundsComponent>();
+        VisibilityComponent* visibilities = chunk.getComponents<VisibilityComponent>();
+        unsigned int chunkVisible = 0;
+        for(unsigned int i = 0; i < chunk.getSize(); i++) {
+            if(visibilities[i].hidden) {
+                visibilities[i].visible = false;
+                continue;
+            }
+            Math::Vec3f worldBoundsMin;
+            Math::Vec3f worldBoundsMax;
+            TransformBounds(transforms[i].transform, bounds[i].boundsMin, bounds[i].boundsMax, worldBoundsMin, worldBoundsMax);
+            visibilities[i].visible = frustum.intersectsBox(worldBoundsMin, worldBoundsMax);
+            chunkVisible += visibilities[i].visible;
+        }
+        numVisible += chunkVisible;
+    });
+    return numVisible;
+}
+
+void CullingSystem::TransformBounds(const Math::Mat4f& transform, const Math::Vec3f& boundsMin, const Math::Vec3f& boundsMax,
+        Math::Vec3f& worldBoundsMin, Math::Vec3f& worldBoundsMax) {
+    // The box's center moves with the transform and each axis of its extent spreads over the axes it's rotated onto
+    for(unsigned int r = 0; r < 3; r++) {
+        float center = transform[r][3];
+        float extent = 0.0f;
+        for(unsigned int c = 0; c < 3; c++) {
+            center += transform[r][c] * 0.5f * (boundsMin[c] + boundsMax[c]);
+            extent += std::abs(transform[r][c]) * 0.5f * (boundsMax[c] - boundsMin[c]);
+        }
+        worldBoundsMin[r] = center - extent;
+        worldBoundsMax[r] = center + extent;
+    }
+}
+
+/*
+ * Class DrawSystem
+ */
+unsigned int DrawSystem::AddVisibleDraws(EntityWorld& world, IndirectDrawStream& drawStream) {
+    // Mesh IDs are small and reused, so the ranges looked up this call are kept in arrays indexed by them
+    std::vector<MeshDrawRange> drawRanges;
+    std::vector<bool> resolved;
+    unsigned int numDraws = 0;
+    ComponentMask mask = componentBit(COMPONENT_TRANSFORM) | componentBit(COMPONENT_MESH) | componentBit(COMPONENT_MATERIAL);
+    world.forEachChunk(mask, [&](EntityChunk& chunk) {
+        const TransformComponent* transforms = chunk.getComponents<TransformComponent>();
+        const MeshComponent* meshes = chunk.getComponents<MeshComponent>();
+        const MaterialComponent* materials = chunk.getComponents<MaterialComponent>();
+        const VisibilityComponent* visibilities = chunk.getComponents<VisibilityComponent>();
+        for(unsigned int i = 0; i < chunk.getSize(); i++) {
+            if(visibilities != nullptr && (!visibilities[i].visible || visibilities[i].hidden)) {
+                continue;
+            }
+            unsigned int meshID = meshes[i].meshID;
+            if(meshID >= resolved.size()) {
+                drawRanges.resize(meshID + 1);
+                resolved.resize(meshID + 1, false);
+            }
+            if(!resolved[meshID]) {
+                drawRanges[meshID] = MeshLoader::GetDrawRange(meshID);
+                resolved[meshID] = true;
+            }
+            drawStream.addDraw(drawRanges[meshID], materials[i].materialHandle, transforms[i].transform);
+            numDraws++;
+        }
+    });
+    return numDraws;
+}
+
+unsigned int DrawSystem::Draw(EntityWorld& world, IndirectDrawStream& drawStream) {
+    drawStream.clear();
+    unsigned int numDraws = AddVisibleDraws(world, drawStream);
+    drawStream.build();
+    drawStream.submit([&world](unsigned int materialHandle) {
+        world.getMaterial(materialHandle).apply();
+    });
+    return numDraws;
+}
+
+}
@@ -0,0 +1,50 @@
+#ifndef SCENE_SYSTEMS_H
+#define SCENE_SYSTEMS_H
+
+#include <graphics/scene/entity_world.h>
+#include <graphics/camera/camera.h>
+#include <graphics/mesh/indirect_draw_stream.h>
+#include <vector>
+
+namespace Engine {
+
+/*
+ * CullingSystem flags which entities are in view, running over the chunks of a world in parallel.
+ */
+class CullingSystem {
+    public:
+        /*
+         * Sets the visibility of every entity with a transform, bounds and visibility to whether its transformed bounds
+         * intersect frustum and it isn't hidden. Returns the number of visible entities.
+         */
+        static unsigned int UpdateVisibility(EntityWorld& world, const Frustum& frustum);
+        
+        /*
+         * Sets worldBoundsMin and worldBoundsMax to the axis aligned box holding the box boundsMin to boundsMax
+         * transformed by transform.
+         */
+        static void TransformBounds(const Math::Mat4f& transform, const Math::Vec3f& boundsMin, const Math::Vec3f& boundsMax,
+                Math::Vec3f& worldBoundsMin, Math::Vec3f& worldBoundsMax);
+};
+
+/*
+ * DrawSystem turns the visible entities of a world into draws of an IndirectDrawStream, batched by material handle.
+ */
+class DrawSystem {
+    public:
+        /*
+         * Adds a draw for every entity with a transform, mesh and material that isn't flagged invisible. The draw range
+         * of each mesh is looked up once per call however many entities draw it. Returns the number of draws added.
+         */
+        static unsigned int AddVisibleDraws(EntityWorld& world, IndirectDrawStream& drawStream);
+        
+        /*
+         * Clears drawStream, adds the world's visible draws, then builds and submits them applying each batch's
+         * material. Returns the number of draws.
+         */
+        static unsigned int Draw(EntityWorld& world, IndirectDrawStream& drawStream);
+};
+
+}
+
+#endif //SCENE_SYSTEMS_H
@@ -3,6 +3,10 @@
 uniform sampler2D texture0;
 uniform sampler2D texture1;
 
+layout (std140) uniform MaterialParameters {
+	vec4 textureMixingWeights;
+};
+
 in vec3 myColor;
 in vec2 myTexCoord;
 
@@ -11,6 +15,7 @@ out vec4 FragColor;
 void main()
 {
 	vec3 a = myColor;
-	FragColor = mix(texture(texture0, myTexCoord), texture(texture1, myTexCoord), 0.5f);
+	vec2 weights = textureMixingWeights.xy;
+	FragColor = (weights.x * texture(texture0, myTexCoord) + weights.y * texture(texture1, myTexCoord)) / (weights.x + weights.y);
 	//FragColor = vec4(myColor, 1.0f);
 }
\ No newline at end of file
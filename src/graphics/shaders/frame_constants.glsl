@@ -0,0 +1,9 @@
+// Values shared by every draw in a frame, as FrameConstants copies them
+layout (std140, row_major) uniform FrameConstants {
+    mat4 viewMatrix;
+    mat4 projectionMatrix;
+    mat4 viewProjectionMatrix;
+    mat4 inverseViewProjectionMatrix;
+    vec4 frustumPlanes[6];
+    vec4 cameraPosition;
+};
@@ -0,0 +1,13 @@
+#version 430 core
+
+#include "vertex_attributes.glsl"
+#include "frame_constants.glsl"
+// Per-draw transform, selected by the draw's baseInstance (see IndirectDrawStream)
+layout (location = 3) in mat4 inTransform;
+
+void main()
+{
+	myTexCoord = inTexCoord;
+    gl_Position = viewProjectionMatrix * inTransform * vec4(inVertex.x, inVertex.y, inVertex.z, 1.0f);
+	myColor = vec3(1.0f, 0.0f, 0.0f);
+}
\ No newline at end of file
@@ -0,0 +1,14 @@
+#version 430 core
+
+#include "vertex_attributes.glsl"
+#include "frame_constants.glsl"
+// Per-instance data streamed by InstanceRenderer
+layout (location = 3) in mat4 inTransform;
+layout (location = 7) in vec4 inCustomData;
+
+void main()
+{
+	myTexCoord = inTexCoord;
+    gl_Position = viewProjectionMatrix * inTransform * vec4(inVertex.x, inVertex.y, inVertex.z, 1.0f);
+	myColor = inCustomData.rgb;
+}
\ No newline at end of file
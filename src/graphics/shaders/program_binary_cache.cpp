@@ -0,0 +1,177 @@
+#include "program_binary_cache.h"
+#include <fileio/hash.h>
+#include <filesystem>
+#include <fstream>
+#include <sstream>
+#include <iomanip>
+#include <cstring>
+#include <cassert>
+
+namespace Engine {
+
+/*
+ * Start of a binary file, followed by the binary.
+ */
+struct BinaryHeader {
+    char magic[4];
+    unsigned int version;
+    unsigned long long key;
+    unsigned int binaryFormat;
+    unsigned int binarySize;
+};
+static_assert(sizeof(BinaryHeader) == 24, "BinaryHeader must have no padding");
+
+static const char binaryMagic[4] = {'E', 'P', 'R', 'G'};
+
+/*
+ * Class ProgramBinaryCache
+ */
+std::string ProgramBinaryCache::cacheDirectory = "";
+ProgramBinaryCacheStats ProgramBinaryCache::stats = ProgramBinaryCacheStats();
+
+void ProgramBinaryCache::SetCacheDirectory(const std::string& cacheDirectory) {
+    if(cacheDirectory != "") {
+        std::error_code errorCode;
+        std::filesystem::create_directories(cacheDirectory, errorCode);
+        if(errorCode) {
+            throw FileIOException("ERROR: Failed to create program binary cache directory \"" + cacheDirectory + "\"");
+        }
+    }
+    ProgramBinaryCache::cacheDirectory = cacheDirectory;
+}
+
+bool ProgramBinaryCache::IsEnabled() {
+    return !cacheDirectory.empty() && IsSupported();
+}
+
+bool ProgramBinaryCache::IsSupported() {
+    if(!GLAD_GL_VERSION_4_1 && !GLAD_GL_ARB_get_program_binary) {
+        return false;
+    }
+    GLint numBinaryFormats = 0;
+    glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &numBinaryFormats);
+    return numBinaryFormats > 0;
+}
+
+unsigned long long ProgramBinaryCache::GetProgramKey(const std::vector<GLenum>& types, const std::vector<std::string>& sources,
+        const std::vector<std::string>& defines) {
+#ifdef _DEBUG
+    assert(types.size() == sources.size());
+#endif
+    unsigned long long key = Hash::HashString(Hash::OFFSET_BASIS, GetDriverString());
+    for(unsigned int i = 0; i < types.size(); i++) {
+        key = Hash::HashBytes(key, &types[i], sizeof(types[i]));
+        key = Hash::HashString(key, sources[i]);
+    }
+    for(unsigned int i = 0; i < defines.size(); i++) {
+        key = Hash::HashString(key, defines[i]);
+    }
+    return key;
+}
+
+std::string ProgramBinaryCache::GetCacheFilePath(const unsigned long long key) {
+    std::stringstream fileName;
+    fileName << std::hex << std::setw(16) << std::setfill('0') << key << ".eprg";
+    return (std::filesystem::path(cacheDirectory) / fileName.str()).string();
+}
+
+bool ProgramBinaryCache::Load(const unsigned long long key, const GLuint program) {
+    std::string filePath = GetCacheFilePath(key);
+    std::error_code errorCode;
+    if(!std::filesystem::exists(filePath, errorCode)) {
+        stats.numMisses++;
+        return false;
+    }
+    try {
+        GLenum binaryFormat = 0;
+        std::vector<char> binary = ReadBinary(filePath, key, binaryFormat);
+        glProgramBinary(program, binaryFormat, binary.data(), binary.size());
+        GLint linkStatus = GL_FALSE;
+        glGetProgramiv(program, GL_LINK_STATUS, &linkStatus);
+        if(linkStatus == GL_TRUE) {
+            stats.numHits++;
+            return true;
+        }
+    }
+    catch(FileIOException& e) {
+        // A corrupt binary file
+    }
+    std::filesystem::remove(filePath, errorCode);
+    stats.numRejections++;
+    stats.numMisses++;
+    return false;
+}
+
+bool ProgramBinaryCache::Store(const unsigned long long key, const GLuint program) {
+    GLint binaryLength = 0;
+    glGetProgramiv(program, GL_PROGRAM_BINARY_LENGTH, &binaryLength);
+    std::vector<char> binary(binaryLength);
+    GLsizei length = 0;
+    GLenum binaryFormat = 0;
+    if(binaryLength > 0) {
+        glGetProgramBinary(program, binaryLength, &length, &binaryFormat, binary.data());
+    }
+    if(length == 0) {
+        stats.numWriteFailures++;
+        return false;
+    }
+    
+    BinaryHeader header = {};
+    std::memcpy(header.magic, binaryMagic, sizeof(binaryMagic));
+    header.version = BINARY_VERSION;
+    header.key = key;
+    header.binaryFormat = binaryFormat;
+    header.binarySize = length;
+    // Write to a temporary file and rename it into place, so a run killed midway never leaves a partial binary
+    std::string filePath = GetCacheFilePath(key);
+    std::string temporaryFilePath = filePath + ".tmp";
+    std::error_code errorCode;
+    {
+        std::ofstream outFile(temporaryFilePath, std::ios_base::out | std::ios_base::binary | std::ios_base::trunc);
+        outFile.write((const char*)&header, sizeof(header));
+        outFile.write(binary.data(), length);
+        if(!outFile) {
+            std::filesystem::remove(temporaryFilePath, errorCode);
+            stats.numWriteFailures++;
+            return false;
+        }
+    }
+    std::filesystem::rename(temporaryFilePath, filePath, errorCode);
+    if(errorCode) {
+        std::filesystem::remove(temporaryFilePath, errorCode);
+        stats.numWriteFailures++;
+        return false;
+    }
+    stats.numWrites++;
+    return true;
+}
+
+std::string ProgramBinaryCache::GetDriverString() {
+    std::string driverString;
+    const GLenum names[] = {GL_VENDOR, GL_RENDERER, GL_VERSION};
+    for(unsigned int i = 0; i < 3; i++) {
+        const GLubyte* string = glGetString(names[i]);
+        driverString += std::string((string != nullptr) ? (const char*)string : "") + "\n";
+    }
+    return driverString;
+}
+
+std::vector<char> ProgramBinaryCache::ReadBinary(const std::string& filePath, const unsigned long long key, GLenum& binaryFormat) {
+    std::ifstream inFile(filePath, std::ios_base::in | std::ios_base::binary);
+    BinaryHeader header;
+    if(!inFile.read((char*)&header, sizeof(header))) {
+        throw FileIOException("ERROR: Program binary \"" + filePath + "\" is truncated");
+    }
+    if(std::memcmp(header.magic, binaryMagic, sizeof(binaryMagic)) != 0 || header.version != BINARY_VERSION || header.key != key
+            || header.binarySize == 0) {
+        throw FileIOException("ERROR: \"" + filePath + "\" is not a valid program binary");
+    }
+    std::vector<char> binary(header.binarySize);
+    if(!inFile.read(binary.data(), binary.size())) {
+        throw FileIOException("ERROR: Program binary \"" + filePath + "\" is truncated");
+    }
+    binaryFormat = header.binaryFormat;
+    return binary;
+}
+
+}
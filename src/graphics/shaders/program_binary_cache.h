@@ -0,0 +1,95 @@
+#ifndef PROGRAM_BINARY_CACHE_H
+#define PROGRAM_BINARY_CACHE_H
+
+#include <exceptions/io_exception.h>
+#include <string>
+#include <vector>
+
+#include <glad/glad.h>
+
+namespace Engine {
+
+/*
+ * Counts of ProgramBinaryCache lookups.
+ */
+struct ProgramBinaryCacheStats {
+    unsigned long long numHits = 0;
+    unsigned long long numMisses = 0;
+    // Binaries the driver refused to link, e.g. after a driver update, and corrupt binary files. Both are deleted
+    unsigned long long numRejections = 0;
+    unsigned long long numWrites = 0;
+    unsigned long long numWriteFailures = 0;
+};
+
+/*
+ * ProgramBinaryCache keeps linked shader programs in a directory as driver binaries, so later runs hand the binary to
+ * glProgramBinary instead of compiling and linking the GLSL sources again.
+ *
+ * A program's key hashes its stage types and sources (after preprocessing), its defines and the driver's vendor,
+ * renderer and version strings, so editing a shader or updating the driver gives a new key. A binary the driver still
+ * refuses is deleted and the program is compiled from source instead.
+ *
+ * Only call it on the thread owning the OpenGL context. Set the cache directory before loading shader programs.
+ */
+class ProgramBinaryCache {
+    public:
+        /*
+         * Sets the directory binaries are kept in, creating it if needed. An empty path disables the cache, which is
+         * the default.
+         */
+        static void SetCacheDirectory(const std::string& cacheDirectory);
+        static const std::string& GetCacheDirectory() { return cacheDirectory; }
+        
+        /*
+         * Returns true if a cache directory is set and the driver supports program binaries.
+         */
+        static bool IsEnabled();
+        
+        /*
+         * Returns true if the driver supports retrieving program binaries in at least one format.
+         */
+        static bool IsSupported();
+        
+        /*
+         * Returns the key of the program built from the stages of types with sources and compiled with defines.
+         */
+        static unsigned long long GetProgramKey(const std::vector<GLenum>& types, const std::vector<std::string>& sources,
+                const std::vector<std::string>& defines);
+        
+        static std::string GetCacheFilePath(const unsigned long long key);
+        
+        /*
+         * Links program, which must have no shaders attached, from the binary cached with key. Returns false if there
+         * is no binary or the driver rejected it, in which case program can still be built from source.
+         */
+        static bool Load(const unsigned long long key, const GLuint program);
+        
+        /*
+         * Writes the binary of the linked program to the cache with key. Set GL_PROGRAM_BINARY_RETRIEVABLE_HINT on
+         * program before linking it. Returns false if the binary couldn't be retrieved or written, which leaves the
+         * program uncached rather than failing the load.
+         */
+        static bool Store(const unsigned long long key, const GLuint program);
+        
+        static const ProgramBinaryCacheStats& GetStats() { return stats; }
+        static void ResetStats() { stats = ProgramBinaryCacheStats(); }
+    private:
+        /*
+         * Returns the vendor, renderer and version strings of the driver.
+         */
+        static std::string GetDriverString();
+        
+        /*
+         * Reads the binary cached with key. Throws FileIOException if the file can't be read or isn't a valid binary.
+         */
+        static std::vector<char> ReadBinary(const std::string& filePath, const unsigned long long key, GLenum& binaryFormat);
+        
+        static constexpr unsigned int BINARY_VERSION = 1;
+        
+        static std::string cacheDirectory;
+        static ProgramBinaryCacheStats stats;
+};
+
+}
+
+#endif //PROGRAM_BINARY_CACHE_H
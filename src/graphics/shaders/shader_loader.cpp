@@ -1,4 +1,6 @@
 #include <graphics/shaders/shader_loader.h>
+#include <graphics/shaders/program_binary_cache.h>
+#include <graphics/state/gl_state_cache.h>
 
 namespace Engine {
 
@@ -17,6 +19,11 @@ void ShaderObject::load(const std::string filePath) {
     this->filePath = filePath;
     std::string source;
     readFile(filePath, source);
+    loadSource(source, filePath);
+}
+
+void ShaderObject::loadSource(const std::string& source, const std::string filePath) {
+    this->filePath = filePath;
     const char* sourceCString = source.c_str();
     shader = glCreateShader(type);
     if(!glIsShader(shader)) {
@@ -26,10 +33,18 @@ void ShaderObject::load(const std::string filePath) {
 }
 
 void ShaderObject::compile() {
+    submitCompile();
+    checkCompileStatus();
+}
+
+void ShaderObject::submitCompile() {
     if(!shader) {
         throw RenderException("ERROR: Attempted to compile shader file \"" + filePath + "\"that wasn't loaded.");
     }
     glCompileShader(shader);
+}
+
+void ShaderObject::checkCompileStatus() {
     int compleStatus = 0;
     glGetShaderiv(shader, GL_COMPILE_STATUS, &compleStatus);
     if(compleStatus != GL_TRUE) {
@@ -55,18 +70,93 @@ ShaderProgram::ShaderProgram(const std::vector<GLenum> types, const std::vector<
 #ifdef _DEBUG
     assert(types.size() == filePaths.size());
 #endif
+    ShaderPreprocessor preprocessor;
+    std::vector<std::string> sources(filePaths.size());
+    for(size_t i = 0; i < filePaths.size(); i++) {
+        sources[i] = preprocessor.process(filePaths[i]);
+    }
+    build(types, filePaths, sources, shaderProgramName, std::vector<std::string>(), false);
+}
+
+ShaderProgram::ShaderProgram(const std::vector<GLenum> types, const std::vector<std::string> filePaths, const std::vector<std::string> sources,
+        const std::string shaderProgramName, const std::vector<std::string> defines, const bool deferStatusChecks) : ShaderProgram() {
+#ifdef _DEBUG
+    assert(types.size() == filePaths.size());
+    assert(types.size() == sources.size());
+#endif
+    build(types, filePaths, sources, shaderProgramName, defines, deferStatusChecks);
+}
+
+void ShaderProgram::build(const std::vector<GLenum>& types, const std::vector<std::string>& filePaths, const std::vector<std::string>& sources,
+        const std::string& shaderProgramName, const std::vector<std::string>& defines, const bool deferStatusChecks) {
     create();
     this->shaderProgramName = shaderProgramName;
+    bool cacheBinary = ProgramBinaryCache::IsEnabled();
+    if(cacheBinary) {
+        binaryKey = ProgramBinaryCache::GetProgramKey(types, sources, defines);
+        if(ProgramBinaryCache::Load(binaryKey, program)) {
+            shaderFileNames = filePaths;
+            linked = true;
+            return;
+        }
+        glProgramParameteri(program, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
+    }
+    
+    // Every stage is submitted before any status is asked for, so a driver compiling on its own threads isn't waited on
     std::vector<std::shared_ptr<ShaderObject>> shaderObjects;
-    for(size_t i = 0; i < filePaths.size(); i++) {
-        std::shared_ptr<ShaderObject> shaderObject(new ShaderObject(types[i], filePaths[i]));
-        shaderObject->compile();
+    for(size_t i = 0; i < sources.size(); i++) {
+        std::shared_ptr<ShaderObject> shaderObject(new ShaderObject(types[i]));
+        shaderObject->loadSource(sources[i], filePaths[i]);
+        shaderObject->submitCompile();
         shaderObjects.push_back(shaderObject);
     }
-    for(size_t i = 0; i < filePaths.size(); i++) {
+    for(size_t i = 0; i < shaderObjects.size(); i++) {
         addShaderObject(shaderObjects[i]);
     }
-    link();
+    submitLink();
+    storeBinary = cacheBinary;
+    compilingShaderObjects = shaderObjects;
+    compiling = true;
+    if(!deferStatusChecks) {
+        finishCompiling();
+    }
+}
+
+bool ShaderProgram::isCompiling() const {
+    if(!compiling) {
+        return false;
+    }
+    if(IsParallelCompileSupported()) {
+        int completionStatus = GL_FALSE;
+        glGetProgramiv(program, GL_COMPLETION_STATUS_KHR, &completionStatus);
+        if(completionStatus != GL_TRUE) {
+            return true;
+        }
+    }
+    finishCompiling();
+    return false;
+}
+
+void ShaderProgram::finishCompiling() const {
+    if(!compiling) {
+        return;
+    }
+    // A failed program stays unlinked rather than being checked again
+    std::vector<std::shared_ptr<ShaderObject>> shaderObjects;
+    shaderObjects.swap(compilingShaderObjects);
+    compiling = false;
+    for(size_t i = 0; i < shaderObjects.size(); i++) {
+        shaderObjects[i]->checkCompileStatus();
+    }
+    const_cast<ShaderProgram*>(this)->checkLinkStatus();
+    if(storeBinary) {
+        ProgramBinaryCache::Store(binaryKey, program);
+        storeBinary = false;
+    }
+}
+
+bool ShaderProgram::IsParallelCompileSupported() {
+    return GLAD_GL_KHR_parallel_shader_compile || GLAD_GL_ARB_parallel_shader_compile;
 }
 
 ShaderProgram::~ShaderProgram() {
@@ -77,6 +167,10 @@ ShaderProgram& ShaderProgram::operator=(const ShaderProgram& shaderProgram) {
     release();
     program = shaderProgram.program;
     linked = shaderProgram.linked;
+    compiling = shaderProgram.compiling;
+    compilingShaderObjects = shaderProgram.compilingShaderObjects;
+    storeBinary = shaderProgram.storeBinary;
+    binaryKey = shaderProgram.binaryKey;
     shaderFileNames = shaderProgram.shaderFileNames;
     return (*this);
 }
@@ -108,10 +202,18 @@ void ShaderProgram::detachShaderObject(const std::shared_ptr<ShaderObject> shade
 }
 
 void ShaderProgram::link() {
+    submitLink();
+    checkLinkStatus();
+}
+
+void ShaderProgram::submitLink() {
     if(!program) {
         throw RenderException("ERROR: Attempted to link shader program that wasn't created.");
     }
     glLinkProgram(program);
+}
+
+void ShaderProgram::checkLinkStatus() {
     int linkStatus = 0;
     glGetProgramiv(program, GL_LINK_STATUS, &linkStatus);
     if(linkStatus != GL_TRUE) {
@@ -131,9 +233,13 @@ void ShaderProgram::link() {
 void ShaderProgram::release() {
     if(program != 0) {
         glDeleteProgram(program);
+        GLStateCache::ForgetProgram(program);
     }
     program = 0;
     linked = false;
+    compiling = false;
+    compilingShaderObjects.clear();
+    storeBinary = false;
     while(shaderFileNames.size() > 0) {
         shaderFileNames.pop_back();
     }
@@ -143,54 +249,197 @@ void ShaderProgram::use() const {
     if(!program) {
         throw RenderException("ERROR: Attempted to use shader program that wasn't created.");
     }
+    finishCompiling();
     if(!linked) {
         throw RenderException("ERROR: Attempted to use shader program that linked.");
     }
-    glUseProgram(program);
+    GLStateCache::UseProgram(program);
 }
 
 /*
  * Class ShaderLoader
  */
 std::vector<ShaderProgramPtr> ShaderLoader::loadedShaderPrograms = std::vector<ShaderProgramPtr>();
+std::unordered_map<std::string, ShaderProgramID> ShaderLoader::shaderProgramIDs = std::unordered_map<std::string, ShaderProgramID>();
+std::unordered_map<unsigned long long, ShaderProgramPtr> ShaderLoader::shaderVariants = std::unordered_map<unsigned long long, ShaderProgramPtr>();
+ShaderVariantStats ShaderLoader::shaderVariantStats = ShaderVariantStats();
+ShaderPreprocessor ShaderLoader::shaderPreprocessor = ShaderPreprocessor();
 
 void ShaderLoader::LoadShaderPrograms(const std::vector<ShaderFiles>& shaderFiles) {
 #ifdef _DEBUG
     assert(shaderFiles.size() > 0);
 #endif
+    // Submit every program before checking any, so the driver can compile them in parallel
+    std::vector<ShaderProgramPtr> shaderProgramPtrs;
     for(unsigned int i = 0; i < shaderFiles.size(); i++) {
-        std::vector<GLenum> types;
-        std::vector<std::string> filePaths;
+        shaderProgramPtrs.push_back(BuildShaderProgram(shaderFiles[i], ShaderDefines(), shaderPreprocessor, shaderFiles[i].shaderProgramName, true));
+    }
+    for(unsigned int i = 0; i < shaderProgramPtrs.size(); i++) {
+        shaderProgramPtrs[i]->finishCompiling();
+    }
+    for(unsigned int i = 0; i < shaderProgramPtrs.size(); i++) {
+        AddShaderProgram(shaderProgramPtrs[i]);
+    }
+}
+
+std::shared_future<void> ShaderLoader::LoadShaderProgramsAsync(const std::vector<ShaderFiles>& shaderFiles) {
+#ifdef _DEBUG
+    assert(shaderFiles.size() > 0);
+#endif
+    std::shared_ptr<std::promise<void>> promisePtr = std::make_shared<std::promise<void>>();
+    std::shared_future<void> loadedFuture = promisePtr->get_future().share();
+    // The worker preprocesses with its own copy, so the shared preprocessor is only touched on the main thread
+    ShaderPreprocessor preprocessor = shaderPreprocessor;
+    AsyncLoader::Submit<void>([shaderFiles, promisePtr, preprocessor]() mutable {
+        // Read and preprocess every stage of every program on the worker
+        std::shared_ptr<std::vector<std::vector<std::string>>> sourcesPtr = std::make_shared<std::vector<std::vector<std::string>>>();
+        try {
+            for(unsigned int i = 0; i < shaderFiles.size(); i++) {
+                std::vector<GLenum> types;
+                std::vector<std::string> filePaths;
+                GetShaderStages(shaderFiles[i], types, filePaths);
+                sourcesPtr->push_back(std::vector<std::string>(filePaths.size()));
+                for(unsigned int j = 0; j < filePaths.size(); j++) {
+                    sourcesPtr->back()[j] = preprocessor.process(filePaths[j]);
+                }
+            }
+        }
+        catch(...) {
+            promisePtr->set_exception(std::current_exception());
+            return;
+        }
+        AsyncLoader::QueueOnMainThread([shaderFiles, promisePtr, sourcesPtr]() {
+            try {
+                std::vector<ShaderProgramPtr> shaderProgramPtrs;
+                for(unsigned int i = 0; i < shaderFiles.size(); i++) {
+                    std::vector<GLenum> types;
+                    std::vector<std::string> filePaths;
+                    GetShaderStages(shaderFiles[i], types, filePaths);
+                    shaderProgramPtrs.push_back(std::make_shared<ShaderProgram>(types, filePaths, (*sourcesPtr)[i], shaderFiles[i].shaderProgramName,
+                            std::vector<std::string>(), true));
+                }
+                for(unsigned int i = 0; i < shaderProgramPtrs.size(); i++) {
+                    shaderProgramPtrs[i]->finishCompiling();
+                }
+                for(unsigned int i = 0; i < shaderProgramPtrs.size(); i++) {
+                    AddShaderProgram(shaderProgramPtrs[i]);
+                }
+                promisePtr->set_value();
+            }
+            catch(...) {
+                promisePtr->set_exception(std::current_exception());
+            }
+        });
+    });
+    return loadedFuture;
+}
+
+void ShaderLoader::SubmitShaderPrograms(const std::vector<ShaderFiles>& shaderFiles) {
 #ifdef _DEBUG
-        assert(shaderFiles[i].shaderProgramName != "");
-        assert(shaderFiles[i].vertexShaderFilePath != "");
-        assert(shaderFiles[i].fragmentShaderFilePath != "");
+    assert(shaderFiles.size() > 0);
 #endif
-        types.push_back(GL_VERTEX_SHADER);
-        types.push_back(GL_FRAGMENT_SHADER);
-        filePaths.push_back(shaderFiles[i].vertexShaderFilePath);
-        filePaths.push_back(shaderFiles[i].fragmentShaderFilePath);
-        if(shaderFiles[i].geometryShaderFilePath != "") {
-            types.push_back(GL_GEOMETRY_SHADER);
-            filePaths.push_back(shaderFiles[i].geometryShaderFilePath);
+    for(unsigned int i = 0; i < shaderFiles.size(); i++) {
+        AddShaderProgram(BuildShaderProgram(shaderFiles[i], ShaderDefines(), shaderPreprocessor, shaderFiles[i].shaderProgramName, true));
+    }
+}
+
+unsigned int ShaderLoader::GetNumCompilingShaderPrograms() {
+    unsigned int numCompiling = 0;
+    for(unsigned int i = 0; i < loadedShaderPrograms.size(); i++) {
+        if(loadedShaderPrograms[i] != nullptr && loadedShaderPrograms[i]->isCompiling()) {
+            numCompiling++;
         }
-        ShaderProgramPtr shaderProgramPtr = std::make_shared<ShaderProgram>(types, filePaths, shaderFiles[i].shaderProgramName);
-        loadedShaderPrograms.push_back(shaderProgramPtr);
     }
+    return numCompiling;
 }
 
-ShaderProgramPtr ShaderLoader::getShaderProgram(const std::string& shaderProgramName) {
-    int index = -1;
+void ShaderLoader::FinishShaderPrograms() {
     for(unsigned int i = 0; i < loadedShaderPrograms.size(); i++) {
-        if(shaderProgramName == loadedShaderPrograms[i]->getShaderProgramName()) {
-            index = i;
-            break;
+        if(loadedShaderPrograms[i] != nullptr) {
+            loadedShaderPrograms[i]->finishCompiling();
         }
     }
+}
+
+void ShaderLoader::Destroy() {
+    loadedShaderPrograms.clear();
+    shaderVariants.clear();
+}
+
+void ShaderLoader::GetShaderStages(const ShaderFiles& shaderFiles, std::vector<GLenum>& types, std::vector<std::string>& filePaths) {
+#ifdef _DEBUG
+    assert(shaderFiles.shaderProgramName != "");
+    assert(shaderFiles.vertexShaderFilePath != "");
+    assert(shaderFiles.fragmentShaderFilePath != "");
+#endif
+    types.push_back(GL_VERTEX_SHADER);
+    types.push_back(GL_FRAGMENT_SHADER);
+    filePaths.push_back(shaderFiles.vertexShaderFilePath);
+    filePaths.push_back(shaderFiles.fragmentShaderFilePath);
+    if(shaderFiles.geometryShaderFilePath != "") {
+        types.push_back(GL_GEOMETRY_SHADER);
+        filePaths.push_back(shaderFiles.geometryShaderFilePath);
+    }
+}
+
+ShaderProgramPtr ShaderLoader::BuildShaderProgram(const ShaderFiles& shaderFiles, const ShaderDefines& defines, ShaderPreprocessor& preprocessor,
+        const std::string& shaderProgramName, const bool deferStatusChecks) {
+    std::vector<GLenum> types;
+    std::vector<std::string> filePaths;
+    GetShaderStages(shaderFiles, types, filePaths);
+    std::vector<std::string> sources(filePaths.size());
+    for(unsigned int i = 0; i < filePaths.size(); i++) {
+        sources[i] = preprocessor.process(filePaths[i], defines);
+    }
+    return std::make_shared<ShaderProgram>(types, filePaths, sources, shaderProgramName, ShaderPreprocessor::GetCanonicalDefines(defines), deferStatusChecks);
+}
+
+ShaderProgramPtr ShaderLoader::GetShaderVariant(const ShaderFiles& shaderFiles, const ShaderDefines& defines) {
+    std::vector<GLenum> types;
+    std::vector<std::string> filePaths;
+    GetShaderStages(shaderFiles, types, filePaths);
+    unsigned long long variantHash = ShaderPreprocessor::GetVariantHash(filePaths, defines);
+    std::unordered_map<unsigned long long, ShaderProgramPtr>::iterator iter = shaderVariants.find(variantHash);
+    if(iter != shaderVariants.end()) {
+        shaderVariantStats.numHits++;
+        return iter->second;
+    }
+    
+    // Name the variant after its program and defines, e.g. "myShader[INSTANCED,LIGHTS=4]"
+    std::string shaderProgramName = shaderFiles.shaderProgramName;
+    std::vector<std::string> canonicalDefines = ShaderPreprocessor::GetCanonicalDefines(defines);
+    for(unsigned int i = 0; i < canonicalDefines.size(); i++) {
+        shaderProgramName += (i == 0 ? "[" : ",") + canonicalDefines[i] + (i + 1 == canonicalDefines.size() ? "]" : "");
+    }
+    ShaderProgramPtr shaderProgramPtr = BuildShaderProgram(shaderFiles, defines, shaderPreprocessor, shaderProgramName, false);
+    shaderVariants[variantHash] = shaderProgramPtr;
+    shaderVariantStats.numCompiles++;
+    return shaderProgramPtr;
+}
+
+ShaderProgramPtr ShaderLoader::getShaderProgram(const std::string& shaderProgramName) {
+    std::unordered_map<std::string, ShaderProgramID>::iterator iter = shaderProgramIDs.find(shaderProgramName);
+    ShaderProgramPtr shaderProgramPtr = (iter == shaderProgramIDs.end()) ? nullptr : getShaderProgram(iter->second);
 #ifdef _DEBUG
-    assert(index != -1);
+    assert(shaderProgramPtr != nullptr);
 #endif
-    return loadedShaderPrograms[index];
+    return shaderProgramPtr;
+}
+
+ShaderProgramPtr ShaderLoader::getShaderProgram(const ShaderProgramID shaderProgramID) {
+    return (shaderProgramID < loadedShaderPrograms.size()) ? loadedShaderPrograms[shaderProgramID] : nullptr;
+}
+
+ShaderProgramID ShaderLoader::GetShaderProgramID(const std::string& shaderProgramName) {
+    return shaderProgramIDs.insert({shaderProgramName, (ShaderProgramID)shaderProgramIDs.size()}).first->second;
+}
+
+void ShaderLoader::AddShaderProgram(const ShaderProgramPtr shaderProgramPtr) {
+    ShaderProgramID shaderProgramID = GetShaderProgramID(shaderProgramPtr->getShaderProgramName());
+    if(shaderProgramID >= loadedShaderPrograms.size()) {
+        loadedShaderPrograms.resize(shaderProgramID + 1);
+    }
+    loadedShaderPrograms[shaderProgramID] = shaderProgramPtr;
 }
 
 };
@@ -16,6 +16,9 @@
 #include <math/vector.h>
 #include <math/matrix.h>
 #include <fileio/fileio.h>
+#include <fileio/async_loader.h>
+#include <graphics/shaders/shader_preprocessor.h>
+#include <unordered_map>
 
 #include <glad/glad.h>
 
@@ -27,7 +30,18 @@ class ShaderObject {
         ShaderObject(const GLenum type, const std::string filePath);
         ~ShaderObject();
         void load(const std::string filePath);
+        
+        /*
+         * Creates the shader object from source already read from filePath.
+         */
+        void loadSource(const std::string& source, const std::string filePath);
         void compile();
+        
+        /*
+         * Starts compiling the shader without waiting for the result, which checkCompileStatus waits for.
+         */
+        void submitCompile();
+        void checkCompileStatus();
         void release();
         GLenum getType() { return type; }
         GLuint getShader() { return shader; }
@@ -40,18 +54,52 @@ class ShaderObject {
 
 class ShaderProgram {
     public:
-        ShaderProgram() : program(0), linked(false), shaderProgramName("") {}
+        ShaderProgram() : program(0), linked(false), compiling(false), shaderProgramName(""), storeBinary(false), binaryKey(0) {}
         ShaderProgram(const std::vector<GLenum> types, const std::vector<std::string> filePaths, const std::string shaderProgramName);
+        
+        /*
+         * Compiles and links shader sources already read from filePaths, preprocessed with defines given canonically
+         * (see ShaderPreprocessor::GetCanonicalDefines). With deferStatusChecks the program is only submitted to the
+         * driver, which may compile it on its own threads, and the compile and link statuses are checked when it's
+         * first used or isCompiling finds it done.
+         */
+        ShaderProgram(const std::vector<GLenum> types, const std::vector<std::string> filePaths, const std::vector<std::string> sources,
+                const std::string shaderProgramName, const std::vector<std::string> defines = std::vector<std::string>(),
+                const bool deferStatusChecks = false);
         ~ShaderProgram();
         ShaderProgram& operator=(const ShaderProgram& shaderProgram);
         
         void create();
         void addShaderObject(const std::shared_ptr<ShaderObject> shaderObject);
         void link();
+        
+        /*
+         * Starts linking the program without waiting for the result, which checkLinkStatus waits for.
+         */
+        void submitLink();
+        void checkLinkStatus();
         void detachShaderObject(const std::shared_ptr<ShaderObject> shaderObject);
         void release();
         void use() const;
         
+        /*
+         * Returns whether the driver is still compiling or linking a program whose status checks were deferred. Once
+         * it's done the statuses are checked, throwing RenderException if either failed. Without
+         * KHR_parallel_shader_compile the driver can't be asked, so this waits for it and returns false.
+         */
+        bool isCompiling() const;
+        
+        /*
+         * Waits for a program whose status checks were deferred and checks them, throwing RenderException if
+         * compiling or linking failed.
+         */
+        void finishCompiling() const;
+        
+        /*
+         * Returns whether the driver can compile and link programs on its own threads, reporting when they're done.
+         */
+        static bool IsParallelCompileSupported();
+        
         GLint getUniformLocation(const std::string variableName) const;
         void setUniformFloat(const std::string variableName, float val) const;
         void setUniformDouble(const std::string variableName, double val) const;
@@ -91,10 +139,24 @@ class ShaderProgram {
         GLuint getProgram() { return program; }
         std::string getShaderProgramName() { return shaderProgramName; }
     private:
+        /*
+         * Creates the program from sources, from the program binary cache if it holds it and otherwise by compiling
+         * and linking them.
+         */
+        void build(const std::vector<GLenum>& types, const std::vector<std::string>& filePaths, const std::vector<std::string>& sources,
+                const std::string& shaderProgramName, const std::vector<std::string>& defines, const bool deferStatusChecks);
+        
         GLuint program;
-        bool linked;
+        // Deferred status checks are made by const functions such as use, as the program is first needed
+        mutable bool linked;
+        mutable bool compiling;
+        // Kept until their compile statuses are checked
+        mutable std::vector<std::shared_ptr<ShaderObject>> compilingShaderObjects;
         std::string shaderProgramName;
         std::vector<std::string> shaderFileNames;
+        // Whether to store the program's binary once linked, under binaryKey
+        mutable bool storeBinary;
+        unsigned long long binaryKey;
 };
 
 typedef std::shared_ptr<ShaderProgram> ShaderProgramPtr;
@@ -106,6 +168,18 @@ struct ShaderFiles {
     std::string fragmentShaderFilePath = "";
 };
 
+/*
+ * Interned name of a shader program, see ShaderLoader::GetShaderProgramID.
+ */
+typedef unsigned int ShaderProgramID;
+
+struct ShaderVariantStats {
+    // Lookups that found the variant already compiled
+    unsigned long long numHits = 0;
+    // Lookups that compiled the variant
+    unsigned long long numCompiles = 0;
+};
+
 class ShaderLoader {
     public:
         /*
@@ -113,14 +187,102 @@ class ShaderLoader {
          */
         static void LoadShaderPrograms(const std::vector<ShaderFiles>& shaderFiles);
         
+        /*
+         * Reads the shader files on an AsyncLoader worker thread, then compiles and buffers the shader programs on the
+         * main thread during AsyncLoader::ProcessMainThreadTasks. The returned future becomes ready once the programs
+         * can be found with getShaderProgram, or holds the exception thrown while loading them.
+         */
+        static std::shared_future<void> LoadShaderProgramsAsync(const std::vector<ShaderFiles>& shaderFiles);
+        
+        /*
+         * Submits every shader program in shaderFiles to the driver without waiting for any of them to compile, so
+         * the driver can compile them in parallel while the engine carries on. The programs can be found with
+         * getShaderProgram at once; their compile and link statuses are checked when they're first used or polled with
+         * ShaderProgram::isCompiling, so materials can render with a fallback program until then.
+         */
+        static void SubmitShaderPrograms(const std::vector<ShaderFiles>& shaderFiles);
+        
+        /*
+         * Returns the number of loaded shader programs the driver is still compiling or linking.
+         */
+        static unsigned int GetNumCompilingShaderPrograms();
+        
+        /*
+         * Waits for every loaded shader program to finish compiling and linking.
+         */
+        static void FinishShaderPrograms();
+        
+        /*
+         * Forgets every loaded shader program and variant, releasing those nothing else holds, e.g. before the OpenGL
+         * context goes away. Interned IDs are kept.
+         */
+        static void Destroy();
+        
         /*
          * Returns pointer to ShaderProgram buffered with OpenGL from list of buffered shader programs with name
-         * shaderProgramName.
+         * shaderProgramName. Looking up a name that isn't loaded is a programming error and asserts in debug builds;
+         * use the ShaderProgramID overload to test whether a program is loaded.
          */
         static ShaderProgramPtr getShaderProgram(const std::string& shaderProgramName);
+        
+        /*
+         * Returns the program loaded under the name shaderProgramID was interned from, or nullptr if none is. Looking
+         * a program up by ID is an index rather than a string hash, for code that asks for it often.
+         */
+        static ShaderProgramPtr getShaderProgram(const ShaderProgramID shaderProgramID);
+        
+        /*
+         * Returns the ID interned for shaderProgramName, giving it the next one the first time it's asked for. IDs
+         * stay the same for as long as the engine runs, whether or not a program is loaded under the name.
+         */
+        static ShaderProgramID GetShaderProgramID(const std::string& shaderProgramName);
+        
+        /*
+         * Returns the variant of the shader program in shaderFiles built with defines, compiling it the first time
+         * that permutation is asked for. Variants are told apart by ShaderPreprocessor::GetVariantHash, so the order
+         * the defines were set in doesn't matter.
+         */
+        static ShaderProgramPtr GetShaderVariant(const ShaderFiles& shaderFiles, const ShaderDefines& defines = ShaderDefines());
+        
+        static unsigned int GetNumShaderVariants() { return shaderVariants.size(); }
+        
+        /*
+         * Releases the variants nothing else holds and forgets them all.
+         */
+        static void ClearShaderVariants() { shaderVariants.clear(); }
+        
+        static const ShaderVariantStats& GetShaderVariantStats() { return shaderVariantStats; }
+        static void ResetShaderVariantStats() { shaderVariantStats = ShaderVariantStats(); }
+        
+        /*
+         * The preprocessor every shader file is loaded through, to add include directories to or replace.
+         */
+        static ShaderPreprocessor& GetShaderPreprocessor() { return shaderPreprocessor; }
     private:
+        /*
+         * Appends the shader types and file paths of the stages given by shaderFiles.
+         */
+        static void GetShaderStages(const ShaderFiles& shaderFiles, std::vector<GLenum>& types, std::vector<std::string>& filePaths);
+        
+        /*
+         * Builds the shader program in shaderFiles with preprocessor, named shaderProgramName, deferring its status checks
+         * if deferStatusChecks.
+         */
+        static ShaderProgramPtr BuildShaderProgram(const ShaderFiles& shaderFiles, const ShaderDefines& defines, ShaderPreprocessor& preprocessor,
+                const std::string& shaderProgramName, const bool deferStatusChecks);
+        
+        /*
+         * Registers shaderProgramPtr under the ID of its name, replacing any program loaded under it before.
+         */
+        static void AddShaderProgram(const ShaderProgramPtr shaderProgramPtr);
+        
         // CHANGE TO SINGLETON PATTERN TO ALLOW RESEARTING OF ENGINE!!!!!!!!!!!!
+        // By ShaderProgramID, nullptr where no program is loaded
         static std::vector<ShaderProgramPtr> loadedShaderPrograms;
+        static std::unordered_map<std::string, ShaderProgramID> shaderProgramIDs;
+        static std::unordered_map<unsigned long long, ShaderProgramPtr> shaderVariants;
+        static ShaderVariantStats shaderVariantStats;
+        static ShaderPreprocessor shaderPreprocessor;
 };
 
 };
@@ -0,0 +1,180 @@
+#include "shader_preprocessor.h"
+#include <fileio/fileio.h>
+#include <fileio/hash.h>
+#include <filesystem>
+#include <cassert>
+
+namespace Engine {
+
+static std::string normalizePath(const std::filesystem::path& path) {
+    return path.lexically_normal().generic_string();
+}
+
+// Returns the word following the '#' of a preprocessor directive line, or "" if line isn't one
+static std::string getDirective(const std::string& line, size_t& directiveEnd) {
+    size_t hashPosition = line.find_first_not_of(" \t");
+    if(hashPosition == std::string::npos || line[hashPosition] != '#') {
+        return "";
+    }
+    size_t directiveStart = line.find_first_not_of(" \t", hashPosition + 1);
+    if(directiveStart == std::string::npos) {
+        return "";
+    }
+    directiveEnd = line.find_first_of(" \t", directiveStart);
+    if(directiveEnd == std::string::npos) {
+        directiveEnd = line.size();
+    }
+    return line.substr(directiveStart, directiveEnd - directiveStart);
+}
+
+/*
+ * Class ShaderPreprocessor
+ */
+ShaderPreprocessor::ShaderPreprocessor() : ShaderPreprocessor([](const std::string& filePath, std::string& source) {
+    std::error_code errorCode;
+    if(!std::filesystem::is_regular_file(filePath, errorCode)) {
+        return false;
+    }
+    readFile(filePath, source);
+    return true;
+}) {}
+
+ShaderPreprocessor::ShaderPreprocessor(const SourceReader& sourceReader)
+    : sourceReader(sourceReader), includeDirectories(), fileCache(), sourceFiles(), includedFiles(), numFileReads(0) {}
+
+std::string ShaderPreprocessor::process(const std::string& filePath, const ShaderDefines& defines) {
+    sourceFiles.clear();
+    includedFiles.clear();
+    std::string rootFilePath = normalizePath(filePath);
+    if(readSource(rootFilePath) == nullptr) {
+        throw FileIOException("ERROR: Failed to open shader file \"" + filePath + "\"");
+    }
+    includedFiles.insert(rootFilePath);
+    std::string output;
+    appendFile(rootFilePath, output, true, defines);
+    return output;
+}
+
+std::vector<std::string> ShaderPreprocessor::GetCanonicalDefines(const ShaderDefines& defines) {
+    std::vector<std::string> canonicalDefines;
+    for(ShaderDefines::const_iterator iter = defines.begin(); iter != defines.end(); iter++) {
+        canonicalDefines.push_back(iter->second.empty() ? iter->first : iter->first + "=" + iter->second);
+    }
+    return canonicalDefines;
+}
+
+unsigned long long ShaderPreprocessor::GetVariantHash(const std::vector<std::string>& filePaths, const ShaderDefines& defines) {
+    unsigned long long hash = Hash::OFFSET_BASIS;
+    for(unsigned int i = 0; i < filePaths.size(); i++) {
+        hash = Hash::HashString(hash, normalizePath(filePaths[i]));
+    }
+    std::vector<std::string> canonicalDefines = GetCanonicalDefines(defines);
+    for(unsigned int i = 0; i < canonicalDefines.size(); i++) {
+        hash = Hash::HashString(hash, canonicalDefines[i]);
+    }
+    return hash;
+}
+
+void ShaderPreprocessor::appendFile(const std::string& filePath, std::string& output, const bool isRoot, const ShaderDefines& defines) {
+    // Files are never removed from the cache while processing, so the source stays valid through the includes
+    const std::string& source = *readSource(filePath);
+    unsigned int sourceNumber = sourceFiles.size();
+    sourceFiles.push_back(filePath);
+    if(!isRoot) {
+        output += "#line 1 " + std::to_string(sourceNumber) + "\n";
+    }
+    
+    // The defines go after #version, which must come first, or at the top without one
+    std::string defineLines;
+    for(ShaderDefines::const_iterator iter = defines.begin(); iter != defines.end(); iter++) {
+#ifdef _DEBUG
+        assert(!iter->first.empty());
+#endif
+        defineLines += "#define " + iter->first + (iter->second.empty() ? "" : " " + iter->second) + "\n";
+    }
+    bool definesPending = isRoot && !defineLines.empty();
+    if(definesPending && source.find("#version") == std::string::npos) {
+        output += defineLines + "#line 1 0\n";
+        definesPending = false;
+    }
+    
+    unsigned int lineNumber = 0;
+    size_t lineStart = 0;
+    while(lineStart < source.size()) {
+        size_t lineEnd = source.find('\n', lineStart);
+        if(lineEnd == std::string::npos) {
+            lineEnd = source.size();
+        }
+        std::string line = source.substr(lineStart, lineEnd - lineStart);
+        lineStart = lineEnd + 1;
+        lineNumber++;
+        if(!line.empty() && line.back() == '\r') {
+            line.pop_back();
+        }
+        
+        size_t directiveEnd = 0;
+        std::string directive = getDirective(line, directiveEnd);
+        if(directive == "version") {
+            if(!isRoot) {
+                throw RenderException("ERROR: Included shader file \"" + filePath + "\" has a #version directive.");
+            }
+            output += line + "\n";
+            if(definesPending) {
+                output += defineLines + "#line " + std::to_string(lineNumber + 1) + " 0\n";
+                definesPending = false;
+            }
+        }
+        else if(directive == "include") {
+            size_t pathStart = line.find_first_not_of(" \t", directiveEnd);
+            char closing = (pathStart == std::string::npos) ? 0 : (line[pathStart] == '"') ? '"' : (line[pathStart] == '<') ? '>' : 0;
+            size_t pathEnd = (closing == 0) ? std::string::npos : line.find(closing, pathStart + 1);
+            if(pathEnd == std::string::npos || pathEnd == pathStart + 1) {
+                throw RenderException("ERROR: Malformed #include at line " + std::to_string(lineNumber) + " of shader file \"" + filePath + "\".");
+            }
+            std::string includedFilePath = resolveInclude(line.substr(pathStart + 1, pathEnd - pathStart - 1), filePath);
+            if(includedFiles.insert(includedFilePath).second) {
+                appendFile(includedFilePath, output, false, defines);
+                output += "#line " + std::to_string(lineNumber + 1) + " " + std::to_string(sourceNumber) + "\n";
+            }
+        }
+        else {
+            output += line + "\n";
+        }
+    }
+}
+
+std::string ShaderPreprocessor::resolveInclude(const std::string& includePath, const std::string& includingFilePath) {
+    std::filesystem::path path(includePath);
+    std::vector<std::filesystem::path> candidates;
+    if(path.is_absolute()) {
+        candidates.push_back(path);
+    }
+    else {
+        candidates.push_back(std::filesystem::path(includingFilePath).parent_path() / path);
+        for(unsigned int i = 0; i < includeDirectories.size(); i++) {
+            candidates.push_back(std::filesystem::path(includeDirectories[i]) / path);
+        }
+    }
+    for(unsigned int i = 0; i < candidates.size(); i++) {
+        std::string candidate = normalizePath(candidates[i]);
+        if(readSource(candidate) != nullptr) {
+            return candidate;
+        }
+    }
+    throw FileIOException("ERROR: Failed to find shader file \"" + includePath + "\" included by \"" + includingFilePath + "\"");
+}
+
+const std::string* ShaderPreprocessor::readSource(const std::string& filePath) {
+    std::unordered_map<std::string, std::string>::iterator iter = fileCache.find(filePath);
+    if(iter != fileCache.end()) {
+        return &iter->second;
+    }
+    std::string source;
+    if(!sourceReader(filePath, source)) {
+        return nullptr;
+    }
+    numFileReads++;
+    return &fileCache.emplace(filePath, std::move(source)).first->second;
+}
+
+}
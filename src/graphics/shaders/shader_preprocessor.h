@@ -0,0 +1,98 @@
+#ifndef SHADER_PREPROCESSOR_H
+#define SHADER_PREPROCESSOR_H
+
+#include <exceptions/render_exception.h>
+#include <exceptions/io_exception.h>
+#include <string>
+#include <vector>
+#include <map>
+#include <unordered_map>
+#include <unordered_set>
+#include <functional>
+
+namespace Engine {
+
+/*
+ * Macros defined for a shader variant by name, with an empty value for a macro that is only defined. Being ordered by
+ * name, equal sets of defines are equal however they were put together.
+ */
+typedef std::map<std::string, std::string> ShaderDefines;
+
+/*
+ * ShaderPreprocessor resolves the #include directives of GLSL sources and injects a set of #defines, so code can be
+ * shared between shader files and feature toggles become defines rather than copies of a file.
+ *
+ * Included paths are looked up relative to the including file, then in each include directory in order. Each file is
+ * included at most once per source, so includes need no guards and cycles end. The defines are inserted after the
+ * #version directive, and #line directives keep compiler messages pointing at the line of the right file, numbered
+ * as getSourceFiles lists them. Files are read once per preprocessor and kept for later sources.
+ */
+class ShaderPreprocessor {
+    public:
+        /*
+         * Reads the file at filePath into source, returning false if it doesn't exist.
+         */
+        typedef std::function<bool(const std::string& filePath, std::string& source)> SourceReader;
+        
+        /*
+         * Reads shader files from the file system.
+         */
+        ShaderPreprocessor();
+        ShaderPreprocessor(const SourceReader& sourceReader);
+        
+        void addIncludeDirectory(const std::string& includeDirectory) { includeDirectories.push_back(includeDirectory); }
+        
+        /*
+         * Returns the source of the file at filePath with its includes resolved and defines injected. Throws
+         * FileIOException if a file can't be found and RenderException if an #include is malformed.
+         */
+        std::string process(const std::string& filePath, const ShaderDefines& defines = ShaderDefines());
+        
+        /*
+         * Returns the files the last processed source was made of, by #line source string number.
+         */
+        const std::vector<std::string>& getSourceFiles() const { return sourceFiles; }
+        
+        /*
+         * Forgets the files read so far, so edited files are read again.
+         */
+        void clearFileCache() { fileCache.clear(); }
+        
+        unsigned int getNumFileReads() const { return numFileReads; }
+        
+        /*
+         * Returns the defines as "NAME" or "NAME=VALUE" strings, ordered by name.
+         */
+        static std::vector<std::string> GetCanonicalDefines(const ShaderDefines& defines);
+        
+        /*
+         * Returns a 64-bit FNV-1a hash identifying the variant of the program built from filePaths with defines.
+         */
+        static unsigned long long GetVariantHash(const std::vector<std::string>& filePaths, const ShaderDefines& defines);
+    private:
+        /*
+         * Appends the lines of the file at filePath to output, resolving its includes.
+         */
+        void appendFile(const std::string& filePath, std::string& output, const bool isRoot, const ShaderDefines& defines);
+        
+        /*
+         * Returns the normalized path of the file an #include of includePath in the file at includingFilePath refers
+         * to, and reads it into the file cache.
+         */
+        std::string resolveInclude(const std::string& includePath, const std::string& includingFilePath);
+        
+        // Reads the file at filePath through the file cache, returning nullptr if it doesn't exist
+        const std::string* readSource(const std::string& filePath);
+        
+        SourceReader sourceReader;
+        std::vector<std::string> includeDirectories;
+        std::unordered_map<std::string, std::string> fileCache;
+        std::vector<std::string> sourceFiles;
+        // Files already part of the source being processed
+        std::unordered_set<std::string> includedFiles;
+        unsigned int numFileReads;
+};
+
+}
+
+#endif //SHADER_PREPROCESSOR_H
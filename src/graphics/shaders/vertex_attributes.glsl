@@ -0,0 +1,7 @@
+// Vertex attributes of every mesh, laid out as MeshData buffers them
+layout (location = 0) in vec3 inVertex;
+layout (location = 1) in vec3 inNormal;
+layout (location = 2) in vec2 inTexCoord;
+
+out vec3 myColor;
+out vec2 myTexCoord;
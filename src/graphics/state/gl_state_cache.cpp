@@ -0,0 +1,219 @@
+#include "gl_state_cache.h"
+
+namespace Engine {
+
+/*
+ * Class GLStateCache
+ */
+GLuint GLStateCache::program = UNKNOWN;
+GLuint GLStateCache::vertexArray = UNKNOWN;
+std::unordered_map<GLenum, GLuint> GLStateCache::buffers;
+std::unordered_map<unsigned long long, GLStateCache::BufferRange> GLStateCache::bufferRanges;
+std::unordered_map<GLenum, bool> GLStateCache::capabilities;
+GLenum GLStateCache::blendFunc[2] = {UNKNOWN, UNKNOWN};
+GLenum GLStateCache::depthFunc = UNKNOWN;
+GLuint GLStateCache::depthMask = UNKNOWN;
+GLenum GLStateCache::cullFace = UNKNOWN;
+GLenum GLStateCache::polygonMode = UNKNOWN;
+GLint GLStateCache::viewport[4] = {0, 0, -1, -1};
+bool GLStateCache::clearColorKnown = false;
+float GLStateCache::clearColor[4] = {0.0f, 0.0f, 0.0f, 0.0f};
+GLStateStats GLStateCache::stats;
+GLStateStats GLStateCache::lastFrameStats;
+
+void GLStateCache::UseProgram(const GLuint program) {
+    if(GLStateCache::program == program) {
+        stats.redundantCalls++;
+        return;
+    }
+    glUseProgram(program);
+    GLStateCache::program = program;
+    stats.programBinds++;
+}
+
+void GLStateCache::BindVertexArray(const GLuint vertexArray) {
+    if(GLStateCache::vertexArray == vertexArray) {
+        stats.redundantCalls++;
+        return;
+    }
+    glBindVertexArray(vertexArray);
+    GLStateCache::vertexArray = vertexArray;
+    buffers.erase(GL_ELEMENT_ARRAY_BUFFER);
+    stats.vertexArrayBinds++;
+}
+
+void GLStateCache::BindBuffer(const GLenum target, const GLuint buffer) {
+    std::unordered_map<GLenum, GLuint>::iterator iter = buffers.find(target);
+    if(iter != buffers.end() && iter->second == buffer) {
+        stats.redundantCalls++;
+        return;
+    }
+    glBindBuffer(target, buffer);
+    buffers[target] = buffer;
+    stats.bufferBinds++;
+}
+
+void GLStateCache::BindBufferRange(const GLenum target, const GLuint index, const GLuint buffer, const GLintptr offset, const GLsizeiptr size) {
+    unsigned long long key = ((unsigned long long)target << 32) | index;
+    std::unordered_map<unsigned long long, BufferRange>::iterator iter = bufferRanges.find(key);
+    if(iter != bufferRanges.end() && iter->second.buffer == buffer && iter->second.offset == offset && iter->second.size == size) {
+        stats.redundantCalls++;
+        return;
+    }
+    glBindBufferRange(target, index, buffer, offset, size);
+    bufferRanges[key] = {buffer, offset, size};
+    buffers[target] = buffer;
+    stats.bufferBinds++;
+}
+
+void GLStateCache::SetEnabled(const GLenum capability, const bool enabled) {
+    std::unordered_map<GLenum, bool>::iterator iter = capabilities.find(capability);
+    if(iter != capabilities.end() && iter->second == enabled) {
+        stats.redundantCalls++;
+        return;
+    }
+    if(enabled) {
+        glEnable(capability);
+    }
+    else {
+        glDisable(capability);
+    }
+    capabilities[capability] = enabled;
+    stats.stateChanges++;
+}
+
+void GLStateCache::SetBlendFunc(const GLenum sourceFactor, const GLenum destinationFactor) {
+    if(blendFunc[0] == sourceFactor && blendFunc[1] == destinationFactor) {
+        stats.redundantCalls++;
+        return;
+    }
+    glBlendFunc(sourceFactor, destinationFactor);
+    blendFunc[0] = sourceFactor;
+    blendFunc[1] = destinationFactor;
+    stats.stateChanges++;
+}
+
+void GLStateCache::SetDepthFunc(const GLenum depthFunc) {
+    if(GLStateCache::depthFunc == depthFunc) {
+        stats.redundantCalls++;
+        return;
+    }
+    glDepthFunc(depthFunc);
+    GLStateCache::depthFunc = depthFunc;
+    stats.stateChanges++;
+}
+
+void GLStateCache::SetDepthMask(const bool depthMask) {
+    if(GLStateCache::depthMask == (GLuint)depthMask) {
+        stats.redundantCalls++;
+        return;
+    }
+    glDepthMask(depthMask ? GL_TRUE : GL_FALSE);
+    GLStateCache::depthMask = depthMask;
+    stats.stateChanges++;
+}
+
+void GLStateCache::SetCullFace(const GLenum cullFace) {
+    if(GLStateCache::cullFace == cullFace) {
+        stats.redundantCalls++;
+        return;
+    }
+    glCullFace(cullFace);
+    GLStateCache::cullFace = cullFace;
+    stats.stateChanges++;
+}
+
+void GLStateCache::SetPolygonMode(const GLenum polygonMode) {
+    if(GLStateCache::polygonMode == polygonMode) {
+        stats.redundantCalls++;
+        return;
+    }
+    glPolygonMode(GL_FRONT_AND_BACK, polygonMode);
+    GLStateCache::polygonMode = polygonMode;
+    stats.stateChanges++;
+}
+
+void GLStateCache::SetViewport(const GLint x, const GLint y, const GLsizei width, const GLsizei height) {
+    if(viewport[0] == x && viewport[1] == y && viewport[2] == width && viewport[3] == height) {
+        stats.redundantCalls++;
+        return;
+    }
+    glViewport(x, y, width, height);
+    viewport[0] = x;
+    viewport[1] = y;
+    viewport[2] = width;
+    viewport[3] = height;
+    stats.stateChanges++;
+}
+
+void GLStateCache::SetClearColor(const float red, const float green, const float blue, const float alpha) {
+    if(clearColorKnown && clearColor[0] == red && clearColor[1] == green && clearColor[2] == blue && clearColor[3] == alpha) {
+        stats.redundantCalls++;
+        return;
+    }
+    glClearColor(red, green, blue, alpha);
+    clearColor[0] = red;
+    clearColor[1] = green;
+    clearColor[2] = blue;
+    clearColor[3] = alpha;
+    clearColorKnown = true;
+    stats.stateChanges++;
+}
+
+void GLStateCache::ForgetProgram(const GLuint program) {
+    // A deleted program stays in use until another is, so don't assume what is
+    if(GLStateCache::program == program) {
+        GLStateCache::program = UNKNOWN;
+    }
+}
+
+void GLStateCache::ForgetVertexArray(const GLuint vertexArray) {
+    if(GLStateCache::vertexArray == vertexArray) {
+        GLStateCache::vertexArray = 0;
+        buffers.erase(GL_ELEMENT_ARRAY_BUFFER);
+    }
+}
+
+void GLStateCache::ForgetBuffer(const GLuint buffer) {
+    for(std::unordered_map<GLenum, GLuint>::iterator iter = buffers.begin(); iter != buffers.end(); iter++) {
+        if(iter->second == buffer) {
+            iter->second = 0;
+        }
+    }
+    for(std::unordered_map<unsigned long long, BufferRange>::iterator iter = bufferRanges.begin(); iter != bufferRanges.end(); iter++) {
+        if(iter->second.buffer == buffer) {
+            iter->second = {0, 0, 0};
+        }
+    }
+}
+
+void GLStateCache::Invalidate() {
+    program = UNKNOWN;
+    vertexArray = UNKNOWN;
+    buffers.clear();
+    bufferRanges.clear();
+    capabilities.clear();
+    blendFunc[0] = UNKNOWN;
+    blendFunc[1] = UNKNOWN;
+    depthFunc = UNKNOWN;
+    depthMask = UNKNOWN;
+    cullFace = UNKNOWN;
+    polygonMode = UNKNOWN;
+    viewport[2] = -1;
+    clearColorKnown = false;
+    TextureUnitState::Invalidate();
+}
+
+void GLStateCache::EndFrame() {
+    lastFrameStats = GetFrameStats();
+    stats = GLStateStats();
+    TextureUnitState::ResetStats();
+}
+
+GLStateStats GLStateCache::GetFrameStats() {
+    GLStateStats frameStats = stats;
+    frameStats.textureStats = TextureUnitState::GetStats();
+    return frameStats;
+}
+
+}
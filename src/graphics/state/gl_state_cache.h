@@ -0,0 +1,130 @@
+#ifndef GL_STATE_CACHE_H
+#define GL_STATE_CACHE_H
+
+#include <graphics/texture/texture_units.h>
+#include <unordered_map>
+
+#include <glad/glad.h>
+
+namespace Engine {
+
+/*
+ * Counts of the OpenGL state calls made through GLStateCache and of those it skipped.
+ */
+struct GLStateStats {
+    unsigned long long programBinds = 0;
+    unsigned long long vertexArrayBinds = 0;
+    unsigned long long bufferBinds = 0;
+    // Enables, disables and blend, depth, raster, viewport and clear color changes
+    unsigned long long stateChanges = 0;
+    // Calls skipped because they would have set what was already set
+    unsigned long long redundantCalls = 0;
+    // Texture unit and sampler binds, counted by TextureUnitState
+    TextureBindStats textureStats;
+    
+    unsigned long long getNumRedundantCalls() const { return redundantCalls + textureStats.redundantBinds; }
+};
+
+/*
+ * GLStateCache tracks the bound program, vertex array and buffers, the enabled capabilities and the blend, depth and
+ * raster state, and only makes the OpenGL calls that change them. Texture units and samplers are tracked by
+ * TextureUnitState, which it forwards to. All such state changes in the engine go through it so the tracked state
+ * stays true; call Invalidate if anything else changes it, or after the context is recreated.
+ *
+ * Counts are kept per frame: call EndFrame once the frame's commands have been submitted.
+ */
+class GLStateCache {
+    public:
+        static void UseProgram(const GLuint program);
+        static void BindVertexArray(const GLuint vertexArray);
+        
+        /*
+         * Binds buffer to target. The element array buffer belongs to the bound vertex array, so binding a vertex
+         * array forgets it.
+         */
+        static void BindBuffer(const GLenum target, const GLuint buffer);
+        
+        /*
+         * Binds size bytes of buffer from offset to binding point index of target, e.g. GL_UNIFORM_BUFFER, which also
+         * binds buffer to target.
+         */
+        static void BindBufferRange(const GLenum target, const GLuint index, const GLuint buffer, const GLintptr offset, const GLsizeiptr size);
+        
+        /*
+         * Binds textureName and sampler to texture unit unit, see TextureUnitState::Bind.
+         */
+        static void BindTexture(const unsigned int unit, const GLuint textureName, const GLuint sampler) { TextureUnitState::Bind(unit, textureName, sampler); }
+        
+        /*
+         * Enables or disables capability, e.g. GL_DEPTH_TEST, GL_BLEND or GL_CULL_FACE.
+         */
+        static void SetEnabled(const GLenum capability, const bool enabled);
+        static void SetBlendFunc(const GLenum sourceFactor, const GLenum destinationFactor);
+        static void SetDepthFunc(const GLenum depthFunc);
+        static void SetDepthMask(const bool depthMask);
+        static void SetCullFace(const GLenum cullFace);
+        
+        /*
+         * Sets the polygon mode of both faces, the only one core profile allows.
+         */
+        static void SetPolygonMode(const GLenum polygonMode);
+        static void SetViewport(const GLint x, const GLint y, const GLsizei width, const GLsizei height);
+        static void SetClearColor(const float red, const float green, const float blue, const float alpha);
+        
+        /*
+         * Records that program (or vertexArray, or buffer) was deleted, which unbinds it if bound.
+         */
+        static void ForgetProgram(const GLuint program);
+        static void ForgetVertexArray(const GLuint vertexArray);
+        static void ForgetBuffer(const GLuint buffer);
+        
+        /*
+         * Forgets all tracked state, including the texture units', so the next call of each kind is made whatever
+         * OpenGL holds.
+         */
+        static void Invalidate();
+        
+        /*
+         * Ends the frame, keeping its counts as the last frame's and starting new ones.
+         */
+        static void EndFrame();
+        
+        /*
+         * Returns the counts of the frame so far.
+         */
+        static GLStateStats GetFrameStats();
+        static const GLStateStats& GetLastFrameStats() { return lastFrameStats; }
+    private:
+        // Marks state that isn't known
+        static constexpr GLuint UNKNOWN = ~(GLuint)0;
+        
+        static GLuint program;
+        static GLuint vertexArray;
+        // Buffers by target, leaving out targets whose binding isn't known
+        static std::unordered_map<GLenum, GLuint> buffers;
+        struct BufferRange {
+            GLuint buffer;
+            GLintptr offset;
+            GLsizeiptr size;
+        };
+        // By target in the high and binding point index in the low 32 bits
+        static std::unordered_map<unsigned long long, BufferRange> bufferRanges;
+        // Whether each capability is enabled, leaving out capabilities whose state isn't known
+        static std::unordered_map<GLenum, bool> capabilities;
+        static GLenum blendFunc[2];
+        static GLenum depthFunc;
+        // 0 or 1, or UNKNOWN
+        static GLuint depthMask;
+        static GLenum cullFace;
+        static GLenum polygonMode;
+        // A width of -1 marks an unknown viewport
+        static GLint viewport[4];
+        static bool clearColorKnown;
+        static float clearColor[4];
+        static GLStateStats stats;
+        static GLStateStats lastFrameStats;
+};
+
+}
+
+#endif //GL_STATE_CACHE_H
@@ -0,0 +1,726 @@
+#include "block_compressor.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <limits>
+
+namespace Engine {
+
+// Weight of the first endpoint for each BC1 index
+static const float bc1EndpointWeights[4] = {1.0f, 0.0f, 2.0f / 3.0f, 1.0f / 3.0f};
+
+// Weight of the first endpoint for each BC4 index in the eight value mode
+static const float bc4EndpointWeights[8] = {1.0f, 0.0f, 6.0f / 7.0f, 5.0f / 7.0f, 4.0f / 7.0f, 3.0f / 7.0f, 2.0f / 7.0f, 1.0f / 7.0f};
+
+// Weight of the second endpoint in 64ths for each 4-bit BC7 index
+static const unsigned int bc7IndexWeights[16] = {0, 4, 9, 13, 17, 21, 26, 30, 34, 38, 43, 47, 51, 55, 60, 64};
+
+// How far the initial endpoints are pulled in from the extremes of a block, for the 4 color BC1 palette and the 16
+// color BC7 palette
+static const float BC1_INSET_FRACTION = 1.0f / 16.0f;
+static const float BC7_INSET_FRACTION = 0.0f;
+
+static float clampChannel(const float value) {
+    return std::min(std::max(value, 0.0f), 255.0f);
+}
+
+static unsigned short quantize565(const float color[3]) {
+    unsigned int red = (unsigned int)(clampChannel(color[0]) * 31.0f / 255.0f + 0.5f);
+    unsigned int green = (unsigned int)(clampChannel(color[1]) * 63.0f / 255.0f + 0.5f);
+    unsigned int blue = (unsigned int)(clampChannel(color[2]) * 31.0f / 255.0f + 0.5f);
+    return (unsigned short)((red << 11) | (green << 5) | blue);
+}
+
+static void expand565(const unsigned short packedColor, int color[3]) {
+    int red = (packedColor >> 11) & 31;
+    int green = (packedColor >> 5) & 63;
+    int blue = packedColor & 31;
+    color[0] = (red << 3) | (red >> 2);
+    color[1] = (green << 2) | (green >> 4);
+    color[2] = (blue << 3) | (blue >> 2);
+}
+
+// The four colors of a BC1 block in index order
+static void bc1Palette(const unsigned short color0, const unsigned short color1, const bool fourColors, int palette[4][3]) {
+    expand565(color0, palette[0]);
+    expand565(color1, palette[1]);
+    for(unsigned int c = 0; c < 3; c++) {
+        if(fourColors) {
+            palette[2][c] = (2 * palette[0][c] + palette[1][c] + 1) / 3;
+            palette[3][c] = (palette[0][c] + 2 * palette[1][c] + 1) / 3;
+        }
+        else {
+            palette[2][c] = (palette[0][c] + palette[1][c] + 1) / 2;
+            palette[3][c] = 0;
+        }
+    }
+}
+
+// The eight values of a BC4 block in index order
+static void bc4Palette(const int value0, const int value1, int palette[8]) {
+    palette[0] = value0;
+    palette[1] = value1;
+    if(value0 > value1) {
+        for(int i = 1; i < 7; i++) {
+            palette[i + 1] = ((7 - i) * value0 + i * value1 + 3) / 7;
+        }
+    }
+    else {
+        for(int i = 1; i < 5; i++) {
+            palette[i + 1] = ((5 - i) * value0 + i * value1 + 2) / 5;
+        }
+        palette[6] = 0;
+        palette[7] = 255;
+    }
+}
+
+static void writeBits(unsigned char* block, unsigned int& bitPosition, const unsigned int value, const unsigned int numBits) {
+    for(unsigned int i = 0; i < numBits; i++) {
+        if((value >> i) & 1) {
+            block[bitPosition / 8] |= (unsigned char)(1 << (bitPosition % 8));
+        }
+        bitPosition++;
+    }
+}
+
+static unsigned int readBits(const unsigned char* block, unsigned int& bitPosition, const unsigned int numBits) {
+    unsigned int value = 0;
+    for(unsigned int i = 0; i < numBits; i++) {
+        value |= ((block[bitPosition / 8] >> (bitPosition % 8)) & 1) << i;
+        bitPosition++;
+    }
+    return value;
+}
+
+/*
+ * Sets endpoints to the corners of the bounding box of the first numChannels channels, inset by insetFraction of the
+ * range at each end. Insetting suits palettes with few entries, which can't reach the extremes of a block anyway.
+ */
+static void boundingBoxEndpoints(const float channels[4][16], const unsigned int numChannels, const float insetFraction, float endpoints[2][4]) {
+    for(unsigned int c = 0; c < numChannels; c++) {
+        float minValue = channels[c][0];
+        float maxValue = channels[c][0];
+        for(unsigned int i = 1; i < 16; i++) {
+            minValue = std::min(minValue, channels[c][i]);
+            maxValue = std::max(maxValue, channels[c][i]);
+        }
+        float inset = (maxValue - minValue) * insetFraction;
+        endpoints[0][c] = maxValue - inset;
+        endpoints[1][c] = minValue + inset;
+    }
+}
+
+/*
+ * Sets endpoints to the extremes of the block projected onto its principal axis, found by power iteration on the
+ * covariance of the first numChannels channels, inset by insetFraction of the projected range at each end.
+ */
+static void principalAxisEndpoints(const float channels[4][16], const unsigned int numChannels, const float insetFraction, float endpoints[2][4]) {
+    float mean[4] = {0.0f, 0.0f, 0.0f, 0.0f};
+    for(unsigned int c = 0; c < numChannels; c++) {
+        for(unsigned int i = 0; i < 16; i++) {
+            mean[c] += channels[c][i];
+        }
+        mean[c] /= 16.0f;
+    }
+    float covariance[4][4] = {};
+    for(unsigned int c0 = 0; c0 < numChannels; c0++) {
+        for(unsigned int c1 = c0; c1 < numChannels; c1++) {
+            float sum = 0.0f;
+            for(unsigned int i = 0; i < 16; i++) {
+                sum += (channels[c0][i] - mean[c0]) * (channels[c1][i] - mean[c1]);
+            }
+            covariance[c0][c1] = sum;
+            covariance[c1][c0] = sum;
+        }
+    }
+    
+    // Start from the channel with the largest variance
+    float axis[4] = {0.0f, 0.0f, 0.0f, 0.0f};
+    unsigned int largestChannel = 0;
+    for(unsigned int c = 1; c < numChannels; c++) {
+        if(covariance[c][c] > covariance[largestChannel][largestChannel]) {
+            largestChannel = c;
+        }
+    }
+    for(unsigned int c = 0; c < numChannels; c++) {
+        axis[c] = covariance[largestChannel][c];
+    }
+    for(unsigned int iteration = 0; iteration < 8; iteration++) {
+        float nextAxis[4] = {0.0f, 0.0f, 0.0f, 0.0f};
+        float length = 0.0f;
+        for(unsigned int c0 = 0; c0 < numChannels; c0++) {
+            for(unsigned int c1 = 0; c1 < numChannels; c1++) {
+                nextAxis[c0] += covariance[c0][c1] * axis[c1];
+            }
+            length = std::max(length, std::fabs(nextAxis[c0]));
+        }
+        if(length < 1e-6f) {
+            break;
+        }
+        for(unsigned int c = 0; c < numChannels; c++) {
+            axis[c] = nextAxis[c] / length;
+        }
+    }
+    float lengthSquared = 0.0f;
+    for(unsigned int c = 0; c < numChannels; c++) {
+        lengthSquared += axis[c] * axis[c];
+    }
+    if(lengthSquared < 1e-12f) {
+        // Flat block
+        for(unsigned int c = 0; c < numChannels; c++) {
+            endpoints[0][c] = mean[c];
+            endpoints[1][c] = mean[c];
+        }
+        return;
+    }
+    
+    float minProjection = std::numeric_limits<float>::max();
+    float maxProjection = std::numeric_limits<float>::lowest();
+    for(unsigned int i = 0; i < 16; i++) {
+        float projection = 0.0f;
+        for(unsigned int c = 0; c < numChannels; c++) {
+            projection += (channels[c][i] - mean[c]) * axis[c];
+        }
+        minProjection = std::min(minProjection, projection);
+        maxProjection = std::max(maxProjection, projection);
+    }
+    float inset = (maxProjection - minProjection) * insetFraction;
+    maxProjection -= inset;
+    minProjection += inset;
+    for(unsigned int c = 0; c < numChannels; c++) {
+        endpoints[0][c] = clampChannel(mean[c] + axis[c] * maxProjection / lengthSquared);
+        endpoints[1][c] = clampChannel(mean[c] + axis[c] * minProjection / lengthSquared);
+    }
+}
+
+/*
+ * Solves for the endpoints that best fit the block by least squares, given each pixel's index and the weight of the
+ * first endpoint for each index. Returns false if every pixel has the same weight.
+ */
+static bool leastSquaresEndpoints(const float channels[4][16], const unsigned int numChannels, const unsigned char indices[16],
+        const float* endpointWeights, float endpoints[2][4]) {
+    float weightSquares0 = 0.0f;
+    float weightProducts = 0.0f;
+    float weightSquares1 = 0.0f;
+    float weightedSums0[4] = {0.0f, 0.0f, 0.0f, 0.0f};
+    float weightedSums1[4] = {0.0f, 0.0f, 0.0f, 0.0f};
+    for(unsigned int i = 0; i < 16; i++) {
+        float weight0 = endpointWeights[indices[i]];
+        float weight1 = 1.0f - weight0;
+        weightSquares0 += weight0 * weight0;
+        weightProducts += weight0 * weight1;
+        weightSquares1 += weight1 * weight1;
+        for(unsigned int c = 0; c < numChannels; c++) {
+            weightedSums0[c] += weight0 * channels[c][i];
+            weightedSums1[c] += weight1 * channels[c][i];
+        }
+    }
+    float determinant = weightSquares0 * weightSquares1 - weightProducts * weightProducts;
+    if(std::fabs(determinant) < 1e-6f) {
+        return false;
+    }
+    for(unsigned int c = 0; c < numChannels; c++) {
+        endpoints[0][c] = clampChannel((weightedSums0[c] * weightSquares1 - weightedSums1[c] * weightProducts) / determinant);
+        endpoints[1][c] = clampChannel((weightedSums1[c] * weightSquares0 - weightedSums0[c] * weightProducts) / determinant);
+    }
+    return true;
+}
+
+/*
+ * Picks the index of the nearest palette color for each pixel of a BC1 block and returns the squared error. Orders
+ * the endpoints so the block decodes with four colors.
+ */
+static float evaluateBC1(const float channels[4][16], unsigned short& color0, unsigned short& color1, unsigned char indices[16]) {
+    if(color0 < color1) {
+        std::swap(color0, color1);
+    }
+    int palette[4][3];
+    bc1Palette(color0, color1, true, palette);
+    // An equal pair decodes with three colors, so only index 0 is safe to use
+    unsigned int numColors = (color0 == color1) ? 1 : 4;
+    float error = 0.0f;
+    for(unsigned int i = 0; i < 16; i++) {
+        float bestDistance = std::numeric_limits<float>::max();
+        for(unsigned int p = 0; p < numColors; p++) {
+            float distance = 0.0f;
+            for(unsigned int c = 0; c < 3; c++) {
+                float difference = channels[c][i] - palette[p][c];
+                distance += difference * difference;
+            }
+            if(distance < bestDistance) {
+                bestDistance = distance;
+                indices[i] = p;
+            }
+        }
+        error += bestDistance;
+    }
+    return error;
+}
+
+/*
+ * Picks the index of the nearest palette value for each pixel of a BC4 block and returns the squared error.
+ */
+static float evaluateBC4(const float values[16], const int value0, const int value1, unsigned char indices[16]) {
+    int palette[8];
+    bc4Palette(value0, value1, palette);
+    float error = 0.0f;
+    for(unsigned int i = 0; i < 16; i++) {
+        float bestDistance = std::numeric_limits<float>::max();
+        for(unsigned int p = 0; p < 8; p++) {
+            float difference = values[i] - palette[p];
+            if(difference * difference < bestDistance) {
+                bestDistance = difference * difference;
+                indices[i] = p;
+            }
+        }
+        error += bestDistance;
+    }
+    return error;
+}
+
+/*
+ * Quantizes a BC7 mode 6 endpoint to 7 bits per channel plus the shared low bit that fits it best.
+ */
+static void quantizeBC7Endpoint(const float endpoint[4], unsigned int quantized[4], unsigned int& parityBit) {
+    float bestError = std::numeric_limits<float>::max();
+    for(unsigned int parity = 0; parity < 2; parity++) {
+        unsigned int candidate[4];
+        float error = 0.0f;
+        for(unsigned int c = 0; c < 4; c++) {
+            float value = (clampChannel(endpoint[c]) - parity) / 2.0f;
+            candidate[c] = (unsigned int)std::min(std::max(value + 0.5f, 0.0f), 127.0f);
+            float difference = (float)((candidate[c] << 1) | parity) - endpoint[c];
+            error += difference * difference;
+        }
+        if(error < bestError) {
+            bestError = error;
+            parityBit = parity;
+            std::memcpy(quantized, candidate, sizeof(candidate));
+        }
+    }
+}
+
+/*
+ * Quantizes the endpoints of a BC7 mode 6 block, picks the index of the nearest palette color for each pixel and
+ * returns the squared error.
+ */
+static float evaluateBC7(const float channels[4][16], const float endpoints[2][4], unsigned int quantized[2][4],
+        unsigned int parityBits[2], unsigned char indices[16]) {
+    int expanded[2][4];
+    for(unsigned int e = 0; e < 2; e++) {
+        quantizeBC7Endpoint(endpoints[e], quantized[e], parityBits[e]);
+        for(unsigned int c = 0; c < 4; c++) {
+            expanded[e][c] = (int)((quantized[e][c] << 1) | parityBits[e]);
+        }
+    }
+    float palette[16][4];
+    for(unsigned int p = 0; p < 16; p++) {
+        for(unsigned int c = 0; c < 4; c++) {
+            palette[p][c] = (float)(((64 - bc7IndexWeights[p]) * expanded[0][c] + bc7IndexWeights[p] * expanded[1][c] + 32) >> 6);
+        }
+    }
+    float error = 0.0f;
+    for(unsigned int i = 0; i < 16; i++) {
+        float bestDistance = std::numeric_limits<float>::max();
+        for(unsigned int p = 0; p < 16; p++) {
+            float distance = 0.0f;
+            for(unsigned int c = 0; c < 4; c++) {
+                float difference = channels[c][i] - palette[p][c];
+                distance += difference * difference;
+            }
+            if(distance < bestDistance) {
+                bestDistance = distance;
+                indices[i] = p;
+            }
+        }
+        error += bestDistance;
+    }
+    return error;
+}
+
+/*
+ * Class BlockCompressor
+ */
+SharedBuffer<unsigned char> BlockCompressor::CompressImage(const unsigned char* pixels, const unsigned int width, const unsigned int height,
+        const unsigned int numChannels, const CompressedFormat format, const CompressionQuality quality) {
+#ifdef _DEBUG
+    assert(width > 0 && height > 0);
+    assert(numChannels > 0 && numChannels <= 4);
+    assert(format != COMPRESSED_FORMAT_NONE);
+#endif
+    std::vector<unsigned char> blocks(GetCompressedSize(width, height, format), 0);
+    unsigned int numBlockRows = (height + 3) / 4;
+    
+    // Bands after the first go to the workers while this thread compresses the first
+    std::vector<std::future<void>> bandResults;
+    unsigned char* blocksPtr = blocks.data();
+    for(unsigned int firstBlockRow = BLOCK_ROWS_PER_TASK; firstBlockRow < numBlockRows; firstBlockRow += BLOCK_ROWS_PER_TASK) {
+        unsigned int lastBlockRow = std::min(firstBlockRow + BLOCK_ROWS_PER_TASK, numBlockRows);
+        bandResults.push_back(AsyncLoader::Submit<void>([pixels, width, height, numChannels, format, quality, firstBlockRow, lastBlockRow, blocksPtr]() {
+            CompressBlockRows(pixels, width, height, numChannels, format, quality, firstBlockRow, lastBlockRow, blocksPtr);
+        }));
+    }
+    CompressBlockRows(pixels, width, height, numChannels, format, quality, 0, std::min(BLOCK_ROWS_PER_TASK, numBlockRows), blocksPtr);
+    for(unsigned int i = 0; i < bandResults.size(); i++) {
+        bandResults[i].get();
+    }
+    return SharedBuffer<unsigned char>(std::move(blocks));
+}
+
+std::vector<unsigned char> BlockCompressor::DecompressImage(const unsigned char* blocks, const unsigned int width, const unsigned int height,
+        const CompressedFormat format, const unsigned int numChannels) {
+#ifdef _DEBUG
+    assert(numChannels > 0 && numChannels <= 4);
+    assert(format != COMPRESSED_FORMAT_NONE);
+#endif
+    std::vector<unsigned char> pixels((size_t)width * height * numChannels);
+    unsigned int blockSize = GetBlockSizeInBytes(format);
+    unsigned int numBlockColumns = (width + 3) / 4;
+    unsigned int numBlockRows = (height + 3) / 4;
+    for(unsigned int blockY = 0; blockY < numBlockRows; blockY++) {
+        for(unsigned int blockX = 0; blockX < numBlockColumns; blockX++) {
+            const unsigned char* block = blocks + ((size_t)blockY * numBlockColumns + blockX) * blockSize;
+            unsigned char decoded[16][4];
+            for(unsigned int i = 0; i < 16; i++) {
+                decoded[i][0] = 0;
+                decoded[i][1] = 0;
+                decoded[i][2] = 0;
+                decoded[i][3] = 255;
+            }
+            switch(format) {
+                case COMPRESSED_FORMAT_BC1:
+                    DecodeBC1Block(block, false, decoded);
+                    break;
+                case COMPRESSED_FORMAT_BC3:
+                    DecodeBC4Block(block, 3, decoded);
+                    DecodeBC1Block(block + 8, true, decoded);
+                    break;
+                case COMPRESSED_FORMAT_BC5:
+                    DecodeBC4Block(block, 0, decoded);
+                    DecodeBC4Block(block + 8, 1, decoded);
+                    break;
+                default:
+                    DecodeBC7Block(block, decoded);
+                    break;
+            }
+            for(unsigned int i = 0; i < 16; i++) {
+                unsigned int x = blockX * 4 + i % 4;
+                unsigned int y = blockY * 4 + i / 4;
+                if(x >= width || y >= height) {
+                    continue;
+                }
+                std::memcpy(pixels.data() + ((size_t)y * width + x) * numChannels, decoded[i], numChannels);
+            }
+        }
+    }
+    return pixels;
+}
+
+double BlockCompressor::ComputePSNR(const unsigned char* original, const unsigned char* decoded, const size_t numBytes) {
+    double squaredError = 0.0;
+    for(size_t i = 0; i < numBytes; i++) {
+        double difference = (double)original[i] - (double)decoded[i];
+        squaredError += difference * difference;
+    }
+    if(squaredError == 0.0) {
+        return std::numeric_limits<double>::infinity();
+    }
+    return 10.0 * std::log10(255.0 * 255.0 * (double)numBytes / squaredError);
+}
+
+unsigned int BlockCompressor::GetBlockSizeInBytes(const CompressedFormat format) {
+    return (format == COMPRESSED_FORMAT_BC1) ? 8 : 16;
+}
+
+size_t BlockCompressor::GetCompressedSize(const unsigned int width, const unsigned int height, const CompressedFormat format) {
+    return (size_t)((width + 3) / 4) * (size_t)((height + 3) / 4) * GetBlockSizeInBytes(format);
+}
+
+unsigned int BlockCompressor::GetNumChannels(const CompressedFormat format) {
+    switch(format) {
+        case COMPRESSED_FORMAT_BC1:
+            return 3;
+        case COMPRESSED_FORMAT_BC5:
+            return 2;
+        default:
+            return 4;
+    }
+}
+
+void BlockCompressor::CompressBlockRows(const unsigned char* pixels, const unsigned int width, const unsigned int height,
+        const unsigned int numChannels, const CompressedFormat format, const CompressionQuality quality,
+        const unsigned int firstBlockRow, const unsigned int lastBlockRow, unsigned char* blocks) {
+    unsigned int blockSize = GetBlockSizeInBytes(format);
+    unsigned int numBlockColumns = (width + 3) / 4;
+    PixelBlock block;
+    for(unsigned int blockY = firstBlockRow; blockY < lastBlockRow; blockY++) {
+        for(unsigned int blockX = 0; blockX < numBlockColumns; blockX++) {
+            unsigned char* output = blocks + ((size_t)blockY * numBlockColumns + blockX) * blockSize;
+            LoadBlock(pixels, width, height, numChannels, blockX, blockY, block);
+            switch(format) {
+                case COMPRESSED_FORMAT_BC1:
+                    EncodeBC1Block(block, quality, output);
+                    break;
+                case COMPRESSED_FORMAT_BC3:
+                    EncodeBC4Block(block.channels[3], quality, output);
+                    EncodeBC1Block(block, quality, output + 8);
+                    break;
+                case COMPRESSED_FORMAT_BC5:
+                    EncodeBC4Block(block.channels[0], quality, output);
+                    EncodeBC4Block(block.channels[1], quality, output + 8);
+                    break;
+                default:
+                    EncodeBC7Block(block, quality, output);
+                    break;
+            }
+        }
+    }
+}
+
+void BlockCompressor::LoadBlock(const unsigned char* pixels, const unsigned int width, const unsigned int height,
+        const unsigned int numChannels, const unsigned int blockX, const unsigned int blockY, PixelBlock& block) {
+    for(unsigned int i = 0; i < 16; i++) {
+        unsigned int x = std::min(blockX * 4 + i % 4, width - 1);
+        unsigned int y = std::min(blockY * 4 + i / 4, height - 1);
+        const unsigned char* pixel = pixels + ((size_t)y * width + x) * numChannels;
+        block.channels[0][i] = pixel[0];
+        block.channels[1][i] = (numChannels == 1) ? pixel[0] : pixel[1];
+        block.channels[2][i] = (numChannels == 1) ? pixel[0] : ((numChannels == 2) ? 0.0f : pixel[2]);
+        block.channels[3][i] = (numChannels == 4) ? pixel[3] : 255.0f;
+    }
+}
+
+void BlockCompressor::EncodeBC1Block(const PixelBlock& block, const CompressionQuality quality, unsigned char* output) {
+    float endpoints[2][4];
+    if(quality == COMPRESSION_QUALITY_FAST) {
+        boundingBoxEndpoints(block.channels, 3, BC1_INSET_FRACTION, endpoints);
+    }
+    else {
+        principalAxisEndpoints(block.channels, 3, BC1_INSET_FRACTION, endpoints);
+    }
+    unsigned short colors[2] = {quantize565(endpoints[0]), quantize565(endpoints[1])};
+    unsigned char indices[16];
+    float error = evaluateBC1(block.channels, colors[0], colors[1], indices);
+    
+    if(quality == COMPRESSION_QUALITY_HIGH) {
+        // Refit the endpoints to the chosen indices while that lowers the error
+        for(unsigned int iteration = 0; iteration < 2; iteration++) {
+            float refinedEndpoints[2][4];
+            if(!leastSquaresEndpoints(block.channels, 3, indices, bc1EndpointWeights, refinedEndpoints)) {
+                break;
+            }
+            unsigned short refinedColors[2] = {quantize565(refinedEndpoints[0]), quantize565(refinedEndpoints[1])};
+            unsigned char refinedIndices[16];
+            float refinedError = evaluateBC1(block.channels, refinedColors[0], refinedColors[1], refinedIndices);
+            if(refinedError >= error) {
+                break;
+            }
+            error = refinedError;
+            colors[0] = refinedColors[0];
+            colors[1] = refinedColors[1];
+            std::memcpy(indices, refinedIndices, sizeof(indices));
+        }
+    }
+    
+    output[0] = (unsigned char)(colors[0] & 0xFF);
+    output[1] = (unsigned char)(colors[0] >> 8);
+    output[2] = (unsigned char)(colors[1] & 0xFF);
+    output[3] = (unsigned char)(colors[1] >> 8);
+    unsigned int packedIndices = 0;
+    for(unsigned int i = 0; i < 16; i++) {
+        packedIndices |= (unsigned int)indices[i] << (2 * i);
+    }
+    for(unsigned int i = 0; i < 4; i++) {
+        output[4 + i] = (unsigned char)((packedIndices >> (8 * i)) & 0xFF);
+    }
+}
+
+void BlockCompressor::EncodeBC4Block(const float* values, const CompressionQuality quality, unsigned char* output) {
+    float minValue = values[0];
+    float maxValue = values[0];
+    // Range of the values other than 0 and 255, which the six value mode stores exactly
+    float innerMinValue = 255.0f;
+    float innerMaxValue = 0.0f;
+    for(unsigned int i = 0; i < 16; i++) {
+        minValue = std::min(minValue, values[i]);
+        maxValue = std::max(maxValue, values[i]);
+        if(values[i] > 0.0f && values[i] < 255.0f) {
+            innerMinValue = std::min(innerMinValue, values[i]);
+            innerMaxValue = std::max(innerMaxValue, values[i]);
+        }
+    }
+    
+    // Eight values spanning the whole range
+    int bestValues[2] = {(int)(maxValue + 0.5f), (int)(minValue + 0.5f)};
+    unsigned char indices[16];
+    float error = evaluateBC4(values, bestValues[0], bestValues[1], indices);
+    if(quality != COMPRESSION_QUALITY_FAST && innerMinValue <= innerMaxValue) {
+        // Six values over the inner range, plus exact 0 and 255
+        unsigned char candidateIndices[16];
+        int candidateValues[2] = {(int)(innerMinValue + 0.5f), (int)(innerMaxValue + 0.5f)};
+        float candidateError = evaluateBC4(values, candidateValues[0], candidateValues[1], candidateIndices);
+        if(candidateError < error) {
+            error = candidateError;
+            bestValues[0] = candidateValues[0];
+            bestValues[1] = candidateValues[1];
+            std::memcpy(indices, candidateIndices, sizeof(indices));
+        }
+    }
+    if(quality == COMPRESSION_QUALITY_HIGH && bestValues[0] > bestValues[1]) {
+        // Refit the eight value endpoints to the chosen indices while that lowers the error
+        float channels[4][16];
+        std::memcpy(channels[0], values, sizeof(channels[0]));
+        for(unsigned int iteration = 0; iteration < 2; iteration++) {
+            float refinedEndpoints[2][4];
+            if(!leastSquaresEndpoints(channels, 1, indices, bc4EndpointWeights, refinedEndpoints)) {
+                break;
+            }
+            int refinedValues[2] = {(int)(refinedEndpoints[0][0] + 0.5f), (int)(refinedEndpoints[1][0] + 0.5f)};
+            if(refinedValues[0] <= refinedValues[1]) {
+                break;
+            }
+            unsigned char refinedIndices[16];
+            float refinedError = evaluateBC4(values, refinedValues[0], refinedValues[1], refinedIndices);
+            if(refinedError >= error) {
+                break;
+            }
+            error = refinedError;
+            bestValues[0] = refinedValues[0];
+            bestValues[1] = refinedValues[1];
+            std::memcpy(indices, refinedIndices, sizeof(indices));
+        }
+    }
+    
+    output[0] = (unsigned char)bestValues[0];
+    output[1] = (unsigned char)bestValues[1];
+    unsigned long long packedIndices = 0;
+    for(unsigned int i = 0; i < 16; i++) {
+        packedIndices |= (unsigned long long)indices[i] << (3 * i);
+    }
+    for(unsigned int i = 0; i < 6; i++) {
+        output[2 + i] = (unsigned char)((packedIndices >> (8 * i)) & 0xFF);
+    }
+}
+
+void BlockCompressor::EncodeBC7Block(const PixelBlock& block, const CompressionQuality quality, unsigned char* output) {
+    // Mode 6 only, a single pair of RGBA endpoints with 4-bit indices
+    float endpoints[2][4];
+    if(quality == COMPRESSION_QUALITY_FAST) {
+        boundingBoxEndpoints(block.channels, 4, BC7_INSET_FRACTION, endpoints);
+    }
+    else {
+        principalAxisEndpoints(block.channels, 4, BC7_INSET_FRACTION, endpoints);
+    }
+    unsigned int quantized[2][4];
+    unsigned int parityBits[2];
+    unsigned char indices[16];
+    float error = evaluateBC7(block.channels, endpoints, quantized, parityBits, indices);
+    
+    if(quality == COMPRESSION_QUALITY_HIGH) {
+        float endpointWeights[16];
+        for(unsigned int i = 0; i < 16; i++) {
+            endpointWeights[i] = 1.0f - bc7IndexWeights[i] / 64.0f;
+        }
+        for(unsigned int iteration = 0; iteration < 2; iteration++) {
+            float refinedEndpoints[2][4];
+            if(!leastSquaresEndpoints(block.channels, 4, indices, endpointWeights, refinedEndpoints)) {
+                break;
+            }
+            unsigned int refinedQuantized[2][4];
+            unsigned int refinedParityBits[2];
+            unsigned char refinedIndices[16];
+            float refinedError = evaluateBC7(block.channels, refinedEndpoints, refinedQuantized, refinedParityBits, refinedIndices);
+            if(refinedError >= error) {
+                break;
+            }
+            error = refinedError;
+            std::memcpy(quantized, refinedQuantized, sizeof(quantized));
+            std::memcpy(parityBits, refinedParityBits, sizeof(parityBits));
+            std::memcpy(indices, refinedIndices, sizeof(indices));
+        }
+    }
+    
+    // The first pixel's index is stored without its top bit, so it must be below 8
+    if(indices[0] >= 8) {
+        for(unsigned int c = 0; c < 4; c++) {
+            std::swap(quantized[0][c], quantized[1][c]);
+        }
+        std::swap(parityBits[0], parityBits[1]);
+        for(unsigned int i = 0; i < 16; i++) {
+            indices[i] = 15 - indices[i];
+        }
+    }
+    
+    std::memset(output, 0, 16);
+    unsigned int bitPosition = 0;
+    writeBits(output, bitPosition, 1 << 6, 7);
+    for(unsigned int c = 0; c < 4; c++) {
+        writeBits(output, bitPosition, quantized[0][c], 7);
+        writeBits(output, bitPosition, quantized[1][c], 7);
+    }
+    writeBits(output, bitPosition, parityBits[0], 1);
+    writeBits(output, bitPosition, parityBits[1], 1);
+    for(unsigned int i = 0; i < 16; i++) {
+        writeBits(output, bitPosition, indices[i], (i == 0) ? 3 : 4);
+    }
+}
+
+void BlockCompressor::DecodeBC1Block(const unsigned char* input, const bool alwaysFourColors, unsigned char decoded[16][4]) {
+    unsigned short color0 = (unsigned short)(input[0] | (input[1] << 8));
+    unsigned short color1 = (unsigned short)(input[2] | (input[3] << 8));
+    bool fourColors = alwaysFourColors || color0 > color1;
+    int palette[4][3];
+    bc1Palette(color0, color1, fourColors, palette);
+    unsigned int packedIndices = input[4] | (input[5] << 8) | (input[6] << 16) | ((unsigned int)input[7] << 24);
+    for(unsigned int i = 0; i < 16; i++) {
+        unsigned int index = (packedIndices >> (2 * i)) & 3;
+        for(unsigned int c = 0; c < 3; c++) {
+            decoded[i][c] = (unsigned char)palette[index][c];
+        }
+        if(!fourColors && index == 3) {
+            decoded[i][3] = 0;
+        }
+    }
+}
+
+void BlockCompressor::DecodeBC4Block(const unsigned char* input, const unsigned int channel, unsigned char decoded[16][4]) {
+    int palette[8];
+    bc4Palette(input[0], input[1], palette);
+    unsigned long long packedIndices = 0;
+    for(unsigned int i = 0; i < 6; i++) {
+        packedIndices |= (unsigned long long)input[2 + i] << (8 * i);
+    }
+    for(unsigned int i = 0; i < 16; i++) {
+        decoded[i][channel] = (unsigned char)palette[(packedIndices >> (3 * i)) & 7];
+    }
+}
+
+void BlockCompressor::DecodeBC7Block(const unsigned char* input, unsigned char decoded[16][4]) {
+    unsigned int bitPosition = 0;
+    unsigned int mode = readBits(input, bitPosition, 7);
+#ifdef _DEBUG
+    assert(mode == (1 << 6));
+#endif
+    if(mode != (1 << 6)) {
+        return;
+    }
+    unsigned int endpoints[2][4];
+    for(unsigned int c = 0; c < 4; c++) {
+        endpoints[0][c] = readBits(input, bitPosition, 7) << 1;
+        endpoints[1][c] = readBits(input, bitPosition, 7) << 1;
+    }
+    unsigned int parityBit0 = readBits(input, bitPosition, 1);
+    unsigned int parityBit1 = readBits(input, bitPosition, 1);
+    for(unsigned int c = 0; c < 4; c++) {
+        endpoints[0][c] |= parityBit0;
+        endpoints[1][c] |= parityBit1;
+    }
+    for(unsigned int i = 0; i < 16; i++) {
+        unsigned int weight = bc7IndexWeights[readBits(input, bitPosition, (i == 0) ? 3 : 4)];
+        for(unsigned int c = 0; c < 4; c++) {
+            decoded[i][c] = (unsigned char)(((64 - weight) * endpoints[0][c] + weight * endpoints[1][c] + 32) >> 6);
+        }
+    }
+}
+
+}
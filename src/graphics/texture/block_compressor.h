@@ -0,0 +1,112 @@
+#ifndef BLOCK_COMPRESSOR_H
+#define BLOCK_COMPRESSOR_H
+
+#include <fileio/async_loader.h>
+#include <graphics/buffer/shared_buffer.h>
+#include <vector>
+#include <cassert>
+
+namespace Engine {
+
+/*
+ * Block compressed formats, each storing 4x4 pixel blocks in a fixed number of bytes.
+ */
+enum CompressedFormat {
+    COMPRESSED_FORMAT_NONE,
+    // RGB in 8 bytes per block (4 bits per pixel)
+    COMPRESSED_FORMAT_BC1,
+    // RGBA in 16 bytes per block, BC1 color plus a separate alpha block
+    COMPRESSED_FORMAT_BC3,
+    // Two independent channels in 16 bytes per block, for tangent space normal maps and masks
+    COMPRESSED_FORMAT_BC5,
+    // RGBA in 16 bytes per block, with finer endpoints and indices than BC1 and BC3
+    COMPRESSED_FORMAT_BC7
+};
+
+/*
+ * Trade-off between encoding time and quality.
+ */
+enum CompressionQuality {
+    // Endpoints from the bounding box of each block
+    COMPRESSION_QUALITY_FAST,
+    // Endpoints along the principal axis of each block
+    COMPRESSION_QUALITY_NORMAL,
+    // Principal axis endpoints refined by least squares, with extra endpoint candidates for the alpha and channel blocks
+    COMPRESSION_QUALITY_HIGH
+};
+
+/*
+ * BlockCompressor encodes 8-bit images into BCn blocks that can be uploaded with glCompressedTexImage2D, and decodes
+ * them again for measuring quality.
+ *
+ * Blocks are gathered channel by channel so the per pixel loops of the encoder run over contiguous arrays and
+ * vectorize. Images are split into bands of block rows that are compressed on AsyncLoader worker threads.
+ */
+class BlockCompressor {
+    public:
+        /*
+         * Returns the blocks of a width by height image with numChannels channels per pixel and tightly packed rows,
+         * in the order glCompressedTexImage2D expects. Grey images are compressed as RGB and missing channels are read
+         * as 0 (blue) or 255 (alpha). Blocks on the right and top edges repeat the last column and row. Waits for the
+         * worker threads, so it must not be called from an AsyncLoader worker task.
+         */
+        static SharedBuffer<unsigned char> CompressImage(const unsigned char* pixels, const unsigned int width, const unsigned int height,
+                const unsigned int numChannels, const CompressedFormat format, const CompressionQuality quality);
+        
+        /*
+         * Decodes the blocks of a width by height image into numChannels channels per pixel, taking the first
+         * numChannels of red, green, blue and alpha. BC7 blocks must use mode 6, the only mode CompressImage writes.
+         */
+        static std::vector<unsigned char> DecompressImage(const unsigned char* blocks, const unsigned int width, const unsigned int height,
+                const CompressedFormat format, const unsigned int numChannels);
+        
+        /*
+         * Returns the peak signal to noise ratio in dB between numBytes bytes of original and decoded, or infinity if
+         * they are identical.
+         */
+        static double ComputePSNR(const unsigned char* original, const unsigned char* decoded, const size_t numBytes);
+        
+        static unsigned int GetBlockSizeInBytes(const CompressedFormat format);
+        static size_t GetCompressedSize(const unsigned int width, const unsigned int height, const CompressedFormat format);
+        
+        /*
+         * Returns the number of channels the format stores.
+         */
+        static unsigned int GetNumChannels(const CompressedFormat format);
+    private:
+        /*
+         * 4x4 RGBA pixels, stored channel by channel.
+         */
+        struct PixelBlock {
+            float channels[4][16];
+        };
+        
+        /*
+         * Compresses the block rows from firstBlockRow up to lastBlockRow into blocks.
+         */
+        static void CompressBlockRows(const unsigned char* pixels, const unsigned int width, const unsigned int height,
+                const unsigned int numChannels, const CompressedFormat format, const CompressionQuality quality,
+                const unsigned int firstBlockRow, const unsigned int lastBlockRow, unsigned char* blocks);
+        
+        static void LoadBlock(const unsigned char* pixels, const unsigned int width, const unsigned int height,
+                const unsigned int numChannels, const unsigned int blockX, const unsigned int blockY, PixelBlock& block);
+        
+        static void EncodeBC1Block(const PixelBlock& block, const CompressionQuality quality, unsigned char* output);
+        static void EncodeBC4Block(const float* values, const CompressionQuality quality, unsigned char* output);
+        static void EncodeBC7Block(const PixelBlock& block, const CompressionQuality quality, unsigned char* output);
+        
+        /*
+         * Decoders write their channels of 16 RGBA pixels. The color block of BC3 always has four colors, while BC1
+         * blocks whose endpoints aren't in descending order have three and transparent black.
+         */
+        static void DecodeBC1Block(const unsigned char* input, const bool alwaysFourColors, unsigned char decoded[16][4]);
+        static void DecodeBC4Block(const unsigned char* input, const unsigned int channel, unsigned char decoded[16][4]);
+        static void DecodeBC7Block(const unsigned char* input, unsigned char decoded[16][4]);
+        
+        // Block rows compressed by each worker task
+        static constexpr unsigned int BLOCK_ROWS_PER_TASK = 16;
+};
+
+}
+
+#endif //BLOCK_COMPRESSOR_H
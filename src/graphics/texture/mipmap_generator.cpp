@@ -0,0 +1,202 @@
+#include "mipmap_generator.h"
+#include <algorithm>
+#include <cmath>
+
+namespace Engine {
+
+/*
+ * Class MipmapGenerator
+ */
+static const std::vector<float>& sRGBToLinearTable() {
+    static const std::vector<float> table = []() {
+        std::vector<float> values(256);
+        for(unsigned int i = 0; i < 256; i++) {
+            double value = i / 255.0;
+            values[i] = (float)((value <= 0.04045) ? value / 12.92 : std::pow((value + 0.055) / 1.055, 2.4));
+        }
+        return values;
+    }();
+    return table;
+}
+
+// Linear values halfway between consecutive sRGB codes, so encoding rounds to the nearest code
+static const std::vector<float>& linearToSRGBThresholds() {
+    static const std::vector<float> thresholds = []() {
+        std::vector<float> values(255);
+        for(unsigned int i = 0; i < 255; i++) {
+            double value = (i + 0.5) / 255.0;
+            values[i] = (float)((value <= 0.04045) ? value / 12.92 : std::pow((value + 0.055) / 1.055, 2.4));
+        }
+        return values;
+    }();
+    return thresholds;
+}
+
+// Zeroth order modified Bessel function of the first kind
+static double besselI0(const double x) {
+    double sum = 1.0;
+    double term = 1.0;
+    for(unsigned int k = 1; k < 32; k++) {
+        term *= (x / (2.0 * k)) * (x / (2.0 * k));
+        sum += term;
+        if(term < sum * 1e-12) {
+            break;
+        }
+    }
+    return sum;
+}
+
+std::vector<SharedBuffer<unsigned char>> MipmapGenerator::GenerateMipLevels(const unsigned char* pixels, const unsigned int width,
+        const unsigned int height, const unsigned int numChannels, const MipmapFilter filter, const bool sRGB, const unsigned int alphaChannel) {
+#ifdef _DEBUG
+    assert(width > 0 && height > 0);
+    assert(numChannels > 0 && numChannels <= 4);
+#endif
+    std::vector<SharedBuffer<unsigned char>> mipLevels;
+    unsigned int numLevels = GetNumLevels(width, height);
+    if(numLevels == 1) {
+        return mipLevels;
+    }
+    
+    // Alpha is coverage rather than color, so it stays linear
+    std::vector<bool> linearize(numChannels, sRGB);
+    if(alphaChannel < numChannels) {
+        linearize[alphaChannel] = false;
+    }
+    
+    std::vector<float> source((size_t)width * height * numChannels);
+    for(size_t i = 0; i < source.size(); i++) {
+        source[i] = linearize[i % numChannels] ? SRGBToLinear(pixels[i]) : pixels[i] / 255.0f;
+    }
+    
+    std::vector<float> destination;
+    unsigned int sourceWidth = width;
+    unsigned int sourceHeight = height;
+    for(unsigned int level = 1; level < numLevels; level++) {
+        unsigned int destinationWidth = GetLevelSize(width, level);
+        unsigned int destinationHeight = GetLevelSize(height, level);
+        Downsample(source, sourceWidth, sourceHeight, numChannels, destination, destinationWidth, destinationHeight, filter);
+        
+        std::vector<unsigned char> levelPixels(destination.size());
+        for(size_t i = 0; i < destination.size(); i++) {
+            // Negative lobes of the Kaiser filter can overshoot
+            float value = std::min(std::max(destination[i], 0.0f), 1.0f);
+            levelPixels[i] = linearize[i % numChannels] ? LinearToSRGB(value) : (unsigned char)(value * 255.0f + 0.5f);
+        }
+        mipLevels.push_back(SharedBuffer<unsigned char>(std::move(levelPixels)));
+        
+        source.swap(destination);
+        sourceWidth = destinationWidth;
+        sourceHeight = destinationHeight;
+    }
+    return mipLevels;
+}
+
+unsigned int MipmapGenerator::GetNumLevels(const unsigned int width, const unsigned int height) {
+    unsigned int numLevels = 1;
+    unsigned int size = std::max(width, height);
+    while(size > 1) {
+        size /= 2;
+        numLevels++;
+    }
+    return numLevels;
+}
+
+unsigned int MipmapGenerator::GetLevelSize(const unsigned int size, const unsigned int level) {
+    return std::max(size >> level, 1u);
+}
+
+float MipmapGenerator::SRGBToLinear(const unsigned char value) {
+    return sRGBToLinearTable()[value];
+}
+
+unsigned char MipmapGenerator::LinearToSRGB(const float value) {
+    const std::vector<float>& thresholds = linearToSRGBThresholds();
+    return (unsigned char)(std::upper_bound(thresholds.begin(), thresholds.end(), value) - thresholds.begin());
+}
+
+MipmapGenerator::FilterTaps MipmapGenerator::ComputeTaps(const unsigned int sourceSize, const unsigned int destinationSize, const MipmapFilter filter) {
+    FilterTaps filterTaps;
+    float scale = (float)sourceSize / (float)destinationSize;
+    float radius = ((filter == MIPMAP_FILTER_BOX) ? 0.5f : KAISER_RADIUS) * scale;
+    for(unsigned int i = 0; i < destinationSize; i++) {
+        filterTaps.firstTap.push_back(filterTaps.sources.size());
+        // Pixel centers are at half integers
+        float center = (i + 0.5f) * scale;
+        int firstSource = (int)std::floor(center - radius);
+        int lastSource = (int)std::ceil(center + radius);
+        float weightSum = 0.0f;
+        for(int source = firstSource; source <= lastSource; source++) {
+            float weight = FilterWeight((source + 0.5f - center) / scale, filter);
+            if(weight == 0.0f) {
+                continue;
+            }
+            // Clamp to the edge
+            filterTaps.sources.push_back((unsigned int)std::min(std::max(source, 0), (int)sourceSize - 1));
+            filterTaps.weights.push_back(weight);
+            weightSum += weight;
+        }
+        for(unsigned int j = filterTaps.firstTap.back(); j < filterTaps.weights.size(); j++) {
+            filterTaps.weights[j] /= weightSum;
+        }
+    }
+    filterTaps.firstTap.push_back(filterTaps.sources.size());
+    return filterTaps;
+}
+
+float MipmapGenerator::FilterWeight(const float distance, const MipmapFilter filter) {
+    float x = std::fabs(distance);
+    if(filter == MIPMAP_FILTER_BOX) {
+        // A source pixel straddling two destination pixels is split between them
+        return (x < 0.5f) ? 1.0f : ((x == 0.5f) ? 0.5f : 0.0f);
+    }
+    if(x >= KAISER_RADIUS) {
+        return 0.0f;
+    }
+    const float pi = 3.14159265358979f;
+    float sinc = (x < 1e-6f) ? 1.0f : std::sin(pi * x) / (pi * x);
+    float windowPosition = x / KAISER_RADIUS;
+    float window = (float)(besselI0(KAISER_ALPHA * std::sqrt(1.0 - windowPosition * windowPosition)) / besselI0(KAISER_ALPHA));
+    return sinc * window;
+}
+
+void MipmapGenerator::Downsample(const std::vector<float>& source, const unsigned int sourceWidth, const unsigned int sourceHeight,
+        const unsigned int numChannels, std::vector<float>& destination, const unsigned int destinationWidth,
+        const unsigned int destinationHeight, const MipmapFilter filter) {
+    FilterTaps horizontalTaps = ComputeTaps(sourceWidth, destinationWidth, filter);
+    FilterTaps verticalTaps = ComputeTaps(sourceHeight, destinationHeight, filter);
+    
+    // Horizontal pass, sourceHeight rows of destinationWidth pixels
+    size_t sourceRowSize = (size_t)sourceWidth * numChannels;
+    size_t destinationRowSize = (size_t)destinationWidth * numChannels;
+    std::vector<float> rows(destinationRowSize * sourceHeight, 0.0f);
+    for(unsigned int row = 0; row < sourceHeight; row++) {
+        const float* sourceRow = source.data() + row * sourceRowSize;
+        float* rowPixels = rows.data() + row * destinationRowSize;
+        for(unsigned int i = 0; i < destinationWidth; i++) {
+            float* pixel = rowPixels + (size_t)i * numChannels;
+            for(unsigned int tap = horizontalTaps.firstTap[i]; tap < horizontalTaps.firstTap[i + 1]; tap++) {
+                const float* sourcePixel = sourceRow + (size_t)horizontalTaps.sources[tap] * numChannels;
+                float weight = horizontalTaps.weights[tap];
+                for(unsigned int c = 0; c < numChannels; c++) {
+                    pixel[c] += weight * sourcePixel[c];
+                }
+            }
+        }
+    }
+    
+    // Vertical pass, accumulating whole rows
+    destination.assign(destinationRowSize * destinationHeight, 0.0f);
+    for(unsigned int row = 0; row < destinationHeight; row++) {
+        float* destinationRow = destination.data() + row * destinationRowSize;
+        for(unsigned int tap = verticalTaps.firstTap[row]; tap < verticalTaps.firstTap[row + 1]; tap++) {
+            const float* sourceRow = rows.data() + verticalTaps.sources[tap] * destinationRowSize;
+            float weight = verticalTaps.weights[tap];
+            for(size_t i = 0; i < destinationRowSize; i++) {
+                destinationRow[i] += weight * sourceRow[i];
+            }
+        }
+    }
+}
+
+}
@@ -0,0 +1,78 @@
+#ifndef MIPMAP_GENERATOR_H
+#define MIPMAP_GENERATOR_H
+
+#include <graphics/buffer/shared_buffer.h>
+#include <vector>
+#include <cassert>
+
+namespace Engine {
+
+/*
+ * Filter used to shrink each mipmap level into the next.
+ */
+enum MipmapFilter {
+    // Averages the 2x2 block of pixels under each pixel (or the 2.5x2.5 block for odd sizes)
+    MIPMAP_FILTER_BOX,
+    // Kaiser windowed sinc over 3 pixels either side, sharper than the box filter
+    MIPMAP_FILTER_KAISER
+};
+
+/*
+ * MipmapGenerator builds mipmap chains of 8-bit images on the CPU, so they can be generated on worker threads and
+ * uploaded level by level instead of leaving glGenerateMipmap to the driver.
+ *
+ * Levels are filtered separably in floating point, each one from the unrounded previous level. Rows are accumulated
+ * whole so the inner loops are contiguous and vectorize.
+ */
+class MipmapGenerator {
+    public:
+        /*
+         * Returns levels 1 and up of the mipmap chain of a width by height image with numChannels channels per pixel
+         * and tightly packed rows, down to 1x1. If sRGB is true the color channels are filtered in linear space and
+         * alpha (channel alphaChannel, if there is one) as is, otherwise every channel is filtered as is.
+         */
+        static std::vector<SharedBuffer<unsigned char>> GenerateMipLevels(const unsigned char* pixels, const unsigned int width,
+                const unsigned int height, const unsigned int numChannels, const MipmapFilter filter, const bool sRGB,
+                const unsigned int alphaChannel = 3);
+        
+        /*
+         * Returns the number of levels in a full mipmap chain for a width by height image, including level 0.
+         */
+        static unsigned int GetNumLevels(const unsigned int width, const unsigned int height);
+        
+        /*
+         * Returns the width (or height) of mipmap level level of an image size pixels wide (or high).
+         */
+        static unsigned int GetLevelSize(const unsigned int size, const unsigned int level);
+        
+        static float SRGBToLinear(const unsigned char value);
+        static unsigned char LinearToSRGB(const float value);
+    private:
+        /*
+         * The source pixels and weights contributing to each destination pixel along one axis.
+         */
+        struct FilterTaps {
+            // Index of the first tap of each destination pixel, with one extra entry marking the end
+            std::vector<unsigned int> firstTap;
+            std::vector<unsigned int> sources;
+            std::vector<float> weights;
+        };
+        
+        static FilterTaps ComputeTaps(const unsigned int sourceSize, const unsigned int destinationSize, const MipmapFilter filter);
+        static float FilterWeight(const float distance, const MipmapFilter filter);
+        
+        /*
+         * Shrinks a floating point image to destinationWidth by destinationHeight pixels.
+         */
+        static void Downsample(const std::vector<float>& source, const unsigned int sourceWidth, const unsigned int sourceHeight,
+                const unsigned int numChannels, std::vector<float>& destination, const unsigned int destinationWidth,
+                const unsigned int destinationHeight, const MipmapFilter filter);
+        
+        // Radius of the Kaiser filter in destination pixels and the shape of its window
+        static constexpr float KAISER_RADIUS = 3.0f;
+        static constexpr float KAISER_ALPHA = 4.0f;
+};
+
+}
+
+#endif //MIPMAP_GENERATOR_H
@@ -0,0 +1,805 @@
+#include "pixel_format.h"
+#include <algorithm>
+#include <vector>
+#include <cstring>
+#include <cmath>
+
+#if (defined(__x86_64__) || defined(__i386__)) && defined(__GNUC__)
+#define PIXEL_CONVERTER_X86
+#include <immintrin.h>
+#endif
+
+namespace Engine {
+
+/*
+ * Scalar kernels, which also convert the pixels left over by the SIMD kernels
+ */
+static void expandRGBToRGBAScalar(const unsigned char* source, unsigned char* destination, const size_t firstPixel, const size_t numPixels,
+        const unsigned char alpha) {
+    for(size_t i = firstPixel; i < numPixels; i++) {
+        destination[i * 4] = source[i * 3];
+        destination[i * 4 + 1] = source[i * 3 + 1];
+        destination[i * 4 + 2] = source[i * 3 + 2];
+        destination[i * 4 + 3] = alpha;
+    }
+}
+
+static void stripRGBAToRGBScalar(const unsigned char* source, unsigned char* destination, const size_t firstPixel, const size_t numPixels) {
+    for(size_t i = firstPixel; i < numPixels; i++) {
+        destination[i * 3] = source[i * 4];
+        destination[i * 3 + 1] = source[i * 4 + 1];
+        destination[i * 3 + 2] = source[i * 4 + 2];
+    }
+}
+
+static void swizzleRGBAScalar(const unsigned char* source, unsigned char* destination, const size_t firstPixel, const size_t numPixels,
+        const unsigned int order[4]) {
+    for(size_t i = firstPixel; i < numPixels; i++) {
+        unsigned char pixel[4] = {source[i * 4], source[i * 4 + 1], source[i * 4 + 2], source[i * 4 + 3]};
+        for(unsigned int c = 0; c < 4; c++) {
+            destination[i * 4 + c] = pixel[order[c]];
+        }
+    }
+}
+
+static void expandGreyScalar(const unsigned char* source, unsigned char* destination, const size_t firstPixel, const size_t numPixels,
+        const unsigned int numChannels, const unsigned char alpha) {
+    for(size_t i = firstPixel; i < numPixels; i++) {
+        destination[i * numChannels] = source[i];
+        destination[i * numChannels + 1] = source[i];
+        destination[i * numChannels + 2] = source[i];
+        if(numChannels == 4) {
+            destination[i * 4 + 3] = alpha;
+        }
+    }
+}
+
+static void expandGreyAlphaToRGBAScalar(const unsigned char* source, unsigned char* destination, const size_t firstPixel, const size_t numPixels) {
+    for(size_t i = firstPixel; i < numPixels; i++) {
+        destination[i * 4] = source[i * 2];
+        destination[i * 4 + 1] = source[i * 2];
+        destination[i * 4 + 2] = source[i * 2];
+        destination[i * 4 + 3] = source[i * 2 + 1];
+    }
+}
+
+// Rounds value / 255 to the nearest integer for value up to 255 * 255
+static unsigned char divideBy255(const unsigned int value) {
+    unsigned int biased = value + 128;
+    return (unsigned char)((biased + (biased >> 8)) >> 8);
+}
+
+static void premultiplyAlphaScalar(unsigned char* pixels, const size_t firstPixel, const size_t numPixels) {
+    for(size_t i = firstPixel; i < numPixels; i++) {
+        unsigned int alpha = pixels[i * 4 + 3];
+        for(unsigned int c = 0; c < 3; c++) {
+            pixels[i * 4 + c] = divideBy255(pixels[i * 4 + c] * alpha);
+        }
+    }
+}
+
+static void widen8To16Scalar(const unsigned char* source, unsigned short* destination, const size_t firstValue, const size_t numValues) {
+    for(size_t i = firstValue; i < numValues; i++) {
+        destination[i] = (unsigned short)(source[i] * 257);
+    }
+}
+
+static void narrow16To8Scalar(const unsigned short* source, unsigned char* destination, const size_t firstValue, const size_t numValues) {
+    for(size_t i = firstValue; i < numValues; i++) {
+        // Rounds source / 257 to the nearest integer
+        destination[i] = (unsigned char)((source[i] * 255u + 32895u) >> 16);
+    }
+}
+
+static unsigned short floatToHalfScalar(const float value) {
+    unsigned int bits;
+    std::memcpy(&bits, &value, sizeof(bits));
+    unsigned int sign = (bits >> 16) & 0x8000;
+    unsigned int exponent = (bits >> 23) & 0xFF;
+    unsigned int mantissa = bits & 0x7FFFFF;
+    if(exponent == 0xFF) {
+        // Infinity, or a quiet NaN keeping the top of its payload
+        return (unsigned short)(sign | 0x7C00 | ((mantissa != 0) ? 0x200 | (mantissa >> 13) : 0));
+    }
+    int halfExponent = (int)exponent - 127 + 15;
+    if(halfExponent >= 31) {
+        return (unsigned short)(sign | 0x7C00);
+    }
+    if(halfExponent <= 0) {
+        // Subnormal half, shifting out the implicit leading bit too
+        if(halfExponent < -10) {
+            return (unsigned short)sign;
+        }
+        mantissa |= 0x800000;
+        unsigned int shift = 14 - halfExponent;
+        unsigned int halfMantissa = mantissa >> shift;
+        unsigned int remainder = mantissa & ((1u << shift) - 1);
+        unsigned int halfway = 1u << (shift - 1);
+        if(remainder > halfway || (remainder == halfway && (halfMantissa & 1) != 0)) {
+            halfMantissa++;
+        }
+        return (unsigned short)(sign | halfMantissa);
+    }
+    unsigned int half = sign | ((unsigned int)halfExponent << 10) | (mantissa >> 13);
+    unsigned int remainder = mantissa & 0x1FFF;
+    // Rounding up may carry into the exponent, which is still the nearest half (or infinity)
+    if(remainder > 0x1000 || (remainder == 0x1000 && (half & 1) != 0)) {
+        half++;
+    }
+    return (unsigned short)half;
+}
+
+static float halfToFloatScalar(const unsigned short half) {
+    unsigned int sign = (unsigned int)(half & 0x8000) << 16;
+    unsigned int exponent = (half >> 10) & 0x1F;
+    unsigned int mantissa = half & 0x3FF;
+    unsigned int bits = 0;
+    if(exponent == 0) {
+        if(mantissa == 0) {
+            bits = sign;
+        }
+        else {
+            // Normalize the subnormal half
+            unsigned int floatExponent = 113;
+            while((mantissa & 0x400) == 0) {
+                mantissa <<= 1;
+                floatExponent--;
+            }
+            bits = sign | (floatExponent << 23) | ((mantissa & 0x3FF) << 13);
+        }
+    }
+    else if(exponent == 31) {
+        bits = sign | 0x7F800000 | (mantissa << 13);
+    }
+    else {
+        bits = sign | ((exponent + 112) << 23) | (mantissa << 13);
+    }
+    float value;
+    std::memcpy(&value, &bits, sizeof(value));
+    return value;
+}
+
+static const std::vector<unsigned short>& sRGBToLinear16Table() {
+    static const std::vector<unsigned short> table = []() {
+        std::vector<unsigned short> values(256);
+        for(unsigned int i = 0; i < 256; i++) {
+            double value = i / 255.0;
+            double linear = (value <= 0.04045) ? value / 12.92 : std::pow((value + 0.055) / 1.055, 2.4);
+            values[i] = (unsigned short)(linear * 65535.0 + 0.5);
+        }
+        return values;
+    }();
+    return table;
+}
+
+// Every 16-bit linear value has an entry, since the sRGB curve is too steep near black to index by fewer bits
+static const std::vector<unsigned char>& linear16ToSRGBTable() {
+    static const std::vector<unsigned char> table = []() {
+        std::vector<unsigned char> values(65536);
+        for(unsigned int i = 0; i < 65536; i++) {
+            double linear = i / 65535.0;
+            double value = (linear <= 0.0031308) ? linear * 12.92 : 1.055 * std::pow(linear, 1.0 / 2.4) - 0.055;
+            values[i] = (unsigned char)std::min(value * 255.0 + 0.5, 255.0);
+        }
+        return values;
+    }();
+    return table;
+}
+
+#ifdef PIXEL_CONVERTER_X86
+/*
+ * SSE2 kernels. Each returns the number of pixels or values it converted, leaving the rest to the scalar kernels.
+ */
+__attribute__((target("sse2")))
+static __m128i premultiplyLanesSSE2(const __m128i pixels, const __m128i alphaMask, const __m128i bias) {
+    // Two pixels of 16-bit channels, with each pixel's alpha broadcast to its four lanes
+    __m128i alpha = _mm_shufflehi_epi16(_mm_shufflelo_epi16(pixels, 0xFF), 0xFF);
+    __m128i biased = _mm_add_epi16(_mm_mullo_epi16(pixels, alpha), bias);
+    __m128i premultiplied = _mm_srli_epi16(_mm_add_epi16(biased, _mm_srli_epi16(biased, 8)), 8);
+    return _mm_or_si128(_mm_and_si128(alphaMask, pixels), _mm_andnot_si128(alphaMask, premultiplied));
+}
+
+__attribute__((target("sse2")))
+static size_t premultiplyAlphaSSE2(unsigned char* pixels, const size_t numPixels) {
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i alphaMask = _mm_set_epi16(-1, 0, 0, 0, -1, 0, 0, 0);
+    const __m128i bias = _mm_set1_epi16(128);
+    size_t i = 0;
+    for(; i + 4 <= numPixels; i += 4) {
+        __m128i block = _mm_loadu_si128((const __m128i*)(pixels + i * 4));
+        __m128i low = premultiplyLanesSSE2(_mm_unpacklo_epi8(block, zero), alphaMask, bias);
+        __m128i high = premultiplyLanesSSE2(_mm_unpackhi_epi8(block, zero), alphaMask, bias);
+        _mm_storeu_si128((__m128i*)(pixels + i * 4), _mm_packus_epi16(low, high));
+    }
+    return i;
+}
+
+__attribute__((target("sse2")))
+static size_t widen8To16SSE2(const unsigned char* source, unsigned short* destination, const size_t numValues) {
+    size_t i = 0;
+    for(; i + 16 <= numValues; i += 16) {
+        // Repeating each byte in both halves of a 16-bit value multiplies it by 257
+        __m128i values = _mm_loadu_si128((const __m128i*)(source + i));
+        _mm_storeu_si128((__m128i*)(destination + i), _mm_unpacklo_epi8(values, values));
+        _mm_storeu_si128((__m128i*)(destination + i + 8), _mm_unpackhi_epi8(values, values));
+    }
+    return i;
+}
+
+__attribute__((target("sse2")))
+static __m128i narrowLanesSSE2(const __m128i values, const __m128i scale, const __m128i bias) {
+    // 32-bit products of eight values and 255 from their low and high halves
+    __m128i productLow = _mm_mullo_epi16(values, scale);
+    __m128i productHigh = _mm_mulhi_epu16(values, scale);
+    __m128i first = _mm_srli_epi32(_mm_add_epi32(_mm_unpacklo_epi16(productLow, productHigh), bias), 16);
+    __m128i second = _mm_srli_epi32(_mm_add_epi32(_mm_unpackhi_epi16(productLow, productHigh), bias), 16);
+    return _mm_packs_epi32(first, second);
+}
+
+__attribute__((target("sse2")))
+static size_t narrow16To8SSE2(const unsigned short* source, unsigned char* destination, const size_t numValues) {
+    const __m128i scale = _mm_set1_epi16(255);
+    const __m128i bias = _mm_set1_epi32(32895);
+    size_t i = 0;
+    for(; i + 16 <= numValues; i += 16) {
+        __m128i first = narrowLanesSSE2(_mm_loadu_si128((const __m128i*)(source + i)), scale, bias);
+        __m128i second = narrowLanesSSE2(_mm_loadu_si128((const __m128i*)(source + i + 8)), scale, bias);
+        _mm_storeu_si128((__m128i*)(destination + i), _mm_packus_epi16(first, second));
+    }
+    return i;
+}
+
+/*
+ * SSSE3 kernels, shuffling bytes with pshufb. A shuffle index of -1 writes zero.
+ */
+__attribute__((target("ssse3")))
+static size_t expandRGBToRGBASSSE3(const unsigned char* source, unsigned char* destination, const size_t numPixels, const unsigned char alpha) {
+    const __m128i shuffle = _mm_setr_epi8(0, 1, 2, -1, 3, 4, 5, -1, 6, 7, 8, -1, 9, 10, 11, -1);
+    const __m128i alphaBytes = _mm_set1_epi32((int)((unsigned int)alpha << 24));
+    size_t i = 0;
+    // Each load reads 16 bytes for 4 pixels, so stop while 16 bytes are left to read
+    for(; (i + 4) * 3 + 4 <= numPixels * 3; i += 4) {
+        __m128i pixels = _mm_loadu_si128((const __m128i*)(source + i * 3));
+        _mm_storeu_si128((__m128i*)(destination + i * 4), _mm_or_si128(_mm_shuffle_epi8(pixels, shuffle), alphaBytes));
+    }
+    return i;
+}
+
+__attribute__((target("ssse3")))
+static size_t stripRGBAToRGBSSSE3(const unsigned char* source, unsigned char* destination, const size_t numPixels) {
+    // Packs the 12 color bytes of 4 pixels at the bottom
+    const __m128i shuffle = _mm_setr_epi8(0, 1, 2, 4, 5, 6, 8, 9, 10, 12, 13, 14, -1, -1, -1, -1);
+    size_t i = 0;
+    for(; i + 16 <= numPixels; i += 16) {
+        __m128i first = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i*)(source + i * 4)), shuffle);
+        __m128i second = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i*)(source + i * 4 + 16)), shuffle);
+        __m128i third = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i*)(source + i * 4 + 32)), shuffle);
+        __m128i fourth = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i*)(source + i * 4 + 48)), shuffle);
+        _mm_storeu_si128((__m128i*)(destination + i * 3), _mm_or_si128(first, _mm_slli_si128(second, 12)));
+        _mm_storeu_si128((__m128i*)(destination + i * 3 + 16), _mm_or_si128(_mm_srli_si128(second, 4), _mm_slli_si128(third, 8)));
+        _mm_storeu_si128((__m128i*)(destination + i * 3 + 32), _mm_or_si128(_mm_srli_si128(third, 8), _mm_slli_si128(fourth, 4)));
+    }
+    return i;
+}
+
+__attribute__((target("ssse3")))
+static size_t swizzleRGBASSSE3(const unsigned char* source, unsigned char* destination, const size_t numPixels, const unsigned int order[4]) {
+    char indices[16];
+    for(unsigned int i = 0; i < 16; i++) {
+        indices[i] = (char)(i / 4 * 4 + order[i % 4]);
+    }
+    const __m128i shuffle = _mm_loadu_si128((const __m128i*)indices);
+    size_t i = 0;
+    for(; i + 4 <= numPixels; i += 4) {
+        __m128i pixels = _mm_loadu_si128((const __m128i*)(source + i * 4));
+        _mm_storeu_si128((__m128i*)(destination + i * 4), _mm_shuffle_epi8(pixels, shuffle));
+    }
+    return i;
+}
+
+__attribute__((target("ssse3")))
+static size_t expandGreyToRGBSSSE3(const unsigned char* source, unsigned char* destination, const size_t numPixels) {
+    const __m128i first = _mm_setr_epi8(0, 0, 0, 1, 1, 1, 2, 2, 2, 3, 3, 3, 4, 4, 4, 5);
+    const __m128i second = _mm_setr_epi8(5, 5, 6, 6, 6, 7, 7, 7, 8, 8, 8, 9, 9, 9, 10, 10);
+    const __m128i third = _mm_setr_epi8(10, 11, 11, 11, 12, 12, 12, 13, 13, 13, 14, 14, 14, 15, 15, 15);
+    size_t i = 0;
+    for(; i + 16 <= numPixels; i += 16) {
+        __m128i grey = _mm_loadu_si128((const __m128i*)(source + i));
+        _mm_storeu_si128((__m128i*)(destination + i * 3), _mm_shuffle_epi8(grey, first));
+        _mm_storeu_si128((__m128i*)(destination + i * 3 + 16), _mm_shuffle_epi8(grey, second));
+        _mm_storeu_si128((__m128i*)(destination + i * 3 + 32), _mm_shuffle_epi8(grey, third));
+    }
+    return i;
+}
+
+__attribute__((target("ssse3")))
+static size_t expandGreyToRGBASSSE3(const unsigned char* source, unsigned char* destination, const size_t numPixels, const unsigned char alpha) {
+    const __m128i alphaBytes = _mm_set1_epi32((int)((unsigned int)alpha << 24));
+    __m128i shuffles[4];
+    for(unsigned int quarter = 0; quarter < 4; quarter++) {
+        char indices[16];
+        for(unsigned int i = 0; i < 16; i++) {
+            indices[i] = (i % 4 == 3) ? -1 : (char)(quarter * 4 + i / 4);
+        }
+        shuffles[quarter] = _mm_loadu_si128((const __m128i*)indices);
+    }
+    size_t i = 0;
+    for(; i + 16 <= numPixels; i += 16) {
+        __m128i grey = _mm_loadu_si128((const __m128i*)(source + i));
+        for(unsigned int quarter = 0; quarter < 4; quarter++) {
+            _mm_storeu_si128((__m128i*)(destination + i * 4 + quarter * 16), _mm_or_si128(_mm_shuffle_epi8(grey, shuffles[quarter]), alphaBytes));
+        }
+    }
+    return i;
+}
+
+__attribute__((target("ssse3")))
+static size_t expandGreyAlphaToRGBASSSE3(const unsigned char* source, unsigned char* destination, const size_t numPixels) {
+    const __m128i first = _mm_setr_epi8(0, 0, 0, 1, 2, 2, 2, 3, 4, 4, 4, 5, 6, 6, 6, 7);
+    const __m128i second = _mm_setr_epi8(8, 8, 8, 9, 10, 10, 10, 11, 12, 12, 12, 13, 14, 14, 14, 15);
+    size_t i = 0;
+    for(; i + 8 <= numPixels; i += 8) {
+        __m128i pixels = _mm_loadu_si128((const __m128i*)(source + i * 2));
+        _mm_storeu_si128((__m128i*)(destination + i * 4), _mm_shuffle_epi8(pixels, first));
+        _mm_storeu_si128((__m128i*)(destination + i * 4 + 16), _mm_shuffle_epi8(pixels, second));
+    }
+    return i;
+}
+
+/*
+ * AVX2 and F16C kernels. 256-bit unpacks and packs work within each 128-bit half, so the halves are kept in order
+ * around them.
+ */
+__attribute__((target("avx2")))
+static size_t premultiplyAlphaAVX2(unsigned char* pixels, const size_t numPixels) {
+    const __m256i zero = _mm256_setzero_si256();
+    const __m256i alphaMask = _mm256_set_epi16(-1, 0, 0, 0, -1, 0, 0, 0, -1, 0, 0, 0, -1, 0, 0, 0);
+    const __m256i bias = _mm256_set1_epi16(128);
+    size_t i = 0;
+    for(; i + 8 <= numPixels; i += 8) {
+        __m256i block = _mm256_loadu_si256((const __m256i*)(pixels + i * 4));
+        __m256i halves[2] = {_mm256_unpacklo_epi8(block, zero), _mm256_unpackhi_epi8(block, zero)};
+        for(unsigned int h = 0; h < 2; h++) {
+            __m256i alpha = _mm256_shufflehi_epi16(_mm256_shufflelo_epi16(halves[h], 0xFF), 0xFF);
+            __m256i biased = _mm256_add_epi16(_mm256_mullo_epi16(halves[h], alpha), bias);
+            __m256i premultiplied = _mm256_srli_epi16(_mm256_add_epi16(biased, _mm256_srli_epi16(biased, 8)), 8);
+            halves[h] = _mm256_or_si256(_mm256_and_si256(alphaMask, halves[h]), _mm256_andnot_si256(alphaMask, premultiplied));
+        }
+        _mm256_storeu_si256((__m256i*)(pixels + i * 4), _mm256_packus_epi16(halves[0], halves[1]));
+    }
+    return i;
+}
+
+__attribute__((target("avx2")))
+static size_t widen8To16AVX2(const unsigned char* source, unsigned short* destination, const size_t numValues) {
+    size_t i = 0;
+    for(; i + 16 <= numValues; i += 16) {
+        __m256i values = _mm256_cvtepu8_epi16(_mm_loadu_si128((const __m128i*)(source + i)));
+        _mm256_storeu_si256((__m256i*)(destination + i), _mm256_or_si256(values, _mm256_slli_epi16(values, 8)));
+    }
+    return i;
+}
+
+__attribute__((target("avx2")))
+static __m256i narrowLanesAVX2(const __m256i values, const __m256i scale, const __m256i bias) {
+    __m256i productLow = _mm256_mullo_epi16(values, scale);
+    __m256i productHigh = _mm256_mulhi_epu16(values, scale);
+    __m256i first = _mm256_srli_epi32(_mm256_add_epi32(_mm256_unpacklo_epi16(productLow, productHigh), bias), 16);
+    __m256i second = _mm256_srli_epi32(_mm256_add_epi32(_mm256_unpackhi_epi16(productLow, productHigh), bias), 16);
+    return _mm256_packs_epi32(first, second);
+}
+
+__attribute__((target("avx2")))
+static size_t narrow16To8AVX2(const unsigned short* source, unsigned char* destination, const size_t numValues) {
+    const __m256i scale = _mm256_set1_epi16(255);
+    const __m256i bias = _mm256_set1_epi32(32895);
+    size_t i = 0;
+    for(; i + 32 <= numValues; i += 32) {
+        __m256i first = narrowLanesAVX2(_mm256_loadu_si256((const __m256i*)(source + i)), scale, bias);
+        __m256i second = narrowLanesAVX2(_mm256_loadu_si256((const __m256i*)(source + i + 16)), scale, bias);
+        // The pack interleaves the halves of first and second
+        __m256i packed = _mm256_packus_epi16(first, second);
+        _mm256_storeu_si256((__m256i*)(destination + i), _mm256_permute4x64_epi64(packed, 0xD8));
+    }
+    return i;
+}
+
+__attribute__((target("avx,f16c")))
+static size_t floatToHalfF16C(const float* source, unsigned short* destination, const size_t numValues) {
+    size_t i = 0;
+    for(; i + 8 <= numValues; i += 8) {
+        __m128i halves = _mm256_cvtps_ph(_mm256_loadu_ps(source + i), _MM_FROUND_TO_NEAREST_INT);
+        _mm_storeu_si128((__m128i*)(destination + i), halves);
+    }
+    return i;
+}
+
+__attribute__((target("avx,f16c")))
+static size_t halfToFloatF16C(const unsigned short* source, float* destination, const size_t numValues) {
+    size_t i = 0;
+    for(; i + 8 <= numValues; i += 8) {
+        _mm256_storeu_ps(destination + i, _mm256_cvtph_ps(_mm_loadu_si128((const __m128i*)(source + i))));
+    }
+    return i;
+}
+#endif
+
+static SIMDLevel detectSIMDLevel() {
+#ifdef PIXEL_CONVERTER_X86
+    __builtin_cpu_init();
+    if(__builtin_cpu_supports("avx2") && __builtin_cpu_supports("f16c")) {
+        return SIMD_LEVEL_AVX2;
+    }
+    if(__builtin_cpu_supports("ssse3")) {
+        return SIMD_LEVEL_SSSE3;
+    }
+    if(__builtin_cpu_supports("sse2")) {
+        return SIMD_LEVEL_SSE2;
+    }
+#endif
+    return SIMD_LEVEL_SCALAR;
+}
+
+/*
+ * Class PixelConverter
+ */
+std::atomic<SIMDLevel> PixelConverter::maxSIMDLevel(SIMD_LEVEL_AVX2);
+
+unsigned int PixelConverter::GetNumChannels(const PixelFormat pixelFormat) {
+    switch(pixelFormat) {
+        case PIXEL_FORMAT_R8:
+        case PIXEL_FORMAT_L8:
+            return 1;
+        case PIXEL_FORMAT_RG8:
+        case PIXEL_FORMAT_LA8:
+            return 2;
+        case PIXEL_FORMAT_RGB8:
+            return 3;
+        default:
+            return 4;
+    }
+}
+
+unsigned int PixelConverter::GetBytesPerPixel(const PixelFormat pixelFormat) {
+    if(pixelFormat == PIXEL_FORMAT_RGBA16 || pixelFormat == PIXEL_FORMAT_RGBA16F) {
+        return 8;
+    }
+    return GetNumChannels(pixelFormat);
+}
+
+PixelFormat PixelConverter::GetPixelFormat(const unsigned int numChannels) {
+#ifdef _DEBUG
+    assert(numChannels > 0 && numChannels <= 4);
+#endif
+    PixelFormat pixelFormats[] = {PIXEL_FORMAT_R8, PIXEL_FORMAT_RG8, PIXEL_FORMAT_RGB8, PIXEL_FORMAT_RGBA8};
+    return pixelFormats[numChannels - 1];
+}
+
+GLPixelFormat PixelConverter::GetGLPixelFormat(const PixelFormat pixelFormat) {
+    switch(pixelFormat) {
+        case PIXEL_FORMAT_R8:
+        case PIXEL_FORMAT_L8:
+            return {GL_R8, GL_RED, GL_UNSIGNED_BYTE};
+        case PIXEL_FORMAT_RG8:
+        case PIXEL_FORMAT_LA8:
+            return {GL_RG8, GL_RG, GL_UNSIGNED_BYTE};
+        case PIXEL_FORMAT_RGB8:
+            return {GL_RGB8, GL_RGB, GL_UNSIGNED_BYTE};
+        case PIXEL_FORMAT_RGBA8:
+            return {GL_RGBA8, GL_RGBA, GL_UNSIGNED_BYTE};
+        case PIXEL_FORMAT_BGRA8:
+            return {GL_RGBA8, GL_BGRA, GL_UNSIGNED_BYTE};
+        case PIXEL_FORMAT_RGBA16:
+            return {GL_RGBA16, GL_RGBA, GL_UNSIGNED_SHORT};
+        default:
+            return {GL_RGBA16F, GL_RGBA, GL_HALF_FLOAT};
+    }
+}
+
+bool PixelConverter::GetGLSwizzle(const PixelFormat pixelFormat, GLint swizzle[4]) {
+    if(pixelFormat == PIXEL_FORMAT_L8) {
+        swizzle[0] = GL_RED;
+        swizzle[1] = GL_RED;
+        swizzle[2] = GL_RED;
+        swizzle[3] = GL_ONE;
+        return true;
+    }
+    if(pixelFormat == PIXEL_FORMAT_LA8) {
+        swizzle[0] = GL_RED;
+        swizzle[1] = GL_RED;
+        swizzle[2] = GL_RED;
+        swizzle[3] = GL_GREEN;
+        return true;
+    }
+    return false;
+}
+
+GLint PixelConverter::GetUnpackAlignment(const size_t rowSize) {
+    for(GLint alignment = 8; alignment > 1; alignment /= 2) {
+        if(rowSize % alignment == 0) {
+            return alignment;
+        }
+    }
+    return 1;
+}
+
+void PixelConverter::ConvertPixels(const void* source, const PixelFormat sourceFormat, void* destination, const PixelFormat destinationFormat,
+        const size_t numPixels) {
+    if(sourceFormat == destinationFormat) {
+        std::memmove(destination, source, numPixels * GetBytesPerPixel(sourceFormat));
+        return;
+    }
+    if(sourceFormat == PIXEL_FORMAT_RGBA8) {
+        ConvertFromRGBA8((const unsigned char*)source, destination, destinationFormat, numPixels);
+        return;
+    }
+    if(destinationFormat == PIXEL_FORMAT_RGBA8) {
+        ConvertToRGBA8(source, sourceFormat, (unsigned char*)destination, numPixels);
+        return;
+    }
+    if(sourceFormat == PIXEL_FORMAT_L8 && destinationFormat == PIXEL_FORMAT_RGB8) {
+        ExpandGreyToRGB((const unsigned char*)source, (unsigned char*)destination, numPixels);
+        return;
+    }
+    
+    // Go through RGBA8 a chunk at a time, small enough to stay in cache
+    std::vector<unsigned char> chunk(CONVERSION_CHUNK_PIXELS * 4);
+    unsigned int sourceBytesPerPixel = GetBytesPerPixel(sourceFormat);
+    unsigned int destinationBytesPerPixel = GetBytesPerPixel(destinationFormat);
+    for(size_t firstPixel = 0; firstPixel < numPixels; firstPixel += CONVERSION_CHUNK_PIXELS) {
+        size_t chunkPixels = std::min(CONVERSION_CHUNK_PIXELS, numPixels - firstPixel);
+        ConvertToRGBA8((const unsigned char*)source + firstPixel * sourceBytesPerPixel, sourceFormat, chunk.data(), chunkPixels);
+        ConvertFromRGBA8(chunk.data(), (unsigned char*)destination + firstPixel * destinationBytesPerPixel, destinationFormat, chunkPixels);
+    }
+}
+
+void PixelConverter::ExpandRGBToRGBA(const unsigned char* source, unsigned char* destination, const size_t numPixels, const unsigned char alpha) {
+    size_t converted = 0;
+#ifdef PIXEL_CONVERTER_X86
+    if(GetSIMDLevel() >= SIMD_LEVEL_SSSE3) {
+        converted = expandRGBToRGBASSSE3(source, destination, numPixels, alpha);
+    }
+#endif
+    expandRGBToRGBAScalar(source, destination, converted, numPixels, alpha);
+}
+
+void PixelConverter::StripRGBAToRGB(const unsigned char* source, unsigned char* destination, const size_t numPixels) {
+    size_t converted = 0;
+#ifdef PIXEL_CONVERTER_X86
+    if(GetSIMDLevel() >= SIMD_LEVEL_SSSE3) {
+        converted = stripRGBAToRGBSSSE3(source, destination, numPixels);
+    }
+#endif
+    stripRGBAToRGBScalar(source, destination, converted, numPixels);
+}
+
+void PixelConverter::SwizzleRGBA(const unsigned char* source, unsigned char* destination, const size_t numPixels, const unsigned int order[4]) {
+#ifdef _DEBUG
+    assert(order[0] < 4 && order[1] < 4 && order[2] < 4 && order[3] < 4);
+#endif
+    size_t converted = 0;
+#ifdef PIXEL_CONVERTER_X86
+    if(GetSIMDLevel() >= SIMD_LEVEL_SSSE3) {
+        converted = swizzleRGBASSSE3(source, destination, numPixels, order);
+    }
+#endif
+    swizzleRGBAScalar(source, destination, converted, numPixels, order);
+}
+
+void PixelConverter::ExpandGreyToRGB(const unsigned char* source, unsigned char* destination, const size_t numPixels) {
+    size_t converted = 0;
+#ifdef PIXEL_CONVERTER_X86
+    if(GetSIMDLevel() >= SIMD_LEVEL_SSSE3) {
+        converted = expandGreyToRGBSSSE3(source, destination, numPixels);
+    }
+#endif
+    expandGreyScalar(source, destination, converted, numPixels, 3, 255);
+}
+
+void PixelConverter::ExpandGreyToRGBA(const unsigned char* source, unsigned char* destination, const size_t numPixels, const unsigned char alpha) {
+    size_t converted = 0;
+#ifdef PIXEL_CONVERTER_X86
+    if(GetSIMDLevel() >= SIMD_LEVEL_SSSE3) {
+        converted = expandGreyToRGBASSSE3(source, destination, numPixels, alpha);
+    }
+#endif
+    expandGreyScalar(source, destination, converted, numPixels, 4, alpha);
+}
+
+void PixelConverter::ExpandGreyAlphaToRGBA(const unsigned char* source, unsigned char* destination, const size_t numPixels) {
+    size_t converted = 0;
+#ifdef PIXEL_CONVERTER_X86
+    if(GetSIMDLevel() >= SIMD_LEVEL_SSSE3) {
+        converted = expandGreyAlphaToRGBASSSE3(source, destination, numPixels);
+    }
+#endif
+    expandGreyAlphaToRGBAScalar(source, destination, converted, numPixels);
+}
+
+void PixelConverter::PremultiplyAlpha(unsigned char* pixels, const size_t numPixels) {
+    size_t converted = 0;
+#ifdef PIXEL_CONVERTER_X86
+    SIMDLevel simdLevel = GetSIMDLevel();
+    if(simdLevel >= SIMD_LEVEL_AVX2) {
+        converted = premultiplyAlphaAVX2(pixels, numPixels);
+    }
+    else if(simdLevel >= SIMD_LEVEL_SSE2) {
+        converted = premultiplyAlphaSSE2(pixels, numPixels);
+    }
+#endif
+    premultiplyAlphaScalar(pixels, converted, numPixels);
+}
+
+void PixelConverter::SRGBToLinear16(const unsigned char* source, unsigned short* destination, const size_t numValues) {
+    const unsigned short* table = sRGBToLinear16Table().data();
+    for(size_t i = 0; i < numValues; i++) {
+        destination[i] = table[source[i]];
+    }
+}
+
+void PixelConverter::Linear16ToSRGB(const unsigned short* source, unsigned char* destination, const size_t numValues) {
+    const unsigned char* table = linear16ToSRGBTable().data();
+    for(size_t i = 0; i < numValues; i++) {
+        destination[i] = table[source[i]];
+    }
+}
+
+void PixelConverter::Widen8To16(const unsigned char* source, unsigned short* destination, const size_t numValues) {
+    size_t converted = 0;
+#ifdef PIXEL_CONVERTER_X86
+    SIMDLevel simdLevel = GetSIMDLevel();
+    if(simdLevel >= SIMD_LEVEL_AVX2) {
+        converted = widen8To16AVX2(source, destination, numValues);
+    }
+    else if(simdLevel >= SIMD_LEVEL_SSE2) {
+        converted = widen8To16SSE2(source, destination, numValues);
+    }
+#endif
+    widen8To16Scalar(source, destination, converted, numValues);
+}
+
+void PixelConverter::Narrow16To8(const unsigned short* source, unsigned char* destination, const size_t numValues) {
+    size_t converted = 0;
+#ifdef PIXEL_CONVERTER_X86
+    SIMDLevel simdLevel = GetSIMDLevel();
+    if(simdLevel >= SIMD_LEVEL_AVX2) {
+        converted = narrow16To8AVX2(source, destination, numValues);
+    }
+    else if(simdLevel >= SIMD_LEVEL_SSE2) {
+        converted = narrow16To8SSE2(source, destination, numValues);
+    }
+#endif
+    narrow16To8Scalar(source, destination, converted, numValues);
+}
+
+void PixelConverter::FloatToHalf(const float* source, unsigned short* destination, const size_t numValues) {
+    size_t converted = 0;
+#ifdef PIXEL_CONVERTER_X86
+    if(GetSIMDLevel() >= SIMD_LEVEL_AVX2) {
+        converted = floatToHalfF16C(source, destination, numValues);
+    }
+#endif
+    for(size_t i = converted; i < numValues; i++) {
+        destination[i] = floatToHalfScalar(source[i]);
+    }
+}
+
+void PixelConverter::HalfToFloat(const unsigned short* source, float* destination, const size_t numValues) {
+    size_t converted = 0;
+#ifdef PIXEL_CONVERTER_X86
+    if(GetSIMDLevel() >= SIMD_LEVEL_AVX2) {
+        converted = halfToFloatF16C(source, destination, numValues);
+    }
+#endif
+    for(size_t i = converted; i < numValues; i++) {
+        destination[i] = halfToFloatScalar(source[i]);
+    }
+}
+
+SIMDLevel PixelConverter::GetSIMDLevel() {
+    static const SIMDLevel detectedSIMDLevel = detectSIMDLevel();
+    return std::min(detectedSIMDLevel, maxSIMDLevel.load(std::memory_order_relaxed));
+}
+
+void PixelConverter::ConvertToRGBA8(const void* source, const PixelFormat sourceFormat, unsigned char* destination, const size_t numPixels) {
+    const unsigned char* bytes = (const unsigned char*)source;
+    switch(sourceFormat) {
+        case PIXEL_FORMAT_R8:
+        case PIXEL_FORMAT_RG8: {
+            unsigned int numChannels = GetNumChannels(sourceFormat);
+            for(size_t i = 0; i < numPixels; i++) {
+                destination[i * 4] = bytes[i * numChannels];
+                destination[i * 4 + 1] = (numChannels == 2) ? bytes[i * 2 + 1] : 0;
+                destination[i * 4 + 2] = 0;
+                destination[i * 4 + 3] = 255;
+            }
+            break;
+        }
+        case PIXEL_FORMAT_RGB8:
+            ExpandRGBToRGBA(bytes, destination, numPixels);
+            break;
+        case PIXEL_FORMAT_RGBA8:
+            std::memmove(destination, bytes, numPixels * 4);
+            break;
+        case PIXEL_FORMAT_BGRA8: {
+            const unsigned int order[4] = {2, 1, 0, 3};
+            SwizzleRGBA(bytes, destination, numPixels, order);
+            break;
+        }
+        case PIXEL_FORMAT_L8:
+            ExpandGreyToRGBA(bytes, destination, numPixels);
+            break;
+        case PIXEL_FORMAT_LA8:
+            ExpandGreyAlphaToRGBA(bytes, destination, numPixels);
+            break;
+        case PIXEL_FORMAT_RGBA16:
+            Narrow16To8((const unsigned short*)source, destination, numPixels * 4);
+            break;
+        case PIXEL_FORMAT_RGBA16F: {
+            std::vector<float> values(std::min(numPixels, CONVERSION_CHUNK_PIXELS) * 4);
+            for(size_t firstPixel = 0; firstPixel < numPixels; firstPixel += CONVERSION_CHUNK_PIXELS) {
+                size_t numValues = std::min(CONVERSION_CHUNK_PIXELS, numPixels - firstPixel) * 4;
+                HalfToFloat((const unsigned short*)source + firstPixel * 4, values.data(), numValues);
+                for(size_t i = 0; i < numValues; i++) {
+                    destination[firstPixel * 4 + i] = (unsigned char)(std::min(std::max(values[i], 0.0f), 1.0f) * 255.0f + 0.5f);
+                }
+            }
+            break;
+        }
+    }
+}
+
+void PixelConverter::ConvertFromRGBA8(const unsigned char* source, void* destination, const PixelFormat destinationFormat, const size_t numPixels) {
+    unsigned char* bytes = (unsigned char*)destination;
+    switch(destinationFormat) {
+        case PIXEL_FORMAT_R8:
+        case PIXEL_FORMAT_RG8: {
+            unsigned int numChannels = GetNumChannels(destinationFormat);
+            for(size_t i = 0; i < numPixels; i++) {
+                for(unsigned int c = 0; c < numChannels; c++) {
+                    bytes[i * numChannels + c] = source[i * 4 + c];
+                }
+            }
+            break;
+        }
+        case PIXEL_FORMAT_RGB8:
+            StripRGBAToRGB(source, bytes, numPixels);
+            break;
+        case PIXEL_FORMAT_RGBA8:
+            std::memmove(bytes, source, numPixels * 4);
+            break;
+        case PIXEL_FORMAT_BGRA8: {
+            const unsigned int order[4] = {2, 1, 0, 3};
+            SwizzleRGBA(source, bytes, numPixels, order);
+            break;
+        }
+        case PIXEL_FORMAT_L8:
+        case PIXEL_FORMAT_LA8: {
+            unsigned int numChannels = GetNumChannels(destinationFormat);
+            for(size_t i = 0; i < numPixels; i++) {
+                // Rec. 709 luma in 8-bit fixed point, with weights summing to 256
+                bytes[i * numChannels] = (unsigned char)((54 * source[i * 4] + 183 * source[i * 4 + 1] + 19 * source[i * 4 + 2] + 128) >> 8);
+                if(numChannels == 2) {
+                    bytes[i * 2 + 1] = source[i * 4 + 3];
+                }
+            }
+            break;
+        }
+        case PIXEL_FORMAT_RGBA16:
+            Widen8To16(source, (unsigned short*)destination, numPixels * 4);
+            break;
+        case PIXEL_FORMAT_RGBA16F: {
+            std::vector<float> values(std::min(numPixels, CONVERSION_CHUNK_PIXELS) * 4);
+            for(size_t firstPixel = 0; firstPixel < numPixels; firstPixel += CONVERSION_CHUNK_PIXELS) {
+                size_t numValues = std::min(CONVERSION_CHUNK_PIXELS, numPixels - firstPixel) * 4;
+                for(size_t i = 0; i < numValues; i++) {
+                    values[i] = source[firstPixel * 4 + i] * (1.0f / 255.0f);
+                }
+                FloatToHalf(values.data(), (unsigned short*)destination + firstPixel * 4, numValues);
+            }
+            break;
+        }
+    }
+}
+
+}
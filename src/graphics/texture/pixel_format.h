@@ -0,0 +1,154 @@
+#ifndef PIXEL_FORMAT_H
+#define PIXEL_FORMAT_H
+
+#include <atomic>
+#include <cstddef>
+#include <cassert>
+
+#include <glad/glad.h>
+
+namespace Engine {
+
+/*
+ * Layouts of uncompressed pixel data, each uploaded to OpenGL without converting it.
+ */
+enum PixelFormat {
+    PIXEL_FORMAT_R8,
+    PIXEL_FORMAT_RG8,
+    PIXEL_FORMAT_RGB8,
+    PIXEL_FORMAT_RGBA8,
+    // RGBA8 with red and blue swapped, as many image and video sources produce
+    PIXEL_FORMAT_BGRA8,
+    // Grey, read by shaders as RGB with an alpha of 1 through the texture's swizzle
+    PIXEL_FORMAT_L8,
+    // Grey and alpha, read by shaders as RGBA through the texture's swizzle
+    PIXEL_FORMAT_LA8,
+    // 16-bit unsigned normalized RGBA
+    PIXEL_FORMAT_RGBA16,
+    // Half float RGBA
+    PIXEL_FORMAT_RGBA16F
+};
+
+/*
+ * Instruction sets the conversion kernels can use, in increasing order.
+ */
+enum SIMDLevel {
+    SIMD_LEVEL_SCALAR,
+    SIMD_LEVEL_SSE2,
+    SIMD_LEVEL_SSSE3,
+    // AVX2 and F16C
+    SIMD_LEVEL_AVX2
+};
+
+/*
+ * OpenGL enums for uploading a pixel format with glTexImage2D and glTexSubImage2D.
+ */
+struct GLPixelFormat {
+    GLint internalFormat;
+    GLenum format;
+    GLenum type;
+};
+
+/*
+ * PixelConverter describes pixel formats and converts pixels between them.
+ *
+ * The kernels for channel shuffles (expanding, stripping, swizzling and grey expansion) use SSSE3 byte shuffles, the
+ * ones for premultiplying alpha and converting between 8 and 16 bits use SSE2 or AVX2, and half floats use F16C. The
+ * instruction set is picked at run time from what the CPU supports, so the engine doesn't need to be built for a
+ * particular CPU, and every kernel has a scalar version that produces the same results. sRGB conversions go through
+ * lookup tables. Kernels are safe to call from AsyncLoader worker threads.
+ */
+class PixelConverter {
+    public:
+        static unsigned int GetNumChannels(const PixelFormat pixelFormat);
+        static unsigned int GetBytesPerPixel(const PixelFormat pixelFormat);
+        static bool Is8Bit(const PixelFormat pixelFormat) { return GetBytesPerPixel(pixelFormat) == GetNumChannels(pixelFormat); }
+        
+        /*
+         * Returns the 8-bit format storing numChannels channels as is, from R8 to RGBA8.
+         */
+        static PixelFormat GetPixelFormat(const unsigned int numChannels);
+        
+        static GLPixelFormat GetGLPixelFormat(const PixelFormat pixelFormat);
+        
+        /*
+         * Writes the GL_TEXTURE_SWIZZLE_RGBA of pixelFormat to swizzle and returns true, or returns false if it reads
+         * its channels as stored.
+         */
+        static bool GetGLSwizzle(const PixelFormat pixelFormat, GLint swizzle[4]);
+        
+        /*
+         * Returns the largest GL_UNPACK_ALIGNMENT (up to 8) that tightly packed rows of rowSize bytes satisfy.
+         */
+        static GLint GetUnpackAlignment(const size_t rowSize);
+        
+        /*
+         * Converts numPixels pixels from sourceFormat to destinationFormat. Formats without a direct kernel go through
+         * RGBA8, and grey is taken from red, green and blue with Rec. 709 weights. source and destination must not
+         * overlap unless both formats are the same size.
+         */
+        static void ConvertPixels(const void* source, const PixelFormat sourceFormat, void* destination, const PixelFormat destinationFormat,
+                const size_t numPixels);
+        
+        static void ExpandRGBToRGBA(const unsigned char* source, unsigned char* destination, const size_t numPixels, const unsigned char alpha = 255);
+        static void StripRGBAToRGB(const unsigned char* source, unsigned char* destination, const size_t numPixels);
+        
+        /*
+         * Writes channel order[c] of each RGBA source pixel to channel c of its destination pixel. source may be
+         * destination.
+         */
+        static void SwizzleRGBA(const unsigned char* source, unsigned char* destination, const size_t numPixels, const unsigned int order[4]);
+        
+        static void ExpandGreyToRGB(const unsigned char* source, unsigned char* destination, const size_t numPixels);
+        static void ExpandGreyToRGBA(const unsigned char* source, unsigned char* destination, const size_t numPixels, const unsigned char alpha = 255);
+        static void ExpandGreyAlphaToRGBA(const unsigned char* source, unsigned char* destination, const size_t numPixels);
+        
+        /*
+         * Multiplies the color channels of RGBA pixels by their alpha in place, rounding to the nearest value.
+         */
+        static void PremultiplyAlpha(unsigned char* pixels, const size_t numPixels);
+        
+        /*
+         * Converts numValues sRGB encoded 8-bit values to linear 16-bit values and back, rounding to the nearest value.
+         */
+        static void SRGBToLinear16(const unsigned char* source, unsigned short* destination, const size_t numValues);
+        static void Linear16ToSRGB(const unsigned short* source, unsigned char* destination, const size_t numValues);
+        
+        /*
+         * Converts between 8 and 16-bit unsigned normalized values, rounding to the nearest value.
+         */
+        static void Widen8To16(const unsigned char* source, unsigned short* destination, const size_t numValues);
+        static void Narrow16To8(const unsigned short* source, unsigned char* destination, const size_t numValues);
+        
+        /*
+         * Converts between floats and half floats, rounding to the nearest half float with ties to even.
+         */
+        static void FloatToHalf(const float* source, unsigned short* destination, const size_t numValues);
+        static void HalfToFloat(const unsigned short* source, float* destination, const size_t numValues);
+        
+        /*
+         * Returns the instruction set the kernels use.
+         */
+        static SIMDLevel GetSIMDLevel();
+        
+        /*
+         * Limits the instruction set the kernels use, e.g. to compare them with the scalar versions. Defaults to
+         * SIMD_LEVEL_AVX2.
+         */
+        static void SetMaxSIMDLevel(const SIMDLevel simdLevel) { maxSIMDLevel = simdLevel; }
+    private:
+        /*
+         * Converts numPixels pixels to and from RGBA8, for formats without a direct kernel.
+         */
+        static void ConvertToRGBA8(const void* source, const PixelFormat sourceFormat, unsigned char* destination, const size_t numPixels);
+        static void ConvertFromRGBA8(const unsigned char* source, void* destination, const PixelFormat destinationFormat, const size_t numPixels);
+        
+        // Pixels converted at a time through RGBA8
+        static constexpr size_t CONVERSION_CHUNK_PIXELS = 1024;
+        
+        static std::atomic<SIMDLevel> maxSIMDLevel;
+};
+
+}
+
+#endif //PIXEL_FORMAT_H
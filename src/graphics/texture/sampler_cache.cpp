@@ -0,0 +1,79 @@
+#include "sampler_cache.h"
+#include <graphics/texture/texture_units.h>
+#include <fileio/hash.h>
+#include <algorithm>
+#include <cstring>
+
+namespace Engine {
+
+/*
+ * Struct SamplerDescription
+ */
+bool SamplerDescription::operator==(const SamplerDescription& other) const {
+    return wrapS == other.wrapS && wrapT == other.wrapT && minFilter == other.minFilter && magFilter == other.magFilter
+            && maxAnisotropy == other.maxAnisotropy && lodBias == other.lodBias && minLod == other.minLod && maxLod == other.maxLod;
+}
+
+size_t SamplerDescription::getHash() const {
+    unsigned char bytes[4 * sizeof(GLint) + 4 * sizeof(float)];
+    GLint enums[4] = {wrapS, wrapT, minFilter, magFilter};
+    // Adding 0 turns -0 into 0, which compares equal to it and so has to hash the same
+    float values[4] = {maxAnisotropy + 0.0f, lodBias + 0.0f, minLod + 0.0f, maxLod + 0.0f};
+    std::memcpy(bytes, enums, sizeof(enums));
+    std::memcpy(bytes + sizeof(enums), values, sizeof(values));
+    return (size_t)Hash::HashBytes(Hash::OFFSET_BASIS, bytes, sizeof(bytes));
+}
+
+/*
+ * Class SamplerCache
+ */
+std::unordered_map<SamplerDescription, GLuint, SamplerCache::DescriptionHash> SamplerCache::samplers;
+float SamplerCache::maxSupportedAnisotropy = 0.0f;
+SamplerCacheStats SamplerCache::stats;
+
+GLuint SamplerCache::GetSampler(const SamplerDescription& description) {
+    SamplerDescription clamped = description;
+    clamped.maxAnisotropy = std::clamp(description.maxAnisotropy, 1.0f, GetMaxSupportedAnisotropy());
+    std::unordered_map<SamplerDescription, GLuint, DescriptionHash>::iterator iter = samplers.find(clamped);
+    if(iter != samplers.end()) {
+        stats.numHits++;
+        return iter->second;
+    }
+    stats.numMisses++;
+    GLuint sampler = 0;
+    glGenSamplers(1, &sampler);
+    glSamplerParameteri(sampler, GL_TEXTURE_WRAP_S, clamped.wrapS);
+    glSamplerParameteri(sampler, GL_TEXTURE_WRAP_T, clamped.wrapT);
+    glSamplerParameteri(sampler, GL_TEXTURE_MIN_FILTER, clamped.minFilter);
+    glSamplerParameteri(sampler, GL_TEXTURE_MAG_FILTER, clamped.magFilter);
+    if(clamped.maxAnisotropy > 1.0f) {
+        glSamplerParameterf(sampler, GL_TEXTURE_MAX_ANISOTROPY, clamped.maxAnisotropy);
+    }
+    glSamplerParameterf(sampler, GL_TEXTURE_LOD_BIAS, clamped.lodBias);
+    glSamplerParameterf(sampler, GL_TEXTURE_MIN_LOD, clamped.minLod);
+    glSamplerParameterf(sampler, GL_TEXTURE_MAX_LOD, clamped.maxLod);
+    samplers[clamped] = sampler;
+    return sampler;
+}
+
+float SamplerCache::GetMaxSupportedAnisotropy() {
+    if(maxSupportedAnisotropy == 0.0f) {
+        // Both extensions use the same enums
+        if(GLAD_GL_ARB_texture_filter_anisotropic || GLAD_GL_EXT_texture_filter_anisotropic) {
+            glGetFloatv(GL_MAX_TEXTURE_MAX_ANISOTROPY, &maxSupportedAnisotropy);
+        }
+        maxSupportedAnisotropy = std::max(maxSupportedAnisotropy, 1.0f);
+    }
+    return maxSupportedAnisotropy;
+}
+
+void SamplerCache::Destroy() {
+    for(std::unordered_map<SamplerDescription, GLuint, DescriptionHash>::iterator iter = samplers.begin(); iter != samplers.end(); iter++) {
+        glDeleteSamplers(1, &iter->second);
+        TextureUnitState::ForgetSampler(iter->second);
+    }
+    samplers.clear();
+    maxSupportedAnisotropy = 0.0f;
+}
+
+}
@@ -0,0 +1,81 @@
+#ifndef SAMPLER_CACHE_H
+#define SAMPLER_CACHE_H
+
+#include <unordered_map>
+#include <cstddef>
+
+#include <glad/glad.h>
+
+namespace Engine {
+
+/*
+ * How a texture is sampled, i.e. the state of an OpenGL sampler object.
+ */
+struct SamplerDescription {
+    GLint wrapS = GL_CLAMP_TO_EDGE;
+    GLint wrapT = GL_CLAMP_TO_EDGE;
+    GLint minFilter = GL_LINEAR_MIPMAP_LINEAR;
+    GLint magFilter = GL_LINEAR;
+    // 1 samples isotropically. Clamped to what the driver supports
+    float maxAnisotropy = 1.0f;
+    float lodBias = 0.0f;
+    float minLod = -1000.0f;
+    float maxLod = 1000.0f;
+    
+    bool operator==(const SamplerDescription& other) const;
+    bool operator!=(const SamplerDescription& other) const { return !(*this == other); }
+    
+    /*
+     * Returns a 64-bit FNV-1a hash of the description.
+     */
+    size_t getHash() const;
+};
+
+struct SamplerCacheStats {
+    // Lookups that found a sampler object with the same description
+    unsigned long long numHits = 0;
+    // Lookups that created a sampler object
+    unsigned long long numMisses = 0;
+};
+
+/*
+ * SamplerCache creates one OpenGL sampler object per distinct SamplerDescription and hands out the same object to
+ * everything sampling the same way, so sampling state is shared between textures rather than set on each of them and
+ * can differ per material without touching the textures. Anisotropy is clamped to the driver's limit before lookup, so
+ * descriptions that only differ beyond it share a sampler.
+ */
+class SamplerCache {
+    public:
+        /*
+         * Returns the sampler object for description, creating it if needed.
+         */
+        static GLuint GetSampler(const SamplerDescription& description);
+        
+        static unsigned int GetNumSamplers() { return samplers.size(); }
+        
+        /*
+         * Returns the largest anisotropy the driver supports, or 1 if it doesn't support anisotropic filtering.
+         */
+        static float GetMaxSupportedAnisotropy();
+        
+        /*
+         * Deletes every sampler object, e.g. before the OpenGL context goes away.
+         */
+        static void Destroy();
+        
+        static const SamplerCacheStats& GetStats() { return stats; }
+        static void ResetStats() { stats = SamplerCacheStats(); }
+    private:
+        struct DescriptionHash {
+            size_t operator()(const SamplerDescription& description) const { return description.getHash(); }
+        };
+        
+        static std::unordered_map<SamplerDescription, GLuint, DescriptionHash> samplers;
+        // 0 until queried from the driver
+        static float maxSupportedAnisotropy;
+        static SamplerCacheStats stats;
+};
+
+}
+
+#endif //SAMPLER_CACHE_H
@@ -5,8 +5,8 @@ namespace Engine {
 /*
  * Class Texture
  */
-Texture::Texture(const std::string filePath, const TextureType type) : type(type) {
-    this->textureID = TextureLoader::LoadTextureFromFile(filePath);
+Texture::Texture(const std::string filePath, const TextureType type, const bool loadAsync) : type(type) {
+    this->textureID = loadAsync ? TextureLoader::LoadTextureFromFileAsync(filePath) : TextureLoader::LoadTextureFromFile(filePath);
     TextureLoader::UseLoadedTexture(this->textureID);
 }
 
@@ -24,8 +24,12 @@ Texture::~Texture() {
     TextureLoader::ReleaseLoadedTexture(this->textureID);
 }
 
-void Texture::bind() const {
-    TextureLoader::BindTexture(this->textureID);
+void Texture::bind(const unsigned int unit) const {
+    TextureLoader::BindTexture(this->textureID, unit);
+}
+
+void Texture::reportUsage(const float screenWidth, const float screenHeight) const {
+    TextureLoader::ReportTextureUsage(this->textureID, screenWidth, screenHeight);
 }
 
 TextureDataPtr Texture::getTextureDataPtr() const {
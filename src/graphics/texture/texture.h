@@ -14,15 +14,25 @@ enum TextureType {
 
 class Texture {
     public:
-        Texture(const std::string filePath, const TextureType type);
+        /*
+         * Loads the texture at filePath. If loadAsync is true the image is decoded in the background and the texture
+         * shows a placeholder until it is ready (see TextureLoader::LoadTextureFromFileAsync).
+         */
+        Texture(const std::string filePath, const TextureType type, const bool loadAsync = false);
         Texture(const TextureDataPtr textureDataPtr, const TextureType type);
         Texture(const Texture& texture);
         ~Texture();
         
         /*
-         * Binds the texture for use.
+         * Binds the texture for use to texture unit unit, along with the sampler for its sampler description.
+         */
+        void bind(const unsigned int unit = 0) const;
+        
+        /*
+         * Records that the texture is drawn this frame covering about screenWidth by screenHeight pixels, for
+         * streaming its mipmap levels (see TextureLoader::ReportTextureUsage).
          */
-        void bind() const;
+        void reportUsage(const float screenWidth, const float screenHeight) const;
         
         /*
          * Returns a TextureDataPtr to a shallow copy of the texture's data in the list of (shared) loaded textures.
@@ -30,14 +40,15 @@ class Texture {
         TextureDataPtr getTextureDataPtr() const;
         
         /*
-         * Returns TextureDataPtr to a deep copy of this texture's data.
+         * Returns TextureDataPtr to a copy of this texture's data that shares pixel data until mutated.
          */
         TextureDataPtr copyTextureData() const;
         
         TextureType getType() const { return type; }
         void setType(const TextureType type) { this->type = type; }
-        unsigned int getWidth() const { return getTextureDataPtr()->getWidth(); }
-        unsigned int getHeight() const { return getTextureDataPtr()->getHeight(); }
+        unsigned int getWidth() const { return TextureLoader::GetWidth(textureID); }
+        unsigned int getHeight() const { return TextureLoader::GetHeight(textureID); }
+        unsigned int getTextureID() const { return textureID; }
     private:
         unsigned int textureID = 0;
         TextureType type;
@@ -0,0 +1,269 @@
+#include "texture_atlas.h"
+#include <algorithm>
+#include <cstring>
+
+namespace Engine {
+
+/*
+ * Class RectanglePacker
+ */
+RectanglePacker::RectanglePacker(const unsigned int width, const unsigned int height) : width(width), height(height), freeRects() {
+    freeRects.push_back({0, 0, width, height});
+}
+
+bool RectanglePacker::insert(const unsigned int width, const unsigned int height, AtlasRect& rect) {
+    if(width == 0 || height == 0) {
+        rect = {0, 0, width, height};
+        return true;
+    }
+    int best = -1;
+    unsigned int bestShortSide = 0;
+    unsigned int bestLongSide = 0;
+    for(unsigned int i = 0; i < freeRects.size(); i++) {
+        const AtlasRect& freeRect = freeRects[i];
+        if(freeRect.width < width || freeRect.height < height) {
+            continue;
+        }
+        unsigned int leftoverX = freeRect.width - width;
+        unsigned int leftoverY = freeRect.height - height;
+        unsigned int shortSide = std::min(leftoverX, leftoverY);
+        unsigned int longSide = std::max(leftoverX, leftoverY);
+        if(best == -1 || shortSide < bestShortSide || (shortSide == bestShortSide && longSide < bestLongSide)) {
+            best = i;
+            bestShortSide = shortSide;
+            bestLongSide = longSide;
+        }
+    }
+    if(best == -1) {
+        return false;
+    }
+    rect = {freeRects[best].x, freeRects[best].y, width, height};
+    splitFreeRects(rect);
+    pruneFreeRects();
+    usedWidth = std::max(usedWidth, rect.x + width);
+    usedHeight = std::max(usedHeight, rect.y + height);
+    usedArea += (size_t)width * height;
+    return true;
+}
+
+float RectanglePacker::getOccupancy() const {
+    if(usedWidth == 0 || usedHeight == 0) {
+        return 0.0f;
+    }
+    return (float)usedArea / ((float)usedWidth * (float)usedHeight);
+}
+
+void RectanglePacker::splitFreeRects(const AtlasRect& placed) {
+    std::vector<AtlasRect> splitRects;
+    unsigned int i = 0;
+    while(i < freeRects.size()) {
+        AtlasRect freeRect = freeRects[i];
+        if(placed.x >= freeRect.x + freeRect.width || placed.x + placed.width <= freeRect.x ||
+                placed.y >= freeRect.y + freeRect.height || placed.y + placed.height <= freeRect.y) {
+            i++;
+            continue;
+        }
+        // Keep the maximal rectangles left free on each side of placed
+        if(placed.x > freeRect.x) {
+            splitRects.push_back({freeRect.x, freeRect.y, placed.x - freeRect.x, freeRect.height});
+        }
+        if(placed.x + placed.width < freeRect.x + freeRect.width) {
+            splitRects.push_back({placed.x + placed.width, freeRect.y, freeRect.x + freeRect.width - (placed.x + placed.width), freeRect.height});
+        }
+        if(placed.y > freeRect.y) {
+            splitRects.push_back({freeRect.x, freeRect.y, freeRect.width, placed.y - freeRect.y});
+        }
+        if(placed.y + placed.height < freeRect.y + freeRect.height) {
+            splitRects.push_back({freeRect.x, placed.y + placed.height, freeRect.width, freeRect.y + freeRect.height - (placed.y + placed.height)});
+        }
+        freeRects[i] = freeRects.back();
+        freeRects.pop_back();
+    }
+    freeRects.insert(freeRects.end(), splitRects.begin(), splitRects.end());
+}
+
+void RectanglePacker::pruneFreeRects() {
+    auto contains = [](const AtlasRect& outer, const AtlasRect& inner) {
+        return inner.x >= outer.x && inner.y >= outer.y && inner.x + inner.width <= outer.x + outer.width &&
+                inner.y + inner.height <= outer.y + outer.height;
+    };
+    unsigned int i = 0;
+    while(i < freeRects.size()) {
+        bool contained = false;
+        for(unsigned int j = 0; j < freeRects.size(); j++) {
+            // Of two identical rectangles only the later one is removed
+            if(j != i && contains(freeRects[j], freeRects[i]) && (!contains(freeRects[i], freeRects[j]) || j < i)) {
+                contained = true;
+                break;
+            }
+        }
+        if(contained) {
+            freeRects.erase(freeRects.begin() + i);
+        }
+        else {
+            i++;
+        }
+    }
+}
+
+/*
+ * Class TextureAtlasBuilder
+ */
+TextureAtlasBuilder::TextureAtlasBuilder(const unsigned int numSlots, const unsigned int maxPageSize, const unsigned int numMipLevels,
+        const unsigned int gutter) : numSlots(numSlots), maxPageSize(maxPageSize), numMipLevels(numMipLevels), gutter(gutter), entries() {
+#ifdef _DEBUG
+    assert(numSlots > 0);
+    assert(numMipLevels > 0);
+    assert(maxPageSize >= (1u << (numMipLevels - 1)));
+#endif
+    alignment = 1 << (numMipLevels - 1);
+}
+
+bool TextureAtlasBuilder::canAdd(const std::vector<TextureDataPtr>& textures) const {
+    if(textures.size() != numSlots || textures[0] == nullptr) {
+        return false;
+    }
+    unsigned int width = textures[0]->getWidth();
+    unsigned int height = textures[0]->getHeight();
+    for(unsigned int slot = 0; slot < textures.size(); slot++) {
+        const TextureDataPtr& textureDataPtr = textures[slot];
+        if(textureDataPtr == nullptr || textureDataPtr->isCompressed() || !PixelConverter::Is8Bit(textureDataPtr->getPixelFormat()) ||
+                textureDataPtr->getWidth() != width || textureDataPtr->getHeight() != height) {
+            return false;
+        }
+    }
+    unsigned int pageSize = maxPageSize / alignment * alignment;
+    return width > 0 && height > 0 && getPaddedSize(width) <= pageSize && getPaddedSize(height) <= pageSize;
+}
+
+unsigned int TextureAtlasBuilder::addEntry(const std::vector<TextureDataPtr>& textures) {
+#ifdef _DEBUG
+    assert(canAdd(textures));
+#endif
+    entries.push_back(textures);
+    return entries.size() - 1;
+}
+
+TextureAtlas TextureAtlasBuilder::build(const MipmapFilter filter, const bool sRGB) {
+    TextureAtlas atlas;
+    atlas.pages.resize(numSlots);
+    atlas.regions.resize(entries.size());
+    
+    // Largest entries first, since they are the hardest to fit
+    std::vector<unsigned int> order(entries.size());
+    for(unsigned int i = 0; i < entries.size(); i++) {
+        order[i] = i;
+    }
+    std::sort(order.begin(), order.end(), [this](const unsigned int a, const unsigned int b) {
+        unsigned int widthA = entries[a][0]->getWidth(), heightA = entries[a][0]->getHeight();
+        unsigned int widthB = entries[b][0]->getWidth(), heightB = entries[b][0]->getHeight();
+        if(std::max(widthA, heightA) != std::max(widthB, heightB)) {
+            return std::max(widthA, heightA) > std::max(widthB, heightB);
+        }
+        if((size_t)widthA * heightA != (size_t)widthB * heightB) {
+            return (size_t)widthA * heightA > (size_t)widthB * heightB;
+        }
+        return a < b;
+    });
+    
+    // Pack in units of the placement grid, so every entry lands on it
+    unsigned int cellsPerPage = maxPageSize / alignment;
+    std::vector<RectanglePacker> packers;
+    std::vector<AtlasRect> cells(entries.size());
+    for(unsigned int i = 0; i < order.size(); i++) {
+        unsigned int entryIndex = order[i];
+        unsigned int cellWidth = getPaddedSize(entries[entryIndex][0]->getWidth()) / alignment;
+        unsigned int cellHeight = getPaddedSize(entries[entryIndex][0]->getHeight()) / alignment;
+        unsigned int page = 0;
+        while(page < packers.size() && !packers[page].insert(cellWidth, cellHeight, cells[entryIndex])) {
+            page++;
+        }
+        if(page == packers.size()) {
+            packers.push_back(RectanglePacker(cellsPerPage, cellsPerPage));
+            bool inserted = packers.back().insert(cellWidth, cellHeight, cells[entryIndex]);
+#ifdef _DEBUG
+            assert(inserted);
+#endif
+            (void)inserted;
+        }
+        atlas.regions[entryIndex].page = page;
+    }
+    
+    for(unsigned int slot = 0; slot < numSlots; slot++) {
+        PixelFormat pixelFormat = entries.empty() ? PIXEL_FORMAT_RGBA8 : entries[0][slot]->getPixelFormat();
+        for(unsigned int i = 1; i < entries.size(); i++) {
+            if(entries[i][slot]->getPixelFormat() != pixelFormat) {
+                pixelFormat = PIXEL_FORMAT_RGBA8;
+                break;
+            }
+        }
+        for(unsigned int page = 0; page < packers.size(); page++) {
+            unsigned int pageWidth = packers[page].getUsedWidth() * alignment;
+            unsigned int pageHeight = packers[page].getUsedHeight() * alignment;
+            std::vector<unsigned char> pixels((size_t)pageWidth * pageHeight * PixelConverter::GetBytesPerPixel(pixelFormat), 0);
+            atlas.pages[slot].push_back(std::make_shared<TextureData>(pageWidth, pageHeight, pixelFormat, SharedBuffer<unsigned char>(std::move(pixels))));
+        }
+        for(unsigned int i = 0; i < entries.size(); i++) {
+            TextureData& page = *atlas.pages[slot][atlas.regions[i].page];
+            const AtlasRect& cell = cells[i];
+            if(entries[i][slot]->getPixelFormat() != pixelFormat) {
+                TextureData converted(*entries[i][slot]);
+                converted.setMipLevels(std::vector<SharedBuffer<unsigned char>>());
+                converted.convert(pixelFormat);
+                blitEntry(converted, page, cell.x * alignment, cell.y * alignment, cell.width * alignment, cell.height * alignment);
+            }
+            else {
+                blitEntry(*entries[i][slot], page, cell.x * alignment, cell.y * alignment, cell.width * alignment, cell.height * alignment);
+            }
+        }
+        for(unsigned int page = 0; page < atlas.pages[slot].size(); page++) {
+            // Coarser levels would filter neighbouring entries together
+            TextureData& pageData = *atlas.pages[slot][page];
+            pageData.generateMipLevels(filter, sRGB);
+            std::vector<SharedBuffer<unsigned char>> mipLevels = pageData.getMipLevels();
+            if(mipLevels.size() > numMipLevels - 1) {
+                mipLevels.resize(numMipLevels - 1);
+            }
+            pageData.setMipLevels(mipLevels);
+        }
+    }
+    
+    for(unsigned int i = 0; i < entries.size(); i++) {
+        AtlasRegion& region = atlas.regions[i];
+        const TextureData& pageData = *atlas.pages[0][region.page];
+        region.rect = {cells[i].x * alignment + gutter, cells[i].y * alignment + gutter, entries[i][0]->getWidth(), entries[i][0]->getHeight()};
+        region.uvOffset = Math::createVec2<float>((float)region.rect.x / pageData.getWidth(), (float)region.rect.y / pageData.getHeight());
+        region.uvScale = Math::createVec2<float>((float)region.rect.width / pageData.getWidth(), (float)region.rect.height / pageData.getHeight());
+    }
+    entries.clear();
+    return atlas;
+}
+
+unsigned int TextureAtlasBuilder::getPaddedSize(const unsigned int size) const {
+    return (size + 2 * gutter + alignment - 1) / alignment * alignment;
+}
+
+void TextureAtlasBuilder::blitEntry(const TextureData& textureData, TextureData& page, const unsigned int x, const unsigned int y,
+        const unsigned int paddedWidth, const unsigned int paddedHeight) const {
+    unsigned int bytesPerPixel = PixelConverter::GetBytesPerPixel(page.getPixelFormat());
+    unsigned int width = textureData.getWidth();
+    unsigned int height = textureData.getHeight();
+    const unsigned char* source = textureData.getData().data();
+    unsigned char* destination = page.mutableData();
+    for(unsigned int row = 0; row < paddedHeight; row++) {
+        // Rows of the gutter and padding repeat the nearest edge row
+        unsigned int sourceRow = (row < gutter) ? 0 : std::min(row - gutter, height - 1);
+        const unsigned char* sourcePixels = source + (size_t)sourceRow * width * bytesPerPixel;
+        unsigned char* destinationPixels = destination + ((size_t)(y + row) * page.getWidth() + x) * bytesPerPixel;
+        for(unsigned int column = 0; column < gutter; column++) {
+            std::memcpy(destinationPixels + (size_t)column * bytesPerPixel, sourcePixels, bytesPerPixel);
+        }
+        std::memcpy(destinationPixels + (size_t)gutter * bytesPerPixel, sourcePixels, (size_t)width * bytesPerPixel);
+        const unsigned char* lastPixel = sourcePixels + (size_t)(width - 1) * bytesPerPixel;
+        for(unsigned int column = gutter + width; column < paddedWidth; column++) {
+            std::memcpy(destinationPixels + (size_t)column * bytesPerPixel, lastPixel, bytesPerPixel);
+        }
+    }
+}
+
+}
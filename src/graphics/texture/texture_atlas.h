@@ -0,0 +1,152 @@
+#ifndef TEXTURE_ATLAS_H
+#define TEXTURE_ATLAS_H
+
+#include <graphics/texture/texture_data.h>
+#include <math/vector.h>
+#include <vector>
+#include <cstddef>
+#include <cassert>
+
+namespace Engine {
+
+/*
+ * A rectangle of pixels (or of packing cells), x and y being its first column and row.
+ */
+struct AtlasRect {
+    unsigned int x = 0;
+    unsigned int y = 0;
+    unsigned int width = 0;
+    unsigned int height = 0;
+};
+
+/*
+ * RectanglePacker packs rectangles into a fixed size area with the MaxRects algorithm. It keeps every maximal free
+ * rectangle, possibly overlapping each other, and places each rectangle in the free one it fits with the least space
+ * left over along its shorter side (best short side fit), which packs tighter than shelf or guillotine packers.
+ */
+class RectanglePacker {
+    public:
+        RectanglePacker(const unsigned int width, const unsigned int height);
+        
+        /*
+         * Places a width by height rectangle, writing where it went to rect. Returns false if it doesn't fit.
+         */
+        bool insert(const unsigned int width, const unsigned int height, AtlasRect& rect);
+        
+        unsigned int getWidth() const { return width; }
+        unsigned int getHeight() const { return height; }
+        
+        /*
+         * Returns the size of the bounding box of every rectangle placed.
+         */
+        unsigned int getUsedWidth() const { return usedWidth; }
+        unsigned int getUsedHeight() const { return usedHeight; }
+        
+        /*
+         * Returns the area covered by the rectangles placed divided by the area of their bounding box.
+         */
+        float getOccupancy() const;
+    private:
+        /*
+         * Replaces the free rectangles overlapping placed with the parts of them left free.
+         */
+        void splitFreeRects(const AtlasRect& placed);
+        
+        /*
+         * Removes free rectangles contained in other free rectangles.
+         */
+        void pruneFreeRects();
+        
+        unsigned int width;
+        unsigned int height;
+        unsigned int usedWidth = 0;
+        unsigned int usedHeight = 0;
+        size_t usedArea = 0;
+        std::vector<AtlasRect> freeRects;
+};
+
+/*
+ * Where an entry of a TextureAtlas was placed. A texture coordinate uv of the entry's textures maps to
+ * uvOffset + uv * uvScale in the page.
+ */
+struct AtlasRegion {
+    unsigned int page = 0;
+    // Pixels of the page holding the entry's textures, without the gutter around them
+    AtlasRect rect;
+    Math::Vec2f uvOffset = Math::Vec2f(0.0f);
+    Math::Vec2f uvScale = Math::Vec2f(1.0f);
+};
+
+/*
+ * Pages built by TextureAtlasBuilder::build. Every slot has the same number of pages with the same layout.
+ */
+struct TextureAtlas {
+    // Page images of each slot, pages[slot][page]
+    std::vector<std::vector<TextureDataPtr>> pages;
+    // Region of each entry, in the order the entries were added
+    std::vector<AtlasRegion> regions;
+    
+    unsigned int getNumPages() const { return pages.empty() ? 0 : pages[0].size(); }
+};
+
+/*
+ * TextureAtlasBuilder packs many small textures into a few large pages, so that materials which only differ in their
+ * textures can share one material and be drawn (and batched) together.
+ *
+ * Each entry holds one texture per slot, e.g. a material's diffuse and specular textures. The textures of an entry
+ * share texture coordinates, so they must be the same size and are placed at the same spot of each slot's pages.
+ *
+ * Each entry is surrounded by a gutter repeating its edge pixels, so that bilinear filtering and clamping at the edge
+ * of an entry read its own pixels. Entries are also padded and placed on a grid of 2^(numMipLevels - 1) pixels, so
+ * that every pixel of the first numMipLevels mipmap levels is filtered from a single entry with the box filter. Pages
+ * only get those levels, since coarser ones would mix neighbouring entries.
+ */
+class TextureAtlasBuilder {
+    public:
+        TextureAtlasBuilder(const unsigned int numSlots = 1, const unsigned int maxPageSize = 2048, const unsigned int numMipLevels = 4,
+                const unsigned int gutter = 8);
+        
+        /*
+         * Returns true if textures can be added as an entry: one uncompressed 8-bit texture per slot, all the same size
+         * and small enough to fit in a page along with their gutter.
+         */
+        bool canAdd(const std::vector<TextureDataPtr>& textures) const;
+        
+        /*
+         * Adds an entry holding textures, one per slot. Returns the index of the entry.
+         */
+        unsigned int addEntry(const std::vector<TextureDataPtr>& textures);
+        
+        unsigned int getNumEntries() const { return entries.size(); }
+        unsigned int getNumSlots() const { return numSlots; }
+        
+        /*
+         * Packs the entries added since the last build into pages, generates their mipmap levels and clears the
+         * builder. The pages of a slot hold pixels in the format of the slot's entries, or RGBA8 if they differ.
+         */
+        TextureAtlas build(const MipmapFilter filter, const bool sRGB);
+    private:
+        /*
+         * Returns the size of an entry size pixels wide (or high) with its gutter, rounded up to the placement grid.
+         */
+        unsigned int getPaddedSize(const unsigned int size) const;
+        
+        /*
+         * Copies textureData into page with the corner of its padded area at (x, y), filling the padded area around it
+         * with its edge pixels.
+         */
+        void blitEntry(const TextureData& textureData, TextureData& page, const unsigned int x, const unsigned int y,
+                const unsigned int paddedWidth, const unsigned int paddedHeight) const;
+        
+        unsigned int numSlots;
+        unsigned int maxPageSize;
+        unsigned int numMipLevels;
+        unsigned int gutter;
+        // Side of the placement grid in pixels
+        unsigned int alignment;
+        std::vector<std::vector<TextureDataPtr>> entries;
+};
+
+}
+
+#endif //TEXTURE_ATLAS_H
@@ -0,0 +1,333 @@
+#include "texture_cache.h"
+#include <fileio/hash.h>
+#include <filesystem>
+#include <fstream>
+#include <sstream>
+#include <iomanip>
+#include <thread>
+#include <functional>
+
+#ifdef _WIN32
+#else
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+namespace Engine {
+
+/*
+ * Start of a container file, followed by the offset and size of each level.
+ */
+struct ContainerHeader {
+    char magic[4];
+    unsigned int version;
+    unsigned long long contentHash;
+    unsigned long long fileSize;
+    long long modifiedTime;
+    unsigned int settingsKey;
+    unsigned int width;
+    unsigned int height;
+    unsigned int numChannels;
+    unsigned int compressedFormat;
+    unsigned int rowAlignment;
+    unsigned int numLevels;
+    unsigned int pixelFormat;
+};
+static_assert(sizeof(ContainerHeader) == 64, "ContainerHeader must have no padding");
+
+struct ContainerLevel {
+    unsigned long long offset;
+    unsigned long long size;
+};
+
+static const char containerMagic[4] = {'E', 'T', 'E', 'X'};
+
+static size_t alignUp(const size_t value, const size_t alignment) {
+    return (value + alignment - 1) / alignment * alignment;
+}
+
+/*
+ * Class TextureCache
+ */
+std::string TextureCache::cacheDirectory = "";
+std::mutex TextureCache::statsMutex;
+TextureCacheStats TextureCache::stats = TextureCacheStats();
+
+void TextureCache::SetCacheDirectory(const std::string& cacheDirectory) {
+    if(cacheDirectory != "") {
+        std::error_code errorCode;
+        std::filesystem::create_directories(cacheDirectory, errorCode);
+        if(errorCode) {
+            throw FileIOException("ERROR: Failed to create texture cache directory \"" + cacheDirectory + "\"");
+        }
+    }
+    TextureCache::cacheDirectory = cacheDirectory;
+}
+
+std::string TextureCache::GetCacheFilePath(const std::string& sourceFilePath) {
+    // The file name keeps the source's name for browsing the cache, and the hash of its absolute path keeps sources
+    // with the same name apart
+    std::error_code errorCode;
+    std::filesystem::path absolutePath = std::filesystem::absolute(std::filesystem::path(sourceFilePath), errorCode);
+    std::string pathString = errorCode ? sourceFilePath : absolutePath.lexically_normal().string();
+    std::stringstream fileName;
+    fileName << std::filesystem::path(sourceFilePath).filename().string() << "." << std::hex << std::setw(16) << std::setfill('0')
+            << Hash::HashBytes(Hash::OFFSET_BASIS, pathString.data(), pathString.size()) << ".etex";
+    return (std::filesystem::path(cacheDirectory) / fileName.str()).string();
+}
+
+TextureDataPtr TextureCache::Load(const std::string& sourceFilePath, const unsigned int settingsKey) {
+    std::string cacheFilePath = GetCacheFilePath(sourceFilePath);
+    std::error_code errorCode;
+    if(!std::filesystem::exists(cacheFilePath, errorCode)) {
+        RecordStat(&TextureCacheStats::numMisses);
+        return nullptr;
+    }
+    try {
+        TextureSourceInfo cachedInfo;
+        TextureDataPtr textureDataPtr = ReadContainer(cacheFilePath, cachedInfo);
+        TextureSourceInfo sourceInfo = GetSourceInfo(sourceFilePath, settingsKey, false);
+        bool valid = cachedInfo.settingsKey == settingsKey && cachedInfo.fileSize == sourceInfo.fileSize;
+        if(valid && cachedInfo.modifiedTime != sourceInfo.modifiedTime) {
+            // The source was touched, so only its contents can tell if it changed
+            valid = GetSourceInfo(sourceFilePath, settingsKey, true).contentHash == cachedInfo.contentHash;
+        }
+        if(valid) {
+            RecordStat(&TextureCacheStats::numHits);
+            return textureDataPtr;
+        }
+    }
+    catch(FileIOException& e) {
+        // A corrupt container, or a source that can't be read any more
+    }
+    std::filesystem::remove(cacheFilePath, errorCode);
+    RecordStat(&TextureCacheStats::numInvalidations);
+    RecordStat(&TextureCacheStats::numMisses);
+    return nullptr;
+}
+
+bool TextureCache::Store(const std::string& sourceFilePath, const TextureSourceInfo& sourceInfo, const TextureDataPtr textureDataPtr) {
+    try {
+        WriteContainer(GetCacheFilePath(sourceFilePath), *textureDataPtr, sourceInfo);
+    }
+    catch(FileIOException& e) {
+        RecordStat(&TextureCacheStats::numWriteFailures);
+        return false;
+    }
+    RecordStat(&TextureCacheStats::numWrites);
+    return true;
+}
+
+void TextureCache::WriteContainer(const std::string& filePath, const TextureData& textureData, const TextureSourceInfo& sourceInfo,
+        const unsigned int rowAlignment) {
+#ifdef _DEBUG
+    assert(rowAlignment > 0);
+#endif
+    ContainerHeader header = {};
+    std::memcpy(header.magic, containerMagic, sizeof(containerMagic));
+    header.version = CONTAINER_VERSION;
+    header.contentHash = sourceInfo.contentHash;
+    header.fileSize = sourceInfo.fileSize;
+    header.modifiedTime = sourceInfo.modifiedTime;
+    header.settingsKey = sourceInfo.settingsKey;
+    header.width = textureData.getWidth();
+    header.height = textureData.getHeight();
+    header.numChannels = textureData.getNumChannels();
+    header.pixelFormat = textureData.getPixelFormat();
+    header.compressedFormat = textureData.getCompressedFormat();
+    header.rowAlignment = textureData.isCompressed() ? 1 : rowAlignment;
+    header.numLevels = textureData.getMipLevels().size() + 1;
+    
+    // Lay the levels out after the level table
+    std::vector<ContainerLevel> levels(header.numLevels);
+    size_t offset = alignUp(sizeof(ContainerHeader) + sizeof(ContainerLevel) * levels.size(), LEVEL_ALIGNMENT);
+    for(unsigned int level = 0; level < header.numLevels; level++) {
+        unsigned int levelWidth = MipmapGenerator::GetLevelSize(header.width, level);
+        unsigned int levelHeight = MipmapGenerator::GetLevelSize(header.height, level);
+        levels[level].offset = offset;
+        levels[level].size = textureData.isCompressed() ? BlockCompressor::GetCompressedSize(levelWidth, levelHeight, textureData.getCompressedFormat())
+                : alignUp((size_t)levelWidth * PixelConverter::GetBytesPerPixel(textureData.getPixelFormat()), header.rowAlignment) * levelHeight;
+        offset = alignUp(offset + levels[level].size, LEVEL_ALIGNMENT);
+    }
+    
+    // Write to a file of this thread's own and rename it into place, so readers never see a partial container
+    std::string temporaryFilePath = filePath + "." + std::to_string(std::hash<std::thread::id>()(std::this_thread::get_id())) + ".tmp";
+    {
+        std::ofstream outFile(temporaryFilePath, std::ios_base::out | std::ios_base::binary | std::ios_base::trunc);
+        outFile.write((const char*)&header, sizeof(header));
+        outFile.write((const char*)levels.data(), sizeof(ContainerLevel) * levels.size());
+        std::vector<char> padding(std::max(LEVEL_ALIGNMENT, (size_t)header.rowAlignment), 0);
+        size_t position = sizeof(ContainerHeader) + sizeof(ContainerLevel) * levels.size();
+        for(unsigned int level = 0; level < header.numLevels; level++) {
+            outFile.write(padding.data(), levels[level].offset - position);
+            const SharedBuffer<unsigned char>& levelData = (level == 0) ? textureData.getData() : textureData.getMipLevels()[level - 1];
+            size_t rowSize = (size_t)MipmapGenerator::GetLevelSize(header.width, level) * PixelConverter::GetBytesPerPixel(textureData.getPixelFormat());
+            size_t alignedRowSize = alignUp(rowSize, header.rowAlignment);
+            if(textureData.isCompressed() || alignedRowSize == rowSize) {
+                outFile.write((const char*)levelData.data(), levels[level].size);
+            }
+            else {
+                for(unsigned int row = 0; row < MipmapGenerator::GetLevelSize(header.height, level); row++) {
+                    outFile.write((const char*)levelData.data() + row * rowSize, rowSize);
+                    outFile.write(padding.data(), alignedRowSize - rowSize);
+                }
+            }
+            position = levels[level].offset + levels[level].size;
+        }
+        if(!outFile) {
+            std::error_code errorCode;
+            std::filesystem::remove(temporaryFilePath, errorCode);
+            throw FileIOException("ERROR: Failed to write texture container \"" + filePath + "\"");
+        }
+    }
+    std::error_code errorCode;
+    std::filesystem::rename(temporaryFilePath, filePath, errorCode);
+    if(errorCode) {
+        std::filesystem::remove(temporaryFilePath, errorCode);
+        throw FileIOException("ERROR: Failed to write texture container \"" + filePath + "\"");
+    }
+}
+
+TextureDataPtr TextureCache::ReadContainer(const std::string& filePath, TextureSourceInfo& sourceInfo) {
+    size_t fileSize = 0;
+    std::shared_ptr<unsigned char[]> mappingPtr = MapFile(filePath, fileSize);
+    ContainerHeader header;
+    if(fileSize < sizeof(header)) {
+        throw FileIOException("ERROR: Texture container \"" + filePath + "\" is truncated");
+    }
+    std::memcpy(&header, mappingPtr.get(), sizeof(header));
+    bool validFormat = header.compressedFormat <= COMPRESSED_FORMAT_BC7 && (header.compressedFormat != COMPRESSED_FORMAT_NONE ||
+            (header.pixelFormat <= PIXEL_FORMAT_RGBA16F && header.rowAlignment > 0));
+    if(std::memcmp(header.magic, containerMagic, sizeof(containerMagic)) != 0 || header.version != CONTAINER_VERSION || !validFormat
+            || header.width == 0 || header.height == 0 || header.numLevels == 0
+            || header.numLevels > MipmapGenerator::GetNumLevels(header.width, header.height)) {
+        throw FileIOException("ERROR: \"" + filePath + "\" is not a valid texture container");
+    }
+    if(fileSize < sizeof(header) + sizeof(ContainerLevel) * header.numLevels) {
+        throw FileIOException("ERROR: Texture container \"" + filePath + "\" is truncated");
+    }
+    CompressedFormat compressedFormat = (CompressedFormat)header.compressedFormat;
+    PixelFormat pixelFormat = (PixelFormat)header.pixelFormat;
+    
+    std::vector<SharedBuffer<unsigned char>> levels;
+    for(unsigned int level = 0; level < header.numLevels; level++) {
+        ContainerLevel containerLevel;
+        std::memcpy(&containerLevel, mappingPtr.get() + sizeof(header) + sizeof(ContainerLevel) * level, sizeof(containerLevel));
+        unsigned int levelWidth = MipmapGenerator::GetLevelSize(header.width, level);
+        unsigned int levelHeight = MipmapGenerator::GetLevelSize(header.height, level);
+        size_t rowSize = (size_t)levelWidth * PixelConverter::GetBytesPerPixel(pixelFormat);
+        size_t alignedRowSize = (compressedFormat != COMPRESSED_FORMAT_NONE) ? 0 : alignUp(rowSize, header.rowAlignment);
+        size_t expectedSize = (compressedFormat != COMPRESSED_FORMAT_NONE) ? BlockCompressor::GetCompressedSize(levelWidth, levelHeight, compressedFormat)
+                : alignedRowSize * levelHeight;
+        if(containerLevel.size != expectedSize || containerLevel.offset > fileSize || containerLevel.size > fileSize - containerLevel.offset) {
+            throw FileIOException("ERROR: Texture container \"" + filePath + "\" has a corrupt level " + std::to_string(level));
+        }
+        const unsigned char* levelPtr = mappingPtr.get() + containerLevel.offset;
+        if(compressedFormat == COMPRESSED_FORMAT_NONE && alignedRowSize != rowSize) {
+            std::vector<unsigned char> levelData(rowSize * levelHeight);
+            for(unsigned int row = 0; row < levelHeight; row++) {
+                std::memcpy(levelData.data() + row * rowSize, levelPtr + row * alignedRowSize, rowSize);
+            }
+            levels.push_back(SharedBuffer<unsigned char>(std::move(levelData)));
+        }
+        else {
+            // Refer to the mapping, which stays mapped while any level refers to it
+            std::shared_ptr<unsigned char[]> levelDataPtr(mappingPtr, mappingPtr.get() + containerLevel.offset);
+            levels.push_back(SharedBuffer<unsigned char>(levelDataPtr, containerLevel.size));
+        }
+    }
+    
+    sourceInfo.contentHash = header.contentHash;
+    sourceInfo.fileSize = header.fileSize;
+    sourceInfo.modifiedTime = header.modifiedTime;
+    sourceInfo.settingsKey = header.settingsKey;
+    std::vector<SharedBuffer<unsigned char>> mipLevels(levels.begin() + 1, levels.end());
+    if(compressedFormat != COMPRESSED_FORMAT_NONE) {
+        return std::make_shared<TextureData>(header.width, header.height, compressedFormat, levels[0], mipLevels);
+    }
+    TextureDataPtr textureDataPtr = std::make_shared<TextureData>(header.width, header.height, pixelFormat, levels[0]);
+    textureDataPtr->setMipLevels(mipLevels);
+    return textureDataPtr;
+}
+
+TextureSourceInfo TextureCache::GetSourceInfo(const std::string& filePath, const unsigned int settingsKey, const bool hashContents) {
+    TextureSourceInfo sourceInfo;
+    std::error_code errorCode;
+    sourceInfo.fileSize = std::filesystem::file_size(filePath, errorCode);
+    if(errorCode) {
+        throw FileIOException("ERROR: Failed to read \"" + filePath + "\"");
+    }
+    std::filesystem::file_time_type modifiedTime = std::filesystem::last_write_time(filePath, errorCode);
+    if(errorCode) {
+        throw FileIOException("ERROR: Failed to read \"" + filePath + "\"");
+    }
+    sourceInfo.modifiedTime = modifiedTime.time_since_epoch().count();
+    sourceInfo.settingsKey = settingsKey;
+    if(hashContents) {
+        size_t fileSize = 0;
+        std::shared_ptr<unsigned char[]> mappingPtr = MapFile(filePath, fileSize);
+        sourceInfo.contentHash = Hash::HashBytes(Hash::OFFSET_BASIS, mappingPtr.get(), fileSize);
+    }
+    return sourceInfo;
+}
+
+TextureCacheStats TextureCache::GetStats() {
+    std::lock_guard<std::mutex> lock(statsMutex);
+    return stats;
+}
+
+void TextureCache::ResetStats() {
+    std::lock_guard<std::mutex> lock(statsMutex);
+    stats = TextureCacheStats();
+}
+
+std::shared_ptr<unsigned char[]> TextureCache::MapFile(const std::string& filePath, size_t& fileSize) {
+#ifdef _WIN32
+    // Read the file instead of mapping it
+    std::ifstream inFile(filePath, std::ios_base::in | std::ios_base::binary | std::ios_base::ate);
+    if(!inFile) {
+        throw FileIOException("ERROR: Failed to read \"" + filePath + "\"");
+    }
+    fileSize = (size_t)inFile.tellg();
+    std::shared_ptr<unsigned char[]> dataPtr(new unsigned char[std::max(fileSize, (size_t)1)]);
+    inFile.seekg(0);
+    inFile.read((char*)dataPtr.get(), fileSize);
+    if(!inFile) {
+        throw FileIOException("ERROR: Failed to read \"" + filePath + "\"");
+    }
+    return dataPtr;
+#else
+    int fileDescriptor = open(filePath.c_str(), O_RDONLY);
+    if(fileDescriptor < 0) {
+        throw FileIOException("ERROR: Failed to read \"" + filePath + "\"");
+    }
+    struct stat fileStat;
+    if(fstat(fileDescriptor, &fileStat) != 0) {
+        close(fileDescriptor);
+        throw FileIOException("ERROR: Failed to read \"" + filePath + "\"");
+    }
+    fileSize = (size_t)fileStat.st_size;
+    if(fileSize == 0) {
+        // Empty files can't be mapped
+        close(fileDescriptor);
+        return std::shared_ptr<unsigned char[]>(new unsigned char[1]);
+    }
+    // Writable but private, so texture data referring to the mapping can be written in place without changing the file
+    void* mapping = mmap(nullptr, fileSize, PROT_READ | PROT_WRITE, MAP_PRIVATE, fileDescriptor, 0);
+    close(fileDescriptor);
+    if(mapping == MAP_FAILED) {
+        throw FileIOException("ERROR: Failed to map \"" + filePath + "\"");
+    }
+    size_t mappingSize = fileSize;
+    return std::shared_ptr<unsigned char[]>((unsigned char*)mapping, [mappingSize](unsigned char* mappingPtr) { munmap(mappingPtr, mappingSize); });
+#endif
+}
+
+void TextureCache::RecordStat(unsigned long long TextureCacheStats::* counter) {
+    std::lock_guard<std::mutex> lock(statsMutex);
+    stats.*counter += 1;
+}
+
+}
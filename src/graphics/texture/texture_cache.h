@@ -0,0 +1,117 @@
+#ifndef TEXTURE_CACHE_H
+#define TEXTURE_CACHE_H
+
+#include <exceptions/io_exception.h>
+#include <graphics/texture/texture_data.h>
+#include <string>
+#include <mutex>
+#include <memory>
+
+namespace Engine {
+
+/*
+ * Identity of the source image a texture container was built from, and of the settings it was built with.
+ */
+struct TextureSourceInfo {
+    // 64-bit FNV-1a hash of the source file's contents
+    unsigned long long contentHash = 0;
+    unsigned long long fileSize = 0;
+    long long modifiedTime = 0;
+    // MipmapSettings::getCacheKey of the settings the mipmap chain was built with
+    unsigned int settingsKey = 0;
+};
+
+/*
+ * Counts of TextureCache lookups.
+ */
+struct TextureCacheStats {
+    unsigned long long numHits = 0;
+    unsigned long long numMisses = 0;
+    // Containers deleted because their source file changed, the settings differ or the container is corrupt
+    unsigned long long numInvalidations = 0;
+    unsigned long long numWrites = 0;
+    unsigned long long numWriteFailures = 0;
+};
+
+/*
+ * TextureCache keeps decoded textures in a directory as GPU ready containers, so later runs map the file and upload
+ * its levels instead of decoding the source image and building its mipmap chain again.
+ *
+ * A container holds the dimensions, the pixel format, the compressed format (if any), the row alignment of raw
+ * levels and every mipmap level, each level 16-byte aligned in the file. Containers are mapped into memory and the
+ * texture data of a cache hit refers to the mapping without copying it. Each container records the content hash of
+ * its source file. The source's size and modification time are checked first, so the source is only read again when
+ * they have changed, and a container whose source contents changed is deleted and rebuilt.
+ *
+ * Load and Store are safe to call from AsyncLoader worker threads. Set the cache directory before loading textures.
+ */
+class TextureCache {
+    public:
+        /*
+         * Sets the directory containers are kept in, creating it if needed. An empty path disables the cache, which is
+         * the default.
+         */
+        static void SetCacheDirectory(const std::string& cacheDirectory);
+        static const std::string& GetCacheDirectory() { return cacheDirectory; }
+        static bool IsEnabled() { return !cacheDirectory.empty(); }
+        
+        /*
+         * Returns the path of the container for the source image at sourceFilePath.
+         */
+        static std::string GetCacheFilePath(const std::string& sourceFilePath);
+        
+        /*
+         * Returns the cached texture for the image at sourceFilePath, or nullptr if there is no container built from
+         * the file's current contents with settingsKey. Stale and corrupt containers are deleted.
+         */
+        static TextureDataPtr Load(const std::string& sourceFilePath, const unsigned int settingsKey);
+        
+        /*
+         * Writes textureDataPtr to the container for the image at sourceFilePath, recording sourceInfo. Take
+         * sourceInfo before decoding the source, so that a source changed in the meantime is caught by the next Load.
+         * Returns false if the container couldn't be written, which leaves the texture uncached rather than failing
+         * the load.
+         */
+        static bool Store(const std::string& sourceFilePath, const TextureSourceInfo& sourceInfo, const TextureDataPtr textureDataPtr);
+        
+        /*
+         * Writes textureData to a container at filePath, padding the rows of raw levels to rowAlignment bytes. Throws
+         * FileIOException if the file can't be written.
+         */
+        static void WriteContainer(const std::string& filePath, const TextureData& textureData, const TextureSourceInfo& sourceInfo,
+                const unsigned int rowAlignment = 1);
+        
+        /*
+         * Maps the container at filePath and returns its texture data, whose levels refer to the mapping. Levels with
+         * padded rows are repacked. Throws FileIOException if the file can't be read or isn't a valid container.
+         */
+        static TextureDataPtr ReadContainer(const std::string& filePath, TextureSourceInfo& sourceInfo);
+        
+        /*
+         * Returns the size, modification time and, if hashContents is true, the content hash of the file at filePath.
+         * Throws FileIOException if the file can't be read.
+         */
+        static TextureSourceInfo GetSourceInfo(const std::string& filePath, const unsigned int settingsKey, const bool hashContents);
+        
+        static TextureCacheStats GetStats();
+        static void ResetStats();
+    private:
+        /*
+         * Maps the file at filePath into memory copy on write, so writes through the mapping never reach the file. The
+         * mapping is released with the last reference to it.
+         */
+        static std::shared_ptr<unsigned char[]> MapFile(const std::string& filePath, size_t& fileSize);
+        
+        static void RecordStat(unsigned long long TextureCacheStats::* counter);
+        
+        static constexpr unsigned int CONTAINER_VERSION = 2;
+        static constexpr size_t LEVEL_ALIGNMENT = 16;
+        
+        static std::string cacheDirectory;
+        static std::mutex statsMutex;
+        static TextureCacheStats stats;
+};
+
+}
+
+#endif //TEXTURE_CACHE_H
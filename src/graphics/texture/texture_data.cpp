@@ -1,21 +1,94 @@
 #include "texture_data.h"
+#include "texture_cache.h"
+#include <algorithm>
 
 namespace Engine {
 
 /*
  * Class TextureData
  */
-TextureData::TextureData(const unsigned int width, const unsigned int height, const unsigned int numChannels, const std::shared_ptr<unsigned char[]> dataPtr)
-    : width(width), height(height), numChannels(numChannels), dataPtr(dataPtr) {
-    this->size = width * height * numChannels * bytesPerChannel;
-    this->dataPtr = dataPtr;
+TextureData::TextureData(const unsigned int width, const unsigned int height, const unsigned int numChannels, const SharedBuffer<unsigned char> data)
+    : TextureData(width, height, PixelConverter::GetPixelFormat(numChannels), data) {
 }
 
-TextureData::TextureData(const TextureData& textureData)
-    : width(textureData.width), height(textureData.height), numChannels(textureData.numChannels) {
-    this->size = textureData.size;
-    this->dataPtr = std::shared_ptr<unsigned char[]>(new unsigned char[this->size]);
-    memcpy(this->dataPtr.get(), textureData.dataPtr.get(), this->size);
+TextureData::TextureData(const unsigned int width, const unsigned int height, const PixelFormat pixelFormat, const SharedBuffer<unsigned char> data)
+    : width(width), height(height), numChannels(PixelConverter::GetNumChannels(pixelFormat)), pixelFormat(pixelFormat), data(data) {
+    this->size = width * height * PixelConverter::GetBytesPerPixel(pixelFormat);
+#ifdef _DEBUG
+    assert(this->data.getSize() >= this->size);
+#endif
+}
+
+TextureData::TextureData(const unsigned int width, const unsigned int height, const CompressedFormat compressedFormat, const SharedBuffer<unsigned char> data,
+        const std::vector<SharedBuffer<unsigned char>>& mipLevels)
+    : width(width), height(height), numChannels(BlockCompressor::GetNumChannels(compressedFormat)),
+    pixelFormat(PixelConverter::GetPixelFormat(BlockCompressor::GetNumChannels(compressedFormat))), data(data), mipLevels(mipLevels),
+    compressedFormat(compressedFormat) {
+    this->size = BlockCompressor::GetCompressedSize(width, height, compressedFormat);
+#ifdef _DEBUG
+    assert(compressedFormat != COMPRESSED_FORMAT_NONE);
+    assert(this->data.getSize() >= this->size);
+#endif
+}
+
+void TextureData::generateMipLevels(const MipmapFilter filter, const bool sRGB) {
+#ifdef _DEBUG
+    assert(!isCompressed());
+    assert(PixelConverter::Is8Bit(pixelFormat));
+#endif
+    // Alpha is the second channel of grey and alpha pixels
+    unsigned int alphaChannel = (pixelFormat == PIXEL_FORMAT_LA8) ? 1 : 3;
+    mipLevels = MipmapGenerator::GenerateMipLevels(data.data(), width, height, numChannels, filter, sRGB, alphaChannel);
+}
+
+void TextureData::convert(const PixelFormat pixelFormat) {
+#ifdef _DEBUG
+    assert(!isCompressed());
+#endif
+    if(pixelFormat == this->pixelFormat) {
+        return;
+    }
+    unsigned int bytesPerPixel = PixelConverter::GetBytesPerPixel(pixelFormat);
+    std::vector<unsigned char> converted((size_t)width * height * bytesPerPixel);
+    PixelConverter::ConvertPixels(data.data(), this->pixelFormat, converted.data(), pixelFormat, (size_t)width * height);
+    data = SharedBuffer<unsigned char>(std::move(converted));
+    for(unsigned int level = 1; level <= mipLevels.size(); level++) {
+        size_t numPixels = (size_t)MipmapGenerator::GetLevelSize(width, level) * MipmapGenerator::GetLevelSize(height, level);
+        std::vector<unsigned char> convertedLevel(numPixels * bytesPerPixel);
+        PixelConverter::ConvertPixels(mipLevels[level - 1].data(), this->pixelFormat, convertedLevel.data(), pixelFormat, numPixels);
+        mipLevels[level - 1] = SharedBuffer<unsigned char>(std::move(convertedLevel));
+    }
+    this->pixelFormat = pixelFormat;
+    numChannels = PixelConverter::GetNumChannels(pixelFormat);
+    size = data.getSize();
+}
+
+void TextureData::compress(const CompressedFormat compressedFormat, const CompressionQuality quality) {
+#ifdef _DEBUG
+    assert(!isCompressed());
+    assert(compressedFormat != COMPRESSED_FORMAT_NONE);
+#endif
+    // The compressor reads grey, two channels as red and green, RGB and RGBA
+    if(pixelFormat != PIXEL_FORMAT_L8 && pixelFormat != PIXEL_FORMAT_RG8 && pixelFormat != PIXEL_FORMAT_RGB8 && pixelFormat != PIXEL_FORMAT_RGBA8) {
+        convert(PIXEL_FORMAT_RGBA8);
+    }
+    data = BlockCompressor::CompressImage(data.data(), width, height, numChannels, compressedFormat, quality);
+    for(unsigned int level = 1; level <= mipLevels.size(); level++) {
+        mipLevels[level - 1] = BlockCompressor::CompressImage(mipLevels[level - 1].data(), MipmapGenerator::GetLevelSize(width, level),
+                MipmapGenerator::GetLevelSize(height, level), numChannels, compressedFormat, quality);
+    }
+    numChannels = BlockCompressor::GetNumChannels(compressedFormat);
+    pixelFormat = PixelConverter::GetPixelFormat(numChannels);
+    size = data.getSize();
+    this->compressedFormat = compressedFormat;
+}
+
+size_t TextureData::getSizeInBytesWithMipLevels() const {
+    size_t numBytes = data.getSizeInBytes();
+    for(unsigned int i = 0; i < mipLevels.size(); i++) {
+        numBytes += mipLevels[i].getSizeInBytes();
+    }
+    return numBytes;
 }
 
 /*
@@ -24,75 +97,252 @@ TextureData::TextureData(const TextureData& textureData)
 unsigned int TextureLoader::spareID = 1;
 std::stack<unsigned int> TextureLoader::availableIDStack = std::stack<unsigned int>();
 std::unordered_map<unsigned int, TextureLoader::TextureInfo> TextureLoader::loadedTextures = std::unordered_map<unsigned int, TextureLoader::TextureInfo>();
+PathIndex TextureLoader::pathIndex = PathIndex();
+ResidencyPolicy TextureLoader::defaultResidencyPolicy = RESIDENCY_KEEP_HOST_COPY;
+DeferredReleaseQueue TextureLoader::releaseQueue = DeferredReleaseQueue();
+unsigned long long TextureLoader::spareAsyncLoadTicket = 1;
+SharedBuffer<unsigned char> TextureLoader::placeholderPixels = SharedBuffer<unsigned char>(std::vector<unsigned char>({128, 128, 128}));
+MipmapSettings TextureLoader::mipmapSettings = MipmapSettings();
+bool TextureLoader::defaultStreamed = false;
+SamplerDescription TextureLoader::defaultSamplerDescription;
+TextureStreamingPolicy TextureLoader::streamingPolicy = TextureStreamingPolicy();
+size_t TextureLoader::streamingUploadBudget = 16 * 1024 * 1024;
+
+static GLenum getGLCompressedFormat(const CompressedFormat compressedFormat) {
+    switch(compressedFormat) {
+        case COMPRESSED_FORMAT_BC1:
+            return GL_COMPRESSED_RGB_S3TC_DXT1_EXT;
+        case COMPRESSED_FORMAT_BC3:
+            return GL_COMPRESSED_RGBA_S3TC_DXT5_EXT;
+        case COMPRESSED_FORMAT_BC5:
+            return GL_COMPRESSED_RG_RGTC2;
+        default:
+            return GL_COMPRESSED_RGBA_BPTC_UNORM;
+    }
+}
 
 void TextureLoader::PreLoadTextures(const std::vector<std::string>& textureFilePaths) {
+    LoadTexturesFromFiles(textureFilePaths);
+}
+
+std::vector<unsigned int> TextureLoader::LoadTexturesFromFiles(const std::vector<std::string>& textureFilePaths) {
+    std::vector<unsigned int> textureIDs(textureFilePaths.size(), 0);
+    std::vector<std::future<TextureDataPtr>> decodedTextures(textureFilePaths.size());
+    // Index of the first occurrence of each path that needs decoding, so repeats in the list are decoded once
+    std::unordered_map<unsigned int, unsigned int> decodeIndices;
+    std::vector<unsigned int> firstOccurrences(textureFilePaths.size());
+    MipmapSettings currentMipmapSettings = mipmapSettings;
     for(unsigned int i = 0; i < textureFilePaths.size(); i++) {
-        LoadTextureFromFile(textureFilePaths[i]);
+        textureIDs[i] = pathIndex.find(textureFilePaths[i]);
+        firstOccurrences[i] = i;
+        if(textureIDs[i] != 0) {
+            continue;
+        }
+        unsigned int pathID = PathTable::Intern(textureFilePaths[i]);
+        std::unordered_map<unsigned int, unsigned int>::iterator iter = decodeIndices.find(pathID);
+        if(iter != decodeIndices.end()) {
+            firstOccurrences[i] = iter->second;
+            continue;
+        }
+        decodeIndices[pathID] = i;
+        std::string filePath = textureFilePaths[i];
+        decodedTextures[i] = AsyncLoader::Submit<TextureDataPtr>([filePath, currentMipmapSettings]() {
+            return ReadTextureFile(filePath, currentMipmapSettings);
+        });
     }
+    
+    // Register the decoded textures in order, waiting for every decode before passing on a failure
+    std::exception_ptr failure;
+    for(unsigned int i = 0; i < textureFilePaths.size(); i++) {
+        if(textureIDs[i] != 0) {
+            continue;
+        }
+        if(firstOccurrences[i] != i) {
+            textureIDs[i] = textureIDs[firstOccurrences[i]];
+            continue;
+        }
+        try {
+            textureIDs[i] = AddLoadedTexture(textureFilePaths[i], decodedTextures[i].get());
+        }
+        catch(FileIOException& e) {
+            if(!failure) {
+                failure = std::current_exception();
+            }
+        }
+    }
+    if(failure) {
+        std::rethrow_exception(failure);
+    }
+    return textureIDs;
 }
 
 void TextureLoader::UnloadUnusedTextures() {
+    std::vector<unsigned int> unusedTextureIDs;
     for(std::unordered_map<unsigned int, TextureInfo>::iterator iter = loadedTextures.begin(); iter != loadedTextures.end(); iter++) {
         if(iter->second.usingCount == 0) {
-            UnloadTexture(iter->first);
+            unusedTextureIDs.push_back(iter->first);
         }
     }
+    for(unsigned int i = 0; i < unusedTextureIDs.size(); i++) {
+        UnloadTexture(unusedTextureIDs[i]);
+    }
+}
+
+void TextureLoader::BindTexture(const unsigned int textureID, const unsigned int unit) {
+#ifdef _DEBUG
+    assert(textureID != 0);
+#endif
+    const TextureInfo& textureInfo = loadedTextures[textureID];
+    TextureUnitState::Bind(unit, textureInfo.textureName, SamplerCache::GetSampler(textureInfo.samplerDescription));
+}
+
+void TextureLoader::BindTexture(const unsigned int textureID, const unsigned int unit, const SamplerDescription& samplerDescription) {
+#ifdef _DEBUG
+    assert(textureID != 0);
+#endif
+    TextureUnitState::Bind(unit, loadedTextures[textureID].textureName, SamplerCache::GetSampler(samplerDescription));
+}
+
+void TextureLoader::BindTexture(const unsigned int textureID, const unsigned int unit, const GLuint sampler) {
+#ifdef _DEBUG
+    assert(textureID != 0);
+#endif
+    TextureUnitState::Bind(unit, loadedTextures[textureID].textureName, sampler);
+}
+
+void TextureLoader::SetSamplerDescription(const unsigned int textureID, const SamplerDescription& samplerDescription) {
+#ifdef _DEBUG
+    assert(textureID != 0);
+    assert(loadedTextures.count(textureID) > 0);
+#endif
+    loadedTextures[textureID].samplerDescription = samplerDescription;
 }
 
-void TextureLoader::BindTexture(const unsigned int textureID) {
+const SamplerDescription& TextureLoader::GetSamplerDescription(const unsigned int textureID) {
 #ifdef _DEBUG
     assert(textureID != 0);
+    assert(loadedTextures.count(textureID) > 0);
 #endif
-    glBindTexture(GL_TEXTURE_2D, loadedTextures[textureID].textureName);
+    return loadedTextures[textureID].samplerDescription;
 }
 
 TextureDataPtr TextureLoader::GetTextureDataPtr(const unsigned int textureID) {
 #ifdef _DEBUG
     assert(textureID != 0);
 #endif
+    EnsureHostResident(textureID);
     return loadedTextures[textureID].textureDataPtr;
 }
 
 unsigned int TextureLoader::LoadTextureFromFile(const std::string filePath) {
-    // Check if the texture is already buffered
-    for(std::unordered_map<unsigned int, TextureInfo>::iterator iter = loadedTextures.begin(); iter != loadedTextures.end(); iter++) {
-        if(iter->second.filePath == filePath) {
-            return iter->first;
-        }
+    // Check if the texture is already loaded
+    unsigned int loadedTextureID = pathIndex.find(filePath);
+    if(loadedTextureID != 0) {
+        return loadedTextureID;
     }
     
     // Load texture from file system into memory
-    TextureDataPtr textureDataPtr;
-    int width = 0;
-    int height = 0;
-    int imgNumChannels = 0;
-    stbi_set_flip_vertically_on_load(true);
-    std::shared_ptr<unsigned char[]> dataPtr = std::shared_ptr<unsigned char[]>(stbi_load(filePath.c_str(), &width, &height, &imgNumChannels, 0));
-    if(!dataPtr.get()) {
-        throw Engine::FileIOException("ERROR: Failed to load image data from \"" + filePath + "\"");
+    return AddLoadedTexture(filePath, ReadTextureFile(filePath, mipmapSettings));
+}
+
+unsigned int TextureLoader::AddLoadedTexture(const std::string& filePath, const TextureDataPtr textureDataPtr) {
+    TextureInfo textureInfo;
+    textureInfo.filePath = filePath;
+    textureInfo.textureDataPtr = textureDataPtr;
+    textureInfo.textureName = 0;
+    textureInfo.usingCount = 0;
+    textureInfo.residencyPolicy = defaultResidencyPolicy;
+    textureInfo.streamed = defaultStreamed;
+    textureInfo.samplerDescription = defaultSamplerDescription;
+    textureInfo.width = textureDataPtr->getWidth();
+    textureInfo.height = textureDataPtr->getHeight();
+    textureInfo.pixelFormat = textureDataPtr->getPixelFormat();
+    textureInfo.compressedFormat = textureDataPtr->getCompressedFormat();
+    textureInfo.timesBuffered = 0;
+    if(availableIDStack.empty()) {
+        availableIDStack.push(spareID++);
+    }
+    unsigned int textureID = availableIDStack.top();
+    availableIDStack.pop();
+    loadedTextures[textureID] = textureInfo;
+    pathIndex.insert(filePath, textureID);
+    return textureID;
+}
+
+unsigned int TextureLoader::LoadTextureFromFileAsync(const std::string filePath) {
+    // Check if the texture is already loaded
+    unsigned int loadedTextureID = pathIndex.find(filePath);
+    if(loadedTextureID != 0) {
+        return loadedTextureID;
     }
-    textureDataPtr = std::make_shared<TextureData>((unsigned int)width, (unsigned int)height, (unsigned int)imgNumChannels, dataPtr);
     
     TextureInfo textureInfo;
     textureInfo.filePath = filePath;
-    textureInfo.textureDataPtr = textureDataPtr;
+    textureInfo.textureDataPtr = std::make_shared<TextureData>(1, 1, 3, placeholderPixels);
     textureInfo.textureName = 0;
     textureInfo.usingCount = 0;
+    textureInfo.residencyPolicy = defaultResidencyPolicy;
+    textureInfo.streamed = defaultStreamed;
+    textureInfo.samplerDescription = defaultSamplerDescription;
+    textureInfo.width = 1;
+    textureInfo.height = 1;
+    textureInfo.pixelFormat = PIXEL_FORMAT_RGB8;
+    textureInfo.timesBuffered = 0;
+    textureInfo.asyncLoadTicket = spareAsyncLoadTicket++;
     if(availableIDStack.empty()) {
         availableIDStack.push(spareID++);
     }
     unsigned int textureID = availableIDStack.top();
     availableIDStack.pop();
     loadedTextures[textureID] = textureInfo;
+    pathIndex.insert(filePath, textureID);
+    
+    // Decode on a worker, then swap the image in on the main thread
+    unsigned long long asyncLoadTicket = textureInfo.asyncLoadTicket;
+    MipmapSettings currentMipmapSettings = mipmapSettings;
+    AsyncLoader::Submit<void>([textureID, asyncLoadTicket, filePath, currentMipmapSettings]() {
+        TextureDataPtr textureDataPtr;
+        try {
+            textureDataPtr = ReadTextureFile(filePath, currentMipmapSettings);
+        }
+        catch(FileIOException& e) {
+            textureDataPtr.reset();
+        }
+        AsyncLoader::QueueOnMainThread([textureID, asyncLoadTicket, textureDataPtr]() {
+            CompleteAsyncLoad(textureID, asyncLoadTicket, textureDataPtr);
+        });
+    });
     return textureID;
 }
 
+bool TextureLoader::IsAsyncLoadPending(const unsigned int textureID) {
+#ifdef _DEBUG
+    assert(textureID != 0);
+#endif
+    return loadedTextures[textureID].asyncLoadTicket != 0;
+}
+
+bool TextureLoader::HasAsyncLoadFailed(const unsigned int textureID) {
+#ifdef _DEBUG
+    assert(textureID != 0);
+#endif
+    return loadedTextures[textureID].asyncLoadFailed;
+}
+
 unsigned int TextureLoader::LoadTextureFromTextureData(const TextureDataPtr textureDataPtr) {
     TextureInfo textureInfo;
     textureInfo.filePath = "";
     textureInfo.textureDataPtr = std::make_shared<TextureData>(*(textureDataPtr.get()));
     textureInfo.textureName = 0;
     textureInfo.usingCount = 0;
+    textureInfo.residencyPolicy = defaultResidencyPolicy;
+    textureInfo.streamed = defaultStreamed;
+    textureInfo.samplerDescription = defaultSamplerDescription;
+    textureInfo.width = textureDataPtr->getWidth();
+    textureInfo.height = textureDataPtr->getHeight();
+    textureInfo.pixelFormat = textureDataPtr->getPixelFormat();
+    textureInfo.compressedFormat = textureDataPtr->getCompressedFormat();
+    textureInfo.timesBuffered = 0;
     if(availableIDStack.empty()) {
         availableIDStack.push(spareID++);
     }
@@ -110,7 +360,7 @@ void TextureLoader::UseLoadedTexture(const unsigned int textureID) {
 #ifdef _DEBUG
     assert(textureID != 0);
 #endif
-    if(loadedTextures[textureID].usingCount == 0) {
+    if(loadedTextures[textureID].usingCount == 0 && !releaseQueue.resurrect(textureID)) {
         BufferTextureData(textureID);
     }
     loadedTextures[textureID].usingCount++;
@@ -123,7 +373,16 @@ void TextureLoader::ReleaseLoadedTexture(const unsigned int textureID) {
 #endif
     loadedTextures[textureID].usingCount--;
     if(loadedTextures[textureID].usingCount == 0) {
-        UnBufferTextureData(textureID);
+        releaseQueue.schedule(textureID, loadedTextures[textureID].deviceBytes, FrameClock::GetFrameNumber());
+    }
+}
+
+void TextureLoader::ProcessDeferredReleases(const bool reclaimAll) {
+    std::vector<unsigned int> reclaimedTextureIDs = releaseQueue.collect(FrameClock::GetFrameNumber(), reclaimAll);
+    for(unsigned int i = 0; i < reclaimedTextureIDs.size(); i++) {
+        unsigned int textureID = reclaimedTextureIDs[i];
+        // Textures without a file are unloaded straight after, so their host copy isn't refetched
+        UnBufferTextureData(textureID, loadedTextures[textureID].filePath != "");
         if(loadedTextures[textureID].filePath == "") {
             UnloadTexture(textureID);
         }
@@ -134,6 +393,7 @@ TextureDataPtr TextureLoader::CopyTextureDataFromLoaded(const unsigned int textu
 #ifdef _DEBUG
     assert(textureID != 0);
 #endif
+    EnsureHostResident(textureID);
     return std::make_shared<TextureData>(*(loadedTextures[textureID].textureDataPtr));
     
 //    unsigned int pixelBufferID;
@@ -159,30 +419,447 @@ TextureDataPtr TextureLoader::CopyTextureDataFromLoaded(const unsigned int textu
 //    return;
 }
 
+void TextureLoader::SetResidencyPolicy(const unsigned int textureID, const ResidencyPolicy residencyPolicy) {
+#ifdef _DEBUG
+    assert(textureID != 0);
+#endif
+    TextureInfo& textureInfo = loadedTextures[textureID];
+    if(residencyPolicy == RESIDENCY_KEEP_HOST_COPY) {
+        EnsureHostResident(textureID);
+    }
+    textureInfo.residencyPolicy = residencyPolicy;
+    if(residencyPolicy != RESIDENCY_KEEP_HOST_COPY && textureInfo.textureName != 0 && !streamingPolicy.hasTexture(textureID)) {
+        textureInfo.textureDataPtr.reset();
+    }
+}
+
+ResidencyPolicy TextureLoader::GetResidencyPolicy(const unsigned int textureID) {
+#ifdef _DEBUG
+    assert(textureID != 0);
+#endif
+    return loadedTextures[textureID].residencyPolicy;
+}
+
+bool TextureLoader::IsHostResident(const unsigned int textureID) {
+#ifdef _DEBUG
+    assert(textureID != 0);
+#endif
+    return loadedTextures[textureID].textureDataPtr.get() != nullptr;
+}
+
+unsigned int TextureLoader::GetWidth(const unsigned int textureID) {
+#ifdef _DEBUG
+    assert(textureID != 0);
+#endif
+    return loadedTextures[textureID].width;
+}
+
+unsigned int TextureLoader::GetHeight(const unsigned int textureID) {
+#ifdef _DEBUG
+    assert(textureID != 0);
+#endif
+    return loadedTextures[textureID].height;
+}
+
+MemoryStats TextureLoader::GetMemoryStats() {
+    MemoryStats memoryStats;
+    for(std::unordered_map<unsigned int, TextureInfo>::iterator iter = loadedTextures.begin(); iter != loadedTextures.end(); iter++) {
+        if(iter->second.textureDataPtr.get() != nullptr) {
+            memoryStats.hostBytes += iter->second.textureDataPtr->getSizeInBytesWithMipLevels();
+        }
+        memoryStats.deviceBytes += iter->second.deviceBytes;
+    }
+    return memoryStats;
+}
+
+void TextureLoader::SetStreamed(const unsigned int textureID, const bool streamed) {
+#ifdef _DEBUG
+    assert(textureID != 0);
+#endif
+    loadedTextures[textureID].streamed = streamed;
+}
+
+bool TextureLoader::IsStreamed(const unsigned int textureID) {
+#ifdef _DEBUG
+    assert(textureID != 0);
+#endif
+    return loadedTextures[textureID].streamed;
+}
+
+void TextureLoader::ReportTextureUsage(const unsigned int textureID, const float screenWidth, const float screenHeight) {
+#ifdef _DEBUG
+    assert(textureID != 0);
+#endif
+    if(!streamingPolicy.hasTexture(textureID)) {
+        return;
+    }
+    const TextureInfo& textureInfo = loadedTextures[textureID];
+    streamingPolicy.requestLevel(textureID, TextureStreamingPolicy::ComputeRequiredLevel(textureInfo.width, textureInfo.height, screenWidth, screenHeight),
+            FrameClock::GetFrameNumber());
+}
+
+void TextureLoader::UpdateTextureStreaming() {
+    std::vector<StreamingChange> changes = streamingPolicy.update(FrameClock::GetFrameNumber());
+    for(unsigned int i = 0; i < changes.size(); i++) {
+        ReallocateStreamedTexture(changes[i].textureID, changes[i].residentLevel);
+    }
+    
+    std::vector<unsigned int> pendingTextureIDs;
+    for(std::unordered_map<unsigned int, TextureInfo>::iterator iter = loadedTextures.begin(); iter != loadedTextures.end(); iter++) {
+        if(iter->second.textureName != 0 && iter->second.finestUploadedLevel > iter->second.firstStreamedLevel && streamingPolicy.hasTexture(iter->first)) {
+            pendingTextureIDs.push_back(iter->first);
+        }
+    }
+    size_t uploadedBytes = 0;
+    while(!pendingTextureIDs.empty()) {
+        // Coarsest missing level first, so every texture is raised in step
+        unsigned int next = 0;
+        for(unsigned int i = 1; i < pendingTextureIDs.size(); i++) {
+            unsigned int level = loadedTextures[pendingTextureIDs[i]].finestUploadedLevel;
+            unsigned int nextLevel = loadedTextures[pendingTextureIDs[next]].finestUploadedLevel;
+            if(level > nextLevel || (level == nextLevel && pendingTextureIDs[i] < pendingTextureIDs[next])) {
+                next = i;
+            }
+        }
+        unsigned int textureID = pendingTextureIDs[next];
+        TextureInfo& textureInfo = loadedTextures[textureID];
+        unsigned int level = textureInfo.finestUploadedLevel - 1;
+        size_t levelBytes = GetLevelSizeInBytes(*textureInfo.textureDataPtr, level);
+        if(streamingUploadBudget != 0 && uploadedBytes > 0 && uploadedBytes + levelBytes > streamingUploadBudget) {
+            break;
+        }
+        UploadStreamedLevel(textureID, level);
+        uploadedBytes += levelBytes;
+        if(textureInfo.finestUploadedLevel == textureInfo.firstStreamedLevel) {
+            pendingTextureIDs.erase(pendingTextureIDs.begin() + next);
+        }
+    }
+}
+
+unsigned int TextureLoader::GetFinestUploadedLevel(const unsigned int textureID) {
+#ifdef _DEBUG
+    assert(textureID != 0);
+#endif
+    return streamingPolicy.hasTexture(textureID) ? loadedTextures[textureID].finestUploadedLevel : 0;
+}
+
 void TextureLoader::BufferTextureData(const unsigned int textureID) {
 #ifdef _DEBUG
     assert(textureID != 0);
 #endif
+    EnsureHostResident(textureID);
+    if(loadedTextures[textureID].timesBuffered++ > 0) {
+        releaseQueue.recordThrashEvent();
+    }
     TextureInfo textureInfo = loadedTextures[textureID];
+    if(textureInfo.streamed && CanStream(*textureInfo.textureDataPtr)) {
+        BufferStreamedTexture(textureID);
+        return;
+    }
     glGenTextures(1, &loadedTextures[textureID].textureName);
-    glBindTexture(GL_TEXTURE_2D, loadedTextures[textureID].textureName);
-    // Add ability to change settings for texture???????????
-    //
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGB, textureInfo.textureDataPtr->getWidth(), textureInfo.textureDataPtr->getHeight(),
-            0, GL_RGB, GL_UNSIGNED_BYTE, textureInfo.textureDataPtr->getDataPtr().get());
-    glGenerateMipmap(GL_TEXTURE_2D);
-    glBindTexture(GL_TEXTURE_2D, 0);
+    TextureUnitState::BindToActiveUnit(loadedTextures[textureID].textureName);
+    // Wrapping and filtering come from the sampler bound alongside the texture (see BindTexture)
+    if(textureInfo.textureDataPtr->isCompressed()) {
+        // Compressed levels are uploaded whole, since there are no rows to stream
+        GLenum internalFormat = getGLCompressedFormat(textureInfo.compressedFormat);
+        const std::vector<SharedBuffer<unsigned char>>& mipLevels = textureInfo.textureDataPtr->getMipLevels();
+        size_t deviceBytes = 0;
+        for(unsigned int level = 0; level <= mipLevels.size(); level++) {
+            const SharedBuffer<unsigned char>& levelData = (level == 0) ? textureInfo.textureDataPtr->getData() : mipLevels[level - 1];
+            glCompressedTexImage2D(GL_TEXTURE_2D, level, internalFormat, MipmapGenerator::GetLevelSize(textureInfo.width, level),
+                    MipmapGenerator::GetLevelSize(textureInfo.height, level), 0, levelData.getSizeInBytes(), levelData.data());
+            deviceBytes += levelData.getSizeInBytes();
+        }
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, mipLevels.size());
+        TextureUnitState::BindToActiveUnit(0);
+        loadedTextures[textureID].numBufferedLevels = mipLevels.size() + 1;
+        loadedTextures[textureID].deviceBytes = deviceBytes;
+    }
+    else {
+        // Upload in the texture's own format, so no pixels are converted on the way
+        PixelFormat pixelFormat = textureInfo.textureDataPtr->getPixelFormat();
+        GLPixelFormat glPixelFormat = PixelConverter::GetGLPixelFormat(pixelFormat);
+        GLint swizzle[4];
+        if(PixelConverter::GetGLSwizzle(pixelFormat, swizzle)) {
+            glTexParameteriv(GL_TEXTURE_2D, GL_TEXTURE_SWIZZLE_RGBA, swizzle);
+        }
+        glTexImage2D(GL_TEXTURE_2D, 0, glPixelFormat.internalFormat, textureInfo.textureDataPtr->getWidth(), textureInfo.textureDataPtr->getHeight(),
+                0, glPixelFormat.format, glPixelFormat.type, nullptr);
+        unsigned int numLevels = MipmapGenerator::GetNumLevels(textureInfo.width, textureInfo.height);
+        UploadScheduler::UploadToTexture(loadedTextures[textureID].textureName, textureInfo.textureDataPtr->getWidth(),
+                textureInfo.textureDataPtr->getHeight(), pixelFormat, textureInfo.textureDataPtr->getData().data());
+        if(mipmapSettings.generateOnCPU && PixelConverter::Is8Bit(pixelFormat)) {
+            // Textures that weren't decoded from a file (or were read back from OpenGL) get their chain here
+            if(textureInfo.textureDataPtr->getMipLevels().empty()) {
+                textureInfo.textureDataPtr->generateMipLevels(mipmapSettings.filter, mipmapSettings.sRGB);
+            }
+            const std::vector<SharedBuffer<unsigned char>>& mipLevels = textureInfo.textureDataPtr->getMipLevels();
+            for(unsigned int level = 1; level <= mipLevels.size(); level++) {
+                unsigned int levelWidth = MipmapGenerator::GetLevelSize(textureInfo.width, level);
+                unsigned int levelHeight = MipmapGenerator::GetLevelSize(textureInfo.height, level);
+                TextureUnitState::BindToActiveUnit(loadedTextures[textureID].textureName);
+                glTexImage2D(GL_TEXTURE_2D, level, glPixelFormat.internalFormat, levelWidth, levelHeight, 0, glPixelFormat.format, glPixelFormat.type, nullptr);
+                UploadScheduler::UploadToTexture(loadedTextures[textureID].textureName, levelWidth, levelHeight, pixelFormat, mipLevels[level - 1].data(), level);
+            }
+            TextureUnitState::BindToActiveUnit(loadedTextures[textureID].textureName);
+            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, mipLevels.size());
+            numLevels = mipLevels.size() + 1;
+        }
+        else {
+            TextureUnitState::BindToActiveUnit(loadedTextures[textureID].textureName);
+            glGenerateMipmap(GL_TEXTURE_2D);
+        }
+        TextureUnitState::BindToActiveUnit(0);
+        
+        // Level 0 plus the mipmap chain, which pages of a texture atlas cut short
+        size_t deviceBytes = 0;
+        for(unsigned int level = 0; level < numLevels; level++) {
+            deviceBytes += (size_t)MipmapGenerator::GetLevelSize(textureInfo.width, level) * (size_t)MipmapGenerator::GetLevelSize(textureInfo.height, level)
+                    * PixelConverter::GetBytesPerPixel(pixelFormat);
+        }
+        loadedTextures[textureID].numBufferedLevels = numLevels;
+        loadedTextures[textureID].deviceBytes = deviceBytes;
+    }
+    
+    // The placeholder of a pending asynchronous load is kept so the texture can't be refetched from its file early
+    if(textureInfo.residencyPolicy != RESIDENCY_KEEP_HOST_COPY && textureInfo.asyncLoadTicket == 0) {
+        loadedTextures[textureID].textureDataPtr.reset();
+    }
 }
 
-void TextureLoader::UnBufferTextureData(const unsigned int textureID) {
+void TextureLoader::UnBufferTextureData(const unsigned int textureID, const bool keepHostCopy) {
 #ifdef _DEBUG
     assert(textureID != 0);
 #endif
+    if(keepHostCopy && loadedTextures[textureID].residencyPolicy == RESIDENCY_REFETCH_HOST_COPY) {
+        EnsureHostResident(textureID);
+    }
     glDeleteTextures(1, &loadedTextures[textureID].textureName);
+    TextureUnitState::ForgetTexture(loadedTextures[textureID].textureName);
+    streamingPolicy.removeTexture(textureID);
+    loadedTextures[textureID].textureName = 0;
+    loadedTextures[textureID].numBufferedLevels = 0;
+    loadedTextures[textureID].deviceBytes = 0;
+}
+
+void TextureLoader::EnsureHostResident(const unsigned int textureID) {
+    TextureInfo& textureInfo = loadedTextures[textureID];
+    if(textureInfo.textureDataPtr.get() != nullptr) {
+        return;
+    }
+    if(textureInfo.residencyPolicy == RESIDENCY_REFETCH_HOST_COPY && textureInfo.filePath != "") {
+        textureInfo.textureDataPtr = ReadTextureFile(textureInfo.filePath, mipmapSettings);
+        return;
+    }
+    if(textureInfo.residencyPolicy == RESIDENCY_DISCARD_HOST_COPY || textureInfo.textureName == 0) {
+        throw TextureException("ERROR: System memory copy of texture " + std::to_string(textureID) + " was discarded.");
+    }
+    
+    if(textureInfo.compressedFormat != COMPRESSED_FORMAT_NONE) {
+        // Read every level's blocks back from OpenGL
+        std::vector<SharedBuffer<unsigned char>> levels;
+        TextureUnitState::BindToActiveUnit(textureInfo.textureName);
+        for(unsigned int level = 0; level < textureInfo.numBufferedLevels; level++) {
+            std::vector<unsigned char> blocks(BlockCompressor::GetCompressedSize(MipmapGenerator::GetLevelSize(textureInfo.width, level),
+                    MipmapGenerator::GetLevelSize(textureInfo.height, level), textureInfo.compressedFormat));
+            glGetCompressedTexImage(GL_TEXTURE_2D, level, blocks.data());
+            levels.push_back(SharedBuffer<unsigned char>(std::move(blocks)));
+        }
+        TextureUnitState::BindToActiveUnit(0);
+        textureInfo.textureDataPtr = std::make_shared<TextureData>(textureInfo.width, textureInfo.height, textureInfo.compressedFormat, levels[0],
+                std::vector<SharedBuffer<unsigned char>>(levels.begin() + 1, levels.end()));
+        return;
+    }
+    
+    // Read level 0 back from OpenGL in the format it was uploaded in
+    GLPixelFormat glPixelFormat = PixelConverter::GetGLPixelFormat(textureInfo.pixelFormat);
+    std::vector<unsigned char> data((size_t)textureInfo.width * (size_t)textureInfo.height * PixelConverter::GetBytesPerPixel(textureInfo.pixelFormat));
+    TextureUnitState::BindToActiveUnit(textureInfo.textureName);
+    glPixelStorei(GL_PACK_ALIGNMENT, 1);
+    glGetTexImage(GL_TEXTURE_2D, 0, glPixelFormat.format, glPixelFormat.type, data.data());
+    glPixelStorei(GL_PACK_ALIGNMENT, 4);
+    TextureUnitState::BindToActiveUnit(0);
+    textureInfo.textureDataPtr = std::make_shared<TextureData>(textureInfo.width, textureInfo.height, textureInfo.pixelFormat,
+            SharedBuffer<unsigned char>(std::move(data)));
+}
+
+TextureDataPtr TextureLoader::ReadTextureFile(const std::string& filePath, const MipmapSettings& mipmapSettings) {
+    TextureSourceInfo sourceInfo;
+    if(TextureCache::IsEnabled()) {
+        TextureDataPtr cachedDataPtr = TextureCache::Load(filePath, mipmapSettings.getCacheKey());
+        if(cachedDataPtr.get() != nullptr) {
+            return cachedDataPtr;
+        }
+        sourceInfo = TextureCache::GetSourceInfo(filePath, mipmapSettings.getCacheKey(), true);
+    }
+    int width = 0;
+    int height = 0;
+    int imgNumChannels = 0;
+    std::shared_ptr<unsigned char[]> dataPtr = std::shared_ptr<unsigned char[]>(stbi_load(filePath.c_str(), &width, &height, &imgNumChannels, 0), stbi_image_free);
+    if(!dataPtr.get()) {
+        throw Engine::FileIOException("ERROR: Failed to load image data from \"" + filePath + "\"");
+    }
+    // Flip rows here rather than with stbi_set_flip_vertically_on_load, which sets global state shared by the worker
+    // threads decoding asynchronous loads
+    size_t rowSize = (size_t)width * (size_t)imgNumChannels;
+    std::vector<unsigned char> rowData(rowSize);
+    for(int row = 0; row < height / 2; row++) {
+        unsigned char* topRow = dataPtr.get() + (size_t)row * rowSize;
+        unsigned char* bottomRow = dataPtr.get() + (size_t)(height - 1 - row) * rowSize;
+        std::memcpy(rowData.data(), topRow, rowSize);
+        std::memcpy(topRow, bottomRow, rowSize);
+        std::memcpy(bottomRow, rowData.data(), rowSize);
+    }
+    // Adopt the decoded pixels without copying them. Grey images stay grey, and are read as RGB through the swizzle
+    PixelFormat pixelFormats[] = {PIXEL_FORMAT_L8, PIXEL_FORMAT_LA8, PIXEL_FORMAT_RGB8, PIXEL_FORMAT_RGBA8};
+    SharedBuffer<unsigned char> data = SharedBuffer<unsigned char>(dataPtr, (size_t)width * (size_t)height * (size_t)imgNumChannels);
+    TextureDataPtr textureDataPtr = std::make_shared<TextureData>((unsigned int)width, (unsigned int)height, pixelFormats[imgNumChannels - 1], data);
+    if(mipmapSettings.generateOnCPU) {
+        textureDataPtr->generateMipLevels(mipmapSettings.filter, mipmapSettings.sRGB);
+    }
+    if(TextureCache::IsEnabled()) {
+        TextureCache::Store(filePath, sourceInfo, textureDataPtr);
+    }
+    return textureDataPtr;
+}
+
+void TextureLoader::CompleteAsyncLoad(const unsigned int textureID, const unsigned long long asyncLoadTicket, const TextureDataPtr textureDataPtr) {
+    std::unordered_map<unsigned int, TextureInfo>::iterator iter = loadedTextures.find(textureID);
+    if(iter == loadedTextures.end() || iter->second.asyncLoadTicket != asyncLoadTicket) {
+        // The texture was unloaded while decoding, and its index may since have been reused
+        return;
+    }
+    TextureInfo& textureInfo = iter->second;
+    textureInfo.asyncLoadTicket = 0;
+    if(textureDataPtr.get() == nullptr) {
+        textureInfo.asyncLoadFailed = true;
+        return;
+    }
+    textureInfo.textureDataPtr = textureDataPtr;
+    textureInfo.width = textureDataPtr->getWidth();
+    textureInfo.height = textureDataPtr->getHeight();
+    textureInfo.pixelFormat = textureDataPtr->getPixelFormat();
+    textureInfo.compressedFormat = textureDataPtr->getCompressedFormat();
+    if(textureInfo.textureName == 0) {
+        return;
+    }
+    
+    // Swap the buffered placeholder for the decoded image
+    if(textureInfo.usingCount > 0) {
+        glDeleteTextures(1, &textureInfo.textureName);
+        TextureUnitState::ForgetTexture(textureInfo.textureName);
+        textureInfo.textureName = 0;
+        textureInfo.deviceBytes = 0;
+        // Buffering the placeholder doesn't count towards thrashing
+        textureInfo.timesBuffered = 0;
+        BufferTextureData(textureID);
+    }
+    else {
+        releaseQueue.remove(textureID);
+        UnBufferTextureData(textureID, true);
+    }
+}
+
+bool TextureLoader::CanStream(const TextureData& textureData) {
+    unsigned int numLevels = MipmapGenerator::GetNumLevels(textureData.getWidth(), textureData.getHeight());
+    if(textureData.getMipLevels().size() + 1 == numLevels) {
+        return true;
+    }
+    // A partial chain, such as an atlas page's, can't stream the levels it lacks
+    return textureData.getMipLevels().empty() && !textureData.isCompressed() && PixelConverter::Is8Bit(textureData.getPixelFormat());
+}
+
+void TextureLoader::BufferStreamedTexture(const unsigned int textureID) {
+    TextureInfo& textureInfo = loadedTextures[textureID];
+    TextureDataPtr textureDataPtr = textureInfo.textureDataPtr;
+    if(textureDataPtr->getMipLevels().empty()) {
+        textureDataPtr->generateMipLevels(mipmapSettings.filter, mipmapSettings.sRGB);
+    }
+    unsigned int numLevels = MipmapGenerator::GetNumLevels(textureInfo.width, textureInfo.height);
+    std::vector<size_t> levelBytes(numLevels);
+    for(unsigned int level = 0; level < numLevels; level++) {
+        levelBytes[level] = GetLevelSizeInBytes(*textureDataPtr, level);
+    }
+    unsigned int tailLevel = TextureStreamingPolicy::ComputeTailLevel(textureInfo.width, textureInfo.height, STREAMING_TAIL_SIZE);
+    streamingPolicy.addTexture(textureID, levelBytes, tailLevel);
+    ReallocateStreamedTexture(textureID, tailLevel);
+    // The tail is uploaded straight away so the texture can be drawn this frame
+    for(unsigned int level = numLevels; level > tailLevel; level--) {
+        UploadStreamedLevel(textureID, level - 1);
+    }
+}
+
+void TextureLoader::ReallocateStreamedTexture(const unsigned int textureID, const unsigned int firstLevel) {
+    TextureInfo& textureInfo = loadedTextures[textureID];
+    unsigned int numLevels = MipmapGenerator::GetNumLevels(textureInfo.width, textureInfo.height);
+    GLenum internalFormat = textureInfo.textureDataPtr->isCompressed() ? getGLCompressedFormat(textureInfo.compressedFormat)
+            : PixelConverter::GetGLPixelFormat(textureInfo.pixelFormat).internalFormat;
+    GLuint textureName = 0;
+    glGenTextures(1, &textureName);
+    TextureUnitState::BindToActiveUnit(textureName);
+    GLint swizzle[4];
+    if(PixelConverter::GetGLSwizzle(textureInfo.pixelFormat, swizzle)) {
+        glTexParameteriv(GL_TEXTURE_2D, GL_TEXTURE_SWIZZLE_RGBA, swizzle);
+    }
+    // Level 0 of the storage is level firstLevel of the texture, so texture coordinates are unaffected
+    glTexStorage2D(GL_TEXTURE_2D, numLevels - firstLevel, internalFormat, MipmapGenerator::GetLevelSize(textureInfo.width, firstLevel),
+            MipmapGenerator::GetLevelSize(textureInfo.height, firstLevel));
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, numLevels - firstLevel - 1);
+    
+    unsigned int finestUploadedLevel = numLevels;
+    if(textureInfo.textureName != 0) {
+        // Levels that stay resident are copied on the GPU rather than uploaded again
+        finestUploadedLevel = std::max(textureInfo.finestUploadedLevel, firstLevel);
+        for(unsigned int level = finestUploadedLevel; level < numLevels; level++) {
+            glCopyImageSubData(textureInfo.textureName, GL_TEXTURE_2D, level - textureInfo.firstStreamedLevel, 0, 0, 0, textureName, GL_TEXTURE_2D,
+                    level - firstLevel, 0, 0, 0, MipmapGenerator::GetLevelSize(textureInfo.width, level), MipmapGenerator::GetLevelSize(textureInfo.height, level), 1);
+        }
+        glDeleteTextures(1, &textureInfo.textureName);
+        TextureUnitState::ForgetTexture(textureInfo.textureName);
+    }
+    if(finestUploadedLevel < numLevels) {
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_BASE_LEVEL, finestUploadedLevel - firstLevel);
+    }
+    TextureUnitState::BindToActiveUnit(0);
+    textureInfo.textureName = textureName;
+    textureInfo.firstStreamedLevel = firstLevel;
+    textureInfo.finestUploadedLevel = finestUploadedLevel;
+    textureInfo.numBufferedLevels = numLevels - firstLevel;
+    textureInfo.deviceBytes = streamingPolicy.getResidentBytes(textureID);
+}
+
+void TextureLoader::UploadStreamedLevel(const unsigned int textureID, const unsigned int level) {
+    TextureInfo& textureInfo = loadedTextures[textureID];
+#ifdef _DEBUG
+    assert(level >= textureInfo.firstStreamedLevel && level < textureInfo.finestUploadedLevel);
+#endif
+    const TextureData& textureData = *textureInfo.textureDataPtr;
+    const SharedBuffer<unsigned char>& levelData = (level == 0) ? textureData.getData() : textureData.getMipLevels()[level - 1];
+    unsigned int levelWidth = MipmapGenerator::GetLevelSize(textureInfo.width, level);
+    unsigned int levelHeight = MipmapGenerator::GetLevelSize(textureInfo.height, level);
+    GLint storageLevel = level - textureInfo.firstStreamedLevel;
+    if(textureData.isCompressed()) {
+        TextureUnitState::BindToActiveUnit(textureInfo.textureName);
+        glCompressedTexSubImage2D(GL_TEXTURE_2D, storageLevel, 0, 0, levelWidth, levelHeight, getGLCompressedFormat(textureInfo.compressedFormat),
+                levelData.getSizeInBytes(), levelData.data());
+    }
+    else {
+        UploadScheduler::UploadToTexture(textureInfo.textureName, levelWidth, levelHeight, textureInfo.pixelFormat, levelData.data(), storageLevel);
+        TextureUnitState::BindToActiveUnit(textureInfo.textureName);
+    }
+    // Sampling stays clamped to the levels uploaded so far
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_BASE_LEVEL, storageLevel);
+    TextureUnitState::BindToActiveUnit(0);
+    textureInfo.finestUploadedLevel = level;
+}
+
+size_t TextureLoader::GetLevelSizeInBytes(const TextureData& textureData, const unsigned int level) {
+    unsigned int levelWidth = MipmapGenerator::GetLevelSize(textureData.getWidth(), level);
+    unsigned int levelHeight = MipmapGenerator::GetLevelSize(textureData.getHeight(), level);
+    if(textureData.isCompressed()) {
+        return BlockCompressor::GetCompressedSize(levelWidth, levelHeight, textureData.getCompressedFormat());
+    }
+    return (size_t)levelWidth * (size_t)levelHeight * PixelConverter::GetBytesPerPixel(textureData.getPixelFormat());
 }
 
 void TextureLoader::UnloadTexture(const unsigned int textureID) {
@@ -190,8 +867,14 @@ void TextureLoader::UnloadTexture(const unsigned int textureID) {
     assert(textureID != 0);
     assert(loadedTextures[textureID].usingCount == 0);
 #endif
+    if(releaseQueue.remove(textureID)) {
+        UnBufferTextureData(textureID, false);
+    }
     for(std::unordered_map<unsigned int, TextureInfo>::iterator iter = loadedTextures.begin(); iter != loadedTextures.end(); iter++) {
         if(iter->first == textureID) {
+            if(iter->second.filePath != "") {
+                pathIndex.erase(iter->second.filePath, textureID);
+            }
             availableIDStack.push(iter->first);
             loadedTextures.erase(iter);
             break;
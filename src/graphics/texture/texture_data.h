@@ -3,6 +3,19 @@
 
 #include <exceptions/io_exception.h>
 #include <fileio/image_reader.h>
+#include <fileio/path_index.h>
+#include <fileio/async_loader.h>
+#include <graphics/buffer/shared_buffer.h>
+#include <graphics/buffer/residency.h>
+#include <graphics/buffer/deferred_release_queue.h>
+#include <graphics/buffer/upload_scheduler.h>
+#include <graphics/texture/mipmap_generator.h>
+#include <graphics/texture/block_compressor.h>
+#include <graphics/texture/pixel_format.h>
+#include <graphics/texture/texture_streaming.h>
+#include <graphics/texture/sampler_cache.h>
+#include <graphics/texture/texture_units.h>
+#include <exceptions/render_exception.h>
 #include <cassert>
 #include <vector>
 #include <string>
@@ -16,30 +29,87 @@
 namespace Engine {
 
 /*
- * TextureData contains the pixel data for a texture in system memory.
+ * TextureData contains the pixel data for a texture in system memory, either as 8-bit pixels or as compressed blocks.
  */
 class TextureData {
     public:
         /*
-         * Shallow copies dataPtr to TextureData.
+         * Shares data with the new TextureData, whose pixel format stores numChannels 8-bit channels as is.
          */
-        TextureData(const unsigned int width, const unsigned int height, const unsigned int numChannels, const std::shared_ptr<unsigned char[]> dataPtr);
+        TextureData(const unsigned int width, const unsigned int height, const unsigned int numChannels, const SharedBuffer<unsigned char> data);
         
         /*
-         * Deep copies data from other textureData
+         * Shares data, holding pixels in pixelFormat, with the new TextureData.
          */
-        TextureData(const TextureData& textureData);
+        TextureData(const unsigned int width, const unsigned int height, const PixelFormat pixelFormat, const SharedBuffer<unsigned char> data);
+        
+        /*
+         * Shares the compressed blocks of level 0 in data and of levels 1 and up in mipLevels with the new TextureData.
+         */
+        TextureData(const unsigned int width, const unsigned int height, const CompressedFormat compressedFormat, const SharedBuffer<unsigned char> data,
+                const std::vector<SharedBuffer<unsigned char>>& mipLevels = std::vector<SharedBuffer<unsigned char>>());
+        
+        /*
+         * Shares the pixel data of other textureData. The pixel data is only copied when one of the textures mutates it.
+         */
+        TextureData(const TextureData& textureData) = default;
         
         unsigned int getWidth() const { return width; }
         void setWidth(const unsigned int width) { this->width = width; }
         unsigned int getHeight() const { return height; }
         void setHeight(const unsigned int height) { this->height = height; }
         unsigned int getNumChannels() const { return numChannels; }
-        void setNumChannels(const unsigned int numChannels) { this->numChannels = numChannels; }
+        void setNumChannels(const unsigned int numChannels) { this->numChannels = numChannels; pixelFormat = PixelConverter::GetPixelFormat(numChannels); }
+        
+        /*
+         * Returns the layout of the pixel data. Compressed textures return the 8-bit format of the channels they store.
+         */
+        PixelFormat getPixelFormat() const { return pixelFormat; }
         unsigned int getSize() const { return size; }
         void setSize(const unsigned int size) { this->size = size; }
-        std::shared_ptr<unsigned char[]> getDataPtr() const { return dataPtr; };
-        void setDataPtr(const std::shared_ptr<unsigned char[]> dataPtr) { this->dataPtr = dataPtr; };
+        const SharedBuffer<unsigned char>& getData() const { return data; }
+        void setData(const SharedBuffer<unsigned char> data) { this->data = data; }
+        
+        /*
+         * Returns a writable pointer to the pixel data, copying it first if it is shared. Drops the mipmap levels, which
+         * would no longer match the pixel data once it is written.
+         */
+        unsigned char* mutableData() { mipLevels.clear(); return data.mutableData(); }
+        
+        /*
+         * Returns mipmap levels 1 and up, or an empty list if none have been generated. Compressed textures hold
+         * compressed blocks for every level.
+         */
+        const std::vector<SharedBuffer<unsigned char>>& getMipLevels() const { return mipLevels; }
+        void setMipLevels(const std::vector<SharedBuffer<unsigned char>>& mipLevels) { this->mipLevels = mipLevels; }
+        
+        /*
+         * Generates the full mipmap chain from the pixel data with MipmapGenerator. The texture must hold 8-bit pixels
+         * and must not be compressed.
+         */
+        void generateMipLevels(const MipmapFilter filter, const bool sRGB);
+        
+        /*
+         * Converts the pixel data and each mipmap level to pixelFormat with PixelConverter. The texture must not be
+         * compressed.
+         */
+        void convert(const PixelFormat pixelFormat);
+        
+        CompressedFormat getCompressedFormat() const { return compressedFormat; }
+        bool isCompressed() const { return compressedFormat != COMPRESSED_FORMAT_NONE; }
+        
+        /*
+         * Replaces the pixel data and each mipmap level with its compressed blocks, and the number of channels with
+         * the number the format stores. Pixel formats the compressor doesn't read directly are converted to RGBA8
+         * first. Generate the mipmap levels first to have them compressed too. Compression runs on the AsyncLoader
+         * worker threads, so it must not be called from a worker task.
+         */
+        void compress(const CompressedFormat compressedFormat, const CompressionQuality quality);
+        
+        /*
+         * Returns the bytes of the pixel data plus its mipmap levels.
+         */
+        size_t getSizeInBytesWithMipLevels() const;
         
         /*std::string getFormat() { return format; }
         void setFormat(const std::string& format) { this->format = format; }*/
@@ -47,14 +117,33 @@ class TextureData {
         unsigned int width;
         unsigned int height;
         unsigned int numChannels;
-        const unsigned short bytesPerChannel = 1;
+        PixelFormat pixelFormat;
         unsigned int size;
-        std::shared_ptr<unsigned char[]> dataPtr;
+        SharedBuffer<unsigned char> data;
+        std::vector<SharedBuffer<unsigned char>> mipLevels;
+        CompressedFormat compressedFormat = COMPRESSED_FORMAT_NONE;
         /*std::string format;
         std::string type;*/
 };
 typedef std::shared_ptr<TextureData> TextureDataPtr;
 
+/*
+ * How TextureLoader builds mipmap chains.
+ */
+struct MipmapSettings {
+    // Generate the chain with MipmapGenerator when the image is decoded and upload it level by level, rather than
+    // calling glGenerateMipmap after uploading level 0
+    bool generateOnCPU = true;
+    MipmapFilter filter = MIPMAP_FILTER_BOX;
+    // Filter color channels in linear space, for images with sRGB encoded colors
+    bool sRGB = true;
+    
+    /*
+     * Returns a key identifying these settings, so TextureCache only reuses mipmap chains built with them.
+     */
+    unsigned int getCacheKey() const { return (generateOnCPU ? 1 : 0) | (sRGB ? 2 : 0) | ((unsigned int)filter << 2); }
+};
+
 /*
  * TextureLoader handles loading textures from file system or from texture data into system memory and buffering textures
  * into OpenGL. TextureLoader maintains a list of all loaded textures.
@@ -66,6 +155,14 @@ class TextureLoader {
          */
         static void PreLoadTextures(const std::vector<std::string>& textureFilePaths);
         
+        /*
+         * Loads textures from list of file paths into system memory, decoding them and generating their mipmap chains on
+         * AsyncLoader worker threads. Returns the index of each texture from list of loaded textures, in the order of
+         * textureFilePaths. Textures that are already loaded are not decoded again. Throws FileIOException after all
+         * decodes have finished if any of the files can't be decoded, with the textures that could be loaded kept.
+         */
+        static std::vector<unsigned int> LoadTexturesFromFiles(const std::vector<std::string>& textureFilePaths);
+        
         /*
          * Unloads all loaded textures with usage count less than 1 from system memory.
          */
@@ -77,9 +174,34 @@ class TextureLoader {
         static TextureDataPtr GetTextureDataPtr(const unsigned int textureID);
         
         /*
-         * Binds texture about to be rendered.
+         * Binds texture about to be rendered to texture unit unit, along with the sampler for its sampler description.
+         */
+        static void BindTexture(const unsigned int textureID, const unsigned int unit = 0);
+        
+        /*
+         * Binds texture about to be rendered to texture unit unit, sampled as samplerDescription describes instead of
+         * as its own sampler description does.
+         */
+        static void BindTexture(const unsigned int textureID, const unsigned int unit, const SamplerDescription& samplerDescription);
+        
+        /*
+         * Binds texture about to be rendered to texture unit unit along with sampler, a sampler object from
+         * SamplerCache looked up ahead of time.
+         */
+        static void BindTexture(const unsigned int textureID, const unsigned int unit, const GLuint sampler);
+        
+        /*
+         * Sets how texture with index textureID is sampled when bound with its own sampler description. Takes effect
+         * the next time it is bound, without uploading it again.
+         */
+        static void SetSamplerDescription(const unsigned int textureID, const SamplerDescription& samplerDescription);
+        static const SamplerDescription& GetSamplerDescription(const unsigned int textureID);
+        
+        /*
+         * Sets the sampler description given to textures loaded from now on. Defaults to clamping to the edge with
+         * trilinear filtering.
          */
-        static void BindTexture(const unsigned int textureID);
+        static void SetDefaultSamplerDescription(const SamplerDescription& samplerDescription) { defaultSamplerDescription = samplerDescription; }
         
         /*
          * Loads texture from file system into system memory. Returns the index of texture from list of loaded textures.
@@ -89,8 +211,23 @@ class TextureLoader {
         static unsigned int LoadTextureFromFile(const std::string filePath);
         
         /*
-         * Deep copies texture data given by TextureDataPtr into list of loaded textures. Returns the index of the texture
-         * from list of loaded textures.
+         * Starts decoding the texture at filePath on an AsyncLoader worker thread and returns the index of the texture
+         * from list of loaded textures straight away. Until AsyncLoader::ProcessMainThreadTasks swaps the decoded image
+         * in, the texture holds a 1x1 grey placeholder that can be used and buffered like any other texture. If the
+         * texture is already loaded (or loading), then the loaded instance will be used. If decoding fails the
+         * placeholder is kept and HasAsyncLoadFailed returns true.
+         */
+        static unsigned int LoadTextureFromFileAsync(const std::string filePath);
+        
+        /*
+         * Returns true if texture with index textureID is still waiting for its image to be decoded.
+         */
+        static bool IsAsyncLoadPending(const unsigned int textureID);
+        static bool HasAsyncLoadFailed(const unsigned int textureID);
+        
+        /*
+         * Puts texture data given by TextureDataPtr into list of loaded textures, sharing its pixel data rather than
+         * copying it. Returns the index of the texture from list of loaded textures.
          */
         static unsigned int LoadTextureFromTextureData(const TextureDataPtr textureDataPtr);
         
@@ -106,14 +243,103 @@ class TextureLoader {
         static void UseLoadedTexture(const unsigned int textureID);
         
         /*
-         * Decrements using count for texture with index textureID from list of loaded textures.
+         * Decrements using count for texture with index textureID from list of loaded textures. A texture that is no
+         * longer used stays buffered until it is reclaimed by ProcessDeferredReleases, so using it again in the
+         * meantime is free.
          */
         static void ReleaseLoadedTexture(const unsigned int textureID);
         
         /*
-         * Returns a deep copy of the loaded texture data with index textureID from list of loaded textures.
+         * Unbuffers the released textures that have gone unused for the release delay, or all released textures if
+         * reclaimAll is true. Released textures without a file path are also unloaded. Call once per frame.
+         */
+        static void ProcessDeferredReleases(const bool reclaimAll = false);
+        
+        static DeferredReleaseQueue& GetReleaseQueue() { return releaseQueue; }
+        
+        /*
+         * Returns a copy of the loaded texture data with index textureID from list of loaded textures. The copy shares
+         * its pixel data with the loaded texture until either is mutated.
          */
         static TextureDataPtr CopyTextureDataFromLoaded(const unsigned int textureID);
+        
+        /*
+         * Returns the index used to find already loaded textures by file path, for reading hit/miss counts.
+         */
+        static const PathIndex& GetPathIndex() { return pathIndex; }
+        
+        /*
+         * Sets the residency policy given to textures loaded from now on.
+         */
+        static void SetDefaultResidencyPolicy(const ResidencyPolicy residencyPolicy) { defaultResidencyPolicy = residencyPolicy; }
+        
+        /*
+         * Sets the residency policy of loaded texture with index textureID. Takes effect the next time the texture is
+         * buffered, or immediately if it is already buffered.
+         */
+        static void SetResidencyPolicy(const unsigned int textureID, const ResidencyPolicy residencyPolicy);
+        static ResidencyPolicy GetResidencyPolicy(const unsigned int textureID);
+        
+        /*
+         * Returns true if the system memory copy of texture with index textureID is currently held.
+         */
+        static bool IsHostResident(const unsigned int textureID);
+        
+        /*
+         * Sets whether textures loaded from now on are streamed (see SetStreamed).
+         */
+        static void SetDefaultStreamed(const bool streamed) { defaultStreamed = streamed; }
+        
+        /*
+         * Sets whether texture with index textureID is streamed. A streamed texture is buffered with only its coarse
+         * mipmap levels in immutable storage, and finer levels are added as ReportTextureUsage asks for them and
+         * dropped again when the streaming budget runs short (see TextureStreamingPolicy). Textures without a full
+         * mipmap chain in system memory that can't generate one are buffered whole. Streamed textures keep their
+         * system memory copy whatever their residency policy, since finer levels are uploaded from it. Takes effect
+         * the next time the texture is buffered.
+         */
+        static void SetStreamed(const unsigned int textureID, const bool streamed);
+        static bool IsStreamed(const unsigned int textureID);
+        
+        /*
+         * Records that texture with index textureID is drawn this frame covering about screenWidth by screenHeight
+         * pixels, so a streamed texture gets the levels it needs at that size. Ignored for textures that aren't
+         * buffered as streamed.
+         */
+        static void ReportTextureUsage(const unsigned int textureID, const float screenWidth, const float screenHeight);
+        
+        /*
+         * Applies the streaming policy's decisions for this frame, giving streamed textures new storage where their
+         * resident levels changed, and uploads the levels still missing, coarsest first, up to the streaming upload
+         * budget. Until a level is uploaded GL_TEXTURE_BASE_LEVEL keeps sampling on the levels that are. Call once per
+         * frame before drawing.
+         */
+        static void UpdateTextureStreaming();
+        
+        static TextureStreamingPolicy& GetStreamingPolicy() { return streamingPolicy; }
+        
+        /*
+         * Sets the most bytes of streamed levels UpdateTextureStreaming uploads per call. At least one level is
+         * uploaded per call. 0 means no limit.
+         */
+        static void SetStreamingUploadBudget(const size_t streamingUploadBudget) { TextureLoader::streamingUploadBudget = streamingUploadBudget; }
+        
+        /*
+         * Returns the finest mipmap level of texture with index textureID that can be sampled, i.e. the finest level
+         * uploaded for a streamed texture and 0 for any other buffered texture.
+         */
+        static unsigned int GetFinestUploadedLevel(const unsigned int textureID);
+        
+        static void SetMipmapSettings(const MipmapSettings& mipmapSettings) { TextureLoader::mipmapSettings = mipmapSettings; }
+        static const MipmapSettings& GetMipmapSettings() { return mipmapSettings; }
+        
+        static unsigned int GetWidth(const unsigned int textureID);
+        static unsigned int GetHeight(const unsigned int textureID);
+        
+        /*
+         * Returns the bytes held by all loaded textures in system memory and in OpenGL textures (including mipmaps).
+         */
+        static MemoryStats GetMemoryStats();
     private:
         /*
          * Buffers texture data to GPU from loaded texture list with index textureID.
@@ -121,25 +347,107 @@ class TextureLoader {
         static void BufferTextureData(const unsigned int textureID);
         
         /*
-         * Deletes OpenGL buffer of texture with index textureID from loaded texture list.
+         * Deletes OpenGL buffer of texture with index textureID from loaded texture list. The system memory copy is
+         * refetched first if the residency policy asks for it and keepHostCopy is set; pass false when the texture is
+         * about to be unloaded.
          */
-        static void UnBufferTextureData(const unsigned int textureID);
+        static void UnBufferTextureData(const unsigned int textureID, const bool keepHostCopy);
         
         /*
          * Unloads loaded texture from system memory. Removes the texture from list of loaded textures.
          */
         static void UnloadTexture(const unsigned int textureID);
         
+        /*
+         * Makes sure the system memory copy of texture with index textureID is held, reloading it from its file or
+         * reading it back from OpenGL if it was dropped. Throws TextureException if the copy was discarded and can't be
+         * fetched.
+         */
+        static void EnsureHostResident(const unsigned int textureID);
+        
+        /*
+         * Decodes the image file at filePath into new texture data, with its mipmap chain if mipmapSettings asks for it.
+         * Safe to call from worker threads.
+         */
+        static TextureDataPtr ReadTextureFile(const std::string& filePath, const MipmapSettings& mipmapSettings);
+        
+        /*
+         * Puts texture data decoded from filePath into list of loaded textures. Returns the index of the texture.
+         */
+        static unsigned int AddLoadedTexture(const std::string& filePath, const TextureDataPtr textureDataPtr);
+        
+        /*
+         * Replaces the placeholder of texture with index textureID with its decoded image, re-buffering it if it is
+         * buffered. Ignored if the texture was unloaded since the load with asyncLoadTicket was started. A null
+         * textureDataPtr marks the load as failed.
+         */
+        static void CompleteAsyncLoad(const unsigned int textureID, const unsigned long long asyncLoadTicket, const TextureDataPtr textureDataPtr);
+        
+        /*
+         * Returns true if textureData holds, or can generate, every mipmap level a streamed texture uploads.
+         */
+        static bool CanStream(const TextureData& textureData);
+        
+        /*
+         * Buffers texture with index textureID as streamed, uploading the levels the streaming policy always keeps
+         * resident.
+         */
+        static void BufferStreamedTexture(const unsigned int textureID);
+        
+        /*
+         * Replaces the storage of streamed texture with index textureID with immutable storage for levels firstLevel
+         * and up, copying the levels already uploaded that it keeps on the GPU.
+         */
+        static void ReallocateStreamedTexture(const unsigned int textureID, const unsigned int firstLevel);
+        
+        /*
+         * Uploads mipmap level level of streamed texture with index textureID from its system memory copy and lowers
+         * GL_TEXTURE_BASE_LEVEL to it.
+         */
+        static void UploadStreamedLevel(const unsigned int textureID, const unsigned int level);
+        
+        static size_t GetLevelSizeInBytes(const TextureData& textureData, const unsigned int level);
+        
         struct TextureInfo {
             std::string filePath;
             TextureDataPtr textureDataPtr;
             unsigned int textureName = 0;
             unsigned int usingCount = 0;
+            ResidencyPolicy residencyPolicy = RESIDENCY_KEEP_HOST_COPY;
+            unsigned int width = 0;
+            unsigned int height = 0;
+            PixelFormat pixelFormat = PIXEL_FORMAT_RGB8;
+            CompressedFormat compressedFormat = COMPRESSED_FORMAT_NONE;
+            // Levels given storage in OpenGL, including level 0
+            unsigned int numBufferedLevels = 0;
+            size_t deviceBytes = 0;
+            unsigned int timesBuffered = 0;
+            // Nonzero while an asynchronous load is decoding the texture's image
+            unsigned long long asyncLoadTicket = 0;
+            bool asyncLoadFailed = false;
+            bool streamed = false;
+            // Level the storage of a buffered streamed texture starts at, and the finest level uploaded to it
+            unsigned int firstStreamedLevel = 0;
+            unsigned int finestUploadedLevel = 0;
+            SamplerDescription samplerDescription;
         };
         // CHANGE TO SINGLETON PATTERN TO ALLOW RESEARTING OF ENGINE!!!!!!!!!!!!
         static unsigned int spareID;
         static std::stack<unsigned int> availableIDStack;
         static std::unordered_map<unsigned int, TextureInfo> loadedTextures;
+        static PathIndex pathIndex;
+        static ResidencyPolicy defaultResidencyPolicy;
+        static DeferredReleaseQueue releaseQueue;
+        static unsigned long long spareAsyncLoadTicket;
+        static SharedBuffer<unsigned char> placeholderPixels;
+        static MipmapSettings mipmapSettings;
+        static bool defaultStreamed;
+        static SamplerDescription defaultSamplerDescription;
+        static TextureStreamingPolicy streamingPolicy;
+        static size_t streamingUploadBudget;
+        
+        // Streamed textures keep the levels up to this size along both axes resident at all times
+        static constexpr unsigned int STREAMING_TAIL_SIZE = 64;
 };
 
 }
@@ -0,0 +1,268 @@
+#include "texture_streaming.h"
+#include <graphics/texture/mipmap_generator.h>
+#include <algorithm>
+#include <cmath>
+#include <cassert>
+
+namespace Engine {
+
+/*
+ * Class TextureStreamingPolicy
+ */
+void TextureStreamingPolicy::addTexture(const unsigned int textureID, const std::vector<size_t>& levelBytes, const unsigned int minResidentLevel) {
+#ifdef _DEBUG
+    assert(textureID != 0);
+    assert(minResidentLevel < levelBytes.size());
+#endif
+    removeTexture(textureID);
+    StreamedTexture texture;
+    texture.levelBytes = levelBytes;
+    texture.minResidentLevel = minResidentLevel;
+    texture.residentLevel = minResidentLevel;
+    texture.requestedLevel = minResidentLevel;
+    for(unsigned int level = minResidentLevel; level < levelBytes.size(); level++) {
+        texture.residentBytes += levelBytes[level];
+    }
+    totalResidentBytes += texture.residentBytes;
+    textures[textureID] = texture;
+}
+
+void TextureStreamingPolicy::removeTexture(const unsigned int textureID) {
+    std::unordered_map<unsigned int, StreamedTexture>::iterator iter = textures.find(textureID);
+    if(iter == textures.end()) {
+        return;
+    }
+    totalResidentBytes -= iter->second.residentBytes;
+    textures.erase(iter);
+}
+
+void TextureStreamingPolicy::requestLevel(const unsigned int textureID, const unsigned int level, const unsigned long long frameNumber) {
+#ifdef _DEBUG
+    assert(textures.count(textureID) > 0);
+#endif
+    StreamedTexture& texture = textures[textureID];
+    unsigned int clampedLevel = std::min(level, texture.minResidentLevel);
+    if(texture.used && texture.lastUsedFrame == frameNumber) {
+        texture.requestedLevel = std::min(texture.requestedLevel, clampedLevel);
+    }
+    else {
+        texture.requestedLevel = clampedLevel;
+    }
+    texture.lastUsedFrame = frameNumber;
+    texture.used = true;
+}
+
+std::vector<StreamingChange> TextureStreamingPolicy::update(const unsigned long long frameNumber) {
+    // Resident level of each texture touched, from before the update
+    std::unordered_map<unsigned int, unsigned int> previousLevels;
+    
+    // Get back under the budget, e.g. after it was lowered
+    while(budget != 0 && totalResidentBytes > budget) {
+        std::unordered_map<unsigned int, StreamedTexture>::iterator victim = findEvictionVictim(0, 0, frameNumber);
+        if(victim == textures.end()) {
+            break;
+        }
+        previousLevels.emplace(victim->first, victim->second.residentLevel);
+        evictLevel(victim->second);
+    }
+    
+    std::vector<unsigned int> candidateIDs;
+    for(std::unordered_map<unsigned int, StreamedTexture>::iterator iter = textures.begin(); iter != textures.end(); iter++) {
+        if(iter->second.residentLevel > getNeededLevel(iter->second, frameNumber)) {
+            candidateIDs.push_back(iter->first);
+        }
+    }
+    size_t promotedBytes = 0;
+    while(!candidateIDs.empty()) {
+        // Most recently used first, then the coarsest missing level, so every texture in view is raised in step
+        unsigned int best = 0;
+        for(unsigned int i = 1; i < candidateIDs.size(); i++) {
+            const StreamedTexture& texture = textures[candidateIDs[i]];
+            const StreamedTexture& bestTexture = textures[candidateIDs[best]];
+            if(getRecency(texture) != getRecency(bestTexture)) {
+                if(getRecency(texture) > getRecency(bestTexture)) {
+                    best = i;
+                }
+            }
+            else if(texture.residentLevel != bestTexture.residentLevel) {
+                if(texture.residentLevel > bestTexture.residentLevel) {
+                    best = i;
+                }
+            }
+            else if(candidateIDs[i] < candidateIDs[best]) {
+                best = i;
+            }
+        }
+        unsigned int textureID = candidateIDs[best];
+        StreamedTexture& texture = textures[textureID];
+        unsigned int level = texture.residentLevel - 1;
+        size_t levelBytes = texture.levelBytes[level];
+        if(maxPromotedBytesPerUpdate != 0 && promotedBytes > 0 && promotedBytes + levelBytes > maxPromotedBytesPerUpdate) {
+            break;
+        }
+        
+        // Only evict anything once it is certain to make enough room
+        if(budget != 0 && totalResidentBytes + levelBytes > budget) {
+            size_t freeBytes = (totalResidentBytes < budget) ? budget - totalResidentBytes : 0;
+            if(freeBytes + getEvictableBytes(textureID, level, frameNumber) < levelBytes) {
+                stats.budgetMisses++;
+                candidateIDs.erase(candidateIDs.begin() + best);
+                continue;
+            }
+            while(totalResidentBytes + levelBytes > budget) {
+                std::unordered_map<unsigned int, StreamedTexture>::iterator victim = findEvictionVictim(textureID, level, frameNumber);
+#ifdef _DEBUG
+                assert(victim != textures.end());
+#endif
+                previousLevels.emplace(victim->first, victim->second.residentLevel);
+                evictLevel(victim->second);
+            }
+        }
+        previousLevels.emplace(textureID, texture.residentLevel);
+        texture.residentLevel = level;
+        texture.residentBytes += levelBytes;
+        totalResidentBytes += levelBytes;
+        promotedBytes += levelBytes;
+        stats.levelsPromoted++;
+        if(texture.residentLevel <= getNeededLevel(texture, frameNumber)) {
+            candidateIDs.erase(candidateIDs.begin() + best);
+        }
+    }
+    
+    std::vector<StreamingChange> changes;
+    for(std::unordered_map<unsigned int, unsigned int>::iterator iter = previousLevels.begin(); iter != previousLevels.end(); iter++) {
+        unsigned int residentLevel = textures[iter->first].residentLevel;
+        if(residentLevel != iter->second) {
+            changes.push_back({iter->first, iter->second, residentLevel});
+        }
+    }
+    std::sort(changes.begin(), changes.end(), [](const StreamingChange& a, const StreamingChange& b) { return a.textureID < b.textureID; });
+    return changes;
+}
+
+unsigned int TextureStreamingPolicy::getResidentLevel(const unsigned int textureID) const {
+#ifdef _DEBUG
+    assert(textures.count(textureID) > 0);
+#endif
+    return textures.at(textureID).residentLevel;
+}
+
+unsigned int TextureStreamingPolicy::getRequestedLevel(const unsigned int textureID) const {
+#ifdef _DEBUG
+    assert(textures.count(textureID) > 0);
+#endif
+    return textures.at(textureID).requestedLevel;
+}
+
+size_t TextureStreamingPolicy::getResidentBytes(const unsigned int textureID) const {
+#ifdef _DEBUG
+    assert(textures.count(textureID) > 0);
+#endif
+    return textures.at(textureID).residentBytes;
+}
+
+unsigned int TextureStreamingPolicy::ComputeRequiredLevel(const unsigned int width, const unsigned int height, const float screenWidth,
+        const float screenHeight) {
+    unsigned int lastLevel = MipmapGenerator::GetNumLevels(width, height) - 1;
+    if(screenWidth <= 0.0f || screenHeight <= 0.0f) {
+        return lastLevel;
+    }
+    // Trilinear filtering reads the level whose texels are closest to one per pixel and the finer one next to it
+    float texelsPerPixel = std::max((float)width / screenWidth, (float)height / screenHeight);
+    if(texelsPerPixel <= 1.0f) {
+        return 0;
+    }
+    return std::min((unsigned int)std::floor(std::log2(texelsPerPixel)), lastLevel);
+}
+
+unsigned int TextureStreamingPolicy::ComputeTailLevel(const unsigned int width, const unsigned int height, const unsigned int maxTailSize) {
+    unsigned int lastLevel = MipmapGenerator::GetNumLevels(width, height) - 1;
+    for(unsigned int level = 0; level < lastLevel; level++) {
+        if(MipmapGenerator::GetLevelSize(width, level) <= maxTailSize && MipmapGenerator::GetLevelSize(height, level) <= maxTailSize) {
+            return level;
+        }
+    }
+    return lastLevel;
+}
+
+unsigned int TextureStreamingPolicy::getNeededLevel(const StreamedTexture& texture, const unsigned long long frameNumber) const {
+    if(!texture.used || frameNumber > texture.lastUsedFrame + usageTimeoutFrames) {
+        return texture.minResidentLevel;
+    }
+    return texture.requestedLevel;
+}
+
+bool TextureStreamingPolicy::isEvictable(const StreamedTexture& texture, const unsigned int level, const StreamedTexture* candidate,
+        const unsigned int candidateLevel, const unsigned long long frameNumber) const {
+    if(level >= texture.minResidentLevel) {
+        return false;
+    }
+    if(candidate == nullptr || level < getNeededLevel(texture, frameNumber)) {
+        return true;
+    }
+    if(getRecency(texture) != getRecency(*candidate)) {
+        return getRecency(texture) < getRecency(*candidate);
+    }
+    return level < candidateLevel;
+}
+
+size_t TextureStreamingPolicy::getEvictableBytes(const unsigned int candidateID, const unsigned int level, const unsigned long long frameNumber) const {
+    const StreamedTexture& candidate = textures.at(candidateID);
+    size_t evictableBytes = 0;
+    for(std::unordered_map<unsigned int, StreamedTexture>::const_iterator iter = textures.begin(); iter != textures.end(); iter++) {
+        if(iter->first == candidateID) {
+            continue;
+        }
+        // Levels are evicted finest first, so stop at the first one that may not be
+        for(unsigned int textureLevel = iter->second.residentLevel; isEvictable(iter->second, textureLevel, &candidate, level, frameNumber); textureLevel++) {
+            evictableBytes += iter->second.levelBytes[textureLevel];
+        }
+    }
+    return evictableBytes;
+}
+
+std::unordered_map<unsigned int, TextureStreamingPolicy::StreamedTexture>::iterator TextureStreamingPolicy::findEvictionVictim(const unsigned int candidateID,
+        const unsigned int level, const unsigned long long frameNumber) {
+    const StreamedTexture* candidate = (candidateID != 0) ? &textures[candidateID] : nullptr;
+    std::unordered_map<unsigned int, StreamedTexture>::iterator victim = textures.end();
+    bool victimIsSurplus = false;
+    for(std::unordered_map<unsigned int, StreamedTexture>::iterator iter = textures.begin(); iter != textures.end(); iter++) {
+        const StreamedTexture& texture = iter->second;
+        if(iter->first == candidateID || !isEvictable(texture, texture.residentLevel, candidate, level, frameNumber)) {
+            continue;
+        }
+        // Levels finer than needed go first, then the least recently used textures, then the finest levels
+        bool isSurplus = texture.residentLevel < getNeededLevel(texture, frameNumber);
+        bool better = false;
+        if(victim == textures.end()) {
+            better = true;
+        }
+        else if(isSurplus != victimIsSurplus) {
+            better = isSurplus;
+        }
+        else if(getRecency(texture) != getRecency(victim->second)) {
+            better = getRecency(texture) < getRecency(victim->second);
+        }
+        else if(texture.residentLevel != victim->second.residentLevel) {
+            better = texture.residentLevel < victim->second.residentLevel;
+        }
+        else {
+            better = iter->first < victim->first;
+        }
+        if(better) {
+            victim = iter;
+            victimIsSurplus = isSurplus;
+        }
+    }
+    return victim;
+}
+
+void TextureStreamingPolicy::evictLevel(StreamedTexture& texture) {
+    size_t levelBytes = texture.levelBytes[texture.residentLevel];
+    texture.residentLevel++;
+    texture.residentBytes -= levelBytes;
+    totalResidentBytes -= levelBytes;
+    stats.levelsEvicted++;
+}
+
+}
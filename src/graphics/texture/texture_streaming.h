@@ -0,0 +1,158 @@
+#ifndef TEXTURE_STREAMING_H
+#define TEXTURE_STREAMING_H
+
+#include <vector>
+#include <unordered_map>
+#include <cstddef>
+
+namespace Engine {
+
+/*
+ * A streamed texture whose finest resident mipmap level changed during TextureStreamingPolicy::update.
+ */
+struct StreamingChange {
+    unsigned int textureID;
+    unsigned int previousLevel;
+    unsigned int residentLevel;
+};
+
+struct TextureStreamingStats {
+    // Mipmap levels made resident to raise a texture's resolution
+    unsigned long long levelsPromoted = 0;
+    // Mipmap levels dropped to make room for others or to get back under the budget
+    unsigned long long levelsEvicted = 0;
+    // Times a requested level didn't fit in the budget without evicting levels used more recently
+    unsigned long long budgetMisses = 0;
+};
+
+/*
+ * TextureStreamingPolicy decides which mipmap levels of streamed textures are resident within a byte budget. It only
+ * does the bookkeeping, so it can be driven with a simulated budget without OpenGL; TextureLoader applies its
+ * decisions to the textures.
+ *
+ * Each texture keeps a tail of coarse levels resident at all times. Finer levels are made resident one at a time as
+ * usage feedback asks for them, the coarsest missing level of the most recently used textures first, so every texture
+ * in view gets a usable resolution before any gets its finest levels. When a level doesn't fit, levels finer than
+ * their texture currently needs are evicted first, then the finest levels of the least recently used textures.
+ * Textures used on the same frame only give up levels finer than the one being made resident, so their resolutions
+ * even out instead of trading levels back and forth. A level is only made resident if enough can be evicted for it.
+ */
+class TextureStreamingPolicy {
+    public:
+        /*
+         * Starts streaming textureID, whose level i takes levelBytes[i] bytes. Levels from minResidentLevel onwards are
+         * always resident, and the texture starts out with only those.
+         */
+        void addTexture(const unsigned int textureID, const std::vector<size_t>& levelBytes, const unsigned int minResidentLevel);
+        void removeTexture(const unsigned int textureID);
+        bool hasTexture(const unsigned int textureID) const { return textures.count(textureID) > 0; }
+        
+        /*
+         * Records that textureID was drawn on frame frameNumber needing mipmap level level or finer. The finest level
+         * requested on a frame is kept.
+         */
+        void requestLevel(const unsigned int textureID, const unsigned int level, const unsigned long long frameNumber);
+        
+        /*
+         * Evicts levels until the resident bytes are back under the budget and then makes requested levels resident,
+         * at most maxPromotedBytesPerUpdate bytes of them. Returns the textures whose resident level changed, ordered
+         * by texture ID.
+         */
+        std::vector<StreamingChange> update(const unsigned long long frameNumber);
+        
+        unsigned int getResidentLevel(const unsigned int textureID) const;
+        unsigned int getRequestedLevel(const unsigned int textureID) const;
+        size_t getResidentBytes(const unsigned int textureID) const;
+        size_t getTotalResidentBytes() const { return totalResidentBytes; }
+        unsigned int getNumTextures() const { return textures.size(); }
+        
+        size_t getBudget() const { return budget; }
+        
+        /*
+         * Sets the most bytes streamed textures may keep resident. The tails of coarse levels are kept even if they
+         * alone exceed it. 0 means no limit.
+         */
+        void setBudget(const size_t budget) { this->budget = budget; }
+        
+        size_t getMaxPromotedBytesPerUpdate() const { return maxPromotedBytesPerUpdate; }
+        
+        /*
+         * Sets the most bytes of levels made resident by one update, so that raising many textures at once is spread
+         * over frames. At least one level is made resident per update. 0 means no limit.
+         */
+        void setMaxPromotedBytesPerUpdate(const size_t maxPromotedBytesPerUpdate) { this->maxPromotedBytesPerUpdate = maxPromotedBytesPerUpdate; }
+        
+        unsigned int getUsageTimeoutFrames() const { return usageTimeoutFrames; }
+        
+        /*
+         * Sets how many frames a request lasts. Once it runs out the texture only needs its tail, so its finer levels
+         * are the first to be evicted.
+         */
+        void setUsageTimeoutFrames(const unsigned int usageTimeoutFrames) { this->usageTimeoutFrames = usageTimeoutFrames; }
+        
+        const TextureStreamingStats& getStats() const { return stats; }
+        void resetStats() { stats = TextureStreamingStats(); }
+        
+        /*
+         * Returns the finest mipmap level a width by height texture needs when it covers screenWidth by screenHeight
+         * pixels on screen, i.e. the finest level trilinear filtering reads at that size.
+         */
+        static unsigned int ComputeRequiredLevel(const unsigned int width, const unsigned int height, const float screenWidth, const float screenHeight);
+        
+        /*
+         * Returns the first level of a width by height texture that is at most maxTailSize texels along either axis.
+         */
+        static unsigned int ComputeTailLevel(const unsigned int width, const unsigned int height, const unsigned int maxTailSize);
+    private:
+        struct StreamedTexture {
+            std::vector<size_t> levelBytes;
+            unsigned int minResidentLevel = 0;
+            unsigned int residentLevel = 0;
+            unsigned int requestedLevel = 0;
+            unsigned long long lastUsedFrame = 0;
+            bool used = false;
+            size_t residentBytes = 0;
+        };
+        
+        /*
+         * Returns the level texture needs on frame frameNumber, its tail if it hasn't been used within the timeout.
+         */
+        unsigned int getNeededLevel(const StreamedTexture& texture, const unsigned long long frameNumber) const;
+        
+        /*
+         * Returns how recently texture was used, 0 if it never was.
+         */
+        static unsigned long long getRecency(const StreamedTexture& texture) { return texture.used ? texture.lastUsedFrame + 1 : 0; }
+        
+        /*
+         * Returns true if level level of texture may be evicted to make level candidateLevel of candidate resident. A
+         * null candidate allows every level above the tail, for getting back under the budget.
+         */
+        bool isEvictable(const StreamedTexture& texture, const unsigned int level, const StreamedTexture* candidate, const unsigned int candidateLevel,
+                const unsigned long long frameNumber) const;
+        
+        /*
+         * Returns the bytes that could be evicted to make level level of the texture with candidateID resident.
+         */
+        size_t getEvictableBytes(const unsigned int candidateID, const unsigned int level, const unsigned long long frameNumber) const;
+        
+        /*
+         * Returns the texture whose finest level should be evicted next to make level level of the texture with
+         * candidateID resident, or textures.end() if none may be. A candidateID of 0 allows every level above the tail.
+         */
+        std::unordered_map<unsigned int, StreamedTexture>::iterator findEvictionVictim(const unsigned int candidateID, const unsigned int level,
+                const unsigned long long frameNumber);
+        
+        void evictLevel(StreamedTexture& texture);
+        
+        std::unordered_map<unsigned int, StreamedTexture> textures;
+        size_t totalResidentBytes = 0;
+        size_t budget = 0;
+        size_t maxPromotedBytesPerUpdate = 0;
+        unsigned int usageTimeoutFrames = 60;
+        TextureStreamingStats stats;
+};
+
+}
+
+#endif //TEXTURE_STREAMING_H
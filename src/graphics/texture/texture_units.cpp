@@ -0,0 +1,81 @@
+#include "texture_units.h"
+
+namespace Engine {
+
+/*
+ * Class TextureUnitState
+ */
+std::vector<GLuint> TextureUnitState::boundTextures(MAX_TEXTURE_UNITS, UNKNOWN);
+std::vector<GLuint> TextureUnitState::boundSamplers(MAX_TEXTURE_UNITS, UNKNOWN);
+GLuint TextureUnitState::activeUnit = UNKNOWN;
+TextureBindStats TextureUnitState::stats;
+
+void TextureUnitState::Bind(const unsigned int unit, const GLuint textureName, const GLuint sampler) {
+#ifdef _DEBUG
+    assert(unit < MAX_TEXTURE_UNITS);
+#endif
+    if(boundTextures[unit] != textureName) {
+        SetActiveUnit(unit);
+        glBindTexture(GL_TEXTURE_2D, textureName);
+        boundTextures[unit] = textureName;
+        stats.textureBinds++;
+    }
+    else {
+        stats.redundantBinds++;
+    }
+    // Samplers are bound by unit without making it active
+    if(boundSamplers[unit] != sampler) {
+        glBindSampler(unit, sampler);
+        boundSamplers[unit] = sampler;
+        stats.samplerBinds++;
+    }
+    else {
+        stats.redundantBinds++;
+    }
+}
+
+void TextureUnitState::BindToActiveUnit(const GLuint textureName) {
+    if(activeUnit == UNKNOWN) {
+        SetActiveUnit(0);
+    }
+    if(boundTextures[activeUnit] == textureName) {
+        stats.redundantBinds++;
+        return;
+    }
+    glBindTexture(GL_TEXTURE_2D, textureName);
+    boundTextures[activeUnit] = textureName;
+    stats.textureBinds++;
+}
+
+void TextureUnitState::ForgetTexture(const GLuint textureName) {
+    for(unsigned int unit = 0; unit < MAX_TEXTURE_UNITS; unit++) {
+        if(boundTextures[unit] == textureName) {
+            boundTextures[unit] = 0;
+        }
+    }
+}
+
+void TextureUnitState::ForgetSampler(const GLuint sampler) {
+    for(unsigned int unit = 0; unit < MAX_TEXTURE_UNITS; unit++) {
+        if(boundSamplers[unit] == sampler) {
+            boundSamplers[unit] = 0;
+        }
+    }
+}
+
+void TextureUnitState::Invalidate() {
+    boundTextures.assign(MAX_TEXTURE_UNITS, UNKNOWN);
+    boundSamplers.assign(MAX_TEXTURE_UNITS, UNKNOWN);
+    activeUnit = UNKNOWN;
+}
+
+void TextureUnitState::SetActiveUnit(const unsigned int unit) {
+    if(activeUnit == unit) {
+        return;
+    }
+    glActiveTexture(GL_TEXTURE0 + unit);
+    activeUnit = unit;
+    stats.unitSwitches++;
+}
+
+}
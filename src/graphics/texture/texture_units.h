@@ -0,0 +1,65 @@
+#ifndef TEXTURE_UNITS_H
+#define TEXTURE_UNITS_H
+
+#include <vector>
+#include <cassert>
+
+#include <glad/glad.h>
+
+namespace Engine {
+
+struct TextureBindStats {
+    unsigned long long textureBinds = 0;
+    unsigned long long samplerBinds = 0;
+    unsigned long long unitSwitches = 0;
+    // Binds skipped because the unit already held the texture or sampler
+    unsigned long long redundantBinds = 0;
+};
+
+/*
+ * TextureUnitState tracks the texture and sampler bound to each texture unit and the active unit, and only makes the
+ * OpenGL calls that change them. All texture binding in the engine goes through it so the tracked state stays true;
+ * call Invalidate if anything else binds textures or samplers, or after the context is recreated.
+ */
+class TextureUnitState {
+    public:
+        /*
+         * Binds textureName and sampler to texture unit unit for drawing.
+         */
+        static void Bind(const unsigned int unit, const GLuint textureName, const GLuint sampler);
+        
+        /*
+         * Binds textureName to the active texture unit, for uploading to it or changing its parameters.
+         */
+        static void BindToActiveUnit(const GLuint textureName);
+        
+        /*
+         * Records that textureName (or sampler) was deleted, which unbinds it from every unit.
+         */
+        static void ForgetTexture(const GLuint textureName);
+        static void ForgetSampler(const GLuint sampler);
+        
+        /*
+         * Forgets the tracked state, so the next bind of each unit is made whatever it holds.
+         */
+        static void Invalidate();
+        
+        static const TextureBindStats& GetStats() { return stats; }
+        static void ResetStats() { stats = TextureBindStats(); }
+        
+        static constexpr unsigned int MAX_TEXTURE_UNITS = 32;
+    private:
+        static void SetActiveUnit(const unsigned int unit);
+        
+        // Marks a unit or binding whose state isn't known
+        static constexpr GLuint UNKNOWN = ~(GLuint)0;
+        
+        static std::vector<GLuint> boundTextures;
+        static std::vector<GLuint> boundSamplers;
+        static GLuint activeUnit;
+        static TextureBindStats stats;
+};
+
+}
+
+#endif //TEXTURE_UNITS_H
@@ -0,0 +1,477 @@
+#include "job_system.h"
+#include <algorithm>
+#include <chrono>
+#include <cassert>
+
+namespace Engine {
+
+// Index of the worker thread running, NOT_A_JOB_THREAD on threads the job system didn't start
+static thread_local unsigned int workerThreadIndex = JobSystem::NOT_A_JOB_THREAD;
+
+/*
+ * Class JobCounter
+ */
+JobCounter::~JobCounter() {
+#ifdef _DEBUG
+    // Jobs still pointing at the counter would count down freed memory
+    assert(count == 0);
+#endif
+}
+
+unsigned int JobCounter::getCount() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return count;
+}
+
+/*
+ * Class JobSystem
+ */
+std::mutex JobSystem::startMutex;
+std::atomic<bool> JobSystem::running(false);
+std::atomic<bool> JobSystem::stopping(false);
+std::thread::id JobSystem::mainThreadID = std::thread::id();
+unsigned int JobSystem::numWorkerThreads = 0;
+std::vector<std::thread> JobSystem::workerThreads = std::vector<std::thread>();
+std::vector<std::unique_ptr<JobSystem::ThreadState>> JobSystem::threadStates = std::vector<std::unique_ptr<JobSystem::ThreadState>>();
+std::mutex JobSystem::sharedMutex;
+std::deque<Job*> JobSystem::sharedJobs = std::deque<Job*>();
+std::atomic<unsigned long long> JobSystem::numQueuedJobs(0);
+std::atomic<unsigned int> JobSystem::numSleepingWorkers(0);
+std::mutex JobSystem::sleepMutex;
+std::condition_variable JobSystem::sleepCondition;
+std::mutex JobSystem::mainThreadMutex;
+std::deque<Job*> JobSystem::mainThreadJobs = std::deque<Job*>();
+std::atomic<unsigned long long> JobSystem::numMainThreadJobsRun(0);
+JobSystemHooks JobSystem::hooks = JobSystemHooks();
+
+// Joins the worker threads before the statics above are destroyed, since destroying a joinable thread terminates
+static struct JobSystemShutdownGuard {
+    ~JobSystemShutdownGuard() { JobSystem::Shutdown(); }
+} jobSystemShutdownGuard;
+
+void JobSystem::Start() {
+    std::lock_guard<std::mutex> lock(startMutex);
+    if(running.load()) {
+        return;
+    }
+    mainThreadID = std::this_thread::get_id();
+    unsigned int numThreads = numWorkerThreads;
+    if(numThreads == 0) {
+        unsigned int numHardwareThreads = std::thread::hardware_concurrency();
+        numThreads = (numHardwareThreads > 1) ? numHardwareThreads - 1 : 1;
+    }
+    threadStates.clear();
+    for(unsigned int i = 0; i <= numThreads; i++) {
+        threadStates.push_back(std::make_unique<ThreadState>());
+        threadStates.back()->randomState = i + 1;
+    }
+    stopping.store(false);
+    running.store(true);
+    for(unsigned int i = 1; i <= numThreads; i++) {
+        workerThreads.push_back(std::thread(RunWorker, i));
+    }
+}
+
+void JobSystem::Run(const std::function<void()>& function, JobCounter& counter) {
+    if(!running.load()) {
+        Start();
+    }
+    Job* job = new Job{function, &counter};
+    {
+        std::lock_guard<std::mutex> lock(counter.mutex);
+        counter.count++;
+    }
+    Push(job);
+}
+
+void JobSystem::Run(const std::function<void()>& function, JobCounter& counter, JobCounter& dependency) {
+    if(!running.load()) {
+        Start();
+    }
+    Job* job = new Job{function, &counter};
+    {
+        std::lock_guard<std::mutex> lock(counter.mutex);
+        counter.count++;
+    }
+    {
+        // Checked under the dependency's lock, so its last job either sees this job or this sees the count at 0
+        std::lock_guard<std::mutex> lock(dependency.mutex);
+        if(dependency.count > 0) {
+            dependency.dependentJobs.push_back(job);
+            return;
+        }
+    }
+    Push(job);
+}
+
+void JobSystem::RunOnMainThread(const std::function<void()>& function, JobCounter& counter) {
+    if(!running.load()) {
+        Start();
+    }
+    Job* job = new Job{function, &counter};
+    {
+        std::lock_guard<std::mutex> lock(counter.mutex);
+        counter.count++;
+    }
+    std::lock_guard<std::mutex> lock(mainThreadMutex);
+    mainThreadJobs.push_back(job);
+}
+
+void JobSystem::Wait(JobCounter& counter) {
+    Help(counter);
+    std::exception_ptr exception;
+    {
+        std::lock_guard<std::mutex> lock(counter.mutex);
+        exception = counter.exception;
+        counter.exception = nullptr;
+    }
+    if(exception) {
+        std::rethrow_exception(exception);
+    }
+}
+
+void JobSystem::ParallelFor(const size_t first, const size_t last, const size_t grainSize, const std::function<void(size_t, size_t)>& function) {
+    if(last <= first) {
+        return;
+    }
+    size_t grain = std::max((size_t)1, grainSize);
+    if(last - first <= grain) {
+        function(first, last);
+        return;
+    }
+    JobCounter counter;
+    try {
+        SplitRange(first, last, grain, function, counter);
+    }
+    catch(...) {
+        // The queued ranges refer to function and counter, so they must finish before either goes
+        Help(counter);
+        throw;
+    }
+    Wait(counter);
+}
+
+unsigned int JobSystem::ProcessMainThreadJobs() {
+#ifdef _DEBUG
+    assert(!running.load() || IsMainThread());
+#endif
+    // Jobs queued while these run are left for the next call, so a job queuing another can't keep this going
+    std::deque<Job*> jobs;
+    {
+        std::lock_guard<std::mutex> lock(mainThreadMutex);
+        jobs.swap(mainThreadJobs);
+    }
+    for(unsigned int i = 0; i < jobs.size(); i++) {
+        Execute(jobs[i], NOT_A_JOB_THREAD);
+        numMainThreadJobsRun++;
+    }
+    return jobs.size();
+}
+
+void JobSystem::SetHooks(const JobSystemHooks& hooks) {
+#ifdef _DEBUG
+    assert(!running.load());
+#endif
+    JobSystem::hooks = hooks;
+}
+
+bool JobSystem::IsMainThread() {
+    return running.load() && std::this_thread::get_id() == mainThreadID;
+}
+
+unsigned int JobSystem::GetNumRunningWorkerThreads() {
+    std::lock_guard<std::mutex> lock(startMutex);
+    return workerThreads.size();
+}
+
+size_t JobSystem::GetNumPendingMainThreadJobs() {
+    std::lock_guard<std::mutex> lock(mainThreadMutex);
+    return mainThreadJobs.size();
+}
+
+JobSystemStats JobSystem::GetStats() {
+    std::lock_guard<std::mutex> lock(startMutex);
+    JobSystemStats stats;
+    for(unsigned int i = 0; i < threadStates.size(); i++) {
+        stats.numJobsRun += threadStates[i]->numJobsRun.load();
+        stats.numJobsStolen += threadStates[i]->numJobsStolen.load();
+        stats.numFailedSteals += threadStates[i]->numFailedSteals.load();
+        stats.idleMilliseconds += threadStates[i]->idleNanoseconds.load() / 1000000.0;
+    }
+    stats.numMainThreadJobsRun = numMainThreadJobsRun.load();
+    return stats;
+}
+
+JobSystemStats JobSystem::GetThreadStats(const unsigned int threadIndex) {
+    std::lock_guard<std::mutex> lock(startMutex);
+    JobSystemStats stats;
+    if(threadIndex >= threadStates.size()) {
+        return stats;
+    }
+    stats.numJobsRun = threadStates[threadIndex]->numJobsRun.load();
+    stats.numJobsStolen = threadStates[threadIndex]->numJobsStolen.load();
+    stats.numFailedSteals = threadStates[threadIndex]->numFailedSteals.load();
+    stats.idleMilliseconds = threadStates[threadIndex]->idleNanoseconds.load() / 1000000.0;
+    if(threadIndex == 0) {
+        stats.numMainThreadJobsRun = numMainThreadJobsRun.load();
+    }
+    return stats;
+}
+
+void JobSystem::ResetStats() {
+    std::lock_guard<std::mutex> lock(startMutex);
+    for(unsigned int i = 0; i < threadStates.size(); i++) {
+        threadStates[i]->numJobsRun.store(0);
+        threadStates[i]->numJobsStolen.store(0);
+        threadStates[i]->numFailedSteals.store(0);
+        threadStates[i]->idleNanoseconds.store(0);
+    }
+    numMainThreadJobsRun.store(0);
+}
+
+void JobSystem::Shutdown() {
+    std::lock_guard<std::mutex> lock(startMutex);
+    if(!running.load()) {
+        return;
+    }
+    stopping.store(true);
+    {
+        std::lock_guard<std::mutex> sleepLock(sleepMutex);
+    }
+    sleepCondition.notify_all();
+    for(unsigned int i = 0; i < workerThreads.size(); i++) {
+        workerThreads[i].join();
+    }
+    workerThreads.clear();
+    // Jobs the main thread queued after the workers stopped looking
+    unsigned int threadIndex = GetThreadIndex();
+    while(RunNextJob(threadIndex)) {}
+    std::deque<Job*> droppedJobs;
+    {
+        std::lock_guard<std::mutex> mainThreadLock(mainThreadMutex);
+        droppedJobs.swap(mainThreadJobs);
+    }
+    for(unsigned int i = 0; i < droppedJobs.size(); i++) {
+        delete droppedJobs[i];
+    }
+    running.store(false);
+    stopping.store(false);
+    threadStates.clear();
+}
+
+void JobSystem::RunWorker(const unsigned int threadIndex) {
+    workerThreadIndex = threadIndex;
+    ThreadState& state = *threadStates[threadIndex];
+    bool idle = false;
+    std::chrono::steady_clock::time_point idleStartTime;
+    auto endIdle = [&idle, &idleStartTime, &state, threadIndex]() {
+        std::chrono::nanoseconds idleTime = std::chrono::steady_clock::now() - idleStartTime;
+        state.idleNanoseconds += idleTime.count();
+        if(hooks.onIdle) {
+            hooks.onIdle(threadIndex, idleTime.count() / 1000000.0);
+        }
+        idle = false;
+    };
+    while(true) {
+        Job* job = TakeJob(threadIndex);
+        if(job != nullptr) {
+            if(idle) {
+                endIdle();
+            }
+            Execute(job, threadIndex);
+            continue;
+        }
+        if(!idle) {
+            idle = true;
+            idleStartTime = std::chrono::steady_clock::now();
+        }
+        if(stopping.load()) {
+            // Finish the queued jobs before stopping
+            if(numQueuedJobs.load() == 0) {
+                break;
+            }
+            continue;
+        }
+        std::unique_lock<std::mutex> lock(sleepMutex);
+        numSleepingWorkers++;
+        sleepCondition.wait(lock, []() { return stopping.load() || numQueuedJobs.load() > 0; });
+        numSleepingWorkers--;
+    }
+    endIdle();
+}
+
+unsigned int JobSystem::GetThreadIndex() {
+    if(workerThreadIndex != NOT_A_JOB_THREAD) {
+        return workerThreadIndex;
+    }
+    return IsMainThread() ? 0 : NOT_A_JOB_THREAD;
+}
+
+void JobSystem::Push(Job* job) {
+    // Counted first, so the count never drops below the jobs a thread can take
+    numQueuedJobs++;
+    unsigned int threadIndex = GetThreadIndex();
+    if(threadIndex != NOT_A_JOB_THREAD) {
+        threadStates[threadIndex]->deque.push(job);
+    }
+    else {
+        std::lock_guard<std::mutex> lock(sharedMutex);
+        sharedJobs.push_back(job);
+    }
+    // A worker going to sleep counts itself before checking for jobs, so it either sees this job or is woken
+    if(numSleepingWorkers.load() > 0) {
+        {
+            std::lock_guard<std::mutex> lock(sleepMutex);
+        }
+        sleepCondition.notify_one();
+    }
+}
+
+bool JobSystem::RunNextJob(const unsigned int threadIndex) {
+    Job* job = TakeJob(threadIndex);
+    if(job == nullptr) {
+        return false;
+    }
+    Execute(job, threadIndex);
+    return true;
+}
+
+Job* JobSystem::TakeJob(const unsigned int threadIndex) {
+    if(threadIndex != NOT_A_JOB_THREAD) {
+        Job* job = threadStates[threadIndex]->deque.pop();
+        if(job != nullptr) {
+            numQueuedJobs--;
+            return job;
+        }
+    }
+    {
+        std::lock_guard<std::mutex> lock(sharedMutex);
+        if(!sharedJobs.empty()) {
+            Job* job = sharedJobs.front();
+            sharedJobs.pop_front();
+            numQueuedJobs--;
+            return job;
+        }
+    }
+    return Steal(threadIndex);
+}
+
+Job* JobSystem::Steal(const unsigned int threadIndex) {
+    unsigned int numThreads = threadStates.size();
+    unsigned int firstVictim = 0;
+    if(threadIndex != NOT_A_JOB_THREAD) {
+        // xorshift, so threads out of work don't all try the same victim first
+        unsigned int& randomState = threadStates[threadIndex]->randomState;
+        randomState ^= randomState << 13;
+        randomState ^= randomState >> 17;
+        randomState ^= randomState << 5;
+        firstVictim = randomState % numThreads;
+    }
+    for(unsigned int i = 0; i < numThreads; i++) {
+        unsigned int victimIndex = (firstVictim + i) % numThreads;
+        if(victimIndex == threadIndex) {
+            continue;
+        }
+        WorkStealingDeque& victimDeque = threadStates[victimIndex]->deque;
+        if(victimDeque.getSize() == 0) {
+            continue;
+        }
+        Job* job = victimDeque.steal();
+        if(threadIndex == NOT_A_JOB_THREAD) {
+            if(job != nullptr) {
+                numQueuedJobs--;
+                return job;
+            }
+            continue;
+        }
+        if(job == nullptr) {
+            threadStates[threadIndex]->numFailedSteals++;
+            continue;
+        }
+        numQueuedJobs--;
+        threadStates[threadIndex]->numJobsStolen++;
+        if(hooks.onSteal) {
+            hooks.onSteal(threadIndex, victimIndex);
+        }
+        return job;
+    }
+    return nullptr;
+}
+
+void JobSystem::Execute(Job* job, const unsigned int threadIndex) {
+    std::exception_ptr exception;
+    try {
+        job->function();
+    }
+    catch(...) {
+        exception = std::current_exception();
+    }
+    JobCounter& counter = *job->counter;
+    // Release the job's captures before counting it as finished
+    delete job;
+    if(threadIndex != NOT_A_JOB_THREAD) {
+        threadStates[threadIndex]->numJobsRun++;
+    }
+    Finish(counter, exception);
+}
+
+bool JobSystem::RunMainThreadJob() {
+    Job* job = nullptr;
+    {
+        std::lock_guard<std::mutex> lock(mainThreadMutex);
+        if(mainThreadJobs.empty()) {
+            return false;
+        }
+        job = mainThreadJobs.front();
+        mainThreadJobs.pop_front();
+    }
+    Execute(job, NOT_A_JOB_THREAD);
+    numMainThreadJobsRun++;
+    return true;
+}
+
+void JobSystem::Finish(JobCounter& counter, std::exception_ptr exception) {
+    std::vector<Job*> readyJobs;
+    {
+        std::lock_guard<std::mutex> lock(counter.mutex);
+        if(exception && !counter.exception) {
+            counter.exception = exception;
+        }
+        counter.count--;
+        if(counter.count == 0) {
+            readyJobs.swap(counter.dependentJobs);
+        }
+    }
+    // The counter may be gone once its lock is released, since a waiting thread can see it done
+    for(unsigned int i = 0; i < readyJobs.size(); i++) {
+        Push(readyJobs[i]);
+    }
+}
+
+void JobSystem::Help(JobCounter& counter) {
+    unsigned int threadIndex = GetThreadIndex();
+    bool mainThread = threadIndex == 0;
+    while(!counter.isDone()) {
+        if(mainThread && RunMainThreadJob()) {
+            continue;
+        }
+        if(RunNextJob(threadIndex)) {
+            continue;
+        }
+        std::this_thread::yield();
+    }
+}
+
+void JobSystem::SplitRange(const size_t first, const size_t last, const size_t grainSize, const std::function<void(size_t, size_t)>& function,
+        JobCounter& counter) {
+    size_t splitLast = last;
+    // The upper halves go on the deque, so thieves take the largest ranges and this thread keeps the smallest
+    while(splitLast - first > grainSize) {
+        size_t middle = first + (splitLast - first) / 2;
+        Run([middle, splitLast, grainSize, &function, &counter]() { SplitRange(middle, splitLast, grainSize, function, counter); }, counter);
+        splitLast = middle;
+    }
+    function(first, splitLast);
+}
+
+}
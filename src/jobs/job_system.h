@@ -0,0 +1,229 @@
+#ifndef JOB_SYSTEM_H
+#define JOB_SYSTEM_H
+
+#include "work_stealing_deque.h"
+#include <functional>
+#include <exception>
+#include <memory>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <deque>
+#include <vector>
+#include <cstddef>
+
+namespace Engine {
+
+class JobCounter;
+
+struct Job {
+    std::function<void()> function;
+    JobCounter* counter = nullptr;
+};
+
+/*
+ * Counts the unfinished jobs run with it. JobSystem::Wait blocks until the count is 0, and jobs run with it as their
+ * dependency are held back until then. The first exception thrown by one of its jobs is kept for Wait to rethrow.
+ *
+ * A counter must outlive its jobs, so wait on it before destroying it.
+ */
+class JobCounter {
+    public:
+        JobCounter() = default;
+        JobCounter(const JobCounter&) = delete;
+        JobCounter& operator=(const JobCounter&) = delete;
+        ~JobCounter();
+        
+        unsigned int getCount() const;
+        bool isDone() const { return getCount() == 0; }
+    private:
+        friend class JobSystem;
+        
+        mutable std::mutex mutex;
+        unsigned int count = 0;
+        // Jobs waiting for the count to reach 0
+        std::vector<Job*> dependentJobs;
+        std::exception_ptr exception;
+};
+
+/*
+ * Counts of the work done by a thread of the job system, or by all of them.
+ */
+struct JobSystemStats {
+    unsigned long long numJobsRun = 0;
+    // Jobs taken from another thread's deque
+    unsigned long long numJobsStolen = 0;
+    // Steals that found jobs in the victim's deque but lost the race for them to another thread
+    unsigned long long numFailedSteals = 0;
+    unsigned long long numMainThreadJobsRun = 0;
+    // Time worker threads spent without a job, from their first failed search to the next job they found
+    double idleMilliseconds = 0.0;
+};
+
+/*
+ * Callbacks for profiling the job system. They're called on the thread doing the work, so they must be thread safe.
+ * Thread index 0 is the main thread and 1 onwards the worker threads.
+ */
+struct JobSystemHooks {
+    std::function<void(const unsigned int thiefIndex, const unsigned int victimIndex)> onSteal;
+    std::function<void(const unsigned int threadIndex, const double idleMilliseconds)> onIdle;
+};
+
+/*
+ * JobSystem runs small jobs on a fixed pool of worker threads. Each worker and the main thread own a work stealing
+ * deque: jobs a thread runs go on its own deque and it takes them back newest first, which keeps split up work on the
+ * thread that has its data in cache, while threads that run out of jobs steal the oldest, largest jobs from the others.
+ * Threads outside the job system submit through a shared queue.
+ *
+ * Waiting on a JobCounter runs other jobs until the count reaches 0, so jobs can wait on the jobs they run without
+ * tying up their thread. OpenGL calls must stay on the thread that owns the context, so jobs needing them are run with
+ * RunOnMainThread, and the main thread runs them while it waits or in ProcessMainThreadJobs.
+ *
+ * The main thread is the thread that starts the job system, either with Start or on first use.
+ */
+class JobSystem {
+    public:
+        /*
+         * If the job system isn't running, starts the worker threads and makes the calling thread the main thread.
+         */
+        static void Start();
+        
+        /*
+         * Runs function as a job counted by counter. Safe to call from any thread.
+         */
+        static void Run(const std::function<void()>& function, JobCounter& counter);
+        
+        /*
+         * Runs function as a job counted by counter once the count of dependency reaches 0.
+         */
+        static void Run(const std::function<void()>& function, JobCounter& counter, JobCounter& dependency);
+        
+        /*
+         * Runs function on the main thread, the next time it waits on a counter or calls ProcessMainThreadJobs. Safe to
+         * call from any thread.
+         */
+        static void RunOnMainThread(const std::function<void()>& function, JobCounter& counter);
+        
+        /*
+         * Runs jobs until the count of counter reaches 0, then rethrows the first exception thrown by one of its jobs.
+         * On the main thread this runs main thread jobs too.
+         */
+        static void Wait(JobCounter& counter);
+        
+        /*
+         * Calls function over [first, last) split into ranges of at most grainSize, run as jobs, and returns once every
+         * range is done. Ranges are split in halves, so a thread stealing a job takes half of the remaining work. A
+         * range of grainSize or less runs on the calling thread without starting the job system.
+         */
+        static void ParallelFor(const size_t first, const size_t last, const size_t grainSize, const std::function<void(size_t, size_t)>& function);
+        
+        /*
+         * Runs the queued main thread jobs in order. Returns the number run. Only call from the main thread.
+         */
+        static unsigned int ProcessMainThreadJobs();
+        
+        /*
+         * Sets the number of worker threads, with 0 using one less than the number of hardware threads. Takes effect
+         * the next time the worker threads are started.
+         */
+        static void SetNumWorkerThreads(const unsigned int numWorkerThreads) { JobSystem::numWorkerThreads = numWorkerThreads; }
+        
+        /*
+         * Sets the profiling callbacks. Only call while the job system isn't running.
+         */
+        static void SetHooks(const JobSystemHooks& hooks);
+        
+        static bool IsRunning() { return running.load(); }
+        static bool IsMainThread();
+        static unsigned int GetNumRunningWorkerThreads();
+        static size_t GetNumPendingMainThreadJobs();
+        
+        /*
+         * Returns the counts summed over every thread, or the counts of the thread at threadIndex.
+         */
+        static JobSystemStats GetStats();
+        static JobSystemStats GetThreadStats(const unsigned int threadIndex);
+        static void ResetStats();
+        
+        /*
+         * Finishes the queued jobs, joins the worker threads and drops the queued main thread jobs. Main thread jobs
+         * must not be left for the workers to wait on. The worker threads are started again by the next Start or job.
+         */
+        static void Shutdown();
+        
+        static constexpr unsigned int NOT_A_JOB_THREAD = ~0u;
+    private:
+        struct ThreadState {
+            WorkStealingDeque deque;
+            std::atomic<unsigned long long> numJobsRun{0};
+            std::atomic<unsigned long long> numJobsStolen{0};
+            std::atomic<unsigned long long> numFailedSteals{0};
+            std::atomic<unsigned long long> idleNanoseconds{0};
+            // State of the generator picking steal victims
+            unsigned int randomState = 1;
+        };
+        
+        static void RunWorker(const unsigned int threadIndex);
+        
+        /*
+         * Returns the index of the calling thread, or NOT_A_JOB_THREAD for threads outside the job system.
+         */
+        static unsigned int GetThreadIndex();
+        
+        /*
+         * Queues job on the calling thread's deque, or on the shared queue for threads outside the job system.
+         */
+        static void Push(Job* job);
+        
+        /*
+         * Takes a job from the calling thread's deque, the shared queue or another thread, in that order, and runs it.
+         * Returns whether a job was run.
+         */
+        static bool RunNextJob(const unsigned int threadIndex);
+        static Job* TakeJob(const unsigned int threadIndex);
+        static Job* Steal(const unsigned int threadIndex);
+        
+        /*
+         * Runs the oldest queued main thread job. Returns whether there was one.
+         */
+        static bool RunMainThreadJob();
+        static void Execute(Job* job, const unsigned int threadIndex);
+        
+        /*
+         * Counts down the counter of a finished job, queuing the jobs depending on it if it reaches 0.
+         */
+        static void Finish(JobCounter& counter, std::exception_ptr exception);
+        
+        /*
+         * Runs jobs until the count of counter reaches 0.
+         */
+        static void Help(JobCounter& counter);
+        
+        static void SplitRange(const size_t first, const size_t last, const size_t grainSize, const std::function<void(size_t, size_t)>& function,
+                JobCounter& counter);
+        
+        static std::mutex startMutex;
+        static std::atomic<bool> running;
+        static std::atomic<bool> stopping;
+        static std::thread::id mainThreadID;
+        static unsigned int numWorkerThreads;
+        static std::vector<std::thread> workerThreads;
+        // Index 0 is the main thread's
+        static std::vector<std::unique_ptr<ThreadState>> threadStates;
+        static std::mutex sharedMutex;
+        static std::deque<Job*> sharedJobs;
+        // Jobs in the deques and the shared queue, which sleeping workers wait on
+        static std::atomic<unsigned long long> numQueuedJobs;
+        static std::atomic<unsigned int> numSleepingWorkers;
+        static std::mutex sleepMutex;
+        static std::condition_variable sleepCondition;
+        static std::mutex mainThreadMutex;
+        static std::deque<Job*> mainThreadJobs;
+        static std::atomic<unsigned long long> numMainThreadJobsRun;
+        static JobSystemHooks hooks;
+};
+
+}
+
+#endif //JOB_SYSTEM_H
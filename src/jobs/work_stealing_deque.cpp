@@ -0,0 +1,83 @@
+#include "work_stealing_deque.h"
+#include <cassert>
+
+namespace Engine {
+
+/*
+ * Class WorkStealingDeque
+ */
+WorkStealingDeque::WorkStealingDeque(const size_t capacity) : top(0), bottom(0), buffer(nullptr), buffers() {
+#ifdef _DEBUG
+    // Indices wrap around the buffer with a mask
+    assert(capacity > 0 && (capacity & (capacity - 1)) == 0);
+#endif
+    buffers.push_back(std::make_unique<Buffer>(capacity));
+    buffer.store(buffers.back().get(), std::memory_order_relaxed);
+}
+
+void WorkStealingDeque::push(Job* job) {
+    long long b = bottom.load(std::memory_order_relaxed);
+    long long t = top.load(std::memory_order_acquire);
+    Buffer* currentBuffer = buffer.load(std::memory_order_relaxed);
+    if(b - t > (long long)currentBuffer->capacity - 1) {
+        currentBuffer = grow(currentBuffer, t, b);
+    }
+    currentBuffer->put(b, job);
+    // The job is written before thieves can see the new bottom
+    std::atomic_thread_fence(std::memory_order_release);
+    bottom.store(b + 1, std::memory_order_relaxed);
+}
+
+Job* WorkStealingDeque::pop() {
+    long long b = bottom.load(std::memory_order_relaxed) - 1;
+    Buffer* currentBuffer = buffer.load(std::memory_order_relaxed);
+    bottom.store(b, std::memory_order_relaxed);
+    // Taking the bottom is ordered against thieves reading it before top is read
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    long long t = top.load(std::memory_order_relaxed);
+    if(t > b) {
+        bottom.store(b + 1, std::memory_order_relaxed);
+        return nullptr;
+    }
+    Job* job = currentBuffer->get(b);
+    if(t == b) {
+        // The last job, which a thief may be taking too
+        if(!top.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst, std::memory_order_relaxed)) {
+            job = nullptr;
+        }
+        bottom.store(b + 1, std::memory_order_relaxed);
+    }
+    return job;
+}
+
+Job* WorkStealingDeque::steal() {
+    long long t = top.load(std::memory_order_acquire);
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    long long b = bottom.load(std::memory_order_acquire);
+    if(t >= b) {
+        return nullptr;
+    }
+    Job* job = buffer.load(std::memory_order_acquire)->get(t);
+    if(!top.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst, std::memory_order_relaxed)) {
+        return nullptr;
+    }
+    return job;
+}
+
+size_t WorkStealingDeque::getSize() const {
+    long long b = bottom.load(std::memory_order_relaxed);
+    long long t = top.load(std::memory_order_relaxed);
+    return (b > t) ? b - t : 0;
+}
+
+WorkStealingDeque::Buffer* WorkStealingDeque::grow(Buffer* oldBuffer, const long long top, const long long bottom) {
+    buffers.push_back(std::make_unique<Buffer>(2 * oldBuffer->capacity));
+    Buffer* newBuffer = buffers.back().get();
+    for(long long i = top; i < bottom; i++) {
+        newBuffer->put(i, oldBuffer->get(i));
+    }
+    buffer.store(newBuffer, std::memory_order_release);
+    return newBuffer;
+}
+
+}
@@ -0,0 +1,71 @@
+#ifndef WORK_STEALING_DEQUE_H
+#define WORK_STEALING_DEQUE_H
+
+#include <atomic>
+#include <vector>
+#include <memory>
+#include <cstddef>
+
+namespace Engine {
+
+struct Job;
+
+/*
+ * WorkStealingDeque is a Chase-Lev deque of jobs. The thread owning it pushes and pops jobs at the bottom, newest
+ * first, without locking, while any other thread can steal the oldest job from the top. The deque grows when full; the
+ * arrays it outgrows are kept until it's destroyed, since a thief may still be reading one.
+ *
+ * Reference: Lê, Pop, Cohen and Zappa Nardelli, "Correct and Efficient Work-Stealing for Weak Memory Models", 2013.
+ */
+class WorkStealingDeque {
+    public:
+        WorkStealingDeque(const size_t capacity = 1024);
+        WorkStealingDeque(const WorkStealingDeque&) = delete;
+        WorkStealingDeque& operator=(const WorkStealingDeque&) = delete;
+        
+        /*
+         * Adds job at the bottom. Only call from the owning thread.
+         */
+        void push(Job* job);
+        
+        /*
+         * Removes and returns the job at the bottom, or nullptr if the deque is empty. Only call from the owning thread.
+         */
+        Job* pop();
+        
+        /*
+         * Removes and returns the job at the top, or nullptr if the deque is empty or another thread took the job
+         * first. Safe to call from any thread.
+         */
+        Job* steal();
+        
+        /*
+         * Returns the number of jobs, which other threads may be changing.
+         */
+        size_t getSize() const;
+        size_t getCapacity() const { return buffer.load(std::memory_order_relaxed)->capacity; }
+    private:
+        struct Buffer {
+            Buffer(const size_t capacity) : capacity(capacity), slots(new std::atomic<Job*>[capacity]) {}
+            Job* get(const long long index) const { return slots[index & (capacity - 1)].load(std::memory_order_relaxed); }
+            void put(const long long index, Job* job) { slots[index & (capacity - 1)].store(job, std::memory_order_relaxed); }
+            
+            size_t capacity;
+            std::unique_ptr<std::atomic<Job*>[]> slots;
+        };
+        
+        /*
+         * Replaces the buffer with one twice its size holding the jobs from top to bottom.
+         */
+        Buffer* grow(Buffer* oldBuffer, const long long top, const long long bottom);
+        
+        std::atomic<long long> top;
+        std::atomic<long long> bottom;
+        std::atomic<Buffer*> buffer;
+        // Every buffer the deque has used, the current one last
+        std::vector<std::unique_ptr<Buffer>> buffers;
+};
+
+}
+
+#endif //WORK_STEALING_DEQUE_H
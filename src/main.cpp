@@ -1,10 +1,25 @@
 #include <iostream>
 #include <thread>
 #include <chrono>
+#include <future>
+#include <memory>
+#include <limits>
+#include <algorithm>
 
 #include <exceptions/render_exception.h>
 #include <fileio/image_reader.h>
 #include <graphics/model/model_converter.h>
+#include <graphics/buffer/resource_reclaimer.h>
+#include <graphics/buffer/upload_scheduler.h>
+#include <fileio/async_loader.h>
+#include <jobs/job_system.h>
+#include <graphics/texture/texture_cache.h>
+#include <graphics/state/gl_state_cache.h>
+#include <graphics/shaders/program_binary_cache.h>
+#include <graphics/material/material_parameter_block.h>
+#include <graphics/camera/frame_constants.h>
+#include <graphics/scene/scene_systems.h>
+#include <math/linear_math.h>
 
 #include <glad/glad.h> // Must include before GLFW
 #include <GLFW/glfw3.h>
@@ -19,11 +34,14 @@ void myWindowCloseCallback(GLFWwindow* window) {
 
 int myFrameWidth = 0;
 int myFrameHeight = 0;
+Engine::Camera myCamera(Engine::Math::toRadians(45.0f), 900.0f / 700.0f, 1.0f, 100.0f);
 void myFrameBufferResizeCallback(GLFWwindow* window, int frameWidth, int frameHeight) {
     std::cout << "New framebuffer size = (" << frameWidth << ", " << frameHeight << ")" << std::endl;
-    glViewport(0, 0, frameWidth, frameHeight);
+    Engine::GLStateCache::SetViewport(0, 0, frameWidth, frameHeight);
     myFrameWidth = frameWidth;
     myFrameHeight = frameHeight;
+    // Only marks the projection dirty, it's worked out again when next read
+    myCamera.setFramebufferSize(frameWidth, frameHeight);
 }
 
 void myMousePosCallback(GLFWwindow* window, double x, double y) {
@@ -94,7 +112,8 @@ int main(void) {
         std::cout << "OpenGL " << GLVersion.major << "." << GLVersion.minor << std::endl;
         
         glfwGetFramebufferSize(window, &myFrameWidth, &myFrameHeight);
-        glViewport(0, 0, myFrameWidth, myFrameHeight);
+        Engine::GLStateCache::SetViewport(0, 0, myFrameWidth, myFrameHeight);
+        myCamera.setFramebufferSize(myFrameWidth, myFrameHeight);
         std::cout << "Frame buffer size = (" << myFrameWidth << ", " << myFrameHeight << ")" << std::endl;
         
         // Random info ////
@@ -108,27 +127,33 @@ int main(void) {
         ////////////////////
         
         // Setup
-        Utility::ColladaModelConverter colladaModelConverter;
-        ADD_ERROR_INFO(colladaModelConverter = Utility::ColladaModelConverter("wolf_no_fur_test.dae"));
-        Engine::Model model = Engine::Model(colladaModelConverter.getModelDataPtr());
+        // Started here so this thread, which owns the context, runs the main thread jobs
+        Engine::JobSystem::Start();
+        Engine::UploadScheduler::SetStagingEnabled(true);
+        // Keep decoded textures with their mipmap chains, so later runs skip decoding
+        Engine::TextureCache::SetCacheDirectory("texture_cache");
+        // Keep linked shader programs as driver binaries, so later runs skip compiling them
+        Engine::ProgramBinaryCache::SetCacheDirectory("shader_cache");
+        // Parse the model in the background so the window keeps drawing while it loads
+        std::shared_future<Engine::ModelDataPtr> modelDataFuture = Utility::ColladaModelConverter::LoadModelDataAsync("wolf_no_fur_test.dae");
+        std::unique_ptr<Engine::Model> modelPtr;
+        // The model's meshes are drawn as entities, culled and batched into indirect draws
+        Engine::EntityWorld world;
+        Engine::IndirectDrawStream drawStream(1024);
+        std::vector<Engine::Entity> entities;
         
-        Engine::ShaderFiles files = {"myShader", "basic_vertex_shader.vs.glsl", "", "basic_fragment_shader.fs.glsl"};
+        Engine::ShaderFiles files = {"myIndirectShader", "indirect_vertex_shader.vs.glsl", "", "basic_fragment_shader.fs.glsl"};
         Engine::ShaderLoader::LoadShaderPrograms({files});
-        std::vector<Engine::Mesh> meshes = model.getModelDataPtr()->getMeshes();
         Engine::TexturedMaterial texturedMaterial;
-        texturedMaterial.setShaderProgramPtr(Engine::ShaderLoader::getShaderProgram("myShader"));
+        texturedMaterial.setShaderProgramPtr(Engine::ShaderLoader::getShaderProgram("myIndirectShader"));
         texturedMaterial.setTextures(
-                {Engine::Texture("Wolf_Body.jpg", Engine::TextureType::TEXTURE_DIFFUSE),
-                Engine::Texture("Wolf_Body.jpg", Engine::TextureType::TEXTURE_DIFFUSE)}
+                {Engine::Texture("Wolf_Body.jpg", Engine::TextureType::TEXTURE_DIFFUSE, true),
+                Engine::Texture("Wolf_Body.jpg", Engine::TextureType::TEXTURE_DIFFUSE, true)}
         );
         texturedMaterial.setTextureMixingWeights(
                 {1.0f,
                 1.0f}
         );
-        for(unsigned int i = 0; i < meshes.size(); i++) {
-            meshes[i].setTexturedMaterial(texturedMaterial);
-        }
-        model.getModelDataPtr()->setMeshes(meshes);
         
         // Set minimum of 1 frame time between swapping buffer
         glfwSwapInterval(1);
@@ -136,20 +161,67 @@ int main(void) {
             //std::this_thread::sleep_for(std::chrono::milliseconds(17));
             glfwPollEvents();
             
-            // MOVE THIS
-            glEnable(GL_DEPTH_TEST);
-            
             // Render to back buffer
-            glClearColor(0.0f, 1.0f, 0.0f, 1.0f);
+            Engine::GLStateCache::SetEnabled(GL_DEPTH_TEST, true);
+            Engine::GLStateCache::SetClearColor(0.0f, 1.0f, 0.0f, 1.0f);
             glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
             
+            // LOADING
+            Engine::AsyncLoader::ProcessMainThreadTasks(2.0);
+            Engine::JobSystem::ProcessMainThreadJobs();
+            if(!modelPtr && modelDataFuture.wait_for(std::chrono::seconds(0)) == std::future_status::ready) {
+                ADD_ERROR_INFO(modelPtr = std::make_unique<Engine::Model>(modelDataFuture.get()));
+                unsigned int materialHandle = world.addMaterial(texturedMaterial);
+                std::vector<Engine::Mesh> meshes = modelPtr->getModelDataPtr()->getMeshes();
+                for(unsigned int i = 0; i < meshes.size(); i++) {
+                    Engine::Entity entity = world.createEntity(Engine::componentBit(Engine::COMPONENT_TRANSFORM) | Engine::componentBit(Engine::COMPONENT_BOUNDS)
+                            | Engine::componentBit(Engine::COMPONENT_MESH) | Engine::componentBit(Engine::COMPONENT_MATERIAL)
+                            | Engine::componentBit(Engine::COMPONENT_VISIBILITY));
+                    // Bounds of the vertices the mesh draws, its geometry may be shared with the other meshes
+                    Engine::MeshDataPtr meshDataPtr = meshes[i].getMeshDataPtr();
+                    const Engine::SharedBuffer<unsigned int>& indices = meshDataPtr->getIndices();
+                    const Engine::SharedBuffer<Engine::Math::Vec3f>& vertices = meshDataPtr->getMeshGeometryDataPtr()->getVertices();
+                    Engine::BoundsComponent& bounds = world.getComponent<Engine::BoundsComponent>(entity);
+                    bounds.boundsMin = Engine::Math::Vec3f(std::numeric_limits<float>::max());
+                    bounds.boundsMax = Engine::Math::Vec3f(std::numeric_limits<float>::lowest());
+                    for(unsigned int j = 0; j < indices.getSize(); j++) {
+                        for(unsigned int c = 0; c < 3; c++) {
+                            bounds.boundsMin[c] = std::min(bounds.boundsMin[c], vertices[indices[j]][c]);
+                            bounds.boundsMax[c] = std::max(bounds.boundsMax[c], vertices[indices[j]][c]);
+                        }
+                    }
+                    world.getComponent<Engine::MeshComponent>(entity).meshID = meshes[i].getMeshID();
+                    world.getComponent<Engine::MaterialComponent>(entity).materialHandle = materialHandle;
+                    entities.push_back(entity);
+                }
+            }
+            
             // DRAWING
-            Engine::Mesh::myTime = ((int)(100.0f * glfwGetTime()) % 1000) / 1000.0f;
-            model.render();
+            Engine::TextureLoader::UpdateTextureStreaming();
+            Engine::UploadScheduler::ProcessUploads();
+            float myTime = ((int)(100.0f * glfwGetTime()) % 1000) / 1000.0f;
+            Engine::Mesh::myTransform = Engine::Math::createTranslationMat(Engine::Math::createVec3<float>(Engine::Mesh::myPos[0], Engine::Mesh::myPos[1], Engine::Mesh::myPos[2]))
+                    * Engine::Math::createTranslationMat(Engine::Math::createVec3<float>(0.5f, 0.5f, 0.5f))
+                    * Engine::Math::createRotationMat(Engine::Math::createVec3<float>(1.0f, 1.0f, 1.0f), Engine::Math::toRadians(360.0f * myTime))
+                    * Engine::Math::createTranslationMat(Engine::Math::createVec3<float>(-0.5f, -0.5f, -0.5f));
+            Engine::FrameConstants::Update(myCamera);
+            for(unsigned int i = 0; i < entities.size(); i++) {
+                world.getComponent<Engine::TransformComponent>(entities[i]).transform = Engine::Mesh::myTransform;
+            }
+            Engine::CullingSystem::UpdateVisibility(world, myCamera.getFrustum());
+            Engine::DrawSystem::Draw(world, drawStream);
             
             glfwSwapBuffers(window);
+            Engine::ResourceReclaimer::EndFrame();
+            Engine::UploadScheduler::EndFrame();
+            Engine::MaterialParameterBlock::EndFrame();
+            Engine::FrameConstants::EndFrame();
+            Engine::GLStateCache::EndFrame();
         }
         
+        Engine::AsyncLoader::Shutdown();
+        Engine::JobSystem::Shutdown();
+        drawStream.destroy();
         glfwDestroyWindow(window);
         
         // Terminate to free memory and resources
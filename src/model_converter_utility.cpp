@@ -1,16 +1,102 @@
 #include <graphics/model/model_converter.h>
+#include <graphics/texture/texture_data.h>
+#include <graphics/texture/texture_cache.h>
 #include <fileio/xml/xml_parser.h>
 #include <iostream>
+#include <iomanip>
+#include <chrono>
+#include <string>
 
-int main() {
+/*
+ * Compresses the image at filePath and its mipmap chain into format, printing the size, encoding time and PSNR of each
+ * level so the encoder's quality can be checked without a window. If cacheDirectory isn't empty, the compressed texture
+ * is stored there as the cached container TextureLoader loads in place of the image.
+ */
+static void compressTexture(const std::string& filePath, const Engine::CompressedFormat format, const Engine::CompressionQuality quality,
+        const std::string& cacheDirectory) {
+    Engine::TextureSourceInfo sourceInfo = Engine::TextureCache::GetSourceInfo(filePath, Engine::TextureLoader::GetMipmapSettings().getCacheKey(), true);
+    unsigned int textureID = Engine::TextureLoader::LoadTextureFromFile(filePath);
+    Engine::TextureDataPtr originalPtr = Engine::TextureLoader::CopyTextureDataFromLoaded(textureID);
+    Engine::TextureDataPtr compressedPtr = Engine::TextureLoader::CopyTextureDataFromLoaded(textureID);
+    unsigned int numChannels = originalPtr->getNumChannels();
+    
+    std::chrono::steady_clock::time_point startTime = std::chrono::steady_clock::now();
+    compressedPtr->compress(format, quality);
+    double elapsedMilliseconds = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - startTime).count();
+    
+    std::cout << filePath << ": " << originalPtr->getWidth() << "x" << originalPtr->getHeight() << ", " << numChannels << " channels, "
+            << originalPtr->getSizeInBytesWithMipLevels() << " bytes raw, " << compressedPtr->getSizeInBytesWithMipLevels()
+            << " bytes compressed in " << std::fixed << std::setprecision(1) << elapsedMilliseconds << " ms" << std::endl;
+    for(unsigned int level = 0; level <= originalPtr->getMipLevels().size(); level++) {
+        unsigned int levelWidth = Engine::MipmapGenerator::GetLevelSize(originalPtr->getWidth(), level);
+        unsigned int levelHeight = Engine::MipmapGenerator::GetLevelSize(originalPtr->getHeight(), level);
+        const Engine::SharedBuffer<unsigned char>& original = (level == 0) ? originalPtr->getData() : originalPtr->getMipLevels()[level - 1];
+        const Engine::SharedBuffer<unsigned char>& blocks = (level == 0) ? compressedPtr->getData() : compressedPtr->getMipLevels()[level - 1];
+        // Only compare the channels the format stores
+        unsigned int comparedChannels = std::min(numChannels, Engine::BlockCompressor::GetNumChannels(format));
+        std::vector<unsigned char> decoded = Engine::BlockCompressor::DecompressImage(blocks.data(), levelWidth, levelHeight, format, numChannels);
+        std::vector<unsigned char> originalChannels;
+        std::vector<unsigned char> decodedChannels;
+        for(size_t i = 0; i < decoded.size(); i++) {
+            if(i % numChannels < comparedChannels) {
+                originalChannels.push_back(original[i]);
+                decodedChannels.push_back(decoded[i]);
+            }
+        }
+        std::cout << "    LEVEL " << level << " " << levelWidth << "x" << levelHeight << ": PSNR "
+                << Engine::BlockCompressor::ComputePSNR(originalChannels.data(), decodedChannels.data(), originalChannels.size()) << " dB" << std::endl;
+    }
+    
+    if(!cacheDirectory.empty()) {
+        Engine::TextureCache::SetCacheDirectory(cacheDirectory);
+        if(!Engine::TextureCache::Store(filePath, sourceInfo, compressedPtr)) {
+            throw Engine::FileIOException("ERROR: Failed to write \"" + Engine::TextureCache::GetCacheFilePath(filePath) + "\"");
+        }
+        std::cout << "Cached as " << Engine::TextureCache::GetCacheFilePath(filePath) << std::endl;
+    }
+}
+
+int main(int argc, char** argv) {
     int errorNum = 0;
     
     std::cout << "CONVERTER UTILITY" << std::endl;
     
     try {
-        Utility::XmlParser parser;
-        ADD_ERROR_INFO(parser = Utility::XmlParser("wolf_test.dae"));
-        std::cout << parser.getTopNode()->getChildNodes()[6]->toString();
+        if(argc > 2 && std::string(argv[1]) == "--compress-texture") {
+            // --compress-texture <image file> [bc1|bc3|bc5|bc7] [fast|normal|high] [cache directory]
+            std::string formatName = (argc > 3) ? argv[3] : "bc1";
+            std::string qualityName = (argc > 4) ? argv[4] : "normal";
+            Engine::CompressedFormat format = Engine::COMPRESSED_FORMAT_BC1;
+            if(formatName == "bc3") {
+                format = Engine::COMPRESSED_FORMAT_BC3;
+            }
+            else if(formatName == "bc5") {
+                format = Engine::COMPRESSED_FORMAT_BC5;
+            }
+            else if(formatName == "bc7") {
+                format = Engine::COMPRESSED_FORMAT_BC7;
+            }
+            else if(formatName != "bc1") {
+                throw Engine::GeneralException("ERROR: Unknown compressed format \"" + formatName + "\".");
+            }
+            Engine::CompressionQuality quality = Engine::COMPRESSION_QUALITY_NORMAL;
+            if(qualityName == "fast") {
+                quality = Engine::COMPRESSION_QUALITY_FAST;
+            }
+            else if(qualityName == "high") {
+                quality = Engine::COMPRESSION_QUALITY_HIGH;
+            }
+            else if(qualityName != "normal") {
+                throw Engine::GeneralException("ERROR: Unknown compression quality \"" + qualityName + "\".");
+            }
+            std::string cacheDirectory = (argc > 5) ? argv[5] : "";
+            ADD_ERROR_INFO(compressTexture(argv[2], format, quality, cacheDirectory));
+        }
+        else {
+            Utility::XmlParser parser;
+            ADD_ERROR_INFO(parser = Utility::XmlParser("wolf_test.dae"));
+            std::cout << parser.getTopNode()->getChildNodes()[6]->toString();
+        }
     }
     catch(Engine::GeneralException& e) {
         std::cerr << e.getMessage() << std::endl;
@@ -31,4 +117,3 @@ int main() {
     
     return errorNum;
 }
-
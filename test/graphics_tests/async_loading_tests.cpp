@@ -0,0 +1,259 @@
+#include "async_loading_tests.h"
+#include <filesystem>
+#include <fstream>
+
+using namespace Engine;
+using namespace Engine::Math;
+
+namespace Tests::AsyncLoadingTests {
+
+int DoTests() {
+    int failedCount = 0;
+    
+    failedCount += TestAsyncLoaderQueues();
+    failedCount += TestAsyncTextureLoad();
+    failedCount += TestStaleAsyncTextureLoads();
+    failedCount += TestAsyncModelLoad();
+    
+    AsyncLoader::Shutdown();
+    return failedCount;
+}
+
+/*
+ * Writes a 2x2 binary PPM image to the temporary directory. Rows are stored top to bottom, so the decoded texture
+ * starts with the bottom row (70, 80, 90).
+ */
+static std::string writeTestImage(const std::string& fileName) {
+    std::string filePath = (std::filesystem::temp_directory_path() / fileName).string();
+    std::ofstream outFile(filePath, std::ios_base::out | std::ios_base::binary);
+    outFile << "P6\n2 2\n255\n";
+    for(unsigned char value = 10; value <= 120; value += 10) {
+        outFile.put((char)value);
+    }
+    return filePath;
+}
+
+/*
+ * Writes a Collada file with one triangle to the temporary directory.
+ */
+static std::string writeTestModel(const std::string& fileName) {
+    std::string filePath = (std::filesystem::temp_directory_path() / fileName).string();
+    std::ofstream outFile(filePath, std::ios_base::out);
+    outFile << "<?xml version=\"1.0\" encoding=\"utf-8\"?>\n"
+            << "<COLLADA version=\"1.4.1\">\n"
+            << "  <library_effects>\n"
+            << "  </library_effects>\n"
+            << "  <library_geometries>\n"
+            << "    <geometry id=\"Triangle-mesh\" name=\"Triangle\">\n"
+            << "      <mesh>\n"
+            << "        <source id=\"Triangle-mesh-positions\">\n"
+            << "          <float_array id=\"Triangle-mesh-positions-array\" count=\"9\">0 0 0 1 0 0 0 1 0</float_array>\n"
+            << "          <technique_common>\n"
+            << "            <accessor source=\"#Triangle-mesh-positions-array\" count=\"3\" stride=\"3\">\n"
+            << "            </accessor>\n"
+            << "          </technique_common>\n"
+            << "        </source>\n"
+            << "        <source id=\"Triangle-mesh-normals\">\n"
+            << "          <float_array id=\"Triangle-mesh-normals-array\" count=\"3\">0 0 1</float_array>\n"
+            << "          <technique_common>\n"
+            << "            <accessor source=\"#Triangle-mesh-normals-array\" count=\"1\" stride=\"3\">\n"
+            << "            </accessor>\n"
+            << "          </technique_common>\n"
+            << "        </source>\n"
+            << "        <source id=\"Triangle-mesh-map-0\">\n"
+            << "          <float_array id=\"Triangle-mesh-map-0-array\" count=\"6\">0 0 1 0 0 1</float_array>\n"
+            << "          <technique_common>\n"
+            << "            <accessor source=\"#Triangle-mesh-map-0-array\" count=\"3\" stride=\"2\">\n"
+            << "            </accessor>\n"
+            << "          </technique_common>\n"
+            << "        </source>\n"
+            << "        <vertices id=\"Triangle-mesh-vertices\">\n"
+            << "          <input semantic=\"POSITION\" source=\"#Triangle-mesh-positions\"/>\n"
+            << "        </vertices>\n"
+            << "        <triangles material=\"Material\" count=\"1\">\n"
+            << "          <p>0 0 0 1 0 1 2 0 2</p>\n"
+            << "        </triangles>\n"
+            << "      </mesh>\n"
+            << "    </geometry>\n"
+            << "  </library_geometries>\n"
+            << "</COLLADA>\n";
+    return filePath;
+}
+
+int TestAsyncLoaderQueues() {
+    std::stringstream result;
+    std::stringstream expected;
+    int failedCount = 0;
+    AsyncLoader::ResetStats();
+    
+    // Worker results come back through the future, and main thread tasks wait for ProcessMainThreadTasks
+    result = std::stringstream();
+    expected = std::stringstream();
+    std::shared_ptr<std::vector<int>> orderPtr = std::make_shared<std::vector<int>>();
+    std::future<int> future = AsyncLoader::Submit<int>([orderPtr]() {
+        for(int i = 0; i < 3; i++) {
+            AsyncLoader::QueueOnMainThread([orderPtr, i]() { orderPtr->push_back(i); });
+        }
+        return 42;
+    });
+    result << future.get() << ", ";
+    AsyncLoader::WaitForWorkers();
+    result << orderPtr->size() << " " << AsyncLoader::GetNumPendingMainThreadTasks();
+    expected << "42, 0 3";
+    CompareResult(ERROR_INFO, expected, result, failedCount);
+    
+    // A spent budget still runs one task per call, and the rest are left for later calls in order
+    result = std::stringstream();
+    expected = std::stringstream();
+    result << AsyncLoader::ProcessMainThreadTasks(0.0) << " " << AsyncLoader::ProcessMainThreadTasks(1000.0) << " "
+            << AsyncLoader::ProcessMainThreadTasks(1000.0) << ", ";
+    for(unsigned int i = 0; i < orderPtr->size(); i++) {
+        result << (*orderPtr)[i] << " ";
+    }
+    AsyncLoadStats stats = AsyncLoader::GetStats();
+    result << stats.numTasksSubmitted << " " << stats.numTasksCompleted << " " << stats.numMainThreadTasksRun << " " << stats.numBudgetDeferrals;
+    expected << "1 2 0, 0 1 2 1 1 3 1";
+    CompareResult(ERROR_INFO, expected, result, failedCount);
+    
+    // Exceptions thrown on a worker are passed on through the future
+    result = std::stringstream();
+    expected = std::stringstream();
+    std::future<int> failedFuture = AsyncLoader::Submit<int>([]() -> int {
+        throw FileIOException("ERROR: Test exception.");
+    });
+    try {
+        failedFuture.get();
+        result << "returned";
+    }
+    catch(FileIOException& e) {
+        result << "threw";
+    }
+    result << ", " << (AsyncLoader::GetNumRunningWorkerThreads() > 0) << " ";
+    AsyncLoader::Shutdown();
+    result << AsyncLoader::GetNumRunningWorkerThreads() << " " << AsyncLoader::GetNumPendingWorkerTasks();
+    expected << "threw, 1 0 0";
+    CompareResult(ERROR_INFO, expected, result, failedCount);
+    
+    return failedCount;
+}
+
+int TestAsyncTextureLoad() {
+    std::stringstream result;
+    std::stringstream expected;
+    int failedCount = 0;
+    GeometryHeap::Destroy();
+    HeadlessGL::Reset();
+    std::string filePath = writeTestImage("async_loading_test.ppm");
+    unsigned long long initialThrashEvents = TextureLoader::GetReleaseQueue().getStats().thrashEvents;
+    
+    // The texture can be used and buffered straight away with its placeholder
+    result = std::stringstream();
+    expected = std::stringstream();
+    unsigned int textureID = TextureLoader::LoadTextureFromFileAsync(filePath);
+    TextureLoader::UseLoadedTexture(textureID);
+    result << TextureLoader::IsAsyncLoadPending(textureID) << ", " << TextureLoader::GetWidth(textureID) << "x" << TextureLoader::GetHeight(textureID) << ", "
+            << (TextureLoader::LoadTextureFromFileAsync(filePath) == textureID) << " " << (TextureLoader::LoadTextureFromFile(filePath) == textureID) << ", "
+            << HeadlessGL::GetNumLiveTextures() << " " << TextureLoader::GetMemoryStats().deviceBytes;
+    expected << "1, 1x1, 1 1, 1 3";
+    CompareResult(ERROR_INFO, expected, result, failedCount);
+    
+    // The decoded image replaces the placeholder in OpenGL once the main thread picks it up
+    result = std::stringstream();
+    expected = std::stringstream();
+    AsyncLoader::WaitForWorkers();
+    result << TextureLoader::IsAsyncLoadPending(textureID) << ", ";
+    AsyncLoader::ProcessMainThreadTasks(1000.0);
+    std::vector<unsigned char> pixels(12);
+    TextureLoader::BindTexture(textureID);
+    glPixelStorei(GL_PACK_ALIGNMENT, 1);
+    glGetTexImage(GL_TEXTURE_2D, 0, GL_RGB, GL_UNSIGNED_BYTE, pixels.data());
+    glPixelStorei(GL_PACK_ALIGNMENT, 4);
+    TextureUnitState::BindToActiveUnit(0);
+    result << TextureLoader::IsAsyncLoadPending(textureID) << " " << TextureLoader::HasAsyncLoadFailed(textureID) << ", "
+            << TextureLoader::GetWidth(textureID) << "x" << TextureLoader::GetHeight(textureID) << ", "
+            << (int)pixels[0] << " " << (int)pixels[11] << ", " << (int)TextureLoader::GetTextureDataPtr(textureID)->getData()[3] << ", "
+            << HeadlessGL::GetNumLiveTextures() << " " << TextureLoader::GetMemoryStats().deviceBytes << " "
+            << TextureLoader::GetReleaseQueue().getStats().thrashEvents - initialThrashEvents;
+    expected << "1, 0 0, 2x2, 70 60, 100, 1 15 0";
+    CompareResult(ERROR_INFO, expected, result, failedCount);
+    
+    TextureLoader::ReleaseLoadedTexture(textureID);
+    ResourceReclaimer::ReclaimAll();
+    TextureLoader::UnloadUnusedTextures();
+    std::filesystem::remove(filePath);
+    return failedCount;
+}
+
+int TestStaleAsyncTextureLoads() {
+    std::stringstream result;
+    std::stringstream expected;
+    int failedCount = 0;
+    GeometryHeap::Destroy();
+    HeadlessGL::Reset();
+    TextureLoader::UnloadUnusedTextures();
+    std::string filePath = writeTestImage("async_loading_stale_test.ppm");
+    
+    // A texture unloaded while decoding ignores the decoded image, even if its index has been reused
+    result = std::stringstream();
+    expected = std::stringstream();
+    unsigned int staleTextureID = TextureLoader::LoadTextureFromFileAsync(filePath);
+    TextureLoader::UnloadUnusedTextures();
+    std::vector<unsigned char> pixels(9, 5);
+    unsigned int reusedTextureID = TextureLoader::LoadTextureFromTextureData(std::make_shared<TextureData>(3, 1, 3, SharedBuffer<unsigned char>(std::move(pixels))));
+    
+    // A file that can't be decoded keeps the placeholder
+    unsigned int failedTextureID = TextureLoader::LoadTextureFromFileAsync("missing_async_loading_test.ppm");
+    AsyncLoader::WaitForWorkers();
+    AsyncLoader::ProcessMainThreadTasks(1000.0);
+    result << (reusedTextureID == staleTextureID) << ", " << TextureLoader::GetWidth(reusedTextureID) << " "
+            << (int)TextureLoader::GetTextureDataPtr(reusedTextureID)->getData()[0] << " " << TextureLoader::IsAsyncLoadPending(reusedTextureID) << ", "
+            << TextureLoader::IsAsyncLoadPending(failedTextureID) << " " << TextureLoader::HasAsyncLoadFailed(failedTextureID) << " "
+            << TextureLoader::GetWidth(failedTextureID);
+    expected << "1, 3 5 0, 0 1 1";
+    CompareResult(ERROR_INFO, expected, result, failedCount);
+    
+    TextureLoader::UnloadUnusedTextures();
+    ResourceReclaimer::ReclaimAll();
+    std::filesystem::remove(filePath);
+    return failedCount;
+}
+
+int TestAsyncModelLoad() {
+    std::stringstream result;
+    std::stringstream expected;
+    int failedCount = 0;
+    GeometryHeap::Destroy();
+    HeadlessGL::Reset();
+    std::string filePath = writeTestModel("async_loading_test.dae");
+    size_t initialHostBytes = MeshLoader::GetMemoryStats().hostBytes;
+    
+    // The model is parsed on a worker but its meshes are only loaded on the main thread
+    result = std::stringstream();
+    expected = std::stringstream();
+    std::shared_future<ModelDataPtr> modelDataFuture = Utility::ColladaModelConverter::LoadModelDataAsync(filePath);
+    std::shared_future<ModelDataPtr> missingModelDataFuture = Utility::ColladaModelConverter::LoadModelDataAsync("missing_async_loading_test.dae");
+    AsyncLoader::WaitForWorkers();
+    result << (modelDataFuture.wait_for(std::chrono::seconds(0)) == std::future_status::ready) << " "
+            << (missingModelDataFuture.wait_for(std::chrono::seconds(0)) == std::future_status::ready) << " " << MeshLoader::GetMemoryStats().hostBytes - initialHostBytes << ", ";
+    AsyncLoader::ProcessMainThreadTasks(1000.0);
+    ModelDataPtr modelDataPtr = modelDataFuture.get();
+    result << modelDataPtr->getNumMeshes() << " " << modelDataPtr->getMesh(0).getMeshDataPtr()->getIndices().getSize() << " "
+            << modelDataPtr->getMesh(0).getMeshDataPtr()->getMeshGeometryDataPtr()->getVertices().getSize() << ", ";
+    try {
+        missingModelDataFuture.get();
+        result << "returned";
+    }
+    catch(GeneralException& e) {
+        result << "threw";
+    }
+    expected << "0 1 0, 1 3 3, threw";
+    CompareResult(ERROR_INFO, expected, result, failedCount);
+    
+    modelDataPtr.reset();
+    modelDataFuture = std::shared_future<ModelDataPtr>();
+    ResourceReclaimer::ReclaimAll();
+    std::filesystem::remove(filePath);
+    return failedCount;
+}
+
+};
@@ -0,0 +1,25 @@
+#ifndef ASYNC_LOADING_TESTS_H
+#define ASYNC_LOADING_TESTS_H
+
+#include <iostream>
+#include <string>
+#include <fileio/async_loader.h>
+#include <graphics/texture/texture_data.h>
+#include <graphics/model/model_converter.h>
+#include <graphics/buffer/geometry_heap.h>
+#include <graphics/buffer/resource_reclaimer.h>
+#include <headless_gl.h>
+#include <test_exception.h>
+#include <test_comparison.h>
+
+namespace Tests::AsyncLoadingTests {
+
+int DoTests();
+int TestAsyncLoaderQueues();
+int TestAsyncTextureLoad();
+int TestStaleAsyncTextureLoads();
+int TestAsyncModelLoad();
+
+};
+
+#endif //ASYNC_LOADING_TESTS_H
@@ -0,0 +1,182 @@
+#include "block_compression_tests.h"
+
+using namespace Engine;
+
+namespace Tests::BlockCompressionTests {
+
+int DoTests() {
+    int failedCount = 0;
+    
+    failedCount += TestExactBlocks();
+    failedCount += TestCompressionQuality();
+    failedCount += TestParallelCompression();
+    failedCount += TestCompressedUpload();
+    
+    return failedCount;
+}
+
+/*
+ * Returns a width by height image of smooth gradients with numChannels channels.
+ */
+static std::vector<unsigned char> createGradientImage(const unsigned int width, const unsigned int height, const unsigned int numChannels) {
+    std::vector<unsigned char> pixels;
+    for(unsigned int y = 0; y < height; y++) {
+        for(unsigned int x = 0; x < width; x++) {
+            unsigned char values[4] = {(unsigned char)(x * 255 / width), (unsigned char)(y * 255 / height),
+                    (unsigned char)((x + y) * 127 / (width + height)), (unsigned char)(255 - x * 127 / width)};
+            pixels.insert(pixels.end(), values, values + numChannels);
+        }
+    }
+    return pixels;
+}
+
+static double compressionPSNR(const std::vector<unsigned char>& pixels, const unsigned int width, const unsigned int height,
+        const unsigned int numChannels, const CompressedFormat format, const CompressionQuality quality) {
+    SharedBuffer<unsigned char> blocks = BlockCompressor::CompressImage(pixels.data(), width, height, numChannels, format, quality);
+    std::vector<unsigned char> decoded = BlockCompressor::DecompressImage(blocks.data(), width, height, format, numChannels);
+    return BlockCompressor::ComputePSNR(pixels.data(), decoded.data(), pixels.size());
+}
+
+int TestExactBlocks() {
+    std::stringstream result;
+    std::stringstream expected;
+    int failedCount = 0;
+    
+    // Colors that the endpoints can store exactly survive every format, including partial blocks at the edges
+    result = std::stringstream();
+    expected = std::stringstream();
+    std::vector<unsigned char> red;
+    std::vector<unsigned char> odd;
+    std::vector<unsigned char> checkered;
+    for(unsigned int i = 0; i < 5 * 3; i++) {
+        red.insert(red.end(), {255, 0, 0});
+        odd.insert(odd.end(), {201, 101, 51, 255});
+        checkered.insert(checkered.end(), {255, 255, 255, (unsigned char)((i % 2 == 0) ? 0 : 255)});
+    }
+    SharedBuffer<unsigned char> bc1Blocks = BlockCompressor::CompressImage(red.data(), 5, 3, 3, COMPRESSED_FORMAT_BC1, COMPRESSION_QUALITY_FAST);
+    SharedBuffer<unsigned char> bc7Blocks = BlockCompressor::CompressImage(odd.data(), 5, 3, 4, COMPRESSED_FORMAT_BC7, COMPRESSION_QUALITY_NORMAL);
+    result << bc1Blocks.getSize() << " " << bc7Blocks.getSize() << ", " << BlockCompressor::GetCompressedSize(5, 3, COMPRESSED_FORMAT_BC1) << " "
+            << BlockCompressor::GetCompressedSize(1, 1, COMPRESSED_FORMAT_BC5) << ", "
+            << compressionPSNR(red, 5, 3, 3, COMPRESSED_FORMAT_BC1, COMPRESSION_QUALITY_NORMAL) << " "
+            << compressionPSNR(odd, 5, 3, 4, COMPRESSED_FORMAT_BC7, COMPRESSION_QUALITY_HIGH) << " "
+            << compressionPSNR(checkered, 5, 3, 4, COMPRESSED_FORMAT_BC3, COMPRESSION_QUALITY_FAST);
+    expected << "16 32, 16 16, inf inf inf";
+    CompareResult(ERROR_INFO, expected, result, failedCount);
+    
+    // Only the stored channels are decoded, with grey images compressed as RGB
+    result = std::stringstream();
+    expected = std::stringstream();
+    std::vector<unsigned char> grey(16, 136);
+    SharedBuffer<unsigned char> bc5Blocks = BlockCompressor::CompressImage(odd.data(), 4, 1, 4, COMPRESSED_FORMAT_BC5, COMPRESSION_QUALITY_HIGH);
+    std::vector<unsigned char> bc5Pixels = BlockCompressor::DecompressImage(bc5Blocks.data(), 4, 1, COMPRESSED_FORMAT_BC5, 4);
+    SharedBuffer<unsigned char> greyBlocks = BlockCompressor::CompressImage(grey.data(), 4, 4, 1, COMPRESSED_FORMAT_BC1, COMPRESSION_QUALITY_HIGH);
+    std::vector<unsigned char> greyPixels = BlockCompressor::DecompressImage(greyBlocks.data(), 4, 4, COMPRESSED_FORMAT_BC1, 3);
+    result << (int)bc5Pixels[0] << " " << (int)bc5Pixels[1] << " " << (int)bc5Pixels[2] << " " << (int)bc5Pixels[3] << ", "
+            << (int)greyPixels[0] << " " << (int)greyPixels[1] << " " << (int)greyPixels[2] << ", "
+            << BlockCompressor::GetNumChannels(COMPRESSED_FORMAT_BC1) << " " << BlockCompressor::GetNumChannels(COMPRESSED_FORMAT_BC5) << " "
+            << BlockCompressor::GetNumChannels(COMPRESSED_FORMAT_BC7);
+    expected << "201 101 0 255, 140 138 140, 3 2 4";
+    CompareResult(ERROR_INFO, expected, result, failedCount);
+    
+    return failedCount;
+}
+
+int TestCompressionQuality() {
+    std::stringstream result;
+    std::stringstream expected;
+    int failedCount = 0;
+    
+    // Slower presets never lose quality, and the formats with more bits per pixel do better
+    result = std::stringstream();
+    expected = std::stringstream();
+    std::vector<unsigned char> rgbPixels = createGradientImage(32, 32, 3);
+    std::vector<unsigned char> rgPixels = createGradientImage(32, 32, 2);
+    std::vector<unsigned char> rgbaPixels = createGradientImage(32, 32, 4);
+    double bc1Fast = compressionPSNR(rgbPixels, 32, 32, 3, COMPRESSED_FORMAT_BC1, COMPRESSION_QUALITY_FAST);
+    double bc1Normal = compressionPSNR(rgbPixels, 32, 32, 3, COMPRESSED_FORMAT_BC1, COMPRESSION_QUALITY_NORMAL);
+    double bc1High = compressionPSNR(rgbPixels, 32, 32, 3, COMPRESSED_FORMAT_BC1, COMPRESSION_QUALITY_HIGH);
+    double bc3Normal = compressionPSNR(rgbaPixels, 32, 32, 4, COMPRESSED_FORMAT_BC3, COMPRESSION_QUALITY_NORMAL);
+    double bc5Normal = compressionPSNR(rgPixels, 32, 32, 2, COMPRESSED_FORMAT_BC5, COMPRESSION_QUALITY_NORMAL);
+    double bc5High = compressionPSNR(rgPixels, 32, 32, 2, COMPRESSED_FORMAT_BC5, COMPRESSION_QUALITY_HIGH);
+    double bc7Normal = compressionPSNR(rgbaPixels, 32, 32, 4, COMPRESSED_FORMAT_BC7, COMPRESSION_QUALITY_NORMAL);
+    double bc7High = compressionPSNR(rgbaPixels, 32, 32, 4, COMPRESSED_FORMAT_BC7, COMPRESSION_QUALITY_HIGH);
+    result << (bc1Fast > 30.0) << " " << (bc1High >= bc1Normal) << " " << (bc3Normal > 30.0) << " " << (bc5Normal > 45.0) << " "
+            << (bc5High >= bc5Normal) << " " << (bc7Normal > bc3Normal) << " " << (bc7High >= bc7Normal);
+    expected << "1 1 1 1 1 1 1";
+    CompareResult(ERROR_INFO, expected, result, failedCount);
+    
+    return failedCount;
+}
+
+int TestParallelCompression() {
+    std::stringstream result;
+    std::stringstream expected;
+    int failedCount = 0;
+    
+    // Bands of 16 block rows after the first go to the workers and give the same blocks
+    result = std::stringstream();
+    expected = std::stringstream();
+    std::vector<unsigned char> pixels = createGradientImage(16, 160, 4);
+    AsyncLoadStats initialStats = AsyncLoader::GetStats();
+    SharedBuffer<unsigned char> blocks = BlockCompressor::CompressImage(pixels.data(), 16, 160, 4, COMPRESSED_FORMAT_BC7, COMPRESSION_QUALITY_FAST);
+    unsigned long long numTasksSubmitted = AsyncLoader::GetStats().numTasksSubmitted - initialStats.numTasksSubmitted;
+    // The last band on its own is the first band of its own image
+    SharedBuffer<unsigned char> lastBandBlocks = BlockCompressor::CompressImage(pixels.data() + 16 * 128 * 4, 16, 32, 4, COMPRESSED_FORMAT_BC7,
+            COMPRESSION_QUALITY_FAST);
+    bool lastBandMatches = std::equal(lastBandBlocks.begin(), lastBandBlocks.end(), blocks.begin() + 4 * 32 * 16);
+    result << numTasksSubmitted << " " << blocks.getSize() << " " << lastBandMatches;
+    expected << "2 2560 1";
+    CompareResult(ERROR_INFO, expected, result, failedCount);
+    
+    return failedCount;
+}
+
+int TestCompressedUpload() {
+    std::stringstream result;
+    std::stringstream expected;
+    int failedCount = 0;
+    GeometryHeap::Destroy();
+    HeadlessGL::Reset();
+    MemoryStats initialMemoryStats = TextureLoader::GetMemoryStats();
+    
+    // Every compressed level goes straight to glCompressedTexImage2D
+    result = std::stringstream();
+    expected = std::stringstream();
+    std::vector<unsigned char> pixels = createGradientImage(8, 8, 3);
+    TextureDataPtr textureDataPtr = std::make_shared<TextureData>(8, 8, 3, SharedBuffer<unsigned char>(pixels));
+    textureDataPtr->generateMipLevels(MIPMAP_FILTER_BOX, true);
+    textureDataPtr->compress(COMPRESSED_FORMAT_BC1, COMPRESSION_QUALITY_NORMAL);
+    unsigned int textureID = TextureLoader::LoadTextureFromTextureData(textureDataPtr);
+    TextureLoader::UseLoadedTexture(textureID);
+    TextureLoader::BindTexture(textureID);
+    GLuint textureName = HeadlessGL::GetBoundTexture();
+    TextureUnitState::BindToActiveUnit(0);
+    MemoryStats memoryStats = TextureLoader::GetMemoryStats();
+    result << textureDataPtr->isCompressed() << " " << textureDataPtr->getNumChannels() << " " << textureDataPtr->getSize() << ", "
+            << HeadlessGL::GetCallCount("glCompressedTexImage2D") << " " << HeadlessGL::GetCallCount("glTexImage2D") << " "
+            << HeadlessGL::GetCallCount("glGenerateMipmap") << ", " << HeadlessGL::GetNumTextureLevels(textureName) << " "
+            << (HeadlessGL::GetTextureInternalFormat(textureName, 3) == GL_COMPRESSED_RGB_S3TC_DXT1_EXT) << " "
+            << HeadlessGL::GetTextureLevelSize(textureName, 0) << " " << HeadlessGL::GetTextureLevelSize(textureName, 3) << ", "
+            << memoryStats.hostBytes - initialMemoryStats.hostBytes << " " << memoryStats.deviceBytes - initialMemoryStats.deviceBytes;
+    expected << "1 3 32, 4 0 0, 4 1 32 8, 56 56";
+    CompareResult(ERROR_INFO, expected, result, failedCount);
+    
+    // Dropped compressed copies are read back from OpenGL with their mipmap levels
+    result = std::stringstream();
+    expected = std::stringstream();
+    TextureLoader::SetResidencyPolicy(textureID, RESIDENCY_REFETCH_HOST_COPY);
+    bool droppedHostCopy = !TextureLoader::IsHostResident(textureID);
+    TextureDataPtr readBackPtr = TextureLoader::GetTextureDataPtr(textureID);
+    result << droppedHostCopy << " " << HeadlessGL::GetCallCount("glGetCompressedTexImage") << " " << readBackPtr->isCompressed() << " "
+            << readBackPtr->getMipLevels().size() << " "
+            << std::equal(readBackPtr->getData().begin(), readBackPtr->getData().end(), textureDataPtr->getData().begin()) << " "
+            << std::equal(readBackPtr->getMipLevels()[2].begin(), readBackPtr->getMipLevels()[2].end(), textureDataPtr->getMipLevels()[2].begin());
+    expected << "1 4 1 3 1 1";
+    CompareResult(ERROR_INFO, expected, result, failedCount);
+    
+    TextureLoader::ReleaseLoadedTexture(textureID);
+    ResourceReclaimer::ReclaimAll();
+    return failedCount;
+}
+
+};
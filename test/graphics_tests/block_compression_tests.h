@@ -0,0 +1,24 @@
+#ifndef BLOCK_COMPRESSION_TESTS_H
+#define BLOCK_COMPRESSION_TESTS_H
+
+#include <iostream>
+#include <string>
+#include <graphics/texture/block_compressor.h>
+#include <graphics/texture/texture_data.h>
+#include <graphics/buffer/geometry_heap.h>
+#include <graphics/buffer/resource_reclaimer.h>
+#include <headless_gl.h>
+#include <test_exception.h>
+#include <test_comparison.h>
+
+namespace Tests::BlockCompressionTests {
+
+int DoTests();
+int TestExactBlocks();
+int TestCompressionQuality();
+int TestParallelCompression();
+int TestCompressedUpload();
+
+};
+
+#endif //BLOCK_COMPRESSION_TESTS_H
@@ -0,0 +1,201 @@
+#include "camera_tests.h"
+#include <map>
+#include <cstring>
+
+using namespace Engine;
+
+namespace Tests::CameraTests {
+
+int DoTests() {
+    int failedCount = 0;
+    
+    failedCount += TestCameraMatrices();
+    failedCount += TestCameraCaching();
+    failedCount += TestFrustum();
+    failedCount += TestFrameConstants();
+    
+    return failedCount;
+}
+
+static const float tolerance = 1e-4f;
+
+int TestCameraMatrices() {
+    std::stringstream result;
+    std::stringstream expected;
+    int failedCount = 0;
+    
+    // A camera at the origin doesn't move the scene, and projects as the old fixed projection did
+    result = std::stringstream();
+    expected = std::stringstream();
+    Camera camera(Math::toRadians(45.0f), 1.5f, 1.0f, 100.0f);
+    Math::Mat4f identity(1.0f);
+    result << Math::equalsTol(camera.getViewMatrix(), identity, tolerance) << Math::equalsTol(camera.getInverseViewMatrix(), identity, tolerance) << " "
+            << Math::equalsTol(camera.getProjectionMatrix(), Math::createPerspectiveProjectionMat(Math::toRadians(45.0f), 1.5f, 1.0f, 100.0f), tolerance) << " "
+            << Math::equalsTol((Math::Mat4f)(camera.getProjectionMatrix() * camera.getInverseProjectionMatrix()), identity, tolerance);
+    expected << "11 1 1";
+    CompareResult(ERROR_INFO, expected, result, failedCount);
+    
+    // Each inverse undoes its matrix wherever the camera is and however it's turned
+    result = std::stringstream();
+    expected = std::stringstream();
+    camera.setPosition(Math::createVec3<float>(3.0f, -2.0f, 5.0f));
+    camera.setOrientation(Math::Quatf(Math::createVec3<float>(0.0f, 1.0f, 1.0f).normalize(), Math::toRadians(30.0f)));
+    result << Math::equalsTol((Math::Mat4f)(camera.getViewMatrix() * camera.getInverseViewMatrix()), identity, tolerance)
+            << Math::equalsTol((Math::Mat4f)(camera.getViewProjectionMatrix() * camera.getInverseViewProjectionMatrix()), identity, tolerance)
+            << Math::equalsTol(camera.getViewProjectionMatrix(), (Math::Mat4f)(camera.getProjectionMatrix() * camera.getViewMatrix()), tolerance) << " ";
+    
+    // The view matrix moves the camera to the origin and turns its forward to negative z
+    Math::Vec4f cameraPosition = camera.getViewMatrix() * Math::createVec4<float>(3.0f, -2.0f, 5.0f, 1.0f);
+    Math::Vec4f forward = camera.getInverseViewMatrix() * Math::createVec4<float>(0.0f, 0.0f, -1.0f, 0.0f);
+    Math::Vec4f expectedForward = camera.getOrientation().toRotationMatrix() * Math::createVec4<float>(0.0f, 0.0f, -1.0f, 0.0f);
+    result << Math::equalsTol(cameraPosition, Math::createVec4<float>(0.0f, 0.0f, 0.0f, 1.0f), tolerance) << Math::equalsTol(forward, expectedForward, tolerance);
+    expected << "111 11";
+    CompareResult(ERROR_INFO, expected, result, failedCount);
+    
+    return failedCount;
+}
+
+int TestCameraCaching() {
+    std::stringstream result;
+    std::stringstream expected;
+    int failedCount = 0;
+    
+    // Matrices are worked out once, however often they're read
+    result = std::stringstream();
+    expected = std::stringstream();
+    Camera camera;
+    for(unsigned int i = 0; i < 10; i++) {
+        camera.getViewProjectionMatrix();
+        camera.getInverseViewProjectionMatrix();
+        camera.getFrustum();
+    }
+    result << camera.getStats().viewUpdates << camera.getStats().projectionUpdates << camera.getStats().viewProjectionUpdates << camera.getStats().frustumUpdates << " ";
+    
+    // Setting what they already are, or an empty framebuffer, changes nothing
+    camera.setPosition(camera.getPosition());
+    camera.setAspectRatio(camera.getAspectRatio());
+    camera.setFramebufferSize(0, 0);
+    camera.getFrustum();
+    result << camera.getStats().viewUpdates << camera.getStats().projectionUpdates << camera.getStats().viewProjectionUpdates << camera.getStats().frustumUpdates << " ";
+    
+    // Resizing only works out the projection again
+    camera.setFramebufferSize(800, 400);
+    camera.getFrustum();
+    camera.getFrustum();
+    result << camera.getAspectRatio() << " " << camera.getStats().viewUpdates << camera.getStats().projectionUpdates << camera.getStats().viewProjectionUpdates
+            << camera.getStats().frustumUpdates << " ";
+    
+    // Moving only works out the view again, and nothing is worked out until read
+    camera.setPosition(Math::createVec3<float>(1.0f, 0.0f, 0.0f));
+    camera.setPosition(Math::createVec3<float>(2.0f, 0.0f, 0.0f));
+    result << camera.getStats().viewUpdates << " ";
+    camera.getViewProjectionMatrix();
+    result << camera.getStats().viewUpdates << camera.getStats().projectionUpdates << camera.getStats().viewProjectionUpdates << camera.getStats().frustumUpdates;
+    expected << "1111 1111 2 1222 1 2232";
+    CompareResult(ERROR_INFO, expected, result, failedCount);
+    
+    return failedCount;
+}
+
+int TestFrustum() {
+    std::stringstream result;
+    std::stringstream expected;
+    int failedCount = 0;
+    
+    // Only what's in front of the camera between its near and far planes is inside
+    result = std::stringstream();
+    expected = std::stringstream();
+    Camera camera(Math::toRadians(45.0f), 1.0f, 1.0f, 100.0f);
+    const Frustum& frustum = camera.getFrustum();
+    result << frustum.intersectsSphere(Math::createVec3<float>(0.0f, 0.0f, -10.0f), 1.0f) << frustum.intersectsSphere(Math::createVec3<float>(0.0f, 0.0f, 10.0f), 1.0f)
+            << frustum.intersectsSphere(Math::createVec3<float>(0.0f, 0.0f, -200.0f), 1.0f)
+            << frustum.intersectsSphere(Math::createVec3<float>(1000.0f, 0.0f, -10.0f), 1.0f)
+            << frustum.intersectsSphere(Math::createVec3<float>(0.0f, 0.0f, -101.0f), 2.0f) << " ";
+    result << frustum.intersectsBox(Math::createVec3<float>(-1.0f, -1.0f, -20.0f), Math::createVec3<float>(1.0f, 1.0f, -10.0f))
+            << frustum.intersectsBox(Math::createVec3<float>(-1.0f, -1.0f, 1.0f), Math::createVec3<float>(1.0f, 1.0f, 5.0f))
+            << frustum.intersectsBox(Math::createVec3<float>(-1000.0f, -1.0f, -20.0f), Math::createVec3<float>(1000.0f, 1.0f, -10.0f))
+            << frustum.intersectsBox(Math::createVec3<float>(50.0f, -1.0f, -20.0f), Math::createVec3<float>(60.0f, 1.0f, -10.0f)) << " ";
+    
+    // The planes follow the camera as it turns around and moves
+    camera.setOrientation(Math::Quatf(Math::createVec3<float>(0.0f, 1.0f, 0.0f), Math::toRadians(180.0f)));
+    camera.setPosition(Math::createVec3<float>(0.0f, 0.0f, -50.0f));
+    const Frustum& turnedFrustum = camera.getFrustum();
+    result << turnedFrustum.intersectsSphere(Math::createVec3<float>(0.0f, 0.0f, -10.0f), 1.0f)
+            << turnedFrustum.intersectsSphere(Math::createVec3<float>(0.0f, 0.0f, -60.0f), 1.0f);
+    expected << "10001 1010 10";
+    CompareResult(ERROR_INFO, expected, result, failedCount);
+    
+    return failedCount;
+}
+
+static const std::map<std::string, std::string> shaderSources = {
+    {"camera.vs.glsl", "#version 430 core\nlayout (std140, row_major) uniform FrameConstants {\n    mat4 viewProjectionMatrix;\n};\nuniform mat4 transform;\n"
+            "void main() { gl_Position = viewProjectionMatrix * transform * vec4(0.0); }\n"},
+    {"camera.fs.glsl", "#version 430 core\nuniform sampler2D texture0;\nout vec4 color;\nvoid main() { color = vec4(1.0); }\n"}
+};
+
+int TestFrameConstants() {
+    std::stringstream result;
+    std::stringstream expected;
+    int failedCount = 0;
+    ShaderLoader::Destroy();
+    GeometryHeap::Destroy();
+    HeadlessGL::Reset();
+    FrameConstants::ResetStats();
+    
+    // The frame's constants are copied once and bound for every draw
+    result = std::stringstream();
+    expected = std::stringstream();
+    Camera camera(Math::toRadians(60.0f), 2.0f, 0.5f, 50.0f);
+    camera.setPosition(Math::createVec3<float>(1.0f, 2.0f, 3.0f));
+    HeadlessGL::ClearCallLog();
+    FrameConstants::Update(camera);
+    HeadlessGL::BufferRange range = HeadlessGL::GetBoundBufferRange(GL_UNIFORM_BUFFER, FrameConstants::FRAME_CONSTANTS_BINDING);
+    FrameConstantData boundData;
+    std::memcpy(&boundData, HeadlessGL::GetBufferData(range.buffer).data() + range.offset, sizeof(FrameConstantData));
+    const Math::Mat4f& viewProjectionMatrix = camera.getViewProjectionMatrix();
+    bool matches = true;
+    for(unsigned int r = 0; r < 4; r++) {
+        for(unsigned int c = 0; c < 4; c++) {
+            matches = matches && (boundData.viewProjectionMatrix[4 * r + c] == viewProjectionMatrix[r][c]);
+        }
+    }
+    result << (range.buffer == FrameConstants::GetRing().getBufferName()) << " " << range.size << " " << matches << " "
+            << (std::memcmp(boundData.frustumPlanes, FrameConstants::GetData().frustumPlanes, sizeof(boundData.frustumPlanes)) == 0) << " "
+            << boundData.cameraPosition[0] << boundData.cameraPosition[1] << boundData.cameraPosition[2] << boundData.cameraPosition[3] << " "
+            << HeadlessGL::GetCallCount("glBindBufferRange") << " " << camera.getStats().frustumUpdates << ", ";
+    
+    // The next frame's are copied again, and the camera isn't worked out again while it's still
+    FrameConstants::EndFrame();
+    FrameConstants::Update(camera);
+    result << FrameConstants::GetStats().numUpdates << " " << camera.getStats().viewProjectionUpdates << camera.getStats().frustumUpdates;
+    expected << "1 368 1 1 1231 1 1, 2 11";
+    CompareResult(ERROR_INFO, expected, result, failedCount);
+    
+    // Programs reading the camera have their block bound to the frame's constants once their material is applied
+    result = std::stringstream();
+    expected = std::stringstream();
+    ShaderLoader::GetShaderPreprocessor() = ShaderPreprocessor([](const std::string& filePath, std::string& source) {
+        std::map<std::string, std::string>::const_iterator iter = shaderSources.find(filePath);
+        if(iter == shaderSources.end()) {
+            return false;
+        }
+        source = iter->second;
+        return true;
+    });
+    ShaderLoader::LoadShaderPrograms({{"camera", "camera.vs.glsl", "", "camera.fs.glsl"}});
+    TextureDataPtr textureDataPtr = std::make_shared<TextureData>(4, 1, 4, SharedBuffer<unsigned char>(std::vector<unsigned char>(16, 255)));
+    TexturedMaterial texturedMaterial("camera", {Texture(textureDataPtr, TEXTURE_DIFFUSE)}, {1.0f});
+    texturedMaterial.apply();
+    result << HeadlessGL::GetUniformBlockBinding(ShaderLoader::getShaderProgram("camera")->getProgram(), "FrameConstants") << " " << HeadlessGL::GetNumErrors();
+    expected << "1 0";
+    CompareResult(ERROR_INFO, expected, result, failedCount);
+    
+    FrameConstants::Destroy();
+    MaterialParameterBlock::Destroy();
+    ShaderLoader::Destroy();
+    ShaderLoader::GetShaderPreprocessor() = ShaderPreprocessor();
+    return failedCount;
+}
+
+}
@@ -0,0 +1,25 @@
+#ifndef CAMERA_TESTS_H
+#define CAMERA_TESTS_H
+
+#include <iostream>
+#include <string>
+#include <graphics/camera/camera.h>
+#include <graphics/camera/frame_constants.h>
+#include <graphics/shaders/shaders.h>
+#include <graphics/material/material.h>
+#include <graphics/buffer/geometry_heap.h>
+#include <headless_gl.h>
+#include <test_exception.h>
+#include <test_comparison.h>
+
+namespace Tests::CameraTests {
+
+int DoTests();
+int TestCameraMatrices();
+int TestCameraCaching();
+int TestFrustum();
+int TestFrameConstants();
+
+};
+
+#endif //CAMERA_TESTS_H
@@ -0,0 +1,199 @@
+#include "deferred_release_tests.h"
+
+using namespace Engine;
+using namespace Engine::Math;
+
+namespace Tests::DeferredReleaseTests {
+
+int DoTests() {
+    int failedCount = 0;
+    
+    failedCount += TestDeferredReleaseQueue();
+    failedCount += TestPendingByteBudget();
+    failedCount += TestTextureReleaseHysteresis();
+    failedCount += TestMeshReleaseHysteresis();
+    failedCount += TestThrashEvents();
+    
+    return failedCount;
+}
+
+static std::string toString(const std::vector<unsigned int>& ids) {
+    std::stringstream stream;
+    stream << "[";
+    for(unsigned int i = 0; i < ids.size(); i++) {
+        stream << (i == 0 ? "" : ", ") << ids[i];
+    }
+    stream << "]";
+    return stream.str();
+}
+
+int TestDeferredReleaseQueue() {
+    std::stringstream result;
+    std::stringstream expected;
+    int failedCount = 0;
+    
+    result = std::stringstream();
+    expected = std::stringstream();
+    DeferredReleaseQueue releaseQueue;
+    releaseQueue.setReleaseDelayFrames(3);
+    releaseQueue.schedule(7, 100, 0);
+    releaseQueue.schedule(9, 50, 1);
+    result << toString(releaseQueue.collect(2)) << ", " << releaseQueue.getNumPending() << ", " << releaseQueue.getPendingBytes() << ", ";
+    result << toString(releaseQueue.collect(3)) << ", " << releaseQueue.getNumPending() << ", " << releaseQueue.getPendingBytes();
+    expected << "[], 2, 150, [7], 1, 50";
+    CompareResult(ERROR_INFO, expected, result, failedCount);
+    
+    // Resurrected resources are never reclaimed
+    result = std::stringstream();
+    expected = std::stringstream();
+    result << releaseQueue.resurrect(9) << ", " << releaseQueue.resurrect(9) << ", " << toString(releaseQueue.collect(100)) << ", ";
+    releaseQueue.schedule(9, 50, 10);
+    releaseQueue.schedule(3, 10, 10);
+    result << releaseQueue.isPending(9) << ", " << releaseQueue.remove(9) << ", " << releaseQueue.isPending(9) << ", "
+            << toString(releaseQueue.collect(10, true));
+    expected << "1, 0, [], 1, 1, 0, [3]";
+    CompareResult(ERROR_INFO, expected, result, failedCount);
+    
+    result = std::stringstream();
+    expected = std::stringstream();
+    const DeferredReleaseStats& stats = releaseQueue.getStats();
+    result << stats.deferredReleases << ", " << stats.resurrections << ", " << stats.reclaims << ", " << stats.pressureReclaims;
+    expected << "4, 1, 2, 1";
+    CompareResult(ERROR_INFO, expected, result, failedCount);
+    
+    return failedCount;
+}
+
+int TestPendingByteBudget() {
+    std::stringstream result;
+    std::stringstream expected;
+    int failedCount = 0;
+    
+    // Over budget the oldest released resources are reclaimed first, regardless of the release delay
+    result = std::stringstream();
+    expected = std::stringstream();
+    DeferredReleaseQueue releaseQueue;
+    releaseQueue.setReleaseDelayFrames(1000);
+    releaseQueue.setPendingByteBudget(100);
+    releaseQueue.schedule(1, 60, 0);
+    releaseQueue.schedule(2, 30, 1);
+    result << toString(releaseQueue.collect(1)) << ", ";
+    releaseQueue.schedule(3, 60, 2);
+    result << toString(releaseQueue.collect(2)) << ", " << releaseQueue.getPendingBytes() << ", " << releaseQueue.getStats().pressureReclaims;
+    expected << "[], [1], 90, 1";
+    CompareResult(ERROR_INFO, expected, result, failedCount);
+    
+    return failedCount;
+}
+
+int TestTextureReleaseHysteresis() {
+    std::stringstream result;
+    std::stringstream expected;
+    int failedCount = 0;
+    GeometryHeap::Destroy();
+    HeadlessGL::Reset();
+    ResourceReclaimer::SetReleaseDelayFrames(2);
+    ResourceReclaimer::ResetStats();
+    
+    // Releasing and using a texture again on the same frame keeps its OpenGL texture
+    result = std::stringstream();
+    expected = std::stringstream();
+    TextureDataPtr textureDataPtr = std::make_shared<TextureData>(4, 2, 3, SharedBuffer<unsigned char>(std::vector<unsigned char>(24, 255)));
+    unsigned int textureID = TextureLoader::LoadTextureFromTextureData(textureDataPtr);
+    TextureLoader::UseLoadedTexture(textureID);
+    TextureLoader::ReleaseLoadedTexture(textureID);
+    TextureLoader::UseLoadedTexture(textureID);
+    result << HeadlessGL::GetCallCount("glGenTextures") << ", " << HeadlessGL::GetCallCount("glDeleteTextures") << ", "
+            << HeadlessGL::GetNumLiveTextures() << ", " << ResourceReclaimer::GetStats().resurrections;
+    expected << "1, 0, 1, 1";
+    CompareResult(ERROR_INFO, expected, result, failedCount);
+    
+    // Only reclaimed once unused for the release delay
+    result = std::stringstream();
+    expected = std::stringstream();
+    TextureLoader::ReleaseLoadedTexture(textureID);
+    ResourceReclaimer::EndFrame();
+    result << HeadlessGL::GetNumLiveTextures() << ", ";
+    ResourceReclaimer::EndFrame();
+    result << HeadlessGL::GetNumLiveTextures() << ", " << TextureLoader::GetReleaseQueue().getNumPending() << ", "
+            << ResourceReclaimer::GetStats().reclaims;
+    expected << "1, 0, 0, 1";
+    CompareResult(ERROR_INFO, expected, result, failedCount);
+    
+    ResourceReclaimer::SetReleaseDelayFrames(120);
+    return failedCount;
+}
+
+int TestMeshReleaseHysteresis() {
+    std::stringstream result;
+    std::stringstream expected;
+    int failedCount = 0;
+    GeometryHeap::Destroy();
+    HeadlessGL::Reset();
+    ResourceReclaimer::SetReleaseDelayFrames(2);
+    ResourceReclaimer::ResetStats();
+    
+    result = std::stringstream();
+    expected = std::stringstream();
+    unsigned int meshID = 0;
+    {
+        MeshDataPtr meshDataPtr = std::make_shared<MeshData>(SharedBuffer<unsigned int>(std::vector<unsigned int>({0, 1, 2})),
+                CreateTestMeshGeometryData(3));
+        meshID = MeshLoader::LoadMeshFromMeshData(meshDataPtr);
+    }
+    MeshLoader::UseLoadedMesh(meshID);
+    MeshLoader::ReleaseLoadedMesh(meshID);
+    MeshLoader::UseLoadedMesh(meshID);
+    const TLSFAllocator& vertexAllocator = GeometryHeap::GetVertexHeap(VERTEX_FORMAT_POSITION_NORMAL_TEXCOORD).getAllocator();
+    const TLSFAllocator& indexAllocator = GeometryHeap::GetIndexHeap().getAllocator();
+    result << HeadlessGL::GetCallCount("glBufferSubData") << ", " << vertexAllocator.getNumAllocations() << ", " << indexAllocator.getNumAllocations();
+    expected << "2, 1, 1";
+    CompareResult(ERROR_INFO, expected, result, failedCount);
+    
+    // Memory pressure reclaims the mesh straight away, and unloading it unloads its geometry
+    result = std::stringstream();
+    expected = std::stringstream();
+    MeshLoader::ReleaseLoadedMesh(meshID);
+    result << vertexAllocator.getNumAllocations() << ", " << indexAllocator.getNumAllocations() << ", ";
+    ResourceReclaimer::ReclaimAll();
+    result << vertexAllocator.getNumAllocations() << ", " << indexAllocator.getNumAllocations() << ", " << ResourceReclaimer::GetStats().reclaims;
+    expected << "1, 1, 0, 0, 1";
+    CompareResult(ERROR_INFO, expected, result, failedCount);
+    
+    ResourceReclaimer::SetReleaseDelayFrames(120);
+    return failedCount;
+}
+
+int TestThrashEvents() {
+    std::stringstream result;
+    std::stringstream expected;
+    int failedCount = 0;
+    GeometryHeap::Destroy();
+    HeadlessGL::Reset();
+    ResourceReclaimer::SetReleaseDelayFrames(1);
+    ResourceReclaimer::ResetStats();
+    
+    // Buffering again after the buffer was reclaimed counts as a thrash event
+    result = std::stringstream();
+    expected = std::stringstream();
+    unsigned int meshGeometryID = MeshGeometryLoader::LoadMeshFromMeshGeometryData(CreateTestMeshGeometryData(4), "deferred_release_thrash.dae");
+    MeshGeometryLoader::UseLoadedMeshGeometry(meshGeometryID);
+    MeshGeometryLoader::RequireMeshGeometryBuffered(meshGeometryID);
+    MeshGeometryLoader::RelaxMeshGeometryBuffered(meshGeometryID);
+    MeshGeometryLoader::RequireMeshGeometryBuffered(meshGeometryID);
+    result << ResourceReclaimer::GetStats().thrashEvents << ", ";
+    MeshGeometryLoader::RelaxMeshGeometryBuffered(meshGeometryID);
+    ResourceReclaimer::EndFrame();
+    MeshGeometryLoader::RequireMeshGeometryBuffered(meshGeometryID);
+    result << ResourceReclaimer::GetStats().thrashEvents << ", " << HeadlessGL::GetCallCount("glBufferSubData");
+    expected << "0, 1, 2";
+    CompareResult(ERROR_INFO, expected, result, failedCount);
+    MeshGeometryLoader::RelaxMeshGeometryBuffered(meshGeometryID);
+    MeshGeometryLoader::ReleaseLoadedMeshGeometry(meshGeometryID);
+    ResourceReclaimer::ReclaimAll();
+    
+    ResourceReclaimer::SetReleaseDelayFrames(120);
+    return failedCount;
+}
+
+};
@@ -0,0 +1,26 @@
+#ifndef DEFERRED_RELEASE_TESTS_H
+#define DEFERRED_RELEASE_TESTS_H
+
+#include <iostream>
+#include <string>
+#include <graphics/buffer/deferred_release_queue.h>
+#include <graphics/buffer/resource_reclaimer.h>
+#include <graphics/mesh/mesh_data.h>
+#include <graphics/texture/texture_data.h>
+#include <headless_gl.h>
+#include <test_exception.h>
+#include <test_comparison.h>
+#include <test_meshes.h>
+
+namespace Tests::DeferredReleaseTests {
+
+int DoTests();
+int TestDeferredReleaseQueue();
+int TestPendingByteBudget();
+int TestTextureReleaseHysteresis();
+int TestMeshReleaseHysteresis();
+int TestThrashEvents();
+
+};
+
+#endif //DEFERRED_RELEASE_TESTS_H
@@ -0,0 +1,208 @@
+#include "entity_world_tests.h"
+#include <atomic>
+
+using namespace Engine;
+using namespace Engine::Math;
+
+namespace Tests::EntityWorldTests {
+
+int DoTests() {
+    int failedCount = 0;
+    
+    failedCount += TestEntityLifecycle();
+    failedCount += TestComponentChanges();
+    failedCount += TestParallelIteration();
+    failedCount += TestCullingAndDrawing();
+    
+    return failedCount;
+}
+
+static const ComponentMask RENDERABLE_MASK = componentBit(COMPONENT_TRANSFORM) | componentBit(COMPONENT_BOUNDS) | componentBit(COMPONENT_MESH)
+        | componentBit(COMPONENT_MATERIAL) | componentBit(COMPONENT_VISIBILITY);
+
+int TestEntityLifecycle() {
+    std::stringstream result;
+    std::stringstream expected;
+    int failedCount = 0;
+    
+    // Entities with the same components share an archetype, packed into chunks
+    result = std::stringstream();
+    expected = std::stringstream();
+    EntityWorld world(1);
+    std::vector<Entity> entities;
+    for(unsigned int i = 0; i < 300; i++) {
+        Entity entity = world.createEntity(componentBit(COMPONENT_TRANSFORM) | componentBit(COMPONENT_MESH));
+        world.getComponent<MeshComponent>(entity).meshID = i;
+        entities.push_back(entity);
+    }
+    Entity boundedEntity = world.createEntity(componentBit(COMPONENT_BOUNDS));
+    EntityWorldStats stats = world.getStats();
+    result << stats.numEntities << " " << stats.numArchetypes << " " << stats.numChunks << " " << world.getComponent<TransformComponent>(entities[0]).transform[0][0]
+            << world.getComponent<TransformComponent>(entities[0]).transform[0][1] << " "
+            << (world.getComponentMask(boundedEntity) == componentBit(COMPONENT_BOUNDS));
+    expected << "301 2 4 10 1";
+    CompareResult(ERROR_INFO, expected, result, failedCount);
+    
+    // Destroying an entity moves the archetype's last entity into its place, keeping the chunks full
+    result = std::stringstream();
+    expected = std::stringstream();
+    for(unsigned int i = 0; i < 200; i++) {
+        world.destroyEntity(entities[i]);
+    }
+    unsigned int numMoved = 0;
+    for(unsigned int i = 200; i < 300; i++) {
+        numMoved += (world.getComponent<MeshComponent>(entities[i]).meshID == i);
+    }
+    unsigned int numFullChunks = 0;
+    world.forEachChunk(componentBit(COMPONENT_MESH), [&numFullChunks](EntityChunk& chunk) { numFullChunks += chunk.isFull(); });
+    result << world.getNumEntities() << " " << world.getStats().numChunks << " " << numFullChunks << " " << numMoved << " " << world.isAlive(entities[0])
+            << world.isAlive(entities[299]) << " ";
+    
+    // Slots are reused with a new generation, so old handles stay dead
+    Entity reused = world.createEntity(componentBit(COMPONENT_TRANSFORM));
+    result << (reused.index == entities[199].index) << (reused.generation == entities[199].generation + 1) << world.isAlive(entities[199]) << world.isAlive(reused);
+    expected << "101 2 0 100 01 1101";
+    CompareResult(ERROR_INFO, expected, result, failedCount);
+    
+    return failedCount;
+}
+
+int TestComponentChanges() {
+    std::stringstream result;
+    std::stringstream expected;
+    int failedCount = 0;
+    
+    // Adding or removing components moves the entity to another archetype keeping the components it still has
+    result = std::stringstream();
+    expected = std::stringstream();
+    EntityWorld world(1);
+    Entity entity = world.createEntity(componentBit(COMPONENT_TRANSFORM) | componentBit(COMPONENT_MESH));
+    Entity other = world.createEntity(componentBit(COMPONENT_TRANSFORM) | componentBit(COMPONENT_MESH));
+    world.getComponent<TransformComponent>(entity).transform = createTranslationMat(createVec3<float>(4.0f, 5.0f, 6.0f));
+    world.getComponent<MeshComponent>(entity).meshID = 7;
+    world.getComponent<MeshComponent>(other).meshID = 8;
+    world.addComponents(entity, componentBit(COMPONENT_VISIBILITY));
+    world.getComponent<VisibilityComponent>(entity).hidden = true;
+    result << world.getComponent<TransformComponent>(entity).transform[1][3] << " " << world.getComponent<MeshComponent>(entity).meshID << " "
+            << world.getComponent<VisibilityComponent>(entity).visible << " " << world.getComponent<MeshComponent>(other).meshID << " ";
+    world.removeComponents(entity, componentBit(COMPONENT_MESH));
+    result << (world.getComponentMask(entity) == (componentBit(COMPONENT_TRANSFORM) | componentBit(COMPONENT_VISIBILITY)))
+            << world.getComponent<VisibilityComponent>(entity).hidden << " " << world.getComponent<TransformComponent>(entity).transform[2][3] << " "
+            << world.getStats().numArchetypes << " " << world.getStats().numChunks;
+    expected << "5 7 1 8 11 6 3 2";
+    CompareResult(ERROR_INFO, expected, result, failedCount);
+    
+    return failedCount;
+}
+
+int TestParallelIteration() {
+    std::stringstream result;
+    std::stringstream expected;
+    int failedCount = 0;
+    
+    // Every chunk with the components is visited once, whichever thread visits it
+    result = std::stringstream();
+    expected = std::stringstream();
+    EntityWorld world(4);
+    const unsigned int numEntities = 5000;
+    for(unsigned int i = 0; i < numEntities; i++) {
+        ComponentMask mask = componentBit(COMPONENT_MESH) | ((i % 3 == 0) ? componentBit(COMPONENT_BOUNDS) : 0);
+        world.getComponent<MeshComponent>(world.createEntity(mask)).meshID = i;
+    }
+    std::atomic<unsigned int> numChunks(0);
+    world.parallelForEachChunk(componentBit(COMPONENT_MESH), [&numChunks](EntityChunk& chunk) {
+        MeshComponent* meshes = chunk.getComponents<MeshComponent>();
+        for(unsigned int i = 0; i < chunk.getSize(); i++) {
+            meshes[i].meshID += 1;
+        }
+        numChunks++;
+    });
+    unsigned long long sum = 0;
+    unsigned int numBounded = 0;
+    world.forEachChunk(componentBit(COMPONENT_MESH), [&sum](EntityChunk& chunk) {
+        const MeshComponent* meshes = chunk.getComponents<MeshComponent>();
+        for(unsigned int i = 0; i < chunk.getSize(); i++) {
+            sum += meshes[i].meshID;
+        }
+    });
+    world.forEachChunk(componentBit(COMPONENT_BOUNDS), [&numBounded](EntityChunk& chunk) { numBounded += chunk.getSize(); });
+    result << numChunks << " " << sum << " " << numBounded;
+    expected << world.getStats().numChunks << " " << (unsigned long long)numEntities * (numEntities + 1) / 2 << " " << (numEntities + 2) / 3;
+    CompareResult(ERROR_INFO, expected, result, failedCount);
+    
+    return failedCount;
+}
+
+int TestCullingAndDrawing() {
+    std::stringstream result;
+    std::stringstream expected;
+    int failedCount = 0;
+    GeometryHeap::Destroy();
+    HeadlessGL::Reset();
+    
+    unsigned int meshIDs[2] = {};
+    for(unsigned int i = 0; i < 2; i++) {
+        meshIDs[i] = MeshLoader::LoadMeshFromMeshData(CreateTestMeshData(3 * (i + 1)));
+        MeshLoader::UseLoadedMesh(meshIDs[i]);
+    }
+    
+    // Entities are visible when their transformed bounds are in view and they aren't hidden
+    result = std::stringstream();
+    expected = std::stringstream();
+    EntityWorld world(2);
+    unsigned int materialA = world.addMaterial(TexturedMaterial());
+    unsigned int materialB = world.addMaterial(TexturedMaterial());
+    Camera camera(toRadians(45.0f), 1.0f, 1.0f, 100.0f);
+    float positions[6] = {-10.0f, 10.0f, -20.0f, -30.0f, -500.0f, -40.0f};
+    std::vector<Entity> entities;
+    for(unsigned int i = 0; i < 6; i++) {
+        Entity entity = world.createEntity(RENDERABLE_MASK);
+        world.getComponent<TransformComponent>(entity).transform = createTranslationMat(createVec3<float>(0.0f, 0.0f, positions[i]));
+        world.getComponent<BoundsComponent>(entity).boundsMin = Vec3f(-1.0f);
+        world.getComponent<BoundsComponent>(entity).boundsMax = Vec3f(1.0f);
+        world.getComponent<MeshComponent>(entity).meshID = meshIDs[i % 2];
+        world.getComponent<MaterialComponent>(entity).materialHandle = (i < 3) ? materialA : materialB;
+        entities.push_back(entity);
+    }
+    world.getComponent<VisibilityComponent>(entities[5]).hidden = true;
+    unsigned int numVisible = CullingSystem::UpdateVisibility(world, camera.getFrustum());
+    result << numVisible << " ";
+    for(unsigned int i = 0; i < 6; i++) {
+        result << world.getComponent<VisibilityComponent>(entities[i]).visible;
+    }
+    
+    // A rotated box is bounded by the box around its corners
+    Vec3f worldBoundsMin;
+    Vec3f worldBoundsMax;
+    CullingSystem::TransformBounds(createRotationMat(createVec3<float>(0.0f, 0.0f, 1.0f), toRadians(45.0f)), Vec3f(-1.0f), Vec3f(1.0f), worldBoundsMin, worldBoundsMax);
+    result << " " << equalsTol(worldBoundsMax[0], std::sqrt(2.0f), 1e-4f) << equalsTol(worldBoundsMin[1], -std::sqrt(2.0f), 1e-4f)
+            << equalsTol(worldBoundsMax[2], 1.0f, 1e-4f);
+    expected << "3 101100 111";
+    CompareResult(ERROR_INFO, expected, result, failedCount);
+    
+    // The visible entities are drawn batched by material
+    result = std::stringstream();
+    expected = std::stringstream();
+    IndirectDrawStream drawStream(16, 1);
+    unsigned int numDraws = DrawSystem::AddVisibleDraws(world, drawStream);
+    drawStream.build();
+    HeadlessGL::ClearCallLog();
+    drawStream.submit([&result](unsigned int batchKey) { result << batchKey << " "; });
+    const std::vector<HeadlessGL::DrawRecord>& drawLog = HeadlessGL::GetDrawLog();
+    result << ", " << numDraws << " ";
+    for(unsigned int i = 0; i < drawLog.size(); i++) {
+        result << drawLog[i].count << " ";
+    }
+    result << HeadlessGL::GetCallCount("glMultiDrawElementsIndirect") << " " << HeadlessGL::GetNumErrors();
+    expected << "0 1 , 3 3 3 6 2 0";
+    CompareResult(ERROR_INFO, expected, result, failedCount);
+    
+    drawStream.destroy();
+    for(unsigned int i = 0; i < 2; i++) {
+        MeshLoader::ReleaseLoadedMesh(meshIDs[i]);
+    }
+    ResourceReclaimer::ReclaimAll();
+    return failedCount;
+}
+
+}
@@ -0,0 +1,26 @@
+#ifndef ENTITY_WORLD_TESTS_H
+#define ENTITY_WORLD_TESTS_H
+
+#include <iostream>
+#include <string>
+#include <graphics/scene/entity_world.h>
+#include <graphics/scene/scene_systems.h>
+#include <graphics/buffer/geometry_heap.h>
+#include <graphics/buffer/resource_reclaimer.h>
+#include <math/linear_math.h>
+#include <headless_gl.h>
+#include <test_exception.h>
+#include <test_comparison.h>
+#include <test_meshes.h>
+
+namespace Tests::EntityWorldTests {
+
+int DoTests();
+int TestEntityLifecycle();
+int TestComponentChanges();
+int TestParallelIteration();
+int TestCullingAndDrawing();
+
+};
+
+#endif //ENTITY_WORLD_TESTS_H
@@ -0,0 +1,245 @@
+#include "geometry_heap_tests.h"
+
+using namespace Engine;
+using namespace Engine::Math;
+
+namespace Tests::GeometryHeapTests {
+
+int DoTests() {
+    int failedCount = 0;
+    
+    failedCount += TestTLSFAllocate();
+    failedCount += TestTLSFFragmentation();
+    failedCount += TestTLSFDefragment();
+    failedCount += TestGPUBufferHeap();
+    failedCount += TestSharedMeshBuffers();
+    failedCount += TestEmptyMesh();
+    
+    return failedCount;
+}
+
+int TestTLSFAllocate() {
+    std::stringstream result;
+    std::stringstream expected;
+    int failedCount = 0;
+    
+    result = std::stringstream();
+    expected = std::stringstream();
+    TLSFAllocator allocator(1000);
+    size_t offsets[4] = {};
+    for(unsigned int i = 0; i < 4; i++) {
+        result << allocator.allocate(100 * (i + 1), offsets[i]) << " " << offsets[i] << ", ";
+    }
+    size_t offset = 0;
+    result << allocator.allocate(1, offset) << ", " << allocator.getUsedSize() << ", " << allocator.getNumAllocations();
+    expected << "1 0, 1 100, 1 300, 1 600, 0, 1000, 4";
+    CompareResult(ERROR_INFO, expected, result, failedCount);
+    
+    // Freed neighbours merge back into one block
+    result = std::stringstream();
+    expected = std::stringstream();
+    allocator.free(offsets[1]);
+    allocator.free(offsets[3]);
+    allocator.free(offsets[2]);
+    result << allocator.getStats().numFreeBlocks << ", " << allocator.getLargestFreeBlock() << ", "
+            << allocator.allocate(900, offset) << " " << offset;
+    expected << "1, 900, 1 100";
+    CompareResult(ERROR_INFO, expected, result, failedCount);
+    
+    // A block in the same free list as the request is still found when no larger list has one
+    result = std::stringstream();
+    expected = std::stringstream();
+    TLSFAllocator oddAllocator(38);
+    oddAllocator.allocate(37, offset);
+    oddAllocator.allocate(1, offset);
+    oddAllocator.free(0);
+    result << oddAllocator.allocate(37, offset) << " " << offset << ", " << oddAllocator.allocate(1, offset);
+    expected << "1 0, 0";
+    CompareResult(ERROR_INFO, expected, result, failedCount);
+    
+    // Growing extends the last free block
+    result = std::stringstream();
+    expected = std::stringstream();
+    TLSFAllocator growingAllocator(10);
+    growingAllocator.allocate(8, offset);
+    growingAllocator.grow(20);
+    result << growingAllocator.getStats().numFreeBlocks << ", " << growingAllocator.allocate(12, offset) << " " << offset;
+    expected << "1, 1 8";
+    CompareResult(ERROR_INFO, expected, result, failedCount);
+    
+    return failedCount;
+}
+
+int TestTLSFFragmentation() {
+    std::stringstream result;
+    std::stringstream expected;
+    int failedCount = 0;
+    
+    result = std::stringstream();
+    expected = std::stringstream();
+    TLSFAllocator allocator(1000);
+    size_t offsets[10] = {};
+    for(unsigned int i = 0; i < 10; i++) {
+        allocator.allocate(100, offsets[i]);
+    }
+    for(unsigned int i = 0; i < 10; i += 2) {
+        allocator.free(offsets[i]);
+    }
+    AllocatorStats stats = allocator.getStats();
+    size_t offset = 0;
+    result << stats.freeSize << ", " << stats.largestFreeBlock << ", " << stats.numFreeBlocks << ", " << stats.fragmentation << ", "
+            << allocator.allocate(200, offset);
+    expected << "500, 100, 5, 0.8, 0";
+    CompareResult(ERROR_INFO, expected, result, failedCount);
+    
+    return failedCount;
+}
+
+int TestTLSFDefragment() {
+    std::stringstream result;
+    std::stringstream expected;
+    int failedCount = 0;
+    
+    result = std::stringstream();
+    expected = std::stringstream();
+    TLSFAllocator allocator(100);
+    size_t offsets[5] = {};
+    for(unsigned int i = 0; i < 5; i++) {
+        allocator.allocate(10, offsets[i]);
+    }
+    allocator.free(offsets[1]);
+    allocator.free(offsets[3]);
+    std::vector<TLSFAllocator::Move> moves = allocator.defragment();
+    for(unsigned int i = 0; i < moves.size(); i++) {
+        result << moves[i].oldOffset << "->" << moves[i].newOffset << " " << moves[i].size << ", ";
+    }
+    AllocatorStats stats = allocator.getStats();
+    result << stats.numFreeBlocks << ", " << stats.largestFreeBlock << ", " << stats.fragmentation << ", " << allocator.getAllocationSize(20);
+    expected << "20->10 10, 40->20 10, 1, 70, 0, 10";
+    CompareResult(ERROR_INFO, expected, result, failedCount);
+    
+    return failedCount;
+}
+
+int TestGPUBufferHeap() {
+    std::stringstream result;
+    std::stringstream expected;
+    int failedCount = 0;
+    HeadlessGL::Reset();
+    
+    // Growing and compacting keep the contents and update allocation offsets
+    result = std::stringstream();
+    expected = std::stringstream();
+    GPUBufferHeap heap(sizeof(unsigned int), 8);
+    std::vector<unsigned int> allocationIDs;
+    for(unsigned int i = 0; i < 4; i++) {
+        std::vector<unsigned int> values(2, i);
+        allocationIDs.push_back(heap.allocate(values.size(), values.data()));
+    }
+    heap.free(allocationIDs[1]);
+    std::vector<unsigned int> values(5, 9);
+    unsigned int grownAllocationID = heap.allocate(values.size(), values.data());
+    std::vector<unsigned int> readValues(2);
+    heap.read(allocationIDs[3], readValues.data());
+    result << heap.getAllocator().getCapacity() << ", " << heap.getOffset(allocationIDs[3]) << ", " << readValues[0] << readValues[1] << ", "
+            << heap.getOffset(grownAllocationID) << ", " << heap.getNumGrows() << ", " << HeadlessGL::GetNumLiveBuffers() << ", "
+            << HeadlessGL::GetCallCount("glCopyBufferSubData") << ", " << HeadlessGL::GetNumErrors();
+    // Allocations 0 and 2..3 are copied in two runs
+    expected << "16, 4, 33, 6, 1, 1, 2, 0";
+    CompareResult(ERROR_INFO, expected, result, failedCount);
+    
+    // Fits after compacting without growing
+    result = std::stringstream();
+    expected = std::stringstream();
+    heap.free(allocationIDs[2]);
+    heap.defragment();
+    heap.read(allocationIDs[3], readValues.data());
+    std::vector<unsigned int> grownValues(5);
+    heap.read(grownAllocationID, grownValues.data());
+    result << heap.getAllocator().getCapacity() << ", " << heap.getOffset(allocationIDs[3]) << ", " << readValues[0] << ", "
+            << heap.getOffset(grownAllocationID) << ", " << grownValues[4] << ", " << heap.getAllocator().getStats().numFreeBlocks << ", "
+            << heap.getGeneration();
+    expected << "16, 2, 3, 4, 9, 1, 3";
+    CompareResult(ERROR_INFO, expected, result, failedCount);
+    
+    heap.free(allocationIDs[0]);
+    heap.free(allocationIDs[3]);
+    heap.free(grownAllocationID);
+    heap.destroy();
+    return failedCount;
+}
+
+int TestSharedMeshBuffers() {
+    std::stringstream result;
+    std::stringstream expected;
+    int failedCount = 0;
+    GeometryHeap::Destroy();
+    HeadlessGL::Reset();
+    
+    // Meshes share one vertex buffer, one index buffer and one vertex array, and are drawn with base vertex offsets
+    result = std::stringstream();
+    expected = std::stringstream();
+    unsigned int meshIDs[3] = {};
+    for(unsigned int i = 0; i < 3; i++) {
+        meshIDs[i] = MeshLoader::LoadMeshFromMeshData(CreateTestMeshData(3 * (i + 1)));
+        MeshLoader::UseLoadedMesh(meshIDs[i]);
+    }
+    for(unsigned int i = 0; i < 3; i++) {
+        MeshLoader::BindMesh(meshIDs[i]);
+        glDrawElementsBaseVertex(GL_TRIANGLES, MeshLoader::GetNumIndices(meshIDs[i]), GL_UNSIGNED_INT,
+                (void*)(MeshLoader::GetFirstIndex(meshIDs[i]) * sizeof(unsigned int)), MeshLoader::GetBaseVertex(meshIDs[i]));
+    }
+    const std::vector<HeadlessGL::DrawRecord>& drawLog = HeadlessGL::GetDrawLog();
+    for(unsigned int i = 0; i < drawLog.size(); i++) {
+        result << (drawLog[i].vertexArray == drawLog[0].vertexArray) << " " << drawLog[i].count << " "
+                << drawLog[i].indexOffset / sizeof(unsigned int) << " " << drawLog[i].baseVertex << ", ";
+    }
+    result << HeadlessGL::GetNumLiveBuffers() << ", " << HeadlessGL::GetNumLiveVertexArrays() << ", " << HeadlessGL::GetCallCount("glGenVertexArrays");
+    expected << "1 3 0 0, 1 6 3 3, 1 9 9 9, 2, 1, 1";
+    CompareResult(ERROR_INFO, expected, result, failedCount);
+    
+    // Defragmenting moves the last mesh down and rebuilds the vertex array against the new buffers
+    result = std::stringstream();
+    expected = std::stringstream();
+    MeshLoader::ReleaseLoadedMesh(meshIDs[1]);
+    ResourceReclaimer::ReclaimAll();
+    GeometryHeap::Defragment();
+    HeadlessGL::ClearCallLog();
+    MeshLoader::BindMesh(meshIDs[2]);
+    result << MeshLoader::GetFirstIndex(meshIDs[2]) << ", " << MeshLoader::GetBaseVertex(meshIDs[2]) << ", " << HeadlessGL::GetCallCount("glVertexAttribPointer")
+            << ", " << HeadlessGL::GetNumLiveBuffers() << ", " << HeadlessGL::GetNumErrors();
+    expected << "3, 3, 3, 2, 0";
+    CompareResult(ERROR_INFO, expected, result, failedCount);
+    
+    MeshLoader::ReleaseLoadedMesh(meshIDs[0]);
+    MeshLoader::ReleaseLoadedMesh(meshIDs[2]);
+    ResourceReclaimer::ReclaimAll();
+    return failedCount;
+}
+
+int TestEmptyMesh() {
+    std::stringstream result;
+    std::stringstream expected;
+    int failedCount = 0;
+    GeometryHeap::Destroy();
+    HeadlessGL::Reset();
+    
+    // A mesh without vertices or indices buffers without taking space in the heaps and has an empty draw range
+    result = std::stringstream();
+    expected = std::stringstream();
+    unsigned int meshID = MeshLoader::LoadMeshFromMeshData(CreateTestMeshData(0));
+    MeshLoader::UseLoadedMesh(meshID);
+    MeshDrawRange drawRange = MeshLoader::GetDrawRange(meshID);
+    result << drawRange.numIndices << " " << drawRange.firstIndex << " " << drawRange.baseVertex << ", "
+            << GeometryHeap::GetVertexHeap(VERTEX_FORMAT_POSITION_NORMAL_TEXCOORD).getAllocator().getNumAllocations() << " "
+            << GeometryHeap::GetIndexHeap().getAllocator().getNumAllocations() << ", ";
+    MeshLoader::ReleaseLoadedMesh(meshID);
+    ResourceReclaimer::ReclaimAll();
+    result << HeadlessGL::GetNumErrors();
+    expected << "0 0 0, 0 0, 0";
+    CompareResult(ERROR_INFO, expected, result, failedCount);
+    
+    return failedCount;
+}
+
+};
@@ -0,0 +1,28 @@
+#ifndef GEOMETRY_HEAP_TESTS_H
+#define GEOMETRY_HEAP_TESTS_H
+
+#include <iostream>
+#include <string>
+#include <graphics/buffer/tlsf_allocator.h>
+#include <graphics/buffer/gpu_buffer_heap.h>
+#include <graphics/buffer/geometry_heap.h>
+#include <graphics/buffer/resource_reclaimer.h>
+#include <graphics/mesh/mesh_data.h>
+#include <headless_gl.h>
+#include <test_exception.h>
+#include <test_comparison.h>
+#include <test_meshes.h>
+
+namespace Tests::GeometryHeapTests {
+
+int DoTests();
+int TestTLSFAllocate();
+int TestTLSFFragmentation();
+int TestTLSFDefragment();
+int TestGPUBufferHeap();
+int TestSharedMeshBuffers();
+int TestEmptyMesh();
+
+};
+
+#endif //GEOMETRY_HEAP_TESTS_H
@@ -0,0 +1,202 @@
+#include "gl_state_cache_tests.h"
+
+using namespace Engine;
+using namespace Engine::Math;
+
+namespace Tests::GLStateCacheTests {
+
+int DoTests() {
+    int failedCount = 0;
+    
+    failedCount += TestRedundantStateFiltered();
+    failedCount += TestBufferBinds();
+    failedCount += TestFrameStats();
+    
+    return failedCount;
+}
+
+static std::string toString(const std::vector<float>& values) {
+    std::stringstream stream;
+    for(unsigned int i = 0; i < values.size(); i++) {
+        stream << (i > 0 ? " " : "") << values[i];
+    }
+    return stream.str();
+}
+
+int TestRedundantStateFiltered() {
+    std::stringstream result;
+    std::stringstream expected;
+    int failedCount = 0;
+    GeometryHeap::Destroy();
+    HeadlessGL::Reset();
+    GLStateCache::EndFrame();
+    
+    // Setting state twice makes one call, and changing it makes another
+    result = std::stringstream();
+    expected = std::stringstream();
+    for(unsigned int i = 0; i < 2; i++) {
+        GLStateCache::UseProgram(7);
+        GLStateCache::SetEnabled(GL_DEPTH_TEST, true);
+        GLStateCache::SetEnabled(GL_BLEND, false);
+        GLStateCache::SetBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+        GLStateCache::SetDepthFunc(GL_LEQUAL);
+        GLStateCache::SetDepthMask(false);
+        GLStateCache::SetCullFace(GL_BACK);
+        GLStateCache::SetPolygonMode(GL_LINE);
+        GLStateCache::SetViewport(0, 0, 900, 700);
+        GLStateCache::SetClearColor(0.0f, 1.0f, 0.0f, 1.0f);
+    }
+    result << HeadlessGL::GetCallLog().size() << " " << HeadlessGL::GetCurrentProgram() << " " << HeadlessGL::IsEnabled(GL_DEPTH_TEST)
+            << HeadlessGL::IsEnabled(GL_BLEND) << ", " << toString(HeadlessGL::GetStateValues("glBlendFunc")) << ", "
+            << toString(HeadlessGL::GetStateValues("glDepthFunc")) << " " << toString(HeadlessGL::GetStateValues("glDepthMask")) << " "
+            << toString(HeadlessGL::GetStateValues("glCullFace")) << ", " << toString(HeadlessGL::GetStateValues("glPolygonMode")) << ", "
+            << toString(HeadlessGL::GetStateValues("glViewport")) << ", " << toString(HeadlessGL::GetStateValues("glClearColor")) << ", ";
+    GLStateStats stats = GLStateCache::GetFrameStats();
+    result << stats.programBinds << " " << stats.stateChanges << " " << stats.redundantCalls << ", ";
+    
+    GLStateCache::UseProgram(8);
+    GLStateCache::SetEnabled(GL_BLEND, true);
+    GLStateCache::SetViewport(0, 0, 1280, 720);
+    GLStateCache::SetClearColor(0.0f, 1.0f, 0.0f, 0.5f);
+    result << HeadlessGL::GetCurrentProgram() << " " << HeadlessGL::IsEnabled(GL_BLEND) << " " << toString(HeadlessGL::GetStateValues("glViewport")) << " "
+            << HeadlessGL::GetStateValues("glClearColor")[3] << " " << HeadlessGL::GetCallLog().size() << " " << HeadlessGL::GetNumErrors();
+    expected << "10 7 10, " << GL_SRC_ALPHA << " " << GL_ONE_MINUS_SRC_ALPHA << ", " << GL_LEQUAL << " 0 " << GL_BACK << ", "
+            << GL_FRONT_AND_BACK << " " << GL_LINE << ", 0 0 900 700, 0 1 0 1, 1 9 10, 8 1 0 0 1280 720 0.5 14 0";
+    CompareResult(ERROR_INFO, expected, result, failedCount);
+    
+    // After invalidating, every state call is made again
+    result = std::stringstream();
+    expected = std::stringstream();
+    GLStateCache::Invalidate();
+    HeadlessGL::ClearCallLog();
+    GLStateCache::UseProgram(8);
+    GLStateCache::SetEnabled(GL_BLEND, true);
+    GLStateCache::SetPolygonMode(GL_LINE);
+    GLStateCache::UseProgram(8);
+    result << HeadlessGL::GetCallCount("glUseProgram") << " " << HeadlessGL::GetCallCount("glEnable") << " " << HeadlessGL::GetCallCount("glPolygonMode");
+    expected << "1 1 1";
+    CompareResult(ERROR_INFO, expected, result, failedCount);
+    
+    // A deleted program stays in use until another one is, so using a program after forgetting it is never skipped
+    result = std::stringstream();
+    expected = std::stringstream();
+    HeadlessGL::ClearCallLog();
+    GLStateCache::ForgetProgram(8);
+    GLStateCache::UseProgram(8);
+    GLStateCache::ForgetProgram(3);
+    GLStateCache::UseProgram(8);
+    result << HeadlessGL::GetCallCount("glUseProgram");
+    expected << "1";
+    CompareResult(ERROR_INFO, expected, result, failedCount);
+    
+    GLStateCache::Invalidate();
+    GLStateCache::EndFrame();
+    return failedCount;
+}
+
+int TestBufferBinds() {
+    std::stringstream result;
+    std::stringstream expected;
+    int failedCount = 0;
+    GeometryHeap::Destroy();
+    HeadlessGL::Reset();
+    
+    // Bindings are kept per target
+    result = std::stringstream();
+    expected = std::stringstream();
+    GLuint buffers[2];
+    glGenBuffers(2, buffers);
+    HeadlessGL::ClearCallLog();
+    GLStateCache::BindBuffer(GL_ARRAY_BUFFER, buffers[0]);
+    GLStateCache::BindBuffer(GL_COPY_WRITE_BUFFER, buffers[0]);
+    GLStateCache::BindBuffer(GL_ARRAY_BUFFER, buffers[0]);
+    GLStateCache::BindBuffer(GL_COPY_WRITE_BUFFER, buffers[1]);
+    result << HeadlessGL::GetCallCount("glBindBuffer") << " " << (HeadlessGL::GetBoundBuffer(GL_ARRAY_BUFFER) == buffers[0])
+            << (HeadlessGL::GetBoundBuffer(GL_COPY_WRITE_BUFFER) == buffers[1]) << ", ";
+    
+    // Deleting a buffer unbinds it, so binding 0 afterwards is skipped and binding a new buffer isn't
+    glDeleteBuffers(1, &buffers[0]);
+    GLStateCache::ForgetBuffer(buffers[0]);
+    HeadlessGL::ClearCallLog();
+    GLStateCache::BindBuffer(GL_ARRAY_BUFFER, 0);
+    GLStateCache::BindBuffer(GL_ARRAY_BUFFER, buffers[1]);
+    result << HeadlessGL::GetCallCount("glBindBuffer") << " " << (HeadlessGL::GetBoundBuffer(GL_ARRAY_BUFFER) == buffers[1]);
+    glDeleteBuffers(1, &buffers[1]);
+    GLStateCache::ForgetBuffer(buffers[1]);
+    expected << "3 11, 1 1";
+    CompareResult(ERROR_INFO, expected, result, failedCount);
+    
+    // The element array buffer belongs to the vertex array, so it is bound again after another vertex array is
+    result = std::stringstream();
+    expected = std::stringstream();
+    GLuint vertexArrays[2];
+    glGenVertexArrays(2, vertexArrays);
+    glGenBuffers(1, buffers);
+    HeadlessGL::ClearCallLog();
+    GLStateCache::BindVertexArray(vertexArrays[0]);
+    GLStateCache::BindBuffer(GL_ELEMENT_ARRAY_BUFFER, buffers[0]);
+    GLStateCache::BindVertexArray(vertexArrays[0]);
+    GLStateCache::BindBuffer(GL_ELEMENT_ARRAY_BUFFER, buffers[0]);
+    result << HeadlessGL::GetCallCount("glBindVertexArray") << " " << HeadlessGL::GetCallCount("glBindBuffer") << " ";
+    GLStateCache::BindVertexArray(vertexArrays[1]);
+    GLStateCache::BindBuffer(GL_ELEMENT_ARRAY_BUFFER, buffers[0]);
+    result << HeadlessGL::GetCallCount("glBindVertexArray") << " " << HeadlessGL::GetCallCount("glBindBuffer") << ", ";
+    
+    // Deleting the bound vertex array binds 0
+    glDeleteVertexArrays(1, &vertexArrays[1]);
+    GLStateCache::ForgetVertexArray(vertexArrays[1]);
+    GLStateCache::BindVertexArray(0);
+    GLStateCache::BindVertexArray(vertexArrays[0]);
+    result << HeadlessGL::GetCallCount("glBindVertexArray") << " " << HeadlessGL::GetBoundVertexArray() << " " << HeadlessGL::GetNumErrors();
+    glDeleteVertexArrays(1, &vertexArrays[0]);
+    GLStateCache::ForgetVertexArray(vertexArrays[0]);
+    glDeleteBuffers(1, buffers);
+    GLStateCache::ForgetBuffer(buffers[0]);
+    expected << "1 1 2 2, 3 " << vertexArrays[0] << " 0";
+    CompareResult(ERROR_INFO, expected, result, failedCount);
+    
+    GLStateCache::EndFrame();
+    return failedCount;
+}
+
+int TestFrameStats() {
+    std::stringstream result;
+    std::stringstream expected;
+    int failedCount = 0;
+    GeometryHeap::Destroy();
+    HeadlessGL::Reset();
+    GLStateCache::EndFrame();
+    
+    // Binding the meshes of a frame binds their shared vertex array once, and the counts are kept per frame
+    result = std::stringstream();
+    expected = std::stringstream();
+    {
+        std::vector<Mesh> meshes;
+        for(unsigned int i = 0; i < 4; i++) {
+            meshes.push_back(Mesh(CreateTestMeshData(3 + i), TexturedMaterial(), UnTexturedMaterial()));
+        }
+        for(unsigned int frame = 0; frame < 2; frame++) {
+            HeadlessGL::ClearCallLog();
+            GLStateCache::SetEnabled(GL_DEPTH_TEST, true);
+            for(unsigned int i = 0; i < meshes.size(); i++) {
+                MeshLoader::BindMesh(meshes[i].getMeshID());
+                GLStateCache::SetPolygonMode(GL_FILL);
+            }
+            GLStateStats stats = GLStateCache::GetFrameStats();
+            result << HeadlessGL::GetCallCount("glBindVertexArray") << " " << HeadlessGL::GetCallCount("glPolygonMode") << " "
+                    << HeadlessGL::GetCallCount("glEnable") << " " << stats.vertexArrayBinds << " " << stats.stateChanges << " "
+                    << stats.getNumRedundantCalls() << ", ";
+            GLStateCache::EndFrame();
+        }
+        const GLStateStats& lastFrameStats = GLStateCache::GetLastFrameStats();
+        result << lastFrameStats.vertexArrayBinds << " " << lastFrameStats.getNumRedundantCalls() << " " << GLStateCache::GetFrameStats().redundantCalls << " "
+                << HeadlessGL::GetNumErrors();
+    }
+    expected << "1 1 1 1 2 6, 0 0 0 0 0 9, 0 9 0 0";
+    CompareResult(ERROR_INFO, expected, result, failedCount);
+    
+    ResourceReclaimer::ReclaimAll();
+    return failedCount;
+}
+
+}
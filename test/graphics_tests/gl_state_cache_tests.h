@@ -0,0 +1,24 @@
+#ifndef GL_STATE_CACHE_TESTS_H
+#define GL_STATE_CACHE_TESTS_H
+
+#include <iostream>
+#include <string>
+#include <graphics/state/gl_state_cache.h>
+#include <graphics/mesh/mesh.h>
+#include <graphics/buffer/geometry_heap.h>
+#include <graphics/buffer/resource_reclaimer.h>
+#include <headless_gl.h>
+#include <test_exception.h>
+#include <test_comparison.h>
+#include <test_meshes.h>
+
+namespace Tests::GLStateCacheTests {
+
+int DoTests();
+int TestRedundantStateFiltered();
+int TestBufferBinds();
+int TestFrameStats();
+
+};
+
+#endif //GL_STATE_CACHE_TESTS_H
@@ -0,0 +1,373 @@
+#include <iostream>
+#include <string>
+
+#include "path_index_tests.h"
+#include "shared_buffer_tests.h"
+#include "residency_tests.h"
+#include "deferred_release_tests.h"
+#include "geometry_heap_tests.h"
+#include "indirect_draw_tests.h"
+#include "instancing_tests.h"
+#include "static_batching_tests.h"
+#include "streaming_upload_tests.h"
+#include "async_loading_tests.h"
+#include "mipmap_tests.h"
+#include "block_compression_tests.h"
+#include "texture_cache_tests.h"
+#include "pixel_format_tests.h"
+#include "texture_streaming_tests.h"
+#include "texture_atlas_tests.h"
+#include "sampler_cache_tests.h"
+#include "gl_state_cache_tests.h"
+#include "program_binary_cache_tests.h"
+#include "shader_preprocessor_tests.h"
+#include "parallel_shader_compile_tests.h"
+#include "material_parameter_block_tests.h"
+#include "camera_tests.h"
+#include "entity_world_tests.h"
+#include "job_system_tests.h"
+#include "test_exception.h"
+#include "headless_gl.h"
+
+using namespace Engine;
+using namespace Tests;
+
+int main() {
+    std::cout << "STARTING GRAPHICS TESTS." << std::endl;
+    int failedCount = 0;
+    HeadlessGL::Install();
+    
+    // Path index tests
+    try {
+        failedCount += PathIndexTests::DoTests();
+    }
+    catch(GeneralException& e) {
+        std::cout << e.getMessage() << std::endl;
+        failedCount++;
+    }
+    catch(std::exception& e) {
+        std::cout << e.what() << std::endl;
+        failedCount++;
+    }
+    
+    // Shared buffer tests
+    try {
+        failedCount += SharedBufferTests::DoTests();
+    }
+    catch(GeneralException& e) {
+        std::cout << e.getMessage() << std::endl;
+        failedCount++;
+    }
+    catch(std::exception& e) {
+        std::cout << e.what() << std::endl;
+        failedCount++;
+    }
+    
+    // Residency tests
+    try {
+        failedCount += ResidencyTests::DoTests();
+    }
+    catch(GeneralException& e) {
+        std::cout << e.getMessage() << std::endl;
+        failedCount++;
+    }
+    catch(std::exception& e) {
+        std::cout << e.what() << std::endl;
+        failedCount++;
+    }
+    
+    // Deferred release tests
+    try {
+        failedCount += DeferredReleaseTests::DoTests();
+    }
+    catch(GeneralException& e) {
+        std::cout << e.getMessage() << std::endl;
+        failedCount++;
+    }
+    catch(std::exception& e) {
+        std::cout << e.what() << std::endl;
+        failedCount++;
+    }
+    
+    // Geometry heap tests
+    try {
+        failedCount += GeometryHeapTests::DoTests();
+    }
+    catch(GeneralException& e) {
+        std::cout << e.getMessage() << std::endl;
+        failedCount++;
+    }
+    catch(std::exception& e) {
+        std::cout << e.what() << std::endl;
+        failedCount++;
+    }
+    
+    // Indirect draw tests
+    try {
+        failedCount += IndirectDrawTests::DoTests();
+    }
+    catch(GeneralException& e) {
+        std::cout << e.getMessage() << std::endl;
+        failedCount++;
+    }
+    catch(std::exception& e) {
+        std::cout << e.what() << std::endl;
+        failedCount++;
+    }
+    
+    // Instancing tests
+    try {
+        failedCount += InstancingTests::DoTests();
+    }
+    catch(GeneralException& e) {
+        std::cout << e.getMessage() << std::endl;
+        failedCount++;
+    }
+    catch(std::exception& e) {
+        std::cout << e.what() << std::endl;
+        failedCount++;
+    }
+    
+    // Static batching tests
+    try {
+        failedCount += StaticBatchingTests::DoTests();
+    }
+    catch(GeneralException& e) {
+        std::cout << e.getMessage() << std::endl;
+        failedCount++;
+    }
+    catch(std::exception& e) {
+        std::cout << e.what() << std::endl;
+        failedCount++;
+    }
+    
+    // Streaming upload tests
+    try {
+        failedCount += StreamingUploadTests::DoTests();
+    }
+    catch(GeneralException& e) {
+        std::cout << e.getMessage() << std::endl;
+        failedCount++;
+    }
+    catch(std::exception& e) {
+        std::cout << e.what() << std::endl;
+        failedCount++;
+    }
+    
+    // Async loading tests
+    try {
+        failedCount += AsyncLoadingTests::DoTests();
+    }
+    catch(GeneralException& e) {
+        std::cout << e.getMessage() << std::endl;
+        failedCount++;
+    }
+    catch(std::exception& e) {
+        std::cout << e.what() << std::endl;
+        failedCount++;
+    }
+    
+    // Mipmap tests
+    try {
+        failedCount += MipmapTests::DoTests();
+    }
+    catch(GeneralException& e) {
+        std::cout << e.getMessage() << std::endl;
+        failedCount++;
+    }
+    catch(std::exception& e) {
+        std::cout << e.what() << std::endl;
+        failedCount++;
+    }
+    
+    // Block compression tests
+    try {
+        failedCount += BlockCompressionTests::DoTests();
+    }
+    catch(GeneralException& e) {
+        std::cout << e.getMessage() << std::endl;
+        failedCount++;
+    }
+    catch(std::exception& e) {
+        std::cout << e.what() << std::endl;
+        failedCount++;
+    }
+    
+    // Texture cache tests
+    try {
+        failedCount += TextureCacheTests::DoTests();
+    }
+    catch(GeneralException& e) {
+        std::cout << e.getMessage() << std::endl;
+        failedCount++;
+    }
+    catch(std::exception& e) {
+        std::cout << e.what() << std::endl;
+        failedCount++;
+    }
+    
+    // Pixel format tests
+    try {
+        failedCount += PixelFormatTests::DoTests();
+    }
+    catch(GeneralException& e) {
+        std::cout << e.getMessage() << std::endl;
+        failedCount++;
+    }
+    catch(std::exception& e) {
+        std::cout << e.what() << std::endl;
+        failedCount++;
+    }
+    
+    // Texture streaming tests
+    try {
+        failedCount += TextureStreamingTests::DoTests();
+    }
+    catch(GeneralException& e) {
+        std::cout << e.getMessage() << std::endl;
+        failedCount++;
+    }
+    catch(std::exception& e) {
+        std::cout << e.what() << std::endl;
+        failedCount++;
+    }
+    
+    // Texture atlas tests
+    try {
+        failedCount += TextureAtlasTests::DoTests();
+    }
+    catch(GeneralException& e) {
+        std::cout << e.getMessage() << std::endl;
+        failedCount++;
+    }
+    catch(std::exception& e) {
+        std::cout << e.what() << std::endl;
+        failedCount++;
+    }
+    
+    // Sampler cache tests
+    try {
+        failedCount += SamplerCacheTests::DoTests();
+    }
+    catch(GeneralException& e) {
+        std::cout << e.getMessage() << std::endl;
+        failedCount++;
+    }
+    catch(std::exception& e) {
+        std::cout << e.what() << std::endl;
+        failedCount++;
+    }
+    
+    // GL state cache tests
+    try {
+        failedCount += GLStateCacheTests::DoTests();
+    }
+    catch(GeneralException& e) {
+        std::cout << e.getMessage() << std::endl;
+        failedCount++;
+    }
+    catch(std::exception& e) {
+        std::cout << e.what() << std::endl;
+        failedCount++;
+    }
+    
+    // Program binary cache tests
+    try {
+        failedCount += ProgramBinaryCacheTests::DoTests();
+    }
+    catch(GeneralException& e) {
+        std::cout << e.getMessage() << std::endl;
+        failedCount++;
+    }
+    catch(std::exception& e) {
+        std::cout << e.what() << std::endl;
+        failedCount++;
+    }
+    
+    // Shader preprocessor tests
+    try {
+        failedCount += ShaderPreprocessorTests::DoTests();
+    }
+    catch(GeneralException& e) {
+        std::cout << e.getMessage() << std::endl;
+        failedCount++;
+    }
+    catch(std::exception& e) {
+        std::cout << e.what() << std::endl;
+        failedCount++;
+    }
+    
+    // Parallel shader compile tests
+    try {
+        failedCount += ParallelShaderCompileTests::DoTests();
+    }
+    catch(GeneralException& e) {
+        std::cout << e.getMessage() << std::endl;
+        failedCount++;
+    }
+    catch(std::exception& e) {
+        std::cout << e.what() << std::endl;
+        failedCount++;
+    }
+    
+    // Material parameter block tests
+    try {
+        failedCount += MaterialParameterBlockTests::DoTests();
+    }
+    catch(GeneralException& e) {
+        std::cout << e.getMessage() << std::endl;
+        failedCount++;
+    }
+    catch(std::exception& e) {
+        std::cout << e.what() << std::endl;
+        failedCount++;
+    }
+    
+    // Camera tests
+    try {
+        failedCount += CameraTests::DoTests();
+    }
+    catch(GeneralException& e) {
+        std::cout << e.getMessage() << std::endl;
+        failedCount++;
+    }
+    catch(std::exception& e) {
+        std::cout << e.what() << std::endl;
+        failedCount++;
+    }
+    
+    // Entity world tests
+    try {
+        failedCount += EntityWorldTests::DoTests();
+    }
+    catch(GeneralException& e) {
+        std::cout << e.getMessage() << std::endl;
+        failedCount++;
+    }
+    catch(std::exception& e) {
+        std::cout << e.what() << std::endl;
+        failedCount++;
+    }
+    
+    // Job system tests
+    try {
+        failedCount += JobSystemTests::DoTests();
+    }
+    catch(GeneralException& e) {
+        std::cout << e.getMessage() << std::endl;
+        failedCount++;
+    }
+    catch(std::exception& e) {
+        std::cout << e.what() << std::endl;
+        failedCount++;
+    }
+    
+    if(failedCount > 0) {
+        std::cout << "GRAPHICS TESTS FAILED:" << std::endl;
+        std::cout << "\tFinished graphics tests with " << failedCount << " failed tests." << std::endl;
+    }
+    else {
+        std::cout << "GRAPHICS TESTS PASSED." << std::endl;
+    }
+    return 0;
+}
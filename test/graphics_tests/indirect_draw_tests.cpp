@@ -0,0 +1,223 @@
+#include "indirect_draw_tests.h"
+
+using namespace Engine;
+using namespace Engine::Math;
+
+namespace Tests::IndirectDrawTests {
+
+int DoTests() {
+    int failedCount = 0;
+    
+    failedCount += TestPersistentMappedBuffer();
+    failedCount += TestIndirectDrawBatches();
+    failedCount += TestParallelBuild();
+    failedCount += TestBufferStorageFallback();
+    
+    return failedCount;
+}
+
+static std::vector<unsigned char> readBuffer(const GLuint buffer) {
+    std::vector<unsigned char> data(HeadlessGL::GetBufferSize(buffer));
+    glBindBuffer(GL_COPY_READ_BUFFER, buffer);
+    glGetBufferSubData(GL_COPY_READ_BUFFER, 0, data.size(), data.data());
+    glBindBuffer(GL_COPY_READ_BUFFER, 0);
+    return data;
+}
+
+int TestPersistentMappedBuffer() {
+    std::stringstream result;
+    std::stringstream expected;
+    int failedCount = 0;
+    HeadlessGL::Reset();
+    
+    // Regions are written in turn through the mapping and a region's fence is waited on before it is written again
+    result = std::stringstream();
+    expected = std::stringstream();
+    PersistentMappedBuffer buffer(4, 3);
+    for(unsigned int i = 0; i < 4; i++) {
+        unsigned char* region = (unsigned char*)buffer.beginWrite();
+        result << buffer.getRegionOffset() << " ";
+        std::memset(region, i + 1, 4);
+        buffer.endWrite(4);
+        buffer.fenceRegion();
+    }
+    std::vector<unsigned char> data = readBuffer(buffer.getBufferName());
+    result << ", " << buffer.isPersistent() << ", " << (int)data[0] << " " << (int)data[4] << " " << (int)data[8] << ", "
+            << HeadlessGL::GetCallCount("glClientWaitSync") << ", " << HeadlessGL::GetCallCount("glBufferSubData") << ", "
+            << HeadlessGL::GetNumLiveSyncs() << ", " << buffer.getNumStalls();
+    expected << "0 4 8 0 , 1, 4 2 3, 1, 0, 3, 0";
+    CompareResult(ERROR_INFO, expected, result, failedCount);
+    
+    // Destroying releases the buffer and fences
+    result = std::stringstream();
+    expected = std::stringstream();
+    buffer.destroy();
+    result << HeadlessGL::GetNumLiveBuffers() << ", " << HeadlessGL::GetNumLiveSyncs() << ", " << HeadlessGL::GetCallCount("glUnmapBuffer");
+    expected << "0, 0, 1";
+    CompareResult(ERROR_INFO, expected, result, failedCount);
+    
+    return failedCount;
+}
+
+int TestIndirectDrawBatches() {
+    std::stringstream result;
+    std::stringstream expected;
+    int failedCount = 0;
+    GeometryHeap::Destroy();
+    HeadlessGL::Reset();
+    
+    unsigned int meshIDs[3] = {};
+    for(unsigned int i = 0; i < 3; i++) {
+        meshIDs[i] = MeshLoader::LoadMeshFromMeshData(CreateTestMeshData(3 * (i + 1)));
+        MeshLoader::UseLoadedMesh(meshIDs[i]);
+    }
+    
+    // Draws are grouped by batch key into one multi-draw call each, keeping their order within a batch
+    result = std::stringstream();
+    expected = std::stringstream();
+    IndirectDrawStream drawStream(16, 1);
+    unsigned int batchKeys[5] = {2, 1, 2, 1, 1};
+    unsigned int drawMeshes[5] = {0, 1, 2, 2, 0};
+    for(unsigned int i = 0; i < 5; i++) {
+        drawStream.addDraw(meshIDs[drawMeshes[i]], batchKeys[i], createTranslationMat(createVec3<float>((float)i, 0.0f, 0.0f)));
+    }
+    drawStream.build();
+    HeadlessGL::ClearCallLog();
+    drawStream.submit([&result](unsigned int batchKey) { result << batchKey << " "; });
+    const std::vector<HeadlessGL::DrawRecord>& drawLog = HeadlessGL::GetDrawLog();
+    result << ", ";
+    for(unsigned int i = 0; i < drawLog.size(); i++) {
+        result << drawLog[i].count << " " << drawLog[i].indexOffset / sizeof(unsigned int) << " " << drawLog[i].baseVertex << " "
+                << drawLog[i].instanceCount << " " << drawLog[i].baseInstance << ", ";
+    }
+    result << HeadlessGL::GetCallCount("glMultiDrawElementsIndirect") << ", " << drawStream.getNumBatches() << ", "
+            << HeadlessGL::GetVertexAttribDivisor(IndirectDrawStream::TRANSFORM_ATTRIBUTE_LOCATION) << ", "
+            << HeadlessGL::GetCallCount("glDisableVertexAttribArray") << ", " << HeadlessGL::GetNumErrors();
+    expected << "1 2 , 6 3 3 1 0, 9 9 9 1 1, 3 0 0 1 2, 3 0 0 1 3, 9 9 9 1 4, 2, 2, 1, 4, 0";
+    CompareResult(ERROR_INFO, expected, result, failedCount);
+    
+    // Each draw's data holds its transform column major, at the index given by its base instance
+    result = std::stringstream();
+    expected = std::stringstream();
+    std::vector<unsigned char> data = readBuffer(drawStream.getDrawDataBuffer().getBufferName());
+    const IndirectDrawData* drawData = (const IndirectDrawData*)(data.data() + drawStream.getDrawDataBuffer().getRegionOffset());
+    for(unsigned int i = 0; i < 5; i++) {
+        result << drawData[i].transform[12] << " " << drawData[i].transform[15] << ", ";
+    }
+    expected << "1 1, 3 1, 4 1, 0 1, 2 1, ";
+    CompareResult(ERROR_INFO, expected, result, failedCount);
+    
+    // A full stream throws
+    result = std::stringstream();
+    expected = std::stringstream();
+    IndirectDrawStream smallDrawStream(1, 1);
+    smallDrawStream.addDraw(meshIDs[0], 0, Mat4f(1.0f));
+    try {
+        smallDrawStream.addDraw(meshIDs[0], 0, Mat4f(1.0f));
+        result << "no exception";
+    }
+    catch(MeshException& e) {
+        result << "exception";
+    }
+    expected << "exception";
+    CompareResult(ERROR_INFO, expected, result, failedCount);
+    
+    drawStream.destroy();
+    smallDrawStream.destroy();
+    for(unsigned int i = 0; i < 3; i++) {
+        MeshLoader::ReleaseLoadedMesh(meshIDs[i]);
+    }
+    ResourceReclaimer::ReclaimAll();
+    return failedCount;
+}
+
+int TestParallelBuild() {
+    std::stringstream result;
+    std::stringstream expected;
+    int failedCount = 0;
+    GeometryHeap::Destroy();
+    HeadlessGL::Reset();
+    
+    unsigned int meshIDs[4] = {};
+    for(unsigned int i = 0; i < 4; i++) {
+        meshIDs[i] = MeshLoader::LoadMeshFromMeshData(CreateTestMeshData(3 * (i + 1)));
+        MeshLoader::UseLoadedMesh(meshIDs[i]);
+    }
+    
+    // Commands and draw data built on several threads match those built on one
+    result = std::stringstream();
+    expected = std::stringstream();
+    const unsigned int numDraws = 4000;
+    IndirectDrawStream serialDrawStream(numDraws, 1);
+    IndirectDrawStream parallelDrawStream(numDraws, 4);
+    for(unsigned int i = 0; i < numDraws; i++) {
+        Mat4f transform = createTranslationMat(createVec3<float>((float)i, (float)(i % 7), 1.0f));
+        serialDrawStream.addDraw(meshIDs[i % 4], i % 5, transform);
+        parallelDrawStream.addDraw(meshIDs[i % 4], i % 5, transform);
+    }
+    serialDrawStream.build();
+    parallelDrawStream.build();
+    result << (readBuffer(serialDrawStream.getCommandBuffer().getBufferName()) == readBuffer(parallelDrawStream.getCommandBuffer().getBufferName())) << ", "
+            << (readBuffer(serialDrawStream.getDrawDataBuffer().getBufferName()) == readBuffer(parallelDrawStream.getDrawDataBuffer().getBufferName())) << ", "
+            << parallelDrawStream.getNumBatches();
+    expected << "1, 1, 5";
+    CompareResult(ERROR_INFO, expected, result, failedCount);
+    
+    // Every draw is submitted
+    result = std::stringstream();
+    expected = std::stringstream();
+    HeadlessGL::ClearCallLog();
+    parallelDrawStream.submit([](unsigned int batchKey) {});
+    result << HeadlessGL::GetDrawLog().size() << ", " << HeadlessGL::GetCallCount("glMultiDrawElementsIndirect") << ", " << HeadlessGL::GetNumErrors();
+    expected << numDraws << ", 5, 0";
+    CompareResult(ERROR_INFO, expected, result, failedCount);
+    
+    serialDrawStream.destroy();
+    parallelDrawStream.destroy();
+    for(unsigned int i = 0; i < 4; i++) {
+        MeshLoader::ReleaseLoadedMesh(meshIDs[i]);
+    }
+    ResourceReclaimer::ReclaimAll();
+    return failedCount;
+}
+
+int TestBufferStorageFallback() {
+    std::stringstream result;
+    std::stringstream expected;
+    int failedCount = 0;
+    GeometryHeap::Destroy();
+    HeadlessGL::Reset();
+    HeadlessGL::SetBufferStorageSupported(false);
+    
+    unsigned int meshID = MeshLoader::LoadMeshFromMeshData(CreateTestMeshData(6));
+    MeshLoader::UseLoadedMesh(meshID);
+    
+    // Without buffer storage the commands are uploaded with glBufferSubData, into the next region each frame
+    result = std::stringstream();
+    expected = std::stringstream();
+    IndirectDrawStream drawStream(8, 1);
+    for(unsigned int frame = 0; frame < 2; frame++) {
+        drawStream.clear();
+        drawStream.addDraw(meshID, 0, Mat4f(1.0f));
+        drawStream.addDraw(meshID, 0, Mat4f(1.0f));
+        drawStream.build();
+        HeadlessGL::ClearCallLog();
+        drawStream.submit([](unsigned int batchKey) {});
+    }
+    const std::vector<HeadlessGL::DrawRecord>& drawLog = HeadlessGL::GetDrawLog();
+    for(unsigned int i = 0; i < drawLog.size(); i++) {
+        result << drawLog[i].count << " " << drawLog[i].baseInstance << ", ";
+    }
+    result << drawStream.getCommandBuffer().isPersistent() << ", " << drawStream.getCommandBuffer().getRegionOffset() << ", "
+            << HeadlessGL::GetCallCount("glMapBufferRange") << ", " << HeadlessGL::GetNumErrors();
+    expected << "6 0, 6 1, 0, " << 8 * sizeof(DrawElementsIndirectCommand) << ", 0, 0";
+    CompareResult(ERROR_INFO, expected, result, failedCount);
+    
+    drawStream.destroy();
+    HeadlessGL::SetBufferStorageSupported(true);
+    MeshLoader::ReleaseLoadedMesh(meshID);
+    ResourceReclaimer::ReclaimAll();
+    return failedCount;
+}
+
+};
@@ -0,0 +1,25 @@
+#ifndef INDIRECT_DRAW_TESTS_H
+#define INDIRECT_DRAW_TESTS_H
+
+#include <iostream>
+#include <string>
+#include <graphics/mesh/indirect_draw_stream.h>
+#include <graphics/buffer/persistent_mapped_buffer.h>
+#include <graphics/buffer/resource_reclaimer.h>
+#include <math/linear_math.h>
+#include <headless_gl.h>
+#include <test_exception.h>
+#include <test_comparison.h>
+#include <test_meshes.h>
+
+namespace Tests::IndirectDrawTests {
+
+int DoTests();
+int TestPersistentMappedBuffer();
+int TestIndirectDrawBatches();
+int TestParallelBuild();
+int TestBufferStorageFallback();
+
+};
+
+#endif //INDIRECT_DRAW_TESTS_H
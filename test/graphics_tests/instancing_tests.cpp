@@ -0,0 +1,134 @@
+#include "instancing_tests.h"
+
+using namespace Engine;
+using namespace Engine::Math;
+
+namespace Tests::InstancingTests {
+
+int DoTests() {
+    int failedCount = 0;
+    
+    failedCount += TestInstanceGrouping();
+    failedCount += TestModelInstancing();
+    
+    return failedCount;
+}
+
+static std::vector<unsigned char> readBuffer(const GLuint buffer) {
+    std::vector<unsigned char> data(HeadlessGL::GetBufferSize(buffer));
+    glBindBuffer(GL_COPY_READ_BUFFER, buffer);
+    glGetBufferSubData(GL_COPY_READ_BUFFER, 0, data.size(), data.data());
+    glBindBuffer(GL_COPY_READ_BUFFER, 0);
+    return data;
+}
+
+int TestInstanceGrouping() {
+    std::stringstream result;
+    std::stringstream expected;
+    int failedCount = 0;
+    GeometryHeap::Destroy();
+    HeadlessGL::Reset();
+    
+    // Instances of the same mesh with the same material state share a draw call, a different material splits them
+    result = std::stringstream();
+    expected = std::stringstream();
+    {
+        Mesh meshA(CreateTestMeshData(3), TexturedMaterial(), UnTexturedMaterial());
+        Mesh meshB(CreateTestMeshData(6), TexturedMaterial(), UnTexturedMaterial());
+        Mesh texturedMeshA(meshA);
+        TextureDataPtr textureDataPtr = std::make_shared<TextureData>(4, 1, 4, SharedBuffer<unsigned char>(std::vector<unsigned char>(16, 255)));
+        texturedMeshA.setTexturedMaterial(TexturedMaterial(ShaderProgramPtr(), {Texture(textureDataPtr, TEXTURE_DIFFUSE)}, {1.0f}));
+        
+        InstanceRenderer instanceRenderer(16);
+        const Mesh* meshes[6] = {&meshA, &meshB, &texturedMeshA, &meshA, &meshB, &meshA};
+        for(unsigned int i = 0; i < 6; i++) {
+            instanceRenderer.addInstance(*meshes[i], createTranslationMat(createVec3<float>((float)i, 0.0f, 0.0f)), Vec4f((float)i));
+        }
+        result << instanceRenderer.getNumGroups() << ", ";
+        HeadlessGL::ClearCallLog();
+        unsigned int numTexturedBatches = 0;
+        instanceRenderer.render([&numTexturedBatches](const TexturedMaterial& texturedMaterial) { numTexturedBatches += texturedMaterial.getTextures().size(); });
+        const std::vector<HeadlessGL::DrawRecord>& drawLog = HeadlessGL::GetDrawLog();
+        for(unsigned int i = 0; i < drawLog.size(); i++) {
+            result << drawLog[i].count << " " << drawLog[i].instanceCount << " " << drawLog[i].baseVertex << ", ";
+        }
+        result << numTexturedBatches << ", " << instanceRenderer.getFrameStats().numDrawCalls << ", " << instanceRenderer.getFrameStats().getInstancingRatio()
+                << ", " << instanceRenderer.getNumInstances() << ", " << HeadlessGL::GetVertexAttribDivisor(InstanceRenderer::CUSTOM_DATA_ATTRIBUTE_LOCATION)
+                << ", " << HeadlessGL::GetNumErrors();
+        
+        // Instances are laid out per group in the order they were added
+        result << ", ";
+        std::vector<unsigned char> data = readBuffer(instanceRenderer.getInstanceBuffer().getBufferName());
+        const InstanceData* instanceData = (const InstanceData*)(data.data() + instanceRenderer.getInstanceBuffer().getRegionOffset());
+        for(unsigned int i = 0; i < 6; i++) {
+            result << instanceData[i].transform[12] << " " << instanceData[i].customData[0] << ", ";
+        }
+        instanceRenderer.destroy();
+    }
+    expected << "3, 3 3 0, 6 2 3, 3 1 0, 1, 3, 2, 0, 1, 0, 0 0, 3 3, 5 5, 1 1, 4 4, 2 2, ";
+    CompareResult(ERROR_INFO, expected, result, failedCount);
+    
+    // A full renderer throws
+    result = std::stringstream();
+    expected = std::stringstream();
+    {
+        Mesh mesh(CreateTestMeshData(3), TexturedMaterial(), UnTexturedMaterial());
+        InstanceRenderer instanceRenderer(1);
+        instanceRenderer.addInstance(mesh, Mat4f(1.0f));
+        try {
+            instanceRenderer.addInstance(mesh, Mat4f(1.0f));
+            result << "no exception";
+        }
+        catch(MeshException& e) {
+            result << "exception";
+        }
+        instanceRenderer.destroy();
+    }
+    expected << "exception";
+    CompareResult(ERROR_INFO, expected, result, failedCount);
+    
+    ResourceReclaimer::ReclaimAll();
+    return failedCount;
+}
+
+int TestModelInstancing() {
+    std::stringstream result;
+    std::stringstream expected;
+    int failedCount = 0;
+    GeometryHeap::Destroy();
+    HeadlessGL::Reset();
+    
+    // Models sharing their model data draw each mesh once for all instances
+    result = std::stringstream();
+    expected = std::stringstream();
+    {
+        std::vector<Mesh> meshes;
+        meshes.push_back(Mesh(CreateTestMeshData(3), TexturedMaterial(), UnTexturedMaterial()));
+        meshes.push_back(Mesh(CreateTestMeshData(6), TexturedMaterial(), UnTexturedMaterial()));
+        Model tree(std::make_shared<ModelData>(meshes));
+        Model otherTree(tree);
+        
+        InstanceRenderer instanceRenderer(256);
+        for(unsigned int frame = 0; frame < 2; frame++) {
+            for(unsigned int i = 0; i < 50; i++) {
+                instanceRenderer.addModelInstance((i % 2 == 0) ? tree : otherTree, createTranslationMat(createVec3<float>((float)i, 0.0f, 0.0f)));
+            }
+            HeadlessGL::ClearCallLog();
+            instanceRenderer.render([](const TexturedMaterial& texturedMaterial) {});
+        }
+        result << HeadlessGL::GetCallCount("glDrawElementsInstancedBaseVertex") << ", " << HeadlessGL::GetDrawLog()[0].instanceCount << ", "
+                << instanceRenderer.getFrameStats().numInstances << ", " << instanceRenderer.getFrameStats().getInstancingRatio() << ", "
+                << instanceRenderer.getTotalStats().numInstances << " " << instanceRenderer.getTotalStats().numDrawCalls << ", "
+                << instanceRenderer.getInstanceBuffer().getRegionOffset() / sizeof(InstanceData);
+        instanceRenderer.resetStats();
+        result << ", " << instanceRenderer.getTotalStats().getInstancingRatio();
+        instanceRenderer.destroy();
+    }
+    expected << "2, 50, 100, 50, 200 4, 256, 0";
+    CompareResult(ERROR_INFO, expected, result, failedCount);
+    
+    ResourceReclaimer::ReclaimAll();
+    return failedCount;
+}
+
+};
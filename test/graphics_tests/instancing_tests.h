@@ -0,0 +1,22 @@
+#ifndef INSTANCING_TESTS_H
+#define INSTANCING_TESTS_H
+
+#include <iostream>
+#include <string>
+#include <graphics/model/instance_renderer.h>
+#include <graphics/buffer/resource_reclaimer.h>
+#include <math/linear_math.h>
+#include <headless_gl.h>
+#include <test_exception.h>
+#include <test_comparison.h>
+#include <test_meshes.h>
+
+namespace Tests::InstancingTests {
+
+int DoTests();
+int TestInstanceGrouping();
+int TestModelInstancing();
+
+};
+
+#endif //INSTANCING_TESTS_H
@@ -0,0 +1,342 @@
+#include "job_system_tests.h"
+#include <atomic>
+#include <thread>
+#include <chrono>
+#include <vector>
+
+using namespace Engine;
+
+namespace Tests::JobSystemTests {
+
+int DoTests() {
+    int failedCount = 0;
+    
+    failedCount += TestWorkStealingDeque();
+    failedCount += TestJobCounters();
+    failedCount += TestParallelFor();
+    failedCount += TestMainThreadJobs();
+    failedCount += TestJobSystemStats();
+    
+    JobSystem::Shutdown();
+    JobSystem::SetNumWorkerThreads(0);
+    return failedCount;
+}
+
+int TestWorkStealingDeque() {
+    std::stringstream result;
+    std::stringstream expected;
+    int failedCount = 0;
+    
+    // The owner takes the newest job and thieves the oldest, and the deque grows past its capacity
+    result = std::stringstream();
+    expected = std::stringstream();
+    std::vector<Job> jobs(6);
+    WorkStealingDeque deque(4);
+    for(unsigned int i = 0; i < jobs.size(); i++) {
+        deque.push(&jobs[i]);
+    }
+    result << deque.getSize() << " " << deque.getCapacity() << ", " << (deque.pop() - jobs.data()) << " " << (deque.steal() - jobs.data()) << " ";
+    while(Job* job = deque.pop()) {
+        result << (job - jobs.data()) << " ";
+    }
+    result << (deque.steal() == nullptr) << " " << deque.getSize();
+    expected << "6 8, 5 0 4 3 2 1 1 0";
+    CompareResult(ERROR_INFO, expected, result, failedCount);
+    
+    // Every job is taken exactly once while thieves race the owner
+    result = std::stringstream();
+    expected = std::stringstream();
+    const unsigned int numJobs = 20000;
+    std::vector<Job> raceJobs(numJobs);
+    std::vector<std::atomic<unsigned int>> takenCounts(numJobs);
+    WorkStealingDeque raceDeque(16);
+    std::atomic<bool> done(false);
+    auto take = [&raceJobs, &takenCounts](Job* job) {
+        if(job != nullptr) {
+            takenCounts[job - raceJobs.data()]++;
+        }
+    };
+    std::vector<std::thread> thieves;
+    for(unsigned int t = 0; t < 3; t++) {
+        thieves.emplace_back([&raceDeque, &done, &take]() {
+            while(!done.load()) {
+                take(raceDeque.steal());
+            }
+        });
+    }
+    for(unsigned int i = 0; i < numJobs; i++) {
+        raceDeque.push(&raceJobs[i]);
+        if(i % 3 == 0) {
+            take(raceDeque.pop());
+        }
+    }
+    while(raceDeque.getSize() > 0) {
+        take(raceDeque.pop());
+    }
+    done.store(true);
+    for(unsigned int t = 0; t < thieves.size(); t++) {
+        thieves[t].join();
+    }
+    unsigned int numTakenOnce = 0;
+    for(unsigned int i = 0; i < numJobs; i++) {
+        numTakenOnce += (takenCounts[i].load() == 1);
+    }
+    result << numTakenOnce;
+    expected << numJobs;
+    CompareResult(ERROR_INFO, expected, result, failedCount);
+    
+    return failedCount;
+}
+
+int TestJobCounters() {
+    std::stringstream result;
+    std::stringstream expected;
+    int failedCount = 0;
+    JobSystem::Shutdown();
+    JobSystem::SetNumWorkerThreads(3);
+    JobSystem::Start();
+    
+    // Waiting returns once every job counted by the counter has run
+    result = std::stringstream();
+    expected = std::stringstream();
+    std::atomic<unsigned int> numRun(0);
+    JobCounter counter;
+    for(unsigned int i = 0; i < 100; i++) {
+        JobSystem::Run([&numRun]() { numRun++; }, counter);
+    }
+    JobSystem::Wait(counter);
+    result << JobSystem::IsRunning() << " " << JobSystem::GetNumRunningWorkerThreads() << " " << JobSystem::IsMainThread() << ", " << numRun.load() << " "
+            << counter.getCount();
+    expected << "1 3 1, 100 0";
+    CompareResult(ERROR_INFO, expected, result, failedCount);
+    
+    // A dependent job is held back until every job of its dependency has finished
+    result = std::stringstream();
+    expected = std::stringstream();
+    std::atomic<unsigned int> numSlowRun(0);
+    unsigned int numSlowRunSeen = 0;
+    JobCounter slowCounter;
+    JobCounter dependentCounter;
+    for(unsigned int i = 0; i < 8; i++) {
+        JobSystem::Run([&numSlowRun]() {
+            std::this_thread::sleep_for(std::chrono::milliseconds(2));
+            numSlowRun++;
+        }, slowCounter);
+    }
+    JobSystem::Run([&numSlowRun, &numSlowRunSeen]() { numSlowRunSeen = numSlowRun.load(); }, dependentCounter, slowCounter);
+    result << dependentCounter.getCount() << " ";
+    JobSystem::Wait(dependentCounter);
+    result << numSlowRunSeen << " " << slowCounter.isDone() << " ";
+    // With the dependency already done, the job is queued straight away
+    JobSystem::Run([&numSlowRunSeen]() { numSlowRunSeen++; }, dependentCounter, slowCounter);
+    JobSystem::Wait(dependentCounter);
+    result << numSlowRunSeen;
+    expected << "1 8 1 9";
+    CompareResult(ERROR_INFO, expected, result, failedCount);
+    
+    // The first exception thrown by a job is rethrown by Wait, once its other jobs are done
+    result = std::stringstream();
+    expected = std::stringstream();
+    JobCounter failingCounter;
+    std::atomic<unsigned int> numFailingRun(0);
+    for(unsigned int i = 0; i < 10; i++) {
+        JobSystem::Run([&numFailingRun, i]() {
+            numFailingRun++;
+            if(i == 5) {
+                throw RenderException("ERROR: Test exception.");
+            }
+        }, failingCounter);
+    }
+    try {
+        JobSystem::Wait(failingCounter);
+        result << "returned ";
+    }
+    catch(RenderException& e) {
+        result << "threw ";
+    }
+    result << numFailingRun.load() << " " << failingCounter.getCount() << ", ";
+    JobSystem::Wait(failingCounter);
+    result << "returned";
+    expected << "threw 10 0, returned";
+    CompareResult(ERROR_INFO, expected, result, failedCount);
+    
+    return failedCount;
+}
+
+int TestParallelFor() {
+    std::stringstream result;
+    std::stringstream expected;
+    int failedCount = 0;
+    
+    // Every index is visited exactly once, in ranges no larger than the grain size
+    result = std::stringstream();
+    expected = std::stringstream();
+    const size_t numValues = 10000;
+    std::vector<unsigned int> values(numValues, 0);
+    std::atomic<size_t> largestRange(0);
+    std::atomic<unsigned int> numRanges(0);
+    JobSystem::ParallelFor(0, numValues, 64, [&values, &largestRange, &numRanges](size_t first, size_t last) {
+        for(size_t i = first; i < last; i++) {
+            values[i] += i + 1;
+        }
+        size_t largest = largestRange.load();
+        while(last - first > largest && !largestRange.compare_exchange_weak(largest, last - first)) {}
+        numRanges++;
+    });
+    unsigned int numCorrect = 0;
+    unsigned long long sum = 0;
+    for(size_t i = 0; i < numValues; i++) {
+        numCorrect += (values[i] == i + 1);
+        sum += values[i];
+    }
+    result << numCorrect << " " << sum << " " << (largestRange.load() <= 64) << " " << numRanges.load();
+    expected << "10000 50005000 1 256";
+    CompareResult(ERROR_INFO, expected, result, failedCount);
+    
+    // A range within the grain size runs on the calling thread, and an empty one doesn't run at all
+    result = std::stringstream();
+    expected = std::stringstream();
+    std::thread::id callingThreadID;
+    unsigned int numCalls = 0;
+    JobSystem::ParallelFor(5, 15, 64, [&callingThreadID, &numCalls](size_t first, size_t last) {
+        callingThreadID = std::this_thread::get_id();
+        numCalls++;
+    });
+    JobSystem::ParallelFor(7, 7, 1, [&numCalls](size_t first, size_t last) { numCalls++; });
+    result << (callingThreadID == std::this_thread::get_id()) << " " << numCalls;
+    expected << "1 1";
+    CompareResult(ERROR_INFO, expected, result, failedCount);
+    
+    // Loops run from jobs wait by running jobs, so nesting them doesn't tie up the workers
+    result = std::stringstream();
+    expected = std::stringstream();
+    std::atomic<unsigned long long> nestedSum(0);
+    JobSystem::ParallelFor(0, 8, 1, [&nestedSum](size_t first, size_t last) {
+        for(size_t outer = first; outer < last; outer++) {
+            JobSystem::ParallelFor(0, 1000, 10, [&nestedSum](size_t innerFirst, size_t innerLast) {
+                for(size_t inner = innerFirst; inner < innerLast; inner++) {
+                    nestedSum += inner;
+                }
+            });
+        }
+    });
+    result << nestedSum.load();
+    expected << 8 * 499500;
+    CompareResult(ERROR_INFO, expected, result, failedCount);
+    
+    // An exception thrown by a range is passed on after the other ranges are done
+    result = std::stringstream();
+    expected = std::stringstream();
+    std::atomic<unsigned int> numRangesRun(0);
+    try {
+        JobSystem::ParallelFor(0, 100, 1, [&numRangesRun](size_t first, size_t last) {
+            numRangesRun++;
+            if(first == 50) {
+                throw RenderException("ERROR: Test exception.");
+            }
+        });
+        result << "returned ";
+    }
+    catch(RenderException& e) {
+        result << "threw ";
+    }
+    result << numRangesRun.load();
+    expected << "threw 100";
+    CompareResult(ERROR_INFO, expected, result, failedCount);
+    
+    return failedCount;
+}
+
+int TestMainThreadJobs() {
+    std::stringstream result;
+    std::stringstream expected;
+    int failedCount = 0;
+    
+    // Main thread jobs wait for ProcessMainThreadJobs
+    result = std::stringstream();
+    expected = std::stringstream();
+    std::thread::id mainThreadJobThreadID;
+    JobCounter counter;
+    JobSystem::RunOnMainThread([&mainThreadJobThreadID]() { mainThreadJobThreadID = std::this_thread::get_id(); }, counter);
+    std::this_thread::sleep_for(std::chrono::milliseconds(5));
+    result << JobSystem::GetNumPendingMainThreadJobs() << " " << counter.getCount() << ", " << JobSystem::ProcessMainThreadJobs() << " "
+            << JobSystem::GetNumPendingMainThreadJobs() << " " << counter.getCount() << " " << (mainThreadJobThreadID == std::this_thread::get_id());
+    expected << "1 1, 1 0 0 1";
+    CompareResult(ERROR_INFO, expected, result, failedCount);
+    
+    // Jobs on workers hand work back to the main thread, which runs it while waiting
+    result = std::stringstream();
+    expected = std::stringstream();
+    std::vector<std::thread::id> threadIDs(16);
+    std::atomic<unsigned int> numOnWorkers(0);
+    JobCounter workerCounter;
+    JobCounter mainThreadCounter;
+    for(unsigned int i = 0; i < threadIDs.size(); i++) {
+        JobSystem::Run([&threadIDs, &numOnWorkers, &mainThreadCounter, i]() {
+            numOnWorkers += !JobSystem::IsMainThread();
+            JobSystem::RunOnMainThread([&threadIDs, i]() { threadIDs[i] = std::this_thread::get_id(); }, mainThreadCounter);
+        }, workerCounter);
+    }
+    JobSystem::Wait(workerCounter);
+    JobSystem::Wait(mainThreadCounter);
+    unsigned int numOnMainThread = 0;
+    for(unsigned int i = 0; i < threadIDs.size(); i++) {
+        numOnMainThread += (threadIDs[i] == std::this_thread::get_id());
+    }
+    result << numOnMainThread << " " << JobSystem::GetNumPendingMainThreadJobs() << " " << (JobSystem::GetStats().numMainThreadJobsRun >= 17);
+    expected << "16 0 1";
+    CompareResult(ERROR_INFO, expected, result, failedCount);
+    
+    return failedCount;
+}
+
+int TestJobSystemStats() {
+    std::stringstream result;
+    std::stringstream expected;
+    int failedCount = 0;
+    JobSystem::Shutdown();
+    std::atomic<unsigned int> numStealCalls(0);
+    std::atomic<unsigned int> numBadSteals(0);
+    std::atomic<unsigned int> numIdleCalls(0);
+    JobSystemHooks hooks;
+    hooks.onSteal = [&numStealCalls, &numBadSteals](const unsigned int thiefIndex, const unsigned int victimIndex) {
+        numStealCalls++;
+        numBadSteals += (thiefIndex == victimIndex || thiefIndex > 3 || victimIndex > 3);
+    };
+    hooks.onIdle = [&numIdleCalls](const unsigned int threadIndex, const double idleMilliseconds) {
+        numIdleCalls++;
+    };
+    JobSystem::SetHooks(hooks);
+    JobSystem::SetNumWorkerThreads(3);
+    JobSystem::Start();
+    
+    // Jobs the main thread splits off are stolen by idle workers, and each steal is reported to the hook
+    result = std::stringstream();
+    expected = std::stringstream();
+    JobSystem::ResetStats();
+    JobSystem::ParallelFor(0, 64, 1, [](size_t first, size_t last) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    });
+    JobSystemStats stats = JobSystem::GetStats();
+    unsigned long long numWorkerJobsRun = 0;
+    for(unsigned int i = 1; i <= 3; i++) {
+        numWorkerJobsRun += JobSystem::GetThreadStats(i).numJobsRun;
+    }
+    result << stats.numJobsRun << " " << (stats.numJobsStolen > 0) << " " << (numStealCalls.load() == stats.numJobsStolen) << " " << numBadSteals.load() << " "
+            << (numWorkerJobsRun > 0) << " " << (numWorkerJobsRun + JobSystem::GetThreadStats(0).numJobsRun);
+    expected << "63 1 1 0 1 63";
+    CompareResult(ERROR_INFO, expected, result, failedCount);
+    
+    // Workers report the time they spent without jobs
+    result = std::stringstream();
+    expected = std::stringstream();
+    JobSystem::Shutdown();
+    result << (numIdleCalls.load() > 0) << " " << JobSystem::IsRunning();
+    expected << "1 0";
+    CompareResult(ERROR_INFO, expected, result, failedCount);
+    JobSystem::SetHooks(JobSystemHooks());
+    
+    return failedCount;
+}
+
+}
@@ -0,0 +1,23 @@
+#ifndef JOB_SYSTEM_TESTS_H
+#define JOB_SYSTEM_TESTS_H
+
+#include <iostream>
+#include <string>
+#include <jobs/job_system.h>
+#include <jobs/work_stealing_deque.h>
+#include <exceptions/render_exception.h>
+#include <test_exception.h>
+#include <test_comparison.h>
+
+namespace Tests::JobSystemTests {
+
+int DoTests();
+int TestWorkStealingDeque();
+int TestJobCounters();
+int TestParallelFor();
+int TestMainThreadJobs();
+int TestJobSystemStats();
+
+};
+
+#endif //JOB_SYSTEM_TESTS_H
@@ -0,0 +1,229 @@
+#include "material_parameter_block_tests.h"
+#include <map>
+#include <cstring>
+
+using namespace Engine;
+
+namespace Tests::MaterialParameterBlockTests {
+
+int DoTests() {
+    int failedCount = 0;
+    
+    failedCount += TestShaderProgramIDs();
+    failedCount += TestParameterBlocks();
+    failedCount += TestMaterialParameterBlocks();
+    
+    return failedCount;
+}
+
+static const std::map<std::string, std::string> shaderSources = {
+    {"a.vs.glsl", "#version 430 core\nuniform mat4 transform;\nvoid main() { gl_Position = transform * vec4(0.0); }\n"},
+    {"plain.fs.glsl", "#version 430 core\nuniform sampler2D texture0;\nuniform sampler2D texture1;\nout vec4 color;\nvoid main() { color = vec4(1.0); }\n"},
+    {"block.fs.glsl", "#version 430 core\nuniform sampler2D texture0;\nuniform sampler2D texture1;\n"
+            "layout (std140) uniform MaterialParameters {\n    vec4 textureMixingWeights;\n};\nout vec4 color;\nvoid main() { color = textureMixingWeights; }\n"}
+};
+
+/*
+ * Resets the emulated context and loads shader files from shaderSources.
+ */
+static void resetState() {
+    ShaderLoader::Destroy();
+    GeometryHeap::Destroy();
+    HeadlessGL::Reset();
+    MaterialParameterBlock::ResetStats();
+    ShaderLoader::GetShaderPreprocessor() = ShaderPreprocessor([](const std::string& filePath, std::string& source) {
+        std::map<std::string, std::string>::const_iterator iter = shaderSources.find(filePath);
+        if(iter == shaderSources.end()) {
+            return false;
+        }
+        source = iter->second;
+        return true;
+    });
+}
+
+/*
+ * Returns the floats of the range bound to the material parameters binding point.
+ */
+static std::vector<float> getBoundConstants() {
+    HeadlessGL::BufferRange range = HeadlessGL::GetBoundBufferRange(GL_UNIFORM_BUFFER, MaterialParameterBlock::MATERIAL_PARAMETERS_BINDING);
+    std::vector<unsigned char> data = HeadlessGL::GetBufferData(range.buffer);
+    std::vector<float> constants(range.size / sizeof(float));
+    std::memcpy(constants.data(), data.data() + range.offset, range.size);
+    return constants;
+}
+
+int TestShaderProgramIDs() {
+    std::stringstream result;
+    std::stringstream expected;
+    int failedCount = 0;
+    resetState();
+    
+    // A name keeps its ID, and looking a program up by either gives the same program
+    result = std::stringstream();
+    expected = std::stringstream();
+    ShaderLoader::LoadShaderPrograms({{"idA", "a.vs.glsl", "", "plain.fs.glsl"}, {"idB", "a.vs.glsl", "", "block.fs.glsl"}});
+    ShaderProgramID idA = ShaderLoader::GetShaderProgramID("idA");
+    ShaderProgramID idB = ShaderLoader::GetShaderProgramID("idB");
+    ShaderProgramPtr programAPtr = ShaderLoader::getShaderProgram("idA");
+    result << (idA == ShaderLoader::GetShaderProgramID("idA")) << (idA != idB) << " " << (ShaderLoader::getShaderProgram(idA) == programAPtr)
+            << (ShaderLoader::getShaderProgram(idB) == ShaderLoader::getShaderProgram("idB")) << " " << programAPtr->getShaderProgramName();
+    expected << "11 11 idA";
+    CompareResult(ERROR_INFO, expected, result, failedCount);
+    
+    // A name can be given an ID before its program is loaded
+    result = std::stringstream();
+    expected = std::stringstream();
+    ShaderProgramID idLater = ShaderLoader::GetShaderProgramID("idLater");
+    result << (ShaderLoader::getShaderProgram(idLater) == nullptr) << " ";
+    ShaderLoader::LoadShaderPrograms({{"idLater", "a.vs.glsl", "", "plain.fs.glsl"}});
+    result << (ShaderLoader::getShaderProgram(idLater) == ShaderLoader::getShaderProgram("idLater")) << (ShaderLoader::getShaderProgram(idLater) != nullptr)
+            << (ShaderLoader::GetShaderProgramID("idLater") == idLater);
+    expected << "1 111";
+    CompareResult(ERROR_INFO, expected, result, failedCount);
+    
+    // Loading a name again replaces its program under the same ID
+    result = std::stringstream();
+    expected = std::stringstream();
+    ShaderLoader::LoadShaderPrograms({{"idA", "a.vs.glsl", "", "block.fs.glsl"}});
+    result << (ShaderLoader::getShaderProgram("idA") != programAPtr) << (ShaderLoader::getShaderProgram(idA) == ShaderLoader::getShaderProgram("idA"))
+            << (ShaderLoader::GetShaderProgramID("idA") == idA) << " ";
+    
+    // Destroying the programs keeps the IDs
+    ShaderLoader::Destroy();
+    result << (ShaderLoader::getShaderProgram(idA) == nullptr) << (ShaderLoader::GetShaderProgramID("idB") == idB);
+    expected << "111 11";
+    CompareResult(ERROR_INFO, expected, result, failedCount);
+    
+    ShaderLoader::GetShaderPreprocessor() = ShaderPreprocessor();
+    return failedCount;
+}
+
+int TestParameterBlocks() {
+    std::stringstream result;
+    std::stringstream expected;
+    int failedCount = 0;
+    resetState();
+    ShaderLoader::LoadShaderPrograms({{"block", "a.vs.glsl", "", "block.fs.glsl"}, {"plain", "a.vs.glsl", "", "plain.fs.glsl"}});
+    ShaderProgramPtr shaderProgramPtr = ShaderLoader::getShaderProgram("block");
+    GLuint program = shaderProgramPtr->getProgram();
+    TextureDataPtr textureDataPtr = std::make_shared<TextureData>(4, 1, 4, SharedBuffer<unsigned char>(std::vector<unsigned char>(16, 255)));
+    std::vector<Texture> textures = {Texture(textureDataPtr, TEXTURE_DIFFUSE), Texture(textureDataPtr, TEXTURE_SPECULAR)};
+    
+    // Creating a block assigns the sampler units and the uniform block binding on the program
+    result = std::stringstream();
+    expected = std::stringstream();
+    MaterialParameterBlock block(shaderProgramPtr, textures, {0, 0}, {1.0f, 0.5f});
+    result << block.getSamplerLocations().size() << (block.getSamplerLocations()[0] != -1) << (block.getSamplerLocations()[1] != -1) << " ";
+    std::vector<float> units = HeadlessGL::GetUniformValues(program, "texture1");
+    for(unsigned int i = 0; i < units.size(); i++) {
+        result << units[i] << " ";
+    }
+    result << block.hasConstantBlock() << " " << HeadlessGL::GetUniformBlockBinding(program, "MaterialParameters") << " " << block.getConstantData().size();
+    expected << "211 1 1 0 16";
+    CompareResult(ERROR_INFO, expected, result, failedCount);
+    
+    // Applying looks nothing up and copies the constants once per frame
+    result = std::stringstream();
+    expected = std::stringstream();
+    HeadlessGL::ClearCallLog();
+    block.apply();
+    block.apply();
+    block.apply();
+    HeadlessGL::BufferRange range = HeadlessGL::GetBoundBufferRange(GL_UNIFORM_BUFFER, MaterialParameterBlock::MATERIAL_PARAMETERS_BINDING);
+    result << HeadlessGL::GetCallCount("glGetUniformLocation") << HeadlessGL::GetCallCount("glProgramUniform1i") << HeadlessGL::GetCallCount("glUniform1i") << " "
+            << HeadlessGL::GetCallCount("glBindBufferRange") << " " << MaterialParameterBlock::GetStats().numApplies << " "
+            << MaterialParameterBlock::GetStats().constantBytesCopied << " " << (range.buffer == MaterialParameterBlock::GetUniformRing().getBufferName())
+            << " " << range.size << " " << (HeadlessGL::GetCurrentProgram() == program) << " ";
+    std::vector<float> constants = getBoundConstants();
+    for(unsigned int i = 0; i < constants.size(); i++) {
+        result << constants[i] << " ";
+    }
+    expected << "000 1 3 16 1 16 1 1 0.5 0 0";
+    CompareResult(ERROR_INFO, expected, result, failedCount);
+    
+    // The next frame copies them again, at an offset aligned for uniform buffers
+    result = std::stringstream();
+    expected = std::stringstream();
+    MaterialParameterBlock::EndFrame();
+    block.apply();
+    HeadlessGL::BufferRange nextRange = HeadlessGL::GetBoundBufferRange(GL_UNIFORM_BUFFER, MaterialParameterBlock::MATERIAL_PARAMETERS_BINDING);
+    result << MaterialParameterBlock::GetStats().constantBytesCopied << " " << (nextRange.offset % 256) << " "
+            << getBoundConstants()[1];
+    expected << "32 0 0.5";
+    CompareResult(ERROR_INFO, expected, result, failedCount);
+    
+    // A sampler given for a texture is bound with it, and a program without the uniform block binds no constants
+    result = std::stringstream();
+    expected = std::stringstream();
+    SamplerDescription samplerDescription;
+    samplerDescription.lodBias = 1.0f;
+    GLuint sampler = SamplerCache::GetSampler(samplerDescription);
+    MaterialParameterBlock plainBlock(ShaderLoader::getShaderProgram("plain"), textures, {0, sampler}, {1.0f, 0.5f});
+    HeadlessGL::ClearCallLog();
+    plainBlock.apply();
+    result << plainBlock.hasConstantBlock() << " " << HeadlessGL::GetCallCount("glBindBufferRange") << " " << (HeadlessGL::GetUnitSampler(1) == sampler)
+            << (HeadlessGL::GetUnitSampler(0) != sampler) << " " << HeadlessGL::GetNumErrors();
+    expected << "0 0 11 0";
+    CompareResult(ERROR_INFO, expected, result, failedCount);
+    
+    MaterialParameterBlock::Destroy();
+    ShaderLoader::Destroy();
+    ShaderLoader::GetShaderPreprocessor() = ShaderPreprocessor();
+    return failedCount;
+}
+
+int TestMaterialParameterBlocks() {
+    std::stringstream result;
+    std::stringstream expected;
+    int failedCount = 0;
+    resetState();
+    ShaderLoader::LoadShaderPrograms({{"block", "a.vs.glsl", "", "block.fs.glsl"}});
+    TextureDataPtr textureDataPtr = std::make_shared<TextureData>(4, 1, 4, SharedBuffer<unsigned char>(std::vector<unsigned char>(16, 255)));
+    std::vector<Texture> textures = {Texture(textureDataPtr, TEXTURE_DIFFUSE), Texture(textureDataPtr, TEXTURE_SPECULAR)};
+    
+    // Copies of a material share its block once it's created
+    result = std::stringstream();
+    expected = std::stringstream();
+    TexturedMaterial texturedMaterial("block", textures, {1.0f, 1.0f});
+    texturedMaterial.apply();
+    TexturedMaterial otherMaterial = texturedMaterial;
+    HeadlessGL::ClearCallLog();
+    otherMaterial.apply();
+    result << (otherMaterial.getParameterBlock() == texturedMaterial.getParameterBlock()) << " " << HeadlessGL::GetCallCount("glGetUniformLocation") << " "
+            << getBoundConstants()[0] << getBoundConstants()[1];
+    expected << "1 0 11";
+    CompareResult(ERROR_INFO, expected, result, failedCount);
+    
+    // Changing the material creates a new block
+    result = std::stringstream();
+    expected = std::stringstream();
+    std::shared_ptr<const MaterialParameterBlock> blockPtr = texturedMaterial.getParameterBlock();
+    texturedMaterial.setTextureMixingWeights({0.25f, 0.75f});
+    texturedMaterial.apply();
+    result << (texturedMaterial.getParameterBlock() != blockPtr) << (otherMaterial.getParameterBlock() == blockPtr) << " " << getBoundConstants()[0] << " "
+            << getBoundConstants()[1] << ", ";
+    
+    // Overriding the sampling binds a shared sampler object
+    texturedMaterial.setLodBias(2.0f);
+    texturedMaterial.apply();
+    SamplerDescription samplerDescription = TextureLoader::GetSamplerDescription(textures[0].getTextureID());
+    samplerDescription.lodBias += 2.0f;
+    result << (HeadlessGL::GetUnitSampler(0) == SamplerCache::GetSampler(samplerDescription)) << " ";
+    
+    // Setting another program does too
+    ShaderLoader::LoadShaderPrograms({{"blockToo", "a.vs.glsl", "", "block.fs.glsl"}});
+    blockPtr = texturedMaterial.getParameterBlock();
+    texturedMaterial.setShaderProgramPtr(ShaderLoader::getShaderProgram("blockToo"));
+    texturedMaterial.apply();
+    result << (texturedMaterial.getParameterBlock() != blockPtr) << (HeadlessGL::GetCurrentProgram() == ShaderLoader::getShaderProgram("blockToo")->getProgram())
+            << " " << HeadlessGL::GetNumErrors();
+    expected << "11 0.25 0.75, 1 11 0";
+    CompareResult(ERROR_INFO, expected, result, failedCount);
+    
+    MaterialParameterBlock::Destroy();
+    ShaderLoader::Destroy();
+    ShaderLoader::GetShaderPreprocessor() = ShaderPreprocessor();
+    return failedCount;
+}
+
+}
@@ -0,0 +1,24 @@
+#ifndef MATERIAL_PARAMETER_BLOCK_TESTS_H
+#define MATERIAL_PARAMETER_BLOCK_TESTS_H
+
+#include <iostream>
+#include <string>
+#include <graphics/shaders/shaders.h>
+#include <graphics/material/material.h>
+#include <graphics/material/material_parameter_block.h>
+#include <graphics/texture/sampler_cache.h>
+#include <graphics/buffer/geometry_heap.h>
+#include <headless_gl.h>
+#include <test_exception.h>
+#include <test_comparison.h>
+
+namespace Tests::MaterialParameterBlockTests {
+
+int DoTests();
+int TestShaderProgramIDs();
+int TestParameterBlocks();
+int TestMaterialParameterBlocks();
+
+};
+
+#endif //MATERIAL_PARAMETER_BLOCK_TESTS_H
@@ -0,0 +1,242 @@
+#include "mipmap_tests.h"
+#include <filesystem>
+#include <fstream>
+
+using namespace Engine;
+
+namespace Tests::MipmapTests {
+
+int DoTests() {
+    int failedCount = 0;
+    
+    failedCount += TestBoxFilter();
+    failedCount += TestSRGBFiltering();
+    failedCount += TestKaiserFilter();
+    failedCount += TestLevelUploads();
+    failedCount += TestBatchLoading();
+    
+    return failedCount;
+}
+
+/*
+ * Returns a grey image with numChannels channels from one value per pixel.
+ */
+static std::vector<unsigned char> createGreyImage(const std::vector<unsigned char>& values, const unsigned int numChannels) {
+    std::vector<unsigned char> pixels;
+    for(unsigned int i = 0; i < values.size(); i++) {
+        for(unsigned int c = 0; c < numChannels; c++) {
+            pixels.push_back(values[i]);
+        }
+    }
+    return pixels;
+}
+
+/*
+ * Writes a width by height binary PPM image filled with value to the temporary directory.
+ */
+static std::string writeTestImage(const std::string& fileName, const unsigned int width, const unsigned int height, const unsigned char value) {
+    std::string filePath = (std::filesystem::temp_directory_path() / fileName).string();
+    std::ofstream outFile(filePath, std::ios_base::out | std::ios_base::binary);
+    outFile << "P6\n" << width << " " << height << "\n255\n";
+    for(unsigned int i = 0; i < width * height * 3; i++) {
+        outFile.put((char)value);
+    }
+    return filePath;
+}
+
+int TestBoxFilter() {
+    std::stringstream result;
+    std::stringstream expected;
+    int failedCount = 0;
+    
+    // Each level averages 2x2 blocks of the unrounded level above it
+    result = std::stringstream();
+    expected = std::stringstream();
+    std::vector<unsigned char> pixels = createGreyImage({0, 100, 200, 40, 20, 60, 80, 120}, 3);
+    std::vector<SharedBuffer<unsigned char>> mipLevels = MipmapGenerator::GenerateMipLevels(pixels.data(), 4, 2, 3, MIPMAP_FILTER_BOX, false);
+    result << mipLevels.size() << " " << MipmapGenerator::GetNumLevels(4, 2) << ", " << mipLevels[0].getSize() << " " << mipLevels[1].getSize() << ", "
+            << (int)mipLevels[0][0] << " " << (int)mipLevels[0][5] << " " << (int)mipLevels[1][0];
+    expected << "2 3, 6 3, 45 110 78";
+    CompareResult(ERROR_INFO, expected, result, failedCount);
+    
+    // Odd sizes spread the middle pixel over both neighbors, and a 1 pixel axis is left as is
+    result = std::stringstream();
+    expected = std::stringstream();
+    std::vector<unsigned char> oddPixels = createGreyImage({0, 30, 90}, 1);
+    std::vector<SharedBuffer<unsigned char>> oddMipLevels = MipmapGenerator::GenerateMipLevels(oddPixels.data(), 3, 1, 1, MIPMAP_FILTER_BOX, false);
+    std::vector<unsigned char> tallPixels = createGreyImage({10, 30, 50, 70}, 1);
+    std::vector<SharedBuffer<unsigned char>> tallMipLevels = MipmapGenerator::GenerateMipLevels(tallPixels.data(), 1, 4, 1, MIPMAP_FILTER_BOX, false);
+    result << oddMipLevels.size() << " " << (int)oddMipLevels[0][0] << ", " << tallMipLevels.size() << " " << (int)tallMipLevels[0][0] << " "
+            << (int)tallMipLevels[0][1] << " " << (int)tallMipLevels[1][0] << ", " << MipmapGenerator::GetLevelSize(5, 1) << " "
+            << MipmapGenerator::GetLevelSize(5, 3) << " " << MipmapGenerator::GetNumLevels(1, 1);
+    expected << "1 40, 2 20 60 40, 2 1 1";
+    CompareResult(ERROR_INFO, expected, result, failedCount);
+    
+    return failedCount;
+}
+
+int TestSRGBFiltering() {
+    std::stringstream result;
+    std::stringstream expected;
+    int failedCount = 0;
+    
+    // Averaging black and white in linear space gives sRGB 188 rather than 128, but alpha is averaged as is
+    result = std::stringstream();
+    expected = std::stringstream();
+    std::vector<unsigned char> pixels = createGreyImage({0, 255}, 4);
+    std::vector<SharedBuffer<unsigned char>> sRGBMipLevels = MipmapGenerator::GenerateMipLevels(pixels.data(), 2, 1, 4, MIPMAP_FILTER_BOX, true);
+    std::vector<SharedBuffer<unsigned char>> linearMipLevels = MipmapGenerator::GenerateMipLevels(pixels.data(), 2, 1, 4, MIPMAP_FILTER_BOX, false);
+    result << (int)sRGBMipLevels[0][0] << " " << (int)sRGBMipLevels[0][2] << " " << (int)sRGBMipLevels[0][3] << ", "
+            << (int)linearMipLevels[0][0] << " " << (int)linearMipLevels[0][3];
+    expected << "188 188 128, 128 128";
+    CompareResult(ERROR_INFO, expected, result, failedCount);
+    
+    // Every code survives the round trip through linear space
+    result = std::stringstream();
+    expected = std::stringstream();
+    unsigned int numMismatches = 0;
+    for(unsigned int i = 0; i < 256; i++) {
+        if(MipmapGenerator::LinearToSRGB(MipmapGenerator::SRGBToLinear((unsigned char)i)) != i) {
+            numMismatches++;
+        }
+    }
+    result << numMismatches << " " << (int)MipmapGenerator::LinearToSRGB(0.0f) << " " << (int)MipmapGenerator::LinearToSRGB(1.0f);
+    expected << "0 0 255";
+    CompareResult(ERROR_INFO, expected, result, failedCount);
+    
+    return failedCount;
+}
+
+int TestKaiserFilter() {
+    std::stringstream result;
+    std::stringstream expected;
+    int failedCount = 0;
+    
+    // A flat image stays flat, since the weights are normalized
+    result = std::stringstream();
+    expected = std::stringstream();
+    std::vector<unsigned char> flatPixels(8 * 8 * 3, 77);
+    std::vector<SharedBuffer<unsigned char>> flatMipLevels = MipmapGenerator::GenerateMipLevels(flatPixels.data(), 8, 8, 3, MIPMAP_FILTER_KAISER, true);
+    unsigned int numChanged = 0;
+    for(unsigned int level = 0; level < flatMipLevels.size(); level++) {
+        for(unsigned int i = 0; i < flatMipLevels[level].getSize(); i++) {
+            numChanged += (flatMipLevels[level][i] != 77) ? 1 : 0;
+        }
+    }
+    result << flatMipLevels.size() << " " << numChanged;
+    expected << "3 0";
+    CompareResult(ERROR_INFO, expected, result, failedCount);
+    
+    // A hard edge keeps its sides apart, with the overshoot of the negative lobes clamped
+    result = std::stringstream();
+    expected = std::stringstream();
+    std::vector<unsigned char> edgePixels = createGreyImage({0, 0, 0, 0, 255, 255, 255, 255}, 1);
+    std::vector<SharedBuffer<unsigned char>> edgeMipLevels = MipmapGenerator::GenerateMipLevels(edgePixels.data(), 8, 1, 1, MIPMAP_FILTER_KAISER, false);
+    result << (int)edgeMipLevels[0][0] << " " << (edgeMipLevels[0][1] < 64) << " " << (edgeMipLevels[0][2] > 191) << " " << (int)edgeMipLevels[0][3];
+    expected << "0 1 1 255";
+    CompareResult(ERROR_INFO, expected, result, failedCount);
+    
+    return failedCount;
+}
+
+int TestLevelUploads() {
+    std::stringstream result;
+    std::stringstream expected;
+    int failedCount = 0;
+    GeometryHeap::Destroy();
+    HeadlessGL::Reset();
+    MipmapSettings defaultMipmapSettings = TextureLoader::GetMipmapSettings();
+    MemoryStats initialMemoryStats = TextureLoader::GetMemoryStats();
+    
+    // The chain is generated on the CPU and uploaded level by level without glGenerateMipmap
+    result = std::stringstream();
+    expected = std::stringstream();
+    std::vector<unsigned char> pixels = createGreyImage({0, 100, 200, 40, 20, 60, 80, 120}, 3);
+    unsigned int textureID = TextureLoader::LoadTextureFromTextureData(std::make_shared<TextureData>(4, 2, 3, SharedBuffer<unsigned char>(pixels)));
+    TextureLoader::UseLoadedTexture(textureID);
+    TextureLoader::BindTexture(textureID);
+    GLuint textureName = HeadlessGL::GetBoundTexture();
+    std::vector<unsigned char> levelPixels(6);
+    glPixelStorei(GL_PACK_ALIGNMENT, 1);
+    glGetTexImage(GL_TEXTURE_2D, 1, GL_RGB, GL_UNSIGNED_BYTE, levelPixels.data());
+    glPixelStorei(GL_PACK_ALIGNMENT, 4);
+    TextureUnitState::BindToActiveUnit(0);
+    std::vector<SharedBuffer<unsigned char>> mipLevels = MipmapGenerator::GenerateMipLevels(pixels.data(), 4, 2, 3, MIPMAP_FILTER_BOX, true);
+    MemoryStats memoryStats = TextureLoader::GetMemoryStats();
+    result << HeadlessGL::GetNumTextureLevels(textureName) << " " << HeadlessGL::GetCallCount("glGenerateMipmap") << ", "
+            << (levelPixels == std::vector<unsigned char>(mipLevels[0].begin(), mipLevels[0].end())) << ", " << memoryStats.hostBytes - initialMemoryStats.hostBytes << " "
+            << memoryStats.deviceBytes - initialMemoryStats.deviceBytes << " " << HeadlessGL::GetNumErrors();
+    expected << "3 0, 1, 33 33 0";
+    CompareResult(ERROR_INFO, expected, result, failedCount);
+    TextureLoader::ReleaseLoadedTexture(textureID);
+    ResourceReclaimer::ReclaimAll();
+    
+    // With CPU generation off the driver builds the chain
+    result = std::stringstream();
+    expected = std::stringstream();
+    MipmapSettings driverMipmapSettings;
+    driverMipmapSettings.generateOnCPU = false;
+    TextureLoader::SetMipmapSettings(driverMipmapSettings);
+    textureID = TextureLoader::LoadTextureFromTextureData(std::make_shared<TextureData>(4, 2, 3, SharedBuffer<unsigned char>(pixels)));
+    TextureLoader::UseLoadedTexture(textureID);
+    TextureLoader::BindTexture(textureID);
+    textureName = HeadlessGL::GetBoundTexture();
+    TextureUnitState::BindToActiveUnit(0);
+    result << HeadlessGL::GetNumTextureLevels(textureName) << " " << HeadlessGL::GetCallCount("glGenerateMipmap") << " "
+            << TextureLoader::GetMemoryStats().hostBytes - initialMemoryStats.hostBytes;
+    expected << "1 1 24";
+    CompareResult(ERROR_INFO, expected, result, failedCount);
+    TextureLoader::ReleaseLoadedTexture(textureID);
+    ResourceReclaimer::ReclaimAll();
+    
+    TextureLoader::SetMipmapSettings(defaultMipmapSettings);
+    return failedCount;
+}
+
+int TestBatchLoading() {
+    std::stringstream result;
+    std::stringstream expected;
+    int failedCount = 0;
+    GeometryHeap::Destroy();
+    HeadlessGL::Reset();
+    
+    // Textures are decoded with their chains on the workers, and repeated paths share one texture
+    result = std::stringstream();
+    expected = std::stringstream();
+    std::string firstFilePath = writeTestImage("mipmap_batch_test_0.ppm", 4, 4, 10);
+    std::string secondFilePath = writeTestImage("mipmap_batch_test_1.ppm", 8, 2, 20);
+    unsigned int preloadedTextureID = TextureLoader::LoadTextureFromFile(firstFilePath);
+    AsyncLoadStats initialStats = AsyncLoader::GetStats();
+    std::vector<unsigned int> textureIDs = TextureLoader::LoadTexturesFromFiles({firstFilePath, secondFilePath, secondFilePath});
+    result << (textureIDs[0] == preloadedTextureID) << " " << (textureIDs[1] == textureIDs[2]) << " " << (textureIDs[1] != textureIDs[0]) << ", "
+            << AsyncLoader::GetStats().numTasksSubmitted - initialStats.numTasksSubmitted << ", "
+            << TextureLoader::GetTextureDataPtr(textureIDs[1])->getMipLevels().size() << " "
+            << (int)TextureLoader::GetTextureDataPtr(textureIDs[1])->getMipLevels()[2][0];
+    expected << "1 1 1, 1, 3 20";
+    CompareResult(ERROR_INFO, expected, result, failedCount);
+    
+    // A file that can't be decoded throws once the rest of the batch is loaded
+    result = std::stringstream();
+    expected = std::stringstream();
+    std::string thirdFilePath = writeTestImage("mipmap_batch_test_2.ppm", 2, 2, 30);
+    try {
+        TextureLoader::LoadTexturesFromFiles({"missing_mipmap_batch_test.ppm", thirdFilePath});
+        result << "returned";
+    }
+    catch(FileIOException& e) {
+        result << "threw";
+    }
+    result << ", " << (TextureLoader::GetPathIndex().getSize() > 0) << " " << (TextureLoader::LoadTexturesFromFiles({thirdFilePath})[0] != 0);
+    expected << "threw, 1 1";
+    CompareResult(ERROR_INFO, expected, result, failedCount);
+    
+    TextureLoader::UnloadUnusedTextures();
+    ResourceReclaimer::ReclaimAll();
+    std::filesystem::remove(firstFilePath);
+    std::filesystem::remove(secondFilePath);
+    std::filesystem::remove(thirdFilePath);
+    AsyncLoader::Shutdown();
+    return failedCount;
+}
+
+};
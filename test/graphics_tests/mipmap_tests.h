@@ -0,0 +1,25 @@
+#ifndef MIPMAP_TESTS_H
+#define MIPMAP_TESTS_H
+
+#include <iostream>
+#include <string>
+#include <graphics/texture/mipmap_generator.h>
+#include <graphics/texture/texture_data.h>
+#include <graphics/buffer/geometry_heap.h>
+#include <graphics/buffer/resource_reclaimer.h>
+#include <headless_gl.h>
+#include <test_exception.h>
+#include <test_comparison.h>
+
+namespace Tests::MipmapTests {
+
+int DoTests();
+int TestBoxFilter();
+int TestSRGBFiltering();
+int TestKaiserFilter();
+int TestLevelUploads();
+int TestBatchLoading();
+
+};
+
+#endif //MIPMAP_TESTS_H
@@ -0,0 +1,210 @@
+#include "parallel_shader_compile_tests.h"
+#include <map>
+#include <algorithm>
+
+using namespace Engine;
+
+namespace Tests::ParallelShaderCompileTests {
+
+int DoTests() {
+    int failedCount = 0;
+    
+    failedCount += TestDeferredStatusChecks();
+    failedCount += TestFailedPrograms();
+    failedCount += TestBatchedLoading();
+    failedCount += TestFallbackPrograms();
+    
+    return failedCount;
+}
+
+static const std::map<std::string, std::string> shaderSources = {
+    {"a.vs.glsl", "#version 430 core\nuniform mat4 transform;\nvoid main() { gl_Position = transform * vec4(0.0); }\n"},
+    {"a.fs.glsl", "#version 430 core\nuniform sampler2D texture0;\nuniform sampler2D texture1;\nout vec4 color;\nvoid main() { color = vec4(1.0); }\n"},
+    {"b.fs.glsl", "#version 430 core\nuniform sampler2D texture0;\nuniform sampler2D texture1;\nout vec4 color;\nvoid main() { color = vec4(0.5); }\n"},
+    {"bad.fs.glsl", "#version 430 core\n#error Doesn't compile\n"}
+};
+
+/*
+ * Resets the emulated context and loads shader files from shaderSources.
+ */
+static void resetState() {
+    ShaderLoader::Destroy();
+    GeometryHeap::Destroy();
+    HeadlessGL::Reset();
+    ShaderLoader::GetShaderPreprocessor() = ShaderPreprocessor([](const std::string& filePath, std::string& source) {
+        std::map<std::string, std::string>::const_iterator iter = shaderSources.find(filePath);
+        if(iter == shaderSources.end()) {
+            return false;
+        }
+        source = iter->second;
+        return true;
+    });
+}
+
+int TestDeferredStatusChecks() {
+    std::stringstream result;
+    std::stringstream expected;
+    int failedCount = 0;
+    resetState();
+    HeadlessGL::SetManualShaderCompletion(true);
+    
+    // Every program is submitted without asking for a status, and polling doesn't wait for the driver
+    result = std::stringstream();
+    expected = std::stringstream();
+    ShaderLoader::SubmitShaderPrograms({{"deferredA", "a.vs.glsl", "", "a.fs.glsl"}, {"deferredB", "a.vs.glsl", "", "b.fs.glsl"}});
+    ShaderProgramPtr shaderProgramPtr = ShaderLoader::getShaderProgram("deferredA");
+    result << HeadlessGL::GetCallCount("glCompileShader") << " " << HeadlessGL::GetCallCount("glLinkProgram") << " "
+            << ShaderLoader::GetNumCompilingShaderPrograms() << shaderProgramPtr->isCompiling() << " " << HeadlessGL::GetNumShaderStatusWaits() << ", ";
+    
+    // Once the driver is done the statuses are checked without waiting
+    HeadlessGL::CompleteShaders();
+    result << ShaderLoader::GetNumCompilingShaderPrograms() << shaderProgramPtr->isCompiling() << " " << HeadlessGL::GetNumShaderStatusWaits() << " "
+            << HeadlessGL::IsProgramLinked(shaderProgramPtr->getProgram());
+    shaderProgramPtr->use();
+    result << " " << (HeadlessGL::GetCurrentProgram() == shaderProgramPtr->getProgram()) << HeadlessGL::GetNumErrors();
+    expected << "4 2 21 0, 00 0 1 10";
+    CompareResult(ERROR_INFO, expected, result, failedCount);
+    
+    // Using a program before the driver is done waits for it
+    result = std::stringstream();
+    expected = std::stringstream();
+    ShaderLoader::SubmitShaderPrograms({{"deferredC", "a.vs.glsl", "", "b.fs.glsl"}});
+    shaderProgramPtr = ShaderLoader::getShaderProgram("deferredC");
+    result << shaderProgramPtr->isCompiling() << " ";
+    shaderProgramPtr->use();
+    result << shaderProgramPtr->isCompiling() << " " << HeadlessGL::GetNumShaderStatusWaits() << " "
+            << (HeadlessGL::GetCurrentProgram() == shaderProgramPtr->getProgram());
+    expected << "1 0 3 1";
+    CompareResult(ERROR_INFO, expected, result, failedCount);
+    
+    // Without KHR_parallel_shader_compile the driver can't be polled, so polling waits
+    result = std::stringstream();
+    expected = std::stringstream();
+    HeadlessGL::SetParallelShaderCompileSupported(false);
+    ShaderLoader::SubmitShaderPrograms({{"deferredD", "a.vs.glsl", "", "a.fs.glsl"}});
+    shaderProgramPtr = ShaderLoader::getShaderProgram("deferredD");
+    result << ShaderProgram::IsParallelCompileSupported() << shaderProgramPtr->isCompiling() << " " << HeadlessGL::GetNumShaderStatusWaits() << " "
+            << HeadlessGL::IsProgramLinked(shaderProgramPtr->getProgram());
+    expected << "00 6 1";
+    CompareResult(ERROR_INFO, expected, result, failedCount);
+    
+    ShaderLoader::Destroy();
+    ShaderLoader::GetShaderPreprocessor() = ShaderPreprocessor();
+    return failedCount;
+}
+
+int TestFailedPrograms() {
+    std::stringstream result;
+    std::stringstream expected;
+    int failedCount = 0;
+    resetState();
+    HeadlessGL::SetManualShaderCompletion(true);
+    
+    // A program that fails to compile throws when its status is checked, then stays unusable
+    result = std::stringstream();
+    expected = std::stringstream();
+    ShaderLoader::SubmitShaderPrograms({{"deferredBad", "a.vs.glsl", "", "bad.fs.glsl"}});
+    ShaderProgramPtr shaderProgramPtr = ShaderLoader::getShaderProgram("deferredBad");
+    result << shaderProgramPtr->isCompiling() << " ";
+    HeadlessGL::CompleteShaders();
+    try {
+        shaderProgramPtr->isCompiling();
+        result << "none ";
+    }
+    catch(const RenderException& exception) {
+        result << "RenderException ";
+    }
+    try {
+        shaderProgramPtr->use();
+        result << "none ";
+    }
+    catch(const RenderException& exception) {
+        result << "RenderException ";
+    }
+    result << shaderProgramPtr->isCompiling() << " " << HeadlessGL::GetNumShaderStatusWaits();
+    expected << "1 RenderException RenderException 0 0";
+    CompareResult(ERROR_INFO, expected, result, failedCount);
+    
+    ShaderLoader::Destroy();
+    ShaderLoader::GetShaderPreprocessor() = ShaderPreprocessor();
+    return failedCount;
+}
+
+int TestBatchedLoading() {
+    std::stringstream result;
+    std::stringstream expected;
+    int failedCount = 0;
+    resetState();
+    
+    // Loading submits every stage and link before the first status query
+    result = std::stringstream();
+    expected = std::stringstream();
+    ShaderLoader::LoadShaderPrograms({{"batchedA", "a.vs.glsl", "", "a.fs.glsl"}, {"batchedB", "a.vs.glsl", "", "b.fs.glsl"}});
+    const std::vector<std::string>& callLog = HeadlessGL::GetCallLog();
+    std::vector<std::string>::const_iterator firstStatusQuery = std::find(callLog.begin(), callLog.end(), "glGetShaderiv");
+    result << std::count(callLog.begin(), firstStatusQuery, "glCompileShader") << " " << std::count(callLog.begin(), firstStatusQuery, "glLinkProgram") << " "
+            << HeadlessGL::IsProgramLinked(ShaderLoader::getShaderProgram("batchedA")->getProgram())
+            << HeadlessGL::IsProgramLinked(ShaderLoader::getShaderProgram("batchedB")->getProgram()) << ShaderLoader::GetNumCompilingShaderPrograms();
+    expected << "4 2 110";
+    CompareResult(ERROR_INFO, expected, result, failedCount);
+    
+    // A program failing to compile throws from loading and isn't added
+    result = std::stringstream();
+    expected = std::stringstream();
+    try {
+        ShaderLoader::LoadShaderPrograms({{"batchedC", "a.vs.glsl", "", "a.fs.glsl"}, {"batchedBad", "a.vs.glsl", "", "bad.fs.glsl"}});
+        result << "none";
+    }
+    catch(const RenderException& exception) {
+        result << "RenderException";
+    }
+    expected << "RenderException";
+    CompareResult(ERROR_INFO, expected, result, failedCount);
+    
+    ShaderLoader::Destroy();
+    ShaderLoader::GetShaderPreprocessor() = ShaderPreprocessor();
+    return failedCount;
+}
+
+int TestFallbackPrograms() {
+    std::stringstream result;
+    std::stringstream expected;
+    int failedCount = 0;
+    resetState();
+    
+    // The fallback program is used while the material's own program compiles
+    result = std::stringstream();
+    expected = std::stringstream();
+    ShaderLoader::LoadShaderPrograms({{"fallback", "a.vs.glsl", "", "b.fs.glsl"}});
+    ShaderProgramPtr fallbackPtr = ShaderLoader::getShaderProgram("fallback");
+    HeadlessGL::SetManualShaderCompletion(true);
+    ShaderLoader::SubmitShaderPrograms({{"slow", "a.vs.glsl", "", "a.fs.glsl"}});
+    TextureDataPtr textureDataPtr = std::make_shared<TextureData>(4, 1, 4, SharedBuffer<unsigned char>(std::vector<unsigned char>(16, 255)));
+    TexturedMaterial texturedMaterial("slow", {Texture(textureDataPtr, TEXTURE_DIFFUSE)}, {1.0f});
+    TexturedMaterial otherMaterial = texturedMaterial;
+    texturedMaterial.setFallbackShaderProgramPtr(fallbackPtr);
+    texturedMaterial.apply();
+    result << (HeadlessGL::GetCurrentProgram() == fallbackPtr->getProgram()) << HeadlessGL::GetUniformValues(fallbackPtr->getProgram(), "texture0").size() << " "
+            << HeadlessGL::GetNumShaderStatusWaits() << texturedMaterial.hasSameState(otherMaterial) << ", ";
+    
+    // Once compiled, the material's own program is used
+    HeadlessGL::CompleteShaders();
+    texturedMaterial.apply();
+    result << (HeadlessGL::GetCurrentProgram() == texturedMaterial.getShaderProgramPtr()->getProgram()) << (texturedMaterial.getActiveShaderProgramPtr() != fallbackPtr)
+            << " " << HeadlessGL::GetNumShaderStatusWaits() << ", ";
+    
+    // Without a fallback, applying a material waits for its program
+    ShaderLoader::SubmitShaderPrograms({{"slowToo", "a.vs.glsl", "", "b.fs.glsl"}});
+    TexturedMaterial waitingMaterial("slowToo", {Texture(textureDataPtr, TEXTURE_DIFFUSE)}, {1.0f});
+    waitingMaterial.apply();
+    result << (HeadlessGL::GetCurrentProgram() == waitingMaterial.getShaderProgramPtr()->getProgram()) << " " << HeadlessGL::GetNumShaderStatusWaits()
+            << " " << HeadlessGL::GetNumErrors();
+    expected << "11 00, 11 0, 1 3 0";
+    CompareResult(ERROR_INFO, expected, result, failedCount);
+    
+    ShaderLoader::Destroy();
+    ShaderLoader::GetShaderPreprocessor() = ShaderPreprocessor();
+    return failedCount;
+}
+
+}
@@ -0,0 +1,23 @@
+#ifndef PARALLEL_SHADER_COMPILE_TESTS_H
+#define PARALLEL_SHADER_COMPILE_TESTS_H
+
+#include <iostream>
+#include <string>
+#include <graphics/shaders/shaders.h>
+#include <graphics/material/material.h>
+#include <graphics/buffer/geometry_heap.h>
+#include <headless_gl.h>
+#include <test_exception.h>
+#include <test_comparison.h>
+
+namespace Tests::ParallelShaderCompileTests {
+
+int DoTests();
+int TestDeferredStatusChecks();
+int TestFailedPrograms();
+int TestBatchedLoading();
+int TestFallbackPrograms();
+
+};
+
+#endif //PARALLEL_SHADER_COMPILE_TESTS_H
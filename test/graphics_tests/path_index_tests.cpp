@@ -0,0 +1,86 @@
+#include "path_index_tests.h"
+
+using namespace Engine;
+
+namespace Tests::PathIndexTests {
+
+int DoTests() {
+    int failedCount = 0;
+    
+    failedCount += TestPathTable();
+    failedCount += TestPathIndex();
+    
+    return failedCount;
+}
+
+int TestPathTable() {
+    std::stringstream result;
+    std::stringstream expected;
+    int failedCount = 0;
+    
+    result = std::stringstream();
+    expected = std::stringstream();
+    result << PathTable::Intern("");
+    expected << "0";
+    CompareResult(ERROR_INFO, expected, result, failedCount);
+    
+    result = std::stringstream();
+    expected = std::stringstream();
+    unsigned int pathID = PathTable::Intern("textures/wall.jpg");
+    result << (PathTable::Intern("./textures/../textures/wall.jpg") == pathID) << ", "
+            << (PathTable::Intern("textures//wall.jpg") == pathID) << ", "
+            << (PathTable::Intern("textures/wall2.jpg") == pathID);
+    expected << "1, 1, 0";
+    CompareResult(ERROR_INFO, expected, result, failedCount);
+    
+    result = std::stringstream();
+    expected = std::stringstream();
+    result << (PathTable::GetPath(pathID) == PathTable::Canonicalize("textures/wall.jpg"));
+    expected << "1";
+    CompareResult(ERROR_INFO, expected, result, failedCount);
+    
+    return failedCount;
+}
+
+int TestPathIndex() {
+    std::stringstream result;
+    std::stringstream expected;
+    int failedCount = 0;
+    
+    result = std::stringstream();
+    expected = std::stringstream();
+    PathIndex pathIndex;
+    result << pathIndex.find("models/wolf.dae") << ", " << pathIndex.getHits() << ", " << pathIndex.getMisses();
+    expected << "0, 0, 1";
+    CompareResult(ERROR_INFO, expected, result, failedCount);
+    
+    result = std::stringstream();
+    expected = std::stringstream();
+    pathIndex.insert("models/wolf.dae", 7);
+    for(unsigned int i = 0; i < 1000; i++) {
+        pathIndex.find("models/../models/wolf.dae");
+    }
+    result << pathIndex.find("./models/wolf.dae") << ", " << pathIndex.getHits() << ", " << pathIndex.getMisses() << ", " << pathIndex.getSize();
+    expected << "7, 1001, 1, 1";
+    CompareResult(ERROR_INFO, expected, result, failedCount);
+    
+    result = std::stringstream();
+    expected = std::stringstream();
+    pathIndex.erase("models/wolf.dae", 8);
+    result << pathIndex.find("models/wolf.dae") << ", ";
+    pathIndex.erase("models/wolf.dae", 7);
+    result << pathIndex.find("models/wolf.dae") << ", " << pathIndex.getSize();
+    expected << "7, 0, 0";
+    CompareResult(ERROR_INFO, expected, result, failedCount);
+    
+    result = std::stringstream();
+    expected = std::stringstream();
+    pathIndex.resetStats();
+    result << pathIndex.getHits() << ", " << pathIndex.getMisses();
+    expected << "0, 0";
+    CompareResult(ERROR_INFO, expected, result, failedCount);
+    
+    return failedCount;
+}
+
+};
@@ -0,0 +1,18 @@
+#ifndef PATH_INDEX_TESTS_H
+#define PATH_INDEX_TESTS_H
+
+#include <iostream>
+#include <string>
+#include <fileio/path_index.h>
+#include <test_exception.h>
+#include <test_comparison.h>
+
+namespace Tests::PathIndexTests {
+
+int DoTests();
+int TestPathTable();
+int TestPathIndex();
+
+};
+
+#endif //PATH_INDEX_TESTS_H
@@ -0,0 +1,358 @@
+#include "pixel_format_tests.h"
+#include <cmath>
+#include <cstring>
+
+using namespace Engine;
+
+namespace Tests::PixelFormatTests {
+
+int DoTests() {
+    int failedCount = 0;
+    
+    failedCount += TestChannelKernels();
+    failedCount += TestValueConversions();
+    failedCount += TestHalfFloats();
+    failedCount += TestFormatConversions();
+    failedCount += TestNativeUploads();
+    
+    PixelConverter::SetMaxSIMDLevel(SIMD_LEVEL_AVX2);
+    return failedCount;
+}
+
+/*
+ * Returns numBytes bytes of a repeatable pseudo random pattern.
+ */
+static std::vector<unsigned char> createNoise(const size_t numBytes, unsigned int seed) {
+    std::vector<unsigned char> bytes(numBytes);
+    for(size_t i = 0; i < numBytes; i++) {
+        seed = seed * 1664525u + 1013904223u;
+        bytes[i] = (unsigned char)(seed >> 24);
+    }
+    return bytes;
+}
+
+/*
+ * Runs kernel once with the best instruction set the CPU supports and once with scalar code, and returns whether both
+ * wrote the same bytes.
+ */
+template<typename Kernel>
+static bool matchesScalar(const size_t numBytes, Kernel kernel) {
+    std::vector<unsigned char> simdOutput(numBytes, 0);
+    std::vector<unsigned char> scalarOutput(numBytes, 0);
+    PixelConverter::SetMaxSIMDLevel(SIMD_LEVEL_AVX2);
+    kernel(simdOutput.data());
+    PixelConverter::SetMaxSIMDLevel(SIMD_LEVEL_SCALAR);
+    kernel(scalarOutput.data());
+    PixelConverter::SetMaxSIMDLevel(SIMD_LEVEL_AVX2);
+    return simdOutput == scalarOutput;
+}
+
+int TestChannelKernels() {
+    std::stringstream result;
+    std::stringstream expected;
+    int failedCount = 0;
+    
+    // Channels are expanded, stripped and reordered as described
+    result = std::stringstream();
+    expected = std::stringstream();
+    unsigned char rgb[6] = {1, 2, 3, 4, 5, 6};
+    unsigned char rgba[8];
+    PixelConverter::ExpandRGBToRGBA(rgb, rgba, 2, 7);
+    unsigned char stripped[6];
+    PixelConverter::StripRGBAToRGB(rgba, stripped, 2);
+    const unsigned int bgra[4] = {2, 1, 0, 3};
+    unsigned char swizzled[8];
+    PixelConverter::SwizzleRGBA(rgba, swizzled, 2, bgra);
+    unsigned char grey[2] = {9, 8};
+    unsigned char greyRGBA[8];
+    PixelConverter::ExpandGreyToRGBA(grey, greyRGBA, 2);
+    unsigned char greyAlpha[4] = {9, 1, 8, 2};
+    unsigned char greyAlphaRGBA[8];
+    PixelConverter::ExpandGreyAlphaToRGBA(greyAlpha, greyAlphaRGBA, 2);
+    for(unsigned int i = 0; i < 8; i++) {
+        result << (int)rgba[i] << " ";
+    }
+    result << (std::memcmp(stripped, rgb, 6) == 0) << ", ";
+    for(unsigned int i = 0; i < 8; i++) {
+        result << (int)swizzled[i] << " ";
+    }
+    result << ", " << (int)greyRGBA[4] << " " << (int)greyRGBA[6] << " " << (int)greyRGBA[7] << ", " << (int)greyAlphaRGBA[2] << " " << (int)greyAlphaRGBA[3]
+            << " " << (int)greyAlphaRGBA[7];
+    expected << "1 2 3 7 4 5 6 7 1, 3 2 1 7 6 5 4 7 , 8 8 255, 9 1 2";
+    CompareResult(ERROR_INFO, expected, result, failedCount);
+    
+    // The SIMD kernels match the scalar ones, including the pixels left over after the last full vector
+    result = std::stringstream();
+    expected = std::stringstream();
+    const size_t numPixels = 37;
+    std::vector<unsigned char> source = createNoise(numPixels * 4, 1);
+    result << matchesScalar(numPixels * 4, [&](unsigned char* output) { PixelConverter::ExpandRGBToRGBA(source.data(), output, numPixels); }) << " "
+            << matchesScalar(numPixels * 3, [&](unsigned char* output) { PixelConverter::StripRGBAToRGB(source.data(), output, numPixels); }) << " "
+            << matchesScalar(numPixels * 4, [&](unsigned char* output) { PixelConverter::SwizzleRGBA(source.data(), output, numPixels, bgra); }) << " "
+            << matchesScalar(numPixels * 3, [&](unsigned char* output) { PixelConverter::ExpandGreyToRGB(source.data(), output, numPixels); }) << " "
+            << matchesScalar(numPixels * 4, [&](unsigned char* output) { PixelConverter::ExpandGreyToRGBA(source.data(), output, numPixels); }) << " "
+            << matchesScalar(numPixels * 4, [&](unsigned char* output) { PixelConverter::ExpandGreyAlphaToRGBA(source.data(), output, numPixels); }) << " "
+            << matchesScalar(numPixels * 4, [&](unsigned char* output) {
+                std::memcpy(output, source.data(), numPixels * 4);
+                PixelConverter::PremultiplyAlpha(output, numPixels);
+            });
+    expected << "1 1 1 1 1 1 1";
+    CompareResult(ERROR_INFO, expected, result, failedCount);
+    
+    // Swizzling in place gives the same result as swizzling into another buffer
+    result = std::stringstream();
+    expected = std::stringstream();
+    std::vector<unsigned char> swizzledCopy(numPixels * 4);
+    PixelConverter::SwizzleRGBA(source.data(), swizzledCopy.data(), numPixels, bgra);
+    std::vector<unsigned char> inPlace = source;
+    PixelConverter::SwizzleRGBA(inPlace.data(), inPlace.data(), numPixels, bgra);
+    result << (inPlace == swizzledCopy);
+    expected << "1";
+    CompareResult(ERROR_INFO, expected, result, failedCount);
+    
+    // Premultiplying rounds every color and alpha pair to the nearest value
+    result = std::stringstream();
+    expected = std::stringstream();
+    std::vector<unsigned char> pairs;
+    for(unsigned int alpha = 0; alpha < 256; alpha++) {
+        for(unsigned int color = 0; color < 256; color++) {
+            pairs.insert(pairs.end(), {(unsigned char)color, (unsigned char)color, (unsigned char)color, (unsigned char)alpha});
+        }
+    }
+    PixelConverter::PremultiplyAlpha(pairs.data(), 256 * 256);
+    unsigned int numWrong = 0;
+    for(unsigned int alpha = 0; alpha < 256; alpha++) {
+        for(unsigned int color = 0; color < 256; color++) {
+            const unsigned char* pixel = &pairs[(alpha * 256 + color) * 4];
+            if(pixel[0] != (unsigned char)std::lround(color * alpha / 255.0) || pixel[2] != pixel[0] || pixel[3] != alpha) {
+                numWrong++;
+            }
+        }
+    }
+    result << numWrong;
+    expected << "0";
+    CompareResult(ERROR_INFO, expected, result, failedCount);
+    
+    return failedCount;
+}
+
+int TestValueConversions() {
+    std::stringstream result;
+    std::stringstream expected;
+    int failedCount = 0;
+    
+    // Widening is exact and narrowing rounds every 16-bit value to the nearest 8-bit one
+    result = std::stringstream();
+    expected = std::stringstream();
+    std::vector<unsigned char> bytes(256);
+    for(unsigned int i = 0; i < 256; i++) {
+        bytes[i] = (unsigned char)i;
+    }
+    std::vector<unsigned short> widened(256);
+    PixelConverter::Widen8To16(bytes.data(), widened.data(), 256);
+    std::vector<unsigned short> shorts(65536);
+    for(unsigned int i = 0; i < 65536; i++) {
+        shorts[i] = (unsigned short)i;
+    }
+    std::vector<unsigned char> narrowed(65536);
+    PixelConverter::Narrow16To8(shorts.data(), narrowed.data(), 65536);
+    unsigned int numWrong = 0;
+    for(unsigned int i = 0; i < 256; i++) {
+        numWrong += (widened[i] != i * 257);
+    }
+    for(unsigned int i = 0; i < 65536; i++) {
+        numWrong += (narrowed[i] != (unsigned char)std::lround(i / 257.0));
+    }
+    result << numWrong << " " << matchesScalar(65536, [&](unsigned char* output) { PixelConverter::Narrow16To8(shorts.data(), output, 65536); }) << " "
+            << matchesScalar(512, [&](unsigned char* output) { PixelConverter::Widen8To16(bytes.data(), (unsigned short*)output, 256); });
+    expected << "0 1 1";
+    CompareResult(ERROR_INFO, expected, result, failedCount);
+    
+    // sRGB values survive a round trip through linear 16-bit values
+    result = std::stringstream();
+    expected = std::stringstream();
+    std::vector<unsigned short> linear(256);
+    PixelConverter::SRGBToLinear16(bytes.data(), linear.data(), 256);
+    std::vector<unsigned char> encoded(256);
+    PixelConverter::Linear16ToSRGB(linear.data(), encoded.data(), 256);
+    result << linear[0] << " " << linear[255] << " " << (linear[128] < 32768 / 2) << " " << (encoded == bytes);
+    expected << "0 65535 1 1";
+    CompareResult(ERROR_INFO, expected, result, failedCount);
+    
+    return failedCount;
+}
+
+int TestHalfFloats() {
+    std::stringstream result;
+    std::stringstream expected;
+    int failedCount = 0;
+    
+    // Floats round to the nearest half float, overflowing to infinity and keeping subnormals
+    result = std::stringstream();
+    expected = std::stringstream();
+    const float floats[7] = {1.0f, 65504.0f, 65520.0f, std::ldexp(1.0f, -24), -2.0f, 0.333333f, std::ldexp(1.0f, -26)};
+    unsigned short halves[7];
+    PixelConverter::FloatToHalf(floats, halves, 7);
+    result << std::hex;
+    for(unsigned int i = 0; i < 7; i++) {
+        result << halves[i] << " ";
+    }
+    expected << "3c00 7bff 7c00 1 c000 3555 0 ";
+    CompareResult(ERROR_INFO, expected, result, failedCount);
+    
+    // Every half float that isn't NaN survives a round trip through floats, with and without F16C
+    result = std::stringstream();
+    expected = std::stringstream();
+    std::vector<unsigned short> allHalves(65536);
+    for(unsigned int i = 0; i < 65536; i++) {
+        allHalves[i] = (unsigned short)i;
+    }
+    unsigned int numWrong = 0;
+    for(SIMDLevel simdLevel : {SIMD_LEVEL_AVX2, SIMD_LEVEL_SCALAR}) {
+        PixelConverter::SetMaxSIMDLevel(simdLevel);
+        std::vector<float> asFloats(65536);
+        PixelConverter::HalfToFloat(allHalves.data(), asFloats.data(), 65536);
+        std::vector<unsigned short> roundTrip(65536);
+        PixelConverter::FloatToHalf(asFloats.data(), roundTrip.data(), 65536);
+        for(unsigned int i = 0; i < 65536; i++) {
+            bool isNaN = (i & 0x7C00) == 0x7C00 && (i & 0x03FF) != 0;
+            numWrong += isNaN ? !std::isnan(asFloats[i]) : (roundTrip[i] != i);
+        }
+    }
+    PixelConverter::SetMaxSIMDLevel(SIMD_LEVEL_AVX2);
+    result << numWrong;
+    expected << "0";
+    CompareResult(ERROR_INFO, expected, result, failedCount);
+    
+    return failedCount;
+}
+
+int TestFormatConversions() {
+    std::stringstream result;
+    std::stringstream expected;
+    int failedCount = 0;
+    
+    // Formats describe their channels, sizes and OpenGL enums
+    result = std::stringstream();
+    expected = std::stringstream();
+    GLPixelFormat l8 = PixelConverter::GetGLPixelFormat(PIXEL_FORMAT_L8);
+    GLPixelFormat bgra8 = PixelConverter::GetGLPixelFormat(PIXEL_FORMAT_BGRA8);
+    GLPixelFormat rgba16f = PixelConverter::GetGLPixelFormat(PIXEL_FORMAT_RGBA16F);
+    result << PixelConverter::GetNumChannels(PIXEL_FORMAT_LA8) << " " << PixelConverter::GetBytesPerPixel(PIXEL_FORMAT_RGBA16) << " "
+            << PixelConverter::Is8Bit(PIXEL_FORMAT_BGRA8) << " " << PixelConverter::Is8Bit(PIXEL_FORMAT_RGBA16F) << " "
+            << (PixelConverter::GetPixelFormat(2) == PIXEL_FORMAT_RG8) << ", " << (l8.internalFormat == GL_R8) << " " << (l8.format == GL_RED) << " "
+            << (bgra8.internalFormat == GL_RGBA8) << " " << (bgra8.format == GL_BGRA) << " " << (rgba16f.internalFormat == GL_RGBA16F) << " "
+            << (rgba16f.type == GL_HALF_FLOAT) << ", " << PixelConverter::GetUnpackAlignment(9) << " " << PixelConverter::GetUnpackAlignment(6) << " "
+            << PixelConverter::GetUnpackAlignment(12) << " " << PixelConverter::GetUnpackAlignment(24);
+    expected << "2 8 1 0 1, 1 1 1 1 1 1, 1 2 4 8";
+    CompareResult(ERROR_INFO, expected, result, failedCount);
+    
+    // Formats without a direct kernel go through RGBA8 in chunks, and 8-bit values survive the trip through wider formats
+    result = std::stringstream();
+    expected = std::stringstream();
+    const size_t numPixels = 2500;
+    std::vector<unsigned char> rgba = createNoise(numPixels * 4, 2);
+    std::vector<unsigned char> bgra(numPixels * 4);
+    PixelConverter::ConvertPixels(rgba.data(), PIXEL_FORMAT_RGBA8, bgra.data(), PIXEL_FORMAT_BGRA8, numPixels);
+    std::vector<unsigned char> wide(numPixels * 8);
+    PixelConverter::ConvertPixels(bgra.data(), PIXEL_FORMAT_BGRA8, wide.data(), PIXEL_FORMAT_RGBA16, numPixels);
+    std::vector<unsigned char> halves(numPixels * 8);
+    PixelConverter::ConvertPixels(wide.data(), PIXEL_FORMAT_RGBA16, halves.data(), PIXEL_FORMAT_RGBA16F, numPixels);
+    std::vector<unsigned char> back(numPixels * 4);
+    PixelConverter::ConvertPixels(halves.data(), PIXEL_FORMAT_RGBA16F, back.data(), PIXEL_FORMAT_RGBA8, numPixels);
+    result << (int)bgra[0] << " " << (int)bgra[2] << " " << (back == rgba);
+    expected << (int)rgba[2] << " " << (int)rgba[0] << " 1";
+    CompareResult(ERROR_INFO, expected, result, failedCount);
+    
+    // Grey takes weighted red, green and blue, and expands back to equal channels
+    result = std::stringstream();
+    expected = std::stringstream();
+    unsigned char colors[9] = {255, 0, 0, 0, 255, 0, 200, 200, 200};
+    unsigned char greyAlpha[6];
+    PixelConverter::ConvertPixels(colors, PIXEL_FORMAT_RGB8, greyAlpha, PIXEL_FORMAT_LA8, 3);
+    unsigned char expandedRGB[9];
+    PixelConverter::ConvertPixels(greyAlpha, PIXEL_FORMAT_LA8, expandedRGB, PIXEL_FORMAT_RGB8, 3);
+    result << (int)greyAlpha[0] << " " << (int)greyAlpha[1] << " " << (int)greyAlpha[2] << " " << (int)greyAlpha[4] << ", " << (int)expandedRGB[3]
+            << " " << (int)expandedRGB[5];
+    expected << "54 255 182 200, 182 182";
+    CompareResult(ERROR_INFO, expected, result, failedCount);
+    
+    // Converting texture data converts its mipmap levels too
+    result = std::stringstream();
+    expected = std::stringstream();
+    std::vector<unsigned char> pixels = createNoise(4 * 4 * 3, 3);
+    TextureData textureData(4, 4, 3, SharedBuffer<unsigned char>(pixels));
+    textureData.generateMipLevels(MIPMAP_FILTER_BOX, false);
+    unsigned char firstMipRed = textureData.getMipLevels()[0][0];
+    textureData.convert(PIXEL_FORMAT_RGBA16);
+    const unsigned short* firstMip = (const unsigned short*)textureData.getMipLevels()[0].data();
+    result << (textureData.getPixelFormat() == PIXEL_FORMAT_RGBA16) << " " << textureData.getNumChannels() << " " << textureData.getData().getSize() << " "
+            << textureData.getMipLevels()[0].getSize() << " " << firstMip[0] << " " << firstMip[3];
+    expected << "1 4 128 32 " << firstMipRed * 257 << " 65535";
+    CompareResult(ERROR_INFO, expected, result, failedCount);
+    
+    return failedCount;
+}
+
+int TestNativeUploads() {
+    std::stringstream result;
+    std::stringstream expected;
+    int failedCount = 0;
+    GeometryHeap::Destroy();
+    HeadlessGL::Reset();
+    
+    // Grey textures upload as a single channel and are read as RGB through the swizzle
+    result = std::stringstream();
+    expected = std::stringstream();
+    std::vector<unsigned char> greyPixels = createNoise(6 * 2, 4);
+    unsigned int greyID = TextureLoader::LoadTextureFromTextureData(std::make_shared<TextureData>(6, 2, PIXEL_FORMAT_L8,
+            SharedBuffer<unsigned char>(greyPixels)));
+    TextureLoader::UseLoadedTexture(greyID);
+    TextureLoader::BindTexture(greyID);
+    GLuint greyName = HeadlessGL::GetBoundTexture();
+    TextureUnitState::BindToActiveUnit(0);
+    std::vector<GLint> swizzle = HeadlessGL::GetTextureSwizzle(greyName);
+    result << (HeadlessGL::GetTextureInternalFormat(greyName, 0) == GL_R8) << " " << HeadlessGL::GetTextureLevelSize(greyName, 0) << " "
+            << (swizzle[0] == GL_RED) << (swizzle[1] == GL_RED) << (swizzle[2] == GL_RED) << (swizzle[3] == GL_ONE) << " "
+            << (HeadlessGL::GetTextureLevelData(greyName, 0) == greyPixels) << " " << HeadlessGL::GetLastUploadUnpackAlignment() << " "
+            << HeadlessGL::GetUnpackAlignment();
+    expected << "1 12 1111 1 1 4";
+    CompareResult(ERROR_INFO, expected, result, failedCount);
+    
+    // Grey and alpha mipmaps keep alpha linear while averaging grey in linear light
+    result = std::stringstream();
+    expected = std::stringstream();
+    unsigned char greyAlpha[4] = {0, 0, 255, 255};
+    TextureData greyAlphaData(2, 1, PIXEL_FORMAT_LA8, SharedBuffer<unsigned char>(std::vector<unsigned char>(greyAlpha, greyAlpha + 4)));
+    greyAlphaData.generateMipLevels(MIPMAP_FILTER_BOX, true);
+    result << greyAlphaData.getMipLevels().size() << " " << (int)greyAlphaData.getMipLevels()[0][0] << " " << (int)greyAlphaData.getMipLevels()[0][1];
+    expected << "1 188 128";
+    CompareResult(ERROR_INFO, expected, result, failedCount);
+    
+    // 16-bit textures upload as is with the widest unpack alignment their rows allow, and are read back unchanged
+    result = std::stringstream();
+    expected = std::stringstream();
+    std::vector<unsigned char> widePixels = createNoise(3 * 2 * 8, 5);
+    unsigned int wideID = TextureLoader::LoadTextureFromTextureData(std::make_shared<TextureData>(3, 2, PIXEL_FORMAT_RGBA16,
+            SharedBuffer<unsigned char>(widePixels)));
+    TextureLoader::UseLoadedTexture(wideID);
+    TextureLoader::BindTexture(wideID);
+    GLuint wideName = HeadlessGL::GetBoundTexture();
+    TextureUnitState::BindToActiveUnit(0);
+    GLint wideAlignment = HeadlessGL::GetLastUploadUnpackAlignment();
+    TextureLoader::SetResidencyPolicy(wideID, RESIDENCY_REFETCH_HOST_COPY);
+    bool droppedHostCopy = !TextureLoader::IsHostResident(wideID);
+    TextureDataPtr readBackPtr = TextureLoader::GetTextureDataPtr(wideID);
+    result << (HeadlessGL::GetTextureInternalFormat(wideName, 0) == GL_RGBA16) << " " << HeadlessGL::GetTextureLevelSize(wideName, 0) << " "
+            << wideAlignment << " " << droppedHostCopy << " " << (readBackPtr->getPixelFormat() == PIXEL_FORMAT_RGBA16) << " "
+            << std::equal(widePixels.begin(), widePixels.end(), readBackPtr->getData().begin());
+    expected << "1 48 8 1 1 1";
+    CompareResult(ERROR_INFO, expected, result, failedCount);
+    
+    TextureLoader::ReleaseLoadedTexture(greyID);
+    TextureLoader::ReleaseLoadedTexture(wideID);
+    ResourceReclaimer::ReclaimAll();
+    return failedCount;
+}
+
+};
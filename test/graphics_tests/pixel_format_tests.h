@@ -0,0 +1,25 @@
+#ifndef PIXEL_FORMAT_TESTS_H
+#define PIXEL_FORMAT_TESTS_H
+
+#include <iostream>
+#include <string>
+#include <graphics/texture/pixel_format.h>
+#include <graphics/texture/texture_data.h>
+#include <graphics/buffer/geometry_heap.h>
+#include <graphics/buffer/resource_reclaimer.h>
+#include <headless_gl.h>
+#include <test_exception.h>
+#include <test_comparison.h>
+
+namespace Tests::PixelFormatTests {
+
+int DoTests();
+int TestChannelKernels();
+int TestValueConversions();
+int TestHalfFloats();
+int TestFormatConversions();
+int TestNativeUploads();
+
+};
+
+#endif //PIXEL_FORMAT_TESTS_H
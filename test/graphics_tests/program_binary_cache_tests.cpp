@@ -0,0 +1,189 @@
+#include "program_binary_cache_tests.h"
+#include <filesystem>
+#include <fstream>
+#include <cstring>
+
+using namespace Engine;
+
+namespace Tests::ProgramBinaryCacheTests {
+
+int DoTests() {
+    int failedCount = 0;
+    
+    failedCount += TestProgramKeys();
+    failedCount += TestCacheHits();
+    failedCount += TestRejectedBinaries();
+    
+    return failedCount;
+}
+
+static const std::string vertexSource = "#version 430 core\nuniform mat4 transform;\nvoid main() { gl_Position = transform * vec4(0.0); }\n";
+static const std::string fragmentSource = "#version 430 core\nout vec4 color;\nvoid main() { color = vec4(1.0); }\n";
+
+/*
+ * Points the cache at an empty directory in the temporary directory.
+ */
+static std::string useEmptyCacheDirectory() {
+    std::string cacheDirectory = (std::filesystem::temp_directory_path() / "program_binary_cache_test").string();
+    std::filesystem::remove_all(cacheDirectory);
+    ProgramBinaryCache::SetCacheDirectory(cacheDirectory);
+    ProgramBinaryCache::ResetStats();
+    return cacheDirectory;
+}
+
+static std::string statsString() {
+    const ProgramBinaryCacheStats& stats = ProgramBinaryCache::GetStats();
+    std::stringstream stream;
+    stream << stats.numHits << " " << stats.numMisses << " " << stats.numRejections << " " << stats.numWrites << " " << stats.numWriteFailures;
+    return stream.str();
+}
+
+static ShaderProgramPtr createProgram(const std::string& fragment) {
+    return std::make_shared<ShaderProgram>(std::vector<GLenum>{GL_VERTEX_SHADER, GL_FRAGMENT_SHADER}, std::vector<std::string>{"test.vs.glsl", "test.fs.glsl"},
+            std::vector<std::string>{vertexSource, fragment}, "test");
+}
+
+int TestProgramKeys() {
+    std::stringstream result;
+    std::stringstream expected;
+    int failedCount = 0;
+    GeometryHeap::Destroy();
+    HeadlessGL::Reset();
+    
+    // Keys change with the sources, stage types, defines and driver
+    result = std::stringstream();
+    expected = std::stringstream();
+    std::vector<GLenum> types = {GL_VERTEX_SHADER, GL_FRAGMENT_SHADER};
+    unsigned long long key = ProgramBinaryCache::GetProgramKey(types, {vertexSource, fragmentSource}, {"USE_FOG"});
+    result << (ProgramBinaryCache::GetProgramKey(types, {vertexSource, fragmentSource}, {"USE_FOG"}) == key)
+            << (ProgramBinaryCache::GetProgramKey(types, {vertexSource, fragmentSource + " "}, {"USE_FOG"}) != key)
+            << (ProgramBinaryCache::GetProgramKey({GL_VERTEX_SHADER, GL_GEOMETRY_SHADER}, {vertexSource, fragmentSource}, {"USE_FOG"}) != key)
+            << (ProgramBinaryCache::GetProgramKey(types, {vertexSource, fragmentSource}, {}) != key)
+            << (ProgramBinaryCache::GetProgramKey(types, {"ab", "c"}, {}) != ProgramBinaryCache::GetProgramKey(types, {"a", "bc"}, {}));
+    HeadlessGL::SetDriverVersion("4.3.0 HeadlessGL 2");
+    result << (ProgramBinaryCache::GetProgramKey(types, {vertexSource, fragmentSource}, {"USE_FOG"}) != key) << " ";
+    
+    // The cache is only enabled with a directory and a driver supporting program binaries
+    result << ProgramBinaryCache::IsSupported() << ProgramBinaryCache::IsEnabled();
+    std::string cacheDirectory = useEmptyCacheDirectory();
+    result << ProgramBinaryCache::IsEnabled() << std::filesystem::is_directory(cacheDirectory);
+    HeadlessGL::SetProgramBinarySupported(false);
+    result << ProgramBinaryCache::IsSupported() << ProgramBinaryCache::IsEnabled();
+    std::filesystem::remove_all(cacheDirectory);
+    ProgramBinaryCache::SetCacheDirectory("");
+    expected << "111111 101100";
+    CompareResult(ERROR_INFO, expected, result, failedCount);
+    
+    return failedCount;
+}
+
+int TestCacheHits() {
+    std::stringstream result;
+    std::stringstream expected;
+    int failedCount = 0;
+    GeometryHeap::Destroy();
+    HeadlessGL::Reset();
+    std::string cacheDirectory = useEmptyCacheDirectory();
+    
+    // The first build compiles the program and stores its binary, the next one links it from the binary
+    result = std::stringstream();
+    expected = std::stringstream();
+    unsigned long long key = ProgramBinaryCache::GetProgramKey({GL_VERTEX_SHADER, GL_FRAGMENT_SHADER}, {vertexSource, fragmentSource}, {});
+    {
+        ShaderProgramPtr shaderProgramPtr = createProgram(fragmentSource);
+        result << HeadlessGL::GetCallCount("glCompileShader") << " " << HeadlessGL::GetCallCount("glProgramBinary") << " " << statsString() << " "
+                << std::filesystem::exists(ProgramBinaryCache::GetCacheFilePath(key)) << ", ";
+    }
+    HeadlessGL::ClearCallLog();
+    {
+        ShaderProgramPtr shaderProgramPtr = createProgram(fragmentSource);
+        shaderProgramPtr->use();
+        shaderProgramPtr->setUniformFloatMat("transform", Math::Mat4f(1.0f));
+        result << HeadlessGL::GetCallCount("glCompileShader") << " " << HeadlessGL::GetCallCount("glLinkProgram") << " "
+                << HeadlessGL::GetCallCount("glProgramBinary") << " " << statsString() << " "
+                << (HeadlessGL::GetProgramSource(shaderProgramPtr->getProgram()) == vertexSource + fragmentSource) << " "
+                << HeadlessGL::GetUniformValues(shaderProgramPtr->getProgram(), "transform").size() << " " << HeadlessGL::GetNumErrors() << ", ";
+    }
+    
+    // A changed source misses and is stored alongside
+    HeadlessGL::ClearCallLog();
+    {
+        ShaderProgramPtr shaderProgramPtr = createProgram(fragmentSource + "// Changed\n");
+        result << HeadlessGL::GetCallCount("glCompileShader") << " " << statsString() << " "
+                << std::distance(std::filesystem::directory_iterator(cacheDirectory), std::filesystem::directory_iterator());
+    }
+    expected << "2 0 0 1 0 1 0 1, 0 0 1 1 1 0 1 0 1 16 0, 2 1 2 0 2 0 2";
+    CompareResult(ERROR_INFO, expected, result, failedCount);
+    
+    // A program that fails to compile still throws, and isn't stored
+    result = std::stringstream();
+    expected = std::stringstream();
+    try {
+        createProgram("#error broken\n");
+        result << "no exception";
+    }
+    catch(RenderException& e) {
+        result << "threw";
+    }
+    result << " " << ProgramBinaryCache::GetStats().numWrites;
+    expected << "threw 2";
+    CompareResult(ERROR_INFO, expected, result, failedCount);
+    
+    std::filesystem::remove_all(cacheDirectory);
+    ProgramBinaryCache::SetCacheDirectory("");
+    return failedCount;
+}
+
+int TestRejectedBinaries() {
+    std::stringstream result;
+    std::stringstream expected;
+    int failedCount = 0;
+    GeometryHeap::Destroy();
+    HeadlessGL::Reset();
+    std::string cacheDirectory = useEmptyCacheDirectory();
+    
+    // A binary the driver refuses is deleted, and the program is compiled and stored again
+    result = std::stringstream();
+    expected = std::stringstream();
+    createProgram(fragmentSource);
+    std::vector<GLenum> types = {GL_VERTEX_SHADER, GL_FRAGMENT_SHADER};
+    unsigned long long oldKey = ProgramBinaryCache::GetProgramKey(types, {vertexSource, fragmentSource}, {});
+    HeadlessGL::SetDriverVersion("4.3.0 HeadlessGL 2");
+    unsigned long long newKey = ProgramBinaryCache::GetProgramKey(types, {vertexSource, fragmentSource}, {});
+    {
+        // Give the old driver's binary the new key, as if the driver changed without its version string changing
+        std::ifstream inFile(ProgramBinaryCache::GetCacheFilePath(oldKey), std::ios_base::in | std::ios_base::binary);
+        std::vector<char> bytes((std::istreambuf_iterator<char>(inFile)), std::istreambuf_iterator<char>());
+        std::memcpy(bytes.data() + 8, &newKey, sizeof(newKey));
+        std::ofstream outFile(ProgramBinaryCache::GetCacheFilePath(newKey), std::ios_base::out | std::ios_base::binary | std::ios_base::trunc);
+        outFile.write(bytes.data(), bytes.size());
+    }
+    ProgramBinaryCache::ResetStats();
+    HeadlessGL::ClearCallLog();
+    {
+        ShaderProgramPtr shaderProgramPtr = createProgram(fragmentSource);
+        result << HeadlessGL::GetCallCount("glProgramBinary") << " " << HeadlessGL::GetCallCount("glCompileShader") << " "
+                << HeadlessGL::IsProgramLinked(shaderProgramPtr->getProgram()) << " " << statsString() << ", ";
+    }
+    HeadlessGL::ClearCallLog();
+    createProgram(fragmentSource);
+    result << HeadlessGL::GetCallCount("glCompileShader") << " " << statsString() << ", ";
+    
+    // A corrupt binary file is treated the same way
+    {
+        std::ofstream outFile(ProgramBinaryCache::GetCacheFilePath(newKey), std::ios_base::out | std::ios_base::binary | std::ios_base::trunc);
+        outFile << "EPRG";
+    }
+    HeadlessGL::ClearCallLog();
+    createProgram(fragmentSource);
+    result << HeadlessGL::GetCallCount("glProgramBinary") << " " << HeadlessGL::GetCallCount("glCompileShader") << " " << statsString() << " "
+            << HeadlessGL::GetNumErrors();
+    expected << "1 2 1 0 1 1 1 0, 0 1 1 1 1 0, 0 2 1 2 2 2 0 0";
+    CompareResult(ERROR_INFO, expected, result, failedCount);
+    
+    std::filesystem::remove_all(cacheDirectory);
+    ProgramBinaryCache::SetCacheDirectory("");
+    return failedCount;
+}
+
+}
@@ -0,0 +1,22 @@
+#ifndef PROGRAM_BINARY_CACHE_TESTS_H
+#define PROGRAM_BINARY_CACHE_TESTS_H
+
+#include <iostream>
+#include <string>
+#include <graphics/shaders/shaders.h>
+#include <graphics/shaders/program_binary_cache.h>
+#include <graphics/buffer/geometry_heap.h>
+#include <headless_gl.h>
+#include <test_exception.h>
+#include <test_comparison.h>
+
+namespace Tests::ProgramBinaryCacheTests {
+
+int DoTests();
+int TestProgramKeys();
+int TestCacheHits();
+int TestRejectedBinaries();
+
+};
+
+#endif //PROGRAM_BINARY_CACHE_TESTS_H
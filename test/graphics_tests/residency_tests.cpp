@@ -0,0 +1,155 @@
+#include "residency_tests.h"
+
+using namespace Engine;
+using namespace Engine::Math;
+
+namespace Tests::ResidencyTests {
+
+int DoTests() {
+    int failedCount = 0;
+    
+    failedCount += TestMeshGeometryResidency();
+    failedCount += TestTextureResidency();
+    
+    return failedCount;
+}
+
+int TestMeshGeometryResidency() {
+    std::stringstream result;
+    std::stringstream expected;
+    int failedCount = 0;
+    GeometryHeap::Destroy();
+    HeadlessGL::Reset();
+    
+    result = std::stringstream();
+    expected = std::stringstream();
+    MemoryStats initialMemoryStats = MeshGeometryLoader::GetMemoryStats();
+    unsigned int meshGeometryID = MeshGeometryLoader::LoadMeshFromMeshGeometryData(CreateTestMeshGeometryData(16), "residency_refetch.dae");
+    MeshGeometryLoader::SetResidencyPolicy(meshGeometryID, RESIDENCY_REFETCH_HOST_COPY);
+    MeshGeometryLoader::UseLoadedMeshGeometry(meshGeometryID);
+    MeshGeometryLoader::RequireMeshGeometryBuffered(meshGeometryID);
+    MemoryStats memoryStats = MeshGeometryLoader::GetMemoryStats();
+    result << MeshGeometryLoader::IsHostResident(meshGeometryID) << ", " << memoryStats.hostBytes - initialMemoryStats.hostBytes << ", "
+            << memoryStats.deviceBytes - initialMemoryStats.deviceBytes;
+    expected << "0, 0, " << 16 * 8 * sizeof(float);
+    CompareResult(ERROR_INFO, expected, result, failedCount);
+    
+    result = std::stringstream();
+    expected = std::stringstream();
+    MeshGeometryDataPtr meshGeometryDataPtr = MeshGeometryLoader::GetMeshGeometryDataPtr(meshGeometryID);
+    result << MeshGeometryLoader::IsHostResident(meshGeometryID) << ", " << meshGeometryDataPtr->getVertices()[5] << ", "
+            << meshGeometryDataPtr->getNormals()[5] << ", " << meshGeometryDataPtr->getTextureCoords()[5];
+    expected << "1, [5, 6, 7], [0, 1, 0], [2.5, 1]";
+    CompareResult(ERROR_INFO, expected, result, failedCount);
+    
+    // Fetched back before the buffer is deleted so it can be buffered again
+    result = std::stringstream();
+    expected = std::stringstream();
+    meshGeometryDataPtr.reset();
+    MeshGeometryLoader::SetResidencyPolicy(meshGeometryID, RESIDENCY_REFETCH_HOST_COPY);
+    result << MeshGeometryLoader::IsHostResident(meshGeometryID) << ", ";
+    MeshGeometryLoader::RelaxMeshGeometryBuffered(meshGeometryID);
+    MeshGeometryLoader::ProcessDeferredReleases(true);
+    result << MeshGeometryLoader::IsHostResident(meshGeometryID) << ", " << GeometryHeap::GetVertexHeap(VERTEX_FORMAT_POSITION_NORMAL_TEXCOORD).getAllocator().getNumAllocations() << ", ";
+    MeshGeometryLoader::RequireMeshGeometryBuffered(meshGeometryID);
+    result << MeshGeometryLoader::IsHostResident(meshGeometryID) << ", " << GeometryHeap::GetVertexHeap(VERTEX_FORMAT_POSITION_NORMAL_TEXCOORD).getAllocator().getNumAllocations();
+    expected << "0, 1, 0, 0, 1";
+    CompareResult(ERROR_INFO, expected, result, failedCount);
+    MeshGeometryLoader::RelaxMeshGeometryBuffered(meshGeometryID);
+    MeshGeometryLoader::ReleaseLoadedMeshGeometry(meshGeometryID);
+    
+    result = std::stringstream();
+    expected = std::stringstream();
+    meshGeometryID = MeshGeometryLoader::LoadMeshFromMeshGeometryData(CreateTestMeshGeometryData(16), "residency_discard.dae");
+    MeshGeometryLoader::SetResidencyPolicy(meshGeometryID, RESIDENCY_DISCARD_HOST_COPY);
+    MeshGeometryLoader::UseLoadedMeshGeometry(meshGeometryID);
+    MeshGeometryLoader::RequireMeshGeometryBuffered(meshGeometryID);
+    result << MeshGeometryLoader::IsHostResident(meshGeometryID) << ", " << MeshGeometryLoader::GetNumVertices(meshGeometryID) << ", ";
+    try {
+        MeshGeometryLoader::GetMeshGeometryDataPtr(meshGeometryID);
+        result << "no exception";
+    }
+    catch(MeshException& e) {
+        result << "exception";
+    }
+    expected << "0, 16, exception";
+    CompareResult(ERROR_INFO, expected, result, failedCount);
+    MeshGeometryLoader::RelaxMeshGeometryBuffered(meshGeometryID);
+    MeshGeometryLoader::ReleaseLoadedMeshGeometry(meshGeometryID);
+    MeshGeometryLoader::ProcessDeferredReleases(true);
+    
+    // Not read back when the mesh geometry is unloaded along with its buffer
+    result = std::stringstream();
+    expected = std::stringstream();
+    meshGeometryID = MeshGeometryLoader::LoadMeshFromMeshGeometryData(CreateTestMeshGeometryData(16));
+    MeshGeometryLoader::SetResidencyPolicy(meshGeometryID, RESIDENCY_REFETCH_HOST_COPY);
+    MeshGeometryLoader::UseLoadedMeshGeometry(meshGeometryID);
+    MeshGeometryLoader::RequireMeshGeometryBuffered(meshGeometryID);
+    MeshGeometryLoader::RelaxMeshGeometryBuffered(meshGeometryID);
+    HeadlessGL::ClearCallLog();
+    MeshGeometryLoader::ReleaseLoadedMeshGeometry(meshGeometryID);
+    result << HeadlessGL::GetCallCount("glGetBufferSubData") << ", " << GeometryHeap::GetVertexHeap(VERTEX_FORMAT_POSITION_NORMAL_TEXCOORD).getAllocator().getNumAllocations();
+    expected << "0, 0";
+    CompareResult(ERROR_INFO, expected, result, failedCount);
+    
+    return failedCount;
+}
+
+int TestTextureResidency() {
+    std::stringstream result;
+    std::stringstream expected;
+    int failedCount = 0;
+    HeadlessGL::Reset();
+    
+    result = std::stringstream();
+    expected = std::stringstream();
+    MemoryStats initialMemoryStats = TextureLoader::GetMemoryStats();
+    std::vector<unsigned char> pixels(8 * 4 * 3);
+    for(unsigned int i = 0; i < pixels.size(); i++) {
+        pixels[i] = i;
+    }
+    TextureDataPtr textureDataPtr = std::make_shared<TextureData>(8, 4, 3, SharedBuffer<unsigned char>(std::move(pixels)));
+    TextureLoader::SetDefaultResidencyPolicy(RESIDENCY_REFETCH_HOST_COPY);
+    unsigned int textureID = TextureLoader::LoadTextureFromTextureData(textureDataPtr);
+    TextureLoader::SetDefaultResidencyPolicy(RESIDENCY_KEEP_HOST_COPY);
+    textureDataPtr.reset();
+    TextureLoader::UseLoadedTexture(textureID);
+    MemoryStats memoryStats = TextureLoader::GetMemoryStats();
+    result << TextureLoader::IsHostResident(textureID) << ", " << memoryStats.hostBytes - initialMemoryStats.hostBytes << ", "
+            << memoryStats.deviceBytes - initialMemoryStats.deviceBytes << ", "
+            << TextureLoader::GetWidth(textureID) << ", " << TextureLoader::GetHeight(textureID);
+    // 8x4 + 4x2 + 2x1 + 1x1 texels
+    expected << "0, 0, " << (32 + 8 + 2 + 1) * 3 << ", 8, 4";
+    CompareResult(ERROR_INFO, expected, result, failedCount);
+    
+    result = std::stringstream();
+    expected = std::stringstream();
+    TextureDataPtr fetchedTextureDataPtr = TextureLoader::CopyTextureDataFromLoaded(textureID);
+    result << TextureLoader::IsHostResident(textureID) << ", " << fetchedTextureDataPtr->getSize() << ", "
+            << (int)fetchedTextureDataPtr->getData()[0] << ", " << (int)fetchedTextureDataPtr->getData()[95] << ", "
+            << HeadlessGL::GetPackAlignment();
+    expected << "1, 96, 0, 95, 4";
+    CompareResult(ERROR_INFO, expected, result, failedCount);
+    TextureLoader::ReleaseLoadedTexture(textureID);
+    TextureLoader::ProcessDeferredReleases(true);
+    
+    // Not read back when the texture is unloaded along with its OpenGL texture
+    result = std::stringstream();
+    expected = std::stringstream();
+    textureDataPtr = std::make_shared<TextureData>(8, 4, 3, SharedBuffer<unsigned char>(std::vector<unsigned char>(8 * 4 * 3)));
+    TextureLoader::SetDefaultResidencyPolicy(RESIDENCY_REFETCH_HOST_COPY);
+    textureID = TextureLoader::LoadTextureFromTextureData(textureDataPtr);
+    TextureLoader::SetDefaultResidencyPolicy(RESIDENCY_KEEP_HOST_COPY);
+    textureDataPtr.reset();
+    TextureLoader::UseLoadedTexture(textureID);
+    TextureLoader::ReleaseLoadedTexture(textureID);
+    HeadlessGL::ClearCallLog();
+    TextureLoader::ProcessDeferredReleases(true);
+    result << HeadlessGL::GetCallCount("glGetTexImage") << ", " << HeadlessGL::GetNumLiveTextures();
+    expected << "0, 0";
+    CompareResult(ERROR_INFO, expected, result, failedCount);
+    
+    return failedCount;
+}
+
+};
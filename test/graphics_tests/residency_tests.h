@@ -0,0 +1,21 @@
+#ifndef RESIDENCY_TESTS_H
+#define RESIDENCY_TESTS_H
+
+#include <iostream>
+#include <string>
+#include <graphics/mesh/mesh_geometry_data.h>
+#include <graphics/texture/texture_data.h>
+#include <headless_gl.h>
+#include <test_exception.h>
+#include <test_comparison.h>
+#include <test_meshes.h>
+
+namespace Tests::ResidencyTests {
+
+int DoTests();
+int TestMeshGeometryResidency();
+int TestTextureResidency();
+
+};
+
+#endif //RESIDENCY_TESTS_H
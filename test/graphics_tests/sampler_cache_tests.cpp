@@ -0,0 +1,207 @@
+#include "sampler_cache_tests.h"
+
+using namespace Engine;
+
+namespace Tests::SamplerCacheTests {
+
+int DoTests() {
+    int failedCount = 0;
+    
+    failedCount += TestSamplerCache();
+    failedCount += TestTextureUnitState();
+    failedCount += TestTextureSampling();
+    
+    return failedCount;
+}
+
+static void resetState() {
+    GeometryHeap::Destroy();
+    HeadlessGL::Reset();
+    SamplerCache::Destroy();
+    SamplerCache::ResetStats();
+    TextureUnitState::Invalidate();
+    TextureUnitState::ResetStats();
+}
+
+int TestSamplerCache() {
+    std::stringstream result;
+    std::stringstream expected;
+    int failedCount = 0;
+    resetState();
+    
+    // Equal descriptions share one sampler object, created with the description's parameters
+    result = std::stringstream();
+    expected = std::stringstream();
+    {
+        SamplerDescription trilinear;
+        SamplerDescription repeating;
+        repeating.wrapS = GL_REPEAT;
+        repeating.wrapT = GL_REPEAT;
+        repeating.lodBias = -0.5f;
+        GLuint first = SamplerCache::GetSampler(trilinear);
+        GLuint second = SamplerCache::GetSampler(repeating);
+        GLuint third = SamplerCache::GetSampler(SamplerDescription());
+        result << (first == third) << (first != second) << " " << SamplerCache::GetNumSamplers() << " " << HeadlessGL::GetNumLiveSamplers() << " "
+                << SamplerCache::GetStats().numHits << " " << SamplerCache::GetStats().numMisses << ", "
+                << HeadlessGL::GetSamplerParameter(second, GL_TEXTURE_WRAP_S) << " " << HeadlessGL::GetSamplerParameter(second, GL_TEXTURE_LOD_BIAS) << " "
+                << HeadlessGL::GetSamplerParameter(first, GL_TEXTURE_MIN_FILTER) << " " << HeadlessGL::GetCallCount("glTexParameteri") << " "
+                << HeadlessGL::GetNumErrors();
+    }
+    expected << "11 2 2 1 2, " << GL_REPEAT << " -0.5 " << GL_LINEAR_MIPMAP_LINEAR << " 0 0";
+    CompareResult(ERROR_INFO, expected, result, failedCount);
+    
+    // -0 compares equal to 0, so it hashes the same and shares the sampler
+    result = std::stringstream();
+    expected = std::stringstream();
+    {
+        SamplerDescription negativeZero;
+        negativeZero.lodBias = -0.0f;
+        result << (negativeZero.getHash() == SamplerDescription().getHash()) << " "
+                << (SamplerCache::GetSampler(negativeZero) == SamplerCache::GetSampler(SamplerDescription())) << " " << SamplerCache::GetNumSamplers();
+    }
+    expected << "1 1 2";
+    CompareResult(ERROR_INFO, expected, result, failedCount);
+    
+    // Anisotropy is clamped to the driver's limit, so descriptions beyond it share a sampler
+    result = std::stringstream();
+    expected = std::stringstream();
+    {
+        SamplerDescription anisotropic;
+        anisotropic.maxAnisotropy = 16.0f;
+        SamplerDescription beyondLimit;
+        beyondLimit.maxAnisotropy = 64.0f;
+        GLuint sampler = SamplerCache::GetSampler(anisotropic);
+        result << SamplerCache::GetMaxSupportedAnisotropy() << " " << (SamplerCache::GetSampler(beyondLimit) == sampler) << " "
+                << HeadlessGL::GetSamplerParameter(sampler, GL_TEXTURE_MAX_ANISOTROPY) << " " << SamplerCache::GetNumSamplers();
+    }
+    expected << "16 1 16 3";
+    CompareResult(ERROR_INFO, expected, result, failedCount);
+    
+    // Without anisotropic filtering the parameter is never set, and destroying the cache deletes every sampler
+    result = std::stringstream();
+    expected = std::stringstream();
+    {
+        SamplerCache::Destroy();
+        result << HeadlessGL::GetNumLiveSamplers() << " ";
+        HeadlessGL::SetAnisotropicFilteringSupported(false);
+        HeadlessGL::ClearCallLog();
+        SamplerDescription anisotropic;
+        anisotropic.maxAnisotropy = 8.0f;
+        SamplerCache::GetSampler(anisotropic);
+        result << SamplerCache::GetMaxSupportedAnisotropy() << " " << SamplerCache::GetNumSamplers() << " " << (SamplerCache::GetSampler(SamplerDescription()) != 0) << " "
+                << SamplerCache::GetNumSamplers() << " " << HeadlessGL::GetCallCount("glSamplerParameterf") << " " << HeadlessGL::GetNumErrors();
+        HeadlessGL::SetAnisotropicFilteringSupported(true);
+        SamplerCache::Destroy();
+    }
+    // Four float parameters per sampler: LOD bias and the LOD range
+    expected << "0 1 1 1 1 3 0";
+    CompareResult(ERROR_INFO, expected, result, failedCount);
+    
+    return failedCount;
+}
+
+int TestTextureUnitState() {
+    std::stringstream result;
+    std::stringstream expected;
+    int failedCount = 0;
+    resetState();
+    
+    // Binding what a unit already holds makes no OpenGL calls
+    result = std::stringstream();
+    expected = std::stringstream();
+    {
+        GLuint textures[2];
+        glGenTextures(2, textures);
+        GLuint sampler = SamplerCache::GetSampler(SamplerDescription());
+        HeadlessGL::ClearCallLog();
+        TextureUnitState::Bind(0, textures[0], sampler);
+        TextureUnitState::Bind(1, textures[1], sampler);
+        TextureUnitState::Bind(0, textures[0], sampler);
+        TextureUnitState::Bind(1, textures[1], sampler);
+        const TextureBindStats& stats = TextureUnitState::GetStats();
+        result << HeadlessGL::GetCallCount("glBindTexture") << " " << HeadlessGL::GetCallCount("glBindSampler") << " "
+                << HeadlessGL::GetCallCount("glActiveTexture") << ", " << stats.textureBinds << " " << stats.samplerBinds << " " << stats.unitSwitches << " "
+                << stats.redundantBinds << ", " << (HeadlessGL::GetUnitTexture(0) == textures[0]) << (HeadlessGL::GetUnitTexture(1) == textures[1])
+                << (HeadlessGL::GetUnitSampler(0) == sampler) << (HeadlessGL::GetUnitSampler(1) == sampler) << ", ";
+        
+        // Deleting a texture unbinds it, so binding it again after its name is reused isn't skipped
+        glDeleteTextures(1, &textures[0]);
+        TextureUnitState::ForgetTexture(textures[0]);
+        HeadlessGL::ClearCallLog();
+        TextureUnitState::Bind(0, textures[0], sampler);
+        result << HeadlessGL::GetCallCount("glBindTexture") << " " << HeadlessGL::GetCallCount("glBindSampler") << ", ";
+        
+        // After invalidating, the next bind is made whatever the unit holds
+        TextureUnitState::Invalidate();
+        HeadlessGL::ClearCallLog();
+        TextureUnitState::Bind(1, textures[1], sampler);
+        result << HeadlessGL::GetCallCount("glBindTexture") << " " << HeadlessGL::GetCallCount("glBindSampler") << " "
+                << HeadlessGL::GetCallCount("glActiveTexture");
+        glDeleteTextures(1, &textures[1]);
+        TextureUnitState::ForgetTexture(textures[1]);
+    }
+    expected << "2 2 2, 2 2 2 4, 1111, 1 0, 1 1 1";
+    CompareResult(ERROR_INFO, expected, result, failedCount);
+    
+    SamplerCache::Destroy();
+    return failedCount;
+}
+
+int TestTextureSampling() {
+    std::stringstream result;
+    std::stringstream expected;
+    int failedCount = 0;
+    resetState();
+    std::vector<unsigned char> pixels(4 * 4 * 4, 128);
+    
+    // Textures are sampled through shared sampler objects, and changing how one is sampled doesn't upload it again
+    result = std::stringstream();
+    expected = std::stringstream();
+    {
+        unsigned int first = TextureLoader::LoadTextureFromTextureData(std::make_shared<TextureData>(4, 4, 4, SharedBuffer<unsigned char>(pixels)));
+        unsigned int second = TextureLoader::LoadTextureFromTextureData(std::make_shared<TextureData>(4, 4, 4, SharedBuffer<unsigned char>(pixels)));
+        TextureLoader::UseLoadedTexture(first);
+        TextureLoader::UseLoadedTexture(second);
+        
+        TextureLoader::BindTexture(first, 0);
+        TextureLoader::BindTexture(second, 1);
+        GLuint firstSampler = HeadlessGL::GetUnitSampler(0);
+        result << (firstSampler != 0) << (HeadlessGL::GetUnitSampler(1) == firstSampler) << " " << SamplerCache::GetNumSamplers() << ", ";
+        
+        unsigned int numUploads = HeadlessGL::GetCallCount("glTexImage2D") + HeadlessGL::GetCallCount("glTexSubImage2D");
+        SamplerDescription repeating = TextureLoader::GetSamplerDescription(first);
+        repeating.wrapS = GL_REPEAT;
+        repeating.wrapT = GL_REPEAT;
+        TextureLoader::SetSamplerDescription(first, repeating);
+        TextureLoader::BindTexture(first, 0);
+        GLuint repeatingSampler = HeadlessGL::GetUnitSampler(0);
+        result << (repeatingSampler != firstSampler) << " " << HeadlessGL::GetSamplerParameter(repeatingSampler, GL_TEXTURE_WRAP_T) << " "
+                << (TextureLoader::GetSamplerDescription(second) == SamplerDescription()) << " ";
+        
+        // A one-off description, as a material with its own anisotropy binds, leaves the texture's own one alone
+        SamplerDescription anisotropic = repeating;
+        anisotropic.maxAnisotropy = 8.0f;
+        TextureLoader::BindTexture(first, 0, anisotropic);
+        result << HeadlessGL::GetSamplerParameter(HeadlessGL::GetUnitSampler(0), GL_TEXTURE_MAX_ANISOTROPY) << " "
+                << (TextureLoader::GetSamplerDescription(first) == repeating) << " " << SamplerCache::GetNumSamplers() << " "
+                << (HeadlessGL::GetCallCount("glTexImage2D") + HeadlessGL::GetCallCount("glTexSubImage2D") - numUploads) << ", ";
+        
+        // Unloading a bound texture unbinds it, so a texture reusing its name is still bound
+        TextureLoader::ReleaseLoadedTexture(first);
+        ResourceReclaimer::ReclaimAll();
+        unsigned int third = TextureLoader::LoadTextureFromTextureData(std::make_shared<TextureData>(4, 4, 4, SharedBuffer<unsigned char>(pixels)));
+        TextureLoader::UseLoadedTexture(third);
+        TextureLoader::BindTexture(third, 0);
+        result << (HeadlessGL::GetUnitTexture(0) != 0) << " " << HeadlessGL::GetNumErrors();
+        TextureLoader::ReleaseLoadedTexture(second);
+        TextureLoader::ReleaseLoadedTexture(third);
+    }
+    expected << "11 1, 1 " << GL_REPEAT << " 1 8 1 3 0, 1 0";
+    CompareResult(ERROR_INFO, expected, result, failedCount);
+    
+    ResourceReclaimer::ReclaimAll();
+    SamplerCache::Destroy();
+    return failedCount;
+}
+
+}
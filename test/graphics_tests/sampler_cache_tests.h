@@ -0,0 +1,24 @@
+#ifndef SAMPLER_CACHE_TESTS_H
+#define SAMPLER_CACHE_TESTS_H
+
+#include <iostream>
+#include <string>
+#include <graphics/texture/sampler_cache.h>
+#include <graphics/texture/texture_units.h>
+#include <graphics/texture/texture_data.h>
+#include <graphics/buffer/geometry_heap.h>
+#include <graphics/buffer/resource_reclaimer.h>
+#include <headless_gl.h>
+#include <test_exception.h>
+#include <test_comparison.h>
+
+namespace Tests::SamplerCacheTests {
+
+int DoTests();
+int TestSamplerCache();
+int TestTextureUnitState();
+int TestTextureSampling();
+
+};
+
+#endif //SAMPLER_CACHE_TESTS_H
@@ -0,0 +1,307 @@
+#include "shader_preprocessor_tests.h"
+#include <map>
+
+using namespace Engine;
+
+namespace Tests::ShaderPreprocessorTests {
+
+int DoTests() {
+    int failedCount = 0;
+    
+    failedCount += TestIncludes();
+    failedCount += TestDefines();
+    failedCount += TestVariantHashes();
+    failedCount += TestShaderVariants();
+    failedCount += TestLargeIncludeGraph();
+    
+    return failedCount;
+}
+
+/*
+ * Returns a preprocessor reading from files, a map of file paths to sources.
+ */
+static ShaderPreprocessor createPreprocessor(const std::map<std::string, std::string>& files) {
+    return ShaderPreprocessor([files](const std::string& filePath, std::string& source) {
+        std::map<std::string, std::string>::const_iterator iter = files.find(filePath);
+        if(iter == files.end()) {
+            return false;
+        }
+        source = iter->second;
+        return true;
+    });
+}
+
+static std::string sourceFilesString(const ShaderPreprocessor& preprocessor) {
+    std::string sourceFiles;
+    for(unsigned int i = 0; i < preprocessor.getSourceFiles().size(); i++) {
+        sourceFiles += preprocessor.getSourceFiles()[i] + ";";
+    }
+    return sourceFiles;
+}
+
+int TestIncludes() {
+    std::stringstream result;
+    std::stringstream expected;
+    int failedCount = 0;
+    std::map<std::string, std::string> files = {
+        {"shaders/main.vs.glsl", "#version 430 core\n#include \"common/a.glsl\"\n  #  include <b.glsl>\nvoid main() {}\n"},
+        {"shaders/common/a.glsl", "#include \"../common/b.glsl\"\nfloat a;\n"},
+        {"shaders/common/b.glsl", "#include \"a.glsl\"\nfloat b;\n"},
+        {"lib/b.glsl", "float libB;\n"},
+        {"lib/c.glsl", "float c;\n"}
+    };
+    
+    // Includes resolve relative to the including file, each file is included once and cycles end
+    result = std::stringstream();
+    expected = std::stringstream();
+    ShaderPreprocessor preprocessor = createPreprocessor(files);
+    preprocessor.addIncludeDirectory("lib");
+    result << preprocessor.process("shaders/main.vs.glsl") << sourceFilesString(preprocessor);
+    expected << "#version 430 core\n#line 1 1\n#line 1 2\nfloat b;\n#line 2 1\nfloat a;\n#line 3 0\n#line 1 3\nfloat libB;\n#line 4 0\nvoid main() {}\n"
+            << "shaders/main.vs.glsl;shaders/common/a.glsl;shaders/common/b.glsl;lib/b.glsl;";
+    CompareResult(ERROR_INFO, expected, result, failedCount);
+    
+    // Without the include directory <b.glsl> is looked for next to main.vs.glsl, where it doesn't exist
+    result = std::stringstream();
+    expected = std::stringstream();
+    ShaderPreprocessor otherPreprocessor = createPreprocessor(files);
+    try {
+        otherPreprocessor.process("shaders/main.vs.glsl");
+        result << "no exception";
+    }
+    catch(const FileIOException& exception) {
+        result << "FileIOException";
+    }
+    expected << "FileIOException";
+    CompareResult(ERROR_INFO, expected, result, failedCount);
+    
+    // Include directories are searched in order after the including file's directory
+    result = std::stringstream();
+    expected = std::stringstream();
+    files["shaders/main.vs.glsl"] = "#version 430 core\n#include <b.glsl>\n#include \"c.glsl\"\n";
+    files["first/b.glsl"] = "float firstB;\n";
+    preprocessor = createPreprocessor(files);
+    preprocessor.addIncludeDirectory("first");
+    preprocessor.addIncludeDirectory("lib");
+    result << preprocessor.process("shaders/main.vs.glsl") << sourceFilesString(preprocessor);
+    expected << "#version 430 core\n#line 1 1\nfloat firstB;\n#line 3 0\n#line 1 2\nfloat c;\n#line 4 0\nshaders/main.vs.glsl;first/b.glsl;lib/c.glsl;";
+    CompareResult(ERROR_INFO, expected, result, failedCount);
+    
+    // Malformed includes, missing files and included #version directives throw
+    result = std::stringstream();
+    expected = std::stringstream();
+    std::vector<std::string> badSources = {"#include b.glsl\n", "#include \"b.glsl\n", "#include \"\"\n", "#include \"missing.glsl\"\n", "#include \"version.glsl\"\n"};
+    files["shaders/version.glsl"] = "#version 430 core\n";
+    for(unsigned int i = 0; i < badSources.size(); i++) {
+        files["shaders/bad.glsl"] = badSources[i];
+        preprocessor = createPreprocessor(files);
+        try {
+            preprocessor.process("shaders/bad.glsl");
+            result << "none ";
+        }
+        catch(const RenderException& exception) {
+            result << "Render ";
+        }
+        catch(const FileIOException& exception) {
+            result << "FileIO ";
+        }
+    }
+    try {
+        preprocessor.process("shaders/missing.vs.glsl");
+        result << "none";
+    }
+    catch(const FileIOException& exception) {
+        result << "FileIO";
+    }
+    expected << "Render Render Render FileIO Render FileIO";
+    CompareResult(ERROR_INFO, expected, result, failedCount);
+    
+    return failedCount;
+}
+
+int TestDefines() {
+    std::stringstream result;
+    std::stringstream expected;
+    int failedCount = 0;
+    
+    // Defines go after #version with the line number restored, or at the top without one
+    result = std::stringstream();
+    expected = std::stringstream();
+    ShaderPreprocessor preprocessor = createPreprocessor({
+        {"a.glsl", "// Comment\n#version 430 core\r\nvoid main() {}\n"},
+        {"b.glsl", "void main() {}\n"},
+        {"c.glsl", "float c;\n"},
+        {"d.glsl", "#version 430 core\n#include \"c.glsl\"\n"}
+    });
+    ShaderDefines defines = {{"USE_FOG", ""}, {"NUM_LIGHTS", "4"}};
+    result << preprocessor.process("a.glsl", defines) << preprocessor.process("b.glsl", defines) << preprocessor.process("a.glsl");
+    expected << "// Comment\n#version 430 core\n#define NUM_LIGHTS 4\n#define USE_FOG\n#line 3 0\nvoid main() {}\n"
+            << "#define NUM_LIGHTS 4\n#define USE_FOG\n#line 1 0\nvoid main() {}\n"
+            << "// Comment\n#version 430 core\nvoid main() {}\n";
+    CompareResult(ERROR_INFO, expected, result, failedCount);
+    
+    // Included files see the defines without them being repeated
+    result = std::stringstream();
+    expected = std::stringstream();
+    result << preprocessor.process("d.glsl", {{"USE_FOG", ""}});
+    expected << "#version 430 core\n#define USE_FOG\n#line 2 0\n#line 1 1\nfloat c;\n#line 3 0\n";
+    CompareResult(ERROR_INFO, expected, result, failedCount);
+    
+    return failedCount;
+}
+
+int TestVariantHashes() {
+    std::stringstream result;
+    std::stringstream expected;
+    int failedCount = 0;
+    
+    // Canonical defines are ordered by name whatever order they were set in
+    result = std::stringstream();
+    expected = std::stringstream();
+    ShaderDefines defines;
+    defines["USE_FOG"] = "";
+    defines["NUM_LIGHTS"] = "4";
+    ShaderDefines otherDefines;
+    otherDefines["NUM_LIGHTS"] = "4";
+    otherDefines["USE_FOG"] = "";
+    std::vector<std::string> canonicalDefines = ShaderPreprocessor::GetCanonicalDefines(defines);
+    for(unsigned int i = 0; i < canonicalDefines.size(); i++) {
+        result << canonicalDefines[i] << " ";
+    }
+    expected << "NUM_LIGHTS=4 USE_FOG ";
+    
+    // Variant hashes change with the files, their order and the defines
+    std::vector<std::string> filePaths = {"shaders/a.vs.glsl", "shaders/a.fs.glsl"};
+    unsigned long long hash = ShaderPreprocessor::GetVariantHash(filePaths, defines);
+    result << (ShaderPreprocessor::GetVariantHash(filePaths, otherDefines) == hash)
+            << (ShaderPreprocessor::GetVariantHash({"shaders/./a.vs.glsl", "shaders/a.fs.glsl"}, defines) == hash)
+            << (ShaderPreprocessor::GetVariantHash({"shaders/a.fs.glsl", "shaders/a.vs.glsl"}, defines) != hash)
+            << (ShaderPreprocessor::GetVariantHash(filePaths, {{"USE_FOG", ""}, {"NUM_LIGHTS", "8"}}) != hash)
+            << (ShaderPreprocessor::GetVariantHash(filePaths, {{"USE_FOG", ""}}) != hash)
+            << (ShaderPreprocessor::GetVariantHash(filePaths, {}) != hash);
+    expected << "111111";
+    CompareResult(ERROR_INFO, expected, result, failedCount);
+    
+    return failedCount;
+}
+
+int TestShaderVariants() {
+    std::stringstream result;
+    std::stringstream expected;
+    int failedCount = 0;
+    GeometryHeap::Destroy();
+    HeadlessGL::Reset();
+    ShaderLoader::ClearShaderVariants();
+    ShaderLoader::ResetShaderVariantStats();
+    ShaderLoader::GetShaderPreprocessor() = createPreprocessor({
+        {"variant.vs.glsl", "#version 430 core\n#include \"common.glsl\"\nvoid main() { gl_Position = transform * vec4(0.0); }\n"},
+        {"variant.fs.glsl", "#version 430 core\n#include \"common.glsl\"\nout vec4 color;\nvoid main() { color = vec4(1.0); }\n"},
+        {"common.glsl", "uniform mat4 transform;\n"}
+    });
+    ShaderFiles shaderFiles = {"variant", "variant.vs.glsl", "", "variant.fs.glsl"};
+    
+    // Each permutation is compiled once, however its defines are ordered
+    result = std::stringstream();
+    expected = std::stringstream();
+    ShaderDefines defines;
+    defines["USE_FOG"] = "";
+    defines["NUM_LIGHTS"] = "4";
+    ShaderProgramPtr plainPtr = ShaderLoader::GetShaderVariant(shaderFiles);
+    ShaderProgramPtr foggyPtr = ShaderLoader::GetShaderVariant(shaderFiles, defines);
+    ShaderDefines otherDefines;
+    otherDefines["NUM_LIGHTS"] = "4";
+    otherDefines["USE_FOG"] = "";
+    result << (ShaderLoader::GetShaderVariant(shaderFiles, otherDefines) == foggyPtr) << (ShaderLoader::GetShaderVariant(shaderFiles) == plainPtr)
+            << (plainPtr != foggyPtr) << " " << HeadlessGL::GetCallCount("glCompileShader") << " " << ShaderLoader::GetNumShaderVariants() << " "
+            << ShaderLoader::GetShaderVariantStats().numCompiles << " " << ShaderLoader::GetShaderVariantStats().numHits << " "
+            << plainPtr->getShaderProgramName() << " " << foggyPtr->getShaderProgramName() << " "
+            << ShaderLoader::GetShaderPreprocessor().getNumFileReads() << " " << HeadlessGL::IsProgramLinked(foggyPtr->getProgram()) << " ";
+    
+    // The compiled sources hold the includes and defines
+    std::string foggySource = HeadlessGL::GetProgramSource(foggyPtr->getProgram());
+    result << (foggySource.find("#define USE_FOG") != std::string::npos) << (foggySource.find("uniform mat4 transform;") != std::string::npos)
+            << (foggySource.find("#include") == std::string::npos) << (foggyPtr->getUniformLocation("transform") != -1) << " " << HeadlessGL::GetNumErrors();
+    expected << "111 4 2 2 2 variant variant[NUM_LIGHTS=4,USE_FOG] 3 1 1111 0";
+    CompareResult(ERROR_INFO, expected, result, failedCount);
+    
+    // Cleared variants are compiled again
+    result = std::stringstream();
+    expected = std::stringstream();
+    plainPtr = nullptr;
+    foggyPtr = nullptr;
+    ShaderLoader::ClearShaderVariants();
+    unsigned int numLivePrograms = HeadlessGL::GetNumLivePrograms();
+    HeadlessGL::ClearCallLog();
+    ShaderLoader::GetShaderVariant(shaderFiles, defines);
+    result << numLivePrograms << " " << ShaderLoader::GetNumShaderVariants() << " " << HeadlessGL::GetCallCount("glCompileShader");
+    expected << "0 1 2";
+    CompareResult(ERROR_INFO, expected, result, failedCount);
+    
+    ShaderLoader::ClearShaderVariants();
+    ShaderLoader::GetShaderPreprocessor() = ShaderPreprocessor();
+    return failedCount;
+}
+
+int TestLargeIncludeGraph() {
+    std::stringstream result;
+    std::stringstream expected;
+    int failedCount = 0;
+    
+    /*
+     * A layered graph where every file of a layer includes every file of the next, so the number of include paths
+     * grows exponentially with depth. Each file is still read and included once.
+     */
+    const unsigned int numLayers = 16;
+    const unsigned int layerWidth = 16;
+    std::map<std::string, std::string> files;
+    for(unsigned int layer = 0; layer < numLayers; layer++) {
+        for(unsigned int i = 0; i < layerWidth; i++) {
+            std::string source;
+            if(layer + 1 < numLayers) {
+                for(unsigned int j = 0; j < layerWidth; j++) {
+                    source += "#include \"layer" + std::to_string(layer + 1) + "/file" + std::to_string(j) + ".glsl\"\n";
+                }
+            }
+            source += "float value" + std::to_string(layer) + "_" + std::to_string(i) + ";\n";
+            files["include/layer" + std::to_string(layer) + "/file" + std::to_string(i) + ".glsl"] = source;
+        }
+    }
+    std::string rootSource = "#version 430 core\n";
+    for(unsigned int i = 0; i < layerWidth; i++) {
+        rootSource += "#include \"layer0/file" + std::to_string(i) + ".glsl\"\n";
+    }
+    files["root.glsl"] = rootSource;
+    
+    result = std::stringstream();
+    expected = std::stringstream();
+    unsigned int numReads = 0;
+    ShaderPreprocessor preprocessor([&files, &numReads](const std::string& filePath, std::string& source) {
+        std::map<std::string, std::string>::const_iterator iter = files.find(filePath);
+        if(iter == files.end()) {
+            return false;
+        }
+        numReads++;
+        source = iter->second;
+        return true;
+    });
+    preprocessor.addIncludeDirectory("include");
+    std::string output = preprocessor.process("root.glsl", {{"USE_FOG", ""}});
+    unsigned int numValues = 0;
+    for(size_t position = output.find("float value"); position != std::string::npos; position = output.find("float value", position + 1)) {
+        numValues++;
+    }
+    result << numValues << " " << preprocessor.getSourceFiles().size() << " " << numReads << " " << preprocessor.getNumFileReads() << " ";
+    
+    // The deepest files come first, so every value is declared before the files that include it
+    result << (output.find("float value15_0;") < output.find("float value14_0;")) << (output.find("float value1_15;") < output.find("float value0_0;"));
+    
+    // Processing again for another variant reads nothing
+    preprocessor.process("root.glsl");
+    result << " " << numReads;
+    expected << "256 257 257 257 11 257";
+    CompareResult(ERROR_INFO, expected, result, failedCount);
+    
+    return failedCount;
+}
+
+}
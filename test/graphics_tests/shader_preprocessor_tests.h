@@ -0,0 +1,24 @@
+#ifndef SHADER_PREPROCESSOR_TESTS_H
+#define SHADER_PREPROCESSOR_TESTS_H
+
+#include <iostream>
+#include <string>
+#include <graphics/shaders/shaders.h>
+#include <graphics/shaders/shader_preprocessor.h>
+#include <graphics/buffer/geometry_heap.h>
+#include <headless_gl.h>
+#include <test_exception.h>
+#include <test_comparison.h>
+
+namespace Tests::ShaderPreprocessorTests {
+
+int DoTests();
+int TestIncludes();
+int TestDefines();
+int TestVariantHashes();
+int TestShaderVariants();
+int TestLargeIncludeGraph();
+
+};
+
+#endif //SHADER_PREPROCESSOR_TESTS_H
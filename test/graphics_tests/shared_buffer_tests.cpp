@@ -0,0 +1,116 @@
+#include "shared_buffer_tests.h"
+
+using namespace Engine;
+using namespace Engine::Math;
+
+namespace Tests::SharedBufferTests {
+
+int DoTests() {
+    int failedCount = 0;
+    
+    failedCount += TestCopyOnWrite();
+    failedCount += TestMeshGeometryCopies();
+    failedCount += TestTextureCopies();
+    
+    return failedCount;
+}
+
+int TestCopyOnWrite() {
+    std::stringstream result;
+    std::stringstream expected;
+    int failedCount = 0;
+    
+    result = std::stringstream();
+    expected = std::stringstream();
+    BufferCopyStats::Reset();
+    SharedBuffer<unsigned int> buffer1 = SharedBuffer<unsigned int>(std::vector<unsigned int>({1, 2, 3, 4}));
+    SharedBuffer<unsigned int> buffer2 = buffer1;
+    result << BufferCopyStats::GetBytesCopied() << ", " << buffer1.sharesWith(buffer2) << ", " << buffer1.isUnique();
+    expected << "0, 1, 0";
+    CompareResult(ERROR_INFO, expected, result, failedCount);
+    
+    result = std::stringstream();
+    expected = std::stringstream();
+    buffer2.mutableData()[0] = 10;
+    result << BufferCopyStats::GetBytesCopied() << ", " << buffer1.sharesWith(buffer2) << ", " << buffer1[0] << ", " << buffer2[0];
+    expected << 4 * sizeof(unsigned int) << ", 0, 1, 10";
+    CompareResult(ERROR_INFO, expected, result, failedCount);
+    
+    result = std::stringstream();
+    expected = std::stringstream();
+    BufferCopyStats::Reset();
+    buffer2.mutableData()[1] = 20;
+    result << BufferCopyStats::GetBytesCopied() << ", " << buffer2[1] << ", " << buffer2.getSize();
+    expected << "0, 20, 4";
+    CompareResult(ERROR_INFO, expected, result, failedCount);
+    
+    result = std::stringstream();
+    expected = std::stringstream();
+    std::vector<unsigned int> values({5, 6});
+    SharedBuffer<unsigned int> buffer3 = SharedBuffer<unsigned int>(values);
+    result << BufferCopyStats::GetBytesCopied() << ", " << BufferCopyStats::GetCopyCount();
+    expected << 2 * sizeof(unsigned int) << ", 1";
+    CompareResult(ERROR_INFO, expected, result, failedCount);
+    
+    return failedCount;
+}
+
+int TestMeshGeometryCopies() {
+    std::stringstream result;
+    std::stringstream expected;
+    int failedCount = 0;
+    
+    result = std::stringstream();
+    expected = std::stringstream();
+    std::vector<Vec3f> vertices(300, Vec3f(1.0f));
+    std::vector<Vec3f> normals(300, Vec3f(0.0f));
+    std::vector<Vec2f> textureCoords(300, Vec2f(0.5f));
+    BufferCopyStats::Reset();
+    MeshGeometryDataPtr meshGeometryDataPtr = std::make_shared<MeshGeometryData>(SharedBuffer<Vec3f>(std::move(vertices)),
+            SharedBuffer<Vec3f>(std::move(normals)), SharedBuffer<Vec2f>(std::move(textureCoords)));
+    unsigned int meshGeometryID = MeshGeometryLoader::LoadMeshFromMeshGeometryData(meshGeometryDataPtr);
+    MeshGeometryDataPtr copiedMeshGeometryDataPtr = MeshGeometryLoader::CopyMeshGeometryDataFromLoaded(meshGeometryID);
+    result << BufferCopyStats::GetBytesCopied() << ", " << copiedMeshGeometryDataPtr->getNumVertices() << ", "
+            << copiedMeshGeometryDataPtr->getVertices().sharesWith(meshGeometryDataPtr->getVertices());
+    expected << "0, 300, 1";
+    CompareResult(ERROR_INFO, expected, result, failedCount);
+    
+    result = std::stringstream();
+    expected = std::stringstream();
+    copiedMeshGeometryDataPtr->mutableNormals()[0] = Vec3f(2.0f);
+    result << BufferCopyStats::GetBytesCopied() << ", " << MeshGeometryLoader::GetMeshGeometryDataPtr(meshGeometryID)->getNormals()[0]
+            << ", " << copiedMeshGeometryDataPtr->getNormals()[0];
+    expected << 300 * sizeof(Vec3f) << ", [0, 0, 0], [2, 2, 2]";
+    CompareResult(ERROR_INFO, expected, result, failedCount);
+    
+    return failedCount;
+}
+
+int TestTextureCopies() {
+    std::stringstream result;
+    std::stringstream expected;
+    int failedCount = 0;
+    
+    result = std::stringstream();
+    expected = std::stringstream();
+    std::vector<unsigned char> pixels(64 * 64 * 3, 128);
+    BufferCopyStats::Reset();
+    TextureDataPtr textureDataPtr = std::make_shared<TextureData>(64, 64, 3, SharedBuffer<unsigned char>(std::move(pixels)));
+    unsigned int textureID = TextureLoader::LoadTextureFromTextureData(textureDataPtr);
+    TextureDataPtr copiedTextureDataPtr = TextureLoader::CopyTextureDataFromLoaded(textureID);
+    result << BufferCopyStats::GetBytesCopied() << ", " << copiedTextureDataPtr->getSize() << ", "
+            << copiedTextureDataPtr->getData().sharesWith(TextureLoader::GetTextureDataPtr(textureID)->getData());
+    expected << "0, " << 64 * 64 * 3 << ", 1";
+    CompareResult(ERROR_INFO, expected, result, failedCount);
+    
+    result = std::stringstream();
+    expected = std::stringstream();
+    copiedTextureDataPtr->mutableData()[0] = 0;
+    result << BufferCopyStats::GetBytesCopied() << ", " << (int)TextureLoader::GetTextureDataPtr(textureID)->getData()[0];
+    expected << 64 * 64 * 3 << ", 128";
+    CompareResult(ERROR_INFO, expected, result, failedCount);
+    
+    return failedCount;
+}
+
+};
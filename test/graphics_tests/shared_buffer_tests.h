@@ -0,0 +1,21 @@
+#ifndef SHARED_BUFFER_TESTS_H
+#define SHARED_BUFFER_TESTS_H
+
+#include <iostream>
+#include <string>
+#include <graphics/buffer/shared_buffer.h>
+#include <graphics/mesh/mesh_geometry_data.h>
+#include <graphics/texture/texture_data.h>
+#include <test_exception.h>
+#include <test_comparison.h>
+
+namespace Tests::SharedBufferTests {
+
+int DoTests();
+int TestCopyOnWrite();
+int TestMeshGeometryCopies();
+int TestTextureCopies();
+
+};
+
+#endif //SHARED_BUFFER_TESTS_H
@@ -0,0 +1,234 @@
+#include "static_batching_tests.h"
+
+using namespace Engine;
+using namespace Engine::Math;
+
+namespace Tests::StaticBatchingTests {
+
+int DoTests() {
+    int failedCount = 0;
+    
+    failedCount += TestStaticBatchGeometry();
+    failedCount += TestStaticBatchLimits();
+    failedCount += TestDrawVisibleRanges();
+    failedCount += TestSharedGeometry();
+    failedCount += TestMirroredNormals();
+    
+    return failedCount;
+}
+
+// Creates a triangle in the z = 0 plane facing +z
+static MeshDataPtr createTriangleMeshData() {
+    std::vector<Vec3f> vertices = {createVec3<float>(0.0f, 0.0f, 0.0f), createVec3<float>(1.0f, 0.0f, 0.0f), createVec3<float>(0.0f, 1.0f, 0.0f)};
+    std::vector<Vec3f> normals(3, createVec3<float>(0.0f, 0.0f, 1.0f));
+    std::vector<Vec2f> textureCoords = {createVec2<float>(0.0f, 0.0f), createVec2<float>(1.0f, 0.0f), createVec2<float>(0.0f, 1.0f)};
+    MeshGeometryDataPtr meshGeometryDataPtr = std::make_shared<MeshGeometryData>(SharedBuffer<Vec3f>(std::move(vertices)),
+            SharedBuffer<Vec3f>(std::move(normals)), SharedBuffer<Vec2f>(std::move(textureCoords)));
+    return std::make_shared<MeshData>(SharedBuffer<unsigned int>(std::vector<unsigned int>({0, 1, 2})), meshGeometryDataPtr);
+}
+
+static TexturedMaterial createTexturedMaterial() {
+    TextureDataPtr textureDataPtr = std::make_shared<TextureData>(4, 1, 4, SharedBuffer<unsigned char>(std::vector<unsigned char>(16, 255)));
+    return TexturedMaterial(ShaderProgramPtr(), {Texture(textureDataPtr, TEXTURE_DIFFUSE)}, {1.0f});
+}
+
+int TestStaticBatchGeometry() {
+    std::stringstream result;
+    std::stringstream expected;
+    int failedCount = 0;
+    GeometryHeap::Destroy();
+    HeadlessGL::Reset();
+    
+    // Meshes sharing a material are merged into one batch with world space vertices and rebased indices
+    result = std::stringstream();
+    expected = std::stringstream();
+    {
+        Mesh plainMesh(createTriangleMeshData(), TexturedMaterial(), UnTexturedMaterial());
+        Mesh texturedMesh(createTriangleMeshData(), createTexturedMaterial(), UnTexturedMaterial());
+        StaticBatcher staticBatcher;
+        staticBatcher.addMesh(plainMesh, createTranslationMat(createVec3<float>(10.0f, 0.0f, 0.0f)));
+        staticBatcher.addMesh(texturedMesh, Mat4f(1.0f));
+        staticBatcher.addMesh(plainMesh, createScaleMat(createVec3<float>(2.0f, 2.0f, 4.0f)));
+        std::vector<StaticBatch> batches = staticBatcher.build();
+        result << batches.size() << ", " << staticBatcher.getNumSources() << ", ";
+        const StaticBatch& batch = batches[0];
+        const MeshGeometryDataPtr meshGeometryDataPtr = batch.meshDataPtr->getMeshGeometryDataPtr();
+        result << meshGeometryDataPtr->getNumVertices() << " " << batch.meshDataPtr->getIndices().getSize() << ", "
+                << meshGeometryDataPtr->getVertices()[1][0] << " " << meshGeometryDataPtr->getVertices()[4][0] << ", ";
+        for(unsigned int i = 0; i < batch.meshDataPtr->getIndices().getSize(); i++) {
+            result << batch.meshDataPtr->getIndices()[i] << " ";
+        }
+        result << ", " << meshGeometryDataPtr->getNormals()[3][2] << ", ";
+        for(unsigned int i = 0; i < batch.sourceRanges.size(); i++) {
+            const StaticBatchRange& range = batch.sourceRanges[i];
+            result << range.sourceIndex << " " << range.firstIndex << " " << range.numIndices << " " << range.firstVertex << " "
+                    << range.boundsMin[0] << " " << range.boundsMax[0] << " " << range.boundsMax[1] << ", ";
+        }
+        result << batches[1].sourceRanges[0].sourceIndex << " " << batches[1].texturedMaterial.getTextures().size();
+    }
+    expected << "2, 0, 6 6, 11 2, 0 1 2 3 4 5 , 1, 0 0 3 0 10 11 1, 2 3 3 3 0 2 2, 1 1";
+    CompareResult(ERROR_INFO, expected, result, failedCount);
+    
+    ResourceReclaimer::ReclaimAll();
+    return failedCount;
+}
+
+int TestStaticBatchLimits() {
+    std::stringstream result;
+    std::stringstream expected;
+    int failedCount = 0;
+    GeometryHeap::Destroy();
+    HeadlessGL::Reset();
+    
+    // Batches are split at the vertex limit, and drawing the batched model takes one draw per batch
+    result = std::stringstream();
+    expected = std::stringstream();
+    {
+        std::vector<Mesh> props;
+        for(unsigned int i = 0; i < 10; i++) {
+            props.push_back(Mesh(createTriangleMeshData(), TexturedMaterial(), UnTexturedMaterial()));
+        }
+        StaticBatcher staticBatcher(12, 1000);
+        for(unsigned int i = 0; i < props.size(); i++) {
+            staticBatcher.addMesh(props[i], createTranslationMat(createVec3<float>((float)i, 0.0f, 0.0f)));
+        }
+        std::vector<StaticBatch> batches = staticBatcher.build();
+        for(unsigned int i = 0; i < batches.size(); i++) {
+            result << batches[i].sourceRanges.size() << " ";
+        }
+        Model batchedModel(StaticBatcher::CreateModelData(batches));
+        ModelDataPtr modelDataPtr = batchedModel.getModelDataPtr();
+        HeadlessGL::ClearCallLog();
+        for(unsigned int i = 0; i < modelDataPtr->getNumMeshes(); i++) {
+            const Mesh& mesh = modelDataPtr->getMesh(i);
+            MeshDrawRange drawRange = MeshLoader::GetDrawRange(mesh.getMeshID());
+            MeshLoader::BindMesh(mesh.getMeshID());
+            glDrawElementsBaseVertex(GL_TRIANGLES, drawRange.numIndices, GL_UNSIGNED_INT, (void*)(drawRange.firstIndex * sizeof(unsigned int)), drawRange.baseVertex);
+        }
+        result << ", " << HeadlessGL::GetDrawLog().size() << " " << HeadlessGL::GetDrawLog()[2].count;
+    }
+    expected << "4 4 2 , 3 6";
+    CompareResult(ERROR_INFO, expected, result, failedCount);
+    
+    ResourceReclaimer::ReclaimAll();
+    return failedCount;
+}
+
+int TestDrawVisibleRanges() {
+    std::stringstream result;
+    std::stringstream expected;
+    int failedCount = 0;
+    GeometryHeap::Destroy();
+    HeadlessGL::Reset();
+    
+    // Consecutive visible source ranges are drawn together and culled ones are skipped
+    result = std::stringstream();
+    expected = std::stringstream();
+    {
+        Mesh prop(createTriangleMeshData(), TexturedMaterial(), UnTexturedMaterial());
+        StaticBatcher staticBatcher;
+        for(unsigned int i = 0; i < 5; i++) {
+            staticBatcher.addMesh(prop, createTranslationMat(createVec3<float>((float)i, 0.0f, 0.0f)));
+        }
+        std::vector<StaticBatch> batches = staticBatcher.build();
+        Mesh batchMesh(batches[0].meshDataPtr, batches[0].texturedMaterial, batches[0].unTexturedMaterial);
+        HeadlessGL::ClearCallLog();
+        unsigned int numDrawCalls = StaticBatcher::DrawVisibleRanges(batchMesh, batches[0].sourceRanges, {true, true, false, true, true});
+        const std::vector<HeadlessGL::DrawRecord>& drawLog = HeadlessGL::GetDrawLog();
+        result << numDrawCalls << ", ";
+        for(unsigned int i = 0; i < drawLog.size(); i++) {
+            result << drawLog[i].count << " " << drawLog[i].indexOffset / sizeof(unsigned int) - MeshLoader::GetFirstIndex(batchMesh.getMeshID()) << ", ";
+        }
+        result << StaticBatcher::DrawVisibleRanges(batchMesh, batches[0].sourceRanges, {false, false, false, false, false});
+    }
+    expected << "2, 6 0, 6 9, 0";
+    CompareResult(ERROR_INFO, expected, result, failedCount);
+    
+    ResourceReclaimer::ReclaimAll();
+    return failedCount;
+}
+
+int TestSharedGeometry() {
+    std::stringstream result;
+    std::stringstream expected;
+    int failedCount = 0;
+    GeometryHeap::Destroy();
+    HeadlessGL::Reset();
+    
+    // Meshes sharing one geometry, as the meshes of a converted model do, only bring the vertices they use
+    result = std::stringstream();
+    expected = std::stringstream();
+    {
+        std::vector<Vec3f> vertices = {createVec3<float>(0.0f, 0.0f, 0.0f), createVec3<float>(1.0f, 0.0f, 0.0f), createVec3<float>(0.0f, 1.0f, 0.0f),
+                createVec3<float>(5.0f, 0.0f, 0.0f), createVec3<float>(6.0f, 0.0f, 0.0f), createVec3<float>(5.0f, 3.0f, 0.0f)};
+        std::vector<Vec3f> normals(6, createVec3<float>(0.0f, 0.0f, 1.0f));
+        std::vector<Vec2f> textureCoords(6, createVec2<float>(0.0f, 0.0f));
+        MeshGeometryDataPtr meshGeometryDataPtr = std::make_shared<MeshGeometryData>(SharedBuffer<Vec3f>(std::move(vertices)),
+                SharedBuffer<Vec3f>(std::move(normals)), SharedBuffer<Vec2f>(std::move(textureCoords)));
+        Mesh firstMesh(std::make_shared<MeshData>(SharedBuffer<unsigned int>(std::vector<unsigned int>({0, 1, 2})), meshGeometryDataPtr),
+                TexturedMaterial(), UnTexturedMaterial());
+        Mesh secondMesh(std::make_shared<MeshData>(SharedBuffer<unsigned int>(std::vector<unsigned int>({5, 3, 4, 3, 5, 4})), meshGeometryDataPtr),
+                TexturedMaterial(), UnTexturedMaterial());
+        StaticBatcher staticBatcher;
+        staticBatcher.addMesh(firstMesh, Mat4f(1.0f));
+        staticBatcher.addMesh(secondMesh, Mat4f(1.0f));
+        std::vector<StaticBatch> batches = staticBatcher.build();
+        const StaticBatch& batch = batches[0];
+        result << batches.size() << " " << batch.meshDataPtr->getMeshGeometryDataPtr()->getNumVertices() << ", ";
+        for(unsigned int i = 0; i < batch.meshDataPtr->getIndices().getSize(); i++) {
+            result << batch.meshDataPtr->getIndices()[i] << " ";
+        }
+        result << ", ";
+        for(unsigned int i = 0; i < batch.sourceRanges.size(); i++) {
+            const StaticBatchRange& range = batch.sourceRanges[i];
+            result << range.firstVertex << " " << range.numVertices << " " << range.boundsMin[0] << " " << range.boundsMax[0] << " " << range.boundsMax[1] << ", ";
+        }
+        // Only the used vertices count against the limit
+        StaticBatcher limitedBatcher(6, 1000);
+        limitedBatcher.addMesh(firstMesh, Mat4f(1.0f));
+        limitedBatcher.addMesh(secondMesh, Mat4f(1.0f));
+        result << limitedBatcher.build().size();
+    }
+    expected << "1 6, 0 1 2 3 4 5 4 3 5 , 0 3 0 1 1, 3 3 5 6 3, 1";
+    CompareResult(ERROR_INFO, expected, result, failedCount);
+    
+    ResourceReclaimer::ReclaimAll();
+    return failedCount;
+}
+
+int TestMirroredNormals() {
+    std::stringstream result;
+    std::stringstream expected;
+    int failedCount = 0;
+    GeometryHeap::Destroy();
+    HeadlessGL::Reset();
+    
+    // Mirroring keeps normals facing out of the mirrored surface: flipping z turns the triangle's normal to -z, while
+    // flipping x leaves it at +z. Every mirrored triangle has its winding swapped back
+    result = std::stringstream();
+    expected = std::stringstream();
+    {
+        Mesh prop(createTriangleMeshData(), TexturedMaterial(), UnTexturedMaterial());
+        StaticBatcher staticBatcher;
+        staticBatcher.addMesh(prop, createScaleMat(createVec3<float>(1.0f, 1.0f, -1.0f)));
+        staticBatcher.addMesh(prop, createScaleMat(createVec3<float>(-2.0f, 1.0f, 1.0f)));
+        staticBatcher.addMesh(prop, createScaleMat(createVec3<float>(-1.0f, -1.0f, -1.0f)));
+        std::vector<StaticBatch> batches = staticBatcher.build();
+        const SharedBuffer<Vec3f>& normals = batches[0].meshDataPtr->getMeshGeometryDataPtr()->getNormals();
+        for(unsigned int i = 0; i < normals.getSize(); i += 3) {
+            // Adding 0 prints -0 as 0
+            result << normals[i][0] + 0.0f << " " << normals[i][1] + 0.0f << " " << normals[i][2] + 0.0f << ", ";
+        }
+        const SharedBuffer<unsigned int>& indices = batches[0].meshDataPtr->getIndices();
+        for(unsigned int i = 0; i < indices.getSize(); i++) {
+            result << indices[i] << " ";
+        }
+    }
+    expected << "0 0 -1, 0 0 1, 0 0 -1, 0 2 1 3 5 4 6 8 7 ";
+    CompareResult(ERROR_INFO, expected, result, failedCount);
+    
+    ResourceReclaimer::ReclaimAll();
+    return failedCount;
+}
+
+};
@@ -0,0 +1,24 @@
+#ifndef STATIC_BATCHING_TESTS_H
+#define STATIC_BATCHING_TESTS_H
+
+#include <iostream>
+#include <string>
+#include <graphics/model/static_batcher.h>
+#include <graphics/buffer/resource_reclaimer.h>
+#include <math/linear_math.h>
+#include <headless_gl.h>
+#include <test_exception.h>
+#include <test_comparison.h>
+
+namespace Tests::StaticBatchingTests {
+
+int DoTests();
+int TestStaticBatchGeometry();
+int TestStaticBatchLimits();
+int TestDrawVisibleRanges();
+int TestSharedGeometry();
+int TestMirroredNormals();
+
+};
+
+#endif //STATIC_BATCHING_TESTS_H
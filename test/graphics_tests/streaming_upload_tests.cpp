@@ -0,0 +1,335 @@
+#include "streaming_upload_tests.h"
+
+using namespace Engine;
+using namespace Engine::Math;
+
+namespace Tests::StreamingUploadTests {
+
+int DoTests() {
+    int failedCount = 0;
+    
+    failedCount += TestStreamingRing();
+    failedCount += TestStreamingRingWrap();
+    failedCount += TestUploadBudget();
+    failedCount += TestRingFullDeferral();
+    failedCount += TestUploadsLargerThanRing();
+    failedCount += TestStagedLoaderUploads();
+    
+    return failedCount;
+}
+
+static GLuint createBuffer(const size_t size) {
+    GLuint buffer = 0;
+    glGenBuffers(1, &buffer);
+    glBindBuffer(GL_COPY_WRITE_BUFFER, buffer);
+    glBufferData(GL_COPY_WRITE_BUFFER, size, nullptr, GL_STATIC_DRAW);
+    glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+    return buffer;
+}
+
+static std::vector<unsigned char> readBuffer(const GLuint buffer) {
+    std::vector<unsigned char> data(HeadlessGL::GetBufferSize(buffer));
+    glBindBuffer(GL_COPY_READ_BUFFER, buffer);
+    glGetBufferSubData(GL_COPY_READ_BUFFER, 0, data.size(), data.data());
+    glBindBuffer(GL_COPY_READ_BUFFER, 0);
+    return data;
+}
+
+static std::vector<unsigned char> createTestData(const size_t size) {
+    std::vector<unsigned char> data(size);
+    for(size_t i = 0; i < size; i++) {
+        data[i] = (unsigned char)(i * 7 + 1);
+    }
+    return data;
+}
+
+static void resetUploadScheduler() {
+    UploadScheduler::Destroy();
+    UploadScheduler::SetStagingEnabled(false);
+    UploadScheduler::SetRingCapacity(8 * 1024 * 1024);
+    UploadScheduler::SetFrameByteBudget(4 * 1024 * 1024);
+    UploadScheduler::ResetStats();
+}
+
+int TestStreamingRing() {
+    std::stringstream result;
+    std::stringstream expected;
+    int failedCount = 0;
+    HeadlessGL::Reset();
+    HeadlessGL::SetManualFenceSignalling(true);
+    
+    // Allocations are aligned, and a full ring fails without waiting or waits for the oldest frame
+    result = std::stringstream();
+    expected = std::stringstream();
+    StreamingRing ring(64);
+    size_t offset = 0;
+    ring.allocate(24, 16, offset);
+    result << offset << " ";
+    ring.allocate(24, 16, offset);
+    result << offset << " " << ring.getUsedBytes() << ", ";
+    ring.endFrame();
+    result << (ring.tryAllocate(24, 16, offset) == nullptr) << " " << ring.getStats().numStalls << ", ";
+    result << (ring.allocate(24, 16, offset) != nullptr) << " " << offset << " " << ring.getStats().numStalls << " "
+            << HeadlessGL::GetNumBlockingWaits() << " " << ring.getNumPendingFrames() << ", " << ring.isPersistent();
+    expected << "0 32 56, 1 0, 1 0 1 1 0, 1";
+    CompareResult(ERROR_INFO, expected, result, failedCount);
+    
+    // Signalled frames are retired without waiting, and allocations larger than the ring fail
+    result = std::stringstream();
+    expected = std::stringstream();
+    ring.endFrame();
+    ring.allocate(16, 16, offset);
+    result << offset << " ";
+    ring.endFrame();
+    HeadlessGL::SignalFences();
+    ring.tryAllocate(40, 16, offset);
+    result << offset << " " << ring.getNumPendingFrames() << " " << ring.getUsedBytes() << ", " << ring.getStats().numStalls << " "
+            << HeadlessGL::GetNumBlockingWaits() << ", " << (ring.allocate(65, 1, offset) == nullptr);
+    expected << "32 0 0 40, 1 1, 1";
+    CompareResult(ERROR_INFO, expected, result, failedCount);
+    
+    // Destroying releases the buffer and fences
+    result = std::stringstream();
+    expected = std::stringstream();
+    ring.endFrame();
+    ring.destroy();
+    result << HeadlessGL::GetNumLiveBuffers() << ", " << HeadlessGL::GetNumLiveSyncs();
+    expected << "0, 0";
+    CompareResult(ERROR_INFO, expected, result, failedCount);
+    
+    return failedCount;
+}
+
+int TestStreamingRingWrap() {
+    std::stringstream result;
+    std::stringstream expected;
+    int failedCount = 0;
+    HeadlessGL::Reset();
+    HeadlessGL::SetManualFenceSignalling(true);
+    
+    // An allocation that doesn't fit before the end of the ring restarts at its beginning once the oldest frame retires
+    result = std::stringstream();
+    expected = std::stringstream();
+    StreamingRing ring(64);
+    size_t offset = 0;
+    ring.allocate(32, 16, offset);
+    ring.endFrame();
+    ring.allocate(16, 16, offset);
+    result << offset << " ";
+    ring.endFrame();
+    HeadlessGL::SignalOldestFence();
+    result << (ring.tryAllocate(24, 16, offset) != nullptr) << " " << offset << " " << ring.getStats().numWraps << " "
+            << ring.getUsedBytes() << " " << ring.getNumPendingFrames() << ", ";
+    // The wasted end of the ring is held until the frame that wrapped retires
+    result << (ring.tryAllocate(16, 16, offset) == nullptr);
+    expected << "32 1 0 1 56 1, 1";
+    CompareResult(ERROR_INFO, expected, result, failedCount);
+    
+    ring.destroy();
+    return failedCount;
+}
+
+int TestUploadBudget() {
+    std::stringstream result;
+    std::stringstream expected;
+    int failedCount = 0;
+    HeadlessGL::Reset();
+    resetUploadScheduler();
+    UploadScheduler::SetStagingEnabled(true);
+    UploadScheduler::SetRingCapacity(1024);
+    UploadScheduler::SetFrameByteBudget(100);
+    
+    // A queued buffer upload is split over frames by the byte budget
+    result = std::stringstream();
+    expected = std::stringstream();
+    GLuint buffer = createBuffer(300);
+    std::vector<unsigned char> data = createTestData(250);
+    bool completed = false;
+    unsigned int uploadID = UploadScheduler::QueueBufferUpload(buffer, 50, SharedBuffer<unsigned char>(data), [&completed]() { completed = true; });
+    for(unsigned int frame = 0; frame < 3; frame++) {
+        UploadScheduler::ProcessUploads();
+        result << UploadScheduler::GetFrameBytesUploaded() << " " << UploadScheduler::GetPendingBytes() << " " << completed << ", ";
+        UploadScheduler::EndFrame();
+    }
+    std::vector<unsigned char> bufferData = readBuffer(buffer);
+    result << std::equal(data.begin(), data.end(), bufferData.begin() + 50) << ", " << UploadScheduler::IsUploadPending(uploadID) << ", "
+            << UploadScheduler::GetStats().bytesStaged << " " << UploadScheduler::GetStats().bytesUploadedDirectly << " "
+            << UploadScheduler::GetStats().numBudgetDeferrals << " " << UploadScheduler::GetStats().numUploadsCompleted << ", "
+            << HeadlessGL::GetCallCount("glCopyBufferSubData") << " " << HeadlessGL::GetCallCount("glBufferSubData") << ", " << HeadlessGL::GetNumErrors();
+    expected << "100 150 0, 100 50 0, 50 0 1, 1, 0, 250 0 2 1, 3 0, 0";
+    CompareResult(ERROR_INFO, expected, result, failedCount);
+    
+    // A queued texture upload is split into whole rows, with rows that aren't a multiple of 4 bytes long
+    result = std::stringstream();
+    expected = std::stringstream();
+    GLuint texture = 0;
+    glGenTextures(1, &texture);
+    TextureUnitState::BindToActiveUnit(texture);
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGB, 3, 4, 0, GL_RGB, GL_UNSIGNED_BYTE, nullptr);
+    TextureUnitState::BindToActiveUnit(0);
+    std::vector<unsigned char> pixels = createTestData(36);
+    UploadScheduler::QueueTextureUpload(texture, 3, 4, PIXEL_FORMAT_RGB8, SharedBuffer<unsigned char>(pixels));
+    UploadScheduler::SetFrameByteBudget(20);
+    for(unsigned int frame = 0; frame < 3; frame++) {
+        UploadScheduler::ProcessUploads();
+        result << UploadScheduler::GetFrameBytesUploaded() << " ";
+        UploadScheduler::EndFrame();
+    }
+    std::vector<unsigned char> texturePixels(36);
+    TextureUnitState::BindToActiveUnit(texture);
+    glPixelStorei(GL_PACK_ALIGNMENT, 1);
+    glGetTexImage(GL_TEXTURE_2D, 0, GL_RGB, GL_UNSIGNED_BYTE, texturePixels.data());
+    glPixelStorei(GL_PACK_ALIGNMENT, 4);
+    TextureUnitState::BindToActiveUnit(0);
+    result << ", " << (texturePixels == pixels) << ", " << UploadScheduler::GetNumPendingUploads() << ", " << HeadlessGL::GetNumErrors();
+    expected << "18 18 0 , 1, 0, 0";
+    CompareResult(ERROR_INFO, expected, result, failedCount);
+    
+    resetUploadScheduler();
+    return failedCount;
+}
+
+int TestRingFullDeferral() {
+    std::stringstream result;
+    std::stringstream expected;
+    int failedCount = 0;
+    HeadlessGL::Reset();
+    HeadlessGL::SetManualFenceSignalling(true);
+    resetUploadScheduler();
+    UploadScheduler::SetStagingEnabled(true);
+    UploadScheduler::SetRingCapacity(64);
+    
+    // Queued uploads wait for ring space on later frames instead of stalling on the GPU
+    result = std::stringstream();
+    expected = std::stringstream();
+    GLuint buffer = createBuffer(144);
+    std::vector<unsigned char> data = createTestData(144);
+    for(unsigned int i = 0; i < 3; i++) {
+        UploadScheduler::QueueBufferUpload(buffer, i * 48, SharedBuffer<unsigned char>(std::vector<unsigned char>(data.begin() + i * 48, data.begin() + (i + 1) * 48)));
+    }
+    UploadScheduler::ProcessUploads();
+    result << UploadScheduler::GetNumPendingUploads() << " ";
+    UploadScheduler::EndFrame();
+    UploadScheduler::ProcessUploads();
+    result << UploadScheduler::GetNumPendingUploads() << " ";
+    UploadScheduler::EndFrame();
+    HeadlessGL::SignalFences();
+    UploadScheduler::ProcessUploads();
+    result << UploadScheduler::GetNumPendingUploads() << " ";
+    UploadScheduler::EndFrame();
+    HeadlessGL::SignalFences();
+    UploadScheduler::ProcessUploads();
+    UploadScheduler::EndFrame();
+    result << UploadScheduler::GetNumPendingUploads() << ", " << (readBuffer(buffer) == data) << ", " << UploadScheduler::GetStats().numRingFullDeferrals << ", "
+            << HeadlessGL::GetNumBlockingWaits() << " " << UploadScheduler::GetRing().getStats().numStalls;
+    expected << "2 2 1 0, 1, 3, 0 0";
+    CompareResult(ERROR_INFO, expected, result, failedCount);
+    
+    // Immediate uploads that don't fit the ring go straight to the buffer, and are staged again once it has space
+    result = std::stringstream();
+    expected = std::stringstream();
+    std::vector<unsigned char> moreData(48, 9);
+    UploadScheduler::UploadToBuffer(buffer, 0, 48, moreData.data());
+    HeadlessGL::SignalFences();
+    UploadScheduler::UploadToBuffer(buffer, 48, 48, moreData.data());
+    result << UploadScheduler::GetStats().bytesStaged << " " << UploadScheduler::GetStats().bytesUploadedDirectly << ", " << (int)readBuffer(buffer)[95];
+    expected << "192 48, 9";
+    CompareResult(ERROR_INFO, expected, result, failedCount);
+    
+    resetUploadScheduler();
+    return failedCount;
+}
+
+int TestUploadsLargerThanRing() {
+    std::stringstream result;
+    std::stringstream expected;
+    int failedCount = 0;
+    HeadlessGL::Reset();
+    resetUploadScheduler();
+    UploadScheduler::SetStagingEnabled(true);
+    UploadScheduler::SetRingCapacity(64);
+    
+    // A queued buffer upload larger than the ring, with a budget larger than the ring, is staged in chunks that fit it
+    result = std::stringstream();
+    expected = std::stringstream();
+    GLuint buffer = createBuffer(200);
+    std::vector<unsigned char> data = createTestData(200);
+    UploadScheduler::QueueBufferUpload(buffer, 0, SharedBuffer<unsigned char>(data));
+    for(unsigned int frame = 0; frame < 4; frame++) {
+        UploadScheduler::ProcessUploads();
+        result << UploadScheduler::GetFrameBytesUploaded() << " ";
+        UploadScheduler::EndFrame();
+    }
+    result << ", " << UploadScheduler::GetNumPendingUploads() << " " << (readBuffer(buffer) == data) << ", " << UploadScheduler::GetStats().bytesStaged << " "
+            << UploadScheduler::GetStats().bytesUploadedDirectly << ", " << HeadlessGL::GetNumErrors();
+    expected << "64 64 64 8 , 0 1, 200 0, 0";
+    CompareResult(ERROR_INFO, expected, result, failedCount);
+    
+    // Texture rows larger than the ring go straight to the texture
+    result = std::stringstream();
+    expected = std::stringstream();
+    UploadScheduler::ResetStats();
+    GLuint texture = 0;
+    glGenTextures(1, &texture);
+    TextureUnitState::BindToActiveUnit(texture);
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, 32, 2, 0, GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
+    TextureUnitState::BindToActiveUnit(0);
+    std::vector<unsigned char> pixels = createTestData(256);
+    UploadScheduler::QueueTextureUpload(texture, 32, 2, PIXEL_FORMAT_RGBA8, SharedBuffer<unsigned char>(pixels));
+    UploadScheduler::ProcessUploads();
+    UploadScheduler::EndFrame();
+    std::vector<unsigned char> texturePixels(256);
+    TextureUnitState::BindToActiveUnit(texture);
+    glGetTexImage(GL_TEXTURE_2D, 0, GL_RGBA, GL_UNSIGNED_BYTE, texturePixels.data());
+    TextureUnitState::BindToActiveUnit(0);
+    result << UploadScheduler::GetNumPendingUploads() << " " << (texturePixels == pixels) << ", " << UploadScheduler::GetStats().bytesStaged << " "
+            << UploadScheduler::GetStats().bytesUploadedDirectly << " " << UploadScheduler::GetStats().numRingFullDeferrals << ", " << HeadlessGL::GetNumErrors();
+    expected << "0 1, 0 256 0, 0";
+    CompareResult(ERROR_INFO, expected, result, failedCount);
+    
+    resetUploadScheduler();
+    return failedCount;
+}
+
+int TestStagedLoaderUploads() {
+    std::stringstream result;
+    std::stringstream expected;
+    int failedCount = 0;
+    GeometryHeap::Destroy();
+    HeadlessGL::Reset();
+    resetUploadScheduler();
+    UploadScheduler::SetStagingEnabled(true);
+    
+    // Mesh geometry and indices are staged through the ring into the geometry heaps
+    result = std::stringstream();
+    expected = std::stringstream();
+    std::vector<Vec3f> vertices = {createVec3<float>(1.0f, 2.0f, 3.0f), createVec3<float>(4.0f, 5.0f, 6.0f), createVec3<float>(7.0f, 8.0f, 9.0f)};
+    std::vector<Vec3f> normals(3, createVec3<float>(0.0f, 1.0f, 0.0f));
+    std::vector<Vec2f> textureCoords(3, createVec2<float>(0.5f, 0.5f));
+    MeshGeometryDataPtr meshGeometryDataPtr = std::make_shared<MeshGeometryData>(SharedBuffer<Vec3f>(std::move(vertices)),
+            SharedBuffer<Vec3f>(std::move(normals)), SharedBuffer<Vec2f>(std::move(textureCoords)));
+    unsigned int meshID = MeshLoader::LoadMeshFromMeshData(std::make_shared<MeshData>(SharedBuffer<unsigned int>(std::vector<unsigned int>({2, 1, 0})), meshGeometryDataPtr));
+    MeshLoader::SetResidencyPolicy(meshID, RESIDENCY_REFETCH_HOST_COPY);
+    MeshLoader::UseLoadedMesh(meshID);
+    result << MeshLoader::IsHostResident(meshID) << ", " << MeshLoader::GetMeshDataPtr(meshID)->getIndices()[0] << ", "
+            << (UploadScheduler::GetStats().bytesStaged > 0) << " " << UploadScheduler::GetStats().bytesUploadedDirectly << ", ";
+    
+    // Textures are staged through a pixel unpack buffer, including rows that aren't a multiple of 4 bytes long
+    std::vector<unsigned char> pixels = createTestData(9);
+    unsigned int textureID = TextureLoader::LoadTextureFromTextureData(std::make_shared<TextureData>(3, 1, 3, SharedBuffer<unsigned char>(pixels)));
+    TextureLoader::SetResidencyPolicy(textureID, RESIDENCY_REFETCH_HOST_COPY);
+    TextureLoader::UseLoadedTexture(textureID);
+    const SharedBuffer<unsigned char>& textureData = TextureLoader::GetTextureDataPtr(textureID)->getData();
+    result << std::equal(pixels.begin(), pixels.end(), textureData.begin()) << ", " << UploadScheduler::GetStats().bytesUploadedDirectly << ", "
+            << HeadlessGL::GetNumErrors();
+    expected << "0, 2, 1 0, 1, 0, 0";
+    CompareResult(ERROR_INFO, expected, result, failedCount);
+    
+    MeshLoader::ReleaseLoadedMesh(meshID);
+    TextureLoader::ReleaseLoadedTexture(textureID);
+    ResourceReclaimer::ReclaimAll();
+    resetUploadScheduler();
+    return failedCount;
+}
+
+};
@@ -0,0 +1,28 @@
+#ifndef STREAMING_UPLOAD_TESTS_H
+#define STREAMING_UPLOAD_TESTS_H
+
+#include <iostream>
+#include <string>
+#include <graphics/buffer/streaming_ring.h>
+#include <graphics/buffer/upload_scheduler.h>
+#include <graphics/buffer/geometry_heap.h>
+#include <graphics/buffer/resource_reclaimer.h>
+#include <graphics/mesh/mesh_data.h>
+#include <graphics/texture/texture_data.h>
+#include <headless_gl.h>
+#include <test_exception.h>
+#include <test_comparison.h>
+
+namespace Tests::StreamingUploadTests {
+
+int DoTests();
+int TestStreamingRing();
+int TestStreamingRingWrap();
+int TestUploadBudget();
+int TestRingFullDeferral();
+int TestUploadsLargerThanRing();
+int TestStagedLoaderUploads();
+
+};
+
+#endif //STREAMING_UPLOAD_TESTS_H
@@ -0,0 +1,356 @@
+#include "texture_atlas_tests.h"
+
+using namespace Engine;
+using namespace Engine::Math;
+
+namespace Tests::TextureAtlasTests {
+
+int DoTests() {
+    int failedCount = 0;
+    
+    failedCount += TestRectanglePacker();
+    failedCount += TestAtlasPages();
+    failedCount += TestAtlasMipLevels();
+    failedCount += TestMaterialAtlasBaker();
+    failedCount += TestMaterialAtlasSharedGeometry();
+    
+    return failedCount;
+}
+
+// Creates a width by height texture with every pixel set to color
+static TextureDataPtr createSolidTexture(const unsigned int width, const unsigned int height, const std::vector<unsigned char>& color) {
+    std::vector<unsigned char> pixels;
+    for(unsigned int i = 0; i < width * height; i++) {
+        pixels.insert(pixels.end(), color.begin(), color.end());
+    }
+    return std::make_shared<TextureData>(width, height, color.size(), SharedBuffer<unsigned char>(std::move(pixels)));
+}
+
+// Returns the pixel at (x, y) of a level of textureData
+static std::vector<unsigned int> getPixel(const TextureData& textureData, const unsigned int level, const unsigned int x, const unsigned int y) {
+    unsigned int bytesPerPixel = PixelConverter::GetBytesPerPixel(textureData.getPixelFormat());
+    unsigned int levelWidth = MipmapGenerator::GetLevelSize(textureData.getWidth(), level);
+    const unsigned char* pixels = (level == 0) ? textureData.getData().data() : textureData.getMipLevels()[level - 1].data();
+    const unsigned char* pixel = pixels + ((size_t)y * levelWidth + x) * bytesPerPixel;
+    return std::vector<unsigned int>(pixel, pixel + bytesPerPixel);
+}
+
+static bool overlaps(const AtlasRect& a, const AtlasRect& b) {
+    return a.x < b.x + b.width && b.x < a.x + a.width && a.y < b.y + b.height && b.y < a.y + a.height;
+}
+
+int TestRectanglePacker() {
+    std::stringstream result;
+    std::stringstream expected;
+    int failedCount = 0;
+    
+    // Rectangles filling the area exactly are all placed, the last one in the space left
+    result = std::stringstream();
+    expected = std::stringstream();
+    {
+        RectanglePacker packer(8, 8);
+        AtlasRect a, b, c, d;
+        result << packer.insert(8, 4, a) << packer.insert(4, 4, b) << packer.insert(4, 2, c) << packer.insert(4, 2, d) << ", "
+                << overlaps(a, b) << overlaps(a, c) << overlaps(a, d) << overlaps(b, c) << overlaps(b, d) << overlaps(c, d) << ", "
+                << packer.getUsedWidth() << " " << packer.getUsedHeight() << " " << packer.getOccupancy() << ", ";
+        AtlasRect e;
+        result << packer.insert(1, 1, e);
+    }
+    expected << "1111, 000000, 8 8 1, 0";
+    CompareResult(ERROR_INFO, expected, result, failedCount);
+    
+    // Many rectangles of mixed sizes, in no particular order, stay inside the area without overlapping
+    result = std::stringstream();
+    expected = std::stringstream();
+    {
+        RectanglePacker packer(64, 64);
+        std::vector<AtlasRect> rects;
+        unsigned int numRejected = 0;
+        for(unsigned int i = 0; i < 60; i++) {
+            AtlasRect rect;
+            if(packer.insert(2 + (i * 7) % 11, 2 + (i * 5) % 9, rect)) {
+                rects.push_back(rect);
+            }
+            else {
+                numRejected++;
+            }
+        }
+        bool valid = true;
+        for(unsigned int i = 0; i < rects.size(); i++) {
+            valid = valid && rects[i].x + rects[i].width <= 64 && rects[i].y + rects[i].height <= 64;
+            for(unsigned int j = i + 1; j < rects.size(); j++) {
+                valid = valid && !overlaps(rects[i], rects[j]);
+            }
+        }
+        result << valid << " " << rects.size() << " " << numRejected << " " << (packer.getOccupancy() > 0.6f);
+    }
+    expected << "1 60 0 1";
+    CompareResult(ERROR_INFO, expected, result, failedCount);
+    
+    // Rectangles larger than the area are rejected
+    result = std::stringstream();
+    expected = std::stringstream();
+    {
+        RectanglePacker packer(16, 8);
+        AtlasRect rect;
+        result << packer.insert(17, 1, rect) << packer.insert(1, 9, rect) << packer.insert(16, 8, rect) << " " << rect.x << " " << rect.y;
+    }
+    expected << "001 0 0";
+    CompareResult(ERROR_INFO, expected, result, failedCount);
+    
+    return failedCount;
+}
+
+int TestAtlasPages() {
+    std::stringstream result;
+    std::stringstream expected;
+    int failedCount = 0;
+    
+    // Entries are copied into the page with a gutter repeating their edge pixels, and their regions map [0, 1] to them
+    result = std::stringstream();
+    expected = std::stringstream();
+    {
+        std::vector<unsigned char> pixels;
+        for(unsigned int i = 0; i < 4 * 2; i++) {
+            pixels.push_back((unsigned char)(i * 10));
+        }
+        TextureDataPtr gradientPtr = std::make_shared<TextureData>(4, 2, 1, SharedBuffer<unsigned char>(pixels));
+        TextureDataPtr solidPtr = createSolidTexture(8, 8, {200});
+        TextureAtlasBuilder builder(1, 64, 3, 2);
+        result << builder.addEntry({gradientPtr}) << builder.addEntry({solidPtr}) << " ";
+        TextureAtlas atlas = builder.build(MIPMAP_FILTER_BOX, false);
+        const AtlasRegion& region = atlas.regions[0];
+        const TextureData& page = *atlas.pages[0][0];
+        result << atlas.getNumPages() << " " << builder.getNumEntries() << " " << page.getPixelFormat() << " "
+                << (page.getWidth() % 4) << (page.getHeight() % 4) << ", "
+                << region.rect.width << " " << region.rect.height << " " << (region.rect.x % 4) << " " << (region.rect.y % 4) << ", "
+                << getPixel(page, 0, region.rect.x, region.rect.y)[0] << " " << getPixel(page, 0, region.rect.x + 3, region.rect.y + 1)[0] << " "
+                << getPixel(page, 0, region.rect.x - 2, region.rect.y - 2)[0] << " " << getPixel(page, 0, region.rect.x + 5, region.rect.y)[0] << " "
+                << getPixel(page, 0, region.rect.x + 1, region.rect.y + 3)[0] << ", "
+                << (region.uvOffset[0] * page.getWidth()) << " " << ((region.uvOffset[0] + region.uvScale[0]) * page.getWidth() - region.rect.x) << " "
+                << ((region.uvOffset[1] + region.uvScale[1]) * page.getHeight() - region.rect.y) << ", "
+                << (region.rect.x == atlas.regions[1].rect.x && region.rect.y == atlas.regions[1].rect.y);
+        expected << "01 1 0 " << PIXEL_FORMAT_R8 << " 00, 4 2 2 2, 0 70 0 30 50, " << region.rect.x << " 4 2, 0";
+    }
+    CompareResult(ERROR_INFO, expected, result, failedCount);
+    
+    // Textures of an entry land at the same spot of each slot's pages, and slots mixing formats are converted to RGBA8
+    result = std::stringstream();
+    expected = std::stringstream();
+    {
+        TextureAtlasBuilder builder(2, 16, 1, 2);
+        TextureDataPtr redPtr = createSolidTexture(8, 8, {255, 0, 0, 255});
+        TextureDataPtr greyPtr = createSolidTexture(8, 8, {100});
+        TextureDataPtr bluePtr = createSolidTexture(8, 8, {0, 0, 255, 255});
+        TextureDataPtr greenPtr = createSolidTexture(8, 8, {0, 255, 0});
+        result << builder.canAdd({redPtr}) << builder.canAdd({redPtr, createSolidTexture(4, 8, {100})}) << builder.canAdd({redPtr, greyPtr})
+                << builder.canAdd({createSolidTexture(13, 8, {1}), createSolidTexture(13, 8, {1})}) << " ";
+        builder.addEntry({redPtr, greyPtr});
+        builder.addEntry({bluePtr, greenPtr});
+        TextureAtlas atlas = builder.build(MIPMAP_FILTER_BOX, false);
+        result << atlas.getNumPages() << " " << atlas.regions[0].page << atlas.regions[1].page << " "
+                << atlas.pages[0][0]->getPixelFormat() << " " << atlas.pages[1][0]->getPixelFormat() << " "
+                << atlas.pages[0][0]->getWidth() << " " << atlas.pages[1][1]->getWidth() << " " << atlas.pages[0][0]->getMipLevels().size() << ", ";
+        const AtlasRect& rect = atlas.regions[1].rect;
+        std::vector<unsigned int> blue = getPixel(*atlas.pages[0][1], 0, rect.x + 7, rect.y + 7);
+        std::vector<unsigned int> green = getPixel(*atlas.pages[1][1], 0, rect.x - 1, rect.y + 8);
+        std::vector<unsigned int> grey = getPixel(*atlas.pages[1][0], 0, atlas.regions[0].rect.x, atlas.regions[0].rect.y);
+        for(unsigned int c = 0; c < 4; c++) {
+            result << blue[c] << " ";
+        }
+        for(unsigned int c = 0; c < 4; c++) {
+            result << green[c] << " ";
+        }
+        for(unsigned int c = 0; c < 4; c++) {
+            result << grey[c] << " ";
+        }
+    }
+    expected << "0010 2 01 " << PIXEL_FORMAT_RGBA8 << " " << PIXEL_FORMAT_RGBA8 << " 12 12 0, 0 0 255 255 0 255 0 255 100 0 0 255";
+    CompareResult(ERROR_INFO, expected, result, failedCount);
+    
+    return failedCount;
+}
+
+int TestAtlasMipLevels() {
+    std::stringstream result;
+    std::stringstream expected;
+    int failedCount = 0;
+    
+    // Pages only get the levels whose pixels each come from a single entry, and none of them mix entries
+    result = std::stringstream();
+    expected = std::stringstream();
+    {
+        std::vector<std::vector<unsigned char>> colors = {{255, 0, 0, 255}, {0, 255, 0, 255}, {0, 0, 255, 255}, {255, 255, 255, 0}};
+        std::vector<unsigned int> sizes = {16, 5, 9, 3};
+        TextureAtlasBuilder builder(1, 256, 4, 1);
+        for(unsigned int i = 0; i < colors.size(); i++) {
+            builder.addEntry({createSolidTexture(sizes[i], sizes[i], colors[i])});
+        }
+        TextureAtlas atlas = builder.build(MIPMAP_FILTER_BOX, true);
+        const TextureData& page = *atlas.pages[0][0];
+        result << atlas.getNumPages() << " " << page.getMipLevels().size() << " " << (page.getWidth() % 8) << (page.getHeight() % 8) << ", ";
+        bool clean = true;
+        for(unsigned int i = 0; i < colors.size(); i++) {
+            const AtlasRect& rect = atlas.regions[i].rect;
+            for(unsigned int level = 0; level < 4; level++) {
+                // Every pixel of the level touching the entry
+                unsigned int scale = 1 << level;
+                for(unsigned int y = rect.y / scale; y <= (rect.y + rect.height - 1) / scale; y++) {
+                    for(unsigned int x = rect.x / scale; x <= (rect.x + rect.width - 1) / scale; x++) {
+                        std::vector<unsigned int> pixel = getPixel(page, level, x, y);
+                        clean = clean && (pixel == std::vector<unsigned int>(colors[i].begin(), colors[i].end()));
+                    }
+                }
+            }
+        }
+        result << clean;
+    }
+    expected << "1 3 00, 1";
+    CompareResult(ERROR_INFO, expected, result, failedCount);
+    
+    return failedCount;
+}
+
+// Creates a quad in the z = 0 plane with texture coordinates from 0 to maxTextureCoord
+static MeshDataPtr createQuadMeshData(const float maxTextureCoord) {
+    std::vector<Vec3f> vertices = {createVec3<float>(0.0f, 0.0f, 0.0f), createVec3<float>(1.0f, 0.0f, 0.0f), createVec3<float>(1.0f, 1.0f, 0.0f),
+            createVec3<float>(0.0f, 1.0f, 0.0f)};
+    std::vector<Vec3f> normals(4, createVec3<float>(0.0f, 0.0f, 1.0f));
+    std::vector<Vec2f> textureCoords = {createVec2<float>(0.0f, 0.0f), createVec2<float>(maxTextureCoord, 0.0f),
+            createVec2<float>(maxTextureCoord, maxTextureCoord), createVec2<float>(0.0f, maxTextureCoord)};
+    MeshGeometryDataPtr meshGeometryDataPtr = std::make_shared<MeshGeometryData>(SharedBuffer<Vec3f>(std::move(vertices)),
+            SharedBuffer<Vec3f>(std::move(normals)), SharedBuffer<Vec2f>(std::move(textureCoords)));
+    return std::make_shared<MeshData>(SharedBuffer<unsigned int>(std::vector<unsigned int>({0, 1, 2, 0, 2, 3})), meshGeometryDataPtr);
+}
+
+int TestMaterialAtlasBaker() {
+    std::stringstream result;
+    std::stringstream expected;
+    int failedCount = 0;
+    GeometryHeap::Destroy();
+    HeadlessGL::Reset();
+    
+    // Meshes whose materials only differ in their textures end up sharing one material, and batch into one draw
+    result = std::stringstream();
+    expected = std::stringstream();
+    {
+        Texture red(createSolidTexture(8, 8, {255, 0, 0, 255}), TEXTURE_DIFFUSE);
+        Texture blue(createSolidTexture(16, 8, {0, 0, 255, 255}), TEXTURE_DIFFUSE);
+        Texture green(createSolidTexture(8, 8, {0, 255, 0, 255}), TEXTURE_DIFFUSE);
+        Mesh redMesh(createQuadMeshData(1.0f), TexturedMaterial(ShaderProgramPtr(), {red}, {1.0f}), UnTexturedMaterial());
+        Mesh blueMesh(createQuadMeshData(1.0f), TexturedMaterial(ShaderProgramPtr(), {blue}, {1.0f}), UnTexturedMaterial());
+        Mesh tiledMesh(createQuadMeshData(2.0f), TexturedMaterial(ShaderProgramPtr(), {green}, {1.0f}), UnTexturedMaterial());
+        Mesh specularMesh(createQuadMeshData(1.0f), TexturedMaterial(ShaderProgramPtr(), {Texture(green.getTextureDataPtr(), TEXTURE_SPECULAR)}, {1.0f}),
+                UnTexturedMaterial());
+        Mesh plainMesh(createQuadMeshData(1.0f), TexturedMaterial(), UnTexturedMaterial());
+        
+        MaterialAtlasBaker baker(64, 2, 1);
+        baker.addMesh(redMesh);
+        baker.addMesh(blueMesh);
+        baker.addMesh(tiledMesh);
+        baker.addMesh(specularMesh);
+        baker.addMesh(redMesh);
+        result << baker.addMesh(plainMesh) << " ";
+        std::vector<Mesh> meshes = baker.build();
+        const MaterialAtlasStats& stats = baker.getStats();
+        result << meshes.size() << " " << baker.getNumSources() << ", " << stats.numSourceMaterials << " " << stats.numAtlasMaterials << " "
+                << stats.numAtlasedMeshes << " " << stats.numUnchangedMeshes << ", "
+                << meshes[0].hasTexturedMaterialState(meshes[1].getTexturedMaterial()) << meshes[0].hasTexturedMaterialState(meshes[4].getTexturedMaterial())
+                << meshes[2].hasTexturedMaterialState(tiledMesh.getTexturedMaterial()) << (meshes[3].getMeshID() == specularMesh.getMeshID())
+                << (meshes[5].getMeshID() == plainMesh.getMeshID()) << ", ";
+        
+        // Texture coordinates map onto each source texture's pixels in the page
+        Texture page = meshes[0].getTexturedMaterial().getTextures()[0];
+        TextureDataPtr pageDataPtr = page.getTextureDataPtr();
+        for(unsigned int m = 0; m < 2; m++) {
+            const SharedBuffer<Vec2f>& textureCoords = meshes[m].getMeshDataPtr()->getMeshGeometryDataPtr()->getTextureCoords();
+            unsigned int x = (unsigned int)std::round(textureCoords[0][0] * pageDataPtr->getWidth());
+            unsigned int y = (unsigned int)std::round(textureCoords[0][1] * pageDataPtr->getHeight());
+            unsigned int endX = (unsigned int)std::round(textureCoords[2][0] * pageDataPtr->getWidth());
+            unsigned int endY = (unsigned int)std::round(textureCoords[2][1] * pageDataPtr->getHeight());
+            std::vector<unsigned int> first = getPixel(*pageDataPtr, 0, x, y);
+            std::vector<unsigned int> last = getPixel(*pageDataPtr, 0, endX - 1, endY - 1);
+            result << (endX - x) << " " << (endY - y) << " " << first[0] << " " << first[2] << " " << last[0] << " " << last[2] << ", ";
+        }
+        result << page.getType() << " " << pageDataPtr->getMipLevels().size() << " " << meshes[0].getMeshDataPtr()->getIndices().getSize() << ", ";
+        
+        StaticBatcher staticBatcher;
+        for(unsigned int i = 0; i < meshes.size(); i++) {
+            staticBatcher.addMesh(meshes[i], Mat4f(1.0f));
+        }
+        result << staticBatcher.build().size() << " " << HeadlessGL::GetNumErrors();
+    }
+    expected << "5 6 0, 2 1 3 3, 11111, 8 8 255 0 255 0, 16 8 0 255 0 255, " << TEXTURE_DIFFUSE << " 1 6, 4 0";
+    CompareResult(ERROR_INFO, expected, result, failedCount);
+    
+    ResourceReclaimer::ReclaimAll();
+    return failedCount;
+}
+
+int TestMaterialAtlasSharedGeometry() {
+    std::stringstream result;
+    std::stringstream expected;
+    int failedCount = 0;
+    GeometryHeap::Destroy();
+    HeadlessGL::Reset();
+    
+    // Meshes sharing one geometry, like the meshes of a model, each keep only the vertices they use, and tiled texture
+    // coordinates of one mesh don't keep the others out of the atlas
+    result = std::stringstream();
+    expected = std::stringstream();
+    {
+        std::vector<Vec3f> vertices;
+        std::vector<Vec2f> textureCoords;
+        for(unsigned int q = 0; q < 3; q++) {
+            float maxTextureCoord = (q == 2) ? 2.0f : 1.0f;
+            vertices.push_back(createVec3<float>(q, 0.0f, 0.0f));
+            vertices.push_back(createVec3<float>(q + 1.0f, 0.0f, 0.0f));
+            vertices.push_back(createVec3<float>(q + 1.0f, 1.0f, 0.0f));
+            vertices.push_back(createVec3<float>(q, 1.0f, 0.0f));
+            textureCoords.push_back(createVec2<float>(0.0f, 0.0f));
+            textureCoords.push_back(createVec2<float>(maxTextureCoord, 0.0f));
+            textureCoords.push_back(createVec2<float>(maxTextureCoord, maxTextureCoord));
+            textureCoords.push_back(createVec2<float>(0.0f, maxTextureCoord));
+        }
+        std::vector<Vec3f> normals(vertices.size(), createVec3<float>(0.0f, 0.0f, 1.0f));
+        MeshGeometryDataPtr meshGeometryDataPtr = std::make_shared<MeshGeometryData>(SharedBuffer<Vec3f>(std::move(vertices)),
+                SharedBuffer<Vec3f>(std::move(normals)), SharedBuffer<Vec2f>(std::move(textureCoords)));
+        std::vector<MeshDataPtr> meshDataPtrs;
+        for(unsigned int q = 0; q < 3; q++) {
+            unsigned int first = 4 * q;
+            meshDataPtrs.push_back(std::make_shared<MeshData>(SharedBuffer<unsigned int>(std::vector<unsigned int>({first, first + 1, first + 2, first,
+                    first + 2, first + 3})), meshGeometryDataPtr));
+        }
+        
+        Texture red(createSolidTexture(8, 8, {255, 0, 0, 255}), TEXTURE_DIFFUSE);
+        Texture blue(createSolidTexture(8, 8, {0, 0, 255, 255}), TEXTURE_DIFFUSE);
+        Texture green(createSolidTexture(8, 8, {0, 255, 0, 255}), TEXTURE_DIFFUSE);
+        Mesh redMesh(meshDataPtrs[0], TexturedMaterial(ShaderProgramPtr(), {red}, {1.0f}), UnTexturedMaterial());
+        Mesh blueMesh(meshDataPtrs[1], TexturedMaterial(ShaderProgramPtr(), {blue}, {1.0f}), UnTexturedMaterial());
+        Mesh tiledMesh(meshDataPtrs[2], TexturedMaterial(ShaderProgramPtr(), {green}, {1.0f}), UnTexturedMaterial());
+        result << MaterialAtlasBaker::HasUnitTextureCoords(*meshDataPtrs[0]) << MaterialAtlasBaker::HasUnitTextureCoords(*meshDataPtrs[2]) << ", ";
+        
+        MaterialAtlasBaker baker(64, 1, 1);
+        baker.addMesh(redMesh);
+        baker.addMesh(blueMesh);
+        baker.addMesh(tiledMesh);
+        std::vector<Mesh> meshes = baker.build();
+        const MaterialAtlasStats& stats = baker.getStats();
+        result << stats.numAtlasedMeshes << " " << stats.numUnchangedMeshes << ", ";
+        for(unsigned int m = 0; m < 2; m++) {
+            MeshDataPtr meshDataPtr = meshes[m].getMeshDataPtr();
+            const SharedBuffer<unsigned int>& indices = meshDataPtr->getIndices();
+            const SharedBuffer<Vec3f>& meshVertices = meshDataPtr->getMeshGeometryDataPtr()->getVertices();
+            result << meshDataPtr->getMeshGeometryDataPtr()->getNumVertices() << " " << indices.getSize() << " " << indices[5] << " "
+                    << meshVertices[indices[2]][0] << ", ";
+        }
+        result << (meshes[2].getMeshID() == tiledMesh.getMeshID()) << " " << HeadlessGL::GetNumErrors();
+    }
+    expected << "10, 2 1, 4 6 3 1, 4 6 3 2, 1 0";
+    CompareResult(ERROR_INFO, expected, result, failedCount);
+    
+    ResourceReclaimer::ReclaimAll();
+    return failedCount;
+}
+
+}
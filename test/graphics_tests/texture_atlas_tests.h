@@ -0,0 +1,26 @@
+#ifndef TEXTURE_ATLAS_TESTS_H
+#define TEXTURE_ATLAS_TESTS_H
+
+#include <iostream>
+#include <string>
+#include <graphics/texture/texture_atlas.h>
+#include <graphics/model/material_atlas_baker.h>
+#include <graphics/model/static_batcher.h>
+#include <graphics/buffer/geometry_heap.h>
+#include <graphics/buffer/resource_reclaimer.h>
+#include <headless_gl.h>
+#include <test_exception.h>
+#include <test_comparison.h>
+
+namespace Tests::TextureAtlasTests {
+
+int DoTests();
+int TestRectanglePacker();
+int TestAtlasPages();
+int TestAtlasMipLevels();
+int TestMaterialAtlasBaker();
+int TestMaterialAtlasSharedGeometry();
+
+};
+
+#endif //TEXTURE_ATLAS_TESTS_H
@@ -0,0 +1,269 @@
+#include "texture_cache_tests.h"
+#include <filesystem>
+#include <fstream>
+
+using namespace Engine;
+
+namespace Tests::TextureCacheTests {
+
+int DoTests() {
+    int failedCount = 0;
+    
+    failedCount += TestCacheHits();
+    failedCount += TestInvalidation();
+    failedCount += TestContainers();
+    
+    return failedCount;
+}
+
+/*
+ * Writes a width by height binary PPM image of a gradient starting at firstValue to the temporary directory.
+ */
+static std::string writeTestImage(const std::string& fileName, const unsigned int width, const unsigned int height, const unsigned char firstValue) {
+    std::string filePath = (std::filesystem::temp_directory_path() / fileName).string();
+    std::ofstream outFile(filePath, std::ios_base::out | std::ios_base::binary | std::ios_base::trunc);
+    outFile << "P6\n" << width << " " << height << "\n255\n";
+    for(unsigned int i = 0; i < width * height * 3; i++) {
+        outFile.put((char)(unsigned char)(firstValue + i * 5));
+    }
+    return filePath;
+}
+
+/*
+ * Points the cache at an empty directory in the temporary directory.
+ */
+static std::string useEmptyCacheDirectory() {
+    std::string cacheDirectory = (std::filesystem::temp_directory_path() / "texture_cache_test").string();
+    std::filesystem::remove_all(cacheDirectory);
+    TextureCache::SetCacheDirectory(cacheDirectory);
+    TextureCache::ResetStats();
+    return cacheDirectory;
+}
+
+static bool equalLevels(const TextureData& first, const TextureData& second) {
+    if(first.getMipLevels().size() != second.getMipLevels().size()
+            || !std::equal(first.getData().begin(), first.getData().end(), second.getData().begin(), second.getData().end())) {
+        return false;
+    }
+    for(unsigned int i = 0; i < first.getMipLevels().size(); i++) {
+        if(!std::equal(first.getMipLevels()[i].begin(), first.getMipLevels()[i].end(), second.getMipLevels()[i].begin(), second.getMipLevels()[i].end())) {
+            return false;
+        }
+    }
+    return true;
+}
+
+static std::string statsString() {
+    TextureCacheStats stats = TextureCache::GetStats();
+    std::stringstream statsStream;
+    statsStream << stats.numHits << " " << stats.numMisses << " " << stats.numInvalidations << " " << stats.numWrites << " " << stats.numWriteFailures;
+    return statsStream.str();
+}
+
+int TestCacheHits() {
+    std::stringstream result;
+    std::stringstream expected;
+    int failedCount = 0;
+    GeometryHeap::Destroy();
+    HeadlessGL::Reset();
+    std::string cacheDirectory = useEmptyCacheDirectory();
+    std::string filePath = writeTestImage("texture_cache_test_0.ppm", 8, 4, 10);
+    
+    // The first load decodes the image and writes its container
+    result = std::stringstream();
+    expected = std::stringstream();
+    unsigned int textureID = TextureLoader::LoadTextureFromFile(filePath);
+    TextureDataPtr decodedPtr = TextureLoader::CopyTextureDataFromLoaded(textureID);
+    result << statsString() << ", " << std::filesystem::exists(TextureCache::GetCacheFilePath(filePath)) << " "
+            << (std::filesystem::path(TextureCache::GetCacheFilePath(filePath)).parent_path() == std::filesystem::path(cacheDirectory)) << " "
+            << decodedPtr->getMipLevels().size();
+    expected << "0 1 0 1 0, 1 1 3";
+    CompareResult(ERROR_INFO, expected, result, failedCount);
+    
+    // Loading it again maps the container, whose levels match the decoded ones and keep the container's alignment
+    result = std::stringstream();
+    expected = std::stringstream();
+    TextureLoader::UnloadUnusedTextures();
+    textureID = TextureLoader::LoadTextureFromFile(filePath);
+    TextureDataPtr cachedPtr = TextureLoader::GetTextureDataPtr(textureID);
+    result << statsString() << ", " << cachedPtr->getWidth() << " " << cachedPtr->getHeight() << " " << cachedPtr->getNumChannels() << " "
+            << equalLevels(*decodedPtr, *cachedPtr) << " " << ((uintptr_t)cachedPtr->getData().data() % 16) << " "
+            << ((uintptr_t)cachedPtr->getMipLevels()[0].data() % 16);
+    expected << "1 1 0 1 0, 8 4 3 1 0 0";
+    CompareResult(ERROR_INFO, expected, result, failedCount);
+    
+    // Mutating the cached texture copies it rather than writing to the mapping
+    result = std::stringstream();
+    expected = std::stringstream();
+    TextureDataPtr mutatedPtr = TextureLoader::CopyTextureDataFromLoaded(textureID);
+    unsigned int firstValue = decodedPtr->getData()[0];
+    mutatedPtr->mutableData()[0] = 0;
+    TextureSourceInfo sourceInfo;
+    TextureDataPtr reloadedPtr = TextureCache::ReadContainer(TextureCache::GetCacheFilePath(filePath), sourceInfo);
+    result << (int)mutatedPtr->getData()[0] << " " << (int)cachedPtr->getData()[0] << " " << (int)reloadedPtr->getData()[0] << ", "
+            << sourceInfo.fileSize << " " << sourceInfo.settingsKey;
+    expected << "0 " << firstValue << " " << firstValue << ", " << std::filesystem::file_size(filePath) << " " << TextureLoader::GetMipmapSettings().getCacheKey();
+    CompareResult(ERROR_INFO, expected, result, failedCount);
+    
+    TextureLoader::UnloadUnusedTextures();
+    ResourceReclaimer::ReclaimAll();
+    std::filesystem::remove(filePath);
+    std::filesystem::remove_all(cacheDirectory);
+    TextureCache::SetCacheDirectory("");
+    return failedCount;
+}
+
+int TestInvalidation() {
+    std::stringstream result;
+    std::stringstream expected;
+    int failedCount = 0;
+    std::string cacheDirectory = useEmptyCacheDirectory();
+    std::string filePath = writeTestImage("texture_cache_test_1.ppm", 4, 4, 10);
+    unsigned int settingsKey = TextureLoader::GetMipmapSettings().getCacheKey();
+    TextureDataPtr textureDataPtr = std::make_shared<TextureData>(1, 1, 3, SharedBuffer<unsigned char>(std::vector<unsigned char>{1, 2, 3}));
+    
+    // Touching the source without changing it keeps the container
+    result = std::stringstream();
+    expected = std::stringstream();
+    TextureCache::Store(filePath, TextureCache::GetSourceInfo(filePath, settingsKey, true), textureDataPtr);
+    std::filesystem::last_write_time(filePath, std::filesystem::last_write_time(filePath) + std::chrono::seconds(10));
+    TextureDataPtr cachedPtr = TextureCache::Load(filePath, settingsKey);
+    result << (cachedPtr.get() != nullptr) << ", " << statsString();
+    expected << "1, 1 0 0 1 0";
+    CompareResult(ERROR_INFO, expected, result, failedCount);
+    
+    // Changing its contents deletes the container, even when its size stays the same
+    result = std::stringstream();
+    expected = std::stringstream();
+    std::filesystem::file_time_type modifiedTime = std::filesystem::last_write_time(filePath);
+    writeTestImage("texture_cache_test_1.ppm", 4, 4, 20);
+    std::filesystem::last_write_time(filePath, modifiedTime + std::chrono::seconds(10));
+    cachedPtr = TextureCache::Load(filePath, settingsKey);
+    result << (cachedPtr.get() != nullptr) << " " << std::filesystem::exists(TextureCache::GetCacheFilePath(filePath)) << ", " << statsString();
+    expected << "0 0, 1 1 1 1 0";
+    CompareResult(ERROR_INFO, expected, result, failedCount);
+    
+    // So does loading it with different mipmap settings
+    result = std::stringstream();
+    expected = std::stringstream();
+    TextureCache::Store(filePath, TextureCache::GetSourceInfo(filePath, settingsKey, true), textureDataPtr);
+    MipmapSettings kaiserSettings;
+    kaiserSettings.filter = MIPMAP_FILTER_KAISER;
+    cachedPtr = TextureCache::Load(filePath, kaiserSettings.getCacheKey());
+    result << (cachedPtr.get() != nullptr) << " " << (kaiserSettings.getCacheKey() != settingsKey) << ", " << statsString();
+    expected << "0 1, 1 2 2 2 0";
+    CompareResult(ERROR_INFO, expected, result, failedCount);
+    
+    // A container that can't be written leaves the texture uncached
+    result = std::stringstream();
+    expected = std::stringstream();
+    TextureCache::ResetStats();
+    std::filesystem::remove_all(cacheDirectory);
+    bool stored = TextureCache::Store(filePath, TextureCache::GetSourceInfo(filePath, settingsKey, true), textureDataPtr);
+    result << stored << ", " << statsString();
+    expected << "0, 0 0 0 0 1";
+    CompareResult(ERROR_INFO, expected, result, failedCount);
+    
+    std::filesystem::remove(filePath);
+    std::filesystem::remove_all(cacheDirectory);
+    TextureCache::SetCacheDirectory("");
+    return failedCount;
+}
+
+int TestContainers() {
+    std::stringstream result;
+    std::stringstream expected;
+    int failedCount = 0;
+    std::string cacheDirectory = useEmptyCacheDirectory();
+    std::string containerPath = (std::filesystem::path(cacheDirectory) / "container_test.etex").string();
+    TextureSourceInfo sourceInfo;
+    sourceInfo.contentHash = 0x0123456789abcdefULL;
+    sourceInfo.fileSize = 99;
+    sourceInfo.modifiedTime = -5;
+    sourceInfo.settingsKey = 7;
+    
+    // Rows of raw levels are padded to the row alignment in the file and repacked when read. The file holds the header,
+    // two level table entries, three 12 byte rows and, 16-byte aligned after them, the last level's padded row
+    result = std::stringstream();
+    expected = std::stringstream();
+    std::vector<unsigned char> pixels;
+    for(unsigned int i = 0; i < 3 * 3 * 3; i++) {
+        pixels.push_back((unsigned char)(i * 9));
+    }
+    TextureDataPtr rawPtr = std::make_shared<TextureData>(3, 3, 3, SharedBuffer<unsigned char>(pixels));
+    rawPtr->generateMipLevels(MIPMAP_FILTER_BOX, false);
+    TextureCache::WriteContainer(containerPath, *rawPtr, sourceInfo, 4);
+    TextureSourceInfo readInfo;
+    TextureDataPtr readPtr = TextureCache::ReadContainer(containerPath, readInfo);
+    result << readPtr->getWidth() << " " << readPtr->getHeight() << " " << readPtr->getNumChannels() << " " << readPtr->isCompressed() << " "
+            << equalLevels(*rawPtr, *readPtr) << ", " << (readInfo.contentHash == sourceInfo.contentHash) << " " << readInfo.fileSize << " "
+            << readInfo.modifiedTime << " " << readInfo.settingsKey << ", " << std::filesystem::file_size(containerPath);
+    expected << "3 3 3 0 1, 1 99 -5 7, " << 64 + 2 * 16 + 3 * 12 + 12 + 4;
+    CompareResult(ERROR_INFO, expected, result, failedCount);
+    
+    // Texture data referring to the mapping can be written once uniquely held, and writing it leaves the file as it was
+    result = std::stringstream();
+    expected = std::stringstream();
+    std::vector<unsigned char> alignedPixels(4 * 4 * 4, 200);
+    TextureData alignedData(4, 4, 4, SharedBuffer<unsigned char>(alignedPixels));
+    TextureCache::WriteContainer(containerPath, alignedData, sourceInfo, 4);
+    TextureDataPtr mappedPtr = TextureCache::ReadContainer(containerPath, readInfo);
+    mappedPtr->mutableData()[0] = 7;
+    result << (int)mappedPtr->getData()[0] << " " << (int)mappedPtr->getData()[1] << ", ";
+    mappedPtr.reset();
+    result << (int)TextureCache::ReadContainer(containerPath, readInfo)->getData()[0];
+    expected << "7 200, 200";
+    CompareResult(ERROR_INFO, expected, result, failedCount);
+    
+    // Compressed levels are kept as blocks
+    result = std::stringstream();
+    expected = std::stringstream();
+    TextureDataPtr compressedPtr = std::make_shared<TextureData>(*rawPtr);
+    compressedPtr->compress(COMPRESSED_FORMAT_BC7, COMPRESSION_QUALITY_FAST);
+    TextureCache::WriteContainer(containerPath, *compressedPtr, sourceInfo);
+    readPtr = TextureCache::ReadContainer(containerPath, readInfo);
+    result << readPtr->getCompressedFormat() << " " << readPtr->getNumChannels() << " " << readPtr->getSize() << " "
+            << readPtr->getMipLevels().size() << " " << equalLevels(*compressedPtr, *readPtr);
+    expected << COMPRESSED_FORMAT_BC7 << " 4 16 1 1";
+    CompareResult(ERROR_INFO, expected, result, failedCount);
+    
+    // Truncated and foreign files are rejected
+    result = std::stringstream();
+    expected = std::stringstream();
+    readPtr.reset();
+    std::filesystem::resize_file(containerPath, std::filesystem::file_size(containerPath) - 1);
+    try {
+        TextureCache::ReadContainer(containerPath, readInfo);
+        result << "returned";
+    }
+    catch(FileIOException& e) {
+        result << "threw";
+    }
+    std::ofstream(containerPath, std::ios_base::out | std::ios_base::binary | std::ios_base::trunc) << "not a texture container, but long enough to hold a header of 64 bytes";
+    try {
+        TextureCache::ReadContainer(containerPath, readInfo);
+        result << " returned";
+    }
+    catch(FileIOException& e) {
+        result << " threw";
+    }
+    expected << "threw threw";
+    CompareResult(ERROR_INFO, expected, result, failedCount);
+    
+    // A corrupt container in the cache is deleted and counted as a miss
+    result = std::stringstream();
+    expected = std::stringstream();
+    std::string filePath = writeTestImage("texture_cache_test_2.ppm", 2, 2, 30);
+    std::filesystem::copy_file(containerPath, TextureCache::GetCacheFilePath(filePath));
+    TextureDataPtr cachedPtr = TextureCache::Load(filePath, 0);
+    result << (cachedPtr.get() != nullptr) << " " << std::filesystem::exists(TextureCache::GetCacheFilePath(filePath)) << ", " << statsString();
+    expected << "0 0, 0 1 1 0 0";
+    CompareResult(ERROR_INFO, expected, result, failedCount);
+    
+    std::filesystem::remove(filePath);
+    std::filesystem::remove_all(cacheDirectory);
+    TextureCache::SetCacheDirectory("");
+    return failedCount;
+}
+
+};
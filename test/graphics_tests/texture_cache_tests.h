@@ -0,0 +1,23 @@
+#ifndef TEXTURE_CACHE_TESTS_H
+#define TEXTURE_CACHE_TESTS_H
+
+#include <iostream>
+#include <string>
+#include <graphics/texture/texture_cache.h>
+#include <graphics/texture/texture_data.h>
+#include <graphics/buffer/geometry_heap.h>
+#include <graphics/buffer/resource_reclaimer.h>
+#include <headless_gl.h>
+#include <test_exception.h>
+#include <test_comparison.h>
+
+namespace Tests::TextureCacheTests {
+
+int DoTests();
+int TestCacheHits();
+int TestInvalidation();
+int TestContainers();
+
+};
+
+#endif //TEXTURE_CACHE_TESTS_H
@@ -0,0 +1,264 @@
+#include "texture_streaming_tests.h"
+
+using namespace Engine;
+
+namespace Tests::TextureStreamingTests {
+
+int DoTests() {
+    int failedCount = 0;
+    
+    failedCount += TestRequiredLevels();
+    failedCount += TestPromotion();
+    failedCount += TestEviction();
+    failedCount += TestStreamedUploads();
+    
+    return failedCount;
+}
+
+/*
+ * Returns the bytes of each mipmap level of a size by size RGBA8 texture.
+ */
+static std::vector<size_t> getLevelBytes(const unsigned int size) {
+    std::vector<size_t> levelBytes;
+    for(unsigned int level = 0; level < MipmapGenerator::GetNumLevels(size, size); level++) {
+        unsigned int levelSize = MipmapGenerator::GetLevelSize(size, level);
+        levelBytes.push_back((size_t)levelSize * levelSize * 4);
+    }
+    return levelBytes;
+}
+
+// Bytes of levels 2 and up of a 256 by 256 RGBA8 texture, the tail kept resident
+static const size_t TAIL_BYTES = 16384 + 4096 + 1024 + 256 + 64 + 16 + 4;
+
+int TestRequiredLevels() {
+    std::stringstream result;
+    std::stringstream expected;
+    int failedCount = 0;
+    
+    // The required level is the one with about a texel per pixel, clamped to the chain
+    result = std::stringstream();
+    expected = std::stringstream();
+    result << TextureStreamingPolicy::ComputeRequiredLevel(256, 256, 300.0f, 300.0f) << " " << TextureStreamingPolicy::ComputeRequiredLevel(256, 256, 100.0f, 100.0f)
+            << " " << TextureStreamingPolicy::ComputeRequiredLevel(256, 256, 64.0f, 64.0f) << " " << TextureStreamingPolicy::ComputeRequiredLevel(256, 64, 64.0f, 64.0f)
+            << " " << TextureStreamingPolicy::ComputeRequiredLevel(256, 256, 0.1f, 0.1f) << " " << TextureStreamingPolicy::ComputeRequiredLevel(256, 256, 0.0f, 10.0f)
+            << ", " << TextureStreamingPolicy::ComputeTailLevel(256, 256, 64) << " " << TextureStreamingPolicy::ComputeTailLevel(300, 20, 64) << " "
+            << TextureStreamingPolicy::ComputeTailLevel(32, 32, 64) << " " << TextureStreamingPolicy::ComputeTailLevel(4, 4, 0);
+    expected << "0 1 2 2 8 8, 2 3 0 2";
+    CompareResult(ERROR_INFO, expected, result, failedCount);
+    
+    return failedCount;
+}
+
+int TestPromotion() {
+    std::stringstream result;
+    std::stringstream expected;
+    int failedCount = 0;
+    
+    // Textures start with their tail and are raised to the requested level when there is no budget
+    result = std::stringstream();
+    expected = std::stringstream();
+    TextureStreamingPolicy policy;
+    policy.addTexture(1, getLevelBytes(256), 2);
+    policy.addTexture(2, getLevelBytes(256), 2);
+    size_t initialBytes = policy.getTotalResidentBytes();
+    policy.requestLevel(1, 3, 1);
+    policy.requestLevel(1, 0, 1);
+    policy.requestLevel(2, 5, 1);
+    std::vector<StreamingChange> changes = policy.update(1);
+    result << initialBytes << " " << policy.getResidentLevel(1) << " " << policy.getResidentLevel(2) << " " << policy.getRequestedLevel(1) << " "
+            << policy.getRequestedLevel(2) << ", " << changes.size() << " " << changes[0].textureID << " " << changes[0].previousLevel << " "
+            << changes[0].residentLevel << ", " << policy.getTotalResidentBytes() << " " << policy.getStats().levelsPromoted;
+    expected << 2 * TAIL_BYTES << " 0 2 0 2, 1 1 2 0, " << TAIL_BYTES + 65536 + 262144 + TAIL_BYTES << " 2";
+    CompareResult(ERROR_INFO, expected, result, failedCount);
+    
+    // Limiting the bytes promoted per update spreads the levels over updates, coarsest first
+    result = std::stringstream();
+    expected = std::stringstream();
+    TextureStreamingPolicy limitedPolicy;
+    limitedPolicy.setMaxPromotedBytesPerUpdate(1);
+    limitedPolicy.addTexture(1, getLevelBytes(256), 2);
+    limitedPolicy.requestLevel(1, 0, 1);
+    limitedPolicy.update(1);
+    unsigned int firstLevel = limitedPolicy.getResidentLevel(1);
+    limitedPolicy.requestLevel(1, 0, 2);
+    limitedPolicy.update(2);
+    result << firstLevel << " " << limitedPolicy.getResidentLevel(1);
+    expected << "1 0";
+    CompareResult(ERROR_INFO, expected, result, failedCount);
+    
+    // Textures used on the same frame are raised in step, and don't evict each other's coarser levels
+    result = std::stringstream();
+    expected = std::stringstream();
+    TextureStreamingPolicy budgetPolicy;
+    budgetPolicy.setBudget(2 * TAIL_BYTES + 2 * 65536);
+    budgetPolicy.addTexture(1, getLevelBytes(256), 2);
+    budgetPolicy.addTexture(2, getLevelBytes(256), 2);
+    budgetPolicy.requestLevel(1, 0, 1);
+    budgetPolicy.requestLevel(2, 0, 1);
+    budgetPolicy.update(1);
+    result << budgetPolicy.getResidentLevel(1) << " " << budgetPolicy.getResidentLevel(2) << " " << budgetPolicy.getStats().levelsPromoted << " "
+            << budgetPolicy.getStats().levelsEvicted << " " << budgetPolicy.getStats().budgetMisses << " "
+            << (budgetPolicy.getTotalResidentBytes() <= budgetPolicy.getBudget());
+    expected << "1 1 2 0 2 1";
+    CompareResult(ERROR_INFO, expected, result, failedCount);
+    
+    return failedCount;
+}
+
+int TestEviction() {
+    std::stringstream result;
+    std::stringstream expected;
+    int failedCount = 0;
+    
+    // A texture used more recently takes the finest level of the least recently used one
+    result = std::stringstream();
+    expected = std::stringstream();
+    TextureStreamingPolicy policy;
+    policy.setBudget(3 * TAIL_BYTES + 2 * 65536);
+    policy.setUsageTimeoutFrames(5);
+    for(unsigned int textureID = 1; textureID <= 3; textureID++) {
+        policy.addTexture(textureID, getLevelBytes(256), 2);
+    }
+    policy.requestLevel(1, 1, 1);
+    policy.requestLevel(2, 1, 1);
+    policy.update(1);
+    policy.requestLevel(3, 1, 2);
+    std::vector<StreamingChange> changes = policy.update(2);
+    result << policy.getResidentLevel(1) << " " << policy.getResidentLevel(2) << " " << policy.getResidentLevel(3) << ", " << changes.size() << " "
+            << changes[0].textureID << " " << changes[0].residentLevel << " " << changes[1].textureID << " " << changes[1].residentLevel << ", "
+            << policy.getStats().levelsEvicted;
+    expected << "2 1 1, 2 1 2 3 1, 1";
+    CompareResult(ERROR_INFO, expected, result, failedCount);
+    
+    // Nothing is evicted for a level that wouldn't fit even after evicting everything it may
+    result = std::stringstream();
+    expected = std::stringstream();
+    policy.resetStats();
+    policy.requestLevel(3, 0, 10);
+    changes = policy.update(10);
+    result << changes.size() << " " << policy.getResidentLevel(2) << " " << policy.getResidentLevel(3) << " " << policy.getStats().levelsEvicted << " "
+            << policy.getStats().budgetMisses;
+    expected << "0 1 1 0 1";
+    CompareResult(ERROR_INFO, expected, result, failedCount);
+    
+    // Levels finer than a texture needs go before levels of textures still in use, whatever their age
+    result = std::stringstream();
+    expected = std::stringstream();
+    policy.requestLevel(1, 1, 11);
+    policy.requestLevel(3, 1, 11);
+    policy.update(11);
+    result << policy.getResidentLevel(1) << " " << policy.getResidentLevel(2) << " " << policy.getResidentLevel(3);
+    expected << "1 2 1";
+    CompareResult(ERROR_INFO, expected, result, failedCount);
+    
+    // Lowering the budget evicts down to the tails, which are kept even when they don't fit
+    result = std::stringstream();
+    expected = std::stringstream();
+    policy.setBudget(TAIL_BYTES);
+    changes = policy.update(12);
+    result << changes.size() << " " << policy.getResidentLevel(1) << " " << policy.getResidentLevel(3) << " " << policy.getTotalResidentBytes();
+    expected << "2 2 2 " << 3 * TAIL_BYTES;
+    CompareResult(ERROR_INFO, expected, result, failedCount);
+    
+    // Removed textures give their bytes back
+    result = std::stringstream();
+    expected = std::stringstream();
+    policy.removeTexture(2);
+    result << policy.hasTexture(2) << " " << policy.getNumTextures() << " " << policy.getTotalResidentBytes();
+    expected << "0 2 " << 2 * TAIL_BYTES;
+    CompareResult(ERROR_INFO, expected, result, failedCount);
+    
+    return failedCount;
+}
+
+int TestStreamedUploads() {
+    std::stringstream result;
+    std::stringstream expected;
+    int failedCount = 0;
+    GeometryHeap::Destroy();
+    HeadlessGL::Reset();
+    MemoryStats initialMemoryStats = TextureLoader::GetMemoryStats();
+    
+    // Streamed textures are buffered with only their tail, in immutable storage
+    result = std::stringstream();
+    expected = std::stringstream();
+    std::vector<unsigned char> pixels(256 * 256 * 4);
+    for(unsigned int i = 0; i < pixels.size(); i++) {
+        pixels[i] = (unsigned char)(i * 7 + i / 1024);
+    }
+    unsigned int textureID = TextureLoader::LoadTextureFromTextureData(std::make_shared<TextureData>(256, 256, 4, SharedBuffer<unsigned char>(pixels)));
+    TextureLoader::SetStreamed(textureID, true);
+    TextureLoader::UseLoadedTexture(textureID);
+    TextureDataPtr textureDataPtr = TextureLoader::GetTextureDataPtr(textureID);
+    TextureLoader::BindTexture(textureID);
+    GLuint tailName = HeadlessGL::GetBoundTexture();
+    TextureUnitState::BindToActiveUnit(0);
+    const SharedBuffer<unsigned char>& tailLevel = textureDataPtr->getMipLevels()[1];
+    result << TextureLoader::IsStreamed(textureID) << " " << HeadlessGL::IsTextureImmutable(tailName) << " " << HeadlessGL::GetNumTextureLevels(tailName) << " "
+            << HeadlessGL::GetTextureLevelSize(tailName, 0) << " " << HeadlessGL::GetTextureBaseLevel(tailName) << " " << HeadlessGL::GetTextureMaxLevel(tailName)
+            << " " << TextureLoader::GetFinestUploadedLevel(textureID) << " "
+            << (HeadlessGL::GetTextureLevelData(tailName, 0) == std::vector<unsigned char>(tailLevel.begin(), tailLevel.end())) << " "
+            << TextureLoader::GetMemoryStats().deviceBytes - initialMemoryStats.deviceBytes;
+    expected << "1 1 7 16384 0 6 2 1 " << TAIL_BYTES;
+    CompareResult(ERROR_INFO, expected, result, failedCount);
+    
+    // Raising the texture copies the resident levels on the GPU and uploads the new ones coarsest first, sampling
+    // only the uploaded levels in the meantime
+    result = std::stringstream();
+    expected = std::stringstream();
+    TextureLoader::SetStreamingUploadBudget(1);
+    HeadlessGL::ClearCallLog();
+    TextureLoader::ReportTextureUsage(textureID, 256.0f, 256.0f);
+    TextureLoader::UpdateTextureStreaming();
+    TextureLoader::BindTexture(textureID);
+    GLuint fullName = HeadlessGL::GetBoundTexture();
+    TextureUnitState::BindToActiveUnit(0);
+    unsigned int firstUploadedLevel = TextureLoader::GetFinestUploadedLevel(textureID);
+    GLint firstBaseLevel = HeadlessGL::GetTextureBaseLevel(fullName);
+    TextureLoader::UpdateTextureStreaming();
+    result << (fullName != tailName) << " " << HeadlessGL::GetNumTextureLevels(tailName) << " " << HeadlessGL::GetNumTextureLevels(fullName) << " "
+            << HeadlessGL::GetCallCount("glCopyImageSubData") << " " << firstUploadedLevel << " " << firstBaseLevel << ", "
+            << TextureLoader::GetFinestUploadedLevel(textureID) << " " << HeadlessGL::GetTextureBaseLevel(fullName) << " "
+            << (HeadlessGL::GetTextureLevelData(fullName, 0) == pixels) << " " << (HeadlessGL::GetTextureLevelData(fullName, 2) == HeadlessGL::GetTextureLevelData(tailName, 0))
+            << " " << TextureLoader::GetMemoryStats().deviceBytes - initialMemoryStats.deviceBytes;
+    expected << "1 0 9 7 1 1, 0 0 1 0 " << TAIL_BYTES + 65536 + 262144;
+    CompareResult(ERROR_INFO, expected, result, failedCount);
+    
+    // Lowering the budget drops back to the tail, keeping the levels already on the GPU
+    result = std::stringstream();
+    expected = std::stringstream();
+    TextureLoader::GetStreamingPolicy().setBudget(TAIL_BYTES);
+    TextureLoader::UpdateTextureStreaming();
+    TextureLoader::BindTexture(textureID);
+    GLuint evictedName = HeadlessGL::GetBoundTexture();
+    TextureUnitState::BindToActiveUnit(0);
+    result << HeadlessGL::GetNumTextureLevels(evictedName) << " " << TextureLoader::GetFinestUploadedLevel(textureID) << " "
+            << (HeadlessGL::GetTextureLevelData(evictedName, 0) == std::vector<unsigned char>(tailLevel.begin(), tailLevel.end())) << " "
+            << TextureLoader::GetMemoryStats().deviceBytes - initialMemoryStats.deviceBytes << " " << HeadlessGL::GetNumErrors();
+    expected << "7 2 1 " << TAIL_BYTES << " 0";
+    CompareResult(ERROR_INFO, expected, result, failedCount);
+    
+    // Textures without a mipmap chain they can stream are buffered whole, and unbuffering stops streaming
+    result = std::stringstream();
+    expected = std::stringstream();
+    unsigned int wideID = TextureLoader::LoadTextureFromTextureData(std::make_shared<TextureData>(8, 8, PIXEL_FORMAT_RGBA16,
+            SharedBuffer<unsigned char>(std::vector<unsigned char>(8 * 8 * 8, 0))));
+    TextureLoader::SetStreamed(wideID, true);
+    TextureLoader::UseLoadedTexture(wideID);
+    TextureLoader::BindTexture(wideID);
+    GLuint wideName = HeadlessGL::GetBoundTexture();
+    TextureUnitState::BindToActiveUnit(0);
+    bool wideImmutable = HeadlessGL::IsTextureImmutable(wideName);
+    TextureLoader::ReleaseLoadedTexture(textureID);
+    TextureLoader::ReleaseLoadedTexture(wideID);
+    ResourceReclaimer::ReclaimAll();
+    result << wideImmutable << " " << TextureLoader::GetStreamingPolicy().getNumTextures() << " " << HeadlessGL::GetNumLiveTextures();
+    expected << "0 0 0";
+    CompareResult(ERROR_INFO, expected, result, failedCount);
+    
+    TextureLoader::GetStreamingPolicy().setBudget(0);
+    TextureLoader::SetStreamingUploadBudget(16 * 1024 * 1024);
+    return failedCount;
+}
+
+};
@@ -0,0 +1,24 @@
+#ifndef TEXTURE_STREAMING_TESTS_H
+#define TEXTURE_STREAMING_TESTS_H
+
+#include <iostream>
+#include <string>
+#include <graphics/texture/texture_streaming.h>
+#include <graphics/texture/texture_data.h>
+#include <graphics/buffer/geometry_heap.h>
+#include <graphics/buffer/resource_reclaimer.h>
+#include <headless_gl.h>
+#include <test_exception.h>
+#include <test_comparison.h>
+
+namespace Tests::TextureStreamingTests {
+
+int DoTests();
+int TestRequiredLevels();
+int TestPromotion();
+int TestEviction();
+int TestStreamedUploads();
+
+};
+
+#endif //TEXTURE_STREAMING_TESTS_H
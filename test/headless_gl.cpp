@@ -0,0 +1,1411 @@
+#include "headless_gl.h"
+#include <graphics/state/gl_state_cache.h>
+#include <graphics/texture/sampler_cache.h>
+#include <graphics/material/material_parameter_block.h>
+#include <graphics/camera/frame_constants.h>
+#include <map>
+#include <cstring>
+#include <algorithm>
+
+namespace Tests::HeadlessGL {
+
+struct TextureLevel {
+    GLsizei width = 0;
+    GLsizei height = 0;
+    unsigned int numChannels = 0;
+    unsigned int bytesPerChannel = 1;
+    // Format given to glTexImage2D or glCompressedTexImage2D, with compressed levels holding their blocks as given
+    GLint internalFormat = 0;
+    std::vector<unsigned char> data;
+};
+
+static GLuint nextName = 1;
+static std::map<GLuint, std::vector<unsigned char>> buffers;
+static std::map<GLuint, bool> vertexArrays;
+// Levels of each texture by mipmap level
+static std::map<GLuint, std::map<GLint, TextureLevel>> textures;
+static std::map<GLuint, std::vector<GLint>> textureSwizzles;
+// GL_TEXTURE_BASE_LEVEL and GL_TEXTURE_MAX_LEVEL of each texture, and whether it was given storage by glTexStorage2D
+struct TextureParameters {
+    GLint baseLevel = 0;
+    GLint maxLevel = 1000;
+    bool immutable = false;
+};
+static std::map<GLuint, TextureParameters> textureParameters;
+static std::map<GLenum, GLuint> boundBuffers;
+// Buffer ranges bound to indexed binding points, by target and index
+static std::map<std::pair<GLenum, GLuint>, BufferRange> boundBufferRanges;
+// Texture bound to the active texture unit, and to each other unit by unit index
+static GLuint boundTexture = 0;
+static GLuint activeTextureUnit = 0;
+static std::map<GLuint, GLuint> unitTextures;
+// Parameters of each sampler object, and the sampler bound to each texture unit
+static std::map<GLuint, std::map<GLenum, float>> samplers;
+static std::map<GLuint, GLuint> unitSamplers;
+static GLuint boundVertexArray = 0;
+static GLuint currentProgram = 0;
+// Capabilities enabled with glEnable, and the state set by the other state calls by function name
+static std::map<GLenum, bool> capabilities;
+static std::map<std::string, std::vector<float>> stateValues;
+static std::vector<DrawRecord> drawLog;
+static std::map<GLuint, GLuint> vertexAttribDivisors;
+static unsigned long long nextSync = 1;
+// Whether each fence has been signalled
+static std::map<GLsync, bool> syncs;
+static bool manualFenceSignalling = false;
+static bool manualShaderCompletion = false;
+static unsigned int numShaderStatusWaits = 0;
+static unsigned int numBlockingWaits = 0;
+static unsigned int numErrors = 0;
+static GLint packAlignment = 4;
+static GLint unpackAlignment = 4;
+// Unpack alignment of the last glTexImage2D or glTexSubImage2D
+static GLint lastUploadUnpackAlignment = 0;
+static std::vector<std::string> callLog;
+// Shader objects and programs. A shader fails to compile if its source contains "#error", and a program links if all
+// its attached shaders compiled
+struct ShaderState {
+    GLenum type = 0;
+    std::string source;
+    bool compiled = false;
+    // Whether the driver has finished compiling it, see SetManualShaderCompletion
+    bool complete = true;
+};
+struct ProgramState {
+    std::vector<GLuint> attachedShaders;
+    // Sources of the stages it was linked from, which glGetProgramBinary returns
+    std::string linkedSource;
+    bool linked = false;
+    bool complete = true;
+    bool binaryRetrievable = false;
+    std::map<std::string, GLint> uniformLocations;
+    std::map<GLint, std::vector<float>> uniformValues;
+    // Name and binding point of each uniform block, by index in the order they were first asked for
+    std::vector<std::pair<std::string, GLuint>> uniformBlockBindings;
+};
+static std::map<GLuint, ShaderState> shaders;
+static std::map<GLuint, ProgramState> programs;
+static const std::string vendorString = "HeadlessGL";
+static const std::string rendererString = "HeadlessGL Renderer";
+static std::string driverVersion = "4.3.0 HeadlessGL 1";
+static bool programBinarySupported = true;
+// Binaries are only accepted by the driver version that produced them
+static const GLenum programBinaryFormat = 0x48474C;
+static const GLint uniformBufferOffsetAlignment = 256;
+static const std::string programBinaryMagic = "HGLBIN";
+
+static void record(const std::string& functionName) {
+    callLog.push_back(functionName);
+}
+
+static unsigned int numChannelsOfFormat(const GLenum format) {
+    switch(format) {
+        case GL_RED:
+            return 1;
+        case GL_RG:
+            return 2;
+        case GL_RGB:
+        case GL_BGR:
+            return 3;
+        default:
+            return 4;
+    }
+}
+
+static unsigned int bytesPerChannelOfType(const GLenum type) {
+    switch(type) {
+        case GL_UNSIGNED_SHORT:
+        case GL_HALF_FLOAT:
+            return 2;
+        case GL_FLOAT:
+            return 4;
+        default:
+            return 1;
+    }
+}
+
+// Returns false and counts a GL_INVALID_VALUE error if the range lies outside buffer
+// Returns the channels and bytes per channel of an uncompressed internal format, or 0 channels for a compressed one
+static unsigned int numChannelsOfInternalFormat(const GLint internalFormat, unsigned int& bytesPerChannel) {
+    bytesPerChannel = 1;
+    switch(internalFormat) {
+        case GL_R8:
+            return 1;
+        case GL_RG8:
+            return 2;
+        case GL_RGB8:
+            return 3;
+        case GL_RGBA8:
+            return 4;
+        case GL_RGBA16:
+        case GL_RGBA16F:
+            bytesPerChannel = 2;
+            return 4;
+        default:
+            return 0;
+    }
+}
+
+static size_t compressedLevelSize(const GLint internalFormat, const GLsizei width, const GLsizei height) {
+    size_t blockSize = (internalFormat == GL_COMPRESSED_RGB_S3TC_DXT1_EXT || internalFormat == GL_COMPRESSED_RED_RGTC1) ? 8 : 16;
+    return (size_t)((width + 3) / 4) * (size_t)((height + 3) / 4) * blockSize;
+}
+
+// Counts a GL_INVALID_OPERATION error
+static void invalidOperation() {
+    record("GL_INVALID_OPERATION");
+    numErrors++;
+}
+
+static bool checkRange(const std::vector<unsigned char>& buffer, const GLintptr offset, const GLsizeiptr size) {
+    if(offset < 0 || size < 0 || (size_t)(offset + size) > buffer.size()) {
+        record("GL_INVALID_VALUE");
+        numErrors++;
+        return false;
+    }
+    return true;
+}
+
+static size_t alignedRowSize(const size_t rowSize, const GLint alignment) {
+    return (rowSize + alignment - 1) / alignment * alignment;
+}
+
+static void APIENTRY fakeGenBuffers(GLsizei n, GLuint* names) {
+    record("glGenBuffers");
+    for(GLsizei i = 0; i < n; i++) {
+        names[i] = nextName++;
+        buffers[names[i]] = std::vector<unsigned char>();
+    }
+}
+
+static void APIENTRY fakeDeleteBuffers(GLsizei n, const GLuint* names) {
+    record("glDeleteBuffers");
+    for(GLsizei i = 0; i < n; i++) {
+        buffers.erase(names[i]);
+        for(std::map<GLenum, GLuint>::iterator iter = boundBuffers.begin(); iter != boundBuffers.end(); iter++) {
+            if(iter->second == names[i]) {
+                iter->second = 0;
+            }
+        }
+        for(std::map<std::pair<GLenum, GLuint>, BufferRange>::iterator iter = boundBufferRanges.begin(); iter != boundBufferRanges.end(); iter++) {
+            if(iter->second.buffer == names[i]) {
+                iter->second = BufferRange();
+            }
+        }
+    }
+}
+
+static void APIENTRY fakeBindBuffer(GLenum target, GLuint buffer) {
+    record("glBindBuffer");
+    boundBuffers[target] = buffer;
+}
+
+static void APIENTRY fakeBindBufferRange(GLenum target, GLuint index, GLuint buffer, GLintptr offset, GLsizeiptr size) {
+    record("glBindBufferRange");
+    if(buffer != 0 && !checkRange(buffers[buffer], offset, size)) {
+        return;
+    }
+    boundBuffers[target] = buffer;
+    boundBufferRanges[{target, index}] = {buffer, offset, size};
+}
+
+static void APIENTRY fakeBufferData(GLenum target, GLsizeiptr size, const void* data, GLenum usage) {
+    record("glBufferData");
+    std::vector<unsigned char>& buffer = buffers[boundBuffers[target]];
+    buffer.assign(size, 0);
+    if(data != nullptr) {
+        memcpy(buffer.data(), data, size);
+    }
+}
+
+static void APIENTRY fakeBufferSubData(GLenum target, GLintptr offset, GLsizeiptr size, const void* data) {
+    record("glBufferSubData");
+    std::vector<unsigned char>& buffer = buffers[boundBuffers[target]];
+    if(checkRange(buffer, offset, size)) {
+        memcpy(buffer.data() + offset, data, size);
+    }
+}
+
+static void APIENTRY fakeGetBufferSubData(GLenum target, GLintptr offset, GLsizeiptr size, void* data) {
+    record("glGetBufferSubData");
+    std::vector<unsigned char>& buffer = buffers[boundBuffers[target]];
+    if(checkRange(buffer, offset, size)) {
+        memcpy(data, buffer.data() + offset, size);
+    }
+}
+
+static void APIENTRY fakeCopyBufferSubData(GLenum readTarget, GLenum writeTarget, GLintptr readOffset, GLintptr writeOffset, GLsizeiptr size) {
+    record("glCopyBufferSubData");
+    std::vector<unsigned char>& readBuffer = buffers[boundBuffers[readTarget]];
+    std::vector<unsigned char>& writeBuffer = buffers[boundBuffers[writeTarget]];
+    if(checkRange(readBuffer, readOffset, size) && checkRange(writeBuffer, writeOffset, size)) {
+        memmove(writeBuffer.data() + writeOffset, readBuffer.data() + readOffset, size);
+    }
+}
+
+static void APIENTRY fakeGenVertexArrays(GLsizei n, GLuint* names) {
+    record("glGenVertexArrays");
+    for(GLsizei i = 0; i < n; i++) {
+        names[i] = nextName++;
+        vertexArrays[names[i]] = true;
+    }
+}
+
+static void APIENTRY fakeDeleteVertexArrays(GLsizei n, const GLuint* names) {
+    record("glDeleteVertexArrays");
+    for(GLsizei i = 0; i < n; i++) {
+        vertexArrays.erase(names[i]);
+        if(boundVertexArray == names[i]) {
+            boundVertexArray = 0;
+        }
+    }
+}
+
+static void APIENTRY fakeBindVertexArray(GLuint vertexArray) {
+    record("glBindVertexArray");
+    boundVertexArray = vertexArray;
+}
+
+static void APIENTRY fakeVertexAttribPointer(GLuint index, GLint size, GLenum type, GLboolean normalized, GLsizei stride, const void* pointer) {
+    record("glVertexAttribPointer");
+}
+
+static void APIENTRY fakeEnableVertexAttribArray(GLuint index) {
+    record("glEnableVertexAttribArray");
+}
+
+static void APIENTRY fakeGenTextures(GLsizei n, GLuint* names) {
+    record("glGenTextures");
+    for(GLsizei i = 0; i < n; i++) {
+        names[i] = nextName++;
+        textures[names[i]] = std::map<GLint, TextureLevel>();
+    }
+}
+
+static void APIENTRY fakeDeleteTextures(GLsizei n, const GLuint* names) {
+    record("glDeleteTextures");
+    for(GLsizei i = 0; i < n; i++) {
+        textures.erase(names[i]);
+        textureSwizzles.erase(names[i]);
+        textureParameters.erase(names[i]);
+    }
+}
+
+static void APIENTRY fakeBindTexture(GLenum target, GLuint texture) {
+    record("glBindTexture");
+    boundTexture = texture;
+}
+
+static void APIENTRY fakeActiveTexture(GLenum texture) {
+    record("glActiveTexture");
+    unitTextures[activeTextureUnit] = boundTexture;
+    activeTextureUnit = texture - GL_TEXTURE0;
+    boundTexture = unitTextures[activeTextureUnit];
+}
+
+static void APIENTRY fakeGenSamplers(GLsizei n, GLuint* names) {
+    record("glGenSamplers");
+    for(GLsizei i = 0; i < n; i++) {
+        names[i] = nextName++;
+        samplers[names[i]] = std::map<GLenum, float>();
+    }
+}
+
+static void APIENTRY fakeDeleteSamplers(GLsizei n, const GLuint* names) {
+    record("glDeleteSamplers");
+    for(GLsizei i = 0; i < n; i++) {
+        samplers.erase(names[i]);
+        // Deleting a sampler unbinds it from every unit
+        for(std::map<GLuint, GLuint>::iterator iter = unitSamplers.begin(); iter != unitSamplers.end(); iter++) {
+            if(iter->second == names[i]) {
+                iter->second = 0;
+            }
+        }
+    }
+}
+
+static void APIENTRY fakeBindSampler(GLuint unit, GLuint sampler) {
+    record("glBindSampler");
+    if(sampler != 0 && samplers.count(sampler) == 0) {
+        invalidOperation();
+        return;
+    }
+    unitSamplers[unit] = sampler;
+}
+
+static void APIENTRY fakeSamplerParameteri(GLuint sampler, GLenum pname, GLint param) {
+    record("glSamplerParameteri");
+    samplers[sampler][pname] = (float)param;
+}
+
+static void APIENTRY fakeSamplerParameterf(GLuint sampler, GLenum pname, GLfloat param) {
+    record("glSamplerParameterf");
+    samplers[sampler][pname] = param;
+}
+
+static void APIENTRY fakeGetFloatv(GLenum pname, GLfloat* data) {
+    record("glGetFloatv");
+    if(pname == GL_MAX_TEXTURE_MAX_ANISOTROPY) {
+        *data = 16.0f;
+    }
+}
+
+static void APIENTRY fakeGetIntegerv(GLenum pname, GLint* data) {
+    record("glGetIntegerv");
+    if(pname == GL_NUM_PROGRAM_BINARY_FORMATS) {
+        *data = programBinarySupported ? 1 : 0;
+    }
+    else if(pname == GL_PROGRAM_BINARY_FORMATS && programBinarySupported) {
+        *data = programBinaryFormat;
+    }
+    else if(pname == GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT) {
+        *data = uniformBufferOffsetAlignment;
+    }
+}
+
+static const GLubyte* APIENTRY fakeGetString(GLenum name) {
+    record("glGetString");
+    switch(name) {
+        case GL_VENDOR:
+            return (const GLubyte*)vendorString.c_str();
+        case GL_RENDERER:
+            return (const GLubyte*)rendererString.c_str();
+        case GL_VERSION:
+            return (const GLubyte*)driverVersion.c_str();
+        default:
+            return nullptr;
+    }
+}
+
+static GLuint APIENTRY fakeCreateShader(GLenum type) {
+    record("glCreateShader");
+    GLuint shader = nextName++;
+    shaders[shader].type = type;
+    return shader;
+}
+
+static GLboolean APIENTRY fakeIsShader(GLuint shader) {
+    return shaders.count(shader) > 0 ? GL_TRUE : GL_FALSE;
+}
+
+static void APIENTRY fakeShaderSource(GLuint shader, GLsizei count, const GLchar* const* strings, const GLint* lengths) {
+    record("glShaderSource");
+    std::string source;
+    for(GLsizei i = 0; i < count; i++) {
+        source += (lengths == nullptr || lengths[i] < 0) ? std::string(strings[i]) : std::string(strings[i], lengths[i]);
+    }
+    shaders[shader].source = source;
+}
+
+static void APIENTRY fakeCompileShader(GLuint shader) {
+    record("glCompileShader");
+    shaders[shader].compiled = shaders[shader].source.find("#error") == std::string::npos;
+    shaders[shader].complete = !manualShaderCompletion;
+}
+
+static void APIENTRY fakeGetShaderiv(GLuint shader, GLenum pname, GLint* params) {
+    record("glGetShaderiv");
+    ShaderState& shaderState = shaders[shader];
+    if(pname == GL_COMPLETION_STATUS_KHR) {
+        *params = shaderState.complete ? GL_TRUE : GL_FALSE;
+        return;
+    }
+    // Any other query waits for the compile to finish
+    if(!shaderState.complete) {
+        shaderState.complete = true;
+        numShaderStatusWaits++;
+    }
+    if(pname == GL_COMPILE_STATUS) {
+        *params = shaderState.compiled ? GL_TRUE : GL_FALSE;
+    }
+}
+
+static void APIENTRY fakeGetShaderInfoLog(GLuint shader, GLsizei maxLength, GLsizei* length, GLchar* infoLog) {
+    std::string log = shaders[shader].compiled ? "" : "#error directive";
+    GLsizei logLength = std::min((GLsizei)log.size(), maxLength);
+    std::memcpy(infoLog, log.data(), logLength);
+    if(length != nullptr) {
+        *length = logLength;
+    }
+}
+
+static void APIENTRY fakeDeleteShader(GLuint shader) {
+    record("glDeleteShader");
+    shaders.erase(shader);
+}
+
+static GLuint APIENTRY fakeCreateProgram() {
+    record("glCreateProgram");
+    GLuint program = nextName++;
+    programs[program] = ProgramState();
+    return program;
+}
+
+static GLboolean APIENTRY fakeIsProgram(GLuint program) {
+    return programs.count(program) > 0 ? GL_TRUE : GL_FALSE;
+}
+
+static void APIENTRY fakeAttachShader(GLuint program, GLuint shader) {
+    record("glAttachShader");
+    programs[program].attachedShaders.push_back(shader);
+}
+
+static void APIENTRY fakeDetachShader(GLuint program, GLuint shader) {
+    record("glDetachShader");
+    std::vector<GLuint>& attachedShaders = programs[program].attachedShaders;
+    attachedShaders.erase(std::remove(attachedShaders.begin(), attachedShaders.end(), shader), attachedShaders.end());
+}
+
+static void APIENTRY fakeLinkProgram(GLuint program) {
+    record("glLinkProgram");
+    ProgramState& programState = programs[program];
+    programState.linked = !programState.attachedShaders.empty();
+    programState.complete = !manualShaderCompletion;
+    programState.linkedSource = "";
+    programState.uniformLocations.clear();
+    programState.uniformBlockBindings.clear();
+    for(unsigned int i = 0; i < programState.attachedShaders.size(); i++) {
+        const ShaderState& shaderState = shaders[programState.attachedShaders[i]];
+        programState.linked = programState.linked && shaderState.compiled;
+        programState.linkedSource += shaderState.source;
+    }
+}
+
+static void APIENTRY fakeProgramParameteri(GLuint program, GLenum pname, GLint value) {
+    record("glProgramParameteri");
+    if(pname == GL_PROGRAM_BINARY_RETRIEVABLE_HINT) {
+        programs[program].binaryRetrievable = value == GL_TRUE;
+    }
+}
+
+static void APIENTRY fakeGetProgramiv(GLuint program, GLenum pname, GLint* params) {
+    record("glGetProgramiv");
+    ProgramState& programState = programs[program];
+    if(pname == GL_COMPLETION_STATUS_KHR) {
+        *params = programState.complete ? GL_TRUE : GL_FALSE;
+        return;
+    }
+    // Any other query waits for the link to finish
+    if(!programState.complete) {
+        programState.complete = true;
+        numShaderStatusWaits++;
+    }
+    if(pname == GL_LINK_STATUS) {
+        *params = programState.linked ? GL_TRUE : GL_FALSE;
+    }
+    else if(pname == GL_PROGRAM_BINARY_LENGTH) {
+        *params = programState.linked ? (GLint)(programBinaryMagic.size() + driverVersion.size() + 1 + programState.linkedSource.size()) : 0;
+    }
+}
+
+static void APIENTRY fakeGetProgramInfoLog(GLuint program, GLsizei maxLength, GLsizei* length, GLchar* infoLog) {
+    std::string log = programs[program].linked ? "" : "a shader failed to compile";
+    GLsizei logLength = std::min((GLsizei)log.size(), maxLength);
+    std::memcpy(infoLog, log.data(), logLength);
+    if(length != nullptr) {
+        *length = logLength;
+    }
+}
+
+static void APIENTRY fakeGetProgramBinary(GLuint program, GLsizei bufferSize, GLsizei* length, GLenum* binaryFormat, void* binary) {
+    record("glGetProgramBinary");
+    const ProgramState& programState = programs[program];
+    std::string data = programBinaryMagic + driverVersion + '\0' + programState.linkedSource;
+    if(!programState.linked || (GLsizei)data.size() > bufferSize) {
+        invalidOperation();
+        if(length != nullptr) {
+            *length = 0;
+        }
+        return;
+    }
+    std::memcpy(binary, data.data(), data.size());
+    *binaryFormat = programBinaryFormat;
+    if(length != nullptr) {
+        *length = data.size();
+    }
+}
+
+static void APIENTRY fakeProgramBinary(GLuint program, GLenum binaryFormat, const void* binary, GLsizei length) {
+    record("glProgramBinary");
+    ProgramState& programState = programs[program];
+    std::string data((const char*)binary, length);
+    std::string prefix = programBinaryMagic + driverVersion + '\0';
+    // A binary from another driver version fails to link rather than raising an error
+    programState.linked = programBinarySupported && binaryFormat == programBinaryFormat && data.compare(0, prefix.size(), prefix) == 0;
+    programState.linkedSource = programState.linked ? data.substr(prefix.size()) : "";
+    programState.uniformLocations.clear();
+    programState.uniformBlockBindings.clear();
+}
+
+static void APIENTRY fakeDeleteProgram(GLuint program) {
+    record("glDeleteProgram");
+    programs.erase(program);
+    if(currentProgram == program) {
+        currentProgram = 0;
+    }
+}
+
+static GLint APIENTRY fakeGetUniformLocation(GLuint program, const GLchar* name) {
+    record("glGetUniformLocation");
+    ProgramState& programState = programs[program];
+    if(!programState.linked || programState.linkedSource.find(name) == std::string::npos) {
+        return -1;
+    }
+    std::map<std::string, GLint>::iterator iter = programState.uniformLocations.find(name);
+    if(iter != programState.uniformLocations.end()) {
+        return iter->second;
+    }
+    GLint location = programState.uniformLocations.size();
+    programState.uniformLocations[name] = location;
+    return location;
+}
+
+static GLuint APIENTRY fakeGetUniformBlockIndex(GLuint program, const GLchar* name) {
+    record("glGetUniformBlockIndex");
+    ProgramState& programState = programs[program];
+    if(!programState.linked || programState.linkedSource.find(std::string("uniform ") + name) == std::string::npos) {
+        return GL_INVALID_INDEX;
+    }
+    for(GLuint i = 0; i < programState.uniformBlockBindings.size(); i++) {
+        if(programState.uniformBlockBindings[i].first == name) {
+            return i;
+        }
+    }
+    // Blocks are bound to binding point 0 until told otherwise
+    programState.uniformBlockBindings.push_back({name, 0});
+    return programState.uniformBlockBindings.size() - 1;
+}
+
+static void APIENTRY fakeUniformBlockBinding(GLuint program, GLuint uniformBlockIndex, GLuint uniformBlockBinding) {
+    record("glUniformBlockBinding");
+    ProgramState& programState = programs[program];
+    if(uniformBlockIndex >= programState.uniformBlockBindings.size()) {
+        invalidOperation();
+        return;
+    }
+    programState.uniformBlockBindings[uniformBlockIndex].second = uniformBlockBinding;
+}
+
+static void APIENTRY fakeProgramUniform1i(GLuint program, GLint location, GLint value) {
+    record("glProgramUniform1i");
+    if(programs.count(program) == 0 || !programs[program].linked) {
+        invalidOperation();
+        return;
+    }
+    programs[program].uniformValues[location] = {(float)value};
+}
+
+static void setUniform(const GLint location, const std::vector<float>& values) {
+    if(programs.count(currentProgram) == 0 || !programs[currentProgram].linked) {
+        invalidOperation();
+        return;
+    }
+    programs[currentProgram].uniformValues[location] = values;
+}
+
+static void APIENTRY fakeUniform1i(GLint location, GLint value) {
+    record("glUniform1i");
+    setUniform(location, {(float)value});
+}
+
+static void APIENTRY fakeUniform1f(GLint location, GLfloat value) {
+    record("glUniform1f");
+    setUniform(location, {value});
+}
+
+static void APIENTRY fakeUniformMatrix4fv(GLint location, GLsizei count, GLboolean transpose, const GLfloat* value) {
+    record("glUniformMatrix4fv");
+    setUniform(location, std::vector<float>(value, value + 16 * count));
+}
+
+static void APIENTRY fakeTexParameteri(GLenum target, GLenum pname, GLint param) {
+    record("glTexParameteri");
+    if(pname == GL_TEXTURE_BASE_LEVEL) {
+        textureParameters[boundTexture].baseLevel = param;
+    }
+    else if(pname == GL_TEXTURE_MAX_LEVEL) {
+        textureParameters[boundTexture].maxLevel = param;
+    }
+}
+
+static void APIENTRY fakeTexParameteriv(GLenum target, GLenum pname, const GLint* params) {
+    record("glTexParameteriv");
+    if(pname == GL_TEXTURE_SWIZZLE_RGBA) {
+        textureSwizzles[boundTexture] = std::vector<GLint>(params, params + 4);
+    }
+}
+
+static void APIENTRY fakePixelStorei(GLenum pname, GLint param) {
+    record("glPixelStorei");
+    if(pname == GL_PACK_ALIGNMENT) {
+        packAlignment = param;
+    }
+    else if(pname == GL_UNPACK_ALIGNMENT) {
+        unpackAlignment = param;
+    }
+}
+
+static void APIENTRY fakeTexImage2D(GLenum target, GLint level, GLint internalformat, GLsizei width, GLsizei height, GLint border,
+        GLenum format, GLenum type, const void* pixels) {
+    record("glTexImage2D");
+    if(textureParameters[boundTexture].immutable) {
+        invalidOperation();
+        return;
+    }
+    TextureLevel& texture = textures[boundTexture][level];
+    texture.width = width;
+    texture.height = height;
+    texture.numChannels = numChannelsOfFormat(format);
+    texture.bytesPerChannel = bytesPerChannelOfType(type);
+    texture.internalFormat = internalformat;
+    size_t rowSize = (size_t)width * texture.numChannels * texture.bytesPerChannel;
+    texture.data.assign(rowSize * height, 0);
+    if(pixels != nullptr) {
+        lastUploadUnpackAlignment = unpackAlignment;
+        size_t sourceRowSize = alignedRowSize(rowSize, unpackAlignment);
+        for(GLsizei row = 0; row < height; row++) {
+            memcpy(texture.data.data() + row * rowSize, (const unsigned char*)pixels + row * sourceRowSize, rowSize);
+        }
+    }
+}
+
+static void APIENTRY fakeTexSubImage2D(GLenum target, GLint level, GLint xoffset, GLint yoffset, GLsizei width, GLsizei height,
+        GLenum format, GLenum type, const void* pixels) {
+    record("glTexSubImage2D");
+    TextureLevel& texture = textures[boundTexture][level];
+    if(xoffset < 0 || yoffset < 0 || xoffset + width > texture.width || yoffset + height > texture.height || numChannelsOfFormat(format) != texture.numChannels
+            || bytesPerChannelOfType(type) != texture.bytesPerChannel) {
+        record("GL_INVALID_VALUE");
+        numErrors++;
+        return;
+    }
+    lastUploadUnpackAlignment = unpackAlignment;
+    size_t pixelSize = (size_t)texture.numChannels * texture.bytesPerChannel;
+    size_t rowSize = (size_t)width * pixelSize;
+    size_t sourceRowSize = alignedRowSize(rowSize, unpackAlignment);
+    const unsigned char* source = (const unsigned char*)pixels;
+    GLuint unpackBuffer = boundBuffers[GL_PIXEL_UNPACK_BUFFER];
+    if(unpackBuffer != 0) {
+        // pixels is an offset into the bound pixel unpack buffer
+        std::vector<unsigned char>& buffer = buffers[unpackBuffer];
+        if(!checkRange(buffer, (GLintptr)pixels, (height - 1) * sourceRowSize + rowSize)) {
+            return;
+        }
+        source = buffer.data() + (size_t)pixels;
+    }
+    for(GLsizei row = 0; row < height; row++) {
+        memcpy(texture.data.data() + ((yoffset + row) * texture.width + xoffset) * pixelSize, source + row * sourceRowSize, rowSize);
+    }
+}
+
+static void APIENTRY fakeCompressedTexImage2D(GLenum target, GLint level, GLenum internalformat, GLsizei width, GLsizei height, GLint border,
+        GLsizei imageSize, const void* data) {
+    record("glCompressedTexImage2D");
+    if(textureParameters[boundTexture].immutable) {
+        invalidOperation();
+        return;
+    }
+    TextureLevel& texture = textures[boundTexture][level];
+    texture.width = width;
+    texture.height = height;
+    texture.numChannels = 0;
+    texture.internalFormat = internalformat;
+    texture.data.assign((const unsigned char*)data, (const unsigned char*)data + imageSize);
+}
+
+static void APIENTRY fakeTexStorage2D(GLenum target, GLsizei levels, GLenum internalformat, GLsizei width, GLsizei height) {
+    record("glTexStorage2D");
+    TextureParameters& parameters = textureParameters[boundTexture];
+    if(parameters.immutable || levels < 1) {
+        invalidOperation();
+        return;
+    }
+    parameters.immutable = true;
+    std::map<GLint, TextureLevel>& levelMap = textures[boundTexture];
+    levelMap.clear();
+    for(GLint level = 0; level < levels; level++) {
+        TextureLevel& texture = levelMap[level];
+        texture.width = width;
+        texture.height = height;
+        texture.internalFormat = internalformat;
+        texture.numChannels = numChannelsOfInternalFormat(internalformat, texture.bytesPerChannel);
+        if(texture.numChannels == 0) {
+            texture.data.assign(compressedLevelSize(internalformat, width, height), 0);
+        }
+        else {
+            texture.data.assign((size_t)width * height * texture.numChannels * texture.bytesPerChannel, 0);
+        }
+        width = (width > 1) ? width / 2 : 1;
+        height = (height > 1) ? height / 2 : 1;
+    }
+}
+
+static void APIENTRY fakeCompressedTexSubImage2D(GLenum target, GLint level, GLint xoffset, GLint yoffset, GLsizei width, GLsizei height,
+        GLenum format, GLsizei imageSize, const void* data) {
+    record("glCompressedTexSubImage2D");
+    TextureLevel& texture = textures[boundTexture][level];
+    // Only whole levels are replaced
+    if(xoffset != 0 || yoffset != 0 || width != texture.width || height != texture.height || (GLint)format != texture.internalFormat
+            || (size_t)imageSize != texture.data.size()) {
+        record("GL_INVALID_VALUE");
+        numErrors++;
+        return;
+    }
+    memcpy(texture.data.data(), data, imageSize);
+}
+
+static void APIENTRY fakeCopyImageSubData(GLuint srcName, GLenum srcTarget, GLint srcLevel, GLint srcX, GLint srcY, GLint srcZ,
+        GLuint dstName, GLenum dstTarget, GLint dstLevel, GLint dstX, GLint dstY, GLint dstZ, GLsizei srcWidth, GLsizei srcHeight, GLsizei srcDepth) {
+    record("glCopyImageSubData");
+    if(textures.count(srcName) == 0 || textures[srcName].count(srcLevel) == 0 || textures.count(dstName) == 0 || textures[dstName].count(dstLevel) == 0) {
+        record("GL_INVALID_VALUE");
+        numErrors++;
+        return;
+    }
+    TextureLevel& source = textures[srcName][srcLevel];
+    TextureLevel& destination = textures[dstName][dstLevel];
+    if(source.internalFormat != destination.internalFormat || srcX + srcWidth > source.width || srcY + srcHeight > source.height
+            || dstX + srcWidth > destination.width || dstY + srcHeight > destination.height) {
+        record("GL_INVALID_VALUE");
+        numErrors++;
+        return;
+    }
+    if(source.numChannels == 0) {
+        // Only whole compressed levels are copied
+        if(srcWidth != source.width || srcHeight != source.height || source.data.size() != destination.data.size()) {
+            record("GL_INVALID_VALUE");
+            numErrors++;
+            return;
+        }
+        destination.data = source.data;
+        return;
+    }
+    size_t pixelSize = (size_t)source.numChannels * source.bytesPerChannel;
+    for(GLsizei row = 0; row < srcHeight; row++) {
+        memcpy(destination.data.data() + ((dstY + row) * destination.width + dstX) * pixelSize,
+                source.data.data() + ((srcY + row) * source.width + srcX) * pixelSize, srcWidth * pixelSize);
+    }
+}
+
+static void APIENTRY fakeGetCompressedTexImage(GLenum target, GLint level, void* pixels) {
+    record("glGetCompressedTexImage");
+    TextureLevel& texture = textures[boundTexture][level];
+    memcpy(pixels, texture.data.data(), texture.data.size());
+}
+
+static void APIENTRY fakeGenerateMipmap(GLenum target) {
+    record("glGenerateMipmap");
+}
+
+static void APIENTRY fakeGetTexImage(GLenum target, GLint level, GLenum format, GLenum type, void* pixels) {
+    record("glGetTexImage");
+    TextureLevel& texture = textures[boundTexture][level];
+    unsigned int numChannels = numChannelsOfFormat(format);
+    if(bytesPerChannelOfType(type) != texture.bytesPerChannel) {
+        // Only 8-bit levels are converted between channel counts
+        size_t rowSize = (size_t)texture.width * texture.numChannels * texture.bytesPerChannel;
+        size_t destinationRowSize = alignedRowSize(rowSize, packAlignment);
+        for(GLsizei row = 0; row < texture.height; row++) {
+            memcpy((unsigned char*)pixels + row * destinationRowSize, texture.data.data() + row * rowSize, rowSize);
+        }
+        return;
+    }
+    size_t bytesPerChannel = texture.bytesPerChannel;
+    size_t destinationRowSize = alignedRowSize((size_t)texture.width * numChannels * bytesPerChannel, packAlignment);
+    for(GLsizei row = 0; row < texture.height; row++) {
+        for(GLsizei col = 0; col < texture.width; col++) {
+            for(unsigned int c = 0; c < numChannels; c++) {
+                unsigned char* destination = (unsigned char*)pixels + row * destinationRowSize + (col * numChannels + c) * bytesPerChannel;
+                if(c < texture.numChannels) {
+                    memcpy(destination, texture.data.data() + ((row * texture.width + col) * texture.numChannels + c) * bytesPerChannel, bytesPerChannel);
+                }
+                else {
+                    memset(destination, 255, bytesPerChannel);
+                }
+            }
+        }
+    }
+}
+
+static void APIENTRY fakeDrawElements(GLenum mode, GLsizei count, GLenum type, const void* indices) {
+    record("glDrawElements");
+    DrawRecord drawRecord;
+    drawRecord.vertexArray = boundVertexArray;
+    drawRecord.count = count;
+    drawRecord.indexOffset = (size_t)indices;
+    drawLog.push_back(drawRecord);
+}
+
+static void APIENTRY fakeDrawElementsBaseVertex(GLenum mode, GLsizei count, GLenum type, const void* indices, GLint baseVertex) {
+    record("glDrawElementsBaseVertex");
+    DrawRecord drawRecord;
+    drawRecord.vertexArray = boundVertexArray;
+    drawRecord.count = count;
+    drawRecord.indexOffset = (size_t)indices;
+    drawRecord.baseVertex = baseVertex;
+    drawLog.push_back(drawRecord);
+}
+
+static void APIENTRY fakeDrawElementsInstancedBaseVertex(GLenum mode, GLsizei count, GLenum type, const void* indices, GLsizei instanceCount, GLint baseVertex) {
+    record("glDrawElementsInstancedBaseVertex");
+    DrawRecord drawRecord;
+    drawRecord.vertexArray = boundVertexArray;
+    drawRecord.count = count;
+    drawRecord.indexOffset = (size_t)indices;
+    drawRecord.baseVertex = baseVertex;
+    drawRecord.instanceCount = instanceCount;
+    drawLog.push_back(drawRecord);
+}
+
+static void APIENTRY fakeMultiDrawElementsIndirect(GLenum mode, GLenum type, const void* indirect, GLsizei drawCount, GLsizei stride) {
+    record("glMultiDrawElementsIndirect");
+    const std::vector<unsigned char>& indirectBuffer = buffers[boundBuffers[GL_DRAW_INDIRECT_BUFFER]];
+    // Each command is {count, instanceCount, firstIndex, baseVertex, baseInstance}
+    size_t commandSize = 5 * sizeof(GLuint);
+    size_t commandStride = (stride == 0) ? commandSize : stride;
+    if(drawCount > 0 && !checkRange(indirectBuffer, (GLintptr)indirect, (drawCount - 1) * commandStride + commandSize)) {
+        return;
+    }
+    for(GLsizei i = 0; i < drawCount; i++) {
+        GLuint command[5];
+        std::memcpy(command, indirectBuffer.data() + (size_t)indirect + i * commandStride, commandSize);
+        DrawRecord drawRecord;
+        drawRecord.vertexArray = boundVertexArray;
+        drawRecord.count = command[0];
+        drawRecord.instanceCount = command[1];
+        drawRecord.indexOffset = command[2] * sizeof(GLuint);
+        drawRecord.baseVertex = (GLint)command[3];
+        drawRecord.baseInstance = command[4];
+        drawLog.push_back(drawRecord);
+    }
+}
+
+static void APIENTRY fakeBufferStorage(GLenum target, GLsizeiptr size, const void* data, GLbitfield flags) {
+    record("glBufferStorage");
+    std::vector<unsigned char>& buffer = buffers[boundBuffers[target]];
+    buffer.assign(size, 0);
+    if(data != nullptr) {
+        std::memcpy(buffer.data(), data, size);
+    }
+}
+
+static void* APIENTRY fakeMapBufferRange(GLenum target, GLintptr offset, GLsizeiptr length, GLbitfield access) {
+    record("glMapBufferRange");
+    std::vector<unsigned char>& buffer = buffers[boundBuffers[target]];
+    if(!checkRange(buffer, offset, length)) {
+        return nullptr;
+    }
+    // Emulated buffers are never reallocated while mapped, so the mapping stays valid until the buffer is deleted
+    return buffer.data() + offset;
+}
+
+static GLboolean APIENTRY fakeUnmapBuffer(GLenum target) {
+    record("glUnmapBuffer");
+    return GL_TRUE;
+}
+
+static GLsync APIENTRY fakeFenceSync(GLenum condition, GLbitfield flags) {
+    record("glFenceSync");
+    GLsync sync = (GLsync)nextSync++;
+    // Emulated commands complete as soon as they are issued unless the test signals fences itself
+    syncs[sync] = !manualFenceSignalling;
+    return sync;
+}
+
+static GLenum APIENTRY fakeClientWaitSync(GLsync sync, GLbitfield flags, GLuint64 timeout) {
+    record("glClientWaitSync");
+    std::map<GLsync, bool>::iterator iter = syncs.find(sync);
+    if(iter == syncs.end()) {
+        record("GL_INVALID_VALUE");
+        numErrors++;
+        return GL_WAIT_FAILED;
+    }
+    if(iter->second) {
+        return GL_ALREADY_SIGNALED;
+    }
+    if(timeout == 0) {
+        return GL_TIMEOUT_EXPIRED;
+    }
+    // Blocking until the emulated GPU reaches the fence
+    numBlockingWaits++;
+    iter->second = true;
+    return GL_CONDITION_SATISFIED;
+}
+
+static void APIENTRY fakeDeleteSync(GLsync sync) {
+    record("glDeleteSync");
+    syncs.erase(sync);
+}
+
+static void APIENTRY fakeVertexAttribDivisor(GLuint index, GLuint divisor) {
+    record("glVertexAttribDivisor");
+    vertexAttribDivisors[index] = divisor;
+}
+
+static void APIENTRY fakeDisableVertexAttribArray(GLuint index) {
+    record("glDisableVertexAttribArray");
+}
+
+static void APIENTRY fakePolygonMode(GLenum face, GLenum mode) {
+    record("glPolygonMode");
+    stateValues["glPolygonMode"] = {(float)face, (float)mode};
+}
+
+static void APIENTRY fakeUseProgram(GLuint program) {
+    record("glUseProgram");
+    currentProgram = program;
+}
+
+static void APIENTRY fakeEnable(GLenum cap) {
+    record("glEnable");
+    capabilities[cap] = true;
+}
+
+static void APIENTRY fakeDisable(GLenum cap) {
+    record("glDisable");
+    capabilities[cap] = false;
+}
+
+static void APIENTRY fakeBlendFunc(GLenum sfactor, GLenum dfactor) {
+    record("glBlendFunc");
+    stateValues["glBlendFunc"] = {(float)sfactor, (float)dfactor};
+}
+
+static void APIENTRY fakeDepthFunc(GLenum func) {
+    record("glDepthFunc");
+    stateValues["glDepthFunc"] = {(float)func};
+}
+
+static void APIENTRY fakeDepthMask(GLboolean flag) {
+    record("glDepthMask");
+    stateValues["glDepthMask"] = {(float)flag};
+}
+
+static void APIENTRY fakeCullFace(GLenum mode) {
+    record("glCullFace");
+    stateValues["glCullFace"] = {(float)mode};
+}
+
+static void APIENTRY fakeViewport(GLint x, GLint y, GLsizei width, GLsizei height) {
+    record("glViewport");
+    stateValues["glViewport"] = {(float)x, (float)y, (float)width, (float)height};
+}
+
+static void APIENTRY fakeClearColor(GLfloat red, GLfloat green, GLfloat blue, GLfloat alpha) {
+    record("glClearColor");
+    stateValues["glClearColor"] = {red, green, blue, alpha};
+}
+
+void Install() {
+    glad_glGenBuffers = fakeGenBuffers;
+    glad_glDeleteBuffers = fakeDeleteBuffers;
+    glad_glBindBuffer = fakeBindBuffer;
+    glad_glBufferData = fakeBufferData;
+    glad_glBufferSubData = fakeBufferSubData;
+    glad_glGetBufferSubData = fakeGetBufferSubData;
+    glad_glCopyBufferSubData = fakeCopyBufferSubData;
+    glad_glGenVertexArrays = fakeGenVertexArrays;
+    glad_glDeleteVertexArrays = fakeDeleteVertexArrays;
+    glad_glBindVertexArray = fakeBindVertexArray;
+    glad_glVertexAttribPointer = fakeVertexAttribPointer;
+    glad_glEnableVertexAttribArray = fakeEnableVertexAttribArray;
+    glad_glGenTextures = fakeGenTextures;
+    glad_glDeleteTextures = fakeDeleteTextures;
+    glad_glBindTexture = fakeBindTexture;
+    glad_glActiveTexture = fakeActiveTexture;
+    glad_glTexParameteri = fakeTexParameteri;
+    glad_glTexParameteriv = fakeTexParameteriv;
+    glad_glPixelStorei = fakePixelStorei;
+    glad_glTexImage2D = fakeTexImage2D;
+    glad_glTexSubImage2D = fakeTexSubImage2D;
+    glad_glGenerateMipmap = fakeGenerateMipmap;
+    glad_glGetTexImage = fakeGetTexImage;
+    glad_glCompressedTexImage2D = fakeCompressedTexImage2D;
+    glad_glGetCompressedTexImage = fakeGetCompressedTexImage;
+    glad_glTexStorage2D = fakeTexStorage2D;
+    glad_glCompressedTexSubImage2D = fakeCompressedTexSubImage2D;
+    glad_glCopyImageSubData = fakeCopyImageSubData;
+    glad_glDrawElements = fakeDrawElements;
+    glad_glDrawElementsBaseVertex = fakeDrawElementsBaseVertex;
+    glad_glPolygonMode = fakePolygonMode;
+    glad_glUseProgram = fakeUseProgram;
+    glad_glEnable = fakeEnable;
+    glad_glDisable = fakeDisable;
+    glad_glBlendFunc = fakeBlendFunc;
+    glad_glDepthFunc = fakeDepthFunc;
+    glad_glDepthMask = fakeDepthMask;
+    glad_glCullFace = fakeCullFace;
+    glad_glViewport = fakeViewport;
+    glad_glClearColor = fakeClearColor;
+    glad_glDrawElementsInstancedBaseVertex = fakeDrawElementsInstancedBaseVertex;
+    glad_glMultiDrawElementsIndirect = fakeMultiDrawElementsIndirect;
+    glad_glBufferStorage = fakeBufferStorage;
+    glad_glMapBufferRange = fakeMapBufferRange;
+    glad_glUnmapBuffer = fakeUnmapBuffer;
+    glad_glFenceSync = fakeFenceSync;
+    glad_glClientWaitSync = fakeClientWaitSync;
+    glad_glDeleteSync = fakeDeleteSync;
+    glad_glVertexAttribDivisor = fakeVertexAttribDivisor;
+    glad_glDisableVertexAttribArray = fakeDisableVertexAttribArray;
+    glad_glGenSamplers = fakeGenSamplers;
+    glad_glDeleteSamplers = fakeDeleteSamplers;
+    glad_glBindSampler = fakeBindSampler;
+    glad_glSamplerParameteri = fakeSamplerParameteri;
+    glad_glSamplerParameterf = fakeSamplerParameterf;
+    glad_glGetFloatv = fakeGetFloatv;
+    glad_glGetIntegerv = fakeGetIntegerv;
+    glad_glGetString = fakeGetString;
+    glad_glCreateShader = fakeCreateShader;
+    glad_glIsShader = fakeIsShader;
+    glad_glShaderSource = fakeShaderSource;
+    glad_glCompileShader = fakeCompileShader;
+    glad_glGetShaderiv = fakeGetShaderiv;
+    glad_glGetShaderInfoLog = fakeGetShaderInfoLog;
+    glad_glDeleteShader = fakeDeleteShader;
+    glad_glCreateProgram = fakeCreateProgram;
+    glad_glIsProgram = fakeIsProgram;
+    glad_glAttachShader = fakeAttachShader;
+    glad_glDetachShader = fakeDetachShader;
+    glad_glLinkProgram = fakeLinkProgram;
+    glad_glProgramParameteri = fakeProgramParameteri;
+    glad_glGetProgramiv = fakeGetProgramiv;
+    glad_glGetProgramInfoLog = fakeGetProgramInfoLog;
+    glad_glGetProgramBinary = fakeGetProgramBinary;
+    glad_glProgramBinary = fakeProgramBinary;
+    glad_glDeleteProgram = fakeDeleteProgram;
+    glad_glGetUniformLocation = fakeGetUniformLocation;
+    glad_glGetUniformBlockIndex = fakeGetUniformBlockIndex;
+    glad_glUniformBlockBinding = fakeUniformBlockBinding;
+    glad_glProgramUniform1i = fakeProgramUniform1i;
+    glad_glBindBufferRange = fakeBindBufferRange;
+    glad_glUniform1i = fakeUniform1i;
+    glad_glUniform1f = fakeUniform1f;
+    glad_glUniformMatrix4fv = fakeUniformMatrix4fv;
+    GLAD_GL_ARB_get_program_binary = 1;
+    GLAD_GL_ARB_buffer_storage = 1;
+    GLAD_GL_EXT_texture_filter_anisotropic = 1;
+    GLAD_GL_KHR_parallel_shader_compile = 1;
+}
+
+void SetManualFenceSignalling(const bool manual) {
+    manualFenceSignalling = manual;
+}
+
+void SignalFences() {
+    for(std::map<GLsync, bool>::iterator iter = syncs.begin(); iter != syncs.end(); iter++) {
+        iter->second = true;
+    }
+}
+
+void SignalOldestFence() {
+    // Fences are named in creation order
+    for(std::map<GLsync, bool>::iterator iter = syncs.begin(); iter != syncs.end(); iter++) {
+        if(!iter->second) {
+            iter->second = true;
+            return;
+        }
+    }
+}
+
+unsigned int GetNumBlockingWaits() {
+    return numBlockingWaits;
+}
+
+void SetBufferStorageSupported(const bool supported) {
+    GLAD_GL_ARB_buffer_storage = supported ? 1 : 0;
+}
+
+void SetAnisotropicFilteringSupported(const bool supported) {
+    GLAD_GL_EXT_texture_filter_anisotropic = supported ? 1 : 0;
+}
+
+void SetProgramBinarySupported(const bool supported) {
+    GLAD_GL_ARB_get_program_binary = supported ? 1 : 0;
+    programBinarySupported = supported;
+}
+
+void SetParallelShaderCompileSupported(const bool supported) {
+    GLAD_GL_KHR_parallel_shader_compile = supported ? 1 : 0;
+}
+
+void SetManualShaderCompletion(const bool manual) {
+    manualShaderCompletion = manual;
+}
+
+void CompleteShaders() {
+    for(std::map<GLuint, ShaderState>::iterator iter = shaders.begin(); iter != shaders.end(); iter++) {
+        iter->second.complete = true;
+    }
+    for(std::map<GLuint, ProgramState>::iterator iter = programs.begin(); iter != programs.end(); iter++) {
+        iter->second.complete = true;
+    }
+}
+
+unsigned int GetNumShaderStatusWaits() {
+    return numShaderStatusWaits;
+}
+
+void SetDriverVersion(const std::string& version) {
+    driverVersion = version;
+}
+
+void Reset() {
+    // Sampler objects are shared by the engine rather than owned by a loader, so let go of them with the context
+    Engine::SamplerCache::Destroy();
+    Engine::MaterialParameterBlock::Destroy();
+    Engine::FrameConstants::Destroy();
+    buffers.clear();
+    vertexArrays.clear();
+    textures.clear();
+    textureSwizzles.clear();
+    textureParameters.clear();
+    boundBuffers.clear();
+    boundBufferRanges.clear();
+    boundTexture = 0;
+    activeTextureUnit = 0;
+    unitTextures.clear();
+    samplers.clear();
+    unitSamplers.clear();
+    boundVertexArray = 0;
+    currentProgram = 0;
+    capabilities.clear();
+    stateValues.clear();
+    shaders.clear();
+    programs.clear();
+    driverVersion = "4.3.0 HeadlessGL 1";
+    programBinarySupported = true;
+    GLAD_GL_ARB_get_program_binary = 1;
+    GLAD_GL_KHR_parallel_shader_compile = 1;
+    manualShaderCompletion = false;
+    numShaderStatusWaits = 0;
+    drawLog.clear();
+    vertexAttribDivisors.clear();
+    syncs.clear();
+    manualFenceSignalling = false;
+    numBlockingWaits = 0;
+    numErrors = 0;
+    packAlignment = 4;
+    unpackAlignment = 4;
+    lastUploadUnpackAlignment = 0;
+    callLog.clear();
+    // A fresh context, so nothing the engine tracked as bound is any more
+    Engine::GLStateCache::Invalidate();
+}
+
+void ClearCallLog() {
+    callLog.clear();
+    drawLog.clear();
+}
+
+const std::vector<std::string>& GetCallLog() {
+    return callLog;
+}
+
+unsigned int GetCallCount(const std::string& functionName) {
+    unsigned int count = 0;
+    for(unsigned int i = 0; i < callLog.size(); i++) {
+        if(callLog[i] == functionName) {
+            count++;
+        }
+    }
+    return count;
+}
+
+const std::vector<DrawRecord>& GetDrawLog() {
+    return drawLog;
+}
+
+unsigned int GetNumErrors() {
+    return numErrors;
+}
+
+GLuint GetVertexAttribDivisor(const GLuint index) {
+    std::map<GLuint, GLuint>::iterator iter = vertexAttribDivisors.find(index);
+    return (iter == vertexAttribDivisors.end()) ? 0 : iter->second;
+}
+
+unsigned int GetNumLiveSyncs() {
+    return syncs.size();
+}
+
+unsigned int GetNumLiveBuffers() {
+    return buffers.size();
+}
+
+unsigned int GetNumLiveVertexArrays() {
+    return vertexArrays.size();
+}
+
+unsigned int GetNumLiveTextures() {
+    return textures.size();
+}
+
+unsigned int GetNumTextureLevels(const GLuint texture) {
+    std::map<GLuint, std::map<GLint, TextureLevel>>::iterator iter = textures.find(texture);
+    return (iter != textures.end()) ? iter->second.size() : 0;
+}
+
+GLint GetTextureInternalFormat(const GLuint texture, const GLint level) {
+    std::map<GLuint, std::map<GLint, TextureLevel>>::iterator iter = textures.find(texture);
+    if(iter == textures.end() || iter->second.count(level) == 0) {
+        return 0;
+    }
+    return iter->second[level].internalFormat;
+}
+
+size_t GetTextureLevelSize(const GLuint texture, const GLint level) {
+    std::map<GLuint, std::map<GLint, TextureLevel>>::iterator iter = textures.find(texture);
+    if(iter == textures.end() || iter->second.count(level) == 0) {
+        return 0;
+    }
+    return iter->second[level].data.size();
+}
+
+std::vector<unsigned char> GetTextureLevelData(const GLuint texture, const GLint level) {
+    std::map<GLuint, std::map<GLint, TextureLevel>>::iterator iter = textures.find(texture);
+    if(iter == textures.end() || iter->second.count(level) == 0) {
+        return std::vector<unsigned char>();
+    }
+    return iter->second[level].data;
+}
+
+std::vector<GLint> GetTextureSwizzle(const GLuint texture) {
+    std::map<GLuint, std::vector<GLint>>::iterator iter = textureSwizzles.find(texture);
+    if(iter == textureSwizzles.end()) {
+        return {GL_RED, GL_GREEN, GL_BLUE, GL_ALPHA};
+    }
+    return iter->second;
+}
+
+GLint GetTextureBaseLevel(const GLuint texture) {
+    std::map<GLuint, TextureParameters>::iterator iter = textureParameters.find(texture);
+    return (iter == textureParameters.end()) ? 0 : iter->second.baseLevel;
+}
+
+GLint GetTextureMaxLevel(const GLuint texture) {
+    std::map<GLuint, TextureParameters>::iterator iter = textureParameters.find(texture);
+    return (iter == textureParameters.end()) ? 1000 : iter->second.maxLevel;
+}
+
+bool IsTextureImmutable(const GLuint texture) {
+    std::map<GLuint, TextureParameters>::iterator iter = textureParameters.find(texture);
+    return iter != textureParameters.end() && iter->second.immutable;
+}
+
+GLint GetPackAlignment() {
+    return packAlignment;
+}
+
+GLint GetUnpackAlignment() {
+    return unpackAlignment;
+}
+
+GLint GetLastUploadUnpackAlignment() {
+    return lastUploadUnpackAlignment;
+}
+
+GLuint GetBoundTexture() {
+    return boundTexture;
+}
+
+GLuint GetActiveTextureUnit() {
+    return activeTextureUnit;
+}
+
+GLuint GetUnitTexture(const GLuint unit) {
+    return (unit == activeTextureUnit) ? boundTexture : unitTextures[unit];
+}
+
+GLuint GetUnitSampler(const GLuint unit) {
+    return unitSamplers[unit];
+}
+
+unsigned int GetNumLiveSamplers() {
+    return samplers.size();
+}
+
+float GetSamplerParameter(const GLuint sampler, const GLenum pname) {
+    std::map<GLenum, float>& parameters = samplers[sampler];
+    return (parameters.count(pname) > 0) ? parameters[pname] : 0.0f;
+}
+
+GLuint GetBoundBuffer(const GLenum target) {
+    return boundBuffers[target];
+}
+
+GLuint GetBoundVertexArray() {
+    return boundVertexArray;
+}
+
+GLuint GetCurrentProgram() {
+    return currentProgram;
+}
+
+bool IsEnabled(const GLenum capability) {
+    return capabilities[capability];
+}
+
+std::vector<float> GetStateValues(const std::string& functionName) {
+    std::map<std::string, std::vector<float>>::iterator iter = stateValues.find(functionName);
+    return (iter == stateValues.end()) ? std::vector<float>() : iter->second;
+}
+
+unsigned int GetNumLiveShaders() {
+    return shaders.size();
+}
+
+unsigned int GetNumLivePrograms() {
+    return programs.size();
+}
+
+bool IsProgramLinked(const GLuint program) {
+    std::map<GLuint, ProgramState>::iterator iter = programs.find(program);
+    return iter != programs.end() && iter->second.linked;
+}
+
+std::string GetProgramSource(const GLuint program) {
+    std::map<GLuint, ProgramState>::iterator iter = programs.find(program);
+    return (iter == programs.end()) ? "" : iter->second.linkedSource;
+}
+
+std::vector<float> GetUniformValues(const GLuint program, const std::string& name) {
+    std::map<GLuint, ProgramState>::iterator iter = programs.find(program);
+    if(iter == programs.end() || iter->second.uniformLocations.count(name) == 0) {
+        return std::vector<float>();
+    }
+    GLint location = iter->second.uniformLocations[name];
+    return (iter->second.uniformValues.count(location) > 0) ? iter->second.uniformValues[location] : std::vector<float>();
+}
+
+std::vector<unsigned char> GetBufferData(const GLuint buffer) {
+    std::map<GLuint, std::vector<unsigned char>>::iterator iter = buffers.find(buffer);
+    return (iter == buffers.end()) ? std::vector<unsigned char>() : iter->second;
+}
+
+BufferRange GetBoundBufferRange(const GLenum target, const GLuint index) {
+    std::map<std::pair<GLenum, GLuint>, BufferRange>::iterator iter = boundBufferRanges.find({target, index});
+    return (iter == boundBufferRanges.end()) ? BufferRange() : iter->second;
+}
+
+GLint GetUniformBlockBinding(const GLuint program, const std::string& name) {
+    std::map<GLuint, ProgramState>::iterator iter = programs.find(program);
+    if(iter == programs.end()) {
+        return -1;
+    }
+    for(unsigned int i = 0; i < iter->second.uniformBlockBindings.size(); i++) {
+        if(iter->second.uniformBlockBindings[i].first == name) {
+            return iter->second.uniformBlockBindings[i].second;
+        }
+    }
+    return -1;
+}
+
+size_t GetBufferSize(const GLuint buffer) {
+    std::map<GLuint, std::vector<unsigned char>>::iterator iter = buffers.find(buffer);
+    if(iter == buffers.end()) {
+        return 0;
+    }
+    return iter->second.size();
+}
+
+}
@@ -0,0 +1,165 @@
+#ifndef HEADLESS_GL_H
+#define HEADLESS_GL_H
+
+#include <string>
+#include <vector>
+
+#include <glad/glad.h>
+
+namespace Tests::HeadlessGL {
+
+/*
+ * Arguments of a recorded draw call. Multi-draw calls record one entry per draw. indexOffset is the byte offset into the bound index buffer.
+ */
+struct DrawRecord {
+    GLuint vertexArray = 0;
+    GLsizei count = 0;
+    size_t indexOffset = 0;
+    GLint baseVertex = 0;
+    GLuint instanceCount = 1;
+    GLuint baseInstance = 0;
+};
+
+/*
+ * A buffer range bound to an indexed binding point with glBindBufferRange.
+ */
+struct BufferRange {
+    GLuint buffer = 0;
+    GLintptr offset = 0;
+    GLsizeiptr size = 0;
+};
+
+/*
+ * Points the GLAD function pointers used by the engine at an in-memory emulation of OpenGL so that loaders can be
+ * tested without a context. Buffer and texture contents are kept in system memory and every call is recorded.
+ */
+void Install();
+
+/*
+ * By default fences are signalled as soon as they are created. With manual signalling they stay unsignalled until
+ * SignalFences() is called, as if the GPU were still busy, and a glClientWaitSync with a timeout signals the fence it
+ * waits for and counts a blocking wait.
+ */
+void SetManualFenceSignalling(const bool manual);
+
+/*
+ * Signals all fences, as if the GPU had caught up with every command issued so far.
+ */
+void SignalFences();
+
+/*
+ * Signals the oldest unsignalled fence.
+ */
+void SignalOldestFence();
+unsigned int GetNumBlockingWaits();
+
+/*
+ * Sets whether ARB_buffer_storage is reported as available. Install() reports it as available.
+ */
+void SetBufferStorageSupported(const bool supported);
+
+/*
+ * Sets whether EXT_texture_filter_anisotropic is reported as available, with a maximum anisotropy of 16. Install()
+ * reports it as available.
+ */
+void SetAnisotropicFilteringSupported(const bool supported);
+
+/*
+ * Sets whether ARB_get_program_binary is reported as available with one binary format. Install() reports it as
+ * available.
+ */
+void SetProgramBinarySupported(const bool supported);
+
+/*
+ * Sets whether KHR_parallel_shader_compile is reported as available. Install() reports it as available.
+ */
+void SetParallelShaderCompileSupported(const bool supported);
+
+/*
+ * By default shaders and programs finish compiling and linking as soon as asked to. With manual completion their
+ * GL_COMPLETION_STATUS_KHR stays false until CompleteShaders() is called, as if the driver's compiler threads were still
+ * busy, and querying any other status before then waits for them and counts a status wait.
+ */
+void SetManualShaderCompletion(const bool manual);
+void CompleteShaders();
+unsigned int GetNumShaderStatusWaits();
+
+/*
+ * Sets the GL_VERSION string. Program binaries are only accepted by the version that produced them, as if the driver
+ * were updated between runs.
+ */
+void SetDriverVersion(const std::string& version);
+
+/*
+ * Deletes all emulated objects and clears the call log. The engine's tracked OpenGL state is invalidated, as for a
+ * new context.
+ */
+void Reset();
+
+/*
+ * Clears the call and draw logs without touching emulated objects.
+ */
+void ClearCallLog();
+
+const std::vector<std::string>& GetCallLog();
+unsigned int GetCallCount(const std::string& functionName);
+const std::vector<DrawRecord>& GetDrawLog();
+
+/*
+ * Returns the number of calls that would have raised an OpenGL error, e.g. a buffer range out of bounds.
+ */
+unsigned int GetNumErrors();
+
+GLuint GetVertexAttribDivisor(const GLuint index);
+unsigned int GetNumLiveSyncs();
+unsigned int GetNumLiveBuffers();
+unsigned int GetNumLiveVertexArrays();
+unsigned int GetNumLiveTextures();
+// Number of mipmap levels given storage with glTexImage2D, glCompressedTexImage2D or glTexStorage2D
+unsigned int GetNumTextureLevels(const GLuint texture);
+GLint GetTextureInternalFormat(const GLuint texture, const GLint level);
+// Bytes stored for a level, the blocks of compressed levels
+size_t GetTextureLevelSize(const GLuint texture, const GLint level);
+std::vector<unsigned char> GetTextureLevelData(const GLuint texture, const GLint level);
+// GL_TEXTURE_SWIZZLE_RGBA of a texture, the identity unless set
+std::vector<GLint> GetTextureSwizzle(const GLuint texture);
+// GL_TEXTURE_BASE_LEVEL and GL_TEXTURE_MAX_LEVEL of a texture, 0 and 1000 unless set
+GLint GetTextureBaseLevel(const GLuint texture);
+GLint GetTextureMaxLevel(const GLuint texture);
+// Whether a texture was given its storage by glTexStorage2D
+bool IsTextureImmutable(const GLuint texture);
+GLint GetPackAlignment();
+GLint GetUnpackAlignment();
+// GL_UNPACK_ALIGNMENT in effect for the last glTexImage2D with pixels or glTexSubImage2D
+GLint GetLastUploadUnpackAlignment();
+// Texture bound to the active texture unit
+GLuint GetBoundTexture();
+GLuint GetActiveTextureUnit();
+GLuint GetUnitTexture(const GLuint unit);
+GLuint GetUnitSampler(const GLuint unit);
+unsigned int GetNumLiveSamplers();
+// Value a sampler parameter was set to with glSamplerParameteri or glSamplerParameterf, 0 unless set
+float GetSamplerParameter(const GLuint sampler, const GLenum pname);
+GLuint GetBoundBuffer(const GLenum target);
+GLuint GetBoundVertexArray();
+GLuint GetCurrentProgram();
+// Whether capability was last enabled with glEnable rather than disabled, false unless set
+bool IsEnabled(const GLenum capability);
+// Arguments of the last call to a state function such as glBlendFunc, glDepthMask or glViewport, empty if not called
+std::vector<float> GetStateValues(const std::string& functionName);
+unsigned int GetNumLiveShaders();
+unsigned int GetNumLivePrograms();
+bool IsProgramLinked(const GLuint program);
+// Concatenated sources of the shaders program was linked from, or restored from a binary
+std::string GetProgramSource(const GLuint program);
+// Values the uniform name of program was last set to, empty unless set
+std::vector<float> GetUniformValues(const GLuint program, const std::string& name);
+size_t GetBufferSize(const GLuint buffer);
+std::vector<unsigned char> GetBufferData(const GLuint buffer);
+BufferRange GetBoundBufferRange(const GLenum target, const GLuint index);
+// Binding point of the uniform block name of program, -1 unless its index was asked for
+GLint GetUniformBlockBinding(const GLuint program, const std::string& name);
+
+};
+
+#endif //HEADLESS_GL_H
@@ -0,0 +1,29 @@
+#include "test_meshes.h"
+
+using namespace Engine;
+using namespace Engine::Math;
+
+namespace Tests {
+
+MeshGeometryDataPtr CreateTestMeshGeometryData(const unsigned int numVertices) {
+    std::vector<Vec3f> vertices;
+    std::vector<Vec3f> normals;
+    std::vector<Vec2f> textureCoords;
+    for(unsigned int i = 0; i < numVertices; i++) {
+        vertices.push_back(createVec3<float>(i, i + 1, i + 2));
+        normals.push_back(createVec3<float>(0.0f, 1.0f, 0.0f));
+        textureCoords.push_back(createVec2<float>(i * 0.5f, 1.0f));
+    }
+    return std::make_shared<MeshGeometryData>(SharedBuffer<Vec3f>(std::move(vertices)), SharedBuffer<Vec3f>(std::move(normals)),
+            SharedBuffer<Vec2f>(std::move(textureCoords)));
+}
+
+MeshDataPtr CreateTestMeshData(const unsigned int numVertices) {
+    std::vector<unsigned int> indices;
+    for(unsigned int i = 0; i < numVertices; i++) {
+        indices.push_back(i);
+    }
+    return std::make_shared<MeshData>(SharedBuffer<unsigned int>(std::move(indices)), CreateTestMeshGeometryData(numVertices));
+}
+
+}
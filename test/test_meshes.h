@@ -0,0 +1,21 @@
+#ifndef TEST_MESHES_H
+#define TEST_MESHES_H
+
+#include <graphics/mesh/mesh_geometry_data.h>
+#include <graphics/mesh/mesh_data.h>
+
+namespace Tests {
+
+/*
+ * Returns geometry with numVertices vertices, vertex i at (i, i + 1, i + 2) with normal (0, 1, 0) and texture
+ * coordinates (i / 2, 1).
+ */
+Engine::MeshGeometryDataPtr CreateTestMeshGeometryData(const unsigned int numVertices);
+
+/*
+ * Returns mesh data drawing the vertices of CreateTestMeshGeometryData(numVertices) in order, each once.
+ */
+Engine::MeshDataPtr CreateTestMeshData(const unsigned int numVertices);
+
+}
+#endif //TEST_MESHES_H